@@ -0,0 +1,77 @@
+//
+//	IRCClientCaseMapping.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+
+/*	NOTE: This header is for the framework’s internal use only.
+ */
+
+/********************************/
+#pragma mark IRCClientCaseMapping
+/********************************/
+
+/**	How a server compares nicknames and channel names (as advertised in the
+	CASEMAPPING token of RPL_ISUPPORT).
+ */
+typedef NS_ENUM(uint8_t, IRCClientCaseMapping) {
+	/**	A–Z and []\^ are the upper-case forms of a–z and {}|~. (The default.)
+	 */
+	IRCClientCaseMappingRFC1459 = 0,
+	/**	Like RFC 1459, except that ^ and ~ are distinct.
+	 */
+	IRCClientCaseMappingStrictRFC1459,
+	/**	Only A–Z are the upper-case forms of a–z.
+	 */
+	IRCClientCaseMappingASCII
+};
+
+/*******************************/
+#pragma mark - Folding functions
+/*******************************/
+
+/**	Returns the lower-case form of the given byte.
+ */
+static inline uint8_t IRCClientCaseFoldByte(uint8_t byte,
+											IRCClientCaseMapping mapping) {
+	if (byte >= 'A' && byte <= 'Z')
+		return byte + ('a' - 'A');
+
+	if (mapping == IRCClientCaseMappingASCII)
+		return byte;
+
+	// [\] → {|}, and ^ → ~ (for RFC 1459 only).
+	if (   (byte >= '[' && byte <= ']')
+		|| (byte == '^' && mapping == IRCClientCaseMappingRFC1459))
+		return byte + ('{' - '[');
+
+	return byte;
+}
+
+/**	Fills in the given 256-byte table with the lower-case form of each byte,
+	so that folding a name is one table lookup per byte.
+ */
+static inline void IRCClientCaseFoldTableInit(uint8_t table[256],
+											  IRCClientCaseMapping mapping) {
+	for (NSUInteger i = 0; i < 256; i++)
+		table[i] = IRCClientCaseFoldByte((uint8_t)i, mapping);
+}
+
+/**	Sets the given mutable data to the lower-case form of the given bytes
+	(reusing its storage, so that it can serve as a lookup key), using a table
+	filled in by IRCClientCaseFoldTableInit().
+ */
+static inline void IRCClientCaseFold(NSMutableData *key,
+									 const uint8_t *bytes,
+									 NSUInteger length,
+									 const uint8_t table[256]) {
+	key.length = length;
+	uint8_t *keyBytes = key.mutableBytes;
+	for (NSUInteger i = 0; i < length; i++)
+		keyBytes[i] = table[bytes[i]];
+}
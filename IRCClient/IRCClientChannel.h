@@ -9,6 +9,7 @@
 
 #import <Foundation/Foundation.h>
 #import "IRCClientChannelDelegate.h"
+#import "IRCClientFormattedMessage.h"
 
 /** \class IRCClientChannel
  *	@brief Represents a connected IRC Channel.
@@ -41,6 +42,12 @@
 /** Encoding used by, and in, this channel. */
 @property (assign) NSStringEncoding encoding;
 
+/** What is done with the mIRC format codes in messages, notices, and actions
+	on this channel, before they are passed to the delegate. The default,
+	IRCClientColorCodeHandlingDefault, is to do whatever the session does (see
+	-[IRCClientSession colorCodeHandling]). */
+@property (assign) IRCClientColorCodeHandling colorCodeHandling;
+
 /** Topic of the channel
  *
  *	You can (attempt to) set the topic by using -[setChannelTopic:], not by
@@ -51,12 +58,19 @@
  */
 @property (readonly) NSData *topic;
 
-/** Modes of the channel. */
+/** Modes of the channel (not including list modes, such as bans), with their
+	parameters; e.g. “+klnt key 10”. (Kept up to date as modes are changed;
+	see also -[hasMode:], -[parameterForMode:], and -[listForMode:].) */
 @property (readonly) NSData *modes;
 
 /** An array of nicknames stored as NSData objects that list the connected users
-    for the channel. */
-@property (readonly) NSArray *nicks;
+    for the channel. (The list is filled in from the server’s reply to NAMES,
+    which is sent on joining the channel, and kept up to date as users join,
+    part, are kicked, quit, and change nicks.) */
+@property (readonly) NSArray <NSData *> *nicks;
+
+/** The number of users on the channel. */
+@property (readonly) NSUInteger memberCount;
 
 /** Stores arbitrary user info. */
 @property (strong) NSDictionary *userInfo;
@@ -67,6 +81,52 @@
 
 +(instancetype) channel;
 
+/************************/
+#pragma mark - Membership
+/************************/
+
+/** Returns YES if the given nick is on the channel. (Nicks are compared the
+ *	way the server compares them, i.e. case-insensitively.)
+ *
+ *  @param nick The nickname to look for.
+ */
+-(BOOL) hasMember:(NSData *)nick;
+
+/** Returns the symbols of the channel membership prefixes (such as @ for
+ *	operator and + for voice) that the given nick has, highest-ranked first;
+ *	or nil if the nick is not on the channel.
+ *
+ *  @param nick The nickname to look for.
+ */
+-(NSData *) prefixesForMember:(NSData *)nick;
+
+/***************************/
+#pragma mark - Channel modes
+/***************************/
+
+/** Returns YES if the given mode (which must not be a list mode or a channel
+ *	membership prefix mode) is set on the channel.
+ *
+ *  @param mode The mode letter, e.g. 'm'.
+ */
+-(BOOL) hasMode:(uint8_t)mode;
+
+/** Returns the parameter of the given mode (such as the key, for +k), or nil
+ *	if the mode is not set or has no parameter.
+ *
+ *  @param mode The mode letter, e.g. 'k'.
+ */
+-(NSData *) parameterForMode:(uint8_t)mode;
+
+/** Returns the entries of the given list mode (such as the ban masks, for
+ *	+b). The lists are filled in from the server’s replies to list queries
+ *	(e.g. “MODE #channel +b”), and kept up to date as entries are added and
+ *	removed.
+ *
+ *  @param mode The mode letter, e.g. 'b'.
+ */
+-(NSSet <NSData *> *) listForMode:(uint8_t)mode;
+
 /**************************/
 #pragma mark - IRC commands
 /**************************/
@@ -9,6 +9,8 @@
 
 #import "IRCClientChannel.h"
 #import "IRCClientChannel_Private.h"
+#import "IRCClientSession_Private.h"
+#import "IRCClientMessage.h"
 #import "NSData+SA_NSDataExtensions.h"
 
 /********************************************/
@@ -16,9 +18,21 @@
 /********************************************/
 
 @interface IRCClientChannel() {
-	// TODO: actually keep track of nicks! Use RPL_NAMREPLY and so on...
-	// (see refreshNames...)
-	NSMutableArray	*_nicks;
+	// Maps each member’s interned nick to the member’s prefixes (bit i is
+	// set if the member has the i’th of the session’s channel prefixes). The
+	// nick itself is shared with every other channel the user is on, and the
+	// prefixes fit in a tagged pointer, so a member costs little more than a
+	// dictionary entry.
+	NSMutableDictionary <IRCClientIdentifier *, NSNumber *> *_members;
+
+	// Collects the members listed by RPL_NAMREPLY, until RPL_ENDOFNAMES.
+	NSMutableDictionary <IRCClientIdentifier *, NSNumber *> *_pendingMembers;
+
+	// Bit set of the (non-list) modes that are set, indexed by mode letter;
+	// the parameters of those that have one; and the entries of list modes.
+	uint64_t _modeFlags[2];
+	NSMutableDictionary <NSNumber *, NSData *> *_modeParameters;
+	NSMutableDictionary <NSNumber *, NSMutableSet <NSData *> *> *_modeLists;
 }
 
 @end
@@ -33,8 +47,56 @@
 #pragma mark - Properties
 /************************/
 
+// (The members and modes belong to the session’s queue, so these are read
+// there.)
+
 -(NSArray *) nicks {
-	return [_nicks copy];
+	__block NSMutableArray *nicks = nil;
+	[_session performOnSessionQueueAndWait:^{
+		nicks = [NSMutableArray arrayWithCapacity:_members.count];
+		for (IRCClientIdentifier *nick in _members.keyEnumerator)
+			[nicks addObject:nick.name];
+	}];
+
+	return nicks;
+}
+
+-(NSUInteger) memberCount {
+	__block NSUInteger memberCount = 0;
+	[_session performOnSessionQueueAndWait:^{
+		memberCount = _members.count;
+	}];
+
+	return memberCount;
+}
+
+-(NSData *) modes {
+	// E.g. “+klnt key 10”.
+	NSMutableData *modes = [NSMutableData dataWithBytes:"+"
+												 length:1];
+	NSMutableData *parameters = [NSMutableData data];
+	[_session performOnSessionQueueAndWait:^{
+		for (uint8_t mode = 0; mode < 128; mode++) {
+			if (((_modeFlags[mode >> 6] >> (mode & 63)) & 1) == 0)
+				continue;
+
+			[modes appendBytes:&mode
+						length:1];
+			NSData *parameter = _modeParameters[@(mode)];
+			if (parameter != nil) {
+				[parameters appendBytes:" "
+								 length:1];
+				[parameters appendData:parameter];
+			}
+		}
+	}];
+
+	if (modes.length == 1)
+		return [NSData dataWithBlankCString];
+
+	[modes appendData:parameters];
+
+	return modes;
 }
 
 /********************************************/
@@ -59,8 +121,9 @@
 	_name = name;
 	_encoding = NSUTF8StringEncoding;
 	_topic = [NSData dataWithBlankCString];
-	_modes = [NSData dataWithBlankCString];
-	_nicks = [NSMutableArray array];
+	_members = [NSMutableDictionary dictionary];
+	_modeParameters = [NSMutableDictionary dictionary];
+	_modeLists = [NSMutableDictionary dictionary];
 
 	return self;
 }
@@ -70,9 +133,13 @@
 /**************************/
 
 -(int) part {
-	[_session sendRaw:[NSData dataWithFormat:"PART %@", _name, nil]];
+	IRCClientLinePart part[] = {
+		IRCClientLinePartCString("PART "),
+		IRCClientLinePartData(_name)
+	};
 
-	return 0;
+	return [_session sendLineParts:part
+							 count:(sizeof(part) / sizeof(IRCClientLinePart))];
 }
 
 -(int) invite:(NSData *)nick {
@@ -80,100 +147,416 @@
 		return 1;
 //		return LIBIRC_ERR_STATE;
 
-	[_session sendRaw:[NSData dataWithFormat:"INVITE %@ %@", nick, _name, nil]];
+	IRCClientLinePart invite[] = {
+		IRCClientLinePartCString("INVITE "),
+		IRCClientLinePartData(nick),
+		IRCClientLinePartCString(" "),
+		IRCClientLinePartData(_name)
+	};
 
-	return 0;
+	return [_session sendLineParts:invite
+							 count:(sizeof(invite) / sizeof(IRCClientLinePart))];
 }
 
 -(int) refreshNames {
-	[_session sendRaw:[NSData dataWithFormat:"NAMES %@", _name, nil]];
-
-	return 0;
+	return [_session names:_name];
 }
 
 -(int) channelTopic:(NSData *)newTopic {
-	if (newTopic)
-		[_session sendRaw:[NSData dataWithFormat:"TOPIC %@ :%@", _name, newTopic, nil]];
-	else
-		[_session sendRaw:[NSData dataWithFormat:"TOPIC %@", _name, nil]];
-
-	return 0;
+	IRCClientLinePart topic[] = {
+		IRCClientLinePartCString("TOPIC "),
+		IRCClientLinePartData(_name),
+		IRCClientLinePartCString(" :"),
+		IRCClientLinePartData(newTopic)
+	};
+
+	return [_session sendLineParts:topic
+							 count:(newTopic ? 4 : 2)];
 }
 
 -(int) channelMode:(NSData *)mode
 			params:(NSData *)params {
-	if (mode != nil) {
-		if (params != nil)
-			[_session sendRaw:[NSData dataWithFormat:"MODE %@ %@ %@", _name, mode, params, nil]];
-		else
-			[_session sendRaw:[NSData dataWithFormat:"MODE %@ %@", _name, mode, nil]];
-	} else {
-		[_session sendRaw:[NSData dataWithFormat:"MODE %@", _name, nil]];
-	}
-
-	return 0;
+	IRCClientLinePart channelMode[] = {
+		IRCClientLinePartCString("MODE "),
+		IRCClientLinePartData(_name),
+		IRCClientLinePartCString(" "),
+		IRCClientLinePartData(mode),
+		IRCClientLinePartCString(" "),
+		IRCClientLinePartData(params)
+	};
+
+	return [_session sendLineParts:channelMode
+							 count:(mode != nil
+									? (params != nil ? 6 : 4)
+									: 2)];
 }
 
 -(int) message:(NSData *)message {
-	if (!message || message.length == 0)
-		return 1;
-//		return LIBIRC_ERR_STATE;
+	return [_session message:message
+						  to:_name];
+}
 
-	[_session sendRaw:[NSData dataWithFormat:"PRIVMSG %@ :%@", _name, [self.session colorConvertToMIRC:message], nil]];
+-(int) action:(NSData *)action {
+	return [_session action:action
+						 to:_name];
+}
 
-	return 0;
+-(int) notice:(NSData *)notice {
+	return [_session notice:notice
+						 to:_name];
 }
 
--(int) action:(NSData *)action {
-	if (!action || action.length == 0)
+-(int) kick:(NSData *)nick 
+	 reason:(NSData *)reason {
+	if (!nick || nick.length == 0)
 		return 1;
 //		return LIBIRC_ERR_STATE;
 
-	[_session sendRaw:[NSData dataWithFormat:"PRIVMSG %@ :\x01" "ACTION %@\x01", _name, [self.session colorConvertToMIRC:action], nil]];
+	IRCClientLinePart kick[] = {
+		IRCClientLinePartCString("KICK "),
+		IRCClientLinePartData(_name),
+		IRCClientLinePartCString(" "),
+		IRCClientLinePartData(nick),
+		IRCClientLinePartCString(" :"),
+		IRCClientLinePartData(reason)
+	};
+
+	return [_session sendLineParts:kick
+							 count:(reason ? 6 : 4)];
+}
 
-	return 0;
+-(int) ctcpRequest:(NSData *)request {
+	return [_session ctcpRequest:request
+						  target:_name];
 }
 
--(int) notice:(NSData *)notice {
-	if (!notice || notice.length == 0)
-		return 1;
-//		return LIBIRC_ERR_STATE;
+/************************/
+#pragma mark - Membership
+/************************/
+
+// (The member index, the identifier pool, and the server’s prefixes all
+// belong to the session’s queue, so these are looked up there.)
 
-	[_session sendRaw:[NSData dataWithFormat:"NOTICE %@ :%@", _name, notice, nil]];
+-(BOOL) hasMember:(NSData *)nick {
+	__block BOOL hasMember = NO;
+	[_session performOnSessionQueueAndWait:^{
+		IRCClientIdentifier *identifier = [self identifierForNick:nick.bytes
+														   length:nick.length
+														   create:NO];
+		hasMember = (identifier != nil && _members[identifier] != nil);
+	}];
 
-	return 0;
+	return hasMember;
 }
 
--(int) kick:(NSData *)nick 
-	 reason:(NSData *)reason {
-	if (!nick || nick.length == 0)
-		return 1;
-//		return LIBIRC_ERR_STATE;
+-(NSData *) prefixesForMember:(NSData *)nick {
+	__block NSMutableData *prefixes = nil;
+	[_session performOnSessionQueueAndWait:^{
+		IRCClientIdentifier *identifier = [self identifierForNick:nick.bytes
+														   length:nick.length
+														   create:NO];
+		NSNumber *memberPrefixes = (identifier != nil) ? _members[identifier] : nil;
+		if (memberPrefixes == nil)
+			return;
+
+		uint16_t bits = memberPrefixes.unsignedShortValue;
+		const IRCClientChannelPrefixes *channelPrefixes = &_session.serverSupport->prefixes;
+		prefixes = [NSMutableData dataWithCapacity:channelPrefixes->count];
+		for (NSUInteger i = 0; i < channelPrefixes->count; i++)
+			if (bits & (1 << i))
+				[prefixes appendBytes:&channelPrefixes->symbols[i]
+							   length:1];
+	}];
+
+	return prefixes;
+}
 
-	if (reason)
-		[_session sendRaw:[NSData dataWithFormat:"KICK %@ %@ :%@", _name, nick, reason, nil]];
-	else
-		[_session sendRaw:[NSData dataWithFormat:"KICK %@ %@", _name, nick, nil]];
+/*	NOTE: The following take a nick either on its own or in nick!user@host
+	form (and ignore the user@host part).
+ */
+
+// Returns the session’s interned nick (or nil, if it isn’t interned and
+// create is NO).
+-(IRCClientIdentifier *) identifierForNick:(const uint8_t *)bytes
+									length:(NSUInteger)length
+									create:(BOOL)create {
+	const uint8_t *separator = memchr(bytes, '!', length);
+	if (separator != NULL)
+		length = (NSUInteger) (separator - bytes);
+
+	IRCClientIdentifierPool *identifiers = _session.identifiers;
+	return (create
+			? [identifiers identifierForBytes:bytes
+									   length:length]
+			: [identifiers existingIdentifierForBytes:bytes
+											   length:length]);
+}
 
-	return 0;
+-(void) addMember:(const uint8_t *)bytes
+		   length:(NSUInteger)length
+		 prefixes:(uint16_t)prefixes
+			   to:(NSMutableDictionary <IRCClientIdentifier *, NSNumber *> *)members {
+	members[[self identifierForNick:bytes
+							 length:length
+							 create:YES]] = @(prefixes);
 }
 
--(int) ctcpRequest:(NSData *)request {
-	if (!request || request.length == 0)
-		return 1;
-//		return LIBIRC_ERR_STATE;
+// Returns the given members, keyed anew (as when the case mapping changes).
+-(NSMutableDictionary <IRCClientIdentifier *, NSNumber *> *) reinternMembers:(NSDictionary <IRCClientIdentifier *, NSNumber *> *)members {
+	NSMutableDictionary <IRCClientIdentifier *, NSNumber *> *reinternedMembers = [NSMutableDictionary dictionaryWithCapacity:members.count];
+	[members enumerateKeysAndObjectsUsingBlock:^(IRCClientIdentifier *nick, NSNumber *prefixes, BOOL *stop) {
+		NSData *name = nick.name;
+		reinternedMembers[[self identifierForNick:name.bytes
+										   length:name.length
+										   create:YES]] = prefixes;
+	}];
+
+	return reinternedMembers;
+}
 
-	[_session sendRaw:[NSData dataWithFormat:"PRIVMSG %@ :\x01%@\x01", _name, request, nil]];
+-(void) removeMember:(NSData *)nick {
+	IRCClientIdentifier *identifier = [self identifierForNick:nick.bytes
+													   length:nick.length
+													   create:NO];
+	if (identifier == nil)
+		return;
 
-	return 0;
+	[_members removeObjectForKey:identifier];
+	[_pendingMembers removeObjectForKey:identifier];
+}
+
+/***************************/
+#pragma mark - Channel modes
+/***************************/
+
+// (Like the members, the modes belong to the session’s queue.)
+
+-(BOOL) hasMode:(uint8_t)mode {
+	if (mode >= 128)
+		return NO;
+
+	__block BOOL hasMode = NO;
+	[_session performOnSessionQueueAndWait:^{
+		hasMode = ((_modeFlags[mode >> 6] >> (mode & 63)) & 1);
+	}];
+
+	return hasMode;
+}
+
+-(NSData *) parameterForMode:(uint8_t)mode {
+	__block NSData *parameter = nil;
+	[_session performOnSessionQueueAndWait:^{
+		parameter = _modeParameters[@(mode)];
+	}];
+
+	return parameter;
+}
+
+-(NSSet <NSData *> *) listForMode:(uint8_t)mode {
+	__block NSSet <NSData *> *list = nil;
+	[_session performOnSessionQueueAndWait:^{
+		list = [_modeLists[@(mode)] copy];
+	}];
+
+	return list ?: [NSSet set];
+}
+
+-(void) setFlagForMode:(uint8_t)mode
+					to:(BOOL)set {
+	if (mode >= 128)
+		return;
+
+	uint64_t bit = (uint64_t) 1 << (mode & 63);
+	if (set)
+		_modeFlags[mode >> 6] |= bit;
+	else
+		_modeFlags[mode >> 6] &= ~bit;
+}
+
+-(void) setPrefix:(NSUInteger)rank
+		ofMember:(IRCClientIdentifier *)identifier
+			   to:(BOOL)set
+			   in:(NSMutableDictionary <IRCClientIdentifier *, NSNumber *> *)members {
+	NSNumber *prefixes = members[identifier];
+	if (prefixes == nil)
+		return;
+
+	uint16_t bits = prefixes.unsignedShortValue;
+	members[identifier] = @(set ? (bits | (1 << rank)) : (bits & ~(1 << rank)));
+}
+
+/*	Applies the mode string in the given parameter of the message (using the
+	parameters that follow it as the modes’ parameters), in one pass, and
+	records each change in changes (which must have room for one change per
+	byte of the mode string). Returns the number of changes.
+
+	The parameters array keeps the changes’ parameters alive.
+ */
+-(NSUInteger) applyModes:(const IRCClientMessage *)message
+			   fromParam:(NSUInteger)index
+				 changes:(IRCClientChannelModeChange *)changes
+			  parameters:(NSMutableArray <NSData *> *)parameters {
+	const IRCClientServerSupport *support = _session.serverSupport;
+
+	NSRange modeString = IRCClientMessageParamRange(message, index);
+	if (modeString.location == NSNotFound)
+		return 0;
+
+	NSUInteger nextParam = index + 1;
+	NSUInteger count = 0;
+	BOOL adding = YES;
+	for (NSUInteger i = 0; i < modeString.length; i++) {
+		uint8_t mode = message->bytes[modeString.location + i];
+		if (mode == '+' || mode == '-') {
+			adding = (mode == '+');
+			continue;
+		}
+
+		IRCClientChannelModeType type = IRCClientServerSupportChannelModeType(support, mode);
+		BOOL hasParameter = (   type == IRCClientChannelModeTypeList
+							 || type == IRCClientChannelModeTypeParameter
+							 || type == IRCClientChannelModeTypeMembership
+							 || (type == IRCClientChannelModeTypeParameterWhenSet && adding));
+		NSRange parameterRange = (hasParameter
+								  ? IRCClientMessageParamRange(message, nextParam++)
+								  : NSMakeRange(NSNotFound, 0));
+
+		NSData *parameter = nil;
+		switch (type) {
+			case IRCClientChannelModeTypeList: {
+				// Without a parameter, this is a request for the list, not a
+				// change to it.
+				if (parameterRange.location == NSNotFound)
+					continue;
+
+				parameter = IRCClientMessageDataForRange(message, parameterRange);
+				if (adding)
+					[self addListEntry:parameter
+							   forMode:mode];
+				else
+					[_modeLists[@(mode)] removeObject:parameter];
+
+				break;
+			}
+			case IRCClientChannelModeTypeParameter:
+			case IRCClientChannelModeTypeParameterWhenSet: {
+				parameter = IRCClientMessageDataForRange(message, parameterRange);
+				if (adding && parameter == nil)
+					continue;
+
+				[self setFlagForMode:mode
+								  to:adding];
+				_modeParameters[@(mode)] = adding ? parameter : nil;
+
+				break;
+			}
+			case IRCClientChannelModeTypeMembership: {
+				if (parameterRange.location == NSNotFound)
+					continue;
+
+				// The member’s status is updated in place; no new nick data is
+				// made unless the nick isn’t known.
+				IRCClientIdentifier *identifier = [self identifierForNick:(message->bytes + parameterRange.location)
+																   length:parameterRange.length
+																   create:NO];
+				if (identifier != nil) {
+					NSUInteger rank = IRCClientChannelPrefixModeIndex(&support->prefixes, mode);
+					[self setPrefix:rank
+						   ofMember:identifier
+								 to:adding
+								 in:_members];
+					if (_pendingMembers != nil)
+						[self setPrefix:rank
+							   ofMember:identifier
+									 to:adding
+									 in:_pendingMembers];
+					parameter = identifier.name;
+				} else {
+					parameter = IRCClientMessageDataForRange(message, parameterRange);
+				}
+
+				break;
+			}
+			case IRCClientChannelModeTypeFlag:
+			case IRCClientChannelModeTypeUnknown: {
+				[self setFlagForMode:mode
+								  to:adding];
+
+				break;
+			}
+		}
+
+		if (parameter != nil)
+			[parameters addObject:parameter];
+		changes[count++] = (IRCClientChannelModeChange) { adding, mode, type, parameter };
+	}
+
+	return count;
 }
 
 /****************************/
 #pragma mark - Event handlers
 /****************************/
 
+-(void) namesReceived:(NSData *)names {
+	if (_pendingMembers == nil)
+		_pendingMembers = [NSMutableDictionary dictionaryWithCapacity:_members.count];
+
+	const IRCClientChannelPrefixes *channelPrefixes = &_session.serverSupport->prefixes;
+
+	// Each name is a nick (or nick!user@host), preceded by the symbols of its
+	// prefixes (all of them, or only the highest-ranked one, depending on
+	// whether the server has enabled multi-prefix).
+	const uint8_t *bytes = names.bytes;
+	NSUInteger length = names.length;
+	NSUInteger position = 0;
+	while (position < length) {
+		if (bytes[position] == ' ') {
+			position++;
+			continue;
+		}
+
+		uint16_t prefixes = 0;
+		NSUInteger rank;
+		while (   position < length
+			   && (rank = IRCClientChannelPrefixIndex(channelPrefixes, bytes[position])) != NSNotFound) {
+			prefixes |= (1 << rank);
+			position++;
+		}
+
+		NSUInteger start = position;
+		while (position < length && bytes[position] != ' ')
+			position++;
+
+		if (position > start)
+			[self addMember:(bytes + start)
+					 length:(position - start)
+				   prefixes:prefixes
+						 to:_pendingMembers];
+	}
+}
+
+-(void) namesEnded {
+	// The list is complete, so it replaces what we had before.
+	if (_pendingMembers != nil) {
+		_members = _pendingMembers;
+		_pendingMembers = nil;
+	}
+
+	if ([_delegate respondsToSelector:@selector(namesReceivedForChannel:)])
+		[_delegate namesReceivedForChannel:self];
+}
+
 -(void) userJoined:(NSData *)nick {
-	[_nicks addObject:nick];
+	[self addMember:nick.bytes
+			 length:nick.length
+		   prefixes:0
+				 to:_members];
+	if (_pendingMembers != nil)
+		[self addMember:nick.bytes
+				 length:nick.length
+			   prefixes:0
+					 to:_pendingMembers];
 
 	[_delegate userJoined:nick 
 				  channel:self];
@@ -183,7 +566,7 @@
 		withReason:(NSData *)reason 
 				us:(BOOL)wasItUs {
 	if (!wasItUs) {
-		[_nicks removeObject:nick];
+		[self removeMember:nick];
 	} else {
 		// NOTE: When the channel object receives this message, and wasItUs
 		// is true, its session has already removed the channel from its list
@@ -198,17 +581,72 @@
 					   us:wasItUs];
 }
 
--(void) modeSet:(NSData *)mode 
-	 withParams:(NSData *)params 
-			 by:(NSData *)nick {
-	// TODO: actually update the mode based on this event ... figure out what
-	// mode set event returns?
-//	_modes =
+-(void) modesChanged:(const IRCClientMessage *)message {
+	// MODE <channel> <modestring> [<mode arguments>...]
+	NSRange modeString = IRCClientMessageParamRange(message, 1);
+	IRCClientChannelModeChange changes[MAX(modeString.length, 1)];
+	NSMutableArray <NSData *> *parameters = [NSMutableArray array];
+	NSUInteger count = [self applyModes:message
+							  fromParam:1
+								changes:changes
+							 parameters:parameters];
+
+	NSData *nick = IRCClientMessageDataForRange(message, message->prefix);
+	if ([_delegate respondsToSelector:@selector(modesChanged:count:forChannel:by:)]) {
+		[_delegate modesChanged:changes
+						  count:count
+					 forChannel:self
+							 by:nick];
+	} else {
+		// All the mode arguments, separated by spaces.
+		NSMutableData *params = nil;
+		for (NSUInteger i = 2; i < message->paramCount; i++) {
+			if (params == nil)
+				params = [NSMutableData data];
+			else
+				[params appendBytes:" "
+							 length:1];
+			NSRange param = IRCClientMessageParamRange(message, i);
+			[params appendBytes:(message->bytes + param.location)
+						 length:param.length];
+		}
+
+		[_delegate modeSet:IRCClientMessageDataForRange(message, modeString)
+				forChannel:self
+				withParams:params
+						by:nick];
+	}
+}
 
-	[_delegate modeSet:mode 
-			forChannel:self 
-			withParams:params 
-					by:nick];
+-(void) modesReceived:(const IRCClientMessage *)message {
+	// RPL_CHANNELMODEIS: <client> <channel> <modestring> <mode arguments>...
+	// This is the whole set of (non-list) modes, so it replaces what we had.
+	memset(_modeFlags, 0, sizeof(_modeFlags));
+	[_modeParameters removeAllObjects];
+
+	NSRange modeString = IRCClientMessageParamRange(message, 2);
+	IRCClientChannelModeChange changes[MAX(modeString.length, 1)];
+	NSMutableArray <NSData *> *parameters = [NSMutableArray array];
+	NSUInteger count = [self applyModes:message
+							  fromParam:2
+								changes:changes
+							 parameters:parameters];
+
+	if ([_delegate respondsToSelector:@selector(modesChanged:count:forChannel:by:)])
+		[_delegate modesChanged:changes
+						  count:count
+					 forChannel:self
+							 by:IRCClientMessageDataForRange(message, message->prefix)];
+}
+
+-(void) addListEntry:(NSData *)entry
+			 forMode:(uint8_t)mode {
+	NSMutableSet <NSData *> *list = _modeLists[@(mode)];
+	if (list == nil) {
+		list = [NSMutableSet set];
+		_modeLists[@(mode)] = list;
+	}
+	[list addObject:entry];
 }
 
 -(void) topicSet:(NSData *)topic 
@@ -225,7 +663,7 @@
 				by:(NSData *)byNick
 				us:(BOOL)wasItUs {
 	if (!wasItUs) {
-		[_nicks removeObject:nick];
+		[self removeMember:nick];
 	} else {
 		// NOTE: When the channel object receives this message, and wasItUs
 		// is true, its session has already removed the channel from its list
@@ -241,6 +679,44 @@
 					   us:wasItUs];
 }
 
+-(void) caseMappingChanged {
+	_members = [self reinternMembers:_members];
+	if (_pendingMembers != nil)
+		_pendingMembers = [self reinternMembers:_pendingMembers];
+}
+
+-(void) userQuit:(NSData *)nick {
+	[self removeMember:nick];
+}
+
+-(void) nickChangedFrom:(NSData *)oldNick
+					 to:(NSData *)newNick {
+	if (newNick.length == 0)
+		return;
+
+	IRCClientIdentifier *oldIdentifier = [self identifierForNick:oldNick.bytes
+														  length:oldNick.length
+														  create:NO];
+	if (oldIdentifier == nil)
+		return;
+
+	NSNumber *prefixes = _members[oldIdentifier];
+	NSNumber *pendingPrefixes = _pendingMembers[oldIdentifier];
+	if (prefixes == nil && pendingPrefixes == nil)
+		return;
+
+	[_members removeObjectForKey:oldIdentifier];
+	[_pendingMembers removeObjectForKey:oldIdentifier];
+
+	IRCClientIdentifier *newIdentifier = [self identifierForNick:newNick.bytes
+														  length:newNick.length
+														  create:YES];
+	if (prefixes != nil)
+		_members[newIdentifier] = prefixes;
+	if (pendingPrefixes != nil)
+		_pendingMembers[newIdentifier] = pendingPrefixes;
+}
+
 -(void) messageSent:(NSData *)message 
 			 byUser:(NSData *)nick {
 	[_delegate messageSent:message
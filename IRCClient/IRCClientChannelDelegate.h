@@ -8,6 +8,7 @@
 //  See LICENSE and README.md for more info.
 
 #import <Foundation/Foundation.h>
+#import "IRCClientChannelMode.h"
 
 /** @brief Receives delegate messages from an IRCClientChannel.
  *
@@ -49,8 +50,12 @@
 /** Received when an IRC client changes the channel mode. What modes are available
  *  for a given channel is an implementation detail for each server.
  *
+ *	(Not received if the delegate implements
+ *	-[modesChanged:count:forChannel:by:].)
+ *
  *  @param mode The new channel mode.
- *  @param params Any parameters with the mode (such as channel key).
+ *  @param params Any parameters with the mode (such as channel key), separated
+ *	by spaces.
  *  @param nick The nickname of the IRC client that changed the mode.
  */
 -(void) modeSet:(NSData *)mode 
@@ -112,4 +117,27 @@
 				 byUser:(NSData *)nick 
 			  onChannel:(IRCClientChannel *)session;
 
+/** Received when the server has finished listing the users on the channel
+ *	(in reply to NAMES, which is also sent on joining the channel); the
+ *	channel’s nicks property has been updated.
+ */
+@optional
+-(void) namesReceivedForChannel:(IRCClientChannel *)channel;
+
+/** Received when modes are changed on the channel (or when the server lists
+ *	the channel’s modes, in reply to MODE); the channel’s mode state (and
+ *	its members’ prefixes) have been updated. Preferred over
+ *	-[modeSet:forChannel:withParams:by:], which is not received if this is
+ *	implemented.
+ *
+ *  @param changes The changes, one per mode, in the order given.
+ *  @param count The number of changes.
+ *  @param nick The nickname of the IRC client (or the server) that changed
+ *	the modes.
+ */
+-(void) modesChanged:(const IRCClientChannelModeChange *)changes
+			   count:(NSUInteger)count
+		  forChannel:(IRCClientChannel *)channel
+				  by:(NSData *)nick;
+
 @end
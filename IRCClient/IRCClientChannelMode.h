@@ -0,0 +1,69 @@
+//
+//	IRCClientChannelMode.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+
+/************************************/
+#pragma mark IRCClientChannelModeType
+/************************************/
+
+/**	The kinds of channel mode (as advertised by the server in the CHANMODES
+	and PREFIX tokens of RPL_ISUPPORT).
+ */
+typedef NS_ENUM(uint8_t, IRCClientChannelModeType) {
+	/**	A mode that the server hasn’t told us about; treated as a flag.
+	 */
+	IRCClientChannelModeTypeUnknown = 0,
+	/**	(Type A.) Adds to or removes from a list, such as the ban list (+b);
+		always has a parameter.
+	 */
+	IRCClientChannelModeTypeList,
+	/**	(Type B.) A setting that always has a parameter, such as the channel
+		key (+k).
+	 */
+	IRCClientChannelModeTypeParameter,
+	/**	(Type C.) A setting that has a parameter only when set, such as the
+		user limit (+l).
+	 */
+	IRCClientChannelModeTypeParameterWhenSet,
+	/**	(Type D.) A setting with no parameter, such as moderated (+m).
+	 */
+	IRCClientChannelModeTypeFlag,
+	/**	A channel membership prefix, such as operator (+o); the parameter is
+		the nick of the member.
+	 */
+	IRCClientChannelModeTypeMembership
+};
+
+/***********************************************/
+#pragma mark - IRCClientChannelModeChange struct
+/***********************************************/
+
+/** @struct IRCClientChannelModeChange
+ *	@brief One mode that was set or unset on a channel.
+ *
+ *	A MODE message may change any number of modes; they’re passed to the
+ *	channel’s delegate as an array of these (see
+ *	-[IRCClientChannelDelegate modesChanged:count:forChannel:by:]). The
+ *	channel’s state has already been updated.
+ */
+typedef struct {
+	/**	YES if the mode was set (+), NO if it was unset (-).
+	 */
+	BOOL adding;
+
+	uint8_t mode;
+
+	IRCClientChannelModeType type;
+
+	/**	The mode’s parameter, or nil if it has none. Only valid for the
+		duration of the delegate call (copy the pointer to keep it).
+	 */
+	__unsafe_unretained NSData *parameter;
+} IRCClientChannelModeChange;
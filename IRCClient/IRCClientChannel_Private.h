@@ -9,6 +9,7 @@
 
 #import "IRCClientChannel.h"
 #import "IRCClientSession.h"
+#import "IRCClientMessage.h"
 
 /********************************************/
 #pragma mark IRCClientChannel class extension
@@ -37,15 +38,22 @@
  *	in files that make use of the IRCClientChannel class.
  */
 
+-(void) namesReceived:(NSData *)names;
+
+-(void) namesEnded;
+
 -(void) userJoined:(NSData *)nick;
 
 -(void) userParted:(NSData *)nick 
 		withReason:(NSData *)reason 
 				us:(BOOL)wasItUs;
 
--(void) modeSet:(NSData *)mode 
-	 withParams:(NSData *)params 
-			 by:(NSData *)nick;
+-(void) modesChanged:(const IRCClientMessage *)message;
+
+-(void) modesReceived:(const IRCClientMessage *)message;
+
+-(void) addListEntry:(NSData *)entry
+			 forMode:(uint8_t)mode;
 
 -(void) topicSet:(NSData *)newTopic 
 			  by:(NSData *)nick;
@@ -55,6 +63,13 @@
 				by:(NSData *)byNick 
 				us:(BOOL)wasItUs;
 
+-(void) caseMappingChanged;
+
+-(void) userQuit:(NSData *)nick;
+
+-(void) nickChangedFrom:(NSData *)oldNick
+					 to:(NSData *)newNick;
+
 -(void) messageSent:(NSData *)message 
 			 byUser:(NSData *)nick;
 
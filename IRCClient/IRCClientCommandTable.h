@@ -0,0 +1,106 @@
+//
+//	IRCClientCommandTable.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+/*	NOTE: This file is generated by Scripts/generate_command_table.py.
+	Do not edit it by hand; edit the script and re-run it instead.
+ */
+
+#import <Foundation/Foundation.h>
+
+/****************************/
+#pragma mark IRCClientCommand
+/****************************/
+
+typedef NS_ENUM(NSUInteger, IRCClientCommand) {
+	IRCClientCommandUnknown = 0,
+	IRCClientCommandPING,
+	IRCClientCommandNICK,
+	IRCClientCommandQUIT,
+	IRCClientCommandJOIN,
+	IRCClientCommandPART,
+	IRCClientCommandMODE,
+	IRCClientCommandTOPIC,
+	IRCClientCommandKICK,
+	IRCClientCommandERROR,
+	IRCClientCommandINVITE,
+	IRCClientCommandPRIVMSG,
+	IRCClientCommandNOTICE,
+	IRCClientCommandCAP,
+	IRCClientCommandAUTHENTICATE,
+	IRCClientCommandBATCH,
+	IRCClientCommandFAIL,
+};
+
+/********************************/
+#pragma mark - Perfect hash table
+/********************************/
+
+#define IRCClientCommandHashMultiplier 0x9E3779C3U
+#define IRCClientCommandHashBits 5
+
+static const struct {
+	const char *name;
+	NSUInteger length;
+	IRCClientCommand command;
+} IRCClientCommandHashTable[1 << IRCClientCommandHashBits] = {
+	/*  0 */ { NULL, 0, IRCClientCommandUnknown },
+	/*  1 */ { NULL, 0, IRCClientCommandUnknown },
+	/*  2 */ { NULL, 0, IRCClientCommandUnknown },
+	/*  3 */ { NULL, 0, IRCClientCommandUnknown },
+	/*  4 */ { "MODE", 4, IRCClientCommandMODE },
+	/*  5 */ { "NOTICE", 6, IRCClientCommandNOTICE },
+	/*  6 */ { NULL, 0, IRCClientCommandUnknown },
+	/*  7 */ { "INVITE", 6, IRCClientCommandINVITE },
+	/*  8 */ { NULL, 0, IRCClientCommandUnknown },
+	/*  9 */ { NULL, 0, IRCClientCommandUnknown },
+	/* 10 */ { NULL, 0, IRCClientCommandUnknown },
+	/* 11 */ { NULL, 0, IRCClientCommandUnknown },
+	/* 12 */ { NULL, 0, IRCClientCommandUnknown },
+	/* 13 */ { NULL, 0, IRCClientCommandUnknown },
+	/* 14 */ { "JOIN", 4, IRCClientCommandJOIN },
+	/* 15 */ { "FAIL", 4, IRCClientCommandFAIL },
+	/* 16 */ { "ERROR", 5, IRCClientCommandERROR },
+	/* 17 */ { "NICK", 4, IRCClientCommandNICK },
+	/* 18 */ { NULL, 0, IRCClientCommandUnknown },
+	/* 19 */ { NULL, 0, IRCClientCommandUnknown },
+	/* 20 */ { "KICK", 4, IRCClientCommandKICK },
+	/* 21 */ { "QUIT", 4, IRCClientCommandQUIT },
+	/* 22 */ { "CAP", 3, IRCClientCommandCAP },
+	/* 23 */ { NULL, 0, IRCClientCommandUnknown },
+	/* 24 */ { "PRIVMSG", 7, IRCClientCommandPRIVMSG },
+	/* 25 */ { "AUTHENTICATE", 12, IRCClientCommandAUTHENTICATE },
+	/* 26 */ { "TOPIC", 5, IRCClientCommandTOPIC },
+	/* 27 */ { NULL, 0, IRCClientCommandUnknown },
+	/* 28 */ { NULL, 0, IRCClientCommandUnknown },
+	/* 29 */ { "PING", 4, IRCClientCommandPING },
+	/* 30 */ { "BATCH", 5, IRCClientCommandBATCH },
+	/* 31 */ { "PART", 4, IRCClientCommandPART },
+};
+
+/*****************************/
+#pragma mark - Lookup function
+/*****************************/
+
+/**	Returns the IRCClientCommand for the given command bytes (or
+	IRCClientCommandUnknown if the command is not one that IRCClient handles).
+ */
+static inline IRCClientCommand IRCClientCommandLookup(const uint8_t *bytes,
+													   NSUInteger length) {
+	uint32_t key = 0;
+	for (NSUInteger i = 0; i < length && i < 4; i++)
+		key |= ((uint32_t) bytes[i]) << (8 * i);
+	key ^= (uint32_t) length;
+
+	uint32_t slot = (key * IRCClientCommandHashMultiplier) >> (32 - IRCClientCommandHashBits);
+	if (   IRCClientCommandHashTable[slot].length == length
+		&& memcmp(IRCClientCommandHashTable[slot].name, bytes, length) == 0)
+		return IRCClientCommandHashTable[slot].command;
+
+	return IRCClientCommandUnknown;
+}
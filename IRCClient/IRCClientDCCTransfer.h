@@ -0,0 +1,153 @@
+//
+//	IRCClientDCCTransfer.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+
+@class IRCClientDCCTransfer;
+
+/*****************************************/
+#pragma mark IRCClientDCCTransferDirection
+/*****************************************/
+
+typedef NS_ENUM(NSUInteger, IRCClientDCCTransferDirection) {
+	/**	We’re sending the file (see -[IRCClientSession sendFile:to:passive:]).
+	 */
+	IRCClientDCCTransferSend = 0,
+	/**	We’re being sent the file (see -[IRCClientSessionDelegate
+		fileTransferOffered:session:]).
+	 */
+	IRCClientDCCTransferReceive
+};
+
+/***************************************/
+#pragma mark - IRCClientDCCTransferState
+/***************************************/
+
+typedef NS_ENUM(NSUInteger, IRCClientDCCTransferState) {
+	/**	The file has been offered; the transfer is waiting to be accepted (or
+		for the other side to connect).
+	 */
+	IRCClientDCCTransferOffered = 0,
+	IRCClientDCCTransferConnecting,
+	IRCClientDCCTransferTransferring,
+	IRCClientDCCTransferFinished,
+	/**	The transfer failed, or was cancelled; see -[IRCClientDCCTransfer
+		error].
+	 */
+	IRCClientDCCTransferFailed
+};
+
+/***************************************************/
+#pragma mark - IRCClientDCCTransferDelegate protocol
+/***************************************************/
+
+/** @protocol IRCClientDCCTransferDelegate
+ *	@brief Receives a transfer’s events (on its session’s queue).
+ */
+@protocol IRCClientDCCTransferDelegate <NSObject>
+
+/**	Sent (at most once per progressInterval) while the transfer is under way.
+ */
+@optional
+-(void) transferProgressed:(IRCClientDCCTransfer *)transfer;
+
+/**	The whole file has been transferred.
+ */
+@required
+-(void) transferFinished:(IRCClientDCCTransfer *)transfer;
+
+@required
+-(void) transfer:(IRCClientDCCTransfer *)transfer
+didFailWithError:(NSError *)error;
+
+@end
+
+/** @class IRCClientDCCTransfer
+ *	@brief A file sent to, or received from, another IRC user over DCC.
+ *
+ *	Transfers run on their session’s queue (and so on its event loop, if it
+ *	has one). Outgoing files are sent with sendfile(), straight from the file
+ *	to the socket; incoming files are written (with pwrite()) to a file whose
+ *	space has been set aside in advance.
+ */
+
+/****************************************************/
+#pragma mark - IRCClientDCCTransfer class declaration
+/****************************************************/
+
+@interface IRCClientDCCTransfer : NSObject
+
+@property (weak) id <IRCClientDCCTransferDelegate> delegate;
+
+@property (readonly) IRCClientDCCTransferDirection direction;
+
+@property (readonly) IRCClientDCCTransferState state;
+
+/**	The user that the file is being sent to, or received from.
+ */
+@property (readonly) NSData *nick;
+
+/**	The file’s name, as offered.
+ */
+@property (readonly) NSData *filename;
+
+/**	The file’s size, as offered (0 if the sender didn’t say).
+ */
+@property (readonly) uint64_t size;
+
+/**	The local file (nil for an incoming transfer that hasn’t been accepted).
+ */
+@property (readonly) NSString *path;
+
+/**	YES if the receiver connects to the sender, rather than the other way
+	around (“passive”, or “reverse”, DCC; for senders behind NAT).
+ */
+@property (readonly) BOOL passive;
+
+/**	The other side’s address (a numeric IPv4 or IPv6 address) and port, once
+	known.
+ */
+@property (readonly) NSData *remoteAddress;
+@property (readonly) NSUInteger remotePort;
+
+/**	Where in the file the transfer started (more than 0 if it was resumed).
+ */
+@property (readonly) uint64_t startPosition;
+
+/**	How far into the file the transfer has got.
+ */
+@property (readonly) uint64_t position;
+
+/**	How fast the transfer has been going (in bytes per second), over the
+	last progressInterval.
+ */
+@property (readonly) double throughput;
+
+/**	How long the transfer has been under way (since it connected).
+ */
+@property (readonly) NSTimeInterval duration;
+
+/**	How often to send -[transferProgressed:]. The default is 1 second.
+ */
+@property (assign) NSTimeInterval progressInterval;
+
+/**	How long to wait for the other side to accept (or connect) before giving
+	up. The default is 120 seconds.
+ */
+@property (assign) NSTimeInterval offerTimeout;
+
+/**	Why the transfer failed (nil unless it has).
+ */
+@property (readonly) NSError *error;
+
+/**	Stops the transfer (which then fails, with ECANCELED).
+ */
+-(void) cancel;
+
+@end
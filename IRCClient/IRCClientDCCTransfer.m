@@ -0,0 +1,651 @@
+//
+//	IRCClientDCCTransfer.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientDCCTransfer.h"
+#import "IRCClientDCCTransfer_Private.h"
+
+#import <sys/socket.h>
+#import <sys/stat.h>
+#import <sys/uio.h>
+#import <netinet/in.h>
+#import <netdb.h>
+#import <fcntl.h>
+#import <unistd.h>
+
+/******************************/
+#pragma mark - Static variables
+/******************************/
+
+static const NSTimeInterval IRCClientDCCTransferDefaultProgressInterval = 1.0;
+static const NSTimeInterval IRCClientDCCTransferDefaultOfferTimeout = 120.0;
+
+// The most bytes to hand to one sendfile() call (so that one transfer doesn’t
+// hog the queue that it shares with its session).
+static const off_t IRCClientDCCSendChunkSize = 1 << 20;
+
+// The most bytes to read (and write to the file) at once.
+#define IRCClientDCCReceiveChunkSize (64 * 1024)
+
+/******************************/
+#pragma mark - Helper functions
+/******************************/
+
+static uint64_t IRCClientDCCCurrentTime(void) {
+	return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+/*******************************************************/
+#pragma mark - IRCClientDCCTransfer class implementation
+/*******************************************************/
+
+@implementation IRCClientDCCTransfer {
+	dispatch_queue_t _queue;
+
+	int _file;
+
+	// The listening socket’s source (which closes the socket when cancelled).
+	dispatch_source_t _listenSource;
+
+	// The connection’s sources; the socket is closed once both have been
+	// cancelled. (Sources must be resumed before they’re cancelled, so we
+	// keep track of which ones are suspended.)
+	int _socket;
+	dispatch_source_t _readSource;
+	BOOL _readSourceSuspended;
+	dispatch_source_t _writeSource;
+	BOOL _writeSourceSuspended;
+	BOOL _connected;
+
+	// Bumped on every listen and connect, so that a timeout meant for an
+	// earlier one is ignored.
+	NSUInteger _phase;
+
+	// The receiver’s acknowledgment (of how many bytes it has, modulo 2^32)
+	// being read, a byte at a time, and the last one read in full.
+	uint8_t _ack[4];
+	NSUInteger _ackLength;
+	uint32_t _lastAck;
+
+	// The acknowledgment being sent (by the receiver), how much of it is
+	// still to go out, and whether there’s a later position to acknowledge
+	// once it has.
+	uint8_t _outgoingAck[4];
+	NSUInteger _outgoingAckRemaining;
+	BOOL _outgoingAckStale;
+
+	// When the transfer connected, and the last progress report.
+	uint64_t _startTime;
+	uint64_t _progressTime;
+	uint64_t _progressPosition;
+}
+
+/********************************************/
+#pragma mark - Initializers & factory methods
+/********************************************/
+
+-(instancetype) initWithDirection:(IRCClientDCCTransferDirection)direction
+							 nick:(NSData *)nick
+						 filename:(NSData *)filename
+							 size:(uint64_t)size
+						  passive:(BOOL)passive
+							queue:(dispatch_queue_t)queue {
+	if (!(self = [super init]))
+		return nil;
+
+	_direction = direction;
+	_nick = [nick copy];
+	_filename = [filename copy];
+	_size = size;
+	_passive = passive;
+	_queue = queue;
+
+	_file = -1;
+	_socket = -1;
+	_progressInterval = IRCClientDCCTransferDefaultProgressInterval;
+	_offerTimeout = IRCClientDCCTransferDefaultOfferTimeout;
+
+	return self;
+}
+
+-(void) dealloc {
+	[self close];
+}
+
+/******************************/
+#pragma mark - Custom accessors
+/******************************/
+
+-(NSTimeInterval) duration {
+	return (_startTime != 0
+			? (IRCClientDCCCurrentTime() - _startTime) / (NSTimeInterval) NSEC_PER_SEC
+			: 0);
+}
+
+/****************************/
+#pragma mark - Public methods
+/****************************/
+
+-(void) cancel {
+	dispatch_async(_queue, ^{
+		[self failWithErrno:ECANCELED];
+	});
+}
+
+/*****************************/
+#pragma mark - Private methods
+/*****************************/
+
+-(BOOL) openFileForSendingAtPath:(NSString *)path {
+	_path = [path copy];
+	_file = open(path.fileSystemRepresentation, O_RDONLY | O_CLOEXEC);
+	struct stat fileStatus;
+	if (   _file < 0
+		|| fstat(_file, &fileStatus) < 0) {
+		_error = [NSError errorWithDomain:NSPOSIXErrorDomain
+									 code:errno
+								 userInfo:nil];
+		return NO;
+	}
+	_size = (uint64_t) fileStatus.st_size;
+
+	return YES;
+}
+
+-(BOOL) openFileForReceivingAtPath:(NSString *)path
+							resume:(BOOL)resume {
+	_path = [path copy];
+	_file = open(path.fileSystemRepresentation, O_WRONLY | O_CREAT | O_CLOEXEC | (resume ? 0 : O_TRUNC), 0644);
+	struct stat fileStatus;
+	if (   _file < 0
+		|| fstat(_file, &fileStatus) < 0) {
+		_error = [NSError errorWithDomain:NSPOSIXErrorDomain
+									 code:errno
+								 userInfo:nil];
+		return NO;
+	}
+
+	// (Only what’s short of the whole file can be resumed.)
+	if (   resume
+		&& (uint64_t) fileStatus.st_size < _size)
+		_startPosition = (uint64_t) fileStatus.st_size;
+
+	return YES;
+}
+
+-(BOOL) listenWithFamily:(int)family {
+	int fd = socket(family, SOCK_STREAM, IPPROTO_TCP);
+	if (fd < 0)
+		return [self setErrno:errno];
+
+	int on = 1;
+	setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+	struct sockaddr_storage address = { 0 };
+	socklen_t addressLength;
+	if (family == AF_INET6) {
+		struct sockaddr_in6 *address6 = (struct sockaddr_in6 *) &address;
+		address6->sin6_len = sizeof(*address6);
+		address6->sin6_family = AF_INET6;
+		address6->sin6_addr = in6addr_any;
+		addressLength = sizeof(*address6);
+	} else {
+		struct sockaddr_in *address4 = (struct sockaddr_in *) &address;
+		address4->sin_len = sizeof(*address4);
+		address4->sin_family = AF_INET;
+		address4->sin_addr.s_addr = htonl(INADDR_ANY);
+		addressLength = sizeof(*address4);
+	}
+
+	// (Port 0: the system picks one.)
+	if (   bind(fd, (struct sockaddr *) &address, addressLength) < 0
+		|| listen(fd, 1) < 0
+		|| getsockname(fd, (struct sockaddr *) &address, &addressLength) < 0) {
+		int errorNumber = errno;
+		close(fd);
+		return [self setErrno:errorNumber];
+	}
+	_localPort = ntohs(family == AF_INET6
+					   ? ((struct sockaddr_in6 *) &address)->sin6_port
+					   : ((struct sockaddr_in *) &address)->sin_port);
+
+	_listenSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t) fd, 0, _queue);
+	__weak typeof(self) weakSelf = self;
+	dispatch_source_set_event_handler(_listenSource, ^{
+		[weakSelf connectionAvailable];
+	});
+	dispatch_source_set_cancel_handler(_listenSource, ^{
+		close(fd);
+	});
+	dispatch_resume(_listenSource);
+
+	[self startTimeout];
+
+	return YES;
+}
+
+-(void) connectionAvailable {
+	int fd = accept((int) dispatch_source_get_handle(_listenSource), NULL, NULL);
+	if (fd < 0) {
+		if (errno != EAGAIN && errno != EINTR)
+			[self failWithErrno:errno];
+		return;
+	}
+
+	// One connection is all we want.
+	dispatch_source_cancel(_listenSource);
+	_listenSource = nil;
+	_localPort = 0;
+
+	int on = 1;
+	setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+	[self watchSocket:fd];
+	[self connected];
+}
+
+-(void) connectToAddress:(NSData *)address
+					port:(NSUInteger)port {
+	_remoteAddress = [address copy];
+	_remotePort = port;
+	_state = IRCClientDCCTransferConnecting;
+
+	// (The address is numeric, so this doesn’t block.)
+	char host[NI_MAXHOST];
+	snprintf(host, sizeof(host), "%.*s", (int) address.length, address.bytes);
+	char service[8];
+	snprintf(service, sizeof(service), "%lu", (unsigned long) port);
+
+	struct addrinfo hints = { 0 };
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+
+	struct addrinfo *addressInfo = NULL;
+	if (getaddrinfo(host, service, &hints, &addressInfo) != 0) {
+		[self failWithErrno:EADDRNOTAVAIL];
+		return;
+	}
+
+	int fd = socket(addressInfo->ai_family, SOCK_STREAM, IPPROTO_TCP);
+	if (fd < 0) {
+		freeaddrinfo(addressInfo);
+		[self failWithErrno:errno];
+		return;
+	}
+
+	int on = 1;
+	setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+	int result = connect(fd, addressInfo->ai_addr, addressInfo->ai_addrlen);
+	int errorNumber = errno;
+	freeaddrinfo(addressInfo);
+	if (   result < 0
+		&& errorNumber != EINPROGRESS) {
+		close(fd);
+		[self failWithErrno:errorNumber];
+		return;
+	}
+
+	// The socket becomes writable once it has connected (or failed to).
+	[self watchSocket:fd];
+	dispatch_resume(_writeSource);
+	_writeSourceSuspended = NO;
+
+	[self startTimeout];
+}
+
+-(void) watchSocket:(int)fd {
+	_socket = fd;
+
+	// Close the socket once both sources have been cancelled.
+	__block NSUInteger sourcesRemaining = 2;
+	dispatch_block_t cancelHandler = ^{
+		if (--sourcesRemaining == 0)
+			close(fd);
+	};
+
+	__weak typeof(self) weakSelf = self;
+
+	_readSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t) fd, 0, _queue);
+	dispatch_source_set_event_handler(_readSource, ^{
+		[weakSelf socketIsReadable];
+	});
+	dispatch_source_set_cancel_handler(_readSource, cancelHandler);
+	_readSourceSuspended = YES;
+
+	_writeSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_WRITE, (uintptr_t) fd, 0, _queue);
+	dispatch_source_set_event_handler(_writeSource, ^{
+		[weakSelf socketIsWritable];
+	});
+	dispatch_source_set_cancel_handler(_writeSource, cancelHandler);
+	_writeSourceSuspended = YES;
+}
+
+// Fails the transfer if it’s still waiting for the other side, once the offer
+// timeout is up.
+-(void) startTimeout {
+	NSUInteger phase = ++_phase;
+	__weak typeof(self) weakSelf = self;
+	dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t) (_offerTimeout * NSEC_PER_SEC)), _queue, ^{
+		typeof(self) strongSelf = weakSelf;
+		if (   strongSelf != nil
+			&& strongSelf->_phase == phase
+			&& strongSelf->_connected == NO
+			&& strongSelf->_state < IRCClientDCCTransferFinished)
+			[strongSelf failWithErrno:ETIMEDOUT];
+	});
+}
+
+-(void) connected {
+	_connected = YES;
+	_state = IRCClientDCCTransferTransferring;
+	_position = _startPosition;
+	_startTime = IRCClientDCCCurrentTime();
+	_progressTime = _startTime;
+	_progressPosition = _position;
+
+	// (Both sides read: the receiver, the file; the sender, the receiver’s
+	// acknowledgments.)
+	dispatch_resume(_readSource);
+	_readSourceSuspended = NO;
+
+	if (_direction == IRCClientDCCTransferSend) {
+		if (_writeSourceSuspended) {
+			dispatch_resume(_writeSource);
+			_writeSourceSuspended = NO;
+		}
+	} else {
+		if (_writeSourceSuspended == NO) {
+			dispatch_suspend(_writeSource);
+			_writeSourceSuspended = YES;
+		}
+
+		// Set aside the space for the rest of the file (without changing its
+		// length, so that an interrupted transfer can still be resumed from
+		// where it got to). Contiguous space if we can get it; any if not.
+		if (_size > _position) {
+			fstore_t store = {
+				.fst_flags = F_ALLOCATECONTIG | F_ALLOCATEALL,
+				.fst_posmode = F_PEOFPOSMODE,
+				.fst_offset = 0,
+				.fst_length = (off_t) (_size - _position)
+			};
+			if (fcntl(_file, F_PREALLOCATE, &store) < 0) {
+				store.fst_flags = F_ALLOCATEALL;
+				fcntl(_file, F_PREALLOCATE, &store);
+			}
+		}
+	}
+}
+
+-(void) socketIsWritable {
+	if (_connected == NO) {
+		int socketError = 0;
+		socklen_t length = sizeof(socketError);
+		getsockopt(_socket, SOL_SOCKET, SO_ERROR, &socketError, &length);
+		if (socketError != 0) {
+			[self failWithErrno:socketError];
+			return;
+		}
+
+		[self connected];
+		if (_direction == IRCClientDCCTransferReceive)
+			return;
+	}
+
+	// (The receiver only writes acknowledgments that didn’t fit at once.)
+	if (_direction == IRCClientDCCTransferReceive) {
+		[self flushAcknowledgment];
+		return;
+	}
+
+	// Straight from the file to the socket, a chunk at a time. (If the socket
+	// can’t take a whole chunk, sendfile() sends what it can, and we come
+	// back when there’s space; the write source is level-triggered.)
+	off_t length = (off_t) MIN(_size - _position, (uint64_t) IRCClientDCCSendChunkSize);
+	if (length > 0) {
+		int result = sendfile(_file, _socket, (off_t) _position, &length, NULL, 0);
+		_position += (uint64_t) length;
+		if (   result < 0
+			&& errno != EAGAIN
+			&& errno != EINTR) {
+			[self failWithErrno:errno];
+			return;
+		}
+		[self reportProgress];
+	}
+
+	// All sent; now we wait for the receiver to say it has all of it (unless
+	// there was nothing to send).
+	if (_size == 0) {
+		[self finish];
+	} else if (_position >= _size) {
+		dispatch_suspend(_writeSource);
+		_writeSourceSuspended = YES;
+	}
+}
+
+-(void) socketIsReadable {
+	if (_direction == IRCClientDCCTransferSend) {
+		[self acknowledgmentsAvailable];
+		return;
+	}
+
+	uint8_t buffer[IRCClientDCCReceiveChunkSize];
+	ssize_t bytesRead = read(_socket, buffer, sizeof(buffer));
+	if (bytesRead < 0) {
+		if (errno != EAGAIN && errno != EINTR)
+			[self failWithErrno:errno];
+		return;
+	} else if (bytesRead == 0) {
+		// If the sender didn’t say how big the file is, it’s done when it
+		// closes the connection.
+		if (   _size == 0
+			|| _position >= _size)
+			[self finish];
+		else
+			[self failWithErrno:ECONNRESET];
+		return;
+	}
+
+	for (ssize_t written = 0; written < bytesRead; ) {
+		ssize_t result = pwrite(_file, buffer + written, (size_t) (bytesRead - written), (off_t) (_position + (uint64_t) written));
+		if (result < 0) {
+			if (errno == EINTR)
+				continue;
+			[self failWithErrno:errno];
+			return;
+		}
+		written += result;
+	}
+	_position += (uint64_t) bytesRead;
+
+	[self acknowledge];
+
+	[self reportProgress];
+
+	if (   _size > 0
+		&& _position >= _size)
+		[self finish];
+}
+
+// Acknowledges what we have so far. (The sender doesn’t wait for each
+// acknowledgment, so one that hasn’t started going out is just replaced with
+// the latest; but one that has must be finished first, or the sender would
+// read the rest of it as part of the next.)
+-(void) acknowledge {
+	if (   _outgoingAckRemaining == 0
+		|| _outgoingAckRemaining == sizeof(_outgoingAck))
+		[self setOutgoingAcknowledgment];
+	else
+		_outgoingAckStale = YES;
+
+	[self flushAcknowledgment];
+}
+
+-(void) setOutgoingAcknowledgment {
+	uint32_t ack = htonl((uint32_t) _position);
+	memcpy(_outgoingAck, &ack, sizeof(ack));
+	_outgoingAckRemaining = sizeof(_outgoingAck);
+	_outgoingAckStale = NO;
+}
+
+// Sends as much of the outgoing acknowledgment (and of any later one) as the
+// socket will take; if it won’t take it all, the rest goes when there’s room.
+-(void) flushAcknowledgment {
+	while (_outgoingAckRemaining > 0) {
+		ssize_t sent = send(_socket,
+							_outgoingAck + (sizeof(_outgoingAck) - _outgoingAckRemaining),
+							_outgoingAckRemaining,
+							0);
+		if (sent < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN) {
+				if (_writeSourceSuspended) {
+					dispatch_resume(_writeSource);
+					_writeSourceSuspended = NO;
+				}
+				return;
+			}
+
+			// (A connection that’s gone is noticed when reading.)
+			_outgoingAckRemaining = 0;
+			break;
+		}
+
+		_outgoingAckRemaining -= (NSUInteger) sent;
+		if (   _outgoingAckRemaining == 0
+			&& _outgoingAckStale)
+			[self setOutgoingAcknowledgment];
+	}
+
+	if (_writeSourceSuspended == NO) {
+		dispatch_suspend(_writeSource);
+		_writeSourceSuspended = YES;
+	}
+}
+
+-(void) acknowledgmentsAvailable {
+	uint8_t buffer[64];
+	ssize_t bytesRead = read(_socket, buffer, sizeof(buffer));
+	if (bytesRead < 0) {
+		if (errno != EAGAIN && errno != EINTR)
+			[self failWithErrno:errno];
+		return;
+	} else if (bytesRead == 0) {
+		// (Many receivers just close the connection once they have it all.)
+		if (_position >= _size)
+			[self finish];
+		else
+			[self failWithErrno:ECONNRESET];
+		return;
+	}
+
+	for (ssize_t i = 0; i < bytesRead; i++) {
+		_ack[_ackLength++] = buffer[i];
+		if (_ackLength == sizeof(_ack)) {
+			_lastAck = (  ((uint32_t) _ack[0] << 24)
+						| ((uint32_t) _ack[1] << 16)
+						| ((uint32_t) _ack[2] << 8)
+						|  (uint32_t) _ack[3]);
+			_ackLength = 0;
+		}
+	}
+
+	if (   _position >= _size
+		&& _lastAck == (uint32_t) _size)
+		[self finish];
+}
+
+-(void) reportProgress {
+	uint64_t now = IRCClientDCCCurrentTime();
+	uint64_t elapsed = now - _progressTime;
+	if (elapsed < (uint64_t) (_progressInterval * NSEC_PER_SEC))
+		return;
+
+	_throughput = (_position - _progressPosition) / (elapsed / (double) NSEC_PER_SEC);
+	_progressTime = now;
+	_progressPosition = _position;
+
+	id <IRCClientDCCTransferDelegate> delegate = _delegate;
+	if ([delegate respondsToSelector:@selector(transferProgressed:)])
+		[delegate transferProgressed:self];
+}
+
+-(void) finish {
+	uint64_t elapsed = IRCClientDCCCurrentTime() - _progressTime;
+	if (elapsed > 0)
+		_throughput = (_position - _progressPosition) / (elapsed / (double) NSEC_PER_SEC);
+
+	[self close];
+	_state = IRCClientDCCTransferFinished;
+
+	[_delegate transferFinished:self];
+	[self ended];
+}
+
+-(BOOL) setErrno:(int)errorNumber {
+	_error = [NSError errorWithDomain:NSPOSIXErrorDomain
+								 code:errorNumber
+							 userInfo:nil];
+	return NO;
+}
+
+-(void) failWithErrno:(int)errorNumber {
+	if (_state >= IRCClientDCCTransferFinished)
+		return;
+
+	[self setErrno:errorNumber];
+	[self close];
+	_state = IRCClientDCCTransferFailed;
+
+	[_delegate transfer:self
+	   didFailWithError:_error];
+	[self ended];
+}
+
+-(void) ended {
+	void (^endHandler)(IRCClientDCCTransfer *) = _endHandler;
+	_endHandler = nil;
+	if (endHandler != nil)
+		endHandler(self);
+}
+
+-(void) close {
+	if (_listenSource != nil) {
+		dispatch_source_cancel(_listenSource);
+		_listenSource = nil;
+	}
+
+	if (_readSource != nil) {
+		if (_readSourceSuspended)
+			dispatch_resume(_readSource);
+		dispatch_source_cancel(_readSource);
+		_readSource = nil;
+	}
+	if (_writeSource != nil) {
+		if (_writeSourceSuspended)
+			dispatch_resume(_writeSource);
+		dispatch_source_cancel(_writeSource);
+		_writeSource = nil;
+	}
+	_socket = -1;
+	_connected = NO;
+
+	if (_file >= 0) {
+		close(_file);
+		_file = -1;
+	}
+}
+
+@end
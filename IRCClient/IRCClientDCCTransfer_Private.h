@@ -0,0 +1,87 @@
+//
+//	IRCClientDCCTransfer_Private.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientDCCTransfer.h"
+#import "IRCClientIdentifier.h"
+
+/*	NOTE: This header is for the framework’s internal use only. Do not import
+ *	it in files that make use of the IRCClientDCCTransfer class.
+ */
+
+/************************************************/
+#pragma mark IRCClientDCCTransfer class extension
+/************************************************/
+
+@interface IRCClientDCCTransfer ()
+
+/**	The interned nick, for matching the other side’s DCC messages to the
+	transfer. Set (on the session’s queue) by the session.
+ */
+@property (strong) IRCClientIdentifier *nickIdentifier;
+
+/**	For a passive transfer, the token that identifies it in DCC messages.
+ */
+@property (copy) NSData *token;
+
+/**	The port that the transfer is listening on (0 if it isn’t).
+ */
+@property (readonly) NSUInteger localPort;
+
+@property (readwrite) NSData *remoteAddress;
+
+@property (readwrite) NSUInteger remotePort;
+
+@property (readwrite) uint64_t startPosition;
+
+/**	YES while we’re waiting for the sender to agree (with DCC ACCEPT) to our
+	DCC RESUME.
+ */
+@property (assign) BOOL awaitingAccept;
+
+/**	Called (once) when the transfer has finished, or failed.
+ */
+@property (copy) void (^endHandler)(IRCClientDCCTransfer *transfer);
+
+/**	Returns a transfer that runs on the given queue (the session’s).
+ */
+-(instancetype) initWithDirection:(IRCClientDCCTransferDirection)direction
+							 nick:(NSData *)nick
+						 filename:(NSData *)filename
+							 size:(uint64_t)size
+						  passive:(BOOL)passive
+							queue:(dispatch_queue_t)queue;
+
+/**	Opens the file to send (and takes its size); returns NO (and sets the
+	error) if it can’t be opened.
+ */
+-(BOOL) openFileForSendingAtPath:(NSString *)path;
+
+/**	Opens (creating, if need be) the file to receive into; if resuming, the
+	transfer starts at the end of what’s already there. Returns NO (and sets
+	the error) if it can’t be opened.
+ */
+-(BOOL) openFileForReceivingAtPath:(NSString *)path
+							resume:(BOOL)resume;
+
+/**	Listens (on every interface) for the other side to connect, with a
+	socket of the given address family; returns NO (and sets the error) if
+	it can’t.
+ */
+-(BOOL) listenWithFamily:(int)family;
+
+/**	Connects to the other side (at a numeric address).
+ */
+-(void) connectToAddress:(NSData *)address
+					port:(NSUInteger)port;
+
+/**	Fails the transfer (if it hasn’t finished or failed already).
+ */
+-(void) failWithErrno:(int)errorNumber;
+
+@end
@@ -0,0 +1,79 @@
+//
+//	IRCClientEventBatch.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+
+/** @class IRCClientEventBatch
+ *	@brief A batch of messages received from the server, delivered to the
+ *	session’s delegate in one go (see -[IRCClientSession batchesEvents]).
+ *
+ *	The batch holds the messages’ bytes contiguously, along with where each
+ *	message’s parts are; NSData objects for the parts are only created when
+ *	asked for.
+ *
+ *	The messages of an IRCv3 batch (e.g. a netsplit, or chat history) are
+ *	gathered into one of these as well; see -[IRCClientSessionDelegate
+ *	batchReceived:session:].
+ */
+
+/*************************************************/
+#pragma mark IRCClientEventBatch class declaration
+/*************************************************/
+
+@interface IRCClientEventBatch : NSObject
+
+/**	The number of messages in the batch.
+ */
+@property (readonly) NSUInteger count;
+
+/**	The messages, one after another (without their CRLFs); see
+	-[rangeOfMessageAtIndex:].
+ */
+@property (readonly) NSData *bytes;
+
+/**	For an IRCv3 batch, its type (e.g. "netsplit"); nil otherwise.
+ */
+@property (readonly) NSData *batchType;
+
+/**	For an IRCv3 batch, the parameters that followed its type (e.g. the two
+	servers, for a netsplit); nil otherwise.
+ */
+@property (readonly) NSArray <NSData *> *batchParams;
+
+/**	Returns the range, in the batch’s bytes, of the message at the given
+	index.
+ */
+-(NSRange) rangeOfMessageAtIndex:(NSUInteger)index;
+
+/**	Returns the message at the given index (without its CRLF).
+ */
+-(NSData *) messageAtIndex:(NSUInteger)index;
+
+/**	Returns the prefix (e.g. nick!user@host) of the message at the given
+	index, or nil if it has none.
+ */
+-(NSData *) prefixOfMessageAtIndex:(NSUInteger)index;
+
+/**	Returns the command (or three-digit numeric reply code) of the message at
+	the given index.
+ */
+-(NSData *) commandOfMessageAtIndex:(NSUInteger)index;
+
+/**	Returns the parameters of the message at the given index.
+ */
+-(NSArray <NSData *> *) paramsOfMessageAtIndex:(NSUInteger)index;
+
+/**	Returns the (unescaped) value of the IRCv3 message tag with the given key
+	(e.g. "time", or "account") on the message at the given index; empty data
+	if the tag has no value, or nil if the message has no such tag.
+ */
+-(NSData *) valueOfTag:(NSData *)key
+	  ofMessageAtIndex:(NSUInteger)index;
+
+@end
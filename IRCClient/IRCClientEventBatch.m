@@ -0,0 +1,139 @@
+//
+//	IRCClientEventBatch.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientEventBatch.h"
+#import "IRCClientEventBatch_Private.h"
+
+/******************************/
+#pragma mark - Type definitions
+/******************************/
+
+// A message in the batch. The message’s ranges are relative to its own first
+// byte, which is at the given offset in the batch’s bytes (so the bytes may
+// be reallocated as the batch grows).
+typedef struct {
+	NSUInteger offset;
+	IRCClientMessage message;
+} IRCClientEventBatchEntry;
+
+/******************************************************/
+#pragma mark - IRCClientEventBatch class implementation
+/******************************************************/
+
+@implementation IRCClientEventBatch {
+	NSMutableData *_bytes;
+	NSMutableData *_entries;
+}
+
+/**************************/
+#pragma mark - Initializers
+/**************************/
+
+-(instancetype) init {
+	return [self initWithCapacity:0];
+}
+
+-(instancetype) initWithCapacity:(NSUInteger)capacity {
+	if (!(self = [super init]))
+		return nil;
+
+	// Most messages are well short of 512 bytes.
+	_bytes = [NSMutableData dataWithCapacity:(capacity * 128)];
+	_entries = [NSMutableData dataWithCapacity:(capacity * sizeof(IRCClientEventBatchEntry))];
+
+	return self;
+}
+
+/******************************/
+#pragma mark - Custom accessors
+/******************************/
+
+-(NSUInteger) count {
+	return _entries.length / sizeof(IRCClientEventBatchEntry);
+}
+
+-(NSData *) bytes {
+	return _bytes;
+}
+
+/****************************/
+#pragma mark - Public methods
+/****************************/
+
+-(NSRange) rangeOfMessageAtIndex:(NSUInteger)index {
+	const IRCClientEventBatchEntry *entry = [self entryAtIndex:index];
+	return NSMakeRange(entry->offset, entry->message.length);
+}
+
+-(NSData *) messageAtIndex:(NSUInteger)index {
+	return [_bytes subdataWithRange:[self rangeOfMessageAtIndex:index]];
+}
+
+-(NSData *) prefixOfMessageAtIndex:(NSUInteger)index {
+	IRCClientMessage message = [self messageStructAtIndex:index];
+	return IRCClientMessageDataForRange(&message, message.prefix);
+}
+
+-(NSData *) commandOfMessageAtIndex:(NSUInteger)index {
+	IRCClientMessage message = [self messageStructAtIndex:index];
+	return IRCClientMessageDataForRange(&message, message.command);
+}
+
+-(NSArray <NSData *> *) paramsOfMessageAtIndex:(NSUInteger)index {
+	IRCClientMessage message = [self messageStructAtIndex:index];
+	return IRCClientMessageParamsArray(&message, 0);
+}
+
+-(NSData *) valueOfTag:(NSData *)key
+	  ofMessageAtIndex:(NSUInteger)index {
+	IRCClientMessage message = [self messageStructAtIndex:index];
+	if (message.tags.location == NSNotFound)
+		return nil;
+
+	IRCClientMessageTags tags;
+	IRCClientMessageTagsParse(&message, &tags);
+	return IRCClientMessageTagValueData(&message,
+										IRCClientMessageTagValueRange(&message, &tags, key.bytes, key.length));
+}
+
+/*****************************/
+#pragma mark - Private methods
+/*****************************/
+
+-(void) addMessage:(const IRCClientMessage *)message {
+	IRCClientEventBatchEntry entry = {
+		.offset = _bytes.length,
+		.message = *message
+	};
+	entry.message.bytes = NULL;
+
+	[_bytes appendBytes:message->bytes
+				 length:message->length];
+	[_entries appendBytes:&entry
+				   length:sizeof(entry)];
+}
+
+-(const IRCClientEventBatchEntry *) entryAtIndex:(NSUInteger)index {
+	if (index >= self.count)
+		[NSException raise:NSRangeException
+					format:@"Index %lu beyond bounds of batch of %lu messages", (unsigned long) index, (unsigned long) self.count];
+
+	return ((const IRCClientEventBatchEntry *) _entries.bytes) + index;
+}
+
+// Returns the message, pointing into the batch’s bytes.
+-(IRCClientMessage) messageStructAtIndex:(NSUInteger)index {
+	const IRCClientEventBatchEntry *entry = [self entryAtIndex:index];
+	IRCClientMessage message = entry->message;
+	message.bytes = ((const uint8_t *) _bytes.bytes) + entry->offset;
+
+	return message;
+}
+
+@end
@@ -0,0 +1,35 @@
+//
+//	IRCClientEventBatch_Private.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientEventBatch.h"
+#import "IRCClientMessage.h"
+
+/*	NOTE: This header is for the framework’s internal use only. Do not import
+ *	it in files that make use of the IRCClientEventBatch class.
+ */
+
+/***********************************************/
+#pragma mark IRCClientEventBatch class extension
+/***********************************************/
+
+@interface IRCClientEventBatch ()
+
+@property (readwrite) NSData *batchType;
+
+@property (readwrite) NSArray <NSData *> *batchParams;
+
+/**	Returns an empty batch with room for the given number of messages.
+ */
+-(instancetype) initWithCapacity:(NSUInteger)capacity;
+
+/**	Copies the given (parsed) message into the batch.
+ */
+-(void) addMessage:(const IRCClientMessage *)message;
+
+@end
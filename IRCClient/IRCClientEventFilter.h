@@ -0,0 +1,54 @@
+//
+//	IRCClientEventFilter.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+
+/** @class IRCClientEventFilter
+ *	@brief Describes received messages that a session should handle (see
+ *	-[IRCClientSession eventFilters]).
+ *
+ *	A message passes the filter if it meets every one of the filter’s
+ *	criteria; criteria that are nil are ignored (so a filter with no criteria
+ *	passes everything). Filters are checked against the message as received,
+ *	before anything is made of it, so a message that passes no filter costs
+ *	nothing but the scan.
+ */
+
+/**************************************************/
+#pragma mark IRCClientEventFilter class declaration
+/**************************************************/
+
+@interface IRCClientEventFilter : NSObject <NSCopying>
+
+/**	Commands (e.g. "PRIVMSG") and three-digit numeric reply codes (e.g.
+	"332") to pass. Commands are compared case-insensitively.
+ */
+@property (copy) NSSet <NSData *> *commands;
+
+/**	Targets (channel names, or your nick) to pass messages addressed to; a
+	message addressed to several targets passes if any of them is in the set.
+	(The target is the first parameter of the message.) Names are compared
+	as the server compares them, i.e. case-insensitively.
+ */
+@property (copy) NSSet <NSData *> *targets;
+
+/**	Masks (e.g. "*!*@*.example.com") of senders to pass messages from, as
+	nick!user@host; * matches any number of characters, and ? matches any
+	one character. Masks are compared case-insensitively.
+ */
+@property (copy) NSArray <NSData *> *origins;
+
+/**	Bytes that the last parameter of the message (e.g. the text of a PRIVMSG)
+	must contain. Compared exactly (case-sensitively).
+ */
+@property (copy) NSData *text;
+
++(instancetype) filter;
+
+@end
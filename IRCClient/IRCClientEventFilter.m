@@ -0,0 +1,32 @@
+//
+//	IRCClientEventFilter.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientEventFilter.h"
+
+/*******************************************************/
+#pragma mark - IRCClientEventFilter class implementation
+/*******************************************************/
+
+@implementation IRCClientEventFilter
+
++(instancetype) filter {
+	return [self new];
+}
+
+-(id) copyWithZone:(NSZone *)zone {
+	IRCClientEventFilter *filter = [[[self class] allocWithZone:zone] init];
+	filter.commands = _commands;
+	filter.targets = _targets;
+	filter.origins = _origins;
+	filter.text = _text;
+
+	return filter;
+}
+
+@end
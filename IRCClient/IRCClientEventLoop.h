@@ -0,0 +1,50 @@
+//
+//	IRCClientEventLoop.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+
+/** @class IRCClientEventLoop
+ *	@brief A fixed pool of event loops, shared by many IRCClientSessions.
+ *
+ *	By default, each IRCClientSession has its own serial queue, on which all of
+ *	its I/O and event handling happens. An application that runs a great many
+ *	sessions at once (e.g., a bouncer) can instead create sessions with a
+ *	shared IRCClientEventLoop (see -[IRCClientSession initWithEventLoop:]);
+ *	each such session is pinned to one of the pool’s loops (serial queues), so
+ *	that all of the sessions are serviced by at most threadCount threads, and
+ *	each session’s events are still handled one at a time, in order.
+ */
+
+/************************************************/
+#pragma mark IRCClientEventLoop class declaration
+/************************************************/
+
+@interface IRCClientEventLoop : NSObject
+
+/************************/
+#pragma mark - Properties
+/************************/
+
+/** The number of loops (and thus the maximum number of threads) in the pool.
+ */
+@property (readonly) NSUInteger threadCount;
+
+/********************************************/
+#pragma mark - Initializers & factory methods
+/********************************************/
+
+/** Returns an event loop pool with one loop per active processor core.
+ */
++(instancetype) sharedEventLoop;
+
+/** Creates an event loop pool with the given number of loops (at least 1).
+ */
+-(instancetype) initWithThreadCount:(NSUInteger)threadCount;
+
+@end
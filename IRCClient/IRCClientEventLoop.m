@@ -0,0 +1,89 @@
+//
+//	IRCClientEventLoop.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientEventLoop.h"
+#import "IRCClientEventLoop_Private.h"
+
+#import <stdatomic.h>
+
+/******************************/
+#pragma mark - Static variables
+/******************************/
+
+// Identifies a loop’s queue (the value is the queue); see
+// IRCClientEventLoopCurrentQueue().
+static char IRCClientEventLoopQueueKey;
+
+/*****************************************************/
+#pragma mark - IRCClientEventLoop class implementation
+/*****************************************************/
+
+@implementation IRCClientEventLoop {
+	NSArray <dispatch_queue_t> *_queues;
+
+	atomic_uint_fast64_t _nextQueueIndex;
+}
+
+/********************************************/
+#pragma mark - Initializers & factory methods
+/********************************************/
+
++(instancetype) sharedEventLoop {
+	static IRCClientEventLoop *sharedEventLoop;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		sharedEventLoop = [[self alloc] initWithThreadCount:[NSProcessInfo processInfo].activeProcessorCount];
+	});
+
+	return sharedEventLoop;
+}
+
+-(instancetype) init {
+	return [self initWithThreadCount:[NSProcessInfo processInfo].activeProcessorCount];
+}
+
+-(instancetype) initWithThreadCount:(NSUInteger)threadCount {
+	if (!(self = [super init]))
+		return nil;
+
+	_threadCount = MAX(threadCount, 1);
+
+	NSMutableArray <dispatch_queue_t> *queues = [NSMutableArray arrayWithCapacity:_threadCount];
+	for (NSUInteger i = 0; i < _threadCount; i++) {
+		dispatch_queue_t queue = dispatch_queue_create("IRCClientEventLoop", DISPATCH_QUEUE_SERIAL);
+		dispatch_queue_set_specific(queue, &IRCClientEventLoopQueueKey, (__bridge void *) queue, NULL);
+		[queues addObject:queue];
+	}
+	_queues = [queues copy];
+
+	atomic_init(&_nextQueueIndex, 0);
+
+	return self;
+}
+
+/****************************************/
+#pragma mark - Instance methods (private)
+/****************************************/
+
+-(dispatch_queue_t) nextQueue {
+	uint_fast64_t index = atomic_fetch_add_explicit(&_nextQueueIndex, 1, memory_order_relaxed);
+
+	return _queues[(NSUInteger) (index % _threadCount)];
+}
+
+@end
+
+/****************************/
+#pragma mark - Loop functions
+/****************************/
+
+dispatch_queue_t IRCClientEventLoopCurrentQueue(void) {
+	// (Specifics are looked up through the queue’s targets.)
+	return (__bridge dispatch_queue_t) dispatch_get_specific(&IRCClientEventLoopQueueKey);
+}
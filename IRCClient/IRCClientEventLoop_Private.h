@@ -0,0 +1,37 @@
+//
+//  IRCClientEventLoop_Private.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientEventLoop.h"
+
+/*	NOTE: This header is for the framework’s internal use only. Do not import
+ *	it in files that make use of the IRCClientEventLoop class.
+ */
+
+/**********************************************/
+#pragma mark IRCClientEventLoop class extension
+/**********************************************/
+
+@interface IRCClientEventLoop ()
+
+/**	Returns the loop (queue) that the next session should be pinned to. (The
+	loops are handed out in rotation.)
+ */
+-(dispatch_queue_t) nextQueue;
+
+@end
+
+/****************************/
+#pragma mark - Loop functions
+/****************************/
+
+/**	Returns the loop (queue) that the calling code is running on, directly or
+	through a queue that targets it (such as a session’s); or NULL if it
+	isn’t running on one.
+ */
+dispatch_queue_t IRCClientEventLoopCurrentQueue(void);
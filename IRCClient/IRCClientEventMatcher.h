@@ -0,0 +1,45 @@
+//
+//	IRCClientEventMatcher.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+#import "IRCClientEventFilter.h"
+#import "IRCClientMessage.h"
+
+/*	NOTE: This header is for the framework’s internal use only.
+ */
+
+/** @class IRCClientEventMatcher
+ *	@brief A session’s event filters, compiled for checking against received
+ *	messages.
+ *
+ *	Commands are compiled to bit sets, and names and masks are case-folded
+ *	up front, so that checking a message doesn’t allocate.
+ */
+
+/***************************************************/
+#pragma mark IRCClientEventMatcher class declaration
+/***************************************************/
+
+@interface IRCClientEventMatcher : NSObject
+
+/**	The filters that the matcher was compiled from.
+ */
+@property (readonly) NSArray <IRCClientEventFilter *> *filters;
+
+/**	Returns a matcher for the given filters, which folds names with the given
+	table (see IRCClientCaseFoldTableInit()), which is copied.
+ */
+-(instancetype) initWithFilters:(NSArray <IRCClientEventFilter *> *)filters
+					   caseFold:(const uint8_t *)caseFold;
+
+/**	Returns YES if the message passes any of the filters.
+ */
+-(BOOL) matchesMessage:(const IRCClientMessage *)message;
+
+@end
@@ -0,0 +1,277 @@
+//
+//	IRCClientEventMatcher.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientEventMatcher.h"
+#import "IRCClientCaseMapping.h"
+#import "IRCClientCommandTable.h"
+
+/******************************/
+#pragma mark - Type definitions
+/******************************/
+
+// One filter, compiled. (The objects are kept alive by the matcher.)
+typedef struct {
+	// If NO, the message’s command must be in the sets below.
+	BOOL anyCommand;
+	// Indexed by IRCClientCommand.
+	uint32_t commands;
+	// Indexed by numeric reply code (000–999).
+	uint8_t numerics[(1000 + 7) / 8];
+	// Commands that IRCClient doesn’t handle, in upper case.
+	__unsafe_unretained NSSet <NSData *> *otherCommands;
+
+	// Case-folded; nil to pass any target.
+	__unsafe_unretained NSSet <NSData *> *targets;
+	// Case-folded; nil to pass any sender.
+	__unsafe_unretained NSArray <NSData *> *origins;
+	// Nil to pass any text.
+	__unsafe_unretained NSData *text;
+} IRCClientEventMatcherRule;
+
+/******************************/
+#pragma mark - Helper functions
+/******************************/
+
+// Matches the bytes against a (case-folded) mask, with * and ? wildcards.
+static BOOL IRCClientMaskMatches(const uint8_t *mask,
+								 NSUInteger maskLength,
+								 const uint8_t *bytes,
+								 NSUInteger length,
+								 const uint8_t *caseFold) {
+	NSUInteger m = 0, b = 0;
+	NSUInteger starM = NSNotFound, starB = 0;
+	while (b < length) {
+		if (m < maskLength && mask[m] == '*') {
+			// Try matching nothing first; backtrack to here if need be.
+			starM = m++;
+			starB = b;
+		} else if (   m < maskLength
+				   && (   mask[m] == '?'
+					   || mask[m] == caseFold[bytes[b]])) {
+			m++;
+			b++;
+		} else if (starM != NSNotFound) {
+			m = starM + 1;
+			b = ++starB;
+		} else {
+			return NO;
+		}
+	}
+	while (m < maskLength && mask[m] == '*')
+		m++;
+
+	return (m == maskLength);
+}
+
+static NSData *IRCClientUppercaseData(NSData *data) {
+	NSMutableData *uppercase = [data mutableCopy];
+	uint8_t *bytes = uppercase.mutableBytes;
+	for (NSUInteger i = 0; i < uppercase.length; i++)
+		bytes[i] = (uint8_t) toupper(bytes[i]);
+
+	return uppercase;
+}
+
+/********************************************************/
+#pragma mark - IRCClientEventMatcher class implementation
+/********************************************************/
+
+@implementation IRCClientEventMatcher {
+	IRCClientEventMatcherRule *_rules;
+	NSUInteger _ruleCount;
+
+	// Keeps the rules’ objects alive.
+	NSMutableArray *_objects;
+
+	NSMutableData *_lookupKey;
+	uint8_t _caseFold[256];
+}
+
+-(instancetype) initWithFilters:(NSArray <IRCClientEventFilter *> *)filters
+					   caseFold:(const uint8_t *)caseFold {
+	if (!(self = [super init]))
+		return nil;
+
+	_filters = [[NSArray alloc] initWithArray:filters
+									copyItems:YES];
+	_objects = [NSMutableArray array];
+	_lookupKey = [NSMutableData dataWithCapacity:64];
+	memcpy(_caseFold, caseFold, sizeof(_caseFold));
+
+	_ruleCount = _filters.count;
+	_rules = calloc(MAX(_ruleCount, 1), sizeof(IRCClientEventMatcherRule));
+	for (NSUInteger i = 0; i < _ruleCount; i++)
+		[self compileFilter:_filters[i]
+					 toRule:&_rules[i]];
+
+	return self;
+}
+
+-(void) dealloc {
+	free(_rules);
+}
+
+-(void) compileFilter:(IRCClientEventFilter *)filter
+			   toRule:(IRCClientEventMatcherRule *)rule {
+	rule->anyCommand = (filter.commands == nil);
+	NSMutableSet <NSData *> *otherCommands = [NSMutableSet set];
+	for (NSData *command in filter.commands) {
+		NSData *uppercaseCommand = IRCClientUppercaseData(command);
+		const uint8_t *bytes = uppercaseCommand.bytes;
+		NSUInteger length = uppercaseCommand.length;
+
+		IRCClientCommand knownCommand = IRCClientCommandLookup(bytes, length);
+		if (   length == 3
+			&& isdigit(bytes[0])
+			&& isdigit(bytes[1])
+			&& isdigit(bytes[2])) {
+			NSUInteger code = (bytes[0] - '0') * 100 + (bytes[1] - '0') * 10 + (bytes[2] - '0');
+			rule->numerics[code / 8] |= (uint8_t) (1 << (code % 8));
+		} else if (knownCommand != IRCClientCommandUnknown) {
+			rule->commands |= (uint32_t) (1 << knownCommand);
+		} else {
+			[otherCommands addObject:uppercaseCommand];
+		}
+	}
+	if (otherCommands.count > 0) {
+		[_objects addObject:otherCommands];
+		rule->otherCommands = otherCommands;
+	}
+
+	if (filter.targets != nil) {
+		NSMutableSet <NSData *> *targets = [NSMutableSet setWithCapacity:filter.targets.count];
+		for (NSData *target in filter.targets) {
+			NSMutableData *key = [NSMutableData data];
+			IRCClientCaseFold(key, target.bytes, target.length, _caseFold);
+			[targets addObject:key];
+		}
+		[_objects addObject:targets];
+		rule->targets = targets;
+	}
+
+	if (filter.origins != nil) {
+		NSMutableArray <NSData *> *origins = [NSMutableArray arrayWithCapacity:filter.origins.count];
+		for (NSData *origin in filter.origins) {
+			NSMutableData *mask = [NSMutableData data];
+			IRCClientCaseFold(mask, origin.bytes, origin.length, _caseFold);
+			[origins addObject:mask];
+		}
+		[_objects addObject:origins];
+		rule->origins = origins;
+	}
+
+	if (filter.text != nil) {
+		NSData *text = [filter.text copy];
+		[_objects addObject:text];
+		rule->text = text;
+	}
+}
+
+-(BOOL) matchesMessage:(const IRCClientMessage *)message {
+	NSUInteger numericCode = 0;
+	BOOL numeric = IRCClientMessageNumericCode(message, &numericCode);
+	IRCClientCommand command = (numeric
+								? IRCClientCommandUnknown
+								: IRCClientCommandLookup(message->bytes + message->command.location,
+														 message->command.length));
+
+	for (NSUInteger i = 0; i < _ruleCount; i++) {
+		if ([self rule:&_rules[i]
+		 matchesMessage:message
+			   numeric:numeric
+		   numericCode:numericCode
+			   command:command])
+			return YES;
+	}
+
+	return NO;
+}
+
+-(BOOL) rule:(const IRCClientEventMatcherRule *)rule
+matchesMessage:(const IRCClientMessage *)message
+	 numeric:(BOOL)numeric
+ numericCode:(NSUInteger)numericCode
+	 command:(IRCClientCommand)command {
+	// Command.
+	if (rule->anyCommand == NO) {
+		if (numeric) {
+			if (!(rule->numerics[numericCode / 8] & (1 << (numericCode % 8))))
+				return NO;
+		} else if (command != IRCClientCommandUnknown) {
+			if (!(rule->commands & (1 << command)))
+				return NO;
+		} else {
+			if (rule->otherCommands == nil)
+				return NO;
+
+			const uint8_t *bytes = message->bytes + message->command.location;
+			NSUInteger length = message->command.length;
+			_lookupKey.length = length;
+			uint8_t *keyBytes = _lookupKey.mutableBytes;
+			for (NSUInteger i = 0; i < length; i++)
+				keyBytes[i] = (uint8_t) toupper(bytes[i]);
+			if (![rule->otherCommands containsObject:_lookupKey])
+				return NO;
+		}
+	}
+
+	// Target (any of a comma-separated list).
+	if (rule->targets != nil) {
+		NSRange targets = IRCClientMessageParamRange(message, 0);
+		if (targets.location == NSNotFound)
+			return NO;
+
+		BOOL found = NO;
+		const uint8_t *cursor = message->bytes + targets.location;
+		const uint8_t *end = cursor + targets.length;
+		while (found == NO && cursor < end) {
+			const uint8_t *comma = memchr(cursor, ',', (size_t) (end - cursor));
+			const uint8_t *targetEnd = (comma != NULL ? comma : end);
+
+			IRCClientCaseFold(_lookupKey, cursor, (NSUInteger) (targetEnd - cursor), _caseFold);
+			found = [rule->targets containsObject:_lookupKey];
+
+			cursor = targetEnd + 1;
+		}
+		if (found == NO)
+			return NO;
+	}
+
+	// Sender.
+	if (rule->origins != nil) {
+		if (message->prefix.location == NSNotFound)
+			return NO;
+
+		const uint8_t *prefix = message->bytes + message->prefix.location;
+		BOOL found = NO;
+		for (NSData *mask in rule->origins) {
+			if (IRCClientMaskMatches(mask.bytes, mask.length, prefix, message->prefix.length, _caseFold)) {
+				found = YES;
+				break;
+			}
+		}
+		if (found == NO)
+			return NO;
+	}
+
+	// Text (of the last parameter).
+	if (rule->text != nil) {
+		if (message->paramCount == 0)
+			return NO;
+
+		NSRange text = IRCClientMessageParamRange(message, message->paramCount - 1);
+		if (memmem(message->bytes + text.location, text.length,
+				   rule->text.bytes, rule->text.length) == NULL)
+			return NO;
+	}
+
+	return YES;
+}
+
+@end
@@ -0,0 +1,107 @@
+//
+//	IRCClientFormattedMessage.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+
+/**************************************/
+#pragma mark IRCClientColorCodeHandling
+/**************************************/
+
+/**	What is done with the mIRC format codes (colors, bold, etc.) in received
+	messages, notices, and actions, before they’re passed to a delegate.
+	(See -[IRCClientSession colorCodeHandling] and
+	-[IRCClientChannel colorCodeHandling].)
+ */
+typedef NS_ENUM(NSUInteger, IRCClientColorCodeHandling) {
+	/**	(For channels only.) Whatever the channel’s session does.
+	 */
+	IRCClientColorCodeHandlingDefault = 0,
+	/**	Messages are passed on exactly as received (with no extra work at all).
+	 */
+	IRCClientColorCodeHandlingIgnore,
+	/**	Format codes are removed.
+	 */
+	IRCClientColorCodeHandlingStrip,
+	/**	Format codes are removed, and messages that had any are passed on as
+		IRCClientFormattedMessage objects, which describe the formatting as a
+		list of spans.
+	 */
+	IRCClientColorCodeHandlingParse,
+	/**	Format codes are converted to libircclient markup (see
+		-[IRCClientSession colorConvertFromMIRC:]).
+	 */
+	IRCClientColorCodeHandlingConvert
+};
+
+/********************************************/
+#pragma mark - IRCClientFormattingSpan struct
+/********************************************/
+
+/**	Text formats (other than colors) that a span may have.
+ */
+typedef NS_OPTIONS(uint8_t, IRCClientTextFormat) {
+	IRCClientTextFormatBold				= 1 << 0,
+	IRCClientTextFormatItalic			= 1 << 1,
+	IRCClientTextFormatUnderline		= 1 << 2,
+	IRCClientTextFormatReverse			= 1 << 3,
+	IRCClientTextFormatMonospace		= 1 << 4,
+	IRCClientTextFormatStrikethrough	= 1 << 5
+};
+
+/**	The color of a span that has no foreground (or background) color.
+ */
+#define IRCClientNoColor 0xFF
+
+/** @struct IRCClientFormattingSpan
+ *	@brief A run of formatted text in an IRCClientFormattedMessage.
+ *
+ *	Runs of unformatted text have no span.
+ */
+typedef struct {
+	/**	The location and length (in bytes) of the run, in the text of the
+		message (i.e., with the format codes removed).
+	 */
+	uint32_t location;
+	uint32_t length;
+
+	IRCClientTextFormat formats;
+
+	/**	mIRC color numbers (0–99), or IRCClientNoColor.
+	 */
+	uint8_t foreground;
+	uint8_t background;
+} IRCClientFormattingSpan;
+
+/** @class IRCClientFormattedMessage
+ *	@brief The text of a received message (with the mIRC format codes
+ *	removed), along with a description of its formatting.
+ *
+ *	The object’s bytes are those of the text, so it may be used like any
+ *	other NSData.
+ */
+
+/*********************************************************/
+#pragma mark - IRCClientFormattedMessage class declaration
+/*********************************************************/
+
+@interface IRCClientFormattedMessage : NSData
+
+/**	The formatted runs of the text, in order.
+ */
+@property (readonly) const IRCClientFormattingSpan *spans;
+
+@property (readonly) NSUInteger spanCount;
+
+/**	Returns a formatted message with the given text; the spans are given as
+	the bytes of an array of IRCClientFormattingSpan structs.
+ */
+-(instancetype) initWithText:(NSData *)text
+					   spans:(NSData *)spans;
+
+@end
@@ -0,0 +1,60 @@
+//
+//	IRCClientFormattedMessage.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientFormattedMessage.h"
+
+/************************************************************/
+#pragma mark - IRCClientFormattedMessage class implementation
+/************************************************************/
+
+@implementation IRCClientFormattedMessage {
+	NSData *_text;
+	NSData *_spans;
+}
+
+/******************************/
+#pragma mark - Custom accessors
+/******************************/
+
+-(const IRCClientFormattingSpan *) spans {
+	return _spans.bytes;
+}
+
+-(NSUInteger) spanCount {
+	return _spans.length / sizeof(IRCClientFormattingSpan);
+}
+
+/**************************/
+#pragma mark - Initializers
+/**************************/
+
+-(instancetype) initWithText:(NSData *)text
+					   spans:(NSData *)spans {
+	if (!(self = [super init]))
+		return nil;
+
+	_text = [text copy];
+	_spans = [spans copy];
+
+	return self;
+}
+
+/**************************************/
+#pragma mark - NSData primitive methods
+/**************************************/
+
+-(const void *) bytes {
+	return _text.bytes;
+}
+
+-(NSUInteger) length {
+	return _text.length;
+}
+
+@end
@@ -0,0 +1,57 @@
+//
+//	IRCClientFormatting.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+#import "IRCClientFormattedMessage.h"
+
+/*	NOTE: This header is for the framework’s internal use only.
+ */
+
+/*	Formatting markup (as in libircclient) and the mIRC format codes that it
+	corresponds to:
+
+	[B]…[/B]						bold (^B, 0x02)
+	[I]…[/I]						italic (^], 0x1D)
+	[U]…[/U]						underline (^_, 0x1F)
+	[R]…[/R]						reverse (^V, 0x16)
+	[COLOR=fg]…[/COLOR]				color (^C, 0x03, followed by the color number)
+	[COLOR=fg/bg]…[/COLOR]			foreground and background color
+
+	Colors are given by name (WHITE, BLACK, DARKBLUE, DARKGREEN, RED, BROWN,
+	PURPLE, OLIVE, YELLOW, GREEN, TEAL, CYAN, BLUE, MAGENTA, DARKGRAY,
+	LIGHTGRAY, i.e. mIRC colors 0–15) or by number (0–99). A reset (^O, 0x0F)
+	closes all open markup.
+
+	Each function makes one pass over the message; a message with nothing to
+	convert (which is the common case) is found to be so by a vectorized scan,
+	and is returned as is.
+ */
+
+/*********************************/
+#pragma mark - Function prototypes
+/*********************************/
+
+/**	Converts formatting markup in the message to mIRC format codes.
+ */
+NSData *IRCClientFormattingConvertToMIRC(NSData *message);
+
+/**	Converts mIRC format codes in the message to formatting markup. (Format
+	codes that have no markup equivalent are removed.)
+ */
+NSData *IRCClientFormattingConvertFromMIRC(NSData *message);
+
+/**	Removes mIRC format codes (including color numbers) from the message.
+ */
+NSData *IRCClientFormattingStripMIRC(NSData *message);
+
+/**	Removes mIRC format codes from the message, and returns the result as an
+	IRCClientFormattedMessage that describes the formatting that they set. (A
+	message with no format codes is returned as is.)
+ */
+NSData *IRCClientFormattingParse(NSData *message);
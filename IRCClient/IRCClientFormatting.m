@@ -0,0 +1,534 @@
+//
+//	IRCClientFormatting.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientFormatting.h"
+
+/******************************/
+#pragma mark - Type definitions
+/******************************/
+
+typedef NS_ENUM(uint8_t, IRCClientFormat) {
+	IRCClientFormatNone = 0,
+	IRCClientFormatBold,
+	IRCClientFormatItalic,
+	IRCClientFormatUnderline,
+	IRCClientFormatReverse,
+	IRCClientFormatColor,
+	IRCClientFormatReset,
+	// (These two have no markup equivalent.)
+	IRCClientFormatMonospace,
+	IRCClientFormatStrikethrough
+};
+
+// Sixteen bytes, compared all at once.
+typedef uint8_t IRCClientByteVector __attribute__((vector_size(16)));
+
+/******************************/
+#pragma mark - Static variables
+/******************************/
+
+// What each control byte (0x00–0x1F) does; the rest aren’t format codes.
+static const IRCClientFormat IRCClientFormatCodes[0x20] = {
+	[0x02] = IRCClientFormatBold,
+	[0x03] = IRCClientFormatColor,
+	[0x0F] = IRCClientFormatReset,
+	[0x11] = IRCClientFormatMonospace,
+	[0x16] = IRCClientFormatReverse,
+	[0x1D] = IRCClientFormatItalic,
+	[0x1E] = IRCClientFormatStrikethrough,
+	[0x1F] = IRCClientFormatUnderline,
+};
+
+// Markup for the formats that are toggled on and off by their format code.
+static const struct {
+	const char *openingTag;
+	const char *closingTag;
+	uint8_t code;
+} IRCClientFormatToggles[] = {
+	[IRCClientFormatBold]		= { "[B]", "[/B]", 0x02 },
+	[IRCClientFormatItalic]		= { "[I]", "[/I]", 0x1D },
+	[IRCClientFormatUnderline]	= { "[U]", "[/U]", 0x1F },
+	[IRCClientFormatReverse]	= { "[R]", "[/R]", 0x16 },
+};
+
+// The text format that each format code sets (or clears).
+static const IRCClientTextFormat IRCClientTextFormats[] = {
+	[IRCClientFormatBold]			= IRCClientTextFormatBold,
+	[IRCClientFormatItalic]			= IRCClientTextFormatItalic,
+	[IRCClientFormatUnderline]		= IRCClientTextFormatUnderline,
+	[IRCClientFormatReverse]		= IRCClientTextFormatReverse,
+	[IRCClientFormatMonospace]		= IRCClientTextFormatMonospace,
+	[IRCClientFormatStrikethrough]	= IRCClientTextFormatStrikethrough,
+};
+
+static const char *IRCClientColorNames[16] = {
+	"WHITE", "BLACK", "DARKBLUE", "DARKGREEN",
+	"RED", "BROWN", "PURPLE", "OLIVE",
+	"YELLOW", "GREEN", "TEAL", "CYAN",
+	"BLUE", "MAGENTA", "DARKGRAY", "LIGHTGRAY"
+};
+
+// The length of the longest color name.
+static const NSUInteger IRCClientColorNameMaxLength = 9;
+
+static const char IRCClientColorOpeningTag[] = "[COLOR=";
+static const char IRCClientColorClosingTag[] = "[/COLOR]";
+
+/******************************/
+#pragma mark - Helper functions
+/******************************/
+
+// Returns the offset of the first byte that is less than below, or is equal
+// to equal; or length, if there is no such byte.
+static NSUInteger IRCClientFormattingScan(const uint8_t *bytes,
+										  NSUInteger length,
+										  uint8_t below,
+										  uint8_t equal) {
+	IRCClientByteVector zero = { 0 };
+	IRCClientByteVector belowVector = zero + below;
+	IRCClientByteVector equalVector = zero + equal;
+
+	NSUInteger i = 0;
+	for (; i + sizeof(IRCClientByteVector) <= length; i += sizeof(IRCClientByteVector)) {
+		IRCClientByteVector chunk;
+		memcpy(&chunk, bytes + i, sizeof(chunk));
+
+		IRCClientByteVector matches = (IRCClientByteVector) ((chunk < belowVector) | (chunk == equalVector));
+		uint64_t halves[2];
+		memcpy(halves, &matches, sizeof(halves));
+		if (halves[0] | halves[1])
+			break;
+	}
+
+	for (; i < length; i++)
+		if (bytes[i] < below || bytes[i] == equal)
+			return i;
+
+	return length;
+}
+
+static BOOL IRCClientHasCStringPrefix(const uint8_t *bytes,
+									  NSUInteger length,
+									  const char *prefix,
+									  NSUInteger prefixLength) {
+	return (   length >= prefixLength
+			&& memcmp(bytes, prefix, prefixLength) == 0);
+}
+
+static void IRCClientAppendCString(NSMutableData *output,
+								   const char *string) {
+	[output appendBytes:string
+				 length:strlen(string)];
+}
+
+static void IRCClientAppendByte(NSMutableData *output,
+								uint8_t byte) {
+	[output appendBytes:&byte
+				 length:1];
+}
+
+// Parses a one- or two-digit color number; returns the number of digits.
+static NSUInteger IRCClientParseColorNumber(const uint8_t *bytes,
+											NSUInteger length,
+											NSUInteger *color) {
+	NSUInteger digits = 0;
+	*color = 0;
+	while (   digits < 2
+		   && digits < length
+		   && bytes[digits] >= '0' && bytes[digits] <= '9') {
+		*color = (*color * 10) + (bytes[digits] - '0');
+		digits++;
+	}
+
+	return digits;
+}
+
+// Parses the colors that may follow ^C (“fg” or “fg,bg”); returns the number
+// of bytes parsed, or 0 if there is no foreground color. If there is no
+// background color, *background is set to NSNotFound.
+static NSUInteger IRCClientParseMIRCColors(const uint8_t *bytes,
+										   NSUInteger length,
+										   NSUInteger *foreground,
+										   NSUInteger *background) {
+	*background = NSNotFound;
+
+	NSUInteger position = IRCClientParseColorNumber(bytes, length, foreground);
+	if (position == 0)
+		return 0;
+
+	if (position < length && bytes[position] == ',') {
+		NSUInteger digits = IRCClientParseColorNumber(bytes + position + 1, length - position - 1, background);
+		if (digits > 0)
+			position += 1 + digits;
+		else
+			*background = NSNotFound;
+	}
+
+	return position;
+}
+
+// Parses a color in markup (a name or a number, ending at ‘/’ or ‘]’);
+// returns its length, or 0 if it isn’t a valid color.
+static NSUInteger IRCClientParseColorMarkup(const uint8_t *bytes,
+											NSUInteger length,
+											NSUInteger *color) {
+	NSUInteger colorLength = 0;
+	while (   colorLength < length
+		   && colorLength <= IRCClientColorNameMaxLength
+		   && bytes[colorLength] != '/'
+		   && bytes[colorLength] != ']')
+		colorLength++;
+	if (   colorLength == 0
+		|| colorLength == length
+		|| colorLength > IRCClientColorNameMaxLength)
+		return 0;
+
+	if (IRCClientParseColorNumber(bytes, colorLength, color) == colorLength)
+		return colorLength;
+
+	for (NSUInteger i = 0; i < 16; i++) {
+		if (   strlen(IRCClientColorNames[i]) == colorLength
+			&& strncasecmp(IRCClientColorNames[i], (const char *) bytes, colorLength) == 0) {
+			*color = i;
+			return colorLength;
+		}
+	}
+
+	return 0;
+}
+
+// Always two digits, so that a digit that follows can’t be taken as part of
+// the color number.
+static void IRCClientAppendColorNumber(NSMutableData *output,
+									   NSUInteger color) {
+	uint8_t digits[2] = { '0' + (color / 10), '0' + (color % 10) };
+	[output appendBytes:digits
+				 length:2];
+}
+
+static void IRCClientAppendColorName(NSMutableData *output,
+									 NSUInteger color) {
+	if (color < 16) {
+		IRCClientAppendCString(output, IRCClientColorNames[color]);
+	} else {
+		char number[4];
+		snprintf(number, sizeof(number), "%lu", (unsigned long) color);
+		IRCClientAppendCString(output, number);
+	}
+}
+
+// Appends the closing tags for all the open formats.
+static void IRCClientCloseFormats(NSMutableData *output,
+								  unsigned int *formats) {
+	if (*formats & (1 << IRCClientFormatColor))
+		IRCClientAppendCString(output, IRCClientColorClosingTag);
+	for (IRCClientFormat format = IRCClientFormatReverse; format >= IRCClientFormatBold; format--)
+		if (*formats & (1 << format))
+			IRCClientAppendCString(output, IRCClientFormatToggles[format].closingTag);
+
+	*formats = 0;
+}
+
+// Ends the span (if the text since its start is formatted at all).
+static void IRCClientEndSpan(NSMutableData *spans,
+							 IRCClientFormattingSpan *span,
+							 NSUInteger end) {
+	if (   end > span->location
+		&& (   span->formats != 0
+			|| span->foreground != IRCClientNoColor
+			|| span->background != IRCClientNoColor)) {
+		span->length = (uint32_t) (end - span->location);
+		[spans appendBytes:span
+					length:sizeof(IRCClientFormattingSpan)];
+	}
+}
+
+/**************************************/
+#pragma mark - Function implementations
+/**************************************/
+
+NSData *IRCClientFormattingConvertToMIRC(NSData *message) {
+	const uint8_t *bytes = message.bytes;
+	NSUInteger length = message.length;
+
+	NSUInteger position = IRCClientFormattingScan(bytes, length, 0, '[');
+	if (position == length)
+		return [message copy];
+
+	NSMutableData *output = [NSMutableData dataWithCapacity:length];
+	[output appendBytes:bytes
+				 length:position];
+	unsigned int formats = 0;
+	while (YES) {
+		NSUInteger next = position + IRCClientFormattingScan(bytes + position, length - position, 0, '[');
+		[output appendBytes:(bytes + position)
+					 length:(next - position)];
+		position = next;
+		if (position == length)
+			break;
+
+		const uint8_t *tag = bytes + position;
+		NSUInteger remaining = length - position;
+
+		// Bold, italic, underline, reverse.
+		BOOL matched = NO;
+		for (IRCClientFormat format = IRCClientFormatBold; format <= IRCClientFormatReverse && !matched; format++) {
+			const char *openingTag = IRCClientFormatToggles[format].openingTag;
+			const char *closingTag = IRCClientFormatToggles[format].closingTag;
+			if (IRCClientHasCStringPrefix(tag, remaining, openingTag, strlen(openingTag))) {
+				if (!(formats & (1 << format)))
+					IRCClientAppendByte(output, IRCClientFormatToggles[format].code);
+				formats |= (1 << format);
+				position += strlen(openingTag);
+				matched = YES;
+			} else if (IRCClientHasCStringPrefix(tag, remaining, closingTag, strlen(closingTag))) {
+				if (formats & (1 << format))
+					IRCClientAppendByte(output, IRCClientFormatToggles[format].code);
+				formats &= ~(1 << format);
+				position += strlen(closingTag);
+				matched = YES;
+			}
+		}
+		if (matched)
+			continue;
+
+		// Colors.
+		if (IRCClientHasCStringPrefix(tag, remaining, IRCClientColorClosingTag, sizeof(IRCClientColorClosingTag) - 1)) {
+			position += sizeof(IRCClientColorClosingTag) - 1;
+			if (formats & (1 << IRCClientFormatColor)) {
+				IRCClientAppendByte(output, 0x03);
+				// A bare ^C followed by a digit would be taken as a color;
+				// a pair of (cancelling) bolds keeps them apart.
+				if (position < length && bytes[position] >= '0' && bytes[position] <= '9')
+					IRCClientAppendCString(output, "\x02\x02");
+			}
+			formats &= ~(1 << IRCClientFormatColor);
+			continue;
+		}
+		if (IRCClientHasCStringPrefix(tag, remaining, IRCClientColorOpeningTag, sizeof(IRCClientColorOpeningTag) - 1)) {
+			NSUInteger tagLength = sizeof(IRCClientColorOpeningTag) - 1;
+			NSUInteger foreground, background = NSNotFound;
+			NSUInteger colorLength = IRCClientParseColorMarkup(tag + tagLength, remaining - tagLength, &foreground);
+			if (colorLength > 0) {
+				tagLength += colorLength;
+				if (tag[tagLength] == '/') {
+					colorLength = IRCClientParseColorMarkup(tag + tagLength + 1, remaining - tagLength - 1, &background);
+					tagLength = (colorLength > 0) ? (tagLength + 1 + colorLength) : 0;
+				}
+			}
+			if (colorLength > 0 && tag[tagLength] == ']') {
+				tagLength++;
+				position += tagLength;
+
+				IRCClientAppendByte(output, 0x03);
+				IRCClientAppendColorNumber(output, foreground);
+				if (background != NSNotFound) {
+					IRCClientAppendByte(output, ',');
+					IRCClientAppendColorNumber(output, background);
+				} else if (position < length && bytes[position] == ',') {
+					// (As above; otherwise, a comma and a digit that follow
+					// would be taken as a background color.)
+					IRCClientAppendCString(output, "\x02\x02");
+				}
+				formats |= (1 << IRCClientFormatColor);
+				continue;
+			}
+		}
+
+		// Not markup.
+		IRCClientAppendByte(output, '[');
+		position++;
+	}
+
+	return output;
+}
+
+NSData *IRCClientFormattingConvertFromMIRC(NSData *message) {
+	const uint8_t *bytes = message.bytes;
+	NSUInteger length = message.length;
+
+	NSUInteger position = IRCClientFormattingScan(bytes, length, 0x20, 0x00);
+	if (position == length)
+		return [message copy];
+
+	NSMutableData *output = [NSMutableData dataWithCapacity:(length + 16)];
+	[output appendBytes:bytes
+				 length:position];
+	unsigned int formats = 0;
+	while (YES) {
+		NSUInteger next = position + IRCClientFormattingScan(bytes + position, length - position, 0x20, 0x00);
+		[output appendBytes:(bytes + position)
+					 length:(next - position)];
+		position = next;
+		if (position == length)
+			break;
+
+		uint8_t byte = bytes[position++];
+		IRCClientFormat format = IRCClientFormatCodes[byte];
+		switch (format) {
+			case IRCClientFormatNone: {
+				IRCClientAppendByte(output, byte);
+				break;
+			}
+			case IRCClientFormatBold:
+			case IRCClientFormatItalic:
+			case IRCClientFormatUnderline:
+			case IRCClientFormatReverse: {
+				IRCClientAppendCString(output, ((formats & (1 << format))
+												? IRCClientFormatToggles[format].closingTag
+												: IRCClientFormatToggles[format].openingTag));
+				formats ^= (1 << format);
+				break;
+			}
+			case IRCClientFormatColor: {
+				NSUInteger foreground, background;
+				NSUInteger colorsLength = IRCClientParseMIRCColors(bytes + position, length - position, &foreground, &background);
+				position += colorsLength;
+
+				// A new color replaces the old one; a bare ^C just ends it.
+				if (formats & (1 << IRCClientFormatColor))
+					IRCClientAppendCString(output, IRCClientColorClosingTag);
+				formats &= ~(1 << IRCClientFormatColor);
+
+				if (colorsLength > 0) {
+					IRCClientAppendCString(output, IRCClientColorOpeningTag);
+					IRCClientAppendColorName(output, foreground);
+					if (background != NSNotFound) {
+						IRCClientAppendByte(output, '/');
+						IRCClientAppendColorName(output, background);
+					}
+					IRCClientAppendByte(output, ']');
+					formats |= (1 << IRCClientFormatColor);
+				}
+				break;
+			}
+			case IRCClientFormatReset: {
+				IRCClientCloseFormats(output, &formats);
+				break;
+			}
+			case IRCClientFormatMonospace:
+			case IRCClientFormatStrikethrough: {
+				break;
+			}
+		}
+	}
+
+	// Formatting ends with the message.
+	IRCClientCloseFormats(output, &formats);
+
+	return output;
+}
+
+NSData *IRCClientFormattingStripMIRC(NSData *message) {
+	const uint8_t *bytes = message.bytes;
+	NSUInteger length = message.length;
+
+	NSUInteger position = IRCClientFormattingScan(bytes, length, 0x20, 0x00);
+	if (position == length)
+		return [message copy];
+
+	NSMutableData *output = [NSMutableData dataWithCapacity:length];
+	[output appendBytes:bytes
+				 length:position];
+	while (YES) {
+		NSUInteger next = position + IRCClientFormattingScan(bytes + position, length - position, 0x20, 0x00);
+		[output appendBytes:(bytes + position)
+					 length:(next - position)];
+		position = next;
+		if (position == length)
+			break;
+
+		uint8_t byte = bytes[position++];
+		switch (IRCClientFormatCodes[byte]) {
+			case IRCClientFormatNone: {
+				IRCClientAppendByte(output, byte);
+				break;
+			}
+			case IRCClientFormatColor: {
+				NSUInteger foreground, background;
+				position += IRCClientParseMIRCColors(bytes + position, length - position, &foreground, &background);
+				break;
+			}
+			default: {
+				break;
+			}
+		}
+	}
+
+	return output;
+}
+
+NSData *IRCClientFormattingParse(NSData *message) {
+	const uint8_t *bytes = message.bytes;
+	NSUInteger length = message.length;
+
+	NSUInteger position = IRCClientFormattingScan(bytes, length, 0x20, 0x00);
+	if (position == length)
+		return [message copy];
+
+	NSMutableData *text = [NSMutableData dataWithCapacity:length];
+	[text appendBytes:bytes
+			   length:position];
+	NSMutableData *spans = [NSMutableData data];
+
+	// The formatting of the text from span.location onward.
+	IRCClientFormattingSpan span = { (uint32_t) position, 0, 0, IRCClientNoColor, IRCClientNoColor };
+	while (YES) {
+		NSUInteger next = position + IRCClientFormattingScan(bytes + position, length - position, 0x20, 0x00);
+		[text appendBytes:(bytes + position)
+				   length:(next - position)];
+		position = next;
+		if (position == length)
+			break;
+
+		uint8_t byte = bytes[position++];
+		IRCClientFormat format = IRCClientFormatCodes[byte];
+		if (format == IRCClientFormatNone) {
+			[text appendBytes:&byte
+					   length:1];
+			continue;
+		}
+
+		IRCClientEndSpan(spans, &span, text.length);
+		span.location = (uint32_t) text.length;
+
+		switch (format) {
+			case IRCClientFormatColor: {
+				// ^C fg keeps the background color; a bare ^C ends both.
+				NSUInteger foreground, background;
+				NSUInteger colorsLength = IRCClientParseMIRCColors(bytes + position, length - position, &foreground, &background);
+				position += colorsLength;
+				if (colorsLength == 0) {
+					span.foreground = IRCClientNoColor;
+					span.background = IRCClientNoColor;
+				} else {
+					span.foreground = (uint8_t) foreground;
+					if (background != NSNotFound)
+						span.background = (uint8_t) background;
+				}
+				break;
+			}
+			case IRCClientFormatReset: {
+				span.formats = 0;
+				span.foreground = IRCClientNoColor;
+				span.background = IRCClientNoColor;
+				break;
+			}
+			default: {
+				span.formats ^= IRCClientTextFormats[format];
+				break;
+			}
+		}
+	}
+
+	IRCClientEndSpan(spans, &span, text.length);
+
+	return [[IRCClientFormattedMessage alloc] initWithText:text
+													 spans:spans];
+}
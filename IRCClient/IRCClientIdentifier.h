@@ -0,0 +1,69 @@
+//
+//	IRCClientIdentifier.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+
+/*	NOTE: This header is for the framework’s internal use only.
+ */
+
+/** @class IRCClientIdentifier
+ *	@brief A nickname or channel name, interned by an IRCClientIdentifierPool.
+ *
+ *	A pool has exactly one identifier for each name (as the server compares
+ *	names, i.e. case-insensitively), so identifiers from the same pool are
+ *	equal only if they are the same object. The hash is computed once, so
+ *	identifiers make cheap dictionary keys.
+ */
+
+/*************************************************/
+#pragma mark IRCClientIdentifier class declaration
+/*************************************************/
+
+@interface IRCClientIdentifier : NSObject <NSCopying>
+
+/**	The name, as first interned (or as changed to by a nick change that
+	changed only its case).
+ */
+@property (strong) NSData *name;
+
+/**	The case-folded name.
+ */
+@property (readonly) NSData *key;
+
+@end
+
+/*******************************************************/
+#pragma mark - IRCClientIdentifierPool class declaration
+/*******************************************************/
+
+/** @class IRCClientIdentifierPool
+ *	@brief The identifiers of one session.
+ *
+ *	The pool holds its identifiers weakly; an identifier lasts as long as
+ *	something (a channel, a channel member) refers to it.
+ */
+@interface IRCClientIdentifierPool : NSObject
+
+/**	Returns a pool that folds names with the given table (see
+	IRCClientCaseFoldTableInit()), which is copied.
+ */
+-(instancetype) initWithCaseFold:(const uint8_t *)caseFold;
+
+/**	Returns the identifier for the given name, creating it if need be.
+ */
+-(IRCClientIdentifier *) identifierForBytes:(const uint8_t *)bytes
+									 length:(NSUInteger)length;
+
+/**	Returns the identifier for the given name, or nil if there is none (in
+	which case nothing refers to the name). Does not allocate.
+ */
+-(IRCClientIdentifier *) existingIdentifierForBytes:(const uint8_t *)bytes
+											 length:(NSUInteger)length;
+
+@end
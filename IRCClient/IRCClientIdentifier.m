@@ -0,0 +1,112 @@
+//
+//	IRCClientIdentifier.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientIdentifier.h"
+#import "IRCClientCaseMapping.h"
+
+/******************************/
+#pragma mark - Helper functions
+/******************************/
+
+// FNV-1a.
+static NSUInteger IRCClientIdentifierHash(NSData *key) {
+	const uint8_t *bytes = key.bytes;
+	NSUInteger length = key.length;
+
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (NSUInteger i = 0; i < length; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return (NSUInteger) hash;
+}
+
+/******************************************************/
+#pragma mark - IRCClientIdentifier class implementation
+/******************************************************/
+
+@implementation IRCClientIdentifier {
+	NSUInteger _hash;
+}
+
+-(instancetype) initWithName:(NSData *)name
+						 key:(NSData *)key {
+	if (!(self = [super init]))
+		return nil;
+
+	// Most names are already in lower case, so they can share their bytes
+	// with the key.
+	_name = [name isEqualToData:key] ? key : name;
+	_key = key;
+	_hash = IRCClientIdentifierHash(key);
+
+	return self;
+}
+
+-(NSUInteger) hash {
+	return _hash;
+}
+
+-(BOOL) isEqual:(id)object {
+	return (object == self);
+}
+
+-(id) copyWithZone:(NSZone *)zone {
+	return self;
+}
+
+@end
+
+/**********************************************************/
+#pragma mark - IRCClientIdentifierPool class implementation
+/**********************************************************/
+
+@implementation IRCClientIdentifierPool {
+	NSMapTable <NSData *, IRCClientIdentifier *> *_identifiers;
+	NSMutableData *_lookupKey;
+	uint8_t _caseFold[256];
+}
+
+-(instancetype) initWithCaseFold:(const uint8_t *)caseFold {
+	if (!(self = [super init]))
+		return nil;
+
+	_identifiers = [NSMapTable strongToWeakObjectsMapTable];
+	_lookupKey = [NSMutableData dataWithCapacity:64];
+	memcpy(_caseFold, caseFold, sizeof(_caseFold));
+
+	return self;
+}
+
+-(IRCClientIdentifier *) identifierForBytes:(const uint8_t *)bytes
+									 length:(NSUInteger)length {
+	IRCClientIdentifier *identifier = [self existingIdentifierForBytes:bytes
+																length:length];
+	if (identifier == nil) {
+		NSData *key = [_lookupKey copy];
+		identifier = [[IRCClientIdentifier alloc] initWithName:[NSData dataWithBytes:bytes
+																			   length:length]
+														   key:key];
+		[_identifiers setObject:identifier
+						 forKey:key];
+	}
+
+	return identifier;
+}
+
+-(IRCClientIdentifier *) existingIdentifierForBytes:(const uint8_t *)bytes
+											 length:(NSUInteger)length {
+	// Reuse the lookup key’s storage, so that a lookup doesn’t allocate.
+	IRCClientCaseFold(_lookupKey, bytes, length, _caseFold);
+
+	return [_identifiers objectForKey:_lookupKey];
+}
+
+@end
@@ -0,0 +1,140 @@
+//
+//	IRCClientLog.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+
+/*****************************/
+#pragma mark IRCClientLogLevel
+/*****************************/
+
+/**	How much a session logs (see -[IRCClientSession logLevel]). Each level
+	includes the ones before it.
+ */
+typedef NS_ENUM(uint8_t, IRCClientLogLevel) {
+	IRCClientLogLevelNone = 0,
+	IRCClientLogLevelError,
+	IRCClientLogLevelWarning,
+	IRCClientLogLevelInfo,
+	IRCClientLogLevelDebug,
+	/**	Everything, including every line sent to and received from the
+		server.
+	 */
+	IRCClientLogLevelTrace
+};
+
+/**	The highest log level that is compiled in; logging calls above it are
+	compiled out entirely. Define it (e.g. as IRCClientLogLevelWarning) when
+	building the framework to change it.
+ */
+#ifndef IRCClientLogLevelMax
+#define IRCClientLogLevelMax IRCClientLogLevelTrace
+#endif
+
+/************************************/
+#pragma mark - IRCClientLogRecordType
+/************************************/
+
+typedef NS_ENUM(uint8_t, IRCClientLogRecordType) {
+	/**	A message (text) about what the session is doing.
+	 */
+	IRCClientLogRecordMessage = 0,
+	/**	A line received from the server (without its CRLF).
+	 */
+	IRCClientLogRecordReceived,
+	/**	A line queued to be sent to the server (without its CRLF).
+	 */
+	IRCClientLogRecordSent
+};
+
+/***************************************/
+#pragma mark - IRCClientLogRecord struct
+/***************************************/
+
+/**	The longest record; longer ones are truncated.
+ */
+#define IRCClientLogRecordMaxLength 512
+
+/** @struct IRCClientLogRecord
+ *	@brief One entry in a session’s log.
+ */
+typedef struct {
+	/**	When the record was logged (nanoseconds since 1970).
+	 */
+	uint64_t timestamp;
+
+	IRCClientLogLevel level;
+
+	IRCClientLogRecordType type;
+
+	/**	YES if the record was longer than IRCClientLogRecordMaxLength bytes
+		(and has been cut short).
+	 */
+	BOOL truncated;
+
+	/**	The text (not NUL-terminated) or line. Only valid for the duration of
+		the sink call.
+	 */
+	const uint8_t *bytes;
+	NSUInteger length;
+} IRCClientLogRecord;
+
+/***************************************/
+#pragma mark - IRCClientLogSink protocol
+/***************************************/
+
+/** @protocol IRCClientLogSink
+ *	@brief Receives a session’s log records (see -[IRCClientSession logSink]).
+ *
+ *	Records are handed to the sink in batches, on a background queue (one
+ *	batch at a time), well after they were logged.
+ */
+@protocol IRCClientLogSink <NSObject>
+
+-(void) writeLogRecords:(const IRCClientLogRecord *)records
+				  count:(NSUInteger)count;
+
+@end
+
+/*************************************************/
+#pragma mark - IRCClientLogConsoleSink declaration
+/*************************************************/
+
+/** @class IRCClientLogConsoleSink
+ *	@brief Writes log records to the console (with NSLog()). This is a
+ *	session’s default sink.
+ */
+@interface IRCClientLogConsoleSink : NSObject <IRCClientLogSink>
+
+@end
+
+/**********************************************/
+#pragma mark - IRCClientLogFileSink declaration
+/**********************************************/
+
+/** @class IRCClientLogFileSink
+ *	@brief Writes log records to a file.
+ *
+ *	By default, only the lines sent to and received from the server are
+ *	written (each followed by a CRLF, i.e. as they were on the wire); the
+ *	session’s logLevel must be IRCClientLogLevelTrace for there to be any.
+ */
+@interface IRCClientLogFileSink : NSObject <IRCClientLogSink>
+
+/**	If YES, each line is preceded by a timestamp and a direction marker
+	(">>" for sent, "<<" for received), and messages are written too. The
+	default is NO.
+ */
+@property (assign) BOOL annotated;
+
+/**	Opens (creating, or appending to) the file at the given path; returns nil
+	if it can’t be opened.
+ */
+-(instancetype) initWithPath:(NSString *)path;
+
+@end
@@ -0,0 +1,119 @@
+//
+//	IRCClientLog.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientLog.h"
+
+#import <fcntl.h>
+#import <unistd.h>
+#import <sys/uio.h>
+
+/******************************/
+#pragma mark - Static variables
+/******************************/
+
+static const char *IRCClientLogLevelNames[] = {
+	[IRCClientLogLevelNone]		= "",
+	[IRCClientLogLevelError]	= "ERROR",
+	[IRCClientLogLevelWarning]	= "WARNING",
+	[IRCClientLogLevelInfo]		= "INFO",
+	[IRCClientLogLevelDebug]	= "DEBUG",
+	[IRCClientLogLevelTrace]	= "TRACE"
+};
+
+static const char *IRCClientLogRecordMarkers[] = {
+	[IRCClientLogRecordMessage]		= "--",
+	[IRCClientLogRecordReceived]	= "<<",
+	[IRCClientLogRecordSent]		= ">>"
+};
+
+/**********************************************************/
+#pragma mark - IRCClientLogConsoleSink class implementation
+/**********************************************************/
+
+@implementation IRCClientLogConsoleSink
+
+-(void) writeLogRecords:(const IRCClientLogRecord *)records
+				  count:(NSUInteger)count {
+	for (NSUInteger i = 0; i < count; i++) {
+		const IRCClientLogRecord *record = &records[i];
+		NSLog(@"%s %s %.*s%s",
+			  IRCClientLogLevelNames[record->level],
+			  IRCClientLogRecordMarkers[record->type],
+			  (int) record->length, record->bytes,
+			  (record->truncated ? "…" : ""));
+	}
+}
+
+@end
+
+/*******************************************************/
+#pragma mark - IRCClientLogFileSink class implementation
+/*******************************************************/
+
+@implementation IRCClientLogFileSink {
+	int _fd;
+}
+
+-(instancetype) initWithPath:(NSString *)path {
+	if (!(self = [super init]))
+		return nil;
+
+	_fd = open(path.fileSystemRepresentation, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	if (_fd < 0)
+		return nil;
+
+	return self;
+}
+
+-(void) dealloc {
+	if (_fd >= 0)
+		close(_fd);
+}
+
+-(void) writeLogRecords:(const IRCClientLogRecord *)records
+				  count:(NSUInteger)count {
+	BOOL annotated = _annotated;
+
+	// Gather the batch into as few writes as possible (three vectors per
+	// record: annotation, bytes, line end).
+	enum { MaxRecordsPerWrite = 64 };
+	struct iovec vectors[MaxRecordsPerWrite * 3];
+	char annotations[MaxRecordsPerWrite][48];
+
+	NSUInteger i = 0;
+	while (i < count) {
+		int vectorCount = 0;
+		for (NSUInteger n = 0; n < MaxRecordsPerWrite && i < count; i++) {
+			const IRCClientLogRecord *record = &records[i];
+			if (   annotated == NO
+				&& record->type == IRCClientLogRecordMessage)
+				continue;
+
+			if (annotated) {
+				int length = snprintf(annotations[n], sizeof(annotations[n]),
+									  "%llu.%09llu %s ",
+									  (unsigned long long) (record->timestamp / NSEC_PER_SEC),
+									  (unsigned long long) (record->timestamp % NSEC_PER_SEC),
+									  (record->type == IRCClientLogRecordMessage
+									   ? IRCClientLogLevelNames[record->level]
+									   : IRCClientLogRecordMarkers[record->type]));
+				vectors[vectorCount++] = (struct iovec) { annotations[n], (size_t) length };
+			}
+			vectors[vectorCount++] = (struct iovec) { (void *) record->bytes, record->length };
+			vectors[vectorCount++] = (struct iovec) { "\r\n", 2 };
+			n++;
+		}
+
+		if (   vectorCount > 0
+			&& writev(_fd, vectors, vectorCount) < 0)
+			return;
+	}
+}
+
+@end
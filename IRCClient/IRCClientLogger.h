@@ -0,0 +1,98 @@
+//
+//	IRCClientLogger.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+#import "IRCClientLog.h"
+
+/*	NOTE: This header is for the framework’s internal use only.
+ */
+
+/**************************/
+#pragma mark Logging macros
+/**************************/
+
+/**	YES if records of the given level are to be logged, given the current
+	level. Compiles to nothing for levels above IRCClientLogLevelMax.
+ */
+#define IRCClientLogLevelEnabled(level, currentLevel) \
+	((level) <= IRCClientLogLevelMax && (level) <= (currentLevel))
+
+/**	Logs a printf-style message (if the level is enabled; otherwise, the
+	arguments are not evaluated).
+ */
+#define IRCClientLog(logger, currentLevel, level, ...) \
+	do { \
+		if (IRCClientLogLevelEnabled((level), (currentLevel))) \
+			IRCClientLoggerLogMessage((logger), (level), __VA_ARGS__); \
+	} while (0)
+
+/**	Logs a line sent to or received from the server (at the trace level).
+ */
+#define IRCClientLogLine(logger, currentLevel, type, bytes, length) \
+	do { \
+		if (IRCClientLogLevelEnabled(IRCClientLogLevelTrace, (currentLevel))) \
+			IRCClientLoggerLogBytes((logger), IRCClientLogLevelTrace, (type), (bytes), (length)); \
+	} while (0)
+
+/***********************************************/
+#pragma mark - IRCClientLogger class declaration
+/***********************************************/
+
+/** @class IRCClientLogger
+ *	@brief A session’s log: a fixed-size ring of records, which any thread
+ *	may add to without locking, drained on a background queue (shared by all
+ *	loggers) into the sink.
+ *
+ *	The ring is only allocated when the first record is logged. If it’s full
+ *	(i.e., the sink has fallen behind), records are dropped (and counted).
+ */
+@interface IRCClientLogger : NSObject
+
+/**	Where records are drained to (nil to discard them).
+ */
+@property (strong) id <IRCClientLogSink> sink;
+
+/**	The number of records dropped because the ring was full.
+ */
+@property (readonly) NSUInteger recordsDropped;
+
+/**	How many records the ring has room for (rounded up to a power of two).
+	Changing this has no effect once the ring has been allocated.
+ */
+@property (assign) NSUInteger capacity;
+
+/**	Returns a logger with room for the given number of records.
+ */
+-(instancetype) initWithCapacity:(NSUInteger)capacity;
+
+/**	Stops draining, after draining what’s left into the sink (on the drain
+	queue). Must be called before the logger is released.
+ */
+-(void) close;
+
+@end
+
+/*******************************/
+#pragma mark - Logging functions
+/*******************************/
+
+/**	Adds a message (formatted with vsnprintf(), into the ring) to the log.
+ */
+void IRCClientLoggerLogMessage(IRCClientLogger *logger,
+							   IRCClientLogLevel level,
+							   const char *format,
+							   ...) __printflike(3, 4);
+
+/**	Adds the given bytes (copied into the ring) to the log.
+ */
+void IRCClientLoggerLogBytes(IRCClientLogger *logger,
+							 IRCClientLogLevel level,
+							 IRCClientLogRecordType type,
+							 const uint8_t *bytes,
+							 NSUInteger length);
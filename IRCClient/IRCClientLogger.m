@@ -0,0 +1,288 @@
+//
+//	IRCClientLogger.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientLogger.h"
+
+#import <os/lock.h>
+#import <stdatomic.h>
+
+/******************************/
+#pragma mark - Type definitions
+/******************************/
+
+// One slot in the ring. A slot’s sequence number says whose turn it is:
+// when it equals the slot’s position, a producer may fill it in; when it
+// equals the position + 1, the consumer may read it. (This is Dmitry
+// Vyukov’s bounded queue.)
+typedef struct {
+	_Atomic(NSUInteger) sequence;
+
+	uint64_t timestamp;
+	IRCClientLogLevel level;
+	IRCClientLogRecordType type;
+	BOOL truncated;
+	uint16_t length;
+	uint8_t bytes[IRCClientLogRecordMaxLength];
+} IRCClientLogSlot;
+
+/******************************/
+#pragma mark - Static variables
+/******************************/
+
+// The most records handed to the sink at once.
+static const NSUInteger IRCClientLoggerDrainBatchSize = 64;
+
+/******************************/
+#pragma mark - Helper functions
+/******************************/
+
+// Every logger drains on the same (low-priority) queue.
+static dispatch_queue_t IRCClientLoggerDrainQueue(void) {
+	static dispatch_queue_t drainQueue;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		drainQueue = dispatch_queue_create_with_target("IRCClientLog",
+													   DISPATCH_QUEUE_SERIAL,
+													   dispatch_get_global_queue(QOS_CLASS_UTILITY, 0));
+	});
+
+	return drainQueue;
+}
+
+/**************************************************/
+#pragma mark - IRCClientLogger class implementation
+/**************************************************/
+
+@implementation IRCClientLogger {
+	// NULL until the first record is logged; see IRCClientLoggerSlots().
+	_Atomic(IRCClientLogSlot *) _slots;
+	NSUInteger _mask;
+	os_unfair_lock _allocationLock;
+	BOOL _closed;
+
+	_Atomic(NSUInteger) _enqueuePosition;
+	// Only touched on the drain queue.
+	NSUInteger _dequeuePosition;
+
+	_Atomic(NSUInteger) _recordsDropped;
+
+	dispatch_source_t _drainSource;
+}
+
+/**************************/
+#pragma mark - Initializers
+/**************************/
+
+-(instancetype) initWithCapacity:(NSUInteger)capacity {
+	if (!(self = [super init]))
+		return nil;
+
+	_capacity = capacity;
+	_allocationLock = OS_UNFAIR_LOCK_INIT;
+
+	atomic_init(&_slots, NULL);
+	atomic_init(&_enqueuePosition, 0);
+	atomic_init(&_recordsDropped, 0);
+
+	return self;
+}
+
+-(void) dealloc {
+	free(atomic_load_explicit(&_slots, memory_order_relaxed));
+}
+
+/******************************/
+#pragma mark - Custom accessors
+/******************************/
+
+-(NSUInteger) recordsDropped {
+	return atomic_load_explicit(&_recordsDropped, memory_order_relaxed);
+}
+
+/****************************/
+#pragma mark - Public methods
+/****************************/
+
+-(void) close {
+	os_unfair_lock_lock(&_allocationLock);
+	_closed = YES;
+	if (_drainSource != nil)
+		dispatch_source_cancel(_drainSource);
+	os_unfair_lock_unlock(&_allocationLock);
+}
+
+/*****************************/
+#pragma mark - Private methods
+/*****************************/
+
+-(void) drain {
+	id <IRCClientLogSink> sink = self.sink;
+	IRCClientLogSlot *slots = atomic_load_explicit(&_slots, memory_order_acquire);
+
+	IRCClientLogRecord records[IRCClientLoggerDrainBatchSize];
+	for (;;) {
+		NSUInteger count = 0;
+		while (count < IRCClientLoggerDrainBatchSize) {
+			IRCClientLogSlot *slot = &slots[(_dequeuePosition + count) & _mask];
+			if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != _dequeuePosition + count + 1)
+				break;
+
+			records[count++] = (IRCClientLogRecord) {
+				.timestamp = slot->timestamp,
+				.level = slot->level,
+				.type = slot->type,
+				.truncated = slot->truncated,
+				.bytes = slot->bytes,
+				.length = slot->length
+			};
+		}
+		if (count == 0)
+			return;
+
+		[sink writeLogRecords:records
+						count:count];
+
+		// Hand the slots back to the producers.
+		for (NSUInteger i = 0; i < count; i++) {
+			IRCClientLogSlot *slot = &slots[_dequeuePosition & _mask];
+			atomic_store_explicit(&slot->sequence, _dequeuePosition + _mask + 1, memory_order_release);
+			_dequeuePosition++;
+		}
+	}
+}
+
+/****************************************/
+#pragma mark - Logging function internals
+/****************************************/
+
+// Returns the ring, allocating it (and the source that drains it) if this is
+// the first record; returns NULL if the logger has been closed. (Most
+// sessions log little, so most never need a full ring.)
+static IRCClientLogSlot *IRCClientLoggerSlots(IRCClientLogger *logger) {
+	IRCClientLogSlot *slots = atomic_load_explicit(&logger->_slots, memory_order_acquire);
+	if (slots != NULL)
+		return slots;
+
+	os_unfair_lock_lock(&logger->_allocationLock);
+	slots = atomic_load_explicit(&logger->_slots, memory_order_relaxed);
+	if (   slots == NULL
+		&& logger->_closed == NO) {
+		NSUInteger slotCount = 2;
+		while (slotCount < logger.capacity)
+			slotCount <<= 1;
+		logger->_mask = slotCount - 1;
+
+		slots = calloc(slotCount, sizeof(IRCClientLogSlot));
+		for (NSUInteger i = 0; i < slotCount; i++)
+			atomic_init(&slots[i].sequence, i);
+
+		// Producers just poke the source (which coalesces the pokes, and
+		// doesn’t allocate); the records are drained on the drain queue.
+		logger->_drainSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_DATA_OR, 0, 0, IRCClientLoggerDrainQueue());
+		// (The handlers, which keep the logger alive, are released when the
+		// source is cancelled; see -[close].)
+		dispatch_source_set_event_handler(logger->_drainSource, ^{
+			[logger drain];
+		});
+		dispatch_source_set_cancel_handler(logger->_drainSource, ^{
+			[logger drain];
+		});
+		dispatch_resume(logger->_drainSource);
+
+		atomic_store_explicit(&logger->_slots, slots, memory_order_release);
+	}
+	os_unfair_lock_unlock(&logger->_allocationLock);
+
+	return slots;
+}
+
+// Claims a slot for a producer to fill in; returns NULL if the ring is full.
+static IRCClientLogSlot *IRCClientLoggerClaimSlot(IRCClientLogger *logger,
+												  NSUInteger *position) {
+	IRCClientLogSlot *slots = IRCClientLoggerSlots(logger);
+	if (slots == NULL)
+		return NULL;
+
+	NSUInteger claimed = atomic_load_explicit(&logger->_enqueuePosition, memory_order_relaxed);
+	for (;;) {
+		IRCClientLogSlot *slot = &slots[claimed & logger->_mask];
+		NSUInteger sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+		NSInteger difference = (NSInteger) sequence - (NSInteger) claimed;
+		if (difference == 0) {
+			if (atomic_compare_exchange_weak_explicit(&logger->_enqueuePosition,
+													  &claimed,
+													  claimed + 1,
+													  memory_order_relaxed,
+													  memory_order_relaxed)) {
+				*position = claimed;
+				return slot;
+			}
+		} else if (difference < 0) {
+			atomic_fetch_add_explicit(&logger->_recordsDropped, 1, memory_order_relaxed);
+			return NULL;
+		} else {
+			claimed = atomic_load_explicit(&logger->_enqueuePosition, memory_order_relaxed);
+		}
+	}
+}
+
+// Publishes a filled-in slot to the consumer.
+static void IRCClientLoggerPublishSlot(IRCClientLogger *logger,
+									   IRCClientLogSlot *slot,
+									   NSUInteger position) {
+	atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+	dispatch_source_merge_data(logger->_drainSource, 1);
+}
+
+void IRCClientLoggerLogMessage(IRCClientLogger *logger,
+							   IRCClientLogLevel level,
+							   const char *format,
+							   ...) {
+	NSUInteger position;
+	IRCClientLogSlot *slot = IRCClientLoggerClaimSlot(logger, &position);
+	if (slot == NULL)
+		return;
+
+	va_list arguments;
+	va_start(arguments, format);
+	int length = vsnprintf((char *) slot->bytes, sizeof(slot->bytes), format, arguments);
+	va_end(arguments);
+
+	slot->timestamp = clock_gettime_nsec_np(CLOCK_REALTIME);
+	slot->level = level;
+	slot->type = IRCClientLogRecordMessage;
+	slot->truncated = (length >= (int) sizeof(slot->bytes));
+	slot->length = (uint16_t) MAX(0, MIN(length, (int) sizeof(slot->bytes) - 1));
+
+	IRCClientLoggerPublishSlot(logger, slot, position);
+}
+
+void IRCClientLoggerLogBytes(IRCClientLogger *logger,
+							 IRCClientLogLevel level,
+							 IRCClientLogRecordType type,
+							 const uint8_t *bytes,
+							 NSUInteger length) {
+	NSUInteger position;
+	IRCClientLogSlot *slot = IRCClientLoggerClaimSlot(logger, &position);
+	if (slot == NULL)
+		return;
+
+	NSUInteger copied = MIN(length, sizeof(slot->bytes));
+	memcpy(slot->bytes, bytes, copied);
+
+	slot->timestamp = clock_gettime_nsec_np(CLOCK_REALTIME);
+	slot->level = level;
+	slot->type = type;
+	slot->truncated = (copied < length);
+	slot->length = (uint16_t) copied;
+
+	IRCClientLoggerPublishSlot(logger, slot, position);
+}
+
+@end
@@ -0,0 +1,167 @@
+//
+//	IRCClientMessage.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+
+/*	NOTE: This header is for the framework’s internal use only.
+ */
+
+/***********************************/
+#pragma mark IRCClientMessage struct
+/***********************************/
+
+/**	RFC 1459 allows at most 15 parameters per message (14 middle parameters
+	plus the trailing parameter).
+ */
+#define IRCClientMessageMaxParams 15
+
+/**	The most tags that IRCClientMessageTagsParse() records; any more are
+	ignored.
+ */
+#define IRCClientMessageMaxTags 32
+
+/** @struct IRCClientMessage
+ *	@brief A parsed view of a single received IRC message.
+ *
+ *	The message does not own its bytes; it points into the receive buffer,
+ *	and all of its parts are ranges into those bytes. It is valid only for as
+ *	long as the bytes it was parsed from are. NSData objects for the parts of
+ *	the message are created only on request (see the accessor functions
+ *	below), i.e. only when they are actually handed to a delegate.
+ *
+ *	A range with a location of NSNotFound denotes a part that is absent.
+ */
+typedef struct {
+	const uint8_t *bytes;
+	NSUInteger length;
+
+	/**	The IRCv3 message tags (without the leading ‘@’), as they are; see
+		IRCClientMessageTagsParse().
+	 */
+	NSRange tags;
+
+	NSRange prefix;
+	NSRange command;
+
+	NSUInteger paramCount;
+	NSRange params[IRCClientMessageMaxParams];
+} IRCClientMessage;
+
+/*****************************************/
+#pragma mark - IRCClientMessageTags struct
+/*****************************************/
+
+/** @struct IRCClientMessageTags
+ *	@brief A message’s tags, split into keys and values (ranges into the
+ *	message’s bytes).
+ *
+ *	Parsing a message only finds where its tags end; this table is built
+ *	only when some tag is actually looked up, and a value is unescaped only
+ *	when it’s asked for (see IRCClientMessageTagValueData()).
+ */
+typedef struct {
+	NSUInteger count;
+	NSRange keys[IRCClientMessageMaxTags];
+	/**	Still escaped; absent (NSNotFound) for a tag with no value.
+	 */
+	NSRange values[IRCClientMessageMaxTags];
+} IRCClientMessageTags;
+
+/*********************************/
+#pragma mark - Function prototypes
+/*********************************/
+
+/**	Parses a single message (with or without the terminating CRLF).
+	Returns NO if the message has no command (i.e., it is empty or malformed).
+ */
+BOOL IRCClientMessageParse(const uint8_t *bytes,
+						   NSUInteger length,
+						   IRCClientMessage *message);
+
+/**	Splits the message’s tags into keys and values.
+ */
+void IRCClientMessageTagsParse(const IRCClientMessage *message,
+							   IRCClientMessageTags *tags);
+
+/**	Returns the range of the (escaped) value of the tag with the given key,
+	or a range with a location of NSNotFound if there’s no such tag. A tag
+	with no value has an empty range (with a location).
+ */
+NSRange IRCClientMessageTagValueRange(const IRCClientMessage *message,
+									  const IRCClientMessageTags *tags,
+									  const uint8_t *key,
+									  NSUInteger keyLength);
+
+/**	Returns a new NSData object with the given tag value, unescaped, or nil
+	if the range is absent.
+ */
+NSData *IRCClientMessageTagValueData(const IRCClientMessage *message,
+									 NSRange value);
+
+/**	Returns YES if the given range of the message’s bytes is equal to the
+	given C string. (The range may be absent, in which case NO is returned.)
+ */
+BOOL IRCClientMessageRangeIsEqualToCString(const IRCClientMessage *message,
+										   NSRange range,
+										   const char *string);
+
+/**	Returns YES if the given range of the message’s bytes begins with the
+	given C string.
+ */
+BOOL IRCClientMessageRangeHasCStringPrefix(const IRCClientMessage *message,
+										   NSRange range,
+										   const char *prefix);
+
+/**	Returns YES if the given range of the message’s bytes is equal to the
+	bytes of the given NSData object.
+ */
+BOOL IRCClientMessageRangeIsEqualToData(const IRCClientMessage *message,
+										NSRange range,
+										NSData *data);
+
+/**	Returns the range of the given parameter, or a range with a location of
+	NSNotFound if the message has no such parameter.
+ */
+NSRange IRCClientMessageParamRange(const IRCClientMessage *message,
+								   NSUInteger index);
+
+/**	Returns the first byte of the given range, or 0 if the range is empty or
+	absent.
+ */
+uint8_t IRCClientMessageRangeFirstByte(const IRCClientMessage *message,
+									   NSRange range);
+
+/**	Returns the range of the nick part of the message prefix (if the prefix is
+	in nick!user@host format; otherwise, a range with a location of NSNotFound).
+ */
+NSRange IRCClientMessagePrefixNickRange(const IRCClientMessage *message);
+
+/**	If the message’s command is a three-digit numeric reply code, returns YES
+	and puts the numeric value into *code. Otherwise, returns NO.
+ */
+BOOL IRCClientMessageNumericCode(const IRCClientMessage *message,
+								 NSUInteger *code);
+
+/**	Returns a new NSData object with a copy of the given range of the message’s
+	bytes, or nil if the range is absent.
+ */
+NSData *IRCClientMessageDataForRange(const IRCClientMessage *message,
+									 NSRange range);
+
+/**	Returns a new NSData object with a copy of the given parameter,
+	or nil if the message has no such parameter.
+ */
+NSData *IRCClientMessageParamData(const IRCClientMessage *message,
+								  NSUInteger index);
+
+/**	Returns an array of NSData objects for the message’s parameters, starting
+	with the parameter at the given index.
+ */
+NSArray <NSData *> *IRCClientMessageParamsArray(const IRCClientMessage *message,
+												NSUInteger fromIndex);
@@ -0,0 +1,286 @@
+//
+//	IRCClientMessage.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientMessage.h"
+
+/******************************/
+#pragma mark - Helper functions
+/******************************/
+
+static inline NSRange IRCClientAbsentRange() {
+	return NSMakeRange(NSNotFound, 0);
+}
+
+/**************************************/
+#pragma mark - Function implementations
+/**************************************/
+
+BOOL IRCClientMessageParse(const uint8_t *bytes,
+						   NSUInteger length,
+						   IRCClientMessage *message) {
+	// Ignore the line terminator.
+	if (length >= 2 && bytes[length - 2] == '\r' && bytes[length - 1] == '\n')
+		length -= 2;
+
+	message->bytes = bytes;
+	message->length = length;
+	message->tags = IRCClientAbsentRange();
+	message->prefix = IRCClientAbsentRange();
+	message->command = IRCClientAbsentRange();
+	message->paramCount = 0;
+
+	NSUInteger i = 0;
+
+	// Tags. (Only their extent; see IRCClientMessageTagsParse().)
+	if (i < length && bytes[i] == '@') {
+		NSUInteger tagsStart = ++i;
+		const uint8_t *space = memchr(bytes + i, ' ', length - i);
+		i = (space != NULL) ? (NSUInteger) (space - bytes) : length;
+		message->tags = NSMakeRange(tagsStart, i - tagsStart);
+
+		while (i < length && bytes[i] == ' ')
+			i++;
+	}
+
+	// Prefix.
+	if (i < length && bytes[i] == ':') {
+		NSUInteger prefixStart = ++i;
+		while (i < length && bytes[i] != ' ')
+			i++;
+		message->prefix = NSMakeRange(prefixStart, i - prefixStart);
+	}
+
+	// Command.
+	while (i < length && bytes[i] == ' ')
+		i++;
+	NSUInteger commandStart = i;
+	while (i < length && bytes[i] != ' ')
+		i++;
+	if (i == commandStart)
+		return NO;
+	message->command = NSMakeRange(commandStart, i - commandStart);
+
+	// Params.
+	while (i < length) {
+		while (i < length && bytes[i] == ' ')
+			i++;
+		if (i == length)
+			break;
+
+		if (   bytes[i] == ':'
+			|| message->paramCount == IRCClientMessageMaxParams - 1) {
+			// Trailing param (or the last param there’s room for);
+			// runs to the end of the line.
+			if (bytes[i] == ':')
+				i++;
+			message->params[message->paramCount++] = NSMakeRange(i, length - i);
+			break;
+		}
+
+		// Middle param.
+		NSUInteger paramStart = i;
+		while (i < length && bytes[i] != ' ')
+			i++;
+		message->params[message->paramCount++] = NSMakeRange(paramStart, i - paramStart);
+	}
+
+	return YES;
+}
+
+void IRCClientMessageTagsParse(const IRCClientMessage *message,
+							   IRCClientMessageTags *tags) {
+	tags->count = 0;
+	if (message->tags.location == NSNotFound)
+		return;
+
+	// key[=value];key[=value];...
+	const uint8_t *bytes = message->bytes;
+	NSUInteger i = message->tags.location;
+	NSUInteger end = NSMaxRange(message->tags);
+	while (   i < end
+		   && tags->count < IRCClientMessageMaxTags) {
+		NSUInteger keyStart = i;
+		while (i < end && bytes[i] != '=' && bytes[i] != ';')
+			i++;
+		NSRange key = NSMakeRange(keyStart, i - keyStart);
+
+		NSRange value = IRCClientAbsentRange();
+		if (i < end && bytes[i] == '=') {
+			NSUInteger valueStart = ++i;
+			while (i < end && bytes[i] != ';')
+				i++;
+			value = NSMakeRange(valueStart, i - valueStart);
+		}
+
+		if (key.length > 0) {
+			tags->keys[tags->count] = key;
+			tags->values[tags->count] = value;
+			tags->count++;
+		}
+
+		// Skip the separator.
+		i++;
+	}
+}
+
+NSRange IRCClientMessageTagValueRange(const IRCClientMessage *message,
+									  const IRCClientMessageTags *tags,
+									  const uint8_t *key,
+									  NSUInteger keyLength) {
+	for (NSUInteger i = 0; i < tags->count; i++) {
+		if (   tags->keys[i].length == keyLength
+			&& memcmp(message->bytes + tags->keys[i].location, key, keyLength) == 0)
+			return (tags->values[i].location != NSNotFound
+					? tags->values[i]
+					: NSMakeRange(NSMaxRange(tags->keys[i]), 0));
+	}
+
+	return IRCClientAbsentRange();
+}
+
+NSData *IRCClientMessageTagValueData(const IRCClientMessage *message,
+									 NSRange value) {
+	if (value.location == NSNotFound)
+		return nil;
+
+	// Most values have nothing escaped.
+	const uint8_t *bytes = message->bytes + value.location;
+	if (memchr(bytes, '\\', value.length) == NULL)
+		return [NSData dataWithBytes:bytes
+							  length:value.length];
+
+	NSMutableData *unescaped = [NSMutableData dataWithLength:value.length];
+	uint8_t *output = unescaped.mutableBytes;
+	NSUInteger outputLength = 0;
+	for (NSUInteger i = 0; i < value.length; i++) {
+		if (bytes[i] != '\\') {
+			output[outputLength++] = bytes[i];
+			continue;
+		}
+
+		// (A trailing backslash is dropped.)
+		if (++i == value.length)
+			break;
+		switch (bytes[i]) {
+			case ':':	output[outputLength++] = ';';	break;
+			case 's':	output[outputLength++] = ' ';	break;
+			case 'r':	output[outputLength++] = '\r';	break;
+			case 'n':	output[outputLength++] = '\n';	break;
+			default:	output[outputLength++] = bytes[i];	break;
+		}
+	}
+	unescaped.length = outputLength;
+
+	return unescaped;
+}
+
+BOOL IRCClientMessageRangeIsEqualToCString(const IRCClientMessage *message,
+										   NSRange range,
+										   const char *string) {
+	if (range.location == NSNotFound)
+		return NO;
+
+	size_t stringLength = strlen(string);
+	return (   range.length == stringLength
+			&& memcmp(message->bytes + range.location, string, stringLength) == 0);
+}
+
+BOOL IRCClientMessageRangeHasCStringPrefix(const IRCClientMessage *message,
+										   NSRange range,
+										   const char *prefix) {
+	if (range.location == NSNotFound)
+		return NO;
+
+	size_t prefixLength = strlen(prefix);
+	return (   range.length >= prefixLength
+			&& memcmp(message->bytes + range.location, prefix, prefixLength) == 0);
+}
+
+BOOL IRCClientMessageRangeIsEqualToData(const IRCClientMessage *message,
+										NSRange range,
+										NSData *data) {
+	if (   range.location == NSNotFound
+		|| data == nil)
+		return NO;
+
+	return (   range.length == data.length
+			&& memcmp(message->bytes + range.location, data.bytes, range.length) == 0);
+}
+
+NSRange IRCClientMessageParamRange(const IRCClientMessage *message,
+								   NSUInteger index) {
+	return (index < message->paramCount
+			? message->params[index]
+			: IRCClientAbsentRange());
+}
+
+uint8_t IRCClientMessageRangeFirstByte(const IRCClientMessage *message,
+									   NSRange range) {
+	return (   range.location != NSNotFound
+			&& range.length > 0
+			? message->bytes[range.location]
+			: 0);
+}
+
+NSRange IRCClientMessagePrefixNickRange(const IRCClientMessage *message) {
+	if (message->prefix.location == NSNotFound)
+		return IRCClientAbsentRange();
+
+	const uint8_t *separator = memchr(message->bytes + message->prefix.location,
+									  '!',
+									  message->prefix.length);
+	if (separator == NULL)
+		return IRCClientAbsentRange();
+
+	return NSMakeRange(message->prefix.location,
+					   (NSUInteger) (separator - (message->bytes + message->prefix.location)));
+}
+
+BOOL IRCClientMessageNumericCode(const IRCClientMessage *message,
+								 NSUInteger *code) {
+	if (message->command.length != 3)
+		return NO;
+
+	const uint8_t *digits = message->bytes + message->command.location;
+	if (   !isdigit(digits[0])
+		|| !isdigit(digits[1])
+		|| !isdigit(digits[2]))
+		return NO;
+
+	*code = (  (NSUInteger) (digits[0] - '0') * 100
+			 + (NSUInteger) (digits[1] - '0') * 10
+			 + (NSUInteger) (digits[2] - '0'));
+	return YES;
+}
+
+NSData *IRCClientMessageDataForRange(const IRCClientMessage *message,
+									 NSRange range) {
+	if (range.location == NSNotFound)
+		return nil;
+
+	return [NSData dataWithBytes:(message->bytes + range.location)
+						  length:range.length];
+}
+
+NSData *IRCClientMessageParamData(const IRCClientMessage *message,
+								  NSUInteger index) {
+	return IRCClientMessageDataForRange(message,
+										IRCClientMessageParamRange(message, index));
+}
+
+NSArray <NSData *> *IRCClientMessageParamsArray(const IRCClientMessage *message,
+												NSUInteger fromIndex) {
+	NSMutableArray <NSData *> *params = [NSMutableArray arrayWithCapacity:(message->paramCount > fromIndex
+																		   ? message->paramCount - fromIndex
+																		   : 0)];
+	for (NSUInteger i = fromIndex; i < message->paramCount; i++)
+		[params addObject:IRCClientMessageDataForRange(message, message->params[i])];
+
+	return params;
+}
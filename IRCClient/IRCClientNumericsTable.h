@@ -0,0 +1,1046 @@
+//
+//	IRCClientNumericsTable.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+/*	NOTE: This file is generated by Scripts/generate_numerics_table.py
+	from IRC_Numerics.plist. Do not edit it by hand; edit the plist and
+	re-run the script instead.
+ */
+
+#import <Foundation/Foundation.h>
+
+/*********************/
+#pragma mark Constants
+/*********************/
+
+#define IRCClientNumericCodeCount 1000
+
+#define IRCClientNumericsSource "https://www.alien.net.au/irc/irc2numerics.html"
+
+/***********************/
+#pragma mark - Name pool
+/***********************/
+
+static const char IRCClientNumericNamePool[] =
+	"RPL_WELCOME\0"
+	"RPL_YOURHOST\0"
+	"RPL_CREATED\0"
+	"RPL_MYINFO\0"
+	"RPL_ISUPPORT\0"
+	"RPL_BOUNCE\0"
+	"RPL_PROTOCTL\0"
+	"RPL_MAP\0"
+	"RPL_MAP\0"
+	"RPL_MAPMORE\0"
+	"RPL_MAPEND\0"
+	"RPL_SNOMASK\0"
+	"RPL_STATMEMTOT\0"
+	"RPL_BOUNCE\0"
+	"RPL_STATMEM\0"
+	"RPL_YOURCOOKIE\0"
+	"RPL_MAP\0"
+	"RPL_MAPMORE\0"
+	"RPL_MAPEND\0"
+	"RPL_YOURID\0"
+	"RPL_SAVENICK\0"
+	"RPL_ATTEMPTINGJUNC\0"
+	"RPL_ATTEMPTINGREROUTE\0"
+	"RPL_TRACELINK\0"
+	"RPL_TRACECONNECTING\0"
+	"RPL_TRACEHANDSHAKE\0"
+	"RPL_TRACEUNKNOWN\0"
+	"RPL_TRACEOPERATOR\0"
+	"RPL_TRACEUSER\0"
+	"RPL_TRACESERVER\0"
+	"RPL_TRACESERVICE\0"
+	"RPL_TRACENEWTYPE\0"
+	"RPL_TRACECLASS\0"
+	"RPL_STATS\0"
+	"RPL_TRACERECONNECT\0"
+	"RPL_STATSLINKINFO\0"
+	"RPL_STATSCOMMANDS\0"
+	"RPL_STATSCLINE\0"
+	"RPL_STATSNLINE\0"
+	"RPL_STATSOLDNLINE\0"
+	"RPL_STATSILINE\0"
+	"RPL_STATSKLINE\0"
+	"RPL_STATSQLINE\0"
+	"RPL_STATSPLINE\0"
+	"RPL_STATSYLINE\0"
+	"RPL_ENDOFSTATS\0"
+	"RPL_STATSPLINE\0"
+	"RPL_STATSBLINE\0"
+	"RPL_UMODEIS\0"
+	"RPL_MODLIST\0"
+	"RPL_SQLINE_NICK\0"
+	"RPL_STATSBLINE\0"
+	"RPL_STATSGLINE\0"
+	"RPL_STATSELINE\0"
+	"RPL_STATSTLINE\0"
+	"RPL_STATSFLINE\0"
+	"RPL_STATSDLINE\0"
+	"RPL_STATSZLINE\0"
+	"RPL_STATSNLINE\0"
+	"RPL_STATSCOUNT\0"
+	"RPL_STATSVLINE\0"
+	"RPL_STATSGLINE\0"
+	"RPL_STATSQLINE\0"
+	"RPL_SERVICEINFO\0"
+	"RPL_RULES\0"
+	"RPL_ENDOFSERVICES\0"
+	"RPL_SERVICE\0"
+	"RPL_SERVLIST\0"
+	"RPL_SERVLISTEND\0"
+	"RPL_STATSVERBOSE\0"
+	"RPL_STATSENGINE\0"
+	"RPL_STATSFLINE\0"
+	"RPL_STATSIAUTH\0"
+	"RPL_STATSVLINE\0"
+	"RPL_STATSXLINE\0"
+	"RPL_STATSLLINE\0"
+	"RPL_STATSUPTIME\0"
+	"RPL_STATSOLINE\0"
+	"RPL_STATSHLINE\0"
+	"RPL_STATSSLINE\0"
+	"RPL_STATSPING\0"
+	"RPL_STATSTLINE\0"
+	"RPL_STATSULINE\0"
+	"RPL_STATSBLINE\0"
+	"RPL_STATSXLINE\0"
+	"RPL_STATSGLINE\0"
+	"RPL_STATSDEFINE\0"
+	"RPL_STATSULINE\0"
+	"RPL_STATSULINE\0"
+	"RPL_STATSDEBUG\0"
+	"RPL_STATSDLINE\0"
+	"RPL_STATSCONN\0"
+	"RPL_LUSERCLIENT\0"
+	"RPL_LUSEROP\0"
+	"RPL_LUSERUNKNOWN\0"
+	"RPL_LUSERCHANNELS\0"
+	"RPL_LUSERME\0"
+	"RPL_ADMINME\0"
+	"RPL_ADMINLOC1\0"
+	"RPL_ADMINLOC2\0"
+	"RPL_ADMINEMAIL\0"
+	"RPL_TRACELOG\0"
+	"RPL_TRACEPING\0"
+	"RPL_TRACEEND\0"
+	"RPL_TRYAGAIN\0"
+	"RPL_LOCALUSERS\0"
+	"RPL_GLOBALUSERS\0"
+	"RPL_START_NETSTAT\0"
+	"RPL_NETSTAT\0"
+	"RPL_END_NETSTAT\0"
+	"RPL_PRIVS\0"
+	"RPL_SILELIST\0"
+	"RPL_ENDOFSILELIST\0"
+	"RPL_NOTIFY\0"
+	"RPL_ENDNOTIFY\0"
+	"RPL_STATSDELTA\0"
+	"RPL_STATSDLINE\0"
+	"RPL_VCHANEXIST\0"
+	"RPL_VCHANLIST\0"
+	"RPL_VCHANHELP\0"
+	"RPL_GLIST\0"
+	"RPL_ENDOFGLIST\0"
+	"RPL_ACCEPTLIST\0"
+	"RPL_ENDOFACCEPT\0"
+	"RPL_JUPELIST\0"
+	"RPL_ALIST\0"
+	"RPL_ENDOFJUPELIST\0"
+	"RPL_ENDOFALIST\0"
+	"RPL_FEATURE\0"
+	"RPL_GLIST_HASH\0"
+	"RPL_CHANINFO_HANDLE\0"
+	"RPL_NEWHOSTIS\0"
+	"RPL_CHANINFO_USERS\0"
+	"RPL_CHKHEAD\0"
+	"RPL_CHANINFO_CHOPS\0"
+	"RPL_CHANUSER\0"
+	"RPL_CHANINFO_VOICES\0"
+	"RPL_PATCHHEAD\0"
+	"RPL_CHANINFO_AWAY\0"
+	"RPL_PATCHCON\0"
+	"RPL_CHANINFO_OPERS\0"
+	"RPL_HELPHDR\0"
+	"RPL_DATASTR\0"
+	"RPL_CHANINFO_BANNED\0"
+	"RPL_HELPOP\0"
+	"RPL_ENDOFCHECK\0"
+	"RPL_CHANINFO_BANS\0"
+	"RPL_HELPTLR\0"
+	"RPL_CHANINFO_INVITE\0"
+	"RPL_HELPHLP\0"
+	"RPL_CHANINFO_INVITES\0"
+	"RPL_HELPFWD\0"
+	"RPL_CHANINFO_KICK\0"
+	"RPL_HELPIGN\0"
+	"RPL_CHANINFO_KICKS\0"
+	"RPL_END_CHANINFO\0"
+	"RPL_NONE\0"
+	"RPL_AWAY\0"
+	"RPL_USERHOST\0"
+	"RPL_ISON\0"
+	"RPL_TEXT\0"
+	"RPL_UNAWAY\0"
+	"RPL_NOWAWAY\0"
+	"RPL_USERIP\0"
+	"RPL_WHOISREGNICK\0"
+	"RPL_SUSERHOST\0"
+	"RPL_NOTIFYACTION\0"
+	"RPL_WHOISADMIN\0"
+	"RPL_RULESSTART\0"
+	"RPL_NICKTRACE\0"
+	"RPL_WHOISSADMIN\0"
+	"RPL_ENDOFRULES\0"
+	"RPL_WHOISHELPER\0"
+	"RPL_WHOISSVCMSG\0"
+	"RPL_WHOISHELPOP\0"
+	"RPL_WHOISSERVICE\0"
+	"RPL_WHOISUSER\0"
+	"RPL_WHOISSERVER\0"
+	"RPL_WHOISOPERATOR\0"
+	"RPL_WHOWASUSER\0"
+	"RPL_ENDOFWHO\0"
+	"RPL_WHOISCHANOP\0"
+	"RPL_WHOISIDLE\0"
+	"RPL_ENDOFWHOIS\0"
+	"RPL_WHOISCHANNELS\0"
+	"RPL_WHOISVIRT\0"
+	"RPL_WHOIS_HIDDEN\0"
+	"RPL_WHOISSPECIAL\0"
+	"RPL_LISTSTART\0"
+	"RPL_LIST\0"
+	"RPL_LISTEND\0"
+	"RPL_CHANNELMODEIS\0"
+	"RPL_UNIQOPIS\0"
+	"RPL_CHANNELPASSIS\0"
+	"RPL_NOCHANPASS\0"
+	"RPL_CHPASSUNKNOWN\0"
+	"RPL_CHANNEL_URL\0"
+	"RPL_CREATIONTIME\0"
+	"RPL_WHOWAS_TIME\0"
+	"RPL_WHOISACCOUNT\0"
+	"RPL_NOTOPIC\0"
+	"RPL_TOPIC\0"
+	"RPL_TOPICWHOTIME\0"
+	"RPL_LISTUSAGE\0"
+	"RPL_COMMANDSYNTAX\0"
+	"RPL_LISTSYNTAX\0"
+	"RPL_WHOISBOT\0"
+	"RPL_CHANPASSOK\0"
+	"RPL_WHOISACTUALLY\0"
+	"RPL_BADCHANPASS\0"
+	"RPL_USERIP\0"
+	"RPL_INVITING\0"
+	"RPL_SUMMONING\0"
+	"RPL_INVITED\0"
+	"RPL_INVITELIST\0"
+	"RPL_ENDOFINVITELIST\0"
+	"RPL_EXCEPTLIST\0"
+	"RPL_EXLIST\0"
+	"RPL_ENDOFEXCEPTLIST\0"
+	"RPL_ENDOFEXLIST \0"
+	"RPL_VERSION\0"
+	"RPL_WHOREPLY\0"
+	"RPL_NAMREPLY\0"
+	"RPL_WHOSPCRPL\0"
+	"RPL_NAMREPLY_\0"
+	"RPL_MAP\0"
+	"RPL_MAPMORE\0"
+	"RPL_MAPEND\0"
+	"RPL_KILLDONE\0"
+	"RPL_CLOSING\0"
+	"RPL_CLOSEEND\0"
+	"RPL_LINKS\0"
+	"RPL_ENDOFLINKS\0"
+	"RPL_ENDOFNAMES\0"
+	"RPL_BANLIST\0"
+	"RPL_ENDOFBANLIST\0"
+	"RPL_ENDOFWHOWAS\0"
+	"RPL_INFO\0"
+	"RPL_MOTD\0"
+	"RPL_INFOSTART\0"
+	"RPL_ENDOFINFO\0"
+	"RPL_MOTDSTART\0"
+	"RPL_ENDOFMOTD\0"
+	"RPL_KICKEXPIRED\0"
+	"RPL_SPAM\0"
+	"RPL_BANEXPIRED\0"
+	"RPL_WHOISHOST\0"
+	"RPL_MOTD\0"
+	"RPL_KICKLINKED\0"
+	"RPL_WHOISMODES\0"
+	"RPL_BANLINKED\0"
+	"RPL_YOURHELPER\0"
+	"RPL_YOUREOPER\0"
+	"RPL_REHASHING\0"
+	"RPL_YOURESERVICE\0"
+	"RPL_MYPORTIS\0"
+	"RPL_NOTOPERANYMORE\0"
+	"RPL_QLIST\0"
+	"RPL_IRCOPS\0"
+	"RPL_ENDOFQLIST\0"
+	"RPL_ENDOFIRCOPS\0"
+	"RPL_ALIST\0"
+	"RPL_ENDOFALIST\0"
+	"RPL_TIME\0"
+	"RPL_USERSSTART\0"
+	"RPL_USERS\0"
+	"RPL_ENDOFUSERS\0"
+	"RPL_NOUSERS\0"
+	"RPL_HOSTHIDDEN\0"
+	"ERR_UNKNOWNERROR\0"
+	"ERR_NOSUCHNICK\0"
+	"ERR_NOSUCHSERVER\0"
+	"ERR_NOSUCHCHANNEL\0"
+	"ERR_CANNOTSENDTOCHAN\0"
+	"ERR_TOOMANYCHANNELS\0"
+	"ERR_WASNOSUCHNICK\0"
+	"ERR_TOOMANYTARGETS\0"
+	"ERR_NOSUCHSERVICE\0"
+	"ERR_NOCOLORSONCHAN\0"
+	"ERR_NOORIGIN\0"
+	"ERR_NORECIPIENT\0"
+	"ERR_NOTEXTTOSEND\0"
+	"ERR_NOTOPLEVEL\0"
+	"ERR_WILDTOPLEVEL\0"
+	"ERR_BADMASK\0"
+	"ERR_TOOMANYMATCHES\0"
+	"ERR_QUERYTOOLONG\0"
+	"ERR_LENGTHTRUNCATED\0"
+	"ERR_UNKNOWNCOMMAND\0"
+	"ERR_NOMOTD\0"
+	"ERR_NOADMININFO\0"
+	"ERR_FILEERROR\0"
+	"ERR_NOOPERMOTD\0"
+	"ERR_TOOMANYAWAY\0"
+	"ERR_EVENTNICKCHANGE\0"
+	"ERR_NONICKNAMEGIVEN\0"
+	"ERR_ERRONEUSNICKNAME\0"
+	"ERR_NICKNAMEINUSE\0"
+	"ERR_SERVICENAMEINUSE\0"
+	"ERR_NORULES\0"
+	"ERR_SERVICECONFUSED\0"
+	"ERR_BANONCHAN\0"
+	"ERR_NICKCOLLISION\0"
+	"ERR_UNAVAILRESOURCE\0"
+	"ERR_BANNICKCHANGE\0"
+	"ERR_NICKTOOFAST\0"
+	"ERR_NCHANGETOOFAST\0"
+	"ERR_DEAD\0"
+	"ERR_TARGETTOOFAST\0"
+	"RPL_INVTOOFAST\0"
+	"RPL_MSGTOOFAST\0"
+	"ERR_SERVICESDOWN\0"
+	"ERR_USERNOTINCHANNEL\0"
+	"ERR_NOTONCHANNEL\0"
+	"ERR_USERONCHANNEL\0"
+	"ERR_NOLOGIN\0"
+	"ERR_SUMMONDISABLED\0"
+	"ERR_USERSDISABLED\0"
+	"ERR_NONICKCHANGE\0"
+	"ERR_NOTIMPLEMENTED\0"
+	"ERR_NOTREGISTERED\0"
+	"ERR_IDCOLLISION\0"
+	"ERR_NICKLOST\0"
+	"ERR_HOSTILENAME\0"
+	"ERR_ACCEPTFULL\0"
+	"ERR_ACCEPTEXIST\0"
+	"ERR_ACCEPTNOT\0"
+	"ERR_NOHIDING\0"
+	"ERR_NOTFORHALFOPS\0"
+	"ERR_NEEDMOREPARAMS\0"
+	"ERR_ALREADYREGISTERED\0"
+	"ERR_NOPERMFORHOST\0"
+	"ERR_PASSWDMISMATCH\0"
+	"ERR_YOUREBANNEDCREEP\0"
+	"ERR_YOUWILLBEBANNED\0"
+	"ERR_KEYSET\0"
+	"ERR_INVALIDUSERNAME\0"
+	"ERR_ONLYSERVERSCANCHANGE\0"
+	"ERR_LINKSET\0"
+	"ERR_LINKCHANNEL\0"
+	"ERR_KICKEDFROMCHAN\0"
+	"ERR_CHANNELISFULL\0"
+	"ERR_UNKNOWNMODE\0"
+	"ERR_INVITEONLYCHAN\0"
+	"ERR_BANNEDFROMCHAN\0"
+	"ERR_BADCHANNELKEY\0"
+	"ERR_BADCHANMASK\0"
+	"ERR_NOCHANMODES\0"
+	"ERR_MODELESS\0"
+	"ERR_NEEDREGGEDNICK\0"
+	"ERR_BANLISTFULL\0"
+	"ERR_BADCHANNAME\0"
+	"ERR_LINKFAIL\0"
+	"ERR_NOULINE\0"
+	"ERR_CANNOTKNOCK\0"
+	"ERR_NOPRIVILEGES\0"
+	"ERR_CHANOPRIVSNEEDED\0"
+	"ERR_CANTKILLSERVER\0"
+	"ERR_RESTRICTED\0"
+	"ERR_ISCHANSERVICE\0"
+	"ERR_DESYNC\0"
+	"ERR_ATTACKDENY\0"
+	"ERR_UNIQOPRIVSNEEDED\0"
+	"ERR_KILLDENY\0"
+	"ERR_CANTKICKADMIN\0"
+	"ERR_ISREALSERVICE\0"
+	"ERR_NONONREG\0"
+	"ERR_HTMDISABLED\0"
+	"ERR_ACCOUNTONLY\0"
+	"ERR_CHANTOORECENT\0"
+	"ERR_MSGSERVICES\0"
+	"ERR_TSLESSCHAN\0"
+	"ERR_VOICENEEDED\0"
+	"ERR_SECUREONLYCHAN\0"
+	"ERR_NOOPERHOST\0"
+	"ERR_NOSERVICEHOST\0"
+	"ERR_NOFEATURE\0"
+	"ERR_BADFEATURE\0"
+	"ERR_BADLOGTYPE\0"
+	"ERR_BADLOGSYS\0"
+	"ERR_BADLOGVALUE\0"
+	"ERR_ISOPERLCHAN\0"
+	"ERR_CHANOWNPRIVNEEDED\0"
+	"ERR_UMODEUNKNOWNFLAG\0"
+	"ERR_USERSDONTMATCH\0"
+	"ERR_GHOSTEDCLIENT\0"
+	"ERR_VWORLDWARN\0"
+	"ERR_USERNOTONSERV\0"
+	"ERR_SILELISTFULL\0"
+	"ERR_TOOMANYWATCH\0"
+	"ERR_NOTIFYFULL\0"
+	"ERR_BADPING\0"
+	"ERR_NEEDPONG\0"
+	"ERR_INVALID_ERROR\0"
+	"ERR_TOOMANYDCC\0"
+	"ERR_BADEXPIRE\0"
+	"ERR_DONTCHEAT\0"
+	"ERR_DISABLED\0"
+	"ERR_NOINVITE\0"
+	"ERR_LONGMASK\0"
+	"ERR_ADMONLY\0"
+	"ERR_TOOMANYUSERS\0"
+	"ERR_OPERONLY\0"
+	"ERR_MASKTOOWIDE\0"
+	"ERR_WHOTRUNC\0"
+	"ERR_LISTSYNTAX\0"
+	"ERR_WHOSYNTAX\0"
+	"ERR_WHOLIMEXCEED\0"
+	"ERR_QUARANTINED\0"
+	"ERR_OPERSPVERIFY\0"
+	"ERR_REMOTEPFX\0"
+	"ERR_PFXUNROUTABLE\0"
+	"ERR_BADHOSTMASK\0"
+	"ERR_HOSTUNAVAIL\0"
+	"ERR_USINGSLINE\0"
+	"ERR_STATSSLINE\0"
+	"RPL_LOGON\0"
+	"RPL_LOGOFF\0"
+	"RPL_WATCHOFF\0"
+	"RPL_WATCHSTAT\0"
+	"RPL_NOWON\0"
+	"RPL_NOWOFF\0"
+	"RPL_WATCHLIST\0"
+	"RPL_ENDOFWATCHLIST\0"
+	"RPL_WATCHCLEAR\0"
+	"RPL_MAPMORE\0"
+	"RPL_ISOPER\0"
+	"RPL_ISLOCOP\0"
+	"RPL_ISNOTOPER\0"
+	"RPL_ENDOFISOPER\0"
+	"RPL_MAPMORE\0"
+	"RPL_WHOISMODES\0"
+	"RPL_WHOISHOST\0"
+	"RPL_DCCSTATUS\0"
+	"RPL_WHOISBOT\0"
+	"RPL_DCCLIST\0"
+	"RPL_ENDOFDCCLIST\0"
+	"RPL_WHOWASHOST\0"
+	"RPL_DCCINFO\0"
+	"RPL_RULESSTART\0"
+	"RPL_RULES\0"
+	"RPL_ENDOFRULES\0"
+	"RPL_MAPMORE\0"
+	"RPL_OMOTDSTART\0"
+	"RPL_OMOTD\0"
+	"RPL_ENDOFO\0"
+	"RPL_SETTINGS\0"
+	"RPL_ENDOFSETTINGS\0"
+	"RPL_DUMPING\0"
+	"RPL_DUMPRPL\0"
+	"RPL_EODUMP\0"
+	"RPL_TRACEROUTE_HOP\0"
+	"RPL_TRACEROUTE_START\0"
+	"RPL_MODECHANGEWARN\0"
+	"RPL_CHANREDIR\0"
+	"RPL_SERVMODEIS\0"
+	"RPL_OTHERUMODEIS\0"
+	"RPL_ENDOF_GENERIC\0"
+	"RPL_WHOWASDETAILS\0"
+	"RPL_WHOISSECURE\0"
+	"RPL_UNKNOWNMODES\0"
+	"RPL_CANNOTSETMODES\0"
+	"RPL_LUSERSTAFF\0"
+	"RPL_TIMEONSERVERIS\0"
+	"RPL_NETWORKS\0"
+	"RPL_YOURLANGUAGEIS\0"
+	"RPL_LANGUAGE\0"
+	"RPL_WHOISSTAFF\0"
+	"RPL_WHOISLANGUAGE\0"
+	"RPL_MODLIST\0"
+	"RPL_ENDOFMODLIST\0"
+	"RPL_HELPSTART\0"
+	"RPL_HELPTXT\0"
+	"RPL_ENDOFHELP\0"
+	"RPL_ETRACEFULL\0"
+	"RPL_ETRACE\0"
+	"RPL_KNOCK\0"
+	"RPL_KNOCKDLVR\0"
+	"ERR_TOOMANYKNOCK\0"
+	"ERR_CHANOPEN\0"
+	"ERR_KNOCKONCHAN\0"
+	"ERR_KNOCKDISABLED\0"
+	"RPL_TARGUMODEG\0"
+	"RPL_TARGNOTIFY\0"
+	"RPL_UMODEGMSG\0"
+	"RPL_OMOTDSTART\0"
+	"RPL_OMOTD\0"
+	"RPL_ENDOFOMOTD\0"
+	"ERR_NOPRIVS\0"
+	"RPL_TESTMARK\0"
+	"RPL_TESTLINE\0"
+	"RPL_NOTESTLINE\0"
+	"RPL_XINFO\0"
+	"RPL_XINFOSTART\0"
+	"RPL_XINFOEND\0"
+	"ERR_CANNOTDOCOMMAND\0"
+	"ERR_CANNOTCHANGEUMODE\0"
+	"ERR_CANNOTCHANGECHANMODE\0"
+	"ERR_CANNOTCHANGESERVERMODE\0"
+	"ERR_CANNOTSENDTONICK\0"
+	"ERR_UNKNOWNSERVERMODE\0"
+	"ERR_SERVERMODELOCK\0"
+	"ERR_BADCHARENCODING\0"
+	"ERR_TOOMANYLANGUAGES\0"
+	"ERR_NOLANGUAGE\0"
+	"ERR_TEXTTOOSHORT\0"
+	"ERR_NUMERIC_ERR\0"
+	"ERR_NUMERICERR\0"
+	;
+
+static const uint16_t IRCClientNumericNameOffsets[508] = {
+	0, 12, 25, 37, 48, 61, 72, 85,
+	93, 101, 113, 124, 136, 151, 162, 174,
+	189, 197, 209, 220, 231, 244, 263, 285,
+	299, 319, 338, 355, 373, 387, 403, 420,
+	437, 452, 462, 481, 499, 517, 532, 547,
+	565, 580, 595, 610, 625, 640, 655, 670,
+	685, 697, 709, 725, 740, 755, 770, 785,
+	800, 815, 830, 845, 860, 875, 890, 905,
+	921, 931, 949, 961, 974, 990, 1007, 1023,
+	1038, 1053, 1068, 1083, 1098, 1114, 1129, 1144,
+	1159, 1173, 1188, 1203, 1218, 1233, 1248, 1264,
+	1279, 1294, 1309, 1324, 1338, 1354, 1366, 1383,
+	1401, 1413, 1425, 1439, 1453, 1468, 1481, 1495,
+	1508, 1521, 1536, 1552, 1570, 1582, 1598, 1608,
+	1621, 1639, 1650, 1664, 1679, 1694, 1709, 1723,
+	1737, 1747, 1762, 1777, 1793, 1806, 1816, 1834,
+	1849, 1861, 1876, 1896, 1910, 1929, 1941, 1960,
+	1973, 1993, 2007, 2025, 2038, 2057, 2069, 2081,
+	2101, 2112, 2127, 2145, 2157, 2177, 2189, 2210,
+	2222, 2240, 2252, 2271, 2288, 2297, 2306, 2319,
+	2328, 2337, 2348, 2360, 2371, 2388, 2402, 2419,
+	2434, 2449, 2463, 2479, 2494, 2510, 2526, 2542,
+	2559, 2573, 2589, 2607, 2622, 2635, 2651, 2665,
+	2680, 2698, 2712, 2729, 2746, 2760, 2769, 2781,
+	2799, 2812, 2830, 2845, 2863, 2879, 2896, 2912,
+	2929, 2941, 2951, 2968, 2982, 3000, 3015, 3028,
+	3043, 3061, 3077, 3088, 3101, 3115, 3127, 3142,
+	3162, 3177, 3188, 3208, 3225, 3237, 3250, 3263,
+	3277, 3291, 3299, 3311, 3322, 3335, 3347, 3360,
+	3370, 3385, 3400, 3412, 3429, 3445, 3454, 3463,
+	3477, 3491, 3505, 3519, 3535, 3544, 3559, 3573,
+	3582, 3597, 3612, 3626, 3641, 3655, 3669, 3686,
+	3699, 3718, 3728, 3739, 3754, 3770, 3780, 3795,
+	3804, 3819, 3829, 3844, 3856, 3871, 3888, 3903,
+	3920, 3938, 3959, 3979, 3997, 4016, 4034, 4053,
+	4066, 4082, 4099, 4114, 4131, 4143, 4162, 4179,
+	4199, 4218, 4229, 4245, 4259, 4274, 4290, 4310,
+	4330, 4351, 4369, 4390, 4402, 4422, 4436, 4454,
+	4474, 4492, 4508, 4527, 4536, 4554, 4569, 4584,
+	4601, 4622, 4639, 4657, 4669, 4688, 4706, 4723,
+	4742, 4760, 4776, 4789, 4805, 4820, 4836, 4850,
+	4863, 4881, 4900, 4922, 4940, 4959, 4980, 5000,
+	5011, 5031, 5056, 5068, 5084, 5103, 5121, 5137,
+	5156, 5175, 5193, 5209, 5225, 5238, 5257, 5273,
+	5289, 5302, 5314, 5330, 5347, 5368, 5387, 5402,
+	5420, 5431, 5446, 5467, 5480, 5498, 5516, 5529,
+	5545, 5561, 5579, 5595, 5610, 5626, 5645, 5660,
+	5678, 5692, 5707, 5722, 5736, 5752, 5768, 5790,
+	5811, 5830, 5848, 5863, 5881, 5898, 5915, 5930,
+	5942, 5955, 5973, 5988, 6002, 6016, 6029, 6042,
+	6055, 6067, 6084, 6097, 6113, 6126, 6141, 6155,
+	6172, 6188, 6205, 6219, 6237, 6253, 6269, 6284,
+	6299, 6309, 6320, 6333, 6347, 6357, 6368, 6382,
+	6401, 6416, 6428, 6439, 6451, 6465, 6481, 6493,
+	6508, 6522, 6536, 6549, 6561, 6578, 6593, 6605,
+	6620, 6630, 6645, 6657, 6672, 6682, 6693, 6706,
+	6724, 6736, 6748, 6759, 6778, 6799, 6818, 6832,
+	6847, 6864, 6882, 6900, 6916, 6933, 6952, 6967,
+	6986, 6999, 7018, 7031, 7046, 7064, 7076, 7093,
+	7107, 7119, 7133, 7148, 7159, 7169, 7183, 7200,
+	7213, 7229, 7247, 7262, 7277, 7291, 7306, 7316,
+	7331, 7343, 7356, 7369, 7384, 7394, 7409, 7422,
+	7442, 7464, 7489, 7516, 7537, 7559, 7578, 7598,
+	7619, 7634, 7651, 7667,
+};
+
+/****************************/
+#pragma mark - Numerics table
+/****************************/
+
+/*	Indexed by numeric code; codes with no known names have a count of 0.
+ */
+static const struct {
+	uint16_t firstName;
+	uint16_t nameCount;
+} IRCClientNumericsTable[IRCClientNumericCodeCount] = {
+	[1] = { 0, 1 },
+	[2] = { 1, 1 },
+	[3] = { 2, 1 },
+	[4] = { 3, 1 },
+	[5] = { 4, 4 },
+	[6] = { 8, 2 },
+	[7] = { 10, 1 },
+	[8] = { 11, 1 },
+	[9] = { 12, 1 },
+	[10] = { 13, 2 },
+	[14] = { 15, 1 },
+	[15] = { 16, 1 },
+	[16] = { 17, 1 },
+	[17] = { 18, 1 },
+	[42] = { 19, 1 },
+	[43] = { 20, 1 },
+	[50] = { 21, 1 },
+	[51] = { 22, 1 },
+	[200] = { 23, 1 },
+	[201] = { 24, 1 },
+	[202] = { 25, 1 },
+	[203] = { 26, 1 },
+	[204] = { 27, 1 },
+	[205] = { 28, 1 },
+	[206] = { 29, 1 },
+	[207] = { 30, 1 },
+	[208] = { 31, 1 },
+	[209] = { 32, 1 },
+	[210] = { 33, 2 },
+	[211] = { 35, 1 },
+	[212] = { 36, 1 },
+	[213] = { 37, 1 },
+	[214] = { 38, 2 },
+	[215] = { 40, 1 },
+	[216] = { 41, 1 },
+	[217] = { 42, 2 },
+	[218] = { 44, 1 },
+	[219] = { 45, 1 },
+	[220] = { 46, 2 },
+	[221] = { 48, 1 },
+	[222] = { 49, 3 },
+	[223] = { 52, 2 },
+	[224] = { 54, 2 },
+	[225] = { 56, 2 },
+	[226] = { 58, 2 },
+	[227] = { 60, 2 },
+	[228] = { 62, 1 },
+	[231] = { 63, 1 },
+	[232] = { 64, 2 },
+	[233] = { 66, 1 },
+	[234] = { 67, 1 },
+	[235] = { 68, 1 },
+	[236] = { 69, 1 },
+	[237] = { 70, 1 },
+	[238] = { 71, 1 },
+	[239] = { 72, 1 },
+	[240] = { 73, 2 },
+	[241] = { 75, 1 },
+	[242] = { 76, 1 },
+	[243] = { 77, 1 },
+	[244] = { 78, 1 },
+	[245] = { 79, 1 },
+	[246] = { 80, 3 },
+	[247] = { 83, 3 },
+	[248] = { 86, 2 },
+	[249] = { 88, 2 },
+	[250] = { 90, 2 },
+	[251] = { 92, 1 },
+	[252] = { 93, 1 },
+	[253] = { 94, 1 },
+	[254] = { 95, 1 },
+	[255] = { 96, 1 },
+	[256] = { 97, 1 },
+	[257] = { 98, 1 },
+	[258] = { 99, 1 },
+	[259] = { 100, 1 },
+	[261] = { 101, 1 },
+	[262] = { 102, 2 },
+	[263] = { 104, 1 },
+	[265] = { 105, 1 },
+	[266] = { 106, 1 },
+	[267] = { 107, 1 },
+	[268] = { 108, 1 },
+	[269] = { 109, 1 },
+	[270] = { 110, 1 },
+	[271] = { 111, 1 },
+	[272] = { 112, 1 },
+	[273] = { 113, 1 },
+	[274] = { 114, 2 },
+	[275] = { 116, 1 },
+	[276] = { 117, 1 },
+	[277] = { 118, 1 },
+	[278] = { 119, 1 },
+	[280] = { 120, 1 },
+	[281] = { 121, 2 },
+	[282] = { 123, 2 },
+	[283] = { 125, 2 },
+	[284] = { 127, 2 },
+	[285] = { 129, 3 },
+	[286] = { 132, 2 },
+	[287] = { 134, 2 },
+	[288] = { 136, 2 },
+	[289] = { 138, 2 },
+	[290] = { 140, 3 },
+	[291] = { 143, 3 },
+	[292] = { 146, 2 },
+	[293] = { 148, 2 },
+	[294] = { 150, 2 },
+	[295] = { 152, 2 },
+	[296] = { 154, 1 },
+	[299] = { 155, 1 },
+	[300] = { 156, 1 },
+	[301] = { 157, 1 },
+	[302] = { 158, 1 },
+	[303] = { 159, 1 },
+	[304] = { 160, 1 },
+	[305] = { 161, 1 },
+	[306] = { 162, 1 },
+	[307] = { 163, 3 },
+	[308] = { 166, 3 },
+	[309] = { 169, 4 },
+	[310] = { 173, 3 },
+	[311] = { 176, 1 },
+	[312] = { 177, 1 },
+	[313] = { 178, 1 },
+	[314] = { 179, 1 },
+	[315] = { 180, 1 },
+	[316] = { 181, 1 },
+	[317] = { 182, 1 },
+	[318] = { 183, 1 },
+	[319] = { 184, 1 },
+	[320] = { 185, 3 },
+	[321] = { 188, 1 },
+	[322] = { 189, 1 },
+	[323] = { 190, 1 },
+	[324] = { 191, 1 },
+	[325] = { 192, 2 },
+	[326] = { 194, 1 },
+	[327] = { 195, 1 },
+	[328] = { 196, 1 },
+	[329] = { 197, 1 },
+	[330] = { 198, 2 },
+	[331] = { 200, 1 },
+	[332] = { 201, 1 },
+	[333] = { 202, 1 },
+	[334] = { 203, 3 },
+	[335] = { 206, 1 },
+	[338] = { 207, 2 },
+	[339] = { 209, 1 },
+	[340] = { 210, 1 },
+	[341] = { 211, 1 },
+	[342] = { 212, 1 },
+	[345] = { 213, 1 },
+	[346] = { 214, 1 },
+	[347] = { 215, 1 },
+	[348] = { 216, 2 },
+	[349] = { 218, 2 },
+	[351] = { 220, 1 },
+	[352] = { 221, 1 },
+	[353] = { 222, 1 },
+	[354] = { 223, 1 },
+	[355] = { 224, 1 },
+	[357] = { 225, 1 },
+	[358] = { 226, 1 },
+	[359] = { 227, 1 },
+	[361] = { 228, 1 },
+	[362] = { 229, 1 },
+	[363] = { 230, 1 },
+	[364] = { 231, 1 },
+	[365] = { 232, 1 },
+	[366] = { 233, 1 },
+	[367] = { 234, 1 },
+	[368] = { 235, 1 },
+	[369] = { 236, 1 },
+	[371] = { 237, 1 },
+	[372] = { 238, 1 },
+	[373] = { 239, 1 },
+	[374] = { 240, 1 },
+	[375] = { 241, 1 },
+	[376] = { 242, 1 },
+	[377] = { 243, 2 },
+	[378] = { 245, 3 },
+	[379] = { 248, 2 },
+	[380] = { 250, 2 },
+	[381] = { 252, 1 },
+	[382] = { 253, 1 },
+	[383] = { 254, 1 },
+	[384] = { 255, 1 },
+	[385] = { 256, 1 },
+	[386] = { 257, 2 },
+	[387] = { 259, 2 },
+	[388] = { 261, 1 },
+	[389] = { 262, 1 },
+	[391] = { 263, 1 },
+	[392] = { 264, 1 },
+	[393] = { 265, 1 },
+	[394] = { 266, 1 },
+	[395] = { 267, 1 },
+	[396] = { 268, 1 },
+	[400] = { 269, 1 },
+	[401] = { 270, 1 },
+	[402] = { 271, 1 },
+	[403] = { 272, 1 },
+	[404] = { 273, 1 },
+	[405] = { 274, 1 },
+	[406] = { 275, 1 },
+	[407] = { 276, 1 },
+	[408] = { 277, 2 },
+	[409] = { 279, 1 },
+	[411] = { 280, 1 },
+	[412] = { 281, 1 },
+	[413] = { 282, 1 },
+	[414] = { 283, 1 },
+	[415] = { 284, 1 },
+	[416] = { 285, 2 },
+	[419] = { 287, 1 },
+	[421] = { 288, 1 },
+	[422] = { 289, 1 },
+	[423] = { 290, 1 },
+	[424] = { 291, 1 },
+	[425] = { 292, 1 },
+	[429] = { 293, 1 },
+	[430] = { 294, 1 },
+	[431] = { 295, 1 },
+	[432] = { 296, 1 },
+	[433] = { 297, 1 },
+	[434] = { 298, 2 },
+	[435] = { 300, 2 },
+	[436] = { 302, 1 },
+	[437] = { 303, 2 },
+	[438] = { 305, 3 },
+	[439] = { 308, 3 },
+	[440] = { 311, 1 },
+	[441] = { 312, 1 },
+	[442] = { 313, 1 },
+	[443] = { 314, 1 },
+	[444] = { 315, 1 },
+	[445] = { 316, 1 },
+	[446] = { 317, 1 },
+	[447] = { 318, 1 },
+	[449] = { 319, 1 },
+	[451] = { 320, 1 },
+	[452] = { 321, 1 },
+	[453] = { 322, 1 },
+	[455] = { 323, 1 },
+	[456] = { 324, 1 },
+	[457] = { 325, 1 },
+	[458] = { 326, 1 },
+	[459] = { 327, 1 },
+	[460] = { 328, 1 },
+	[461] = { 329, 1 },
+	[462] = { 330, 1 },
+	[463] = { 331, 1 },
+	[464] = { 332, 1 },
+	[465] = { 333, 1 },
+	[466] = { 334, 1 },
+	[467] = { 335, 1 },
+	[468] = { 336, 2 },
+	[469] = { 338, 1 },
+	[470] = { 339, 2 },
+	[471] = { 341, 1 },
+	[472] = { 342, 1 },
+	[473] = { 343, 1 },
+	[474] = { 344, 1 },
+	[475] = { 345, 1 },
+	[476] = { 346, 1 },
+	[477] = { 347, 3 },
+	[478] = { 350, 1 },
+	[479] = { 351, 2 },
+	[480] = { 353, 2 },
+	[481] = { 355, 1 },
+	[482] = { 356, 1 },
+	[483] = { 357, 1 },
+	[484] = { 358, 4 },
+	[485] = { 362, 4 },
+	[486] = { 366, 3 },
+	[487] = { 369, 2 },
+	[488] = { 371, 1 },
+	[489] = { 372, 2 },
+	[491] = { 374, 1 },
+	[492] = { 375, 1 },
+	[493] = { 376, 1 },
+	[494] = { 377, 1 },
+	[495] = { 378, 1 },
+	[496] = { 379, 1 },
+	[497] = { 380, 1 },
+	[498] = { 381, 1 },
+	[499] = { 382, 1 },
+	[501] = { 383, 1 },
+	[502] = { 384, 1 },
+	[503] = { 385, 2 },
+	[504] = { 387, 1 },
+	[511] = { 388, 1 },
+	[512] = { 389, 2 },
+	[513] = { 391, 2 },
+	[514] = { 393, 2 },
+	[515] = { 395, 1 },
+	[516] = { 396, 1 },
+	[517] = { 397, 1 },
+	[518] = { 398, 2 },
+	[519] = { 400, 2 },
+	[520] = { 402, 3 },
+	[521] = { 405, 1 },
+	[522] = { 406, 1 },
+	[523] = { 407, 1 },
+	[524] = { 408, 2 },
+	[525] = { 410, 1 },
+	[526] = { 411, 1 },
+	[550] = { 412, 1 },
+	[551] = { 413, 1 },
+	[552] = { 414, 1 },
+	[553] = { 415, 1 },
+	[600] = { 416, 1 },
+	[601] = { 417, 1 },
+	[602] = { 418, 1 },
+	[603] = { 419, 1 },
+	[604] = { 420, 1 },
+	[605] = { 421, 1 },
+	[606] = { 422, 1 },
+	[607] = { 423, 1 },
+	[608] = { 424, 1 },
+	[610] = { 425, 2 },
+	[611] = { 427, 1 },
+	[612] = { 428, 1 },
+	[613] = { 429, 1 },
+	[615] = { 430, 2 },
+	[616] = { 432, 1 },
+	[617] = { 433, 2 },
+	[618] = { 435, 1 },
+	[619] = { 436, 2 },
+	[620] = { 438, 2 },
+	[621] = { 440, 1 },
+	[622] = { 441, 1 },
+	[623] = { 442, 1 },
+	[624] = { 443, 1 },
+	[625] = { 444, 1 },
+	[626] = { 445, 1 },
+	[630] = { 446, 1 },
+	[631] = { 447, 1 },
+	[640] = { 448, 1 },
+	[641] = { 449, 1 },
+	[642] = { 450, 1 },
+	[660] = { 451, 1 },
+	[661] = { 452, 1 },
+	[662] = { 453, 1 },
+	[663] = { 454, 1 },
+	[664] = { 455, 1 },
+	[665] = { 456, 1 },
+	[666] = { 457, 1 },
+	[670] = { 458, 1 },
+	[671] = { 459, 1 },
+	[672] = { 460, 1 },
+	[673] = { 461, 1 },
+	[678] = { 462, 1 },
+	[679] = { 463, 1 },
+	[682] = { 464, 1 },
+	[687] = { 465, 1 },
+	[688] = { 466, 1 },
+	[689] = { 467, 1 },
+	[690] = { 468, 1 },
+	[702] = { 469, 1 },
+	[703] = { 470, 1 },
+	[704] = { 471, 1 },
+	[705] = { 472, 1 },
+	[706] = { 473, 1 },
+	[708] = { 474, 1 },
+	[709] = { 475, 1 },
+	[710] = { 476, 1 },
+	[711] = { 477, 1 },
+	[712] = { 478, 1 },
+	[713] = { 479, 1 },
+	[714] = { 480, 1 },
+	[715] = { 481, 1 },
+	[716] = { 482, 1 },
+	[717] = { 483, 1 },
+	[718] = { 484, 1 },
+	[720] = { 485, 1 },
+	[721] = { 486, 1 },
+	[722] = { 487, 1 },
+	[723] = { 488, 1 },
+	[724] = { 489, 1 },
+	[725] = { 490, 1 },
+	[726] = { 491, 1 },
+	[771] = { 492, 1 },
+	[773] = { 493, 1 },
+	[774] = { 494, 1 },
+	[972] = { 495, 1 },
+	[973] = { 496, 1 },
+	[974] = { 497, 1 },
+	[975] = { 498, 1 },
+	[976] = { 499, 1 },
+	[977] = { 500, 1 },
+	[979] = { 501, 1 },
+	[980] = { 502, 1 },
+	[981] = { 503, 1 },
+	[982] = { 504, 1 },
+	[983] = { 505, 1 },
+	[999] = { 506, 2 },
+};
+
+/******************************/
+#pragma mark - Lookup functions
+/******************************/
+
+/**	Returns the number of known names for the given numeric code.
+ */
+static inline NSUInteger IRCClientNumericNameCount(NSUInteger code) {
+	if (code >= IRCClientNumericCodeCount)
+		return 0;
+
+	return IRCClientNumericsTable[code].nameCount;
+}
+
+/**	Returns the index’th known name for the given numeric code (as a
+	statically allocated C string), or NULL if there is no such name.
+ */
+static inline const char *IRCClientNumericNameAtIndex(NSUInteger code,
+													   NSUInteger index) {
+	if (index >= IRCClientNumericNameCount(code))
+		return NULL;
+
+	return IRCClientNumericNamePool + IRCClientNumericNameOffsets[IRCClientNumericsTable[code].firstName + index];
+}
+
+/**	Returns the first (usually the standard) known name for the given
+	numeric code, or NULL if the code is not a known one.
+ */
+static inline const char *IRCClientNumericName(NSUInteger code) {
+	return IRCClientNumericNameAtIndex(code, 0);
+}
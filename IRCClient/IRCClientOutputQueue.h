@@ -0,0 +1,121 @@
+//
+//	IRCClientOutputQueue.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+#import <sys/uio.h>
+
+/*	NOTE: This header is for the framework’s internal use only.
+ */
+
+/*****************************************/
+#pragma mark IRCClientOutputSegment struct
+/*****************************************/
+
+/**	Segments of up to this capacity (enough for any IRC message, including
+	the CRLF) are recycled by the queue instead of being freed.
+ */
+#define IRCClientOutputSegmentStandardCapacity 512
+
+/** @struct IRCClientOutputSegment
+ *	@brief One queued outbound message (owned by the queue once appended).
+ */
+typedef struct IRCClientOutputSegment {
+	struct IRCClientOutputSegment *next;
+	NSUInteger length;
+	NSUInteger capacity;
+
+	/** When the message was queued (set by the scheduler; see
+		IRCClientOutputScheduler.h). */
+	uint64_t timestamp;
+
+	uint8_t bytes[];
+} IRCClientOutputSegment;
+
+/*****************************************/
+#pragma mark - IRCClientOutputQueue struct
+/*****************************************/
+
+/** @struct IRCClientOutputQueue
+ *	@brief FIFO list of outbound messages.
+ *
+ *	Messages are written out from the head of the list; a partially written
+ *	head segment is tracked with an offset (nothing is ever moved). Written
+ *	segments of the standard capacity go onto a free list and are reused, so
+ *	that a steady stream of messages doesn’t allocate.
+ *
+ *	A zero-filled IRCClientOutputQueue is a valid, empty queue.
+ */
+typedef struct {
+	IRCClientOutputSegment *head;
+	IRCClientOutputSegment *tail;
+
+	/** Number of bytes of the head segment that have already been written. */
+	NSUInteger headOffset;
+
+	/** Number of bytes queued (and not yet written). */
+	NSUInteger bytesQueued;
+
+	/** The largest value bytesQueued has reached. */
+	NSUInteger highWaterMark;
+
+	IRCClientOutputSegment *freeSegments;
+	NSUInteger freeSegmentCount;
+} IRCClientOutputQueue;
+
+/*********************************/
+#pragma mark - Function prototypes
+/*********************************/
+
+/**	Frees all queued (and recycled) segments, and resets the queue to empty.
+	(The high water mark is kept.)
+ */
+void IRCClientOutputQueueFree(IRCClientOutputQueue *queue);
+
+/**	Returns a segment with at least the given capacity (and a length of 0),
+	to be filled in and then appended with IRCClientOutputQueueAppendSegment().
+
+	The segment is taken from the queue’s free list, if possible. Pass NULL for
+	the queue to allocate a new segment without touching the queue (e.g., when
+	not on the thread or queue that owns the output queue). Returns NULL if a
+	new segment can’t be allocated.
+ */
+IRCClientOutputSegment *IRCClientOutputQueueCreateSegment(IRCClientOutputQueue *queue,
+														  NSUInteger capacity);
+
+/**	Appends a segment (as returned by IRCClientOutputQueueCreateSegment()) to
+	the end of the queue. The queue takes ownership of the segment.
+ */
+void IRCClientOutputQueueAppendSegment(IRCClientOutputQueue *queue,
+									   IRCClientOutputSegment *segment);
+
+/**	Frees a chain of segments (linked by their next pointers) that hasn’t
+	been appended to a queue (e.g., one that couldn’t be finished).
+ */
+void IRCClientOutputQueueFreeSegments(IRCClientOutputSegment *segments);
+
+/**	Fills in up to maxCount iovecs describing the queued bytes, in order,
+	starting with the unwritten part of the head segment. Returns the number
+	of iovecs filled in.
+ */
+int IRCClientOutputQueueGetIOVecs(const IRCClientOutputQueue *queue,
+								  struct iovec *iov,
+								  int maxCount);
+
+/**	Copies up to capacity queued bytes (in order) into the given buffer,
+	without consuming them. Returns the number of bytes copied.
+ */
+NSUInteger IRCClientOutputQueueGather(const IRCClientOutputQueue *queue,
+									  uint8_t *buffer,
+									  NSUInteger capacity);
+
+/**	Marks count bytes (from the head of the queue) as written; completely
+	written segments are released.
+ */
+void IRCClientOutputQueueConsume(IRCClientOutputQueue *queue,
+								 NSUInteger count);
@@ -0,0 +1,150 @@
+//
+//	IRCClientOutputQueue.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientOutputQueue.h"
+
+/******************************/
+#pragma mark - Static variables
+/******************************/
+
+// Keep at most this many written segments around for reuse.
+static const NSUInteger IRCClientOutputQueueMaxFreeSegments = 64;
+
+/******************************/
+#pragma mark - Helper functions
+/******************************/
+
+static void IRCClientOutputQueueReleaseSegment(IRCClientOutputQueue *queue,
+											   IRCClientOutputSegment *segment) {
+	if (   segment->capacity == IRCClientOutputSegmentStandardCapacity
+		&& queue->freeSegmentCount < IRCClientOutputQueueMaxFreeSegments) {
+		segment->next = queue->freeSegments;
+		queue->freeSegments = segment;
+		queue->freeSegmentCount++;
+	} else {
+		free(segment);
+	}
+}
+
+/**************************************/
+#pragma mark - Function implementations
+/**************************************/
+
+void IRCClientOutputQueueFree(IRCClientOutputQueue *queue) {
+	IRCClientOutputQueueFreeSegments(queue->head);
+	IRCClientOutputQueueFreeSegments(queue->freeSegments);
+
+	queue->head = NULL;
+	queue->tail = NULL;
+	queue->headOffset = 0;
+	queue->bytesQueued = 0;
+	queue->freeSegments = NULL;
+	queue->freeSegmentCount = 0;
+}
+
+IRCClientOutputSegment *IRCClientOutputQueueCreateSegment(IRCClientOutputQueue *queue,
+														  NSUInteger capacity) {
+	IRCClientOutputSegment *segment;
+	if (   queue != NULL
+		&& capacity <= IRCClientOutputSegmentStandardCapacity
+		&& queue->freeSegments != NULL) {
+		segment = queue->freeSegments;
+		queue->freeSegments = segment->next;
+		queue->freeSegmentCount--;
+	} else {
+		capacity = MAX(capacity, IRCClientOutputSegmentStandardCapacity);
+		segment = malloc(sizeof(IRCClientOutputSegment) + capacity);
+		if (segment == NULL)
+			return NULL;
+		segment->capacity = capacity;
+	}
+
+	segment->next = NULL;
+	segment->length = 0;
+
+	return segment;
+}
+
+void IRCClientOutputQueueAppendSegment(IRCClientOutputQueue *queue,
+									   IRCClientOutputSegment *segment) {
+	segment->next = NULL;
+	if (queue->tail != NULL)
+		queue->tail->next = segment;
+	else
+		queue->head = segment;
+	queue->tail = segment;
+
+	queue->bytesQueued += segment->length;
+	if (queue->bytesQueued > queue->highWaterMark)
+		queue->highWaterMark = queue->bytesQueued;
+}
+
+void IRCClientOutputQueueFreeSegments(IRCClientOutputSegment *segments) {
+	while (segments != NULL) {
+		IRCClientOutputSegment *next = segments->next;
+		free(segments);
+		segments = next;
+	}
+}
+
+int IRCClientOutputQueueGetIOVecs(const IRCClientOutputQueue *queue,
+								  struct iovec *iov,
+								  int maxCount) {
+	int count = 0;
+	NSUInteger offset = queue->headOffset;
+	for (IRCClientOutputSegment *segment = queue->head;
+		 segment != NULL && count < maxCount;
+		 segment = segment->next) {
+		iov[count].iov_base = segment->bytes + offset;
+		iov[count].iov_len = segment->length - offset;
+		count++;
+		offset = 0;
+	}
+
+	return count;
+}
+
+NSUInteger IRCClientOutputQueueGather(const IRCClientOutputQueue *queue,
+									  uint8_t *buffer,
+									  NSUInteger capacity) {
+	NSUInteger gathered = 0;
+	NSUInteger offset = queue->headOffset;
+	for (IRCClientOutputSegment *segment = queue->head;
+		 segment != NULL && gathered < capacity;
+		 segment = segment->next) {
+		NSUInteger count = MIN(segment->length - offset, capacity - gathered);
+		memcpy(buffer + gathered, segment->bytes + offset, count);
+		gathered += count;
+		offset = 0;
+	}
+
+	return gathered;
+}
+
+void IRCClientOutputQueueConsume(IRCClientOutputQueue *queue,
+								 NSUInteger count) {
+	queue->bytesQueued -= count;
+
+	while (count > 0) {
+		IRCClientOutputSegment *segment = queue->head;
+		NSUInteger remaining = segment->length - queue->headOffset;
+		if (count < remaining) {
+			queue->headOffset += count;
+			break;
+		}
+
+		count -= remaining;
+		queue->head = segment->next;
+		if (queue->head == NULL)
+			queue->tail = NULL;
+		queue->headOffset = 0;
+
+		IRCClientOutputQueueReleaseSegment(queue, segment);
+	}
+}
@@ -0,0 +1,159 @@
+//
+//	IRCClientOutputScheduler.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+#import "IRCClientOutputQueue.h"
+
+/*	NOTE: This header is for the framework’s internal use only.
+ */
+
+/***********************************/
+#pragma mark IRCClientOutputPriority
+/***********************************/
+
+/**	Outbound messages are sent in order of priority class (and, within a
+	class, in the order they were queued; but see IRCClientOutputScheduler).
+ */
+typedef NS_ENUM(uint8_t, IRCClientOutputPriority) {
+	/** PONG and QUIT, and (while registering) PASS, CAP, AUTHENTICATE, NICK,
+		and USER; these are never held back by flood control. */
+	IRCClientOutputPriorityUrgent,
+
+	/** Every other command (JOIN, MODE, NICK, WHO, etc.). */
+	IRCClientOutputPriorityControl,
+
+	/** PRIVMSG and NOTICE (including CTCP). */
+	IRCClientOutputPriorityUser
+};
+
+/*********************************************/
+#pragma mark - IRCClientOutputScheduler struct
+/*********************************************/
+
+/** @struct IRCClientOutputList
+ *	@brief A FIFO list of queued messages.
+ */
+typedef struct {
+	IRCClientOutputSegment *head;
+	IRCClientOutputSegment *tail;
+} IRCClientOutputList;
+
+/** @struct IRCClientOutputLane
+ *	@brief The queued user messages to one target.
+ */
+typedef struct IRCClientOutputLane {
+	/** Hash of the (case-folded) target. */
+	uint64_t target;
+
+	IRCClientOutputList messages;
+
+	/** Next lane in the round-robin ring. */
+	struct IRCClientOutputLane *next;
+} IRCClientOutputLane;
+
+/** @struct IRCClientOutputScheduler
+ *	@brief Token bucket flood control, with priority classes.
+ *
+ *	Messages are held here until flood control allows them to be sent, and are
+ *	then released (to be appended to the output queue) in priority order:
+ *	urgent messages first, then control messages, then user messages. User
+ *	messages are queued per target, and released round-robin across targets,
+ *	one message at a time, so that one busy target can’t starve the others.
+ *
+ *	Each message sent costs one token; tokens are added at a rate of one per
+ *	interval, up to a maximum of burst tokens. (The bucket is kept as “credit”,
+ *	in nanoseconds; a token is worth one interval.) Urgent messages are sent
+ *	even if there are no tokens (and may drive the credit negative); while
+ *	registering, they cost nothing, so that the registration handshake (which
+ *	may be longer than the burst, with SASL) neither waits nor leaves the
+ *	bucket empty.
+ *
+ *	A zero-filled IRCClientOutputScheduler is a valid, empty scheduler, with
+ *	flood control disabled.
+ */
+typedef struct {
+	IRCClientOutputList urgent;
+	IRCClientOutputList control;
+
+	/** Open-addressed hash table of lanes with queued messages (keyed by
+		target hash); laneCapacity is 0 or a power of 2. */
+	IRCClientOutputLane **lanes;
+	NSUInteger laneCapacity;
+	NSUInteger laneCount;
+
+	/** The lane that was served last; its next lane is served next. */
+	IRCClientOutputLane *lastLane;
+
+	/** Maximum number of tokens (0 means no flood control). */
+	NSUInteger burst;
+
+	/** Nanoseconds per token (0 means no flood control). */
+	uint64_t interval;
+
+	int64_t credit;
+	uint64_t lastRefill;
+
+	/** YES from connecting until registration is complete (RPL_WELCOME). */
+	BOOL registering;
+
+	/** Number of messages (and bytes) held by the scheduler. */
+	NSUInteger messagesQueued;
+	NSUInteger bytesQueued;
+
+	/** Time (in nanoseconds) that the most recently released message spent in
+		the scheduler, and the longest time that any message has spent. */
+	uint64_t lastDelay;
+	uint64_t maxDelay;
+} IRCClientOutputScheduler;
+
+/*********************************/
+#pragma mark - Function prototypes
+/*********************************/
+
+/**	Sets the bucket parameters (a burst or interval of 0 disables flood
+	control). The current credit is clamped to the new maximum
+	(or, if flood control was disabled, the bucket is filled).
+ */
+void IRCClientOutputSchedulerConfigure(IRCClientOutputScheduler *scheduler,
+									   NSUInteger burst,
+									   uint64_t interval,
+									   uint64_t now);
+
+/**	Fills the bucket (e.g., on connect).
+ */
+void IRCClientOutputSchedulerRefill(IRCClientOutputScheduler *scheduler,
+									uint64_t now);
+
+/**	Frees all held messages (and lanes). Bucket parameters and delay metrics
+	are kept.
+ */
+void IRCClientOutputSchedulerFree(IRCClientOutputScheduler *scheduler);
+
+/**	Returns the priority class of a (serialized) message (given whether the
+	connection is registering); for user messages, also returns the hash of
+	the (case-folded) target in *target.
+ */
+IRCClientOutputPriority IRCClientOutputSchedulerClassify(const IRCClientOutputSegment *segment,
+														 BOOL registering,
+														 uint64_t *target);
+
+/**	Queues a message. The scheduler takes ownership of the segment.
+ */
+void IRCClientOutputSchedulerEnqueue(IRCClientOutputScheduler *scheduler,
+									 IRCClientOutputSegment *segment,
+									 uint64_t now);
+
+/**	Returns the next message that flood control allows to be sent now (the
+	caller takes ownership of the segment), or NULL if there is none. In the
+	latter case, *wait is set to the number of nanoseconds until the next
+	message may be sent (or to UINT64_MAX if the scheduler is empty).
+ */
+IRCClientOutputSegment *IRCClientOutputSchedulerDequeue(IRCClientOutputScheduler *scheduler,
+														uint64_t now,
+														uint64_t *wait);
@@ -0,0 +1,336 @@
+//
+//	IRCClientOutputScheduler.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientOutputScheduler.h"
+
+/******************************/
+#pragma mark - Helper functions
+/******************************/
+
+static void IRCClientOutputListAppend(IRCClientOutputList *list,
+									  IRCClientOutputSegment *segment) {
+	segment->next = NULL;
+	if (list->tail != NULL)
+		list->tail->next = segment;
+	else
+		list->head = segment;
+	list->tail = segment;
+}
+
+static IRCClientOutputSegment *IRCClientOutputListRemoveFirst(IRCClientOutputList *list) {
+	IRCClientOutputSegment *segment = list->head;
+	list->head = segment->next;
+	if (list->head == NULL)
+		list->tail = NULL;
+	segment->next = NULL;
+
+	return segment;
+}
+
+static void IRCClientOutputListFree(IRCClientOutputList *list) {
+	IRCClientOutputSegment *segment = list->head;
+	while (segment != NULL) {
+		IRCClientOutputSegment *next = segment->next;
+		free(segment);
+		segment = next;
+	}
+	list->head = NULL;
+	list->tail = NULL;
+}
+
+static BOOL IRCClientOutputSchedulerIsLimited(const IRCClientOutputScheduler *scheduler) {
+	return (   scheduler->burst > 0
+			&& scheduler->interval > 0);
+}
+
+static void IRCClientOutputSchedulerUpdateCredit(IRCClientOutputScheduler *scheduler,
+												 uint64_t now) {
+	if (now > scheduler->lastRefill) {
+		int64_t maxCredit = (int64_t) (scheduler->burst * scheduler->interval);
+		scheduler->credit = MIN(maxCredit,
+								scheduler->credit + (int64_t) (now - scheduler->lastRefill));
+	}
+	scheduler->lastRefill = now;
+}
+
+// Case-folded (ASCII) FNV-1a; “#Channel” and “#channel” share a lane.
+static uint64_t IRCClientOutputTargetHash(const uint8_t *bytes,
+										  NSUInteger length) {
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (NSUInteger i = 0; i < length; i++) {
+		uint8_t byte = bytes[i];
+		if (byte >= 'A' && byte <= 'Z')
+			byte += ('a' - 'A');
+		hash ^= byte;
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+/*****************************/
+#pragma mark - Lane hash table
+/*****************************/
+
+static NSUInteger IRCClientOutputLaneSlot(const IRCClientOutputScheduler *scheduler,
+										  uint64_t target) {
+	NSUInteger mask = scheduler->laneCapacity - 1;
+	NSUInteger slot = (NSUInteger) target & mask;
+	while (   scheduler->lanes[slot] != NULL
+		   && scheduler->lanes[slot]->target != target)
+		slot = (slot + 1) & mask;
+
+	return slot;
+}
+
+static void IRCClientOutputLanesGrow(IRCClientOutputScheduler *scheduler) {
+	IRCClientOutputLane **oldLanes = scheduler->lanes;
+	NSUInteger oldCapacity = scheduler->laneCapacity;
+
+	scheduler->laneCapacity = (oldCapacity > 0 ? oldCapacity * 2 : 16);
+	scheduler->lanes = calloc(scheduler->laneCapacity, sizeof(IRCClientOutputLane *));
+
+	for (NSUInteger i = 0; i < oldCapacity; i++) {
+		if (oldLanes[i] != NULL)
+			scheduler->lanes[IRCClientOutputLaneSlot(scheduler, oldLanes[i]->target)] = oldLanes[i];
+	}
+	free(oldLanes);
+}
+
+static void IRCClientOutputLanesRemove(IRCClientOutputScheduler *scheduler,
+									   IRCClientOutputLane *lane) {
+	NSUInteger mask = scheduler->laneCapacity - 1;
+	NSUInteger hole = IRCClientOutputLaneSlot(scheduler, lane->target);
+	scheduler->lanes[hole] = NULL;
+	scheduler->laneCount--;
+
+	// Shift back any following entries that would no longer be reachable
+	// from their home slot across the hole.
+	NSUInteger slot = hole;
+	for (;;) {
+		slot = (slot + 1) & mask;
+		IRCClientOutputLane *entry = scheduler->lanes[slot];
+		if (entry == NULL)
+			break;
+
+		NSUInteger home = (NSUInteger) entry->target & mask;
+		BOOL reachable = (hole <= slot
+						  ? (home > hole && home <= slot)
+						  : (home > hole || home <= slot));
+		if (reachable)
+			continue;
+
+		scheduler->lanes[hole] = entry;
+		scheduler->lanes[slot] = NULL;
+		hole = slot;
+	}
+}
+
+/**************************************/
+#pragma mark - Function implementations
+/**************************************/
+
+void IRCClientOutputSchedulerConfigure(IRCClientOutputScheduler *scheduler,
+									   NSUInteger burst,
+									   uint64_t interval,
+									   uint64_t now) {
+	BOOL wasLimited = IRCClientOutputSchedulerIsLimited(scheduler);
+	if (wasLimited)
+		IRCClientOutputSchedulerUpdateCredit(scheduler, now);
+
+	scheduler->burst = burst;
+	scheduler->interval = interval;
+
+	// If flood control was off, start with a full bucket.
+	if (wasLimited)
+		scheduler->credit = MIN(scheduler->credit,
+								(int64_t) (burst * interval));
+	else
+		scheduler->credit = (int64_t) (burst * interval);
+	scheduler->lastRefill = now;
+}
+
+void IRCClientOutputSchedulerRefill(IRCClientOutputScheduler *scheduler,
+									uint64_t now) {
+	scheduler->credit = (int64_t) (scheduler->burst * scheduler->interval);
+	scheduler->lastRefill = now;
+}
+
+void IRCClientOutputSchedulerFree(IRCClientOutputScheduler *scheduler) {
+	IRCClientOutputListFree(&scheduler->urgent);
+	IRCClientOutputListFree(&scheduler->control);
+
+	for (NSUInteger i = 0; i < scheduler->laneCapacity; i++) {
+		IRCClientOutputLane *lane = scheduler->lanes[i];
+		if (lane == NULL)
+			continue;
+
+		IRCClientOutputListFree(&lane->messages);
+		free(lane);
+	}
+	free(scheduler->lanes);
+
+	scheduler->lanes = NULL;
+	scheduler->laneCapacity = 0;
+	scheduler->laneCount = 0;
+	scheduler->lastLane = NULL;
+
+	scheduler->messagesQueued = 0;
+	scheduler->bytesQueued = 0;
+}
+
+IRCClientOutputPriority IRCClientOutputSchedulerClassify(const IRCClientOutputSegment *segment,
+														 BOOL registering,
+														 uint64_t *target) {
+	const uint8_t *bytes = segment->bytes;
+	const uint8_t *end = bytes + segment->length;
+
+	// Skip the prefix, if any (only sendRaw: would produce one).
+	if (   bytes < end
+		&& *bytes == ':') {
+		while (bytes < end && *bytes != ' ')
+			bytes++;
+		while (bytes < end && *bytes == ' ')
+			bytes++;
+	}
+
+	const uint8_t *command = bytes;
+	while (bytes < end && *bytes != ' ' && *bytes != '\r')
+		bytes++;
+	NSUInteger commandLength = (NSUInteger) (bytes - command);
+
+	if (   (commandLength == 4 && strncasecmp((const char *) command, "PONG", 4) == 0)
+		|| (commandLength == 4 && strncasecmp((const char *) command, "QUIT", 4) == 0))
+		return IRCClientOutputPriorityUrgent;
+
+	// (The registration handshake is sent at once; see
+	// IRCClientOutputScheduler.)
+	if (   registering
+		&& (   (commandLength == 4 && strncasecmp((const char *) command, "PASS", 4) == 0)
+			|| (commandLength == 3 && strncasecmp((const char *) command, "CAP", 3) == 0)
+			|| (commandLength == 12 && strncasecmp((const char *) command, "AUTHENTICATE", 12) == 0)
+			|| (commandLength == 4 && strncasecmp((const char *) command, "NICK", 4) == 0)
+			|| (commandLength == 4 && strncasecmp((const char *) command, "USER", 4) == 0)))
+		return IRCClientOutputPriorityUrgent;
+
+	if (  !(commandLength == 7 && strncasecmp((const char *) command, "PRIVMSG", 7) == 0)
+		&& !(commandLength == 6 && strncasecmp((const char *) command, "NOTICE", 6) == 0))
+		return IRCClientOutputPriorityControl;
+
+	while (bytes < end && *bytes == ' ')
+		bytes++;
+	const uint8_t *targetBytes = bytes;
+	while (bytes < end && *bytes != ' ' && *bytes != '\r')
+		bytes++;
+	*target = IRCClientOutputTargetHash(targetBytes,
+										(NSUInteger) (bytes - targetBytes));
+
+	return IRCClientOutputPriorityUser;
+}
+
+void IRCClientOutputSchedulerEnqueue(IRCClientOutputScheduler *scheduler,
+									 IRCClientOutputSegment *segment,
+									 uint64_t now) {
+	segment->timestamp = now;
+	scheduler->messagesQueued++;
+	scheduler->bytesQueued += segment->length;
+
+	uint64_t target = 0;
+	switch (IRCClientOutputSchedulerClassify(segment, scheduler->registering, &target)) {
+		case IRCClientOutputPriorityUrgent: {
+			IRCClientOutputListAppend(&scheduler->urgent, segment);
+
+			break;
+		}
+		case IRCClientOutputPriorityControl: {
+			IRCClientOutputListAppend(&scheduler->control, segment);
+
+			break;
+		}
+		case IRCClientOutputPriorityUser: {
+			if ((scheduler->laneCount + 1) * 2 > scheduler->laneCapacity)
+				IRCClientOutputLanesGrow(scheduler);
+
+			NSUInteger slot = IRCClientOutputLaneSlot(scheduler, target);
+			IRCClientOutputLane *lane = scheduler->lanes[slot];
+			if (lane == NULL) {
+				lane = calloc(1, sizeof(IRCClientOutputLane));
+				lane->target = target;
+				scheduler->lanes[slot] = lane;
+				scheduler->laneCount++;
+
+				// A new lane goes at the end of the current round.
+				if (scheduler->lastLane != NULL) {
+					lane->next = scheduler->lastLane->next;
+					scheduler->lastLane->next = lane;
+				} else {
+					lane->next = lane;
+				}
+				scheduler->lastLane = lane;
+			}
+
+			IRCClientOutputListAppend(&lane->messages, segment);
+
+			break;
+		}
+	}
+}
+
+IRCClientOutputSegment *IRCClientOutputSchedulerDequeue(IRCClientOutputScheduler *scheduler,
+														uint64_t now,
+														uint64_t *wait) {
+	if (scheduler->messagesQueued == 0) {
+		*wait = UINT64_MAX;
+		return NULL;
+	}
+
+	BOOL limited = IRCClientOutputSchedulerIsLimited(scheduler);
+	if (limited)
+		IRCClientOutputSchedulerUpdateCredit(scheduler, now);
+
+	IRCClientOutputSegment *segment;
+	BOOL charged = limited;
+	if (scheduler->urgent.head != NULL) {
+		segment = IRCClientOutputListRemoveFirst(&scheduler->urgent);
+		charged = (limited && !scheduler->registering);
+	} else if (   limited
+			   && scheduler->credit < (int64_t) scheduler->interval) {
+		*wait = (uint64_t) ((int64_t) scheduler->interval - scheduler->credit);
+		return NULL;
+	} else if (scheduler->control.head != NULL) {
+		segment = IRCClientOutputListRemoveFirst(&scheduler->control);
+	} else {
+		IRCClientOutputLane *lane = scheduler->lastLane->next;
+
+		segment = IRCClientOutputListRemoveFirst(&lane->messages);
+		if (lane->messages.head == NULL) {
+			// The lane is empty; take it out of the ring.
+			if (lane == scheduler->lastLane)
+				scheduler->lastLane = NULL;
+			else
+				scheduler->lastLane->next = lane->next;
+
+			IRCClientOutputLanesRemove(scheduler, lane);
+			free(lane);
+		} else {
+			scheduler->lastLane = lane;
+		}
+	}
+
+	if (charged)
+		scheduler->credit -= (int64_t) scheduler->interval;
+
+	scheduler->messagesQueued--;
+	scheduler->bytesQueued -= segment->length;
+
+	scheduler->lastDelay = (now > segment->timestamp ? now - segment->timestamp : 0);
+	scheduler->maxDelay = MAX(scheduler->maxDelay, scheduler->lastDelay);
+
+	return segment;
+}
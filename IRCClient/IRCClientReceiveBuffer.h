@@ -0,0 +1,95 @@
+//
+//	IRCClientReceiveBuffer.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+
+/*	NOTE: This header is for the framework’s internal use only.
+ */
+
+/*****************************************/
+#pragma mark IRCClientReceiveBuffer struct
+/*****************************************/
+
+/** @struct IRCClientReceiveBuffer
+ *	@brief Compacting buffer for inbound data, framed into CRLF-terminated lines.
+ *
+ *	Bytes are read from the stream directly into the free space at the end of
+ *	the buffer. Complete lines are consumed by advancing the read offset (no
+ *	bytes are moved); the search for the next line terminator resumes from
+ *	where the previous search stopped. The (partial) unconsumed tail is moved
+ *	to the front only when the free space at the end runs low, so each
+ *	received byte is scanned once and moved at most once.
+ *
+ *	A line longer than lineLimit is dropped (as it comes in, so that it isn’t
+ *	held in the buffer), which bounds the buffer’s size.
+ */
+typedef struct {
+	uint8_t *bytes;
+	NSUInteger capacity;
+
+	/** Offset of the first unconsumed byte. */
+	NSUInteger start;
+
+	/** Offset one past the last byte written. */
+	NSUInteger end;
+
+	/** Offset up to which [start, scanned) is known to hold no terminator. */
+	NSUInteger scanned;
+
+	/** The longest line (including the CRLF) to keep (0 means no limit). */
+	NSUInteger lineLimit;
+
+	/** YES while the rest of an over-long line is being dropped. */
+	BOOL discarding;
+
+	/** Number of over-long lines dropped. */
+	NSUInteger linesDropped;
+} IRCClientReceiveBuffer;
+
+/*********************************/
+#pragma mark - Function prototypes
+/*********************************/
+
+/**	Allocates storage for the buffer (with the given initial capacity), and
+	resets the line limit.
+ */
+void IRCClientReceiveBufferInit(IRCClientReceiveBuffer *buffer,
+								NSUInteger capacity);
+
+/**	Frees the buffer’s storage and resets all offsets.
+ */
+void IRCClientReceiveBufferFree(IRCClientReceiveBuffer *buffer);
+
+/**	Returns a pointer to the free space at the end of the buffer, compacting
+	or growing the buffer first if the free space is too small to be worth a
+	read. The amount of free space is returned in *available.
+
+	Returns NULL if the buffer couldn’t be grown (in which case its contents
+	are lost).
+ */
+uint8_t *IRCClientReceiveBufferPrepareWrite(IRCClientReceiveBuffer *buffer,
+											NSUInteger *available);
+
+/**	Marks count bytes (written into the space returned by
+	IRCClientReceiveBufferPrepareWrite()) as received.
+ */
+void IRCClientReceiveBufferCommitWrite(IRCClientReceiveBuffer *buffer,
+									   NSUInteger count);
+
+/**	If the buffer contains a complete (CRLF-terminated) line, returns YES,
+	sets *line and *length to the line’s bytes (including the CRLF), and
+	consumes the line. The returned pointer is valid only until the next call
+	to IRCClientReceiveBufferPrepareWrite() or IRCClientReceiveBufferFree().
+
+	Returns NO if there is no complete line in the buffer. Lines longer than
+	the line limit are dropped (and counted in linesDropped).
+ */
+BOOL IRCClientReceiveBufferNextLine(IRCClientReceiveBuffer *buffer,
+									const uint8_t **line,
+									NSUInteger *length);
@@ -0,0 +1,146 @@
+//
+//	IRCClientReceiveBuffer.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientReceiveBuffer.h"
+
+/******************************/
+#pragma mark - Static variables
+/******************************/
+
+// Don’t bother issuing a read into less free space than this.
+static const NSUInteger IRCClientReceiveBufferMinimumReadSize = 4096;
+
+/**************************************/
+#pragma mark - Function implementations
+/**************************************/
+
+void IRCClientReceiveBufferInit(IRCClientReceiveBuffer *buffer,
+								NSUInteger capacity) {
+	buffer->bytes = malloc(capacity);
+	buffer->capacity = (buffer->bytes != NULL ? capacity : 0);
+	buffer->start = 0;
+	buffer->end = 0;
+	buffer->scanned = 0;
+	buffer->lineLimit = 0;
+	buffer->discarding = NO;
+	buffer->linesDropped = 0;
+}
+
+void IRCClientReceiveBufferFree(IRCClientReceiveBuffer *buffer) {
+	free(buffer->bytes);
+	buffer->bytes = NULL;
+	buffer->capacity = 0;
+	buffer->start = 0;
+	buffer->end = 0;
+	buffer->scanned = 0;
+	buffer->discarding = NO;
+}
+
+uint8_t *IRCClientReceiveBufferPrepareWrite(IRCClientReceiveBuffer *buffer,
+											NSUInteger *available) {
+	if (buffer->capacity - buffer->end < IRCClientReceiveBufferMinimumReadSize) {
+		// Move the unconsumed tail (at most one partial line) to the front.
+		NSUInteger unconsumed = buffer->end - buffer->start;
+		if (buffer->start > 0) {
+			memmove(buffer->bytes,
+					buffer->bytes + buffer->start,
+					unconsumed);
+			buffer->scanned -= buffer->start;
+			buffer->start = 0;
+			buffer->end = unconsumed;
+		}
+
+		// If that didn’t free up enough space, grow the buffer.
+		if (buffer->capacity - buffer->end < IRCClientReceiveBufferMinimumReadSize) {
+			NSUInteger newCapacity = MAX(buffer->capacity * 2,
+										 buffer->end + IRCClientReceiveBufferMinimumReadSize);
+			buffer->bytes = reallocf(buffer->bytes, newCapacity);
+			if (buffer->bytes == NULL) {
+				IRCClientReceiveBufferFree(buffer);
+				*available = 0;
+				return NULL;
+			}
+			buffer->capacity = newCapacity;
+		}
+	}
+
+	*available = buffer->capacity - buffer->end;
+	return buffer->bytes + buffer->end;
+}
+
+void IRCClientReceiveBufferCommitWrite(IRCClientReceiveBuffer *buffer,
+									   NSUInteger count) {
+	buffer->end += count;
+}
+
+BOOL IRCClientReceiveBufferNextLine(IRCClientReceiveBuffer *buffer,
+									const uint8_t **line,
+									NSUInteger *length) {
+	// Resume the search where the last one left off. A LF at position
+	// ‘scanned’ might complete a CRLF whose CR we’ve already scanned past,
+	// so we look for LFs and check the byte before each one.
+	NSUInteger searchStart = MAX(buffer->scanned, buffer->start);
+	while (searchStart < buffer->end) {
+		uint8_t *lf = memchr(buffer->bytes + searchStart,
+							 '\n',
+							 buffer->end - searchStart);
+		if (lf == NULL)
+			break;
+
+		NSUInteger lfOffset = (NSUInteger) (lf - buffer->bytes);
+		if (   buffer->discarding
+			|| (   lfOffset > buffer->start
+				&& buffer->bytes[lfOffset - 1] == '\r')) {
+			// (The CR of the tail of an over-long line may have been dropped
+			// already, so any LF ends it.)
+			BOOL drop = (   buffer->discarding
+						 || (   buffer->lineLimit > 0
+							 && lfOffset + 1 - buffer->start > buffer->lineLimit));
+			*line = buffer->bytes + buffer->start;
+			*length = lfOffset + 1 - buffer->start;
+
+			buffer->start = lfOffset + 1;
+			buffer->scanned = buffer->start;
+
+			// If the buffer is now empty, rewind it, for free.
+			if (buffer->start == buffer->end) {
+				buffer->start = 0;
+				buffer->end = 0;
+				buffer->scanned = 0;
+			}
+
+			if (drop) {
+				buffer->discarding = NO;
+				buffer->linesDropped++;
+				searchStart = buffer->start;
+				continue;
+			}
+
+			return YES;
+		}
+
+		// A bare LF; it’s part of the line, keep looking.
+		searchStart = lfOffset + 1;
+	}
+
+	// An unfinished line that’s already too long is dropped now, and the rest
+	// of it as it comes in.
+	if (   buffer->lineLimit > 0
+		&& (   buffer->discarding
+			|| buffer->end - buffer->start > buffer->lineLimit)) {
+		buffer->discarding = YES;
+		buffer->start = 0;
+		buffer->end = 0;
+		buffer->scanned = 0;
+		return NO;
+	}
+
+	buffer->scanned = buffer->end;
+	return NO;
+}
@@ -0,0 +1,124 @@
+//
+//	IRCClientReply.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+
+@class IRCClientEventBatch;
+
+/******************************/
+#pragma mark IRCClientReplyType
+/******************************/
+
+typedef NS_ENUM(NSUInteger, IRCClientReplyType) {
+	/**	The reply to NAMES: one row per channel member (see
+		IRCClientNamesColumn).
+	 */
+	IRCClientReplyNames = 0,
+	/**	The reply to WHO: one row per user (see IRCClientWhoColumn).
+	 */
+	IRCClientReplyWho,
+	/**	The reply to LIST: one row per channel (see IRCClientListColumn).
+	 */
+	IRCClientReplyList,
+	/**	The reply to CHATHISTORY: no rows; see -[IRCClientReply messages].
+	 */
+	IRCClientReplyHistory
+};
+
+/***************************/
+#pragma mark - Reply columns
+/***************************/
+
+typedef NS_ENUM(NSUInteger, IRCClientNamesColumn) {
+	/**	The member’s channel membership prefixes (e.g. "@"), if any.
+	 */
+	IRCClientNamesColumnPrefixes = 0,
+	IRCClientNamesColumnNick
+};
+
+typedef NS_ENUM(NSUInteger, IRCClientWhoColumn) {
+	/**	A channel that the user is on (or "*").
+	 */
+	IRCClientWhoColumnChannel = 0,
+	IRCClientWhoColumnUsername,
+	IRCClientWhoColumnHost,
+	IRCClientWhoColumnServer,
+	IRCClientWhoColumnNick,
+	/**	H (here) or G (gone, i.e. away), followed by flags such as * (IRC
+		operator) and the user’s prefix on the channel.
+	 */
+	IRCClientWhoColumnFlags,
+	IRCClientWhoColumnHopCount,
+	IRCClientWhoColumnRealname
+};
+
+typedef NS_ENUM(NSUInteger, IRCClientListColumn) {
+	IRCClientListColumnChannel = 0,
+	/**	The number of users on the channel (in decimal).
+	 */
+	IRCClientListColumnUsers,
+	IRCClientListColumnTopic
+};
+
+/** @class IRCClientReply
+ *	@brief The whole of the server’s (multi-line) reply to a request made
+ *	with a completion handler (e.g. -[IRCClientSession who:completion:]).
+ *
+ *	The reply is a table, stored by column: the bytes of every field are
+ *	held contiguously (see bytes), and each column is an array of the ranges,
+ *	in those bytes, of its field in each row. NSData objects for the fields
+ *	are only created when asked for.
+ */
+
+/**********************************************/
+#pragma mark - IRCClientReply class declaration
+/**********************************************/
+
+@interface IRCClientReply : NSObject
+
+@property (readonly) IRCClientReplyType type;
+
+/**	What the request was for (a channel name, a mask, or a target), or nil.
+ */
+@property (readonly) NSData *target;
+
+/**	If the server refused the request, why: the code of the numeric reply
+	(e.g. "263", for RPL_TRYAGAIN, or "403", for ERR_NOSUCHCHANNEL) or of
+	the FAIL message (e.g. "INVALID_TARGET"). nil if it didn’t.
+ */
+@property (readonly) NSData *failure;
+
+/**	The number of rows.
+ */
+@property (readonly) NSUInteger count;
+
+/**	The number of columns (which depends on the type).
+ */
+@property (readonly) NSUInteger columnCount;
+
+/**	The fields, one after another; see -[rangesOfColumn:].
+ */
+@property (readonly) NSData *bytes;
+
+/**	For a reply to CHATHISTORY, the messages (in a batch of type
+	"chathistory"); nil otherwise.
+ */
+@property (readonly) IRCClientEventBatch *messages;
+
+/**	Returns the ranges, in the reply’s bytes, of the given column’s field in
+	each row (count of them). The pointer is valid as long as the reply is.
+ */
+-(const NSRange *) rangesOfColumn:(NSUInteger)column;
+
+/**	Returns the field in the given column of the row at the given index.
+ */
+-(NSData *) valueOfColumn:(NSUInteger)column
+				  atIndex:(NSUInteger)index;
+
+@end
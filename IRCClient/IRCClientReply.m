@@ -0,0 +1,117 @@
+//
+//	IRCClientReply.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientReply.h"
+#import "IRCClientReply_Private.h"
+#import "IRCClientEventBatch.h"
+
+/******************************/
+#pragma mark - Static variables
+/******************************/
+
+static const NSUInteger IRCClientReplyColumnCounts[] = {
+	[IRCClientReplyNames]	= IRCClientNamesColumnNick + 1,
+	[IRCClientReplyWho]		= IRCClientWhoColumnRealname + 1,
+	[IRCClientReplyList]	= IRCClientListColumnTopic + 1,
+	[IRCClientReplyHistory]	= 0
+};
+
+/*************************************************/
+#pragma mark - IRCClientReply class implementation
+/*************************************************/
+
+@implementation IRCClientReply {
+	NSMutableData *_bytes;
+
+	// One array of NSRanges per column.
+	NSArray <NSMutableData *> *_columns;
+	NSUInteger _count;
+}
+
+/**************************/
+#pragma mark - Initializers
+/**************************/
+
+-(instancetype) initWithType:(IRCClientReplyType)type
+					  target:(NSData *)target
+				  completion:(IRCClientReplyHandler)completion {
+	if (!(self = [super init]))
+		return nil;
+
+	_type = type;
+	_target = [target copy];
+	_completion = [completion copy];
+
+	_bytes = [NSMutableData data];
+	NSMutableArray <NSMutableData *> *columns = [NSMutableArray arrayWithCapacity:IRCClientReplyColumnCounts[type]];
+	for (NSUInteger i = 0; i < IRCClientReplyColumnCounts[type]; i++)
+		[columns addObject:[NSMutableData data]];
+	_columns = columns;
+
+	return self;
+}
+
+/******************************/
+#pragma mark - Custom accessors
+/******************************/
+
+-(NSUInteger) count {
+	return (_type == IRCClientReplyHistory ? _messages.count : _count);
+}
+
+-(NSUInteger) columnCount {
+	return _columns.count;
+}
+
+-(NSData *) bytes {
+	return _bytes;
+}
+
+/****************************/
+#pragma mark - Public methods
+/****************************/
+
+-(const NSRange *) rangesOfColumn:(NSUInteger)column {
+	if (column >= _columns.count)
+		[NSException raise:NSRangeException
+					format:@"Column %lu beyond bounds of reply with %lu columns", (unsigned long) column, (unsigned long) _columns.count];
+
+	return (const NSRange *) _columns[column].bytes;
+}
+
+-(NSData *) valueOfColumn:(NSUInteger)column
+				  atIndex:(NSUInteger)index {
+	if (index >= _count)
+		[NSException raise:NSRangeException
+					format:@"Index %lu beyond bounds of reply of %lu rows", (unsigned long) index, (unsigned long) _count];
+
+	return [_bytes subdataWithRange:[self rangesOfColumn:column][index]];
+}
+
+/*****************************/
+#pragma mark - Private methods
+/*****************************/
+
+-(void) addRowWithRanges:(const NSRange *)ranges
+			   ofMessage:(const IRCClientMessage *)message {
+	for (NSUInteger i = 0; i < _columns.count; i++) {
+		// (A missing field is empty.)
+		NSRange field = NSMakeRange(_bytes.length, 0);
+		if (ranges[i].location != NSNotFound) {
+			field.length = ranges[i].length;
+			[_bytes appendBytes:(message->bytes + ranges[i].location)
+						 length:ranges[i].length];
+		}
+		[_columns[i] appendBytes:&field
+						  length:sizeof(field)];
+	}
+	_count++;
+}
+
+@end
@@ -0,0 +1,51 @@
+//
+//	IRCClientReply_Private.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientReply.h"
+#import "IRCClientSession.h"
+#import "IRCClientMessage.h"
+#import "IRCClientIdentifier.h"
+
+/*	NOTE: This header is for the framework’s internal use only. Do not import
+ *	it in files that make use of the IRCClientReply class.
+ */
+
+/******************************************/
+#pragma mark IRCClientReply class extension
+/******************************************/
+
+@interface IRCClientReply ()
+
+/**	The interned target, for matching replies to the request (set on the
+	session’s queue, when the request is sent).
+ */
+@property (strong) IRCClientIdentifier *targetIdentifier;
+
+/**	Called (once) when the reply is complete.
+ */
+@property (readonly) IRCClientReplyHandler completion;
+
+@property (readwrite) NSData *failure;
+
+@property (readwrite) IRCClientEventBatch *messages;
+
+/**	Returns an empty reply of the given type to a request for the given
+	target.
+ */
+-(instancetype) initWithType:(IRCClientReplyType)type
+					  target:(NSData *)target
+				  completion:(IRCClientReplyHandler)completion;
+
+/**	Copies the fields at the given ranges (columnCount of them) of the given
+	message into a new row.
+ */
+-(void) addRowWithRanges:(const NSRange *)ranges
+			   ofMessage:(const IRCClientMessage *)message;
+
+@end
@@ -0,0 +1,155 @@
+//
+//	IRCClientServerSupport.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+#import "IRCClientCaseMapping.h"
+#import "IRCClientChannelMode.h"
+
+/*	NOTE: This header is for the framework’s internal use only.
+ */
+
+/************************************/
+#pragma mark IRCClientChannelPrefixes
+/************************************/
+
+/**	The maximum number of channel membership prefixes that a server may use.
+ */
+#define IRCClientMaxChannelPrefixes 16
+
+/** @struct IRCClientChannelPrefixes
+ *	@brief The channel membership prefixes that a server uses (as advertised
+ *	in the PREFIX token of RPL_ISUPPORT), highest-ranked first; e.g., mode o
+ *	and prefix @ (operator), then mode v and prefix + (voice).
+ */
+typedef struct {
+	NSUInteger count;
+	uint8_t modes[IRCClientMaxChannelPrefixes];
+	uint8_t symbols[IRCClientMaxChannelPrefixes];
+} IRCClientChannelPrefixes;
+
+/**	Returns the rank (index) of the given prefix symbol, or NSNotFound if the
+	byte is not one of the prefix symbols.
+ */
+static inline NSUInteger IRCClientChannelPrefixIndex(const IRCClientChannelPrefixes *prefixes,
+													 uint8_t symbol) {
+	for (NSUInteger i = 0; i < prefixes->count; i++)
+		if (prefixes->symbols[i] == symbol)
+			return i;
+
+	return NSNotFound;
+}
+
+/**	Returns the rank (index) of the given prefix mode, or NSNotFound if the
+	mode is not one of the prefix modes.
+ */
+static inline NSUInteger IRCClientChannelPrefixModeIndex(const IRCClientChannelPrefixes *prefixes,
+														 uint8_t mode) {
+	for (NSUInteger i = 0; i < prefixes->count; i++)
+		if (prefixes->modes[i] == mode)
+			return i;
+
+	return NSNotFound;
+}
+
+/************************************/
+#pragma mark - IRCClientTargetCommand
+/************************************/
+
+/**	The commands that take a list of targets, whose length the server may
+	limit (in the TARGMAX token of RPL_ISUPPORT).
+ */
+typedef NS_ENUM(uint8_t, IRCClientTargetCommand) {
+	IRCClientTargetCommandPRIVMSG,
+	IRCClientTargetCommandNOTICE,
+	IRCClientTargetCommandJOIN,
+	IRCClientTargetCommandPART,
+	IRCClientTargetCommandKICK,
+	IRCClientTargetCommandNAMES,
+	IRCClientTargetCommandWHOIS,
+
+	IRCClientTargetCommandCount
+};
+
+/*******************************************/
+#pragma mark - IRCClientServerSupport struct
+/*******************************************/
+
+/** @struct IRCClientServerSupport
+ *	@brief What the server supports, as advertised in RPL_ISUPPORT (005).
+ *
+ *	Starts out with the defaults (see IRCClientServerSupportInit()), and is
+ *	updated as each RPL_ISUPPORT token is received. The session’s copy is
+ *	overwritten in place (on the session’s queue), so it must only be read
+ *	there; the session keeps its own copies of the limits that its command
+ *	methods (which may be called on any thread) check.
+ */
+typedef struct {
+	/** Bit set of the bytes that start a channel name (CHANTYPES). */
+	uint64_t channelTypes[4];
+
+	/** Channel membership prefixes (PREFIX). */
+	IRCClientChannelPrefixes prefixes;
+
+	/** The type of each channel mode (CHANMODES), indexed by mode letter.
+		(Prefix modes are typed by the prefixes, not by this table.) */
+	IRCClientChannelModeType channelModeTypes[128];
+
+	/** How nicks and channel names are compared (CASEMAPPING); caseFold maps
+		each byte to its lower-case form. */
+	IRCClientCaseMapping caseMapping;
+	uint8_t caseFold[256];
+
+	/** Maximum number of targets per command (TARGMAX, or MAXTARGETS for
+		PRIVMSG and NOTICE); NSUIntegerMax means no limit. */
+	NSUInteger targetLimits[IRCClientTargetCommandCount];
+
+	/** Maximum length of a message, including the CRLF (LINELEN). */
+	NSUInteger lineLength;
+
+	/** Maximum number of modes with a parameter per MODE command (MODES);
+		NSUIntegerMax means no limit. */
+	NSUInteger modesPerCommand;
+} IRCClientServerSupport;
+
+/*********************************/
+#pragma mark - Function prototypes
+/*********************************/
+
+/**	Sets everything to the defaults that apply until the server says
+	otherwise.
+ */
+void IRCClientServerSupportInit(IRCClientServerSupport *support);
+
+/**	Applies one RPL_ISUPPORT token (“KEY”, “KEY=VALUE”, or “-KEY”, which
+	restores the default). Unknown tokens are ignored.
+ */
+void IRCClientServerSupportApplyToken(IRCClientServerSupport *support,
+									  const uint8_t *bytes,
+									  NSUInteger length);
+
+/******************************/
+#pragma mark - Inline functions
+/******************************/
+
+/**	Returns YES if the given byte starts a channel name.
+ */
+static inline BOOL IRCClientServerSupportIsChannelType(const IRCClientServerSupport *support,
+													   uint8_t byte) {
+	return (support->channelTypes[byte >> 6] >> (byte & 63)) & 1;
+}
+
+/**	Returns the type of the given channel mode.
+ */
+static inline IRCClientChannelModeType IRCClientServerSupportChannelModeType(const IRCClientServerSupport *support,
+																			 uint8_t mode) {
+	if (IRCClientChannelPrefixModeIndex(&support->prefixes, mode) != NSNotFound)
+		return IRCClientChannelModeTypeMembership;
+
+	return (mode < 128) ? support->channelModeTypes[mode] : IRCClientChannelModeTypeUnknown;
+}
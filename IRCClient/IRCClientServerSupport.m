@@ -0,0 +1,242 @@
+//
+//	IRCClientServerSupport.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientServerSupport.h"
+#import "IRCClientSession_Private.h"
+
+/**********************/
+#pragma mark - Defaults
+/**********************/
+
+// RFC 2811 channel types.
+static const char IRCClientDefaultChannelTypes[] = "#&!+";
+
+// RFC 2811 channel modes: ban, exception, and invitation lists; key; limit;
+// and the usual flags.
+static const char IRCClientDefaultChannelModes[] = "beI,k,l,imnpst";
+
+// Operator and voice.
+static const IRCClientChannelPrefixes IRCClientDefaultChannelPrefixes = {
+	2, { 'o', 'v' }, { '@', '+' }
+};
+
+// Until told otherwise, we send one target per command, except for JOIN and
+// PART, which have always taken a list of channels.
+static const NSUInteger IRCClientDefaultTargetLimits[IRCClientTargetCommandCount] = {
+	[IRCClientTargetCommandPRIVMSG]	= 1,
+	[IRCClientTargetCommandNOTICE]	= 1,
+	[IRCClientTargetCommandJOIN]	= NSUIntegerMax,
+	[IRCClientTargetCommandPART]	= NSUIntegerMax,
+	[IRCClientTargetCommandKICK]	= 1,
+	[IRCClientTargetCommandNAMES]	= 1,
+	[IRCClientTargetCommandWHOIS]	= 1
+};
+
+// Indexed by IRCClientTargetCommand.
+static const char * const IRCClientTargetCommandNames[IRCClientTargetCommandCount] = {
+	"PRIVMSG", "NOTICE", "JOIN", "PART", "KICK", "NAMES", "WHOIS"
+};
+
+#define IRCClientDefaultModesPerCommand 3
+
+/******************************/
+#pragma mark - Helper functions
+/******************************/
+
+static BOOL IRCClientTokenIsEqualToCString(const uint8_t *bytes,
+										   NSUInteger length,
+										   const char *string) {
+	return (   strlen(string) == length
+			&& memcmp(bytes, string, length) == 0);
+}
+
+// Parses a decimal number; an empty (or unparseable) value means no limit.
+static NSUInteger IRCClientTokenLimit(const uint8_t *bytes,
+									  NSUInteger length) {
+	if (length == 0)
+		return NSUIntegerMax;
+
+	NSUInteger value = 0;
+	for (NSUInteger i = 0; i < length; i++) {
+		if (bytes[i] < '0' || bytes[i] > '9' || value > (NSUIntegerMax - 9) / 10)
+			return NSUIntegerMax;
+		value = value * 10 + (bytes[i] - '0');
+	}
+
+	return value;
+}
+
+// CHANMODES=A,B,C,D (any further groups are ignored, as we can’t know what
+// they mean).
+static void IRCClientServerSupportSetChannelModes(IRCClientServerSupport *support,
+												  const uint8_t *bytes,
+												  NSUInteger length) {
+	memset(support->channelModeTypes, IRCClientChannelModeTypeUnknown, sizeof(support->channelModeTypes));
+
+	IRCClientChannelModeType type = IRCClientChannelModeTypeList;
+	for (NSUInteger i = 0; i < length; i++) {
+		if (bytes[i] == ',') {
+			if (type == IRCClientChannelModeTypeFlag)
+				break;
+			type++;
+		} else if (bytes[i] < 128) {
+			support->channelModeTypes[bytes[i]] = type;
+		}
+	}
+}
+
+// Unknown mappings are treated as RFC 1459 (the default).
+static IRCClientCaseMapping IRCClientCaseMappingNamed(const uint8_t *bytes,
+													  NSUInteger length) {
+	if (   IRCClientTokenIsEqualToCString(bytes, length, "ascii")
+		|| IRCClientTokenIsEqualToCString(bytes, length, "rfc7613"))
+		return IRCClientCaseMappingASCII;
+
+	if (IRCClientTokenIsEqualToCString(bytes, length, "strict-rfc1459"))
+		return IRCClientCaseMappingStrictRFC1459;
+
+	return IRCClientCaseMappingRFC1459;
+}
+
+static void IRCClientServerSupportSetChannelTypes(IRCClientServerSupport *support,
+												  const uint8_t *bytes,
+												  NSUInteger length) {
+	memset(support->channelTypes, 0, sizeof(support->channelTypes));
+	for (NSUInteger i = 0; i < length; i++)
+		support->channelTypes[bytes[i] >> 6] |= (uint64_t) 1 << (bytes[i] & 63);
+}
+
+static void IRCClientServerSupportSetCaseMapping(IRCClientServerSupport *support,
+												 IRCClientCaseMapping mapping) {
+	support->caseMapping = mapping;
+	IRCClientCaseFoldTableInit(support->caseFold, mapping);
+}
+
+// PREFIX=(modes)symbols; an empty value means that there are no prefixes.
+static void IRCClientServerSupportSetPrefixes(IRCClientServerSupport *support,
+											  const uint8_t *bytes,
+											  NSUInteger length) {
+	IRCClientChannelPrefixes prefixes = { 0 };
+
+	if (length > 0) {
+		const uint8_t *close = memchr(bytes, ')', length);
+		if (bytes[0] != '(' || close == NULL)
+			return;
+
+		NSUInteger modeCount = (NSUInteger) (close - bytes) - 1;
+		NSUInteger symbolCount = length - modeCount - 2;
+		if (modeCount != symbolCount || modeCount > IRCClientMaxChannelPrefixes)
+			return;
+
+		prefixes.count = modeCount;
+		memcpy(prefixes.modes, bytes + 1, modeCount);
+		memcpy(prefixes.symbols, close + 1, symbolCount);
+	}
+
+	support->prefixes = prefixes;
+}
+
+// TARGMAX=PRIVMSG:4,NOTICE:4,JOIN:,... (an empty limit means no limit).
+static void IRCClientServerSupportSetTargetLimits(IRCClientServerSupport *support,
+												  const uint8_t *bytes,
+												  NSUInteger length) {
+	const uint8_t *end = bytes + length;
+	while (bytes < end) {
+		const uint8_t *comma = memchr(bytes, ',', (NSUInteger) (end - bytes)) ?: end;
+		const uint8_t *colon = memchr(bytes, ':', (NSUInteger) (comma - bytes));
+		if (colon != NULL) {
+			for (NSUInteger i = 0; i < IRCClientTargetCommandCount; i++) {
+				if (IRCClientTokenIsEqualToCString(bytes, (NSUInteger) (colon - bytes), IRCClientTargetCommandNames[i])) {
+					support->targetLimits[i] = IRCClientTokenLimit(colon + 1, (NSUInteger) (comma - colon - 1));
+					break;
+				}
+			}
+		}
+		bytes = comma + 1;
+	}
+}
+
+/**********************************************/
+#pragma mark - IRCClientServerSupport functions
+/**********************************************/
+
+void IRCClientServerSupportInit(IRCClientServerSupport *support) {
+	IRCClientServerSupportSetChannelTypes(support,
+										  (const uint8_t *) IRCClientDefaultChannelTypes,
+										  strlen(IRCClientDefaultChannelTypes));
+	support->prefixes = IRCClientDefaultChannelPrefixes;
+	IRCClientServerSupportSetChannelModes(support,
+										  (const uint8_t *) IRCClientDefaultChannelModes,
+										  strlen(IRCClientDefaultChannelModes));
+	IRCClientServerSupportSetCaseMapping(support, IRCClientCaseMappingRFC1459);
+	memcpy(support->targetLimits, IRCClientDefaultTargetLimits, sizeof(support->targetLimits));
+	support->lineLength = IRCClientMaxLineLength;
+	support->modesPerCommand = IRCClientDefaultModesPerCommand;
+}
+
+void IRCClientServerSupportApplyToken(IRCClientServerSupport *support,
+									  const uint8_t *bytes,
+									  NSUInteger length) {
+	if (length == 0)
+		return;
+
+	// “-KEY” means that the server no longer advertises KEY, so it goes back
+	// to the default.
+	BOOL negated = (bytes[0] == '-');
+	if (negated) {
+		bytes++;
+		length--;
+	}
+
+	const uint8_t *equals = memchr(bytes, '=', length);
+	NSUInteger keyLength = equals ? (NSUInteger) (equals - bytes) : length;
+	const uint8_t *value = equals ? equals + 1 : bytes + length;
+	NSUInteger valueLength = length - (NSUInteger) (value - bytes);
+
+	IRCClientServerSupport defaults;
+	if (negated)
+		IRCClientServerSupportInit(&defaults);
+
+	if (IRCClientTokenIsEqualToCString(bytes, keyLength, "CHANTYPES")) {
+		if (negated)
+			memcpy(support->channelTypes, defaults.channelTypes, sizeof(support->channelTypes));
+		else
+			IRCClientServerSupportSetChannelTypes(support, value, valueLength);
+	} else if (IRCClientTokenIsEqualToCString(bytes, keyLength, "PREFIX")) {
+		if (negated)
+			support->prefixes = defaults.prefixes;
+		else
+			IRCClientServerSupportSetPrefixes(support, value, valueLength);
+	} else if (IRCClientTokenIsEqualToCString(bytes, keyLength, "CHANMODES")) {
+		if (negated)
+			memcpy(support->channelModeTypes, defaults.channelModeTypes, sizeof(support->channelModeTypes));
+		else
+			IRCClientServerSupportSetChannelModes(support, value, valueLength);
+	} else if (IRCClientTokenIsEqualToCString(bytes, keyLength, "CASEMAPPING")) {
+		IRCClientServerSupportSetCaseMapping(support, (negated
+													   ? defaults.caseMapping
+													   : IRCClientCaseMappingNamed(value, valueLength)));
+	} else if (IRCClientTokenIsEqualToCString(bytes, keyLength, "MAXTARGETS")) {
+		NSUInteger limit = negated ? 1 : IRCClientTokenLimit(value, valueLength);
+		support->targetLimits[IRCClientTargetCommandPRIVMSG] = limit;
+		support->targetLimits[IRCClientTargetCommandNOTICE] = limit;
+	} else if (IRCClientTokenIsEqualToCString(bytes, keyLength, "TARGMAX")) {
+		if (negated)
+			memcpy(support->targetLimits, defaults.targetLimits, sizeof(support->targetLimits));
+		else
+			IRCClientServerSupportSetTargetLimits(support, value, valueLength);
+	} else if (IRCClientTokenIsEqualToCString(bytes, keyLength, "LINELEN")) {
+		// We never send less than the RFC allows.
+		NSUInteger lineLength = negated ? IRCClientMaxLineLength : IRCClientTokenLimit(value, valueLength);
+		if (lineLength >= IRCClientMaxLineLength && lineLength != NSUIntegerMax)
+			support->lineLength = lineLength;
+	} else if (IRCClientTokenIsEqualToCString(bytes, keyLength, "MODES")) {
+		support->modesPerCommand = negated ? IRCClientDefaultModesPerCommand : IRCClientTokenLimit(value, valueLength);
+	}
+}
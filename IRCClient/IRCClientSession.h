@@ -9,6 +9,13 @@
 
 #import <Foundation/Foundation.h>
 #import "IRCClientSessionDelegate.h"
+#import "IRCClientEventLoop.h"
+#import "IRCClientTransport.h"
+#import "IRCClientFormattedMessage.h"
+#import "IRCClientEventFilter.h"
+#import "IRCClientLog.h"
+#import "IRCClientReply.h"
+#import "IRCClientDCCTransfer.h"
 
 /** @class IRCClientSession
  *	@brief Represents a connected IRC Session.
@@ -23,11 +30,65 @@
  *	or to the IRCClientChannel delegate, as required.
  */
 
+/** A handler for a command that IRCClient does not itself handle; see
+	-[IRCClientSession setHandler:forCommand:].
+
+	@param origin The sender of the message (may be nil).
+	@param params An NSArray of NSData objects that are the message’s params.
+ */
+typedef void (^IRCClientCommandHandler)(NSData *origin,
+										NSArray <NSData *> *params,
+										IRCClientSession *session);
+
+/** A handler for the reply to a request; see e.g. -[IRCClientSession
+	who:completion:].
+
+	@param reply The whole reply, or nil if the connection was lost before it
+	was complete.
+ */
+typedef void (^IRCClientReplyHandler)(IRCClientReply *reply,
+									  IRCClientSession *session);
+
+/** What a session does when its delegate falls behind (see
+	-[IRCClientSession inboundEventLimit]).
+ */
+typedef NS_ENUM(NSUInteger, IRCClientInboundOverflowPolicy) {
+	/**	Stop reading from the server until the delegate catches up. (The
+		server will disconnect us if this goes on for too long.)
+	 */
+	IRCClientInboundOverflowPause = 0,
+	/**	Disconnect from the server.
+	 */
+	IRCClientInboundOverflowDisconnect,
+	/**	Keep reading, but drop the messages that the session doesn’t need to
+		keep track of the connection and of channels (the same ones that
+		event filters apply to; see -[IRCClientSession eventFilters]) until the
+		delegate catches up.
+	 */
+	IRCClientInboundOverflowDropMessages
+};
+
+/** How a session authenticates with SASL while registering (see
+	-[IRCClientSession SASLMechanism]).
+ */
+typedef NS_ENUM(NSUInteger, IRCClientSASLMechanism) {
+	/**	Don’t authenticate.
+	 */
+	IRCClientSASLMechanismNone = 0,
+	/**	Send the SASLUsername and SASLPassword.
+	 */
+	IRCClientSASLMechanismPlain,
+	/**	Authenticate with the TLS client certificate (see
+		-[IRCClientTLSTransport clientCertificates]).
+	 */
+	IRCClientSASLMechanismExternal
+};
+
 /**********************************************/
 #pragma mark IRCClientSession class declaration
 /**********************************************/
 
-@interface IRCClientSession : NSObject <NSStreamDelegate>
+@interface IRCClientSession : NSObject <IRCClientTransportDelegate>
 
 /******************************/
 #pragma mark - Class properties
@@ -38,8 +99,12 @@
 	The dictionary contains entries for all known IRC numeric codes (as keys).
 	(The list is taken from https://www.alien.net.au/irc/irc2numerics.html .)
 
-	The value for each key is an NSArray with the known numeric reply names for
-	which the numeric code is used.
+	The value for each key is a dictionary whose "names" entry is an NSArray
+	with the known numeric reply names for which the numeric code is used.
+
+	The dictionary is built (once) from the compiled-in numerics table the
+	first time it’s requested; to look up a name, +[nameForNumericCode:] is
+	much cheaper.
 
 	Note that there is no guarantee whatsoever that any given numeric reply
 	name will, in fact, describe the contents of the message; most IRC numeric
@@ -52,8 +117,9 @@
 #pragma mark - Properties
 /************************/
 
-/** Delegate to send events to. */
-@property (assign) id <IRCClientSessionDelegate> delegate;
+/** Delegate to send events to. (Which optional methods the delegate
+	implements is checked once, when it is set.) */
+@property (nonatomic, assign) id <IRCClientSessionDelegate> delegate;
 
 /** The version string for the client to send back on CTCP VERSION requests.
 	There is usually no reason to set this, as IRCClient correctly sets its
@@ -92,6 +158,16 @@
  */
 @property (assign) NSStringEncoding encoding;
 
+/** What is done with the mIRC format codes in received messages, notices,
+	and actions, before they are passed to the delegate (or to a channel, if
+	the channel’s colorCodeHandling is IRCClientColorCodeHandlingDefault).
+	The default is IRCClientColorCodeHandlingIgnore: the received bytes are
+	passed on as they are, with no extra work at all. (Set this to
+	IRCClientColorCodeHandlingConvert to have format codes converted to
+	libircclient markup.)
+ */
+@property (assign) IRCClientColorCodeHandling colorCodeHandling;
+
 /** An NSDictionary of channels that the client is currently connected to.
 	Keys are channel names (NSData), values are IRCClientChannel objects.
  */
@@ -101,6 +177,228 @@
 	it is not. */
 @property (readonly, getter=isConnected) BOOL connected;
 
+/** The number of bytes of outbound messages that are queued, waiting to be 
+	written to the server. */
+@property (readonly) NSUInteger outputBytesQueued;
+
+/** The largest number of bytes of outbound messages that have been queued at
+	once (at any time since the session was created). */
+@property (readonly) NSUInteger outputHighWaterMark;
+
+/** The number of outbound messages that are being held back by flood control.
+ */
+@property (readonly) NSUInteger outputMessagesQueued;
+
+/** How long (in seconds) the most recently sent message was held back by
+	flood control. */
+@property (readonly) NSTimeInterval outputQueueDelay;
+
+/** The longest time (in seconds) that any message has been held back by flood
+	control (since the session was created). */
+@property (readonly) NSTimeInterval outputMaxQueueDelay;
+
+/** Flood control: the number of messages that may be sent at once (after
+	which messages are sent at a rate of one per floodControlInterval).
+	Set to 0 to disable flood control. The default is 5.
+
+	PONG and QUIT messages are always sent immediately, and ahead of anything
+	else; other commands are sent ahead of PRIVMSGs and NOTICEs, which are
+	sent in turn to each target (one at a time) so that one busy channel
+	can’t hold up messages to the others.
+ */
+@property (nonatomic) NSUInteger floodControlBurst;
+
+/** Flood control: the number of seconds per message (on average) that may be
+	sent, after the initial burst. Set to 0 to disable flood control. The
+	default is 2.0.
+ */
+@property (nonatomic) NSTimeInterval floodControlInterval;
+
+/** If YES, and the delegate implements -[eventsReceived:session:], received
+	messages are passed to the delegate in batches (see IRCClientEventBatch),
+	instead of one delegate call per event. A batch is delivered when
+	everything the transport has for us has been read, or when it reaches
+	eventBatchLimit messages, or eventBatchLatency seconds after its first
+	message was received, whichever comes first. The default is NO.
+ */
+@property (nonatomic) BOOL batchesEvents;
+
+/** The largest number of messages in a batch (see batchesEvents). The default
+	is 256.
+ */
+@property (nonatomic) NSUInteger eventBatchLimit;
+
+/** The longest time (in seconds) that a received message may be held in a
+	batch before the batch is delivered (see batchesEvents). The default is
+	0.005.
+ */
+@property (nonatomic) NSTimeInterval eventBatchLatency;
+
+/** Inbound budget: the number of received messages that may be delivered to
+	the delegate (in batches; see batchesEvents) and not yet consumed (see
+	-[eventBatchConsumed:]) before inboundOverflowPolicy applies. The
+	default is 0 (no limit, and batches needn’t be marked consumed).
+ */
+@property (nonatomic) NSUInteger inboundEventLimit;
+
+/** Inbound budget: the number of bytes of received messages that may be
+	delivered to the delegate and not yet consumed (as for
+	inboundEventLimit). The default is 0 (no limit).
+ */
+@property (nonatomic) NSUInteger inboundByteLimit;
+
+/** What is done when the inbound budget is exceeded. If reading is paused,
+	it resumes once the delegate has consumed enough batches to bring what’s
+	pending down to half of the budget. The default is
+	IRCClientInboundOverflowPause.
+ */
+@property (assign) IRCClientInboundOverflowPolicy inboundOverflowPolicy;
+
+/** The number of received messages delivered to the delegate and not yet
+	consumed. */
+@property (readonly) NSUInteger inboundEventsPending;
+
+/** The number of bytes of received messages delivered to the delegate and
+	not yet consumed. */
+@property (readonly) NSUInteger inboundBytesPending;
+
+/** The number of received messages dropped by
+	IRCClientInboundOverflowDropMessages (since the session was created). */
+@property (readonly) NSUInteger inboundEventsDropped;
+
+/** Returns YES if reading from the server is paused, because the inbound
+	budget has been exceeded. */
+@property (readonly, getter=isReadingPaused) BOOL readingPaused;
+
+/** Filters for received messages (see IRCClientEventFilter). If there are
+	any, messages that pass none of them are dropped as soon as they are
+	received, before anything is made of them (no delegate or channel sees
+	them). The default is nil (no filtering).
+
+	Only PRIVMSGs, NOTICEs, INVITEs, commands that IRCClient doesn’t handle,
+	and numeric replies that the session doesn’t keep track of anything by
+	are filtered; the session always handles the rest (PING, JOIN, MODE, and
+	so on). Note that a CTCP request that is filtered out is not replied to.
+ */
+@property (nonatomic, copy) NSArray <IRCClientEventFilter *> *eventFilters;
+
+/** The number of received messages that were subject to the event filters,
+	and passed one of them. */
+@property (readonly) NSUInteger eventFilterMatchedCount;
+
+/** The number of received messages that were dropped by the event filters.
+ */
+@property (readonly) NSUInteger eventFilterDroppedCount;
+
+/** How much the session logs (see IRCClientLog.h). Logging calls for levels
+	above this cost one comparison; records are copied into a ring buffer
+	and written to the log sink on a background queue. The default is
+	IRCClientLogLevelInfo. (IRCClientLogLevelTrace logs every line sent and
+	received.)
+
+	The ring buffer is sized for this level when the first record is logged,
+	so set it before connecting; raising it later past Info may drop records
+	(see logRecordsDropped).
+ */
+@property (nonatomic) IRCClientLogLevel logLevel;
+
+/** Where log records go. The default is an IRCClientLogConsoleSink; set to
+	nil to discard them.
+ */
+@property (strong) id <IRCClientLogSink> logSink;
+
+/** The number of log records dropped because the log sink fell behind. */
+@property (readonly) NSUInteger logRecordsDropped;
+
+/** If YES, the session reconnects on its own when the connection fails or
+	is lost (but not after -[disconnect], or once a QUIT has been sent),
+	waiting longer after each failed attempt (see reconnectInitialDelay).
+	Once registered again, it rejoins the channels it was on (with their
+	keys), in as few JOINs as will fit. The default is NO.
+ */
+@property (assign) BOOL reconnects;
+
+/** How long to wait before the first reconnect attempt. The wait doubles
+	with each attempt (up to reconnectMaxDelay), and is randomized to between
+	half and all of that. The default is 1 second.
+ */
+@property (assign) NSTimeInterval reconnectInitialDelay;
+
+/** The longest wait between reconnect attempts. The default is 300 seconds.
+ */
+@property (assign) NSTimeInterval reconnectMaxDelay;
+
+/** How many times to try reconnecting before giving up. The default is 0
+	(never give up).
+ */
+@property (assign) NSUInteger reconnectMaxAttempts;
+
+/** The number of reconnect attempts made since the connection was lost (0
+	once registered again). */
+@property (readonly) NSUInteger reconnectAttempts;
+
+/** How long the last recovery took: from losing the connection to being
+	registered and back in every channel (0 if there hasn’t been one). */
+@property (readonly) NSTimeInterval lastRecoveryDuration;
+
+/** If YES, the session connects with TLS (through an IRCClientTLSTransport
+	that trusts the system’s certificate authorities). Only applies if no
+	transport has been set; to configure TLS (a CA, a client certificate,
+	pinned keys), set an IRCClientTLSTransport as the transport instead.
+	Changes take effect on the next connect. The default is NO.
+ */
+@property (assign) BOOL usesTLS;
+
+/** The IRCv3 capabilities (e.g. "server-time") to enable, if the server
+	offers them, when registering (or later, if the server offers them
+	then). The default is server-time, message-tags, account-tag, and batch.
+	Set this to an empty array (with SASLMechanism set to
+	IRCClientSASLMechanismNone) to skip capability negotiation.
+ */
+@property (copy) NSArray <NSData *> *requestedCapabilities;
+
+/** The IRCv3 capabilities that the server has enabled for this connection.
+	Must only be used on the session’s queue (e.g. from a delegate method).
+ */
+@property (readonly) NSSet <NSData *> *enabledCapabilities;
+
+/** How to authenticate with SASL while registering. The default is
+	IRCClientSASLMechanismNone. If the server doesn’t support the mechanism,
+	or authentication fails, registration goes ahead without it.
+ */
+@property (assign) IRCClientSASLMechanism SASLMechanism;
+
+/** The account name for SASL PLAIN; nil (the default) for the nickname.
+ */
+@property (copy) NSData *SASLUsername;
+
+/** The password for SASL PLAIN.
+ */
+@property (copy) NSData *SASLPassword;
+
+/** The address (numeric, IPv4 or IPv6) that other users can reach us at, for
+	DCC: where we listen for them to connect when sending a file (or when
+	accepting one that’s offered passively). The default is nil, in which
+	case files can only be sent passively, and passive offers can’t be
+	accepted. (Set it to "127.0.0.1" to transfer files between sessions on
+	the same machine.)
+ */
+@property (copy) NSString *DCCAddress;
+
+/** The transport to connect through. If this is nil when -[connect] is
+	called, an IRCClientSocketTransport is created (or an
+	IRCClientStreamTransport, if the system configuration specifies a SOCKS
+	proxy), wrapped in an IRCClientTLSTransport if usesTLS is set; that
+	transport is created afresh on each connect (so that changes to usesTLS
+	take effect). Set this (before connecting) to connect in some other way;
+	a transport that’s been set is reused on every connect.
+ */
+@property (strong) id <IRCClientTransport> transport;
+
+/** The event loop pool that the session’s queue is pinned to (nil if the
+	session has a queue of its own). */
+@property (readonly) IRCClientEventLoop *eventLoop;
+
 /** Stores arbitrary user info. */
 @property (nonatomic, readonly) NSMutableDictionary *userInfo;
 
@@ -110,10 +408,24 @@
 
 +(instancetype) session;
 
++(instancetype) sessionWithEventLoop:(IRCClientEventLoop *)eventLoop;
+
+/** Creates a session whose I/O and event handling happen on one of the given
+	event loop pool’s loops, instead of on a queue of its own. (The delegate
+	methods are called on that loop.) Pass nil for the default behavior.
+ */
+-(instancetype) initWithEventLoop:(IRCClientEventLoop *)eventLoop;
+
 /***************************/
 #pragma mark - Class methods
 /***************************/
 
+/**	Returns the (first) known numeric reply name for the given numeric code
+	(e.g. "RPL_WELCOME" for 1), or NULL if the code is not a known one. (The
+	returned C string is statically allocated; see also +[ircNumericCodes].)
+ */
++(const char *) nameForNumericCode:(NSUInteger)code;
+
 /**	Returns the nick part of a nick!user@host string.
  */
 +(NSData *) nickFromNickUserHost:(NSData *)nickUserHost;
@@ -158,14 +470,34 @@
  
 	This always works, as it simply shuts down the socket. If you want to disconnect
 	in a friendly way, you should use the quit: message.
+
+	The session won’t reconnect (see reconnects) after this.
+
+	If called off the session’s queue, this returns at once, and the
+	connection is closed shortly after, on the queue (the delegate is then
+	sent -[disconnected:]).
  */
 -(void) disconnect;
 
+/** Tells the session that the delegate is done with a batch of received
+	messages (see -[IRCClientSessionDelegate eventsReceived:session:]), so
+	that it no longer counts against the inbound budget. Only needed if
+	inboundEventLimit or inboundByteLimit is set. May be called on any
+	thread.
+ */
+-(void) eventBatchConsumed:(IRCClientEventBatch *)batch;
+
 /** Convert libircclient markup in a message to mIRC format codes.
+
+	The markup is [B]…[/B] (bold), [I]…[/I] (italic), [U]…[/U] (underline),
+	[R]…[/R] (reverse), and [COLOR=fg]…[/COLOR] or [COLOR=fg/bg]…[/COLOR]
+	(where the colors are mIRC color names, such as RED or DARKBLUE, or color
+	numbers). A message with no markup is returned unchanged.
  */
 -(NSData *) colorConvertToMIRC:(NSData *)message;
 
-/** Convert mIRC format codes in a message to libircclient markup.
+/** Convert mIRC format codes in a message to libircclient markup. (See
+	-[colorConvertToMIRC:].)
  */
 -(NSData *) colorConvertFromMIRC:(NSData *)message;
 
@@ -173,12 +505,35 @@
  */
 -(NSData *) colorStripFromMIRC:(NSData *)message;
 
+/** Registers a handler for messages with the given command (e.g. CHGHOST,
+	ACCOUNT, etc.).
+
+	Handlers apply only to commands that IRCClient does not itself handle
+	(and are not used for numeric replies); a message with such a command is
+	passed to the handler instead of being sent to the delegate’s 
+	-[unknownEventReceived:from:params:session:] method. The exceptions are
+	CAP and AUTHENTICATE, which IRCClient handles itself (for capability
+	negotiation and SASL) and then also passes to the handler, if there is
+	one.
+
+	The handler is called on the session’s queue. Pass nil to remove the
+	handler for a command.
+
+	@param handler The handler.
+	@param command The command (case-sensitive, e.g. "CHGHOST").
+ */
+-(void) setHandler:(IRCClientCommandHandler)handler
+		forCommand:(NSData *)command;
+
 /**************************/
 #pragma mark - IRC commands
 /**************************/
 
 /** Sends a raw message to the IRC server. Please consult RFC 1459 for the 
 	format of IRC commands. 
+
+	(The other command methods return 1, and send nothing, if the resulting
+	message would be longer than 512 bytes; this one does not check.)
  */
 -(int) sendRaw:(NSData *)message;
 
@@ -204,6 +559,19 @@
 -(int) join:(NSData *)channel 
 		key:(NSData *)key;
 
+/** Joins several channels, with as few JOIN messages as possible (as many
+	channels per message as the server allows, and as will fit).
+
+	All of the messages are queued at once. If any channel (with its key)
+	wouldn’t fit in a message, then none are sent, and 1 is returned.
+
+	@param channels The names of the channels to join.
+	@param keys The channels’ keys, in the same order (empty data for a
+	channel with no key), or nil if none of them have keys.
+ */
+-(int) joinChannels:(NSArray <NSData *> *)channels
+			   keys:(NSArray <NSData *> *)keys;
+
 /**	Lists users in an IRC channel (or channels).
 
 	@param channel A channel name or string to pass to the NAMES command.
@@ -218,6 +586,27 @@
  */
 -(int) list:(NSData *)channel;
 
+/**	Lists the users in an IRC channel, and calls the handler (on the
+	session’s queue) with the whole list once it’s in. The lines of the
+	reply (RPL_NAMREPLY) are not sent to the delegate.
+
+	@param channel A channel name.
+	@param completion Called with a reply of type IRCClientReplyNames.
+ */
+-(int) names:(NSData *)channel
+  completion:(IRCClientReplyHandler)completion;
+
+/**	Lists channels on the IRC server, and calls the handler (on the session’s
+	queue) with the whole list once it’s in. The lines of the reply
+	(RPL_LIST) are not sent to the delegate.
+
+	@param channel A channel name or string to pass to the LIST command, or
+	nil (or empty) to list every channel.
+	@param completion Called with a reply of type IRCClientReplyList.
+ */
+-(int) list:(NSData *)channel
+ completion:(IRCClientReplyHandler)completion;
+
 /** Sets the user mode for the IRC client.
  
 	@param mode The mode string to set.
@@ -240,6 +629,32 @@
  */
 -(int) who:(NSData *)nickmask;
 
+/**	Sends a WHO query to the IRC server, and calls the handler (on the
+	session’s queue) with the whole reply once it’s in. The lines of the reply
+	(RPL_WHOREPLY) are not sent to the delegate.
+
+	(Replies to WHO don’t say which query they answer, so they are matched
+	to queries in the order sent; don’t mix this with -[who:].)
+
+	@param nickmask Nickname mask of the IRC client to WHO.
+	@param completion Called with a reply of type IRCClientReplyWho.
+ */
+-(int) who:(NSData *)nickmask
+completion:(IRCClientReplyHandler)completion;
+
+/**	Asks the server for the latest messages sent to a channel (or exchanged
+	with a user), and calls the handler (on the session’s queue) with them.
+	The server must support the draft/chathistory capability (add it to
+	requestedCapabilities, along with batch).
+
+	@param target A channel name or nickname.
+	@param limit The most messages to get.
+	@param completion Called with a reply of type IRCClientReplyHistory.
+ */
+-(int) chatHistory:(NSData *)target
+			 limit:(NSUInteger)limit
+		completion:(IRCClientReplyHandler)completion;
+
 /**	Sends a WHOIS query to the IRC server.
  
 	@param nick Nickname of the IRC client to WHOIS.
@@ -254,6 +669,19 @@
 -(int) message:(NSData *)message 
 			to:(NSData *)target;
 
+/**	Sends each of the given messages (as a PRIVMSG) to each of the given
+	targets, in order (i.e., the first message to every target, then the second
+	message to every target, and so on).
+
+	All of the resulting messages are queued at once. If any of them would be
+	too long (see RFC 1459, section 2.3), then none are sent, and 1 is returned.
+
+	@param messages Messages to send.
+	@param targets Nicknames and/or channel names to send the messages to.
+ */
+-(int) messages:(NSArray <NSData *> *)messages
+	  toTargets:(NSArray <NSData *> *)targets;
+
 /**	Sends a CTCP ACTION to another IRC client.
  
 	@param action The action message to send.
@@ -286,4 +714,33 @@
 -(int) ctcpReply:(NSData *)reply 
 		  target:(NSData *)target;
 
+/**	Offers a file to another IRC client (with a DCC SEND request), and sends
+	it once the other client accepts. The transfer runs on the session’s
+	queue.
+
+	Returns the transfer (set its delegate to follow it), or nil if the file
+	can’t be opened, or the transfer isn’t passive and there’s no DCCAddress.
+
+	@param path The file to send.
+	@param nick The nickname of the IRC client to send it to.
+	@param passive If YES, the other client listens, and we connect to it
+	(for when we can’t be connected to, e.g. from behind NAT).
+ */
+-(IRCClientDCCTransfer *) sendFile:(NSString *)path
+								to:(NSData *)nick
+						   passive:(BOOL)passive;
+
+/**	Accepts a file that was offered to us (see -[IRCClientSessionDelegate
+	fileTransferOffered:session:]), and receives it into the given file.
+
+	@param transfer The offered transfer.
+	@param path Where to put the file.
+	@param resume If YES, and the file is already there (but is shorter than
+	the one offered), asks the sender to send only the rest of it (with a DCC
+	RESUME request).
+ */
+-(int) acceptTransfer:(IRCClientDCCTransfer *)transfer
+				 path:(NSString *)path
+			   resume:(BOOL)resume;
+
 @end
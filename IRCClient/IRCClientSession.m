@@ -13,16 +13,42 @@
 
 #define IRCCLIENTVERSION "2.1a1"
 
+// Log (see IRCClientLogger.h); the arguments are only evaluated if the level
+// is enabled.
+#define IRCClientSessionLog(level, ...) \
+	IRCClientLog(_logger, _logLevel, (level), __VA_ARGS__)
+#define IRCClientSessionLogLine(type, bytes, length) \
+	IRCClientLogLine(_logger, _logLevel, (type), (bytes), (length))
+
 #import "IRCClientSession.h"
+#import "IRCClientSession_Private.h"
 #import "IRCClientChannel.h"
 #import "IRCClientChannel_Private.h"
+#import "IRCClientEventBatch_Private.h"
+#import "IRCClientReply_Private.h"
+#import "IRCClientDCCTransfer_Private.h"
+#import "IRCClientEventMatcher.h"
+#import "IRCClientLogger.h"
+#import "IRCClientEventLoop_Private.h"
+#import "IRCClientSocketTransport.h"
+#import "IRCClientStreamTransport.h"
+#import "IRCClientTLSTransport.h"
+#import "IRCClientReceiveBuffer.h"
+#import "IRCClientOutputQueue.h"
+#import "IRCClientOutputScheduler.h"
+#import "IRCClientMessage.h"
+#import "IRCClientCommandTable.h"
+#import "IRCClientNumericsTable.h"
+#import "IRCClientFormatting.h"
 
 #import "NSArray+SA_NSArrayExtensions.h"
 #import "NSData+SA_NSDataExtensions.h"
 #import "NSString+SA_NSStringExtensions.h"
+
+#import <arpa/inet.h>
+#import <stdatomic.h>
 #import "NSRange-Conventional.h"
 #import "NSIndexSet+SA_NSIndexSetExtensions.h"
-#import "NSStream+QNetworkAdditions.h"
 
 /******************************/
 #pragma mark - Static variables
@@ -30,16 +56,220 @@
 
 static const char *C_string_crlf = "\r\n";
 
-static NSDictionary* ircNumericCodeList;
+static const NSUInteger IRCClientReceiveBufferInitialCapacity = 16384;
+
+// The most we hand the transport in one write.
+static const NSUInteger IRCClientSendChunkSize = 16384;
+static const int IRCClientSendMaxVectors = 64;
+
+// Flood control defaults (a burst of 5 messages, then one every 2 seconds).
+static const NSUInteger IRCClientFloodControlDefaultBurst = 5;
+static const NSTimeInterval IRCClientFloodControlDefaultInterval = 2.0;
+
+// Event batching defaults (see -[batchesEvents]).
+static const NSUInteger IRCClientEventBatchDefaultLimit = 256;
+static const NSTimeInterval IRCClientEventBatchDefaultLatency = 0.005;
+
+// How many log records may be waiting to be drained into the log sink. (At
+// levels up to Info, a session logs only a few records per connection.)
+static const NSUInteger IRCClientLogCapacity = 256;
+static const NSUInteger IRCClientLogQuietCapacity = 8;
+
+// The most bytes of SASL payload per AUTHENTICATE message.
+static const NSUInteger IRCClientSASLChunkSize = 400;
+
+// The most file transfer offers (DCC SEND) that may be waiting to be
+// accepted at once, from one user and in all; any more are ignored.
+static const NSUInteger IRCClientDCCOfferLimitPerNick = 4;
+static const NSUInteger IRCClientDCCOfferLimit = 32;
+
+// The most IRCv3 batches that may be open at once (a server that never ends
+// them could otherwise have us keep every message).
+static const NSUInteger IRCClientOpenBatchLimit = 32;
+
+// Reconnect backoff defaults (see -[reconnects]).
+static const NSTimeInterval IRCClientReconnectDefaultInitialDelay = 1.0;
+static const NSTimeInterval IRCClientReconnectDefaultMaxDelay = 300.0;
+
+// How late the flood control timer may fire.
+static const uint64_t IRCClientFloodControlTimerLeeway = 10 * NSEC_PER_MSEC;
+
+// Identifies a session’s queue (the value is the session); see -[isOnSessionQueue].
+static char IRCClientSessionQueueKey;
 
 /******************************/
 #pragma mark - Type definitions
 /******************************/
 
-// TODO: more states? maybe to do with the NSStreamDelegate options?
+// What the session does with a numeric reply (besides passing it on to the
+// delegate); see IRCClientNumericHandlers, below.
+typedef NS_ENUM(uint8_t, IRCClientNumericHandler) {
+	IRCClientNumericHandlerNone = 0,
+	IRCClientNumericHandlerRegistrationComplete,
+	IRCClientNumericHandlerISupport,
+	IRCClientNumericHandlerChannelModes,
+	IRCClientNumericHandlerListEntry,
+	IRCClientNumericHandlerNamesReply,
+	IRCClientNumericHandlerEndOfNames,
+	IRCClientNumericHandlerSASLComplete
+};
+
+// Which of the delegate’s (optional) methods we call; worked out once, when
+// the delegate is set (see -[updateDelegateCapabilities]).
+typedef NS_OPTIONS(NSUInteger, IRCClientDelegateCapabilities) {
+	IRCClientDelegateReceivesEvents			= 1 << 0,
+	IRCClientDelegateReceivesEventBatches	= 1 << 1,
+	IRCClientDelegateRespondsToPing			= 1 << 2,
+	IRCClientDelegateCTCPRequest			= 1 << 3,
+	IRCClientDelegateCTCPReply				= 1 << 4,
+	IRCClientDelegateNamedNumeric			= 1 << 5,
+	IRCClientDelegateNumeric				= 1 << 6,
+	IRCClientDelegateUnknownEvent			= 1 << 7,
+	IRCClientDelegateConnectionTimed		= 1 << 8,
+	IRCClientDelegateReceivesBatches		= 1 << 9,
+	IRCClientDelegateFileTransferOffered	= 1 << 10,
+	IRCClientDelegateDCCChatOffered			= 1 << 11
+};
+
+// TODO: more states? maybe to do with the transport’s events?
 typedef NS_OPTIONS(NSUInteger, IRCClientSessionStateFlags) {
 	IRCClientSessionConnected		= 1 << 0,
-	IRCClientSessionMOTDReceived	= 1 << 1
+	IRCClientSessionMOTDReceived	= 1 << 1,
+	IRCClientSessionQuitSent		= 1 << 2,
+	// Registration is on hold until we send CAP END.
+	IRCClientSessionNegotiatingCapabilities	= 1 << 3,
+	IRCClientSessionAuthenticating	= 1 << 4
+};
+
+/******************************/
+#pragma mark - Helper functions
+/******************************/
+
+static uint64_t IRCClientCurrentTime(void) {
+	return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+static NSUInteger IRCClientLinePartsLength(const IRCClientLinePart *parts,
+										   NSUInteger count) {
+	NSUInteger length = 0;
+	for (NSUInteger i = 0; i < count; i++)
+		length += parts[i].length;
+
+	return length;
+}
+
+// Writes the parts, and a CRLF, into the segment (which must be big enough).
+static void IRCClientOutputSegmentWriteLineParts(IRCClientOutputSegment *segment,
+												 const IRCClientLinePart *parts,
+												 NSUInteger count) {
+	uint8_t *cursor = segment->bytes;
+	for (NSUInteger i = 0; i < count; i++) {
+		memcpy(cursor, parts[i].bytes, parts[i].length);
+		cursor += parts[i].length;
+	}
+	memcpy(cursor, C_string_crlf, 2);
+	cursor += 2;
+
+	segment->length = (NSUInteger) (cursor - segment->bytes);
+}
+
+// Returns the length of the part of an outbound line that may be logged: all
+// of it, unless the line carries credentials (PASS, OPER, AUTHENTICATE), in
+// which case only as far as the command.
+static NSUInteger IRCClientLoggableLength(const uint8_t *bytes,
+										  NSUInteger length) {
+	NSUInteger commandStart = 0;
+	if (   length > 0
+		&& bytes[0] == ':') {
+		while (commandStart < length && bytes[commandStart] != ' ')
+			commandStart++;
+		while (commandStart < length && bytes[commandStart] == ' ')
+			commandStart++;
+	}
+
+	NSUInteger commandEnd = commandStart;
+	while (commandEnd < length && bytes[commandEnd] != ' ')
+		commandEnd++;
+
+	const char *command = (const char *) (bytes + commandStart);
+	NSUInteger commandLength = commandEnd - commandStart;
+	if (   (commandLength == 4 && strncasecmp(command, "PASS", 4) == 0)
+		|| (commandLength == 4 && strncasecmp(command, "OPER", 4) == 0)
+		|| (commandLength == 12 && strncasecmp(command, "AUTHENTICATE", 12) == 0))
+		return commandEnd;
+
+	return length;
+}
+
+static BOOL IRCClientDataIsEqualToCString(NSData *data,
+										  const char *string) {
+	return (   data.length == strlen(string)
+			&& strncasecmp(data.bytes, string, data.length) == 0);
+}
+
+// Returns NO if the data isn’t a decimal number.
+static BOOL IRCClientDataUnsignedValue(NSData *data,
+									   uint64_t *value) {
+	const uint8_t *bytes = data.bytes;
+	if (data.length == 0)
+		return NO;
+
+	uint64_t result = 0;
+	for (NSUInteger i = 0; i < data.length; i++) {
+		if (bytes[i] < '0' || bytes[i] > '9')
+			return NO;
+		result = result * 10 + (bytes[i] - '0');
+	}
+	*value = result;
+
+	return YES;
+}
+
+// A DCC request gives an IPv4 address as a (decimal) number, and an IPv6
+// address as is; returns the address as is either way (nil if it’s neither).
+static NSData *IRCClientDCCAddressFromArgument(NSData *argument) {
+	uint64_t number;
+	if (IRCClientDataUnsignedValue(argument, &number)) {
+		if (number > UINT32_MAX)
+			return nil;
+		struct in_addr address4 = { .s_addr = htonl((uint32_t) number) };
+		char string[INET_ADDRSTRLEN];
+		inet_ntop(AF_INET, &address4, string, sizeof(string));
+		return [NSData dataWithBytes:string
+							  length:strlen(string)];
+	}
+
+	return (argument.length > 0 ? argument : nil);
+}
+
+// Chat history is history; the messages in it aren’t to be acted on.
+static BOOL IRCClientBatchIsChatHistory(IRCClientEventBatch *batch) {
+	NSData *type = batch.batchType;
+	return (   type.length == strlen("chathistory")
+			&& memcmp(type.bytes, "chathistory", type.length) == 0);
+}
+
+/******************************************/
+#pragma mark - Numeric reply dispatch table
+/******************************************/
+
+// Indexed by numeric reply code (000–999).
+static const IRCClientNumericHandler IRCClientNumericHandlers[1000] = {
+	[1]		= IRCClientNumericHandlerRegistrationComplete,	// RPL_WELCOME
+	[5]		= IRCClientNumericHandlerISupport,				// RPL_ISUPPORT
+	[324]	= IRCClientNumericHandlerChannelModes,			// RPL_CHANNELMODEIS
+	[346]	= IRCClientNumericHandlerListEntry,				// RPL_INVITELIST
+	[348]	= IRCClientNumericHandlerListEntry,				// RPL_EXCEPTLIST
+	[353]	= IRCClientNumericHandlerNamesReply,			// RPL_NAMREPLY
+	[366]	= IRCClientNumericHandlerEndOfNames,			// RPL_ENDOFNAMES
+	[367]	= IRCClientNumericHandlerListEntry,				// RPL_BANLIST
+	[376]	= IRCClientNumericHandlerRegistrationComplete,	// RPL_ENDOFMOTD
+	[422]	= IRCClientNumericHandlerRegistrationComplete,	// ERR_NOMOTD
+	[903]	= IRCClientNumericHandlerSASLComplete,			// RPL_SASLSUCCESS
+	[904]	= IRCClientNumericHandlerSASLComplete,			// ERR_SASLFAIL
+	[905]	= IRCClientNumericHandlerSASLComplete,			// ERR_SASLTOOLONG
+	[906]	= IRCClientNumericHandlerSASLComplete,			// ERR_SASLABORTED
+	[907]	= IRCClientNumericHandlerSASLComplete,			// ERR_SASLALREADY
 };
 
 /***************************************************/
@@ -47,19 +277,88 @@ typedef NS_OPTIONS(NSUInteger, IRCClientSessionStateFlags) {
 /***************************************************/
 
 @implementation IRCClientSession {
-	NSInputStream *_iStream;
-	NSOutputStream *_oStream;
+	IRCClientReceiveBuffer _receiveBuffer;
+	IRCClientOutputQueue _outputQueue;
+	IRCClientOutputScheduler _outputScheduler;
 
-	NSMutableData *_receivedData;
-	NSMutableData *_dataToSend;
+	dispatch_source_t _floodControlTimer;
 
 	dispatch_queue_t _q;
+	// The event loop queue that _q runs on (nil if none).
+	dispatch_queue_t _loopQueue;
 
 	void (^_cleanupHandler)();
 
-	NSMutableDictionary <NSData *, IRCClientChannel *> *_channels;
+	// Keyed by interned channel name (and so case-insensitive).
+	NSMutableDictionary <IRCClientIdentifier *, IRCClientChannel *> *_channels;
+	NSMutableData *_lookupKey;
+
+	IRCClientIdentifierPool *_identifiers;
+	IRCClientIdentifier *_ownNick;
+
+	NSMutableDictionary <NSData *, IRCClientCommandHandler> *_commandHandlers;
 
 	IRCClientSessionStateFlags _stateFlags;
+
+	IRCClientServerSupport _serverSupport;
+	// The limits that command methods check, which (unlike _serverSupport)
+	// may be read on any thread; kept up to date by -[replaceServerSupport:].
+	_Atomic(NSUInteger) _lineLength;
+	_Atomic(NSUInteger) _targetLimits[IRCClientTargetCommandCount];
+
+	IRCClientDelegateCapabilities _delegateCapabilities;
+
+	// Received messages not yet passed on to the delegate (see
+	// -[batchesEvents]), and when the first of them was received.
+	IRCClientEventBatch *_eventBatch;
+	uint64_t _eventBatchStart;
+
+	// The event filters, compiled (nil if there are none).
+	IRCClientEventMatcher *_eventMatcher;
+
+	IRCClientLogger *_logger;
+
+	// Batches delivered to the delegate but not yet consumed (see
+	// -[inboundEventLimit]).
+	NSMutableSet <IRCClientEventBatch *> *_pendingEventBatches;
+
+	// Bumped to call off a scheduled reconnect (see -[reconnects]).
+	NSUInteger _reconnectGeneration;
+
+	// The channels (and their keys, or empty data) to rejoin once we’ve
+	// reconnected (nil if there’s nothing to recover), how many of them
+	// we haven’t yet got back into, and when the connection was lost.
+	NSArray <NSData *> *_rejoinChannels;
+	NSArray <NSData *> *_rejoinKeys;
+	NSUInteger _rejoinsPending;
+	uint64_t _connectionLostTime;
+
+	// Keys given to -[join:key:], keyed by interned channel name (for
+	// channels whose key we don’t see in their modes).
+	NSMutableDictionary <IRCClientIdentifier *, NSData *> *_channelKeys;
+
+	// When the transport opened (for the registration timing).
+	uint64_t _transportOpenTime;
+
+	// The transport that -[connect] made (rather than one that was set), if
+	// it’s still the transport; it’s made afresh on each connect.
+	id <IRCClientTransport> _ownedTransport;
+
+	// IRCv3 capabilities the server has offered (name to value, or empty
+	// data), and those it has enabled.
+	NSMutableDictionary <NSData *, NSData *> *_offeredCapabilities;
+	NSMutableSet <NSData *> *_enabledCapabilities;
+
+	// Requests whose replies are being gathered up, in the order sent (see
+	// -[collectMessage:]).
+	NSMutableArray <IRCClientReply *> *_pendingReplies;
+
+	// IRCv3 batches that have been started but not yet ended, keyed by
+	// reference tag.
+	NSMutableDictionary <NSData *, IRCClientEventBatch *> *_openBatches;
+
+	// DCC transfers offered (by us or to us) or under way.
+	NSMutableArray <IRCClientDCCTransfer *> *_transfers;
 }
 
 /******************************/
@@ -67,16 +366,135 @@ typedef NS_OPTIONS(NSUInteger, IRCClientSessionStateFlags) {
 /******************************/
 
 -(NSDictionary <NSData *, IRCClientChannel *> *) channels {
-	return [_channels copy];
+	// Internally, channels are keyed by their interned names.
+	NSMutableDictionary <NSData *, IRCClientChannel *> *channels = [NSMutableDictionary dictionaryWithCapacity:_channels.count];
+	for (IRCClientChannel *channel in _channels.objectEnumerator)
+		channels[channel.name] = channel;
+
+	return channels;
+}
+
+-(const IRCClientServerSupport *) serverSupport {
+	return &_serverSupport;
+}
+
+-(IRCClientIdentifierPool *) identifiers {
+	return _identifiers;
 }
 
 -(BOOL) isConnected {
 	return (_stateFlags & IRCClientSessionConnected);
 }
 
+-(NSSet <NSData *> *) enabledCapabilities {
+	return [_enabledCapabilities copy];
+}
+
+-(NSUInteger) outputBytesQueued {
+	return _outputQueue.bytesQueued + _outputScheduler.bytesQueued;
+}
+
+-(NSUInteger) outputHighWaterMark {
+	return _outputQueue.highWaterMark;
+}
+
+-(NSUInteger) outputMessagesQueued {
+	return _outputScheduler.messagesQueued;
+}
+
+-(NSTimeInterval) outputQueueDelay {
+	return ((NSTimeInterval) _outputScheduler.lastDelay) / NSEC_PER_SEC;
+}
+
+-(NSTimeInterval) outputMaxQueueDelay {
+	return ((NSTimeInterval) _outputScheduler.maxDelay) / NSEC_PER_SEC;
+}
+
+-(void) setDelegate:(id <IRCClientSessionDelegate>)delegate {
+	_delegate = delegate;
+	[self updateDelegateCapabilities];
+}
+
+-(void) setBatchesEvents:(BOOL)batchesEvents {
+	_batchesEvents = batchesEvents;
+	[self updateDelegateCapabilities];
+}
+
+-(void) setEventFilters:(NSArray <IRCClientEventFilter *> *)eventFilters {
+	_eventFilters = [eventFilters copy];
+
+	NSArray <IRCClientEventFilter *> *filters = _eventFilters;
+	dispatch_async(_q, ^{
+		[self compileEventFilters:filters];
+	});
+}
+
+-(void) setLogLevel:(IRCClientLogLevel)logLevel {
+	_logLevel = logLevel;
+
+	// (Only takes effect if nothing has been logged yet.)
+	_logger.capacity = (logLevel > IRCClientLogLevelInfo
+						? IRCClientLogCapacity
+						: IRCClientLogQuietCapacity);
+}
+
+-(id <IRCClientLogSink>) logSink {
+	return _logger.sink;
+}
+
+-(void) setLogSink:(id <IRCClientLogSink>)logSink {
+	_logger.sink = logSink;
+}
+
+-(NSUInteger) logRecordsDropped {
+	return _logger.recordsDropped;
+}
+
+-(void) setInboundEventLimit:(NSUInteger)inboundEventLimit {
+	_inboundEventLimit = inboundEventLimit;
+	dispatch_async(_q, ^{
+		[self resumeReadingIfDrained];
+	});
+}
+
+-(void) setInboundByteLimit:(NSUInteger)inboundByteLimit {
+	_inboundByteLimit = inboundByteLimit;
+	dispatch_async(_q, ^{
+		[self resumeReadingIfDrained];
+	});
+}
+
+-(void) setFloodControlBurst:(NSUInteger)floodControlBurst {
+	_floodControlBurst = floodControlBurst;
+	[self configureFloodControl];
+}
+
+-(void) setFloodControlInterval:(NSTimeInterval)floodControlInterval {
+	_floodControlInterval = floodControlInterval;
+	[self configureFloodControl];
+}
+
 +(NSDictionary *) ircNumericCodes {
-	if (ircNumericCodeList == nil)
-		[IRCClientSession loadNumericCodes];
+	// The numerics table is compiled in (see IRCClientNumericsTable.h); this
+	// dictionary is only built, once, for clients that ask for it.
+	static NSDictionary *ircNumericCodeList;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		NSMutableDictionary *numericCodes = [NSMutableDictionary dictionary];
+		for (NSUInteger code = 0; code < IRCClientNumericCodeCount; code++) {
+			NSUInteger nameCount = IRCClientNumericNameCount(code);
+			if (nameCount == 0)
+				continue;
+
+			NSMutableArray *names = [NSMutableArray arrayWithCapacity:nameCount];
+			for (NSUInteger i = 0; i < nameCount; i++)
+				[names addObject:@(IRCClientNumericNameAtIndex(code, i))];
+			numericCodes[[NSString stringWithFormat:@"%lu", (unsigned long) code]] = @{ @"names": names };
+		}
+		numericCodes[@"source"] = @IRCClientNumericsSource;
+
+		ircNumericCodeList = [numericCodes copy];
+	});
 
 	return ircNumericCodeList;
 }
@@ -89,32 +507,109 @@ typedef NS_OPTIONS(NSUInteger, IRCClientSessionStateFlags) {
 	return [self new];
 }
 
++(instancetype) sessionWithEventLoop:(IRCClientEventLoop *)eventLoop {
+	return [[self alloc] initWithEventLoop:eventLoop];
+}
+
 -(instancetype) init {
+	return [self initWithEventLoop:nil];
+}
+
+-(instancetype) initWithEventLoop:(IRCClientEventLoop *)eventLoop {
 	if (!(self = [super init]))
 		return nil;
 
 	_version = [[NSString stringWithFormat:@"IRCClient Framework v%s (Said Achmiz)", IRCCLIENTVERSION] dataAsUTF8];
 
 	_channels = [NSMutableDictionary dictionary];
+	_lookupKey = [NSMutableData dataWithCapacity:64];
+	_commandHandlers = [NSMutableDictionary dictionary];
 	_encoding = NSUTF8StringEncoding;
 
+	_colorCodeHandling = IRCClientColorCodeHandlingIgnore;
+
+	_eventBatchLimit = IRCClientEventBatchDefaultLimit;
+	_eventBatchLatency = IRCClientEventBatchDefaultLatency;
+	_pendingEventBatches = [NSMutableSet set];
+	_pendingReplies = [NSMutableArray array];
+	_openBatches = [NSMutableDictionary dictionary];
+	_transfers = [NSMutableArray array];
+
+	_reconnectInitialDelay = IRCClientReconnectDefaultInitialDelay;
+	_reconnectMaxDelay = IRCClientReconnectDefaultMaxDelay;
+	_channelKeys = [NSMutableDictionary dictionary];
+
+	_requestedCapabilities = @[ [@"server-time" dataAsUTF8],
+								[@"message-tags" dataAsUTF8],
+								[@"account-tag" dataAsUTF8],
+								[@"batch" dataAsUTF8] ];
+	_offeredCapabilities = [NSMutableDictionary dictionary];
+	_enabledCapabilities = [NSMutableSet set];
+
+	_logLevel = IRCClientLogLevelInfo;
+	_logger = [[IRCClientLogger alloc] initWithCapacity:IRCClientLogQuietCapacity];
+	_logger.sink = [IRCClientLogConsoleSink new];
+
+	IRCClientServerSupportInit(&_serverSupport);
+	atomic_init(&_lineLength, _serverSupport.lineLength);
+	for (NSUInteger i = 0; i < IRCClientTargetCommandCount; i++)
+		atomic_init(&_targetLimits[i], _serverSupport.targetLimits[i]);
+	_identifiers = [[IRCClientIdentifierPool alloc] initWithCaseFold:_serverSupport.caseFold];
+
 	_userInfo = [NSMutableDictionary dictionary];
 
-	_q = dispatch_queue_create("Q", DISPATCH_QUEUE_SERIAL);
+	// With an event loop, our queue is pinned to one of its loops (so it is
+	// serviced by that loop’s thread); otherwise, it’s a queue of our own.
+	_eventLoop = eventLoop;
+	_loopQueue = [_eventLoop nextQueue];
+	_q = dispatch_queue_create_with_target("Q", DISPATCH_QUEUE_SERIAL, _loopQueue);
+	dispatch_queue_set_specific(_q, &IRCClientSessionQueueKey, (__bridge void *) self, NULL);
+
+	_floodControlBurst = IRCClientFloodControlDefaultBurst;
+	_floodControlInterval = IRCClientFloodControlDefaultInterval;
+	IRCClientOutputSchedulerConfigure(&_outputScheduler,
+									  _floodControlBurst,
+									  (uint64_t) (_floodControlInterval * NSEC_PER_SEC),
+									  IRCClientCurrentTime());
+
+	// Fires when flood control will next allow a held message to be sent.
+	__weak typeof(self) weakSelf = self;
+	_floodControlTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, _q);
+	dispatch_source_set_timer(_floodControlTimer,
+							  DISPATCH_TIME_FOREVER,
+							  DISPATCH_TIME_FOREVER,
+							  IRCClientFloodControlTimerLeeway);
+	dispatch_source_set_event_handler(_floodControlTimer, ^{
+		[weakSelf releaseScheduledMessages];
+	});
+	dispatch_resume(_floodControlTimer);
 
 	return self;
 }
 
 -(void) dealloc {
 	if (self.isConnected) {
-		NSLog(@"WARNING: IRC Session is not disconnected on dealloc");
+		IRCClientSessionLog(IRCClientLogLevelWarning, "IRC Session is not disconnected on dealloc");
 	}
+
+	dispatch_source_cancel(_floodControlTimer);
+
+	IRCClientReceiveBufferFree(&_receiveBuffer);
+	IRCClientOutputQueueFree(&_outputQueue);
+	IRCClientOutputSchedulerFree(&_outputScheduler);
+
+	// (Drains whatever is still in the log.)
+	[_logger close];
 }
 
 /***************************/
 #pragma mark - Class methods
 /***************************/
 
++(const char *) nameForNumericCode:(NSUInteger)code {
+	return IRCClientNumericName(code);
+}
+
 +(NSData *) nickFromNickUserHost:(NSData *)nickUserHost {
 	if (nickUserHost == nil)
 		return nil;
@@ -166,467 +661,824 @@ typedef NS_OPTIONS(NSUInteger, IRCClientSessionStateFlags) {
 	}
 }
 
-// TODO: implement color support
 -(NSData *) colorConvertToMIRC:(NSData *)message {
-	NSMutableData *workingCopy = [message mutableCopy];
-
-	[@[ @[ @"[B]", @"[/B]", [NSData dataFromCString:"\x02"] ],
-		@[ @"[I]", @"[/I]", [NSData dataFromCString:"\x16"] ],
-		@[ @"[U]", @"[/U]", [NSData dataFromCString:"\x1F"] ] ] forEach:^(NSArray *tags) {
-			NSData *openingTag = [tags[0] dataUsingEncoding:self.encoding];
-			NSData *closingTag = [tags[1] dataUsingEncoding:self.encoding];
-			NSData *mircCode = tags[2];
-
-			NSRange rangeOfOpeningTag, rangeOfClosingTag;
-			do {
-				// Find next opening tag.
-				rangeOfOpeningTag = [workingCopy rangeOfData:openingTag
-													 options:(NSDataSearchOptions) 0
-													   range:workingCopy.fullRange];
-				if (rangeOfOpeningTag.location != NSNotFound) {
-					// Replace opening tag.
-					[workingCopy replaceBytesInRange:rangeOfOpeningTag
-										   withBytes:mircCode.bytes
-											  length:mircCode.length];
-
-					// Find next closing tag.
-					rangeOfClosingTag = [workingCopy rangeOfData:closingTag
-														 options:(NSDataSearchOptions) 0
-														   range:[workingCopy rangeAfterRange:NSMakeRange(rangeOfOpeningTag.location,
-																										  mircCode.length)]];
-					if (rangeOfClosingTag.location != NSNotFound) {
-						// Replace closing tag, if any.
-						[workingCopy replaceBytesInRange:rangeOfClosingTag
-											   withBytes:mircCode.bytes
-												  length:mircCode.length];
-					} else {
-						// Otherwise, end the string with a closing tag.
-						[workingCopy appendBytes:mircCode.bytes
-										  length:mircCode.length];
-					}
-				}
-			} while (rangeOfOpeningTag.location != NSNotFound);
-
-			// Clean up stray closing tags.
-			do {
-				rangeOfClosingTag = [workingCopy rangeOfData:closingTag
-													 options:(NSDataSearchOptions) 0
-													   range:workingCopy.fullRange];
-				if (rangeOfClosingTag.location != NSNotFound) {
-					[workingCopy replaceBytesInRange:rangeOfClosingTag
-										   withBytes:mircCode.bytes
-											  length:mircCode.length];
-				}
-			} while (rangeOfClosingTag.location != NSNotFound);
-		}];
-
-	return [workingCopy copy];
+	return IRCClientFormattingConvertToMIRC(message);
 }
 
 -(NSData *) colorConvertFromMIRC:(NSData *)message {
-	// TODO: Implement this for real!
-	return [self colorStripFromMIRC:message];
+	return IRCClientFormattingConvertFromMIRC(message);
 }
 
-// TODO: implement this!
 -(NSData *) colorStripFromMIRC:(NSData *)message {
-	return message;
-}
-
-/*************************************/
-#pragma mark - Class methods (private)
-/*************************************/
-
-+(void) loadNumericCodes {
-	NSString* numericCodeListPath = [[NSBundle bundleForClass:[self class]] pathForResource:@"IRC_Numerics"
-																					 ofType:@"plist"];
-	ircNumericCodeList = [NSDictionary dictionaryWithContentsOfFile:numericCodeListPath];
-	if (ircNumericCodeList) {
-		NSLog(@"IRC numeric codes list loaded successfully.\n");
-	} else {
-		NSLog(@"Could not load IRC numeric codes list!\n");
-	}
+	return IRCClientFormattingStripMIRC(message);
 }
 
-/******************************/
-#pragma mark - NSStreamDelegate
-/******************************/
-
--(void) stream:(NSStream *)stream
-   handleEvent:(NSStreamEvent)eventCode {
-	switch (eventCode) {
-		case NSStreamEventNone: {
-			NSLog(@"NSStreamEventNone");
+/****************************************/
+#pragma mark - IRCClientTransportDelegate
+/****************************************/
 
-			break;
-		}
-		case NSStreamEventOpenCompleted: {
-			NSLog(@"NSStreamEventOpenCompleted");
-			dispatch_async(_q, ^{
-				_stateFlags |= IRCClientSessionConnected;
-			});
+/*	NOTE: The transport delivers its events on the session queue, so there’s
+	no need to dispatch anything onto it here.
+ */
 
-			break;
-		}
-		case NSStreamEventHasBytesAvailable: {
-			NSLog(@"NSStreamEventHasBytesAvailable");
-			dispatch_async(_q, ^{
-				[self receiveData:((NSInputStream *) stream)];
-			});
+-(void) transportDidOpen:(id <IRCClientTransport>)transport {
+	IRCClientSessionLog(IRCClientLogLevelInfo, "Transport opened.");
+	_stateFlags |= IRCClientSessionConnected;
+	_transportOpenTime = IRCClientCurrentTime();
+}
 
-			break;
-		}
-		case NSStreamEventHasSpaceAvailable: {
-			NSLog(@"NSStreamEventHasSpaceAvailable");
-			dispatch_async(_q, ^{
-				if (_dataToSend.length > 0)
-					[self sendData:((NSOutputStream *) stream)];
-			});
+-(void) transportHasBytesAvailable:(id <IRCClientTransport>)transport {
+	// (A transport that can’t suspend reading may still tell us about bytes
+	// while reading is paused; they’ll be read when it’s resumed.)
+	[self receiveData];
+}
 
-			break;
-		}
-		case NSStreamEventErrorOccurred: {
-			NSLog(@"NSStreamEventErrorOccurred");
-			NSLog(@"%@", stream.streamError);
-			dispatch_async(_q, ^{
-				[self disconnect];
-			});
+-(void) transportHasSpaceAvailable:(id <IRCClientTransport>)transport {
+	[self sendData];
+}
 
-			break;
-		}
-		case NSStreamEventEndEncountered: {
-			NSLog(@"NSStreamEventEndEncountered");
-			dispatch_async(_q, ^{
-				[self disconnect];
-			});
+-(void) transport:(id <IRCClientTransport>)transport
+ didFailWithError:(NSError *)error {
+	if (error != nil)
+		IRCClientSessionLog(IRCClientLogLevelError, "%s", error.description.UTF8String);
+	else
+		IRCClientSessionLog(IRCClientLogLevelInfo, "End of stream encountered.");
 
-			break;
-		}
-	}
+	[self connectionLost];
 }
 
 /****************************/
 #pragma mark - Helper methods
 /****************************/
 
--(void) sendData:(NSOutputStream *)stream {
+-(void) sendData {
 	if (self.isConnected == NO)
 		return;
 
-	// Copy up to 512 bytes of data into a buffer.
-	NSUInteger bufferSize = (_dataToSend.length < 512
-							 ? _dataToSend.length
-							 : 512);
-	uint8_t buffer[bufferSize];
-	[_dataToSend getBytes:buffer
-				   length:bufferSize];
-
-	// Write the buffer to the stream.
-	NSInteger bytesWritten = [stream write:buffer
-								 maxLength:bufferSize];
-
-	if (bytesWritten < 0) {
-		NSLog(@"%@", stream.streamError);
-		[self disconnect];
-	} else {
+	// Write queued messages out, for as long as the transport will take them.
+	// If the transport can write straight from the queued segments, it does;
+	// otherwise, we gather them into a buffer first.
+	BOOL writeVectors = [_transport respondsToSelector:@selector(writeVectors:count:)];
+	uint8_t buffer[IRCClientSendChunkSize];
+	while (_outputQueue.bytesQueued > 0) {
+		NSUInteger bytesOffered;
+		NSInteger bytesWritten;
+		if (writeVectors) {
+			struct iovec vectors[IRCClientSendMaxVectors];
+			int count = IRCClientOutputQueueGetIOVecs(&_outputQueue,
+													  vectors,
+													  IRCClientSendMaxVectors);
+			bytesOffered = 0;
+			for (int i = 0; i < count; i++)
+				bytesOffered += vectors[i].iov_len;
+
+			bytesWritten = [_transport writeVectors:vectors
+											  count:count];
+		} else {
+			bytesOffered = IRCClientOutputQueueGather(&_outputQueue,
+													  buffer,
+													  IRCClientSendChunkSize);
+
+			bytesWritten = [_transport write:buffer
+								   maxLength:bytesOffered];
+		}
+
+		if (bytesWritten < 0) {
+			IRCClientSessionLog(IRCClientLogLevelError, "%s", _transport.error.description.UTF8String);
+			[self connectionLost];
+			return;
+		}
+
 		// Discard the sent bytes.
-		[_dataToSend replaceBytesInRange:NSRangeMake(0, ((NSUInteger) bytesWritten))
-							   withBytes:NULL
-								  length:0];
+		IRCClientOutputQueueConsume(&_outputQueue,
+									((NSUInteger) bytesWritten));
+
+		// If the transport didn’t take everything, it’ll tell us when it can.
+		if (((NSUInteger) bytesWritten) < bytesOffered)
+			break;
 	}
 }
 
--(void) receiveData:(NSInputStream *)stream {
-	if (self.isConnected == NO)
+-(void) receiveData {
+	if (   self.isConnected == NO
+		|| _readingPaused)
 		return;
 
-	// Get some bytes from the stream.
-	NSUInteger bufferSize = 512;
-	uint8_t buffer[bufferSize];
-	NSInteger bytesRead = [stream read:buffer
-							 maxLength:bufferSize];
-
-	if (bytesRead < 0) {
-		NSLog(@"%@", stream.streamError);
-		[self disconnect];
-	} else if (bytesRead == 0) {
-		NSLog(@"0 bytes read (end of stream encountered).");
-		[self disconnect];
-	} else {
-		[_receivedData appendBytes:buffer
-							length:((NSUInteger) bytesRead)];
-
-		// If there’s one or more full messages in there, process them.
-		// (Otherwise, we’ll try again when more bytes have come in.)
-		NSRange crlfRange = NSRangeZero();
-		while (crlfRange.location != NSNotFound) {
-			crlfRange = [_receivedData rangeOfBytes:C_string_crlf
-											options:(NSDataSearchOptions) 0
-											  range:_receivedData.fullRange];
-			if (crlfRange.location != NSNotFound) {
-				NSRange messageRange = NSRangeMake(0, NSRangeMax(crlfRange));
-				[self handleReceivedMessage:[_receivedData subdataWithRange:messageRange]];
-				[_receivedData replaceBytesInRange:messageRange
-										 withBytes:NULL
-											length:0];
-			}
+	// Read everything the transport has for us, straight into the receive
+	// buffer, and process each full message as it comes in.
+	for (;;) {
+		// Handle the full messages in the buffer (there may be some left over
+		// from before reading was paused). Partial ones stay in the buffer
+		// until the rest of them has come in.
+		const uint8_t *line;
+		NSUInteger lineLength;
+		while (IRCClientReceiveBufferNextLine(&_receiveBuffer,
+											  &line,
+											  &lineLength)) {
+			IRCClientSessionLogLine(IRCClientLogRecordReceived, line, lineLength);
+
+			[self handleReceivedMessage:line
+								 length:lineLength];
+
+			// Handling the message may have disconnected us (and freed the
+			// receive buffer), or the delegate may have fallen behind.
+			if (   self.isConnected == NO
+				|| [self inboundBudgetOverflowed])
+				return;
+		}
+
+		if (_receiveBuffer.linesDropped > 0) {
+			IRCClientSessionLog(IRCClientLogLevelWarning,
+								"Dropped %lu over-long line(s).", (unsigned long) _receiveBuffer.linesDropped);
+			_receiveBuffer.linesDropped = 0;
+		}
+
+		NSUInteger bufferSpace;
+		uint8_t *buffer = IRCClientReceiveBufferPrepareWrite(&_receiveBuffer,
+															 &bufferSpace);
+		if (buffer == NULL) {
+			IRCClientSessionLog(IRCClientLogLevelError, "Out of memory for the receive buffer.");
+			[self connectionLost];
+			return;
+		}
+		NSInteger bytesRead = [_transport read:buffer
+									 maxLength:bufferSpace];
+
+		if (bytesRead == IRCClientTransportWouldBlock) {
+			// That’s all for this read cycle.
+			[self deliverEventBatch];
+			[self inboundBudgetOverflowed];
+			return;
+		} else if (bytesRead < 0) {
+			IRCClientSessionLog(IRCClientLogLevelError, "%s", _transport.error.description.UTF8String);
+			[self connectionLost];
+			return;
+		} else if (bytesRead == 0) {
+			IRCClientSessionLog(IRCClientLogLevelInfo, "0 bytes read (end of stream encountered).");
+			[self connectionLost];
+			return;
 		}
+
+		IRCClientReceiveBufferCommitWrite(&_receiveBuffer,
+										  ((NSUInteger) bytesRead));
 	}
 }
 
--(void) handleReceivedMessage:(NSData *)messageData {
-	NSLog(@"handleReceivedMessage: [%s]", messageData.terminatedCString);
-	NSData *prefix;
-	NSData *command;
-	NSMutableArray <NSData *> *params = [NSMutableArray array];
+-(void) handleReceivedMessage:(const uint8_t *)bytes
+					   length:(NSUInteger)length {
+	IRCClientMessage message;
+	if (IRCClientMessageParse(bytes, length, &message) == NO)
+		return;
 
-	/******************************/
-	/* State machine based parsing.
-	 */
+	// Replies to requests, and the messages in IRCv3 batches, are gathered
+	// up and handed over whole (and aren’t subject to filtering or to the
+	// inbound budget; they were asked for).
+	if (   (   _pendingReplies.count > 0
+			|| _openBatches.count > 0
+			|| IRCClientCommandLookup(message.bytes + message.command.location,
+									  message.command.length) == IRCClientCommandBATCH)
+		&& [self collectMessage:&message])
+		return;
 
-	typedef NS_ENUM(NSUInteger, IRCClientMessageParsingSection) {
-		IRCClientMessageParsingStart,
-		IRCClientMessageParsingPrefix,
-		IRCClientMessageParsingCommand,
-		IRCClientMessageParsingMiddleParams,
-		IRCClientMessageParsingTrailingParam,
-		IRCClientMessageParsingEnd
-	};
+	// If the delegate has fallen behind, drop what it can do without.
+	if (   _inboundOverflowPolicy == IRCClientInboundOverflowDropMessages
+		&& [self inboundBudgetExceeded]
+		&& [self messageMayBeFiltered:&message]) {
+		_inboundEventsDropped++;
+		return;
+	}
 
-	IRCClientMessageParsingSection section = IRCClientMessageParsingStart;
-	NSUInteger sectionStart = 0;
-	for (NSUInteger i = 0; i < messageData.length; i++) {
-		char c = ((char *)(messageData.bytes))[i];
-		switch (section) {
-			case IRCClientMessageParsingStart:
-				if (c == ':')
-					sectionStart = (i + 1);
-				section = (c == ':'
-						   ? IRCClientMessageParsingPrefix
-						   : IRCClientMessageParsingCommand);
-				break;
-			case IRCClientMessageParsingPrefix:
-				if (c == ' ') {
-					prefix = [messageData subdataWithRange:NSRangeMake(sectionStart,
-																	   i - sectionStart)];
-					sectionStart = (i + 1);
-					section = IRCClientMessageParsingCommand;
-				}
-				break;
-			case IRCClientMessageParsingCommand:
-				if (c == ' ') {
-					command = [messageData subdataWithRange:NSRangeMake(sectionStart,
-																		i - sectionStart)];
-					sectionStart = (i + 1);
-					section = IRCClientMessageParsingMiddleParams;
-				}
-				break;
-			case IRCClientMessageParsingMiddleParams:
-				if (c == ' ') {
-					[params addObject:[messageData subdataWithRange:NSRangeMake(sectionStart,
-																				i - sectionStart)]];
-					sectionStart = (i + 1);
-				} else if (c == ':') {
-					sectionStart = (i + 1);
-					section = IRCClientMessageParsingTrailingParam;
-				} else if (   ((char *)(messageData.bytes))[i]     == '\r'
-						   && ((char *)(messageData.bytes))[i + 1] == '\n') {
-					[params addObject:[messageData subdataWithRange:NSRangeMake(sectionStart,
-																				i - sectionStart)]];
-					section = IRCClientMessageParsingEnd;
-				}
-				break;
-			case IRCClientMessageParsingTrailingParam:
-				if (   ((char *)(messageData.bytes))[i]     == '\r'
-					&& ((char *)(messageData.bytes))[i + 1] == '\n') {
-					[params addObject:[messageData subdataWithRange:NSRangeMake(sectionStart,
-																				i - sectionStart)]];
-					section = IRCClientMessageParsingEnd;
-				}
-				break;
-			case IRCClientMessageParsingEnd:
-				break;
+	// Drop messages that pass none of the event filters, before anything is
+	// made of them.
+	if (   _eventMatcher != nil
+		&& [self messageMayBeFiltered:&message]) {
+		if ([_eventMatcher matchesMessage:&message] == NO) {
+			_eventFilterDroppedCount++;
+			return;
 		}
+		_eventFilterMatchedCount++;
 	}
 
-	NSMutableArray <NSData *> *parts = [NSMutableArray array];
-	[parts addObject:(prefix ?: [NSData data])];
-	[parts addObject:command];
-	[parts addObjectsFromArray:params];
-	NSLog(@"[%@]", [[parts map:^NSString *(NSData *part) {
-		return [NSString stringWithFormat:@"%s", part.terminatedCString];
-	}] componentsJoinedByString:@"]["]);
-
-	[self handleIRCEvent:command
-					from:prefix
-				  params:params];
+	if (_delegateCapabilities & IRCClientDelegateReceivesEventBatches) {
+		if (_eventBatch == nil) {
+			_eventBatch = [[IRCClientEventBatch alloc] initWithCapacity:_eventBatchLimit];
+			_eventBatchStart = IRCClientCurrentTime();
+		}
+		[_eventBatch addMessage:&message];
+	}
 
-	/**********************/
-	/* Range-based parsing.
-	 */
+	[self handleIRCEvent:&message];
 
-//	NSData *colon = [NSData dataFromCString:":"];
-//	NSData *space = [NSData dataFromCString:" "];
-//	NSData *crlf = [NSData dataFromCString:C_string_crlf];
-//
-//	NSRange remainder = messageData.fullRange;
-//	NSRange spaceRange;
-//	NSRange maybeColonRange;
-//
-//	// Prefix.
-//	maybeColonRange = NSRangeMake(remainder.location,
-//								  colon.length);
-//	if ([[messageData subdataWithRange:maybeColonRange] isEqualToData:colon]) {
-//		remainder = [messageData rangeAfterRange:maybeColonRange];
-//		spaceRange = [messageData rangeOfData:space
-//									  options:(NSDataSearchOptions) 0
-//										range:remainder];
-//		prefix = [messageData subdataWithRange:NSRangeMake(remainder.location,
-//														   spaceRange.location - remainder.location)];
-//		remainder = [messageData rangeAfterRange:spaceRange];
-//	}
-//
-//	// Command.
-//	spaceRange = [messageData rangeOfData:space
-//								  options:(NSDataSearchOptions) 0
-//									range:remainder];
-//	command = [messageData subdataWithRange:NSRangeMake(remainder.location,
-//														spaceRange.location - remainder.location)];
-//	remainder = [messageData rangeAfterRange:spaceRange];
-//
-//	// Params.
-//	while (YES) {
-//		maybeColonRange = NSRangeMake(remainder.location,
-//									  colon.length);
-//		if ([[messageData subdataWithRange:maybeColonRange] isEqualToData:colon]) {
-//			// Trailing param.
-//			remainder = [messageData rangeAfterRange:maybeColonRange];
-//			NSRange crlfRange = [messageData rangeOfData:crlf
-//												 options:(NSDataSearchOptions) 0
-//												   range:remainder];
-//			[params addObject:[messageData subdataWithRange:NSRangeMake(remainder.location,
-//																		crlfRange.location - remainder.location)]];
-//			break;
-//		} else {
-//			// Middle params.
-//			spaceRange = [messageData rangeOfData:space
-//										  options:(NSDataSearchOptions) 0
-//											range:remainder];
-//			if (spaceRange.location == NSNotFound) {
-//				NSRange crlfRange = [messageData rangeOfData:crlf
-//													 options:(NSDataSearchOptions) 0
-//													   range:remainder];
-//				[params addObject:[messageData subdataWithRange:NSRangeMake(remainder.location,
-//																			crlfRange.location - remainder.location)]];
-//				break;
-//			} else {
-//				[params addObject: [messageData subdataWithRange:NSRangeMake(remainder.location,
-//																			 spaceRange.location - remainder.location)]];
-//				remainder = [messageData rangeAfterRange:spaceRange];
-//				if ([[messageData subdataWithRange:remainder] isEqualToData:crlf])
-//					break;
-//			}
-//		}
-//	}
-//
-//	[self handleIRCEvent:command
-//					from:prefix
-//				  params:params];
+	// Don’t hold on to a batch for too long (if the server is sending faster
+	// than we can read, the read cycle may not end for a while).
+	if (   _eventBatch != nil
+		&& (   _eventBatch.count >= _eventBatchLimit
+			|| IRCClientCurrentTime() - _eventBatchStart >= (uint64_t) (_eventBatchLatency * NSEC_PER_SEC)))
+		[self deliverEventBatch];
 }
 
--(void) openStream:(NSStream *)stream {
-	[stream scheduleInRunLoop:[NSRunLoop currentRunLoop]
-					  forMode:NSDefaultRunLoopMode];
-	[stream open];
+-(BOOL) messageMayBeFiltered:(const IRCClientMessage *)message {
+	// The session must see the messages that it keeps track of the connection
+	// and of channels with, whatever the filters say.
+	NSUInteger numericEventCode;
+	if (IRCClientMessageNumericCode(message, &numericEventCode))
+		return (IRCClientNumericHandlers[numericEventCode] == IRCClientNumericHandlerNone);
+
+	switch (IRCClientCommandLookup(message->bytes + message->command.location,
+								   message->command.length)) {
+		case IRCClientCommandPRIVMSG:
+		case IRCClientCommandNOTICE:
+		case IRCClientCommandINVITE:
+		case IRCClientCommandUnknown:
+			return YES;
+		default:
+			return NO;
+	}
 }
 
--(void) closeStream:(NSStream *)stream {
-	[stream close];
-	[stream removeFromRunLoop:[NSRunLoop currentRunLoop]
-					  forMode:NSDefaultRunLoopMode];
+-(void) compileEventFilters:(NSArray <IRCClientEventFilter *> *)filters {
+	_eventMatcher = (filters.count > 0
+					 ? [[IRCClientEventMatcher alloc] initWithFilters:filters
+															 caseFold:_serverSupport.caseFold]
+					 : nil);
 }
 
-/******************************/
-#pragma mark - Instance methods
-/******************************/
-
--(int) connect {
-	if (self.isConnected)
-		return 0;
-
-	NSInputStream *iStream;
-	NSOutputStream *oStream;
-	[NSStream getStreamsToHostNamed:[NSString stringWithUTF8Data:_server]
-							   port:_port
-						inputStream:&iStream
-					   outputStream:&oStream];
-	_iStream = iStream;
-	_oStream = oStream;
+-(void) deliverEventBatch {
+	if (_eventBatch == nil)
+		return;
 
-	_receivedData = [NSMutableData data];
-	_dataToSend = [NSMutableData data];
+	IRCClientEventBatch *batch = _eventBatch;
+	_eventBatch = nil;
+
+	// (The delegate may have changed since the batch was started.)
+	if (_delegateCapabilities & IRCClientDelegateReceivesEventBatches) {
+		// With an inbound budget, the batch counts against it until the
+		// delegate is done with it (see -[eventBatchConsumed:]).
+		if (   _inboundEventLimit > 0
+			|| _inboundByteLimit > 0) {
+			[_pendingEventBatches addObject:batch];
+			_inboundEventsPending += batch.count;
+			_inboundBytesPending += batch.bytes.length;
+		}
 
-	// Prepare cleanup handler.
-	__unsafe_unretained typeof(self) weakSelf = self;
-	_cleanupHandler = ^void() {
-		_stateFlags = (IRCClientSessionStateFlags) 0;
+		[_delegate eventsReceived:batch
+						  session:self];
+	}
+}
 
-		[weakSelf closeStream:iStream];
-		[weakSelf closeStream:oStream];
+-(BOOL) inboundBudgetExceeded {
+	return (   (_inboundEventLimit > 0 && _inboundEventsPending >= _inboundEventLimit)
+			|| (_inboundByteLimit > 0 && _inboundBytesPending >= _inboundByteLimit));
+}
 
-		_iStream = nil;
-		_oStream = nil;
+// Applies the overflow policy if the budget is exceeded; returns YES if we
+// should stop reading.
+-(BOOL) inboundBudgetOverflowed {
+	if ([self inboundBudgetExceeded] == NO)
+		return NO;
 
-		_receivedData = nil;
-		_dataToSend = nil;
-		
-		_cleanupHandler = nil;
-	};
+	switch (_inboundOverflowPolicy) {
+		case IRCClientInboundOverflowPause: {
+			[self deliverEventBatch];
 
-	// Get proxy settings from system configuration.
-	NSDictionary *proxySettings = CFBridgingRelease(CFNetworkCopySystemProxySettings());
-	BOOL SOCKSProxyEnabled = ([proxySettings[(NSString *) kCFNetworkProxiesSOCKSEnable] integerValue] != 0);
-
-	// TODO: Allow setting this somehow!
-	BOOL SSLEnabled = NO;
-
-	// Configure and open streams.
-	[@[ iStream, oStream ] forEach:^(NSStream *stream) {
-		[stream setDelegate:self];
-		if (SSLEnabled)
-			[stream setProperty:NSStreamSocketSecurityLevelNegotiatedSSL
-						 forKey:NSStreamSocketSecurityLevelKey];
-		if (SOCKSProxyEnabled)
-			[stream setProperty:proxySettings
-						 forKey:NSStreamSOCKSProxyConfigurationKey];
-		[self openStream:stream];
-	}];
+			_readingPaused = YES;
+			if ([_transport respondsToSelector:@selector(suspendReading)])
+				[_transport suspendReading];
 
-	// Send PASS message (if need be).
-	if (   _password
-		&& _password.length > 0) {
-		[self sendRaw:[NSData dataWithFormat:"PASS %@", _password, nil]];
+			return YES;
+		}
+		case IRCClientInboundOverflowDisconnect: {
+			IRCClientSessionLog(IRCClientLogLevelWarning,
+								"Inbound budget exceeded (%lu messages, %lu bytes pending); disconnecting.",
+								(unsigned long) _inboundEventsPending,
+								(unsigned long) _inboundBytesPending);
+			[self disconnect];
+
+			return YES;
+		}
+		case IRCClientInboundOverflowDropMessages: {
+			// (See -[handleReceivedMessage:length:].)
+			break;
+		}
 	}
 
-	// Send NICK message.
-	[self sendRaw:[NSData dataWithFormat:"NICK %@", _nickname, nil]];
+	return NO;
+}
 
-	// Send USER message.
-	[self sendRaw:[NSData dataWithFormat:"USER %@ unknown unknown :%@", _username, _realname, nil]];
+// Resumes reading once the pending batches have drained to half the budget
+// (so that we don’t flip between paused and reading on every batch).
+-(void) resumeReadingIfDrained {
+	if (   _readingPaused == NO
+		|| (_inboundEventLimit > 0 && _inboundEventsPending > _inboundEventLimit / 2)
+		|| (_inboundByteLimit > 0 && _inboundBytesPending > _inboundByteLimit / 2))
+		return;
 
-	return 1;
+	_readingPaused = NO;
+	if ([_transport respondsToSelector:@selector(resumeReading)])
+		[_transport resumeReading];
+
+	// Catch up (with what’s left in the receive buffer, and with what the
+	// transport told us about while we were paused); but not from within
+	// the delegate call that consumed the batch.
+	dispatch_async(_q, ^{
+		[self receiveData];
+	});
 }
 
--(void) disconnect {
+// Closes the connection (if there is one), telling the delegate if we were
+// connected. Must be called on our queue.
+-(void) closeConnection {
+	if (_cleanupHandler == nil)
+		return;
+
 	if (self.isConnected) {
+		[self deliverEventBatch];
 		[_delegate disconnected:self];
-		_cleanupHandler();
 	}
+	_cleanupHandler();
+
+	// Requests still waiting for their replies won’t get them now.
+	NSArray <IRCClientReply *> *pendingReplies = [_pendingReplies copy];
+	[_pendingReplies removeAllObjects];
+	for (IRCClientReply *reply in pendingReplies)
+		reply.completion(nil, self);
 }
 
--(BOOL) setNickname:(NSData *)nickname
-		   username:(NSData *)username
-		   realname:(NSData *)realname {
+// Called (on our queue) when the connection fails or is closed from the
+// other end. Reconnects (after a while), if we’re set to, and if we didn’t
+// ask for it by sending a QUIT.
+-(void) connectionLost {
+	if (   _reconnects == NO
+		|| (_stateFlags & IRCClientSessionQuitSent)) {
+		[self stopReconnecting];
+		[self closeConnection];
+		return;
+	}
+
+	// Note what channels we were on (unless the connection was lost again
+	// before we got back into all of them, in which case we already have).
+	if (_rejoinChannels == nil) {
+		NSMutableArray <NSData *> *channels = [NSMutableArray arrayWithCapacity:_channels.count];
+		NSMutableArray <NSData *> *keys = [NSMutableArray arrayWithCapacity:_channels.count];
+		[_channels enumerateKeysAndObjectsUsingBlock:^(IRCClientIdentifier *identifier,
+													   IRCClientChannel *channel,
+													   BOOL *stop) {
+			[channels addObject:channel.name];
+			[keys addObject:([channel parameterForMode:'k'] ?: (_channelKeys[identifier] ?: [NSData data]))];
+		}];
+		_rejoinChannels = channels;
+		_rejoinKeys = keys;
+	}
+	_rejoinsPending = 0;
+	if (_connectionLostTime == 0)
+		_connectionLostTime = IRCClientCurrentTime();
+
+	[self closeConnection];
+	[_channels removeAllObjects];
+
+	[self scheduleReconnect];
+}
+
+-(void) scheduleReconnect {
+	_reconnectAttempts++;
+	if (   _reconnectMaxAttempts > 0
+		&& _reconnectAttempts > _reconnectMaxAttempts) {
+		IRCClientSessionLog(IRCClientLogLevelWarning,
+							"Giving up reconnecting after %lu attempts.",
+							(unsigned long) _reconnectMaxAttempts);
+		[self stopReconnecting];
+		return;
+	}
+
+	// Exponential backoff, with “equal jitter” (half of the delay, plus a
+	// random part of the other half), so that clients dropped all at once
+	// don’t all come back at once.
+	NSTimeInterval delay = MIN(_reconnectInitialDelay * exp2((double) MIN(_reconnectAttempts - 1, (NSUInteger) 32)),
+							   _reconnectMaxDelay);
+	delay = (delay / 2.0) + (delay / 2.0) * ((double) arc4random_uniform(UINT32_MAX) / UINT32_MAX);
+
+	IRCClientSessionLog(IRCClientLogLevelInfo,
+						"Reconnecting in %.1f seconds (attempt %lu).",
+						delay,
+						(unsigned long) _reconnectAttempts);
+
+	NSUInteger generation = _reconnectGeneration;
+	__weak typeof(self) weakSelf = self;
+	dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t) (delay * NSEC_PER_SEC)), _q, ^{
+		IRCClientSession *session = weakSelf;
+		if (   session == nil
+			|| session->_reconnectGeneration != generation)
+			return;
+
+		[session connect];
+	});
+}
+
+// Calls off any scheduled reconnect, and forgets what was to be recovered.
+-(void) stopReconnecting {
+	_reconnectGeneration++;
+	_reconnectAttempts = 0;
+
+	_rejoinChannels = nil;
+	_rejoinKeys = nil;
+	_rejoinsPending = 0;
+	_connectionLostTime = 0;
+}
+
+// Called once we’re registered: rejoins the channels we were on before the
+// connection was lost (as few JOIN lines as possible, all queued at once).
+-(void) rejoinChannels {
+	_reconnectAttempts = 0;
+
+	if (_rejoinChannels.count > 0) {
+		_rejoinsPending = _rejoinChannels.count;
+		[self joinChannels:_rejoinChannels
+					  keys:_rejoinKeys];
+	} else {
+		[self recoveryFinished];
+	}
+}
+
+-(void) recoveryFinished {
+	// (Nothing to recover on a first connection.)
+	if (_connectionLostTime == 0)
+		return;
+
+	_lastRecoveryDuration = (IRCClientCurrentTime() - _connectionLostTime) / (NSTimeInterval) NSEC_PER_SEC;
+	IRCClientSessionLog(IRCClientLogLevelInfo,
+						"Recovered from lost connection in %.3f seconds.",
+						_lastRecoveryDuration);
+
+	_rejoinChannels = nil;
+	_rejoinKeys = nil;
+	_rejoinsPending = 0;
+	_connectionLostTime = 0;
+}
+
+-(void) rememberKey:(NSData *)key
+		 forChannel:(NSData *)channel {
+	key = [key copy];
+	channel = [channel copy];
+	void (^remember)(void) = ^{
+		_channelKeys[[_identifiers identifierForBytes:channel.bytes
+											   length:channel.length]] = key;
+	};
+
+	if ([self isOnSessionQueue])
+		remember();
+	else
+		dispatch_async(_q, remember);
+}
+
+-(void) reportConnectionTimings {
+	IRCClientConnectionTimings timings = {
+		.registration = (IRCClientCurrentTime() - _transportOpenTime) / (NSTimeInterval) NSEC_PER_SEC
+	};
+	if ([_transport respondsToSelector:@selector(resolveDuration)])
+		timings.resolve = _transport.resolveDuration;
+	if ([_transport respondsToSelector:@selector(connectDuration)])
+		timings.connect = _transport.connectDuration;
+	if ([_transport respondsToSelector:@selector(handshakeDuration)])
+		timings.handshake = _transport.handshakeDuration;
+
+	IRCClientSessionLog(IRCClientLogLevelDebug,
+						"Registered (resolve %.3f s, connect %.3f s, handshake %.3f s, registration %.3f s).",
+						timings.resolve,
+						timings.connect,
+						timings.handshake,
+						timings.registration);
+
+	if (_delegateCapabilities & IRCClientDelegateConnectionTimed)
+		[_delegate connectionTimed:timings
+						   session:self];
+}
+
+-(void) updateDelegateCapabilities {
+	id <IRCClientSessionDelegate> delegate = _delegate;
+
+	IRCClientDelegateCapabilities capabilities = (IRCClientDelegateCapabilities) 0;
+	if (   _batchesEvents
+		&& [delegate respondsToSelector:@selector(eventsReceived:session:)]) {
+		capabilities = IRCClientDelegateReceivesEventBatches;
+	} else {
+		capabilities = IRCClientDelegateReceivesEvents;
+		if ([delegate respondsToSelector:@selector(ping:from:session:)])
+			capabilities |= IRCClientDelegateRespondsToPing;
+		if ([delegate respondsToSelector:@selector(CTCPRequestReceived:ofType:fromUser:session:)])
+			capabilities |= IRCClientDelegateCTCPRequest;
+		if ([delegate respondsToSelector:@selector(CTCPReplyReceived:fromUser:session:)])
+			capabilities |= IRCClientDelegateCTCPReply;
+		if ([delegate respondsToSelector:@selector(numericEventReceived:name:from:params:session:)])
+			capabilities |= IRCClientDelegateNamedNumeric;
+		if ([delegate respondsToSelector:@selector(numericEventReceived:from:params:session:)])
+			capabilities |= IRCClientDelegateNumeric;
+		if ([delegate respondsToSelector:@selector(unknownEventReceived:from:params:session:)])
+			capabilities |= IRCClientDelegateUnknownEvent;
+	}
+
+	if ([delegate respondsToSelector:@selector(connectionTimed:session:)])
+		capabilities |= IRCClientDelegateConnectionTimed;
+	if ([delegate respondsToSelector:@selector(batchReceived:session:)])
+		capabilities |= IRCClientDelegateReceivesBatches;
+	if ([delegate respondsToSelector:@selector(fileTransferOffered:session:)])
+		capabilities |= IRCClientDelegateFileTransferOffered;
+	if ([delegate respondsToSelector:@selector(DCCChatOffered:port:fromUser:session:)])
+		capabilities |= IRCClientDelegateDCCChatOffered;
+
+	_delegateCapabilities = capabilities;
+}
+
+-(void) sendPong:(const IRCClientMessage *)ping {
+	NSRange token = IRCClientMessageParamRange(ping, 0);
+	if (token.location == NSNotFound)
+		token = NSMakeRange(0, 0);
+
+	IRCClientLinePart pong[] = {
+		IRCClientLinePartCString("PONG :"),
+		{ ping->bytes + token.location, token.length }
+	};
+	[self queueLineParts:pong
+				   count:(sizeof(pong) / sizeof(IRCClientLinePart))];
+}
+
+-(BOOL) isOnSessionQueue {
+	return (dispatch_get_specific(&IRCClientSessionQueueKey) == (__bridge void *) self);
+}
+
+-(void) performOnSessionQueueAndWait:(void (^)(void))block {
+	if (   [self isOnSessionQueue]
+		|| (   _loopQueue != nil
+			&& IRCClientEventLoopCurrentQueue() == _loopQueue))
+		block();
+	else
+		dispatch_sync(_q, block);
+}
+
+// Returns NO if there’s no memory for the line (which is then not sent).
+-(BOOL) queueLineParts:(const IRCClientLinePart *)parts
+				 count:(NSUInteger)count {
+	// On the session queue, we can append to the output queue (and recycle its
+	// segments) directly; otherwise, we fill in a new segment here, and hand
+	// it over to the session queue.
+	BOOL onSessionQueue = [self isOnSessionQueue];
+
+	IRCClientOutputSegment *segment = IRCClientOutputQueueCreateSegment((onSessionQueue ? &_outputQueue : NULL),
+																		IRCClientLinePartsLength(parts, count) + 2);
+	if (segment == NULL) {
+		IRCClientSessionLog(IRCClientLogLevelError, "Out of memory for an outbound line.");
+		return NO;
+	}
+	IRCClientOutputSegmentWriteLineParts(segment, parts, count);
+
+	[self queueSegments:segment
+		 onSessionQueue:onSessionQueue];
+
+	return YES;
+}
+
+// Logs an outbound line (at the trace level), with any credentials in it
+// left out.
+-(void) logSentLine:(const uint8_t *)bytes
+			 length:(NSUInteger)length {
+	NSUInteger loggable = IRCClientLoggableLength(bytes, length);
+	if (loggable == length) {
+		IRCClientSessionLogLine(IRCClientLogRecordSent, bytes, length);
+		return;
+	}
+
+	static const char redaction[] = " <redacted>";
+	uint8_t redacted[IRCClientMaxLineLength + sizeof(redaction)];
+	loggable = MIN(loggable, (NSUInteger) IRCClientMaxLineLength);
+	memcpy(redacted, bytes, loggable);
+	memcpy(redacted + loggable, redaction, strlen(redaction));
+	IRCClientSessionLogLine(IRCClientLogRecordSent, redacted, loggable + strlen(redaction));
+}
+
+-(void) queueSegments:(IRCClientOutputSegment *)segments
+	   onSessionQueue:(BOOL)onSessionQueue {
+	void (^appendSegments)(void) = ^{
+		uint64_t now = IRCClientCurrentTime();
+
+		IRCClientOutputSegment *segment = segments;
+		while (segment != NULL) {
+			IRCClientOutputSegment *next = segment->next;
+			if (IRCClientLogLevelEnabled(IRCClientLogLevelTrace, _logLevel))
+				[self logSentLine:segment->bytes
+						   length:(segment->length - 2)];
+			IRCClientOutputSchedulerEnqueue(&_outputScheduler, segment, now);
+			segment = next;
+		}
+
+		[self releaseScheduledMessages];
+	};
+
+	if (onSessionQueue)
+		appendSegments();
+	else
+		dispatch_async(_q, appendSegments);
+}
+
+-(void) releaseScheduledMessages {
+	// Move whatever flood control allows from the scheduler to the output
+	// queue, and set the timer for when it will allow more.
+	uint64_t now = IRCClientCurrentTime();
+	uint64_t wait;
+	IRCClientOutputSegment *segment;
+	while ((segment = IRCClientOutputSchedulerDequeue(&_outputScheduler, now, &wait)) != NULL)
+		IRCClientOutputQueueAppendSegment(&_outputQueue, segment);
+
+	dispatch_source_set_timer(_floodControlTimer,
+							  (wait == UINT64_MAX
+							   ? DISPATCH_TIME_FOREVER
+							   : dispatch_time(DISPATCH_TIME_NOW, (int64_t) wait)),
+							  DISPATCH_TIME_FOREVER,
+							  IRCClientFloodControlTimerLeeway);
+
+	[self sendData];
+}
+
+-(void) configureFloodControl {
+	NSUInteger burst = _floodControlBurst;
+	uint64_t interval = (uint64_t) (MAX(_floodControlInterval, 0.0) * NSEC_PER_SEC);
+	dispatch_async(_q, ^{
+		IRCClientOutputSchedulerConfigure(&_outputScheduler,
+										  burst,
+										  interval,
+										  IRCClientCurrentTime());
+		[self releaseScheduledMessages];
+	});
+}
+
+/******************************/
+#pragma mark - Instance methods
+/******************************/
+
+-(int) connect {
+	if (self.isConnected)
+		return 0;
+
+	// Unless a transport has been provided, connect through a socket (or
+	// through NSStream, which supports SOCKS proxies, if the system
+	// configuration specifies one), with TLS over it if need be. (A transport
+	// we made before is made again, so that it picks up any change to
+	// usesTLS, the server, or the proxy settings.)
+	if (   _transport == nil
+		|| _transport == _ownedTransport) {
+		NSDictionary *proxySettings = CFBridgingRelease(CFNetworkCopySystemProxySettings());
+		BOOL SOCKSProxyEnabled = ([proxySettings[(NSString *) kCFNetworkProxiesSOCKSEnable] integerValue] != 0);
+		if (SOCKSProxyEnabled) {
+			IRCClientStreamTransport *streamTransport = [IRCClientStreamTransport new];
+			streamTransport.proxySettings = proxySettings;
+			_transport = streamTransport;
+		} else {
+			_transport = [IRCClientSocketTransport new];
+		}
+
+		if (_usesTLS)
+			_transport = [[IRCClientTLSTransport alloc] initWithTransport:_transport];
+		_ownedTransport = _transport;
+	}
+	id <IRCClientTransport> transport = _transport;
+	transport.delegate = self;
+
+	// Prepare cleanup handler.
+	_cleanupHandler = ^void() {
+		_stateFlags = (IRCClientSessionStateFlags) 0;
+
+		[transport close];
+
+		IRCClientReceiveBufferFree(&_receiveBuffer);
+		IRCClientOutputQueueFree(&_outputQueue);
+		IRCClientOutputSchedulerFree(&_outputScheduler);
+		dispatch_source_set_timer(_floodControlTimer,
+								  DISPATCH_TIME_FOREVER,
+								  DISPATCH_TIME_FOREVER,
+								  IRCClientFloodControlTimerLeeway);
+		
+		_cleanupHandler = nil;
+	};
+
+	NSString *server = [NSString stringWithUTF8Data:_server];
+	NSUInteger port = _port;
+	BOOL negotiatesCapabilities = (   _requestedCapabilities.count > 0
+								   || _SASLMechanism != IRCClientSASLMechanismNone);
+	void (^open)(void) = ^{
+		// (A reconnect scheduled before this connect is called off.)
+		_reconnectGeneration++;
+
+		IRCClientReceiveBufferInit(&_receiveBuffer,
+								   IRCClientReceiveBufferInitialCapacity);
+		_receiveBuffer.lineLimit = IRCClientMaxTagsLength + _serverSupport.lineLength;
+		IRCClientOutputQueueFree(&_outputQueue);
+		IRCClientOutputSchedulerFree(&_outputScheduler);
+		IRCClientOutputSchedulerRefill(&_outputScheduler, IRCClientCurrentTime());
+		_outputScheduler.registering = YES;
+
+		// Batches from the last connection no longer count.
+		[_pendingEventBatches removeAllObjects];
+		_inboundEventsPending = 0;
+		_inboundBytesPending = 0;
+		_readingPaused = NO;
+
+		[_offeredCapabilities removeAllObjects];
+		[_enabledCapabilities removeAllObjects];
+		[_openBatches removeAllObjects];
+		if (negotiatesCapabilities)
+			_stateFlags |= IRCClientSessionNegotiatingCapabilities;
+
+		// A new server may support different things than the last one did.
+		IRCClientServerSupport serverSupport;
+		IRCClientServerSupportInit(&serverSupport);
+		[self replaceServerSupport:&serverSupport];
+		_ownNick = [_identifiers identifierForBytes:_nickname.bytes
+											 length:_nickname.length];
+
+		[transport openToHost:server
+						 port:port
+						queue:_q];
+	};
+
+	// (On our queue, i.e. when reconnecting, this must happen before the
+	// registration messages below are queued, not after.)
+	if ([self isOnSessionQueue])
+		open();
+	else
+		dispatch_async(_q, open);
+
+	// Send PASS message (if need be).
+	if (   _password
+		&& _password.length > 0) {
+		IRCClientLinePart pass[] = {
+			IRCClientLinePartCString("PASS "),
+			IRCClientLinePartData(_password)
+		};
+		[self sendLineParts:pass
+					  count:(sizeof(pass) / sizeof(IRCClientLinePart))];
+	}
+
+	// Ask what IRCv3 capabilities the server has (if need be). The server
+	// holds off registering us until we’re done negotiating, so NICK and
+	// USER can go in the same flight; see -[capabilitiesReceived:].
+	if (negotiatesCapabilities) {
+		IRCClientLinePart cap[] = {
+			IRCClientLinePartCString("CAP LS 302")
+		};
+		[self sendLineParts:cap
+					  count:(sizeof(cap) / sizeof(IRCClientLinePart))];
+	}
+
+	// Send NICK message.
+	[self nick:_nickname];
+
+	// Send USER message.
+	IRCClientLinePart user[] = {
+		IRCClientLinePartCString("USER "),
+		IRCClientLinePartData(_username),
+		IRCClientLinePartCString(" unknown unknown :"),
+		IRCClientLinePartData(_realname)
+	};
+	[self sendLineParts:user
+				  count:(sizeof(user) / sizeof(IRCClientLinePart))];
+
+	return 1;
+}
+
+-(void) disconnect {
+	void (^disconnect)(void) = ^{
+		// We meant to disconnect, so we won’t be reconnecting.
+		[self stopReconnecting];
+		[self closeConnection];
+	};
+
+	// (Not dispatch_sync: our queue may share an event loop’s queue with
+	// the caller’s, e.g. if a delegate of another session calls this.)
+	if ([self isOnSessionQueue])
+		disconnect();
+	else
+		dispatch_async(_q, disconnect);
+}
+
+-(void) eventBatchConsumed:(IRCClientEventBatch *)batch {
+	void (^consume)(void) = ^{
+		if ([_pendingEventBatches containsObject:batch] == NO)
+			return;
+
+		[_pendingEventBatches removeObject:batch];
+		_inboundEventsPending -= batch.count;
+		_inboundBytesPending -= batch.bytes.length;
+
+		[self resumeReadingIfDrained];
+	};
+
+	if ([self isOnSessionQueue])
+		consume();
+	else
+		dispatch_async(_q, consume);
+}
+
+-(BOOL) setNickname:(NSData *)nickname
+		   username:(NSData *)username
+		   realname:(NSData *)realname {
 	if (self.isConnected) {
 		return NO;
 	} else {
@@ -638,662 +1490,2490 @@ typedef NS_OPTIONS(NSUInteger, IRCClientSessionStateFlags) {
 	}
 }
 
+-(void) setHandler:(IRCClientCommandHandler)handler
+		forCommand:(NSData *)command {
+	if (   !command
+		|| command.length == 0)
+		return;
+
+	handler = [handler copy];
+	command = [command copy];
+	dispatch_async(_q, ^{
+		_commandHandlers[command] = handler;
+	});
+}
+
 /**************************/
 #pragma mark - IRC commands
 /**************************/
 
--(int) sendRaw:(NSData *)message {
-	dispatch_async(_q, ^{
-		[_dataToSend appendData:message];
-		[_dataToSend appendBytes:C_string_crlf
-						  length:2];
+-(int) sendLineParts:(const IRCClientLinePart *)parts
+			   count:(NSUInteger)count {
+	if (IRCClientLinePartsLength(parts, count) + 2 > atomic_load_explicit(&_lineLength, memory_order_relaxed))
+		return 1;
 
-		if ([_oStream hasSpaceAvailable])
-			[self sendData:_oStream];
-	});
+	if ([self queueLineParts:parts
+					   count:count] == NO)
+		return 1;
 
 	return 0;
 }
 
--(int) quit:(NSData *)reason {
-	[self sendRaw:[NSData dataWithFormat:"QUIT :%@", (reason ?: [NSData dataFromCString:"quit"]), nil]];
+-(int) sendRaw:(NSData *)message {
+	IRCClientLinePart raw[] = {
+		IRCClientLinePartData(message)
+	};
+	if ([self queueLineParts:raw
+					   count:(sizeof(raw) / sizeof(IRCClientLinePart))] == NO)
+		return 1;
 
 	return 0;
 }
 
--(int) join:(NSData *)channel 
+-(int) quit:(NSData *)reason {
+	IRCClientLinePart quit[] = {
+		IRCClientLinePartCString("QUIT :"),
+		(reason ? IRCClientLinePartData(reason) : IRCClientLinePartCString("quit"))
+	};
+
+	int result = [self sendLineParts:quit
+							   count:(sizeof(quit) / sizeof(IRCClientLinePart))];
+
+	// The server closing the connection after this isn’t a lost connection.
+	// (Queued behind the QUIT, so it’s in place before the server answers.)
+	if (result == 0) {
+		void (^quitting)(void) = ^{
+			_stateFlags |= IRCClientSessionQuitSent;
+		};
+
+		if ([self isOnSessionQueue])
+			quitting();
+		else
+			dispatch_async(_q, quitting);
+	}
+
+	return result;
+}
+
+-(int) join:(NSData *)channel
 		key:(NSData *)key {
 	if (  !channel
 		|| channel.length == 0)
 		return 1;
 //		return LIBIRC_ERR_STATE;
 
-	if (   key
-		&& key.length > 0)
-		[self sendRaw:[NSData dataWithFormat:"JOIN %@ :%@", channel, key, nil]];
-	else
-		[self sendRaw:[NSData dataWithFormat:"JOIN %@", channel, nil]];
+	BOOL hasKey = (   key
+				   && key.length > 0);
+	IRCClientLinePart join[] = {
+		IRCClientLinePartCString("JOIN "),
+		IRCClientLinePartData(channel),
+		IRCClientLinePartCString(" :"),
+		IRCClientLinePartData(key)
+	};
+
+	int result = [self sendLineParts:join
+							   count:(hasKey ? 4 : 2)];
+
+	if (   result == 0
+		&& hasKey)
+		[self rememberKey:key
+			   forChannel:channel];
+
+	return result;
+}
+
+-(int) joinChannels:(NSArray <NSData *> *)channels
+			   keys:(NSArray <NSData *> *)keys {
+	if (   channels.count == 0
+		|| (   keys != nil
+			&& keys.count != channels.count))
+		return 1;
+
+	// Keys are matched to channels by position, so channels with keys must
+	// come first; put them all first, and make sure that each channel (with
+	// its key) fits on a line of its own before queueing anything.
+	NSUInteger lineLength = atomic_load_explicit(&_lineLength, memory_order_relaxed);
+	NSMutableArray <NSData *> *orderedChannels = [NSMutableArray arrayWithCapacity:channels.count];
+	NSMutableArray <NSData *> *orderedKeys = [NSMutableArray arrayWithCapacity:channels.count];
+	NSMutableArray <NSData *> *keylessChannels = [NSMutableArray arrayWithCapacity:channels.count];
+	for (NSUInteger i = 0; i < channels.count; i++) {
+		NSData *channel = channels[i];
+		NSData *key = keys[i];
+		if (channel.length == 0)
+			return 1;
+		if (strlen("JOIN ") + channel.length + (key.length > 0 ? 1 + key.length : 0) + 2 > lineLength)
+			return 1;
+
+		if (key.length > 0) {
+			[orderedChannels addObject:channel];
+			[orderedKeys addObject:key];
+		} else {
+			[keylessChannels addObject:channel];
+		}
+	}
+	NSUInteger keyedCount = orderedChannels.count;
+	[orderedChannels addObjectsFromArray:keylessChannels];
+
+	// Build all the lines into one chain of segments, and queue the chain in
+	// one go. Each line joins as many channels as the server allows per
+	// JOIN, and as will fit.
+	BOOL onSessionQueue = [self isOnSessionQueue];
+	NSUInteger targetLimit = MAX(atomic_load_explicit(&_targetLimits[IRCClientTargetCommandJOIN], memory_order_relaxed), 1);
+	NSMutableData *channelList = [NSMutableData dataWithCapacity:lineLength];
+	NSMutableData *keyList = [NSMutableData dataWithCapacity:lineLength];
+
+	IRCClientOutputSegment *head = NULL;
+	IRCClientOutputSegment **link = &head;
+	NSUInteger next = 0;
+	while (next < orderedChannels.count) {
+		channelList.length = 0;
+		keyList.length = 0;
+		for (NSUInteger listed = 0;
+			 (   next < orderedChannels.count
+			  && listed < targetLimit);
+			 listed++, next++) {
+			NSData *channel = orderedChannels[next];
+			NSData *key = (next < keyedCount) ? orderedKeys[next] : nil;
+
+			NSUInteger channelListLength = channelList.length + (listed > 0 ? 1 : 0) + channel.length;
+			NSUInteger keyListLength = keyList.length + (key ? (keyList.length > 0 ? 1 : 0) + key.length : 0);
+			if (   listed > 0
+				&& strlen("JOIN ") + channelListLength + (keyListLength > 0 ? 1 + keyListLength : 0) + 2 > lineLength)
+				break;
+
+			if (listed > 0)
+				[channelList appendBytes:","
+								  length:1];
+			[channelList appendData:channel];
+			if (key) {
+				if (keyList.length > 0)
+					[keyList appendBytes:","
+								  length:1];
+				[keyList appendData:key];
+
+				[self rememberKey:key
+					   forChannel:channel];
+			}
+		}
+
+		IRCClientLinePart join[] = {
+			IRCClientLinePartCString("JOIN "),
+			IRCClientLinePartData(channelList),
+			IRCClientLinePartCString(" "),
+			IRCClientLinePartData(keyList)
+		};
+		NSUInteger count = (keyList.length > 0 ? 4 : 2);
+
+		IRCClientOutputSegment *segment = IRCClientOutputQueueCreateSegment((onSessionQueue ? &_outputQueue : NULL),
+																			IRCClientLinePartsLength(join, count) + 2);
+		if (segment == NULL) {
+			IRCClientSessionLog(IRCClientLogLevelError, "Out of memory for an outbound line.");
+			IRCClientOutputQueueFreeSegments(head);
+			return 1;
+		}
+		IRCClientOutputSegmentWriteLineParts(segment, join, count);
+
+		*link = segment;
+		link = &segment->next;
+	}
+
+	[self queueSegments:head
+		 onSessionQueue:onSessionQueue];
+
+	return 0;
+}
+
+-(int) names:(NSData *)channel {
+	IRCClientLinePart names[] = {
+		IRCClientLinePartCString("NAMES"),
+		IRCClientLinePartCString(" "),
+		IRCClientLinePartData(channel)
+	};
+
+	return [self sendLineParts:names
+						 count:(channel.length > 0 ? 3 : 1)];
+}
+
+-(int) list:(NSData *)channel {
+	IRCClientLinePart list[] = {
+		IRCClientLinePartCString("LIST"),
+		IRCClientLinePartCString(" "),
+		IRCClientLinePartData(channel)
+	};
+
+	return [self sendLineParts:list
+						 count:(channel.length > 0 ? 3 : 1)];
+}
+
+-(int) userMode:(NSData *)mode {
+	IRCClientLinePart userMode[] = {
+		IRCClientLinePartCString("MODE "),
+		IRCClientLinePartData(_nickname),
+		IRCClientLinePartCString(" "),
+		IRCClientLinePartData(mode)
+	};
+
+	return [self sendLineParts:userMode
+						 count:(mode ? 4 : 2)];
+}
+
+-(int) nick:(NSData *)newnick {
+	if (  !newnick
+		|| newnick.length == 0)
+		return 1;
+//		return LIBIRC_ERR_INVAL;
+
+	IRCClientLinePart nick[] = {
+		IRCClientLinePartCString("NICK "),
+		IRCClientLinePartData(newnick)
+	};
+
+	return [self sendLineParts:nick
+						 count:(sizeof(nick) / sizeof(IRCClientLinePart))];
+}
+
+-(int) who:(NSData *)nickmask {
+	if (  !nickmask
+		|| nickmask.length == 0)
+		return 1;
+//		return LIBIRC_ERR_INVAL;
+
+	IRCClientLinePart who[] = {
+		IRCClientLinePartCString("WHO "),
+		IRCClientLinePartData(nickmask)
+	};
+
+	return [self sendLineParts:who
+						 count:(sizeof(who) / sizeof(IRCClientLinePart))];
+}
+
+-(int) names:(NSData *)channel
+  completion:(IRCClientReplyHandler)completion {
+	if (  !channel
+		|| channel.length == 0)
+		return 1;
+
+	IRCClientLinePart names[] = {
+		IRCClientLinePartCString("NAMES "),
+		IRCClientLinePartData(channel)
+	};
+
+	return [self sendRequest:[[IRCClientReply alloc] initWithType:IRCClientReplyNames
+														   target:channel
+													   completion:completion]
+				   lineParts:names
+					   count:(sizeof(names) / sizeof(IRCClientLinePart))];
+}
+
+-(int) list:(NSData *)channel
+ completion:(IRCClientReplyHandler)completion {
+	IRCClientLinePart list[] = {
+		IRCClientLinePartCString("LIST"),
+		IRCClientLinePartCString(" "),
+		IRCClientLinePartData(channel)
+	};
+
+	return [self sendRequest:[[IRCClientReply alloc] initWithType:IRCClientReplyList
+														   target:channel
+													   completion:completion]
+				   lineParts:list
+					   count:(channel.length > 0 ? 3 : 1)];
+}
+
+-(int) who:(NSData *)nickmask
+completion:(IRCClientReplyHandler)completion {
+	if (  !nickmask
+		|| nickmask.length == 0)
+		return 1;
+
+	IRCClientLinePart who[] = {
+		IRCClientLinePartCString("WHO "),
+		IRCClientLinePartData(nickmask)
+	};
+
+	return [self sendRequest:[[IRCClientReply alloc] initWithType:IRCClientReplyWho
+														   target:nickmask
+													   completion:completion]
+				   lineParts:who
+					   count:(sizeof(who) / sizeof(IRCClientLinePart))];
+}
+
+-(int) chatHistory:(NSData *)target
+			 limit:(NSUInteger)limit
+		completion:(IRCClientReplyHandler)completion {
+	if (  !target
+		|| target.length == 0
+		|| limit == 0)
+		return 1;
+
+	char limitString[24];
+	snprintf(limitString, sizeof(limitString), "%lu", (unsigned long) limit);
+
+	// CHATHISTORY LATEST <target> * <limit>
+	IRCClientLinePart chatHistory[] = {
+		IRCClientLinePartCString("CHATHISTORY LATEST "),
+		IRCClientLinePartData(target),
+		IRCClientLinePartCString(" * "),
+		IRCClientLinePartCString(limitString)
+	};
+
+	return [self sendRequest:[[IRCClientReply alloc] initWithType:IRCClientReplyHistory
+														   target:target
+													   completion:completion]
+				   lineParts:chatHistory
+					   count:(sizeof(chatHistory) / sizeof(IRCClientLinePart))];
+}
+
+// Sends a request, whose reply is to be gathered up into the given one (see
+// -[collectMessage:]).
+-(int) sendRequest:(IRCClientReply *)reply
+		 lineParts:(const IRCClientLinePart *)parts
+			 count:(NSUInteger)count {
+	if (IRCClientLinePartsLength(parts, count) + 2 > atomic_load_explicit(&_lineLength, memory_order_relaxed))
+		return 1;
+
+	// (The reply must be expected before the request goes out.)
+	void (^expect)(void) = ^{
+		if (self.isConnected == NO) {
+			reply.completion(nil, self);
+			return;
+		}
+
+		// NAMES and CHATHISTORY replies say what they are for; WHO and LIST
+		// replies are matched in order.
+		if (   reply.type == IRCClientReplyNames
+			|| reply.type == IRCClientReplyHistory)
+			reply.targetIdentifier = [_identifiers identifierForBytes:reply.target.bytes
+															   length:reply.target.length];
+		[_pendingReplies addObject:reply];
+	};
+	if ([self isOnSessionQueue])
+		expect();
+	else
+		dispatch_async(_q, expect);
+
+	if ([self queueLineParts:parts
+					   count:count] == NO) {
+		// The request didn’t go out, so the reply won’t come.
+		void (^withdraw)(void) = ^{
+			[_pendingReplies removeObjectIdenticalTo:reply];
+		};
+		if ([self isOnSessionQueue])
+			withdraw();
+		else
+			dispatch_async(_q, withdraw);
+
+		return 1;
+	}
+
+	return 0;
+}
+
+-(int) whois:(NSData *)nick {
+	if (!nick || nick.length == 0)
+		return 1;
+//		return LIBIRC_ERR_INVAL;
+
+	IRCClientLinePart whois[] = {
+		IRCClientLinePartCString("WHOIS "),
+		IRCClientLinePartData(nick)
+	};
+
+	return [self sendLineParts:whois
+						 count:(sizeof(whois) / sizeof(IRCClientLinePart))];
+}
+
+-(int) message:(NSData *)message
+			to:(NSData *)target {
+	if (   !target  || target.length == 0
+		|| !message || message.length == 0)
+		return 1;
+//		return LIBIRC_ERR_STATE;
+
+	IRCClientLinePart privmsg[] = {
+		IRCClientLinePartCString("PRIVMSG "),
+		IRCClientLinePartData(target),
+		IRCClientLinePartCString(" :"),
+		IRCClientLinePartData([self colorConvertToMIRC:message])
+	};
+
+	return [self sendLineParts:privmsg
+						 count:(sizeof(privmsg) / sizeof(IRCClientLinePart))];
+}
+
+-(int) messages:(NSArray <NSData *> *)messages
+	  toTargets:(NSArray <NSData *> *)targets {
+	if (   messages.count == 0
+		|| targets.count == 0)
+		return 1;
+
+	// Convert each message once (not once per target), and make sure that
+	// every resulting line will fit before queueing any of them.
+	NSUInteger lineLength = atomic_load_explicit(&_lineLength, memory_order_relaxed);
+	NSUInteger longestTarget = 0;
+	for (NSData *target in targets) {
+		if (target.length == 0)
+			return 1;
+		longestTarget = MAX(longestTarget, target.length);
+	}
+
+	NSMutableArray <NSData *> *convertedMessages = [NSMutableArray arrayWithCapacity:messages.count];
+	for (NSData *message in messages) {
+		if (message.length == 0)
+			return 1;
+
+		NSData *convertedMessage = [self colorConvertToMIRC:message];
+		if (strlen("PRIVMSG ") + longestTarget + strlen(" :") + convertedMessage.length + 2 > lineLength)
+			return 1;
+		[convertedMessages addObject:convertedMessage];
+	}
+
+	// Build all the lines into one chain of segments, and queue the chain in
+	// one go. Each line goes to as many targets (joined with commas) as the
+	// server allows per PRIVMSG, and as will fit.
+	BOOL onSessionQueue = [self isOnSessionQueue];
+	NSUInteger targetLimit = MAX(atomic_load_explicit(&_targetLimits[IRCClientTargetCommandPRIVMSG], memory_order_relaxed), 1);
+	NSMutableData *targetList = [NSMutableData dataWithCapacity:lineLength];
+
+	IRCClientOutputSegment *head = NULL;
+	IRCClientOutputSegment **link = &head;
+	for (NSData *message in convertedMessages) {
+		NSUInteger room = lineLength - (strlen("PRIVMSG ") + strlen(" :") + message.length + 2);
+		NSUInteger next = 0;
+		while (next < targets.count) {
+			[targetList setData:targets[next++]];
+			for (NSUInteger listed = 1;
+				 (   next < targets.count
+				  && listed < targetLimit
+				  && targetList.length + 1 + targets[next].length <= room);
+				 listed++) {
+				[targetList appendBytes:","
+								 length:1];
+				[targetList appendData:targets[next++]];
+			}
+
+			IRCClientLinePart privmsg[] = {
+				IRCClientLinePartCString("PRIVMSG "),
+				IRCClientLinePartData(targetList),
+				IRCClientLinePartCString(" :"),
+				IRCClientLinePartData(message)
+			};
+			NSUInteger count = (sizeof(privmsg) / sizeof(IRCClientLinePart));
+
+			IRCClientOutputSegment *segment = IRCClientOutputQueueCreateSegment((onSessionQueue ? &_outputQueue : NULL),
+																				IRCClientLinePartsLength(privmsg, count) + 2);
+			if (segment == NULL) {
+				IRCClientSessionLog(IRCClientLogLevelError, "Out of memory for an outbound line.");
+				IRCClientOutputQueueFreeSegments(head);
+				return 1;
+			}
+			IRCClientOutputSegmentWriteLineParts(segment, privmsg, count);
+
+			*link = segment;
+			link = &segment->next;
+		}
+	}
+
+	[self queueSegments:head
+		 onSessionQueue:onSessionQueue];
+
+	return 0;
+}
+
+-(int) action:(NSData *)action
+		   to:(NSData *)target {
+	if (   !target || target.length == 0
+		|| !action || action.length == 0)
+		return 1;
+//		return LIBIRC_ERR_STATE;
+
+	IRCClientLinePart privmsg[] = {
+		IRCClientLinePartCString("PRIVMSG "),
+		IRCClientLinePartData(target),
+		IRCClientLinePartCString(" :\x01" "ACTION "),
+		IRCClientLinePartData([self colorConvertToMIRC:action]),
+		IRCClientLinePartCString("\x01")
+	};
+
+	return [self sendLineParts:privmsg
+						 count:(sizeof(privmsg) / sizeof(IRCClientLinePart))];
+}
+
+-(int) notice:(NSData *)notice
+		   to:(NSData *)target {
+	if (   !target || target.length == 0
+		|| !notice || notice.length == 0)
+		return 1;
+//		return LIBIRC_ERR_STATE;
+
+	IRCClientLinePart noticeParts[] = {
+		IRCClientLinePartCString("NOTICE "),
+		IRCClientLinePartData(target),
+		IRCClientLinePartCString(" :"),
+		IRCClientLinePartData(notice)
+	};
+
+	return [self sendLineParts:noticeParts
+						 count:(sizeof(noticeParts) / sizeof(IRCClientLinePart))];
+}
+
+-(int) ctcpRequest:(NSData *)request
+			target:(NSData *)target {
+	if (   !target  || target.length == 0
+		|| !request || request.length == 0)
+		return 1;
+//		return LIBIRC_ERR_STATE;
+
+	IRCClientLinePart privmsg[] = {
+		IRCClientLinePartCString("PRIVMSG "),
+		IRCClientLinePartData(target),
+		IRCClientLinePartCString(" :\x01"),
+		IRCClientLinePartData(request),
+		IRCClientLinePartCString("\x01")
+	};
+
+	return [self sendLineParts:privmsg
+						 count:(sizeof(privmsg) / sizeof(IRCClientLinePart))];
+}
+
+-(int) ctcpReply:(NSData *)reply
+		  target:(NSData *)target {
+	if (   !target || target.length == 0
+		|| !reply  || reply.length == 0)
+		return 1;
+//		return LIBIRC_ERR_STATE;
+
+	IRCClientLinePart notice[] = {
+		IRCClientLinePartCString("NOTICE "),
+		IRCClientLinePartData(target),
+		IRCClientLinePartCString(" :\x01"),
+		IRCClientLinePartData(reply),
+		IRCClientLinePartCString("\x01")
+	};
+
+	return [self sendLineParts:notice
+						 count:(sizeof(notice) / sizeof(IRCClientLinePart))];
+}
+
+-(IRCClientDCCTransfer *) sendFile:(NSString *)path
+								to:(NSData *)nick
+						   passive:(BOOL)passive {
+	if (  !nick
+		|| nick.length == 0)
+		return nil;
+
+	int family = AF_INET;
+	NSData *address = [self DCCAddressArgumentWithFamily:&family];
+	if (   address == nil
+		&& passive == NO)
+		return nil;
+
+	IRCClientDCCTransfer *transfer = [[IRCClientDCCTransfer alloc] initWithDirection:IRCClientDCCTransferSend
+																				 nick:nick
+																			 filename:[path.lastPathComponent dataAsUTF8]
+																				 size:0
+																			  passive:passive
+																				queue:_q];
+	if ([transfer openFileForSendingAtPath:path] == NO)
+		return nil;
+
+	// Either we listen, and say where; or (passively) the receiver does, and
+	// tells us where, in a DCC SEND request of its own with the same token.
+	if (passive)
+		transfer.token = [[NSString stringWithFormat:@"%u", arc4random()] dataAsUTF8];
+	else if ([transfer listenWithFamily:family] == NO)
+		return nil;
+
+	void (^offer)(void) = ^{
+		[self trackTransfer:transfer];
+
+		char port[8];
+		snprintf(port, sizeof(port), "%lu", (unsigned long) transfer.localPort);
+		char size[24];
+		snprintf(size, sizeof(size), "%llu", (unsigned long long) transfer.size);
+
+		NSMutableArray <NSData *> *arguments = [NSMutableArray arrayWithObjects:
+												[@"SEND" dataAsUTF8],
+												transfer.filename,
+												(address ?: [@"0" dataAsUTF8]),
+												[NSData dataWithBytes:port length:strlen(port)],
+												[NSData dataWithBytes:size length:strlen(size)],
+												nil];
+		if (transfer.token != nil)
+			[arguments addObject:transfer.token];
+		[self sendDCCRequest:arguments
+						  to:transfer.nick];
+	};
+	if ([self isOnSessionQueue])
+		offer();
+	else
+		dispatch_async(_q, offer);
+
+	return transfer;
+}
+
+-(int) acceptTransfer:(IRCClientDCCTransfer *)transfer
+				 path:(NSString *)path
+			   resume:(BOOL)resume {
+	if (   transfer == nil
+		|| transfer.direction != IRCClientDCCTransferReceive
+		|| transfer.state != IRCClientDCCTransferOffered
+		|| transfer.path != nil
+		|| path == nil)
+		return 1;
+
+	if ([transfer openFileForReceivingAtPath:path
+									  resume:resume] == NO)
+		return 1;
+
+	void (^accept)(void) = ^{
+		if (transfer.startPosition > 0) {
+			// Ask the sender to send only the rest; we go on when it ACCEPTs
+			// (see -[DCCRequestReceived:ofMessage:]).
+			transfer.awaitingAccept = YES;
+			char port[8];
+			snprintf(port, sizeof(port), "%lu", (unsigned long) transfer.remotePort);
+			char position[24];
+			snprintf(position, sizeof(position), "%llu", (unsigned long long) transfer.startPosition);
+
+			NSMutableArray <NSData *> *arguments = [NSMutableArray arrayWithObjects:
+													[@"RESUME" dataAsUTF8],
+													transfer.filename,
+													[NSData dataWithBytes:port length:strlen(port)],
+													[NSData dataWithBytes:position length:strlen(position)],
+													nil];
+			if (transfer.token != nil)
+				[arguments addObject:transfer.token];
+			[self sendDCCRequest:arguments
+							  to:transfer.nick];
+		} else {
+			[self startReceiving:transfer];
+		}
+	};
+	if ([self isOnSessionQueue])
+		accept();
+	else
+		dispatch_async(_q, accept);
+
+	return 0;
+}
+
+/********************************/
+#pragma mark - IRC event handlers
+/********************************/
+
+-(NSRange) CTCPContentRange:(NSRange)messageBody
+				  ofMessage:(const IRCClientMessage *)message {
+	if (   messageBody.location != NSNotFound
+		&& messageBody.length > 1
+		&& message->bytes[messageBody.location] == '\x01'
+		&& message->bytes[NSMaxRange(messageBody) - 1] == '\x01') {
+		return NSMakeRange(messageBody.location + 1, messageBody.length - 2);
+	} else {
+		return NSMakeRange(NSNotFound, 0);
+	}
+}
+
+-(IRCClientColorCodeHandling) colorCodeHandlingForChannel:(IRCClientChannel *)channel {
+	IRCClientColorCodeHandling handling = channel.colorCodeHandling;
+	if (handling == IRCClientColorCodeHandlingDefault)
+		handling = _colorCodeHandling;
+
+	return handling;
+}
+
+-(NSData *) processColorCodes:(NSData *)messageBody
+				   forChannel:(IRCClientChannel *)channel {
+	switch ([self colorCodeHandlingForChannel:channel]) {
+		case IRCClientColorCodeHandlingDefault:
+		case IRCClientColorCodeHandlingIgnore:
+			return messageBody;
+		case IRCClientColorCodeHandlingStrip:
+			return IRCClientFormattingStripMIRC(messageBody);
+		case IRCClientColorCodeHandlingParse:
+			return IRCClientFormattingParse(messageBody);
+		case IRCClientColorCodeHandlingConvert:
+			return IRCClientFormattingConvertFromMIRC(messageBody);
+	}
+}
+
+-(NSArray <NSData *> *) processColorCodesInParams:(const IRCClientMessage *)message {
+	NSArray <NSData *> *params = IRCClientMessageParamsArray(message, 0);
+	if (   _colorCodeHandling == IRCClientColorCodeHandlingIgnore
+		|| _colorCodeHandling == IRCClientColorCodeHandlingDefault)
+		return params;
+
+	return [params map:^id(NSData *param) {
+		return [self processColorCodes:param
+							forChannel:nil];
+	}];
+}
+
+-(BOOL) isChannelName:(NSRange)name
+			ofMessage:(const IRCClientMessage *)message {
+	return IRCClientServerSupportIsChannelType(&_serverSupport,
+											   IRCClientMessageRangeFirstByte(message, name));
+}
+
+-(void) handleIRCEvent:(const IRCClientMessage *)message {
+	// This is so we can refer to “param [ 0 / 1 / 2 ]” without having to
+	// check for out-of-range every time. (The range of a missing param has
+	// a location of NSNotFound.)
+	NSRange param_0 = IRCClientMessageParamRange(message, 0);
+	NSRange param_1 = IRCClientMessageParamRange(message, 1);
+	NSRange param_2 = IRCClientMessageParamRange(message, 2);
+
+	NSRange command = message->command;
+
+	// Numeric event.
+	NSUInteger numericEventCode;
+	if (IRCClientMessageNumericCode(message, &numericEventCode)) {
+		switch (IRCClientNumericHandlers[numericEventCode]) {
+			case IRCClientNumericHandlerRegistrationComplete: {
+				if (!(_stateFlags & IRCClientSessionMOTDReceived)) {
+					// (If the server doesn’t do CAP, it never answered.)
+					_stateFlags &= ~(IRCClientSessionNegotiatingCapabilities | IRCClientSessionAuthenticating);
+					_stateFlags |= IRCClientSessionMOTDReceived;
+					_outputScheduler.registering = NO;
+					[self rejoinChannels];
+					[self deliverEventBatch];
+					[self reportConnectionTimings];
+					[_delegate connectionSucceeded:self];
+				}
+
+				break;
+			}
+			case IRCClientNumericHandlerISupport: {
+				[self serverSupportReceived:message];
+
+				break;
+			}
+			case IRCClientNumericHandlerChannelModes: {
+				// RPL_CHANNELMODEIS: <client> <channel> <modestring> ...
+				IRCClientChannel *channel = [self channelNamed:param_1
+													 ofMessage:message];
+				[channel modesReceived:message];
+
+				break;
+			}
+			case IRCClientNumericHandlerListEntry: {
+				[self listEntryReceived:message
+								   code:numericEventCode];
+
+				break;
+			}
+			case IRCClientNumericHandlerNamesReply: {
+				[self namesReceived:message];
+
+				break;
+			}
+			case IRCClientNumericHandlerEndOfNames: {
+				[self namesEnded:message];
+
+				break;
+			}
+			case IRCClientNumericHandlerSASLComplete: {
+				[self authenticationEnded:message
+									 code:numericEventCode];
+
+				break;
+			}
+			case IRCClientNumericHandlerNone: {
+				break;
+			}
+		}
+
+		if (_delegateCapabilities & IRCClientDelegateNamedNumeric) {
+			[_delegate numericEventReceived:numericEventCode
+									   name:IRCClientNumericName(numericEventCode)
+									   from:IRCClientMessageDataForRange(message, message->prefix)
+									 params:IRCClientMessageParamsArray(message, 0)
+									session:self];
+		} else if (_delegateCapabilities & IRCClientDelegateNumeric) {
+			[_delegate numericEventReceived:numericEventCode
+									   from:IRCClientMessageDataForRange(message, message->prefix)
+									 params:IRCClientMessageParamsArray(message, 0)
+									session:self];
+		}
+
+		return;
+	}
+
+	// IRC command.
+	switch (IRCClientCommandLookup(message->bytes + command.location,
+								   command.length)) {
+		case IRCClientCommandPING: {
+			// TODO: implement an "ignore ping" toggle
+			// and a "ping passthrough" toggle
+			[self sendPong:message];
+
+			if (_delegateCapabilities & IRCClientDelegateRespondsToPing) {
+				[_delegate ping:IRCClientMessageDataForRange(message, param_0)
+						   from:IRCClientMessageDataForRange(message, message->prefix)
+						session:self];
+			}
+
+			break;
+		}
+		case IRCClientCommandNICK: {
+			/*!
+			 * The ‘nick’ event is triggered when the client receives a NICK message,
+			 * meaning that someone (including you) on a channel with the client has
+			 * changed their nickname.
+			 *
+			 * \param origin The person who changed their nick. Note that it can be you!
+			 * \param params[0] Mandatory; contains the new nick.
+			 */
+			[self nickChanged:message];
+
+			break;
+		}
+		case IRCClientCommandQUIT: {
+			/*!
+			 * The ‘quit’ event is triggered upon receipt of a QUIT message, which
+			 * means that someone on a channel with the client has disconnected.
+			 *
+			 * \param origin The person who is disconnected.
+			 * \param params[0] Optional; contains the reason message (user-specified).
+			 */
+			[self userQuit:message];
+
+			break;
+		}
+		case IRCClientCommandJOIN: {
+			/*!
+			 * The ‘join’ event is triggered upon receipt of a JOIN message, which
+			 * means that someone has entered a channel that the client is on.
+			 *
+			 * \param origin The person who joined the channel. By comparing it with
+			 *               your own nickname, you can check whether your JOIN
+			 *               command succeed.
+			 * \param params[0] Mandatory; contains the channel name.
+			 */
+			[self userJoined:message];
+
+			break;
+		}
+		case IRCClientCommandPART: {
+			/*!
+			 * The ‘part’ event is triggered upon receipt of a PART message, which
+			 * means that someone has left a channel that the client is on.
+			 *
+			 * \param Origin The person who left the channel. By comparing it with
+			 *               your own nickname, you can check whether your PART
+			 *               command succeed.
+			 * \param params[0] Mandatory; contains the channel name.
+			 * \param params[1] Optional; contains the reason message (user-defined).
+			 */
+			[self userParted:message];
+
+			break;
+		}
+		case IRCClientCommandMODE: {
+			if ([self isOwnNick:param_0
+					  ofMessage:message]) {
+				/*!
+				 * The ‘umode’ event is triggered upon receipt of a user MODE message,
+				 * which means that your user mode has been changed.
+				 *
+				 * \param origin The person who changed the user mode.
+				 * \param params[0] Mandatory; contains the user changed mode, like
+				 *        ‘+t’, ‘-i’ and so on.
+				 */
+				if (_delegateCapabilities & IRCClientDelegateReceivesEvents) {
+					[_delegate modeSet:IRCClientMessageDataForRange(message, param_1)
+									by:IRCClientMessageDataForRange(message, message->prefix)
+							   session:self];
+				}
+			} else {
+				/*!
+				 * The ‘mode’ event is triggered upon receipt of a channel MODE message,
+				 * which means that someone on a channel with the client has changed the
+				 * channel’s parameters.
+				 *
+				 * \param origin The person who changed the channel mode.
+				 * \param params[0] Mandatory; contains the channel name.
+				 * \param params[1] Mandatory; contains the changed channel mode, like
+				 *        ‘+t’, ‘-i’, and so on.
+				 * \param params[2] Optional; contains the mode argument (for example, a
+				 *      key for +k mode, or user who got channel operator status for
+				 *      +o mode)
+				 */
+				IRCClientChannel *channel = [self channelNamed:param_0
+													 ofMessage:message];
+				[channel modesChanged:message];
+			}
+
+			break;
+		}
+		case IRCClientCommandTOPIC: {
+			/*!
+			 * The ‘topic’ event is triggered upon receipt of a TOPIC message, which
+			 * means that someone on a channel with the client has changed the
+			 * channel’s topic.
+			 *
+			 * \param origin The person who changes the channel topic.
+			 * \param params[0] Mandatory; contains the channel name.
+			 * \param params[1] Optional; contains the new topic.
+			 */
+			IRCClientChannel *channel = [self channelNamed:param_0
+												 ofMessage:message];
+			if (channel != nil) {
+				[channel topicSet:IRCClientMessageDataForRange(message, param_1)
+							   by:IRCClientMessageDataForRange(message, message->prefix)];
+			}
+
+			break;
+		}
+		case IRCClientCommandKICK: {
+			/*!
+			 * The ‘kick’ event is triggered upon receipt of a KICK message, which
+			 * means that someone on a channel with the client (or possibly the
+			 * client itself!) has been forcibly ejected.
+			 *
+			 * \param origin The person who kicked the poor victim.
+			 * \param params[0] Mandatory; contains the channel name.
+			 * \param params[1] Optional; contains the nick of kicked person.
+			 * \param params[2] Optional; contains the kick text.
+			 */
+			[self userKicked:message];
+
+			break;
+		}
+		case IRCClientCommandERROR: {
+			/*!
+			 * The ‘error’ event is triggered upon receipt of an ERROR message, which
+			 * (when sent to clients) usually means the client has been disconnected.
+			 *
+			 * \param origin the person, who generates the message.
+			 * \param params optional, contains who knows what.
+			 */
+			if (_delegateCapabilities & IRCClientDelegateReceivesEvents) {
+				[_delegate errorReceived:IRCClientMessageParamsArray(message, 0)
+								 session:self];
+			}
+
+			break;
+		}
+		case IRCClientCommandCAP: {
+			[self capabilitiesReceived:message];
+
+			// (The application may also want to see these; e.g. for
+			// cap-notify.)
+			if (self.isConnected)
+				[self callHandlerForCommand:command
+								  ofMessage:message];
+
+			break;
+		}
+		case IRCClientCommandAUTHENTICATE: {
+			[self authenticationContinued:message];
+
+			if (self.isConnected)
+				[self callHandlerForCommand:command
+								  ofMessage:message];
+
+			break;
+		}
+		case IRCClientCommandINVITE: {
+			/*!
+			 * The ‘invite’ event is triggered upon receipt of an INVITE message,
+			 * which means that someone is permitting the client’s entry into a +i
+			 * channel.
+			 *
+			 * \param origin The person who INVITEd you.
+			 * \param params[0] Mandatory; contains your nick.
+			 * \param params[1] Mandatory; contains the channel name you’re invited into.
+			 *
+			 * \sa irc_cmd_invite irc_cmd_chanmode_invite
+			 */
+			if (_delegateCapabilities & IRCClientDelegateReceivesEvents) {
+				[_delegate invitedToChannel:IRCClientMessageDataForRange(message, param_1)
+										 by:IRCClientMessageDataForRange(message, message->prefix)
+									session:self];
+			}
+
+			break;
+		}
+		case IRCClientCommandPRIVMSG: {
+			NSRange ctcpContent = [self CTCPContentRange:param_1
+											   ofMessage:message];
+			if (ctcpContent.location != NSNotFound) {
+				if (IRCClientMessageRangeHasCStringPrefix(message, ctcpContent, "DCC ")) {
+					[self DCCRequestReceived:NSMakeRange(ctcpContent.location + strlen("DCC "),
+														 ctcpContent.length - strlen("DCC "))
+								   ofMessage:message];
+				} else if (IRCClientMessageRangeHasCStringPrefix(message, ctcpContent, "ACTION ")) {
+					/*!
+					 * The ‘action’ event is triggered when the client receives the CTCP
+					 * ACTION message. These messages usually looks like:\n
+					 * \code
+					 * [23:32:55] * Tim gonna sleep.
+					 * \endcode
+					 *
+					 * \param origin The person who generated the message.
+					 * \param params[0] Mandatory; the target of the message.
+					 * \param params[1] Mandatory; the ACTION message.
+					 */
+					NSRange actionRange = NSMakeRange(ctcpContent.location + strlen("ACTION "),
+													  ctcpContent.length - strlen("ACTION "));
+					IRCClientChannel* channel = [self channelNamed:param_0
+														 ofMessage:message];
+					if (channel != nil) {
+						// An action on a channel we’re on.
+						[channel actionPerformed:[self processColorCodes:IRCClientMessageDataForRange(message, actionRange)
+															  forChannel:channel]
+										  byUser:IRCClientMessageDataForRange(message, message->prefix)];
+					} else {
+						// An action in a private message.
+						if (_delegateCapabilities & IRCClientDelegateReceivesEvents) {
+							[_delegate privateCTCPActionReceived:[self processColorCodes:IRCClientMessageDataForRange(message, actionRange)
+																			  forChannel:nil]
+														fromUser:IRCClientMessageDataForRange(message, message->prefix)
+														 session:self];
+						}
+					}
+				} else {
+					/*!
+					 * The ‘ctcp’ event is triggered when the client receives the CTCP
+					 * request. By default, the built-in CTCP request handler is used. The
+					 * build-in handler automatically replies on most CTCP messages, so you
+					 * will rarely need to override it.
+					 *
+					 * \param origin The person who generated the message.
+					 * \param params[0] Mandatory; contains the complete CTCP message, including
+					 *                  its arguments.
+					 *
+					 * Mirc generates PING, FINGER, VERSION, TIME and ACTION messages,
+					 * check the source code of \c libirc_event_ctcp_internal function to
+					 * see how to write your own CTCP request handler. Also you may find
+					 * useful this question in FAQ: \ref faq4
+					 */
+					[self CTCPRequestReceived:IRCClientMessageDataForRange(message, ctcpContent)
+									 fromUser:IRCClientMessageDataForRange(message, message->prefix)];
+				}
+			} else if ([self isOwnNick:param_0
+							 ofMessage:message]) {
+				/*!
+				 * The ‘privmsg’ event is triggered upon receipt of a PRIVMSG message
+				 * which is addressed to one or more clients, which means that someone
+				 * is sending the client a private message.
+				 *
+				 * \param origin The person who generated the message.
+				 * \param params[0] Mandatory; contains your nick.
+				 * \param params[1] Optional; contains the message text.
+				 */
+				if (_delegateCapabilities & IRCClientDelegateReceivesEvents) {
+					[_delegate privateMessageReceived:[self processColorCodes:IRCClientMessageDataForRange(message, param_1)
+																   forChannel:nil]
+											 fromUser:IRCClientMessageDataForRange(message, message->prefix)
+											  session:self];
+				}
+			} else if ([self isChannelName:param_0
+								 ofMessage:message]) {
+				/*!
+				 * The ‘chanmsg’ event is triggered upon receipt of a PRIVMSG message
+				 * to an entire channel, which means that someone on a channel with
+				 * the client has said something aloud. Your own messages don’t trigger
+				 * PRIVMSG event.
+				 *
+				 * \param origin The person who generated the message.
+				 * \param params[0] Mandatory; contains the channel name.
+				 * \param params[1] Optional; contains the message text.
+				 */
+				IRCClientChannel *channel = [self channelNamed:param_0
+													 ofMessage:message];
+				if (channel != nil) {
+					[channel messageSent:[self processColorCodes:IRCClientMessageDataForRange(message, param_1)
+													  forChannel:channel]
+								  byUser:IRCClientMessageDataForRange(message, message->prefix)];
+				}
+			} else {
+				/*!
+				 * The ‘servmsg’ event is triggered upon receipt of a PRIVMSG message
+				 * which is addressed to no one in particular, but it sent to the client
+				 * anyway.
+				 *
+				 * \param origin The person who generated the message.
+				 * \param params Optional; contains who knows what.
+				 */
+				if (_delegateCapabilities & IRCClientDelegateReceivesEvents) {
+					NSArray <NSData *> *params = [self processColorCodesInParams:message];
+					[_delegate serverMessageReceivedFrom:IRCClientMessageDataForRange(message, message->prefix)
+												  params:params
+												 session:self];
+				}
+			}
+
+			break;
+		}
+		case IRCClientCommandNOTICE: {
+			NSRange ctcpContent = [self CTCPContentRange:param_1
+											   ofMessage:message];
+			if (ctcpContent.location != NSNotFound) {
+				/*!
+				 * The ‘ctcp’ event is triggered when the client receives the CTCP reply.
+				 *
+				 * \param origin The person who generated the message.
+				 * \param params[0] Mandatory; the CTCP message itself with its arguments.
+				 */
+				if (_delegateCapabilities & IRCClientDelegateCTCPReply) {
+					[_delegate CTCPReplyReceived:IRCClientMessageDataForRange(message, ctcpContent)
+										fromUser:IRCClientMessageDataForRange(message, message->prefix)
+										 session:self];
+				}
+			} else if ([self isOwnNick:param_0
+							 ofMessage:message]) {
+				/*!
+				 * The ‘notice’ event is triggered upon receipt of a NOTICE message
+				 * which means that someone has sent the client a public or private
+				 * notice. According to RFC 1459, the only difference between NOTICE
+				 * and PRIVMSG is that you should NEVER automatically reply to NOTICE
+				 * messages. Unfortunately, this rule is frequently violated by IRC
+				 * servers itself - for example, NICKSERV messages require reply, and
+				 * are NOTICEs.
+				 *
+				 * \param origin The person who generated the message.
+				 * \param params[0] Mandatory; contains your nick.
+				 * \param params[1] Optional; contains the message text.
+				 */
+				if (_delegateCapabilities & IRCClientDelegateReceivesEvents) {
+					[_delegate privateNoticeReceived:[self processColorCodes:IRCClientMessageDataForRange(message, param_1)
+																  forChannel:nil]
+											fromUser:IRCClientMessageDataForRange(message, message->prefix)
+											 session:self];
+				}
+			} else if ([self isChannelName:param_0
+								 ofMessage:message]) {
+				/*!
+				 * The ‘notice’ event is triggered upon receipt of a NOTICE message
+				 * which means that someone has sent the client a public or private
+				 * notice. According to RFC 1459, the only difference between NOTICE
+				 * and PRIVMSG is that you should NEVER automatically reply to NOTICE
+				 * messages. Unfortunately, this rule is frequently violated by IRC
+				 * servers itself - for example, NICKSERV messages require reply, and
+				 * are NOTICEs.
+				 *
+				 * \param origin The person who generated the message.
+				 * \param params[0] Mandatory; contains the target channel name.
+				 * \param params[1] Optional; contains the message text.
+				 */
+				IRCClientChannel *channel = [self channelNamed:param_0
+													 ofMessage:message];
+				if (channel != nil) {
+					[channel noticeSent:[self processColorCodes:IRCClientMessageDataForRange(message, param_1)
+													 forChannel:channel]
+								 byUser:IRCClientMessageDataForRange(message, message->prefix)];
+				}
+			} else {
+				/*!
+				 * The ‘server_notice’ event is triggered upon receipt of a NOTICE
+				 * message which means that the server has sent the client a notice.
+				 * This notice is not necessarily addressed to the client’s nick
+				 * (for example, AUTH notices, sent before the client’s nick is known).
+				 * According to RFC 1459, the only difference between NOTICE
+				 * and PRIVMSG is that you should NEVER automatically reply to NOTICE
+				 * messages. Unfortunately, this rule is frequently violated by IRC
+				 * servers itself - for example, NICKSERV messages require reply, and
+				 * are NOTICEs.
+				 *
+				 * \param origin The person who generated the message.
+				 * \param params Optional; contains who knows what.
+				 */
+				if (_delegateCapabilities & IRCClientDelegateReceivesEvents) {
+					NSArray <NSData *> *params = [self processColorCodesInParams:message];
+					[_delegate serverNoticeReceivedFrom:IRCClientMessageDataForRange(message, message->prefix)
+												 params:params
+												session:self];
+				}
+			}
+
+			break;
+		}
+		case IRCClientCommandBATCH:
+		case IRCClientCommandFAIL:
+			// (Those that weren’t gathered up; see -[collectMessage:].)
+		case IRCClientCommandUnknown: {
+			// A command that the application has registered a handler for.
+			if ([self callHandlerForCommand:command
+								  ofMessage:message])
+				break;
+
+			/*!
+			 * The ‘unknown’ event is triggered upon receipt of any number of
+			 * unclassifiable miscellaneous messages, which aren’t handled by the
+			 * library.
+			 */
+			if (_delegateCapabilities & IRCClientDelegateUnknownEvent) {
+				[_delegate unknownEventReceived:IRCClientMessageDataForRange(message, command)
+										   from:IRCClientMessageDataForRange(message, message->prefix)
+										 params:IRCClientMessageParamsArray(message, 0)
+										session:self];
+			}
+
+			break;
+		}
+	}
+}
+
+/******************************************/
+#pragma mark - Event handler helper methods
+/******************************************/
+
+/*	NOTE: These methods only create NSData objects for the parts of the
+	message that they actually pass on (to a delegate or a channel).
+ */
+
+-(NSData *) lookupKeyForRange:(NSRange)range
+					ofMessage:(const IRCClientMessage *)message {
+	// Reuse the lookup key’s storage, so that a lookup doesn’t allocate.
+	[_lookupKey replaceBytesInRange:_lookupKey.fullRange
+						  withBytes:(message->bytes + range.location)
+							 length:range.length];
+	return _lookupKey;
+}
+
+// Calls the handler that the application has registered for the message’s
+// command, if there is one; returns whether there was.
+-(BOOL) callHandlerForCommand:(NSRange)command
+					ofMessage:(const IRCClientMessage *)message {
+	IRCClientCommandHandler handler = (_commandHandlers.count > 0
+									   ? _commandHandlers[[self lookupKeyForRange:command
+																		ofMessage:message]]
+									   : nil);
+	if (handler == nil)
+		return NO;
+
+	handler(IRCClientMessageDataForRange(message, message->prefix),
+			IRCClientMessageParamsArray(message, 0),
+			self);
+
+	return YES;
+}
+
+-(IRCClientChannel *) channelNamed:(NSRange)channelName
+						 ofMessage:(const IRCClientMessage *)message {
+	if (channelName.location == NSNotFound)
+		return nil;
+
+	// If the name was never interned, we’re not on the channel.
+	IRCClientIdentifier *identifier = [_identifiers existingIdentifierForBytes:(message->bytes + channelName.location)
+																		length:channelName.length];
+	return (identifier != nil) ? _channels[identifier] : nil;
+}
+
+-(void) removeChannel:(IRCClientChannel *)channel {
+	NSData *name = channel.name;
+	IRCClientIdentifier *identifier = [_identifiers existingIdentifierForBytes:name.bytes
+																		length:name.length];
+	if (identifier != nil) {
+		[_channels removeObjectForKey:identifier];
+		[_channelKeys removeObjectForKey:identifier];
+	}
+}
+
+-(BOOL) isOwnNick:(NSRange)nick
+		ofMessage:(const IRCClientMessage *)message {
+	if (   nick.location == NSNotFound
+		|| _ownNick == nil)
+		return NO;
+
+	return ([_identifiers existingIdentifierForBytes:(message->bytes + nick.location)
+											  length:nick.length] == _ownNick);
+}
+
+-(void) nickChanged:(const IRCClientMessage *)message {
+	NSRange oldNickOnly = IRCClientMessagePrefixNickRange(message);
+	NSData *newNick = IRCClientMessageParamData(message, 0);
+
+	BOOL own = [self isOwnNick:oldNickOnly
+					 ofMessage:message];
+	NSData *oldNick = own ? _nickname : IRCClientMessageDataForRange(message, oldNickOnly);
+	// The new nick is interned (once, for all channels) under its new
+	// spelling, even if it differs from the old one only in case.
+	IRCClientIdentifier *newIdentifier = nil;
+	if (newNick.length > 0) {
+		newIdentifier = [_identifiers identifierForBytes:newNick.bytes
+												  length:newNick.length];
+		newIdentifier.name = newNick;
+	}
+	if (own) {
+		_nickname = newNick;
+		_ownNick = newIdentifier;
+	}
+
+	for (IRCClientChannel *channel in _channels.objectEnumerator)
+		[channel nickChangedFrom:oldNick
+							  to:newNick];
+
+	if (_delegateCapabilities & IRCClientDelegateReceivesEvents) {
+		[_delegate nickChangedFrom:oldNick
+								to:newNick 
+							   own:own 
+						   session:self];
+	}
+}
+
+-(void) userQuit:(const IRCClientMessage *)message {
+	NSData *nickUserHost = IRCClientMessageDataForRange(message, message->prefix);
+
+	for (IRCClientChannel *channel in _channels.objectEnumerator)
+		[channel userQuit:nickUserHost];
+
+	if (_delegateCapabilities & IRCClientDelegateReceivesEvents) {
+		[_delegate userQuit:nickUserHost
+				 withReason:IRCClientMessageParamData(message, 0)
+					session:self];
+	}
+}
+
+-(void) serverSupportReceived:(const IRCClientMessage *)message {
+	// RPL_ISUPPORT: <client> <1-13 tokens> :are supported by this server
+	IRCClientServerSupport serverSupport = _serverSupport;
+	for (NSUInteger i = 1; i + 1 < message->paramCount; i++) {
+		NSRange token = IRCClientMessageParamRange(message, i);
+		IRCClientServerSupportApplyToken(&serverSupport,
+										 (message->bytes + token.location),
+										 token.length);
+	}
+
+	[self replaceServerSupport:&serverSupport];
+}
+
+-(void) replaceServerSupport:(const IRCClientServerSupport *)serverSupport {
+	BOOL caseMappingChanged = (serverSupport->caseMapping != _serverSupport.caseMapping);
+	_serverSupport = *serverSupport;
+
+	_receiveBuffer.lineLimit = IRCClientMaxTagsLength + _serverSupport.lineLength;
+	atomic_store_explicit(&_lineLength, _serverSupport.lineLength, memory_order_relaxed);
+	for (NSUInteger i = 0; i < IRCClientTargetCommandCount; i++)
+		atomic_store_explicit(&_targetLimits[i], _serverSupport.targetLimits[i], memory_order_relaxed);
+
+	// Names are interned in case-folded form, so if the folding has changed,
+	// everything must be interned anew (in a new pool).
+	if (caseMappingChanged) {
+		_identifiers = [[IRCClientIdentifierPool alloc] initWithCaseFold:_serverSupport.caseFold];
+
+		NSArray <IRCClientChannel *> *channels = _channels.allValues;
+		[_channels removeAllObjects];
+		for (IRCClientChannel *channel in channels) {
+			NSData *name = channel.name;
+			_channels[[_identifiers identifierForBytes:name.bytes
+												length:name.length]] = channel;
+			[channel caseMappingChanged];
+		}
+
+		NSDictionary <IRCClientIdentifier *, NSData *> *channelKeys = [_channelKeys copy];
+		[_channelKeys removeAllObjects];
+		[channelKeys enumerateKeysAndObjectsUsingBlock:^(IRCClientIdentifier *identifier,
+														 NSData *key,
+														 BOOL *stop) {
+			_channelKeys[[_identifiers identifierForBytes:identifier.name.bytes
+												   length:identifier.name.length]] = key;
+		}];
+
+		for (IRCClientReply *reply in _pendingReplies) {
+			if (reply.targetIdentifier != nil)
+				reply.targetIdentifier = [_identifiers identifierForBytes:reply.target.bytes
+																   length:reply.target.length];
+		}
+		for (IRCClientDCCTransfer *transfer in _transfers)
+			transfer.nickIdentifier = [_identifiers identifierForBytes:transfer.nick.bytes
+																length:transfer.nick.length];
+
+		if (_ownNick != nil)
+			_ownNick = [_identifiers identifierForBytes:_nickname.bytes
+												 length:_nickname.length];
+
+		// Filter targets and masks are case-folded, too.
+		if (_eventMatcher != nil)
+			[self compileEventFilters:_eventMatcher.filters];
+	}
+}
+
+-(void) listEntryReceived:(const IRCClientMessage *)message
+						code:(NSUInteger)code {
+	// RPL_BANLIST (etc.): <client> <channel> <mask> [<who> <set-ts>]
+	IRCClientChannel *channel = [self channelNamed:IRCClientMessageParamRange(message, 1)
+										 ofMessage:message];
+	NSData *entry = IRCClientMessageParamData(message, 2);
+	if (channel == nil || entry == nil)
+		return;
+
+	uint8_t mode = (code == 367 ? 'b' : (code == 348 ? 'e' : 'I'));
+	[channel addListEntry:entry
+				  forMode:mode];
+}
+
+-(void) namesReceived:(const IRCClientMessage *)message {
+	// RPL_NAMREPLY: <client> [<symbol>] <channel> :<names>
+	// (Servers that follow RFC 1459 may omit the symbol.)
+	if (message->paramCount < 3)
+		return;
+
+	IRCClientChannel *channel = [self channelNamed:IRCClientMessageParamRange(message, message->paramCount - 2)
+										 ofMessage:message];
+	[channel namesReceived:IRCClientMessageParamData(message, message->paramCount - 1)];
+}
+
+-(void) namesEnded:(const IRCClientMessage *)message {
+	// RPL_ENDOFNAMES: <client> <channel> :End of /NAMES list
+	IRCClientChannel *channel = [self channelNamed:IRCClientMessageParamRange(message, 1)
+										 ofMessage:message];
+	[channel namesEnded];
+}
+
+-(void) userJoined:(const IRCClientMessage *)message {
+	NSRange channelName = IRCClientMessageParamRange(message, 0);
+	if (channelName.location == NSNotFound)
+		return;
+
+	if ([self isOwnNick:IRCClientMessagePrefixNickRange(message)
+			  ofMessage:message]) {
+		// We just joined a channel; allocate an IRCClientChannel object and
+		// add it to our channels list.
+
+		NSData *channelNameData = IRCClientMessageDataForRange(message, channelName);
+		IRCClientChannel* newChannel = [[IRCClientChannel alloc] initWithName:channelNameData
+																andIRCSession:self];
+		_channels[[_identifiers identifierForBytes:channelNameData.bytes
+											length:channelNameData.length]] = newChannel;
+
+		// (If we’re rejoining after a reconnect, this may be the last one.)
+		if (   _rejoinsPending > 0
+			&& --_rejoinsPending == 0)
+			[self recoveryFinished];
+
+		[self deliverEventBatch];
+		[_delegate joinedNewChannel:newChannel 
+							session:self];
+	} else {
+		// Someone joined a channel we’re on.
+		
+		IRCClientChannel* channel = [self channelNamed:channelName
+											 ofMessage:message];
+		if (channel != nil)
+			[channel userJoined:IRCClientMessageDataForRange(message, message->prefix)];
+	}
+}
+
+-(void) userParted:(const IRCClientMessage *)message {
+	NSRange channelName = IRCClientMessageParamRange(message, 0);
+	IRCClientChannel* channel = [self channelNamed:channelName
+										 ofMessage:message];
+	if (channel == nil)
+		return;
+
+	NSData *nick = IRCClientMessageDataForRange(message, message->prefix);
+	NSData *reason = IRCClientMessageParamData(message, 1);
+
+	if ([self isOwnNick:IRCClientMessagePrefixNickRange(message)
+			  ofMessage:message]) {
+		// We just left a channel; remove it from the channels dict.
+
+		[self removeChannel:channel];
+		[channel userParted:nick 
+				 withReason:reason 
+						 us:YES];
+	} else {
+		[channel userParted:nick 
+				 withReason:reason 
+						 us:NO];
+	}
+}
+
+-(void) userKicked:(const IRCClientMessage *)message {
+	NSRange channelName = IRCClientMessageParamRange(message, 0);
+	IRCClientChannel* channel = [self channelNamed:channelName
+										 ofMessage:message];
+	if (channel == nil)
+		return;
+
+	NSRange nick = IRCClientMessageParamRange(message, 1);
+	NSData *byNick = IRCClientMessageDataForRange(message, message->prefix);
+	NSData *reason = IRCClientMessageParamData(message, 2);
+
+	if (   nick.location == NSNotFound
+		|| [self isOwnNick:nick
+				 ofMessage:message]) {
+		// we got kicked from a channel we’re on :(
+		[self removeChannel:channel];
+		[channel userKicked:_nickname 
+				 withReason:reason 
+						 by:byNick 
+						 us:YES];
+	} else {
+		// Someone else got booted from a channel we’re on.
+		[channel userKicked:IRCClientMessageDataForRange(message, nick)
+				 withReason:reason 
+						 by:byNick 
+						 us:NO];
+	}
+}
+
+/********************************************/
+#pragma mark - Capability negotiation helpers
+/********************************************/
+
+-(void) capabilitiesReceived:(const IRCClientMessage *)message {
+	// CAP <nick> <subcommand> [*] :<capabilities>
+	// (A “*” before the list means that more lines of it are coming.)
+	NSRange subcommand = IRCClientMessageParamRange(message, 1);
+	BOOL continued = (   message->paramCount > 3
+					  && IRCClientMessageRangeIsEqualToCString(message, IRCClientMessageParamRange(message, 2), "*"));
+	NSRange list = IRCClientMessageParamRange(message, (continued ? 3 : 2));
+	if (list.location == NSNotFound)
+		return;
+
+	if (IRCClientMessageRangeIsEqualToCString(message, subcommand, "LS")) {
+		[self enumerateCapabilitiesInRange:list
+								 ofMessage:message
+								usingBlock:^(NSData *name, NSData *value) {
+			_offeredCapabilities[name] = value;
+		}];
+
+		if (   continued == NO
+			&& (_stateFlags & IRCClientSessionNegotiatingCapabilities))
+			[self requestCapabilities];
+	} else if (IRCClientMessageRangeIsEqualToCString(message, subcommand, "NEW")) {
+		// (With cap-notify, after registration.)
+		NSMutableArray <NSData *> *wanted = [NSMutableArray array];
+		[self enumerateCapabilitiesInRange:list
+								 ofMessage:message
+								usingBlock:^(NSData *name, NSData *value) {
+			_offeredCapabilities[name] = value;
+			if ([_requestedCapabilities containsObject:name])
+				[wanted addObject:name];
+		}];
+		if (wanted.count > 0) {
+			IRCClientOutputSegment *requests = [self capabilityRequestSegments:wanted];
+			if (requests == NULL) {
+				[self connectionLost];
+				return;
+			}
+			[self queueSegments:requests
+				 onSessionQueue:YES];
+		}
+	} else if (IRCClientMessageRangeIsEqualToCString(message, subcommand, "ACK")) {
+		[self enumerateCapabilitiesInRange:list
+								 ofMessage:message
+								usingBlock:^(NSData *name, NSData *value) {
+			// (A “-” means the capability has been disabled.)
+			if (   name.length > 1
+				&& ((const uint8_t *) name.bytes)[0] == '-')
+				[_enabledCapabilities removeObject:[name subdataWithRange:NSMakeRange(1, name.length - 1)]];
+			else
+				[_enabledCapabilities addObject:name];
+		}];
+	} else if (IRCClientMessageRangeIsEqualToCString(message, subcommand, "NAK")) {
+		// The whole request was refused; if it asked for SASL, the
+		// AUTHENTICATE that we sent along with it will fail, so we won’t
+		// be authenticating.
+		if (_stateFlags & IRCClientSessionAuthenticating) {
+			IRCClientSessionLog(IRCClientLogLevelWarning, "Capability request refused; not authenticating.");
+			_stateFlags &= ~IRCClientSessionAuthenticating;
+			[self endCapabilityNegotiation];
+		}
+	} else if (IRCClientMessageRangeIsEqualToCString(message, subcommand, "DEL")) {
+		[self enumerateCapabilitiesInRange:list
+								 ofMessage:message
+								usingBlock:^(NSData *name, NSData *value) {
+			[_offeredCapabilities removeObjectForKey:name];
+			[_enabledCapabilities removeObject:name];
+		}];
+	}
+}
+
+-(void) enumerateCapabilitiesInRange:(NSRange)list
+						   ofMessage:(const IRCClientMessage *)message
+						  usingBlock:(void (^)(NSData *name, NSData *value))block {
+	// name[=value] name[=value] ...
+	const uint8_t *bytes = message->bytes;
+	NSUInteger i = list.location;
+	NSUInteger end = NSMaxRange(list);
+	while (i < end) {
+		while (i < end && bytes[i] == ' ')
+			i++;
+		NSUInteger nameStart = i;
+		while (i < end && bytes[i] != ' ' && bytes[i] != '=')
+			i++;
+		NSRange name = NSMakeRange(nameStart, i - nameStart);
+
+		NSUInteger valueStart = i;
+		if (i < end && bytes[i] == '=')
+			valueStart = ++i;
+		while (i < end && bytes[i] != ' ')
+			i++;
+
+		if (name.length > 0)
+			block(IRCClientMessageDataForRange(message, name),
+				  IRCClientMessageDataForRange(message, NSMakeRange(valueStart, i - valueStart)));
+	}
+}
+
+// Called once the server has listed its capabilities: requests the ones we
+// want that it has, and either starts authenticating or ends negotiation,
+// all in one flight (the server handles them in order, so needn’t have
+// acknowledged the request first).
+-(void) requestCapabilities {
+	NSMutableArray <NSData *> *wanted = [NSMutableArray array];
+	for (NSData *capability in _requestedCapabilities) {
+		if (   _offeredCapabilities[capability] != nil
+			&& [wanted containsObject:capability] == NO)
+			[wanted addObject:capability];
+	}
+
+	const char *mechanism = [self SASLMechanismName];
+	NSData *sasl = [@"sasl" dataAsUTF8];
+	if (mechanism != NULL) {
+		// (If the server lists its mechanisms, ours must be one of them.)
+		NSData *mechanisms = _offeredCapabilities[sasl];
+		NSString *mechanismList = [NSString stringWithFormat:@",%@,", [NSString stringWithUTF8Data:mechanisms]];
+		if (mechanisms == nil) {
+			IRCClientSessionLog(IRCClientLogLevelWarning, "Server doesn’t support SASL; not authenticating.");
+			mechanism = NULL;
+		} else if (   mechanisms.length > 0
+				   && [mechanismList rangeOfString:[NSString stringWithFormat:@",%s,", mechanism]].location == NSNotFound) {
+			IRCClientSessionLog(IRCClientLogLevelWarning, "Server doesn’t support SASL %s; not authenticating.", mechanism);
+			mechanism = NULL;
+		} else if ([wanted containsObject:sasl] == NO) {
+			[wanted addObject:sasl];
+		}
+	}
+
+	// (Registration can’t go on without these lines, so if there’s no memory
+	// for them, we give up on the connection.)
+	IRCClientOutputSegment *head = [self capabilityRequestSegments:wanted];
+	if (   wanted.count > 0
+		&& head == NULL) {
+		[self connectionLost];
+		return;
+	}
+	IRCClientOutputSegment **link = &head;
+	while (*link != NULL)
+		link = &(*link)->next;
+
+	if (mechanism != NULL) {
+		_stateFlags |= IRCClientSessionAuthenticating;
+		IRCClientLinePart authenticate[] = {
+			IRCClientLinePartCString("AUTHENTICATE "),
+			IRCClientLinePartCString(mechanism)
+		};
+		*link = [self segmentWithLineParts:authenticate
+									 count:(sizeof(authenticate) / sizeof(IRCClientLinePart))];
+	} else {
+		_stateFlags &= ~IRCClientSessionNegotiatingCapabilities;
+		IRCClientLinePart end[] = {
+			IRCClientLinePartCString("CAP END")
+		};
+		*link = [self segmentWithLineParts:end
+									 count:(sizeof(end) / sizeof(IRCClientLinePart))];
+	}
+	if (*link == NULL) {
+		IRCClientOutputQueueFreeSegments(head);
+		[self connectionLost];
+		return;
+	}
+
+	[self queueSegments:head
+		 onSessionQueue:YES];
+}
+
+// Returns the CAP REQ lines for the given capabilities (as many to a line as
+// will fit), as a chain of segments (NULL if there are none, or if there’s no
+// memory for them).
+-(IRCClientOutputSegment *) capabilityRequestSegments:(NSArray <NSData *> *)capabilities {
+	NSUInteger lineLength = _serverSupport.lineLength;
+	NSMutableData *list = [NSMutableData dataWithCapacity:lineLength];
+
+	IRCClientOutputSegment *head = NULL;
+	IRCClientOutputSegment **link = &head;
+	NSUInteger next = 0;
+	while (next < capabilities.count) {
+		[list setData:capabilities[next++]];
+		while (   next < capabilities.count
+			   && strlen("CAP REQ :") + list.length + 1 + capabilities[next].length + 2 <= lineLength) {
+			[list appendBytes:" "
+					   length:1];
+			[list appendData:capabilities[next++]];
+		}
+
+		IRCClientLinePart request[] = {
+			IRCClientLinePartCString("CAP REQ :"),
+			IRCClientLinePartData(list)
+		};
+		*link = [self segmentWithLineParts:request
+									 count:(sizeof(request) / sizeof(IRCClientLinePart))];
+		if (*link == NULL) {
+			IRCClientOutputQueueFreeSegments(head);
+			return NULL;
+		}
+		link = &(*link)->next;
+	}
+
+	return head;
+}
 
-	return 0;
+// Returns NULL if there’s no memory for the line.
+-(IRCClientOutputSegment *) segmentWithLineParts:(const IRCClientLinePart *)parts
+										   count:(NSUInteger)count {
+	IRCClientOutputSegment *segment = IRCClientOutputQueueCreateSegment(&_outputQueue,
+																		IRCClientLinePartsLength(parts, count) + 2);
+	if (segment == NULL) {
+		IRCClientSessionLog(IRCClientLogLevelError, "Out of memory for an outbound line.");
+		return NULL;
+	}
+	IRCClientOutputSegmentWriteLineParts(segment, parts, count);
+
+	return segment;
 }
 
--(int) names:(NSData *)channel {
-	if (channel)
-		[self sendRaw:[NSData dataWithFormat:"NAMES %@", channel, nil]];
-	else
-		[self sendRaw:[NSData dataWithFormat:"NAMES", nil]];
+-(const char *) SASLMechanismName {
+	switch (_SASLMechanism) {
+		case IRCClientSASLMechanismPlain:
+			return "PLAIN";
+		case IRCClientSASLMechanismExternal:
+			return "EXTERNAL";
+		case IRCClientSASLMechanismNone:
+			return NULL;
+	}
 
-	return 0;
+	return NULL;
 }
 
--(int) list:(NSData *)channel {
-	if (channel)
-		[self sendRaw:[NSData dataWithFormat:"LIST %@", channel, nil]];
-	else
-		[self sendRaw:[NSData dataWithFormat:"LIST", nil]];
+-(void) authenticationContinued:(const IRCClientMessage *)message {
+	// AUTHENTICATE + (the server is ready for our credentials)
+	if (   (_stateFlags & IRCClientSessionAuthenticating) == 0
+		|| IRCClientMessageRangeIsEqualToCString(message, IRCClientMessageParamRange(message, 0), "+") == NO)
+		return;
 
-	return 0;
+	// PLAIN: authzid NUL authcid NUL password (with an empty authzid).
+	// EXTERNAL: nothing (the client certificate is the credential).
+	NSMutableData *credentials = [NSMutableData data];
+	if (_SASLMechanism == IRCClientSASLMechanismPlain) {
+		[credentials appendBytes:"\0"
+						  length:1];
+		[credentials appendData:(_SASLUsername ?: _nickname)];
+		[credentials appendBytes:"\0"
+						  length:1];
+		[credentials appendData:_SASLPassword];
+	}
+	NSData *payload = [credentials base64EncodedDataWithOptions:0];
+
+	// The payload goes in chunks of up to 400 bytes; one of exactly 400 (or
+	// an empty payload) is followed by a “+”.
+	IRCClientOutputSegment *head = NULL;
+	IRCClientOutputSegment **link = &head;
+	NSUInteger offset = 0;
+	do {
+		NSUInteger chunkLength = MIN(payload.length - offset, IRCClientSASLChunkSize);
+		IRCClientLinePart authenticate[] = {
+			IRCClientLinePartCString("AUTHENTICATE "),
+			(chunkLength > 0
+			 ? (IRCClientLinePart) { ((const uint8_t *) payload.bytes) + offset, chunkLength }
+			 : IRCClientLinePartCString("+"))
+		};
+		*link = [self segmentWithLineParts:authenticate
+									 count:(sizeof(authenticate) / sizeof(IRCClientLinePart))];
+		if (*link == NULL) {
+			IRCClientOutputQueueFreeSegments(head);
+			[self connectionLost];
+			return;
+		}
+		link = &(*link)->next;
+
+		offset += chunkLength;
+		if (chunkLength < IRCClientSASLChunkSize)
+			break;
+	} while (YES);
+
+	[self queueSegments:head
+		 onSessionQueue:YES];
 }
 
--(int) userMode:(NSData *)mode {
-	if (mode)
-		[self sendRaw:[NSData dataWithFormat:"MODE %@ %@", _nickname, mode, nil]];
+-(void) authenticationEnded:(const IRCClientMessage *)message
+					   code:(NSUInteger)code {
+	if ((_stateFlags & IRCClientSessionAuthenticating) == 0)
+		return;
+	_stateFlags &= ~IRCClientSessionAuthenticating;
+
+	if (code == 903)
+		IRCClientSessionLog(IRCClientLogLevelInfo, "SASL authentication succeeded.");
 	else
-		[self sendRaw:[NSData dataWithFormat:"MODE %@", _nickname, nil]];
+		IRCClientSessionLog(IRCClientLogLevelWarning, "SASL authentication failed (%lu).", (unsigned long) code);
 
-	return 0;
+	[self endCapabilityNegotiation];
 }
 
--(int) nick:(NSData *)newnick {
-	if (  !newnick
-		|| newnick.length == 0)
-		return 1;
-//		return LIBIRC_ERR_INVAL;
-
-	[self sendRaw:[NSData dataWithFormat:"NICK %@", newnick, nil]];
+-(void) endCapabilityNegotiation {
+	if ((_stateFlags & IRCClientSessionNegotiatingCapabilities) == 0)
+		return;
+	_stateFlags &= ~IRCClientSessionNegotiatingCapabilities;
 
-	return 0;
+	IRCClientLinePart end[] = {
+		IRCClientLinePartCString("CAP END")
+	};
+	if ([self queueLineParts:end
+					   count:(sizeof(end) / sizeof(IRCClientLinePart))] == NO)
+		[self connectionLost];
 }
 
--(int) who:(NSData *)nickmask {
-	if (  !nickmask
-		|| nickmask.length == 0)
-		return 1;
-//		return LIBIRC_ERR_INVAL;
+/***************************************/
+#pragma mark - Reply and batch gathering
+/***************************************/
+
+// Returns YES if the message has been gathered up into the reply to a request
+// or into an IRCv3 batch (and so is not to be handled as usual).
+-(BOOL) collectMessage:(const IRCClientMessage *)message {
+	// A message tagged with a batch’s reference belongs to that batch.
+	BOOL historical = NO;
+	if (   _openBatches.count > 0
+		&& message->tags.location != NSNotFound) {
+		IRCClientMessageTags tags;
+		IRCClientMessageTagsParse(message, &tags);
+		NSRange reference = IRCClientMessageTagValueRange(message, &tags, (const uint8_t *) "batch", strlen("batch"));
+		if (reference.location != NSNotFound) {
+			IRCClientEventBatch *batch = _openBatches[IRCClientMessageDataForRange(message, reference)];
+			[batch addMessage:message];
+			historical = IRCClientBatchIsChatHistory(batch);
+		}
+	}
 
-	[self sendRaw:[NSData dataWithFormat:"WHO %@", nickmask, nil]];
+	NSUInteger numericEventCode;
+	if (IRCClientMessageNumericCode(message, &numericEventCode))
+		return ([self collectReply:message
+							  code:numericEventCode]
+				|| historical);
 
-	return 0;
+	switch (IRCClientCommandLookup(message->bytes + message->command.location,
+								   message->command.length)) {
+		case IRCClientCommandBATCH: {
+			return [self batchBoundaryReceived:message];
+		}
+		case IRCClientCommandFAIL: {
+			// FAIL <command> <code> [<context>...] :<description>
+			IRCClientReply *reply = nil;
+			if (IRCClientMessageRangeIsEqualToCString(message, IRCClientMessageParamRange(message, 0), "CHATHISTORY"))
+				reply = [self firstPendingReplyOfType:IRCClientReplyHistory];
+			if (reply == nil)
+				return historical;
+
+			reply.failure = IRCClientMessageParamData(message, 1);
+			[self completeReply:reply];
+
+			return YES;
+		}
+		default: {
+			return historical;
+		}
+	}
 }
 
--(int) whois:(NSData *)nick {
-	if (!nick || nick.length == 0)
-		return 1;
-//		return LIBIRC_ERR_INVAL;
+-(BOOL) collectReply:(const IRCClientMessage *)message
+				code:(NSUInteger)code {
+	if (_pendingReplies.count == 0)
+		return NO;
 
-	[self sendRaw:[NSData dataWithFormat:"WHOIS %@", nick, nil]];
+	switch (code) {
+		case 353: {
+			// RPL_NAMREPLY: <client> [<symbol>] <channel> :[prefix]<nick>{ [prefix]<nick>}
+			if (message->paramCount < 3)
+				return NO;
+			IRCClientReply *reply = [self pendingReplyOfType:IRCClientReplyNames
+												   forTarget:IRCClientMessageParamRange(message, message->paramCount - 2)
+												   ofMessage:message];
+			if (reply == nil)
+				return NO;
+
+			// (The session keeps track of the channel’s members regardless.)
+			[self namesReceived:message];
+
+			NSRange names = IRCClientMessageParamRange(message, message->paramCount - 1);
+			const uint8_t *bytes = message->bytes;
+			NSUInteger i = names.location;
+			NSUInteger end = NSMaxRange(names);
+			while (i < end) {
+				while (i < end && bytes[i] == ' ')
+					i++;
+				NSUInteger start = i;
+				while (   i < end
+					   && IRCClientChannelPrefixIndex(&_serverSupport.prefixes, bytes[i]) != NSNotFound)
+					i++;
+				NSUInteger nickStart = i;
+				while (i < end && bytes[i] != ' ')
+					i++;
+
+				if (i > nickStart) {
+					NSRange fields[] = {
+						[IRCClientNamesColumnPrefixes]	= NSMakeRange(start, nickStart - start),
+						[IRCClientNamesColumnNick]		= NSMakeRange(nickStart, i - nickStart)
+					};
+					[reply addRowWithRanges:fields
+								  ofMessage:message];
+				}
+			}
 
-	return 0;
-}
+			return YES;
+		}
+		case 366: {
+			// RPL_ENDOFNAMES: <client> <channel> :End of /NAMES list
+			IRCClientReply *reply = [self pendingReplyOfType:IRCClientReplyNames
+												   forTarget:IRCClientMessageParamRange(message, 1)
+												   ofMessage:message];
+			if (reply == nil)
+				return NO;
+
+			[self namesEnded:message];
+			[self completeReply:reply];
+
+			return YES;
+		}
+		case 352: {
+			// RPL_WHOREPLY: <client> <channel> <username> <host> <server> <nick> <flags> :<hopcount> <realname>
+			IRCClientReply *reply = [self firstPendingReplyOfType:IRCClientReplyWho];
+			if (reply == nil)
+				return NO;
+
+			NSRange trailing = IRCClientMessageParamRange(message, 7);
+			NSRange hopCount = trailing;
+			NSRange realname = NSMakeRange(NSNotFound, 0);
+			if (trailing.location != NSNotFound) {
+				const uint8_t *space = memchr(message->bytes + trailing.location, ' ', trailing.length);
+				if (space != NULL) {
+					hopCount.length = (NSUInteger) (space - (message->bytes + trailing.location));
+					realname = NSMakeRange(hopCount.location + hopCount.length + 1,
+										   trailing.length - hopCount.length - 1);
+				}
+			}
 
--(int) message:(NSData *)message 
-			to:(NSData *)target {
-	if (   !target  || target.length == 0
-		|| !message || message.length == 0)
-		return 1;
-//		return LIBIRC_ERR_STATE;
+			NSRange fields[] = {
+				[IRCClientWhoColumnChannel]		= IRCClientMessageParamRange(message, 1),
+				[IRCClientWhoColumnUsername]	= IRCClientMessageParamRange(message, 2),
+				[IRCClientWhoColumnHost]		= IRCClientMessageParamRange(message, 3),
+				[IRCClientWhoColumnServer]		= IRCClientMessageParamRange(message, 4),
+				[IRCClientWhoColumnNick]		= IRCClientMessageParamRange(message, 5),
+				[IRCClientWhoColumnFlags]		= IRCClientMessageParamRange(message, 6),
+				[IRCClientWhoColumnHopCount]	= hopCount,
+				[IRCClientWhoColumnRealname]	= realname
+			};
+			[reply addRowWithRanges:fields
+						  ofMessage:message];
+
+			return YES;
+		}
+		case 315: {
+			// RPL_ENDOFWHO: <client> <mask> :End of WHO list
+			IRCClientReply *reply = [self firstPendingReplyOfType:IRCClientReplyWho];
+			if (reply == nil)
+				return NO;
 
-	[self sendRaw:[NSData dataWithFormat:"PRIVMSG %@ :%@", target, [self colorConvertToMIRC:message], nil]];
+			[self completeReply:reply];
 
-	return 0;
-}
+			return YES;
+		}
+		case 321: {
+			// RPL_LISTSTART: <client> Channel :Users  Name
+			return ([self firstPendingReplyOfType:IRCClientReplyList] != nil);
+		}
+		case 322: {
+			// RPL_LIST: <client> <channel> <client count> :<topic>
+			IRCClientReply *reply = [self firstPendingReplyOfType:IRCClientReplyList];
+			if (reply == nil)
+				return NO;
+
+			NSRange fields[] = {
+				[IRCClientListColumnChannel]	= IRCClientMessageParamRange(message, 1),
+				[IRCClientListColumnUsers]		= IRCClientMessageParamRange(message, 2),
+				[IRCClientListColumnTopic]		= IRCClientMessageParamRange(message, 3)
+			};
+			[reply addRowWithRanges:fields
+						  ofMessage:message];
+
+			return YES;
+		}
+		case 323: {
+			// RPL_LISTEND: <client> :End of /LIST
+			IRCClientReply *reply = [self firstPendingReplyOfType:IRCClientReplyList];
+			if (reply == nil)
+				return NO;
 
--(int) action:(NSData *)action
-		   to:(NSData *)target {
-	if (   !target || target.length == 0
-		|| !action || action.length == 0)
-		return 1;
-//		return LIBIRC_ERR_STATE;
+			[self completeReply:reply];
 
-	[self sendRaw:[NSData dataWithFormat:"PRIVMSG %@ :\x01" "ACTION %@\x01", target, [self colorConvertToMIRC:action], nil]];
+			return YES;
+		}
+		case 263:
+		case 416:
+		case 461: {
+			// RPL_TRYAGAIN: <client> <command> :Please wait a while and try again.
+			// ERR_TOOMANYMATCHES: <client> <command> [<mask>] :Output too long
+			// ERR_NEEDMOREPARAMS: <client> <command> :Not enough parameters
+			NSRange command = IRCClientMessageParamRange(message, 1);
+			IRCClientReply *reply = nil;
+			if (IRCClientMessageRangeIsEqualToCString(message, command, "LIST"))
+				reply = [self firstPendingReplyOfType:IRCClientReplyList];
+			else if (IRCClientMessageRangeIsEqualToCString(message, command, "WHO"))
+				reply = [self firstPendingReplyOfType:IRCClientReplyWho];
+			else if (IRCClientMessageRangeIsEqualToCString(message, command, "NAMES"))
+				reply = [self firstPendingReplyOfType:IRCClientReplyNames];
+			if (reply == nil)
+				return NO;
+
+			[self failReply:reply
+				withMessage:message];
+
+			return YES;
+		}
+		case 401:
+		case 403: {
+			// ERR_NOSUCHNICK: <client> <nick> :No such nick/channel
+			// ERR_NOSUCHCHANNEL: <client> <channel> :No such channel
+			IRCClientReply *reply = [self pendingReplyForTarget:IRCClientMessageParamRange(message, 1)
+													  ofMessage:message];
+			if (reply == nil)
+				return NO;
+
+			[self failReply:reply
+				withMessage:message];
+
+			return YES;
+		}
+		case 481: {
+			// ERR_NOPRIVILEGES: <client> :Permission Denied
+			// (This doesn’t say what was denied; since the server answers in
+			// order, it’s taken to be the oldest WHO, LIST, or NAMES request.)
+			for (IRCClientReply *reply in _pendingReplies) {
+				if (reply.type != IRCClientReplyHistory) {
+					[self failReply:reply
+						withMessage:message];
+
+					return YES;
+				}
+			}
 
-	return 0;
+			return NO;
+		}
+		default: {
+			return NO;
+		}
+	}
 }
 
--(int) notice:(NSData *)notice 
-		   to:(NSData *)target {
-	if (   !target || target.length == 0
-		|| !notice || notice.length == 0)
-		return 1;
-//		return LIBIRC_ERR_STATE;
+// BATCH +<reference> <type> [<params>...] starts a batch, and
+// BATCH -<reference> ends it.
+-(BOOL) batchBoundaryReceived:(const IRCClientMessage *)message {
+	NSRange reference = IRCClientMessageParamRange(message, 0);
+	if (   reference.location == NSNotFound
+		|| reference.length < 2)
+		return NO;
+	uint8_t sign = IRCClientMessageRangeFirstByte(message, reference);
+	NSData *key = IRCClientMessageDataForRange(message, NSMakeRange(reference.location + 1, reference.length - 1));
+
+	if (sign == '+') {
+		// (Past the limit, a batch’s messages are handled as if unbatched.)
+		if (_openBatches.count >= IRCClientOpenBatchLimit) {
+			IRCClientSessionLog(IRCClientLogLevelWarning, "Too many open batches; not gathering up another.");
+			return NO;
+		}
 
-	[self sendRaw:[NSData dataWithFormat:"NOTICE %@ :%@", target, notice, nil]];
+		IRCClientEventBatch *batch = [[IRCClientEventBatch alloc] initWithCapacity:0];
+		batch.batchType = IRCClientMessageParamData(message, 1);
+		batch.batchParams = IRCClientMessageParamsArray(message, 2);
+		_openBatches[key] = batch;
 
-	return 0;
-}
+		return YES;
+	} else if (sign == '-') {
+		IRCClientEventBatch *batch = _openBatches[key];
+		if (batch == nil)
+			return NO;
+		[_openBatches removeObjectForKey:key];
+
+		// Chat history that was asked for goes to whoever asked for it.
+		if (IRCClientBatchIsChatHistory(batch)) {
+			NSData *target = batch.batchParams.firstObject;
+			IRCClientIdentifier *identifier = (target != nil
+											   ? [_identifiers existingIdentifierForBytes:target.bytes
+																				   length:target.length]
+											   : nil);
+			for (IRCClientReply *reply in _pendingReplies) {
+				if (   reply.type == IRCClientReplyHistory
+					&& identifier != nil
+					&& reply.targetIdentifier == identifier) {
+					reply.messages = batch;
+					[self completeReply:reply];
+
+					return YES;
+				}
+			}
+		}
 
--(int) ctcpRequest:(NSData *)request 
-			target:(NSData *)target {
-	if (   !target  || target.length == 0
-		|| !request || request.length == 0)
-		return 1;
-//		return LIBIRC_ERR_STATE;
+		if (_delegateCapabilities & IRCClientDelegateReceivesBatches) {
+			[_delegate batchReceived:batch
+							 session:self];
+		}
 
-	[self sendRaw:[NSData dataWithFormat:"PRIVMSG %@ :\x01%@\x01", target, request, nil]];
-	return 0;
+		return YES;
+	}
+
+	return NO;
 }
 
--(int) ctcpReply:(NSData *)reply 
-		  target:(NSData *)target {
-	if (   !target || target.length == 0
-		|| !reply  || reply.length == 0)
-		return 1;
-//		return LIBIRC_ERR_STATE;
+-(IRCClientReply *) firstPendingReplyOfType:(IRCClientReplyType)type {
+	for (IRCClientReply *reply in _pendingReplies)
+		if (reply.type == type)
+			return reply;
 
-	[self sendRaw:[NSData dataWithFormat:"NOTICE %@ :\x01%@\x01", target, reply, nil]];
-	return 0;
+	return nil;
 }
 
-/********************************/
-#pragma mark - IRC event handlers
-/********************************/
+-(IRCClientReply *) pendingReplyOfType:(IRCClientReplyType)type
+							 forTarget:(NSRange)target
+							 ofMessage:(const IRCClientMessage *)message {
+	if (target.location == NSNotFound)
+		return nil;
 
--(NSData *) CTCPContent:(NSData *)messageBody {
-	NSData *ctcpQuote = [NSData dataFromCString:"\x01"];
-	if (messageBody.length > 1
-		&& [[messageBody subdataWithRange:NSRangeMake(0, 1)] isEqualToData:ctcpQuote]
-		&& [[messageBody subdataWithRange:NSRangeMake(messageBody.length - 1, 1)] isEqualToData:ctcpQuote]) {
-		return [messageBody subdataWithRange:NSRangeMake(1, messageBody.length - 2)];
-	} else {
+	// (A pending reply holds on to its target’s identifier, so if there is
+	// one for this target, the identifier exists.)
+	IRCClientIdentifier *identifier = [_identifiers existingIdentifierForBytes:(message->bytes + target.location)
+																		length:target.length];
+	if (identifier == nil)
 		return nil;
-	}
-}
 
--(NSData *) processColorCodes:(NSData *)messageBody {
-	typedef NS_ENUM(NSUInteger, SA_IRC_ColorCodeHandling) {
-		SA_IRC_ParseColorCodes,
-		SA_IRC_StripColorCodes,
-		SA_IRC_IgnoreColorCodes,
-	};
+	for (IRCClientReply *reply in _pendingReplies)
+		if (   reply.type == type
+			&& reply.targetIdentifier == identifier)
+			return reply;
 
-	// TODO: Support setting this somehow...
-	SA_IRC_ColorCodeHandling whatAboutColors = SA_IRC_ParseColorCodes;
+	return nil;
+}
 
-	switch (whatAboutColors) {
-		case SA_IRC_IgnoreColorCodes:
-			return messageBody;
-		case SA_IRC_ParseColorCodes:
-			return [self colorConvertFromMIRC:messageBody];
-		case SA_IRC_StripColorCodes:
-			return [self colorStripFromMIRC:messageBody];
-	}
-}
-
--(void) handleIRCEvent:(NSData *)command
-				  from:(NSData *)origin
-				params:(NSArray <NSData *> *)params {
-	// This is so we can refer to “param [ 0 / 1 / 2 ] or nil” without
-	// having to check for out-of-range every time.
-	NSData *param_0 = (params.count > 0
-					   ? params[0]
-					   : nil);
-	NSData *param_1 = (params.count > 1
-					   ? params[1]
-					   : nil);
-	NSData *param_2 = (params.count > 2
-					   ? params[2]
-					   : nil);
-
-	// PING event.
-	if ([command isEqualToCString:"PING"]) {
-		// TODO: implement an "ignore ping" toggle
-		// and a "ping passthrough" toggle
-		[self sendRaw:[NSData dataWithFormat:"PONG %@", param_0, nil]];
-
-		if ([_delegate respondsToSelector:@selector(ping:from:session:)]) {
-			[_delegate ping:param_0
-					   from:origin
-					session:self];
-		}
+// Returns the pending reply to a request for the given target (a NAMES
+// request for it, or else the oldest WHO or LIST request for it), if any.
+-(IRCClientReply *) pendingReplyForTarget:(NSRange)target
+								ofMessage:(const IRCClientMessage *)message {
+	IRCClientReply *reply = [self pendingReplyOfType:IRCClientReplyNames
+										   forTarget:target
+										   ofMessage:message];
+	if (reply != nil)
+		return reply;
+
+	for (reply in _pendingReplies)
+		if (   (   reply.type == IRCClientReplyWho
+				|| reply.type == IRCClientReplyList)
+			&& IRCClientMessageRangeIsEqualToData(message, target, reply.target))
+			return reply;
+
+	return nil;
+}
 
-		return;
-	}
+-(void) completeReply:(IRCClientReply *)reply {
+	[_pendingReplies removeObjectIdenticalTo:reply];
+	reply.completion(reply, self);
+}
 
-	// Numeric event.
-	if (   command.length == 3
-		&& isdigit(((char *) command.bytes)[0])
-		&& isdigit(((char *) command.bytes)[1])
-		&& isdigit(((char *) command.bytes)[2])) {
-		NSUInteger numericEventCode = (NSUInteger) atoi(command.terminatedCString);
-
-		// RPL_WELCOME, RPL_ENDOFMOTD, or ERR_NOMOTD.
-		if (   (   numericEventCode == 1
-				|| numericEventCode == 376
-				|| numericEventCode == 422)
-			&& !(_stateFlags & IRCClientSessionMOTDReceived)) {
-			_stateFlags |= IRCClientSessionMOTDReceived;
-			[_delegate connectionSucceeded:self];
-		}
-
-		if ([_delegate respondsToSelector:@selector(numericEventReceived:from:params:session:)]) {
-			[_delegate numericEventReceived:numericEventCode
-									   from:origin
-									 params:params
-									session:self];
-		}
+// Completes the reply as refused, with the code of the given numeric reply.
+-(void) failReply:(IRCClientReply *)reply
+	  withMessage:(const IRCClientMessage *)message {
+	reply.failure = IRCClientMessageDataForRange(message, message->command);
+	[self completeReply:reply];
+}
 
+/*************************/
+#pragma mark - DCC helpers
+/*************************/
+
+-(void) DCCRequestReceived:(NSRange)request
+				 ofMessage:(const IRCClientMessage *)message {
+	NSArray <NSData *> *arguments = [self DCCArgumentsInRange:request
+													ofMessage:message];
+	if (arguments.count < 4)
 		return;
-	}
 
-	// IRC command.
-	if ([command isEqualToCString:"NICK"]) {
-		/*!
-		 * The ‘nick’ event is triggered when the client receives a NICK message,
-		 * meaning that someone (including you) on a channel with the client has
-		 * changed their nickname.
-		 *
-		 * \param origin The person who changed their nick. Note that it can be you!
-		 * \param params[0] Mandatory; contains the new nick.
-		 */
-		[self nickChangedFrom:origin
-						   to:param_0];
-	} else if ([command isEqualToCString:"QUIT"]) {
-		/*!
-		 * The ‘quit’ event is triggered upon receipt of a QUIT message, which
-		 * means that someone on a channel with the client has disconnected.
-		 *
-		 * \param origin The person who is disconnected.
-		 * \param params[0] Optional; contains the reason message (user-specified).
-		 */
-		[_delegate userQuit:origin
-				 withReason:param_0
-					session:self];
-	} else if ([command isEqualToCString:"JOIN"]) {
-		/*!
-		 * The ‘join’ event is triggered upon receipt of a JOIN message, which
-		 * means that someone has entered a channel that the client is on.
-		 *
-		 * \param origin The person who joined the channel. By comparing it with
-		 *               your own nickname, you can check whether your JOIN
-		 *               command succeed.
-		 * \param params[0] Mandatory; contains the channel name.
-		 */
-		[self userJoined:origin
-				 channel:param_0];
-	} else if ([command isEqualToCString:"PART"]) {
-		/*!
-		 * The ‘part’ event is triggered upon receipt of a PART message, which
-		 * means that someone has left a channel that the client is on.
-		 *
-		 * \param Origin The person who left the channel. By comparing it with
-		 *               your own nickname, you can check whether your PART
-		 *               command succeed.
-		 * \param params[0] Mandatory; contains the channel name.
-		 * \param params[1] Optional; contains the reason message (user-defined).
-		 */
-		[self userParted:origin
-				 channel:param_0
-			  withReason:param_1];
-	} else if ([command isEqualToCString:"MODE"]) {
-		if (   param_0
-			&& [param_0 isEqualToData:_nickname]) {
-			/*!
-			 * The ‘umode’ event is triggered upon receipt of a user MODE message,
-			 * which means that your user mode has been changed.
-			 *
-			 * \param origin The person who changed the user mode.
-			 * \param params[0] Mandatory; contains the user changed mode, like
-			 *        ‘+t’, ‘-i’ and so on.
-			 */
-			[_delegate modeSet:param_1
-							by:origin
-					   session:self];
-		} else {
-			/*!
-			 * The ‘mode’ event is triggered upon receipt of a channel MODE message,
-			 * which means that someone on a channel with the client has changed the
-			 * channel’s parameters.
-			 *
-			 * \param origin The person who changed the channel mode.
-			 * \param params[0] Mandatory; contains the channel name.
-			 * \param params[1] Mandatory; contains the changed channel mode, like
-			 *        ‘+t’, ‘-i’, and so on.
-			 * \param params[2] Optional; contains the mode argument (for example, a
-			 *      key for +k mode, or user who got channel operator status for
-			 *      +o mode)
-			 */
-			IRCClientChannel *channel = _channels[param_0];
-			[channel modeSet:param_1
-				  withParams:param_2
-						  by:origin];
-		}
-	} else if ([command isEqualToCString:"TOPIC"]) {
-		/*!
-		 * The ‘topic’ event is triggered upon receipt of a TOPIC message, which
-		 * means that someone on a channel with the client has changed the
-		 * channel’s topic.
-		 *
-		 * \param origin The person who changes the channel topic.
-		 * \param params[0] Mandatory; contains the channel name.
-		 * \param params[1] Optional; contains the new topic.
-		 */
-		IRCClientChannel *channel = _channels[param_0];
-		[channel topicSet:param_1
-					   by:origin];
-	} else if ([command isEqualToCString:"KICK"]) {
-		/*!
-		 * The ‘kick’ event is triggered upon receipt of a KICK message, which
-		 * means that someone on a channel with the client (or possibly the
-		 * client itself!) has been forcibly ejected.
-		 *
-		 * \param origin The person who kicked the poor victim.
-		 * \param params[0] Mandatory; contains the channel name.
-		 * \param params[1] Optional; contains the nick of kicked person.
-		 * \param params[2] Optional; contains the kick text.
-		 */
-		[self userKicked:param_1
-			 fromChannel:param_0
-					  by:origin
-			  withReason:param_2];
-	} else if ([command isEqualToCString:"ERROR"]) {
-		/*!
-		 * The ‘error’ event is triggered upon receipt of an ERROR message, which
-		 * (when sent to clients) usually means the client has been disconnected.
-		 *
-		 * \param origin the person, who generates the message.
-		 * \param params optional, contains who knows what.
-		 */
-		[_delegate errorReceived:params
-						 session:self];
-	} else if ([command isEqualToCString:"INVITE"]) {
-		/*!
-		 * The ‘invite’ event is triggered upon receipt of an INVITE message,
-		 * which means that someone is permitting the client’s entry into a +i
-		 * channel.
-		 *
-		 * \param origin The person who INVITEd you.
-		 * \param params[0] Mandatory; contains your nick.
-		 * \param params[1] Mandatory; contains the channel name you’re invited into.
-		 *
-		 * \sa irc_cmd_invite irc_cmd_chanmode_invite
-		 */
-		[_delegate invitedToChannel:param_1
-								 by:origin
-							session:self];
-	} else if ([command isEqualToCString:"PRIVMSG"]) {
-		NSData *ctcpContent = [self CTCPContent:param_1];
-		if (ctcpContent) {
-			NSData *dccPrefix = [NSData dataFromCString:"DCC "];
-			NSData *actionPrefix = [NSData dataFromCString:"ACTION "];
-			if ([[ctcpContent subdataWithRange:NSRangeMake(0, dccPrefix.length)] isEqualToData:dccPrefix]) {
-				// TODO: implement DCC request support!
-			} else if ([[ctcpContent subdataWithRange:NSRangeMake(0, actionPrefix.length)] isEqualToData:actionPrefix]) {
-				NSData *action = [self processColorCodes:[ctcpContent
-														  subdataWithRange:[ctcpContent
-																			rangeAfterRange:NSRangeMake(0, actionPrefix.length)]]];
-				/*!
-				 * The ‘action’ event is triggered when the client receives the CTCP
-				 * ACTION message. These messages usually looks like:\n
-				 * \code
-				 * [23:32:55] * Tim gonna sleep.
-				 * \endcode
-				 *
-				 * \param origin The person who generated the message.
-				 * \param params[0] Mandatory; the target of the message.
-				 * \param params[1] Mandatory; the ACTION message.
-				 */
-				IRCClientChannel* channel = _channels[param_0];
-				if (channel != nil) {
-					// An action on a channel we’re on.
-					[channel actionPerformed:action
-									  byUser:origin];
-				} else {
-					// An action in a private message.
-					[_delegate privateCTCPActionReceived:action
-												fromUser:origin
-												 session:self];
-				}
-			} else {
-				/*!
-				 * The ‘ctcp’ event is triggered when the client receives the CTCP
-				 * request. By default, the built-in CTCP request handler is used. The
-				 * build-in handler automatically replies on most CTCP messages, so you
-				 * will rarely need to override it.
-				 *
-				 * \param origin The person who generated the message.
-				 * \param params[0] Mandatory; contains the complete CTCP message, including
-				 *                  its arguments.
-				 *
-				 * Mirc generates PING, FINGER, VERSION, TIME and ACTION messages,
-				 * check the source code of \c libirc_event_ctcp_internal function to
-				 * see how to write your own CTCP request handler. Also you may find
-				 * useful this question in FAQ: \ref faq4
-				 */
-				[self CTCPRequestReceived:ctcpContent
-								 fromUser:origin];
+	NSRange nick = IRCClientMessagePrefixNickRange(message);
+	if (nick.location == NSNotFound)
+		return;
+	IRCClientIdentifier *identifier = [_identifiers identifierForBytes:(message->bytes + nick.location)
+																length:nick.length];
+
+	NSData *type = arguments[0];
+	uint64_t port = 0;
+	uint64_t value = 0;
+	if (IRCClientDataIsEqualToCString(type, "SEND")) {
+		// SEND <filename> <address> <port> [<size> [<token>]]
+		NSData *address = IRCClientDCCAddressFromArgument(arguments[2]);
+		if (   address == nil
+			|| IRCClientDataUnsignedValue(arguments[3], &port) == NO
+			|| port > UINT16_MAX)
+			return;
+		if (arguments.count > 4)
+			IRCClientDataUnsignedValue(arguments[4], &value);
+		NSData *token = (arguments.count > 5 ? arguments[5] : nil);
+
+		// The receiver of one of our passive offers, saying where to connect.
+		if (   port != 0
+			&& token != nil) {
+			IRCClientDCCTransfer *transfer = [self transferWithDirection:IRCClientDCCTransferSend
+																	nick:identifier
+																	port:0
+																   token:token];
+			if (transfer != nil) {
+				[transfer connectToAddress:address
+									  port:(NSUInteger) port];
+				return;
 			}
-		} else if ([param_0 isEqualToData:_nickname]) {
-			/*!
-			 * The ‘privmsg’ event is triggered upon receipt of a PRIVMSG message
-			 * which is addressed to one or more clients, which means that someone
-			 * is sending the client a private message.
-			 *
-			 * \param origin The person who generated the message.
-			 * \param params[0] Mandatory; contains your nick.
-			 * \param params[1] Optional; contains the message text.
-			 */
-			NSData *message = [self processColorCodes:param_1];
-			[_delegate privateMessageReceived:message
-									 fromUser:origin
-									  session:self];
-		} else if (   ((char *) param_0.bytes)[0] == '#'
-				   || ((char *) param_0.bytes)[0] == '&'
-				   || ((char *) param_0.bytes)[0] == '!'
-				   || ((char *) param_0.bytes)[0] == '+') {
-			/*!
-			 * The ‘chanmsg’ event is triggered upon receipt of a PRIVMSG message
-			 * to an entire channel, which means that someone on a channel with
-			 * the client has said something aloud. Your own messages don’t trigger
-			 * PRIVMSG event.
-			 *
-			 * \param origin The person who generated the message.
-			 * \param params[0] Mandatory; contains the channel name.
-			 * \param params[1] Optional; contains the message text.
-			 */
-			IRCClientChannel *channel = _channels[param_0];
-			NSData *message = [self processColorCodes:param_1];
-			[channel messageSent:message
-						  byUser:origin];
-		} else {
-			/*!
-			 * The ‘servmsg’ event is triggered upon receipt of a PRIVMSG message
-			 * which is addressed to no one in particular, but it sent to the client
-			 * anyway.
-			 *
-			 * \param origin The person who generated the message.
-			 * \param params Optional; contains who knows what.
-			 */
-			params = [params map:^id(NSData *param) {
-				return [self processColorCodes:param];
-			}];
-			[_delegate serverMessageReceivedFrom:origin
-										  params:params
-										 session:self];
 		}
-	} else if ([command isEqualToCString:"NOTICE"]) {
-		NSData *ctcpContent = [self CTCPContent:param_1];
-		if (ctcpContent) {
-			/*!
-			 * The ‘ctcp’ event is triggered when the client receives the CTCP reply.
-			 *
-			 * \param origin The person who generated the message.
-			 * \param params[0] Mandatory; the CTCP message itself with its arguments.
-			 */
-			if ([_delegate respondsToSelector:@selector(CTCPReplyReceived:fromUser:session:)]) {
-				[_delegate CTCPReplyReceived:param_0
-									fromUser:origin
-									 session:self];
-			}
-		} else if ([param_0 isEqualToData:_nickname]) {
-			/*!
-			 * The ‘notice’ event is triggered upon receipt of a NOTICE message
-			 * which means that someone has sent the client a public or private
-			 * notice. According to RFC 1459, the only difference between NOTICE
-			 * and PRIVMSG is that you should NEVER automatically reply to NOTICE
-			 * messages. Unfortunately, this rule is frequently violated by IRC
-			 * servers itself - for example, NICKSERV messages require reply, and
-			 * are NOTICEs.
-			 *
-			 * \param origin The person who generated the message.
-			 * \param params[0] Mandatory; contains your nick.
-			 * \param params[1] Optional; contains the message text.
-			 */
-			NSData *notice = [self processColorCodes:param_1];
-			[_delegate privateNoticeReceived:notice
-									fromUser:origin
-									 session:self];
-		} else if (   ((char *) param_0.bytes)[0] == '#'
-				   || ((char *) param_0.bytes)[0] == '&'
-				   || ((char *) param_0.bytes)[0] == '!'
-				   || ((char *) param_0.bytes)[0] == '+') {
-			/*!
-			 * The ‘notice’ event is triggered upon receipt of a NOTICE message
-			 * which means that someone has sent the client a public or private
-			 * notice. According to RFC 1459, the only difference between NOTICE
-			 * and PRIVMSG is that you should NEVER automatically reply to NOTICE
-			 * messages. Unfortunately, this rule is frequently violated by IRC
-			 * servers itself - for example, NICKSERV messages require reply, and
-			 * are NOTICEs.
-			 *
-			 * \param origin The person who generated the message.
-			 * \param params[0] Mandatory; contains the target channel name.
-			 * \param params[1] Optional; contains the message text.
-			 */
-			IRCClientChannel *channel = _channels[param_0];
-			NSData *notice = [self processColorCodes:param_1];
-			[channel noticeSent:notice
-						 byUser:origin];
+
+		if ((_delegateCapabilities & IRCClientDelegateFileTransferOffered) == 0)
+			return;
+
+		// (So that a flood of offers can’t pile up transfers.)
+		NSUInteger offers = 0;
+		NSUInteger offersFromNick = 0;
+		for (IRCClientDCCTransfer *offer in _transfers) {
+			if (   offer.direction != IRCClientDCCTransferReceive
+				|| offer.state != IRCClientDCCTransferOffered
+				|| offer.path != nil)
+				continue;
+
+			offers++;
+			if (offer.nickIdentifier == identifier)
+				offersFromNick++;
+		}
+		if (   offers >= IRCClientDCCOfferLimit
+			|| offersFromNick >= IRCClientDCCOfferLimitPerNick) {
+			IRCClientSessionLog(IRCClientLogLevelWarning, "Too many file transfer offers waiting; ignoring another.");
+			return;
+		}
+
+		IRCClientDCCTransfer *transfer = [[IRCClientDCCTransfer alloc] initWithDirection:IRCClientDCCTransferReceive
+																					 nick:identifier.name
+																				 filename:arguments[1]
+																					 size:value
+																				  passive:(port == 0)
+																					queue:_q];
+		transfer.remoteAddress = address;
+		transfer.remotePort = (NSUInteger) port;
+		transfer.token = token;
+		[self trackTransfer:transfer];
+
+		// Offers not taken up in time are dropped.
+		__weak IRCClientDCCTransfer *weakTransfer = transfer;
+		dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t) (transfer.offerTimeout * NSEC_PER_SEC)), _q, ^{
+			IRCClientDCCTransfer *offeredTransfer = weakTransfer;
+			if (   offeredTransfer.state == IRCClientDCCTransferOffered
+				&& offeredTransfer.path == nil)
+				[offeredTransfer failWithErrno:ETIMEDOUT];
+		});
+
+		[_delegate fileTransferOffered:transfer
+							   session:self];
+	} else if (   IRCClientDataIsEqualToCString(type, "RESUME")
+			   || IRCClientDataIsEqualToCString(type, "ACCEPT")) {
+		// RESUME <filename> <port> <position> [<token>] asks us to send only
+		// the rest of a file; ACCEPT (with the same arguments) agrees to.
+		if (   IRCClientDataUnsignedValue(arguments[2], &port) == NO
+			|| IRCClientDataUnsignedValue(arguments[3], &value) == NO)
+			return;
+		NSData *token = (arguments.count > 4 ? arguments[4] : nil);
+
+		BOOL resume = IRCClientDataIsEqualToCString(type, "RESUME");
+		IRCClientDCCTransfer *transfer = [self transferWithDirection:(resume ? IRCClientDCCTransferSend : IRCClientDCCTransferReceive)
+																nick:identifier
+																port:(NSUInteger) port
+															   token:token];
+		if (transfer == nil)
+			return;
+
+		if (resume) {
+			if (value >= transfer.size)
+				return;
+			transfer.startPosition = value;
+
+			NSMutableArray <NSData *> *reply = [arguments mutableCopy];
+			reply[0] = [@"ACCEPT" dataAsUTF8];
+			reply[1] = transfer.filename;
+			[self sendDCCRequest:reply
+							  to:transfer.nick];
 		} else {
-			/*!
-			 * The ‘server_notice’ event is triggered upon receipt of a NOTICE
-			 * message which means that the server has sent the client a notice.
-			 * This notice is not necessarily addressed to the client’s nick
-			 * (for example, AUTH notices, sent before the client’s nick is known).
-			 * According to RFC 1459, the only difference between NOTICE
-			 * and PRIVMSG is that you should NEVER automatically reply to NOTICE
-			 * messages. Unfortunately, this rule is frequently violated by IRC
-			 * servers itself - for example, NICKSERV messages require reply, and
-			 * are NOTICEs.
-			 *
-			 * \param origin The person who generated the message.
-			 * \param params Optional; contains who knows what.
-			 */
-			params = [params map:^id(NSData *param) {
-				return [self processColorCodes:param];
-			}];
-			[_delegate serverNoticeReceivedFrom:origin
-										 params:params
-										session:self];
+			// (Only the position we asked for will do, and only once.)
+			if (   transfer.awaitingAccept == NO
+				|| value != transfer.startPosition)
+				return;
+			transfer.awaitingAccept = NO;
+			[self startReceiving:transfer];
 		}
-	} else {
-		/*!
-		 * The ‘unknown’ event is triggered upon receipt of any number of
-		 * unclassifiable miscellaneous messages, which aren’t handled by the
-		 * library.
-		 */
-		if ([_delegate respondsToSelector:@selector(unknownEventReceived:from:params:session:)]) {
-			[_delegate unknownEventReceived:command
-									   from:origin
-									 params:params
-									session:self];
+	} else if (IRCClientDataIsEqualToCString(type, "CHAT")) {
+		// CHAT chat <address> <port>
+		NSData *address = IRCClientDCCAddressFromArgument(arguments[2]);
+		if (   address == nil
+			|| IRCClientDataUnsignedValue(arguments[3], &port) == NO
+			|| port == 0
+			|| port > UINT16_MAX)
+			return;
+
+		if (_delegateCapabilities & IRCClientDelegateDCCChatOffered) {
+			[_delegate DCCChatOffered:address
+								 port:(NSUInteger) port
+							 fromUser:identifier.name
+							  session:self];
 		}
 	}
 }
 
-/******************************************/
-#pragma mark - Event handler helper methods
-/******************************************/
+// Splits a DCC request into its arguments, at spaces; an argument (i.e. a
+// filename) in double quotes may have spaces in it.
+-(NSArray <NSData *> *) DCCArgumentsInRange:(NSRange)range
+								  ofMessage:(const IRCClientMessage *)message {
+	NSMutableArray <NSData *> *arguments = [NSMutableArray array];
+
+	const uint8_t *bytes = message->bytes;
+	NSUInteger i = range.location;
+	NSUInteger end = NSMaxRange(range);
+	while (i < end) {
+		while (i < end && bytes[i] == ' ')
+			i++;
+		if (i == end)
+			break;
 
--(void) nickChangedFrom:(NSData *)oldNick
-					 to:(NSData *)newNick {
-	NSData* oldNickOnly = [IRCClientSession nickFromNickUserHost:oldNick];
-	
-	if ([_nickname isEqualToData:oldNickOnly]) {
-		_nickname = newNick;
-		[_delegate nickChangedFrom:oldNickOnly
-								to:newNick 
-							   own:YES 
-						   session:self];
-	} else {
-		[_delegate nickChangedFrom:oldNickOnly 
-								to:newNick 
-							   own:NO 
-						   session:self];
+		NSUInteger start;
+		NSUInteger argumentEnd;
+		if (bytes[i] == '"') {
+			start = ++i;
+			while (i < end && bytes[i] != '"')
+				i++;
+			argumentEnd = i;
+			if (i < end)
+				i++;
+		} else {
+			start = i;
+			while (i < end && bytes[i] != ' ')
+				i++;
+			argumentEnd = i;
+		}
+		[arguments addObject:IRCClientMessageDataForRange(message, NSMakeRange(start, argumentEnd - start))];
 	}
+
+	return arguments;
 }
 
--(void) userJoined:(NSData *)nick
-		   channel:(NSData *)channelName {
-	NSData* nickOnly = [IRCClientSession nickFromNickUserHost:nick];
-	
-	if ([_nickname isEqualToData:nickOnly]) {
-		// We just joined a channel; allocate an IRCClientChannel object and
-		// add it to our channels list.
+-(void) sendDCCRequest:(NSArray <NSData *> *)arguments
+					to:(NSData *)nick {
+	NSMutableData *request = [NSMutableData dataWithBytes:"DCC"
+												   length:strlen("DCC")];
+	for (NSData *argument in arguments) {
+		// (Filenames with spaces in them are quoted.)
+		BOOL quoted = (memchr(argument.bytes, ' ', argument.length) != NULL);
+		[request appendBytes:(quoted ? " \"" : " ")
+					  length:(quoted ? 2 : 1)];
+		[request appendData:argument];
+		if (quoted)
+			[request appendBytes:"\""
+						  length:1];
+	}
 
-		IRCClientChannel* newChannel = [[IRCClientChannel alloc] initWithName:channelName
-																andIRCSession:self];
-		_channels[channelName] = newChannel;
-		[_delegate joinedNewChannel:newChannel 
-							session:self];
-	} else {
-		// Someone joined a channel we’re on.
-		
-		IRCClientChannel* channel = _channels[channelName];
-		[channel userJoined:nick];
+	[self ctcpRequest:request
+			   target:nick];
+}
+
+// Returns our DCCAddress as it goes in a DCC request (an IPv4 address as a
+// decimal number, an IPv6 address as is), and puts its family in *family;
+// or returns nil if there isn’t one.
+-(NSData *) DCCAddressArgumentWithFamily:(int *)family {
+	NSString *address = self.DCCAddress;
+	if (address == nil)
+		return nil;
+
+	struct in_addr address4;
+	struct in6_addr address6;
+	if (inet_pton(AF_INET, address.UTF8String, &address4) == 1) {
+		*family = AF_INET;
+		return [[NSString stringWithFormat:@"%u", ntohl(address4.s_addr)] dataAsUTF8];
+	} else if (inet_pton(AF_INET6, address.UTF8String, &address6) == 1) {
+		*family = AF_INET6;
+		return [address dataAsUTF8];
 	}
+
+	return nil;
 }
 
--(void) userParted:(NSData *)nick 
-		   channel:(NSData *)channelName 
-		withReason:(NSData *)reason {
-	IRCClientChannel* channel = _channels[channelName];
-	
-	NSData* nickOnly = [IRCClientSession nickFromNickUserHost:nick];
-	
-	if ([_nickname isEqualToData:nickOnly]) {
-		// We just left a channel; remove it from the channels dict.
+// Starts receiving an accepted file: by connecting to the sender, or (if the
+// offer was passive) by listening, and telling the sender where.
+-(void) startReceiving:(IRCClientDCCTransfer *)transfer {
+	if (transfer.passive == NO) {
+		[transfer connectToAddress:transfer.remoteAddress
+							  port:transfer.remotePort];
+		return;
+	}
 
-		[_channels removeObjectForKey:channelName];
-		[channel userParted:nick 
-				 withReason:reason 
-						 us:YES];
-	} else {
-		[channel userParted:nick 
-				 withReason:reason 
-						 us:NO];
+	int family = AF_INET;
+	NSData *address = [self DCCAddressArgumentWithFamily:&family];
+	if (address == nil) {
+		[transfer failWithErrno:EADDRNOTAVAIL];
+		return;
 	}
+	if ([transfer listenWithFamily:family] == NO) {
+		[transfer failWithErrno:(int) transfer.error.code];
+		return;
+	}
+
+	// SEND <filename> <address> <port> <size> <token>
+	char port[8];
+	snprintf(port, sizeof(port), "%lu", (unsigned long) transfer.localPort);
+	char size[24];
+	snprintf(size, sizeof(size), "%llu", (unsigned long long) transfer.size);
+
+	NSMutableArray <NSData *> *arguments = [NSMutableArray arrayWithObjects:
+											[@"SEND" dataAsUTF8],
+											transfer.filename,
+											address,
+											[NSData dataWithBytes:port length:strlen(port)],
+											[NSData dataWithBytes:size length:strlen(size)],
+											nil];
+	if (transfer.token != nil)
+		[arguments addObject:transfer.token];
+	[self sendDCCRequest:arguments
+					  to:transfer.nick];
 }
 
--(void) userKicked:(NSData *)nick 
-	   fromChannel:(NSData *)channelName 
-				by:(NSData *)byNick 
-		withReason:(NSData *)reason {
-	IRCClientChannel* channel = _channels[channelName];
+// Holds on to the transfer until it has finished (or failed), so that the
+// other side’s DCC requests can be matched to it.
+-(void) trackTransfer:(IRCClientDCCTransfer *)transfer {
+	if (transfer.nickIdentifier == nil)
+		transfer.nickIdentifier = [_identifiers identifierForBytes:transfer.nick.bytes
+															length:transfer.nick.length];
+	[_transfers addObject:transfer];
+
+	__weak typeof(self) weakSelf = self;
+	transfer.endHandler = ^(IRCClientDCCTransfer *endedTransfer) {
+		IRCClientSession *session = weakSelf;
+		if (session != nil)
+			[session->_transfers removeObjectIdenticalTo:endedTransfer];
+	};
+}
 
-	if (nick == nil) {
-		// we got kicked from a channel we’re on :(
-		[_channels removeObjectForKey:channelName];
-		[channel userKicked:_nickname 
-				 withReason:reason 
-						 by:byNick 
-						 us:YES];
-	} else {
-		// Someone else got booted from a channel we’re on.
-		[channel userKicked:nick 
-				 withReason:reason 
-						 by:byNick 
-						 us:NO];
+// Finds the offered transfer to or from the given user that a DCC request is
+// about: by token, if it has one, or else by port (ours, if we’re sending;
+// theirs, if we’re receiving).
+-(IRCClientDCCTransfer *) transferWithDirection:(IRCClientDCCTransferDirection)direction
+										   nick:(IRCClientIdentifier *)nick
+										   port:(NSUInteger)port
+										  token:(NSData *)token {
+	for (IRCClientDCCTransfer *transfer in _transfers) {
+		if (   transfer.direction != direction
+			|| transfer.state != IRCClientDCCTransferOffered
+			|| transfer.nickIdentifier != nick)
+			continue;
+
+		if (transfer.token != nil) {
+			if ([transfer.token isEqualToData:token])
+				return transfer;
+		} else if (port == (direction == IRCClientDCCTransferSend
+							? transfer.localPort
+							: transfer.remotePort)) {
+			return transfer;
+		}
 	}
+
+	return nil;
 }
 
 /*****************************************/
@@ -1308,11 +3988,33 @@ typedef NS_OPTIONS(NSUInteger, IRCClientSessionStateFlags) {
 		[self ctcpReply:request
 				 target:nickOnly];
 	} else if ([request isEqualToCString:"VERSION"]) {
-		[self ctcpReply:[NSData dataWithFormat:"VERSION %@", _version, nil]
-				 target:nickOnly];
+		if (nickOnly == nil)
+			return;
+
+		IRCClientLinePart reply[] = {
+			IRCClientLinePartCString("NOTICE "),
+			IRCClientLinePartData(nickOnly),
+			IRCClientLinePartCString(" :\x01" "VERSION "),
+			IRCClientLinePartData(_version),
+			IRCClientLinePartCString("\x01")
+		};
+		[self sendLineParts:reply
+					  count:(sizeof(reply) / sizeof(IRCClientLinePart))];
 	} else if ([request isEqualToCString:"FINGER"]) {
-		[self ctcpReply:[NSData dataWithFormat:"FINGER %s (%s) Idle 0 seconds)", _username, _realname, nil]
-				 target:nickOnly];
+		if (nickOnly == nil)
+			return;
+
+		IRCClientLinePart reply[] = {
+			IRCClientLinePartCString("NOTICE "),
+			IRCClientLinePartData(nickOnly),
+			IRCClientLinePartCString(" :\x01" "FINGER "),
+			IRCClientLinePartData(_username),
+			IRCClientLinePartCString(" ("),
+			IRCClientLinePartData(_realname),
+			IRCClientLinePartCString(") Idle 0 seconds\x01")
+		};
+		[self sendLineParts:reply
+					  count:(sizeof(reply) / sizeof(IRCClientLinePart))];
 	} else if ([request isEqualToCString:"TIME"]) {
 		time_t current_time;
 		char timestamp[40];
@@ -1326,7 +4028,7 @@ typedef NS_OPTIONS(NSUInteger, IRCClientSessionStateFlags) {
 		[self ctcpReply:[NSData dataFromCString:timestamp]
 				 target:nickOnly];
 	} else {
-		if ([_delegate respondsToSelector:@selector(CTCPRequestReceived:ofType:fromUser:session:)]) {
+		if (_delegateCapabilities & IRCClientDelegateCTCPRequest) {
 			NSData *space = [NSData dataFromCString:" "];
 			NSRange rangeOfFirstSpace = [request rangeOfData:space
 													 options:(NSDataSearchOptions) 0
@@ -1355,46 +4057,3 @@ typedef NS_OPTIONS(NSUInteger, IRCClientSessionStateFlags) {
 }
 
 @end
-
-/***********************************************/
-#pragma mark - Callback function implementations
-/***********************************************/
-
-
-/*!
- * The ‘dcc chat’ event is triggered when someone requests a DCC CHAT from
- * you.
- *
- * \param session the session, which generates an event
- * \param nick    the person who requested DCC CHAT with you.
- * \param addr    the person's IP address in decimal-dot notation.
- * \param dccid   an id associated with this request. Use it in calls to
- *                irc_dcc_accept() or irc_dcc_decline().
- */
-//static void onDCCChatRequest(irc_session_t *session,
-//							 const char *nick,
-//							 const char *addr,
-//							 irc_dcc_t dccid) {
-//	// TODO: figure out what to do here???
-//}
-
-/*!
- * The ‘dcc send’ event is triggered when someone wants to send a file
- * to you via DCC SEND request.
- *
- * \param session the session, which generates an event
- * \param nick    the person who requested DCC SEND to you.
- * \param addr    the person's IP address in decimal-dot notation.
- * \param filename the sent filename.
- * \param size    the filename size.
- * \param dccid   an id associated with this request. Use it in calls to
- *                irc_dcc_accept() or irc_dcc_decline().
- */
-//static void onDCCSendRequest(irc_session_t *session,
-//							 const char *nick,
-//							 const char *addr,
-//							 const char *filename,
-//							 size_t size,
-//							 irc_dcc_t dccid) {
-//	// TODO: figure out what to do here???
-//}
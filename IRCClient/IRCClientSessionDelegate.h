@@ -8,9 +8,34 @@
 //  See LICENSE and README.md for more info.
 
 #import <Foundation/Foundation.h>
+#import "IRCClientEventBatch.h"
 
 @class IRCClientSession;
 @class IRCClientChannel;
+@class IRCClientDCCTransfer;
+
+/** @struct IRCClientConnectionTimings
+ *	@brief How long each phase of connecting to the server took (in seconds).
+ */
+typedef struct {
+	/**	Looking up the server’s addresses (0 if the transport doesn’t say).
+	 */
+	NSTimeInterval resolve;
+
+	/**	Establishing the connection, once the addresses were known (0 if the
+		transport doesn’t say).
+	 */
+	NSTimeInterval connect;
+
+	/**	The TLS handshake, once connected (0 without TLS).
+	 */
+	NSTimeInterval handshake;
+
+	/**	Registering, from the connection being established until the
+		server’s welcome (RPL_WELCOME).
+	 */
+	NSTimeInterval registration;
+} IRCClientConnectionTimings;
 
 /** @brief Receives delegate messages from an IRCClientSession.
  *
@@ -27,6 +52,13 @@
 @required
 -(void) connectionSucceeded:(IRCClientSession *)session;
 
+/** The client has registered with the IRC server (just before
+ *	-[connectionSucceeded:]); says how long it took to get there.
+ */
+@optional
+-(void) connectionTimed:(IRCClientConnectionTimings)timings
+				session:(IRCClientSession *)session;
+
 /** The client has disconnected from the IRC server. */
 @required
 -(void) disconnected:(IRCClientSession *)session;
@@ -196,6 +228,23 @@
 					  params:(NSArray <NSData *> *)params
 					 session:(IRCClientSession *)session;
 
+/** An unhandled numeric was received from the IRC server. (If the delegate
+ *  implements this method, it is sent instead of
+ *  -[numericEventReceived:from:params:session:].)
+ *
+ *  @param event The unknown event number.
+ *  @param name The event’s (first) known numeric reply name, as a statically
+ *  allocated C string (e.g. "RPL_WELCOME"), or NULL if it has none.
+ *  @param origin The sender of the event.
+ *  @param params An NSArray of NSData objects that are the raw C strings of the event.
+ */
+@optional
+-(void) numericEventReceived:(NSUInteger)event 
+						name:(const char *)name
+						from:(NSData *)origin 
+					  params:(NSArray <NSData *> *)params
+					 session:(IRCClientSession *)session;
+
 /** An unhandled event was received from the IRC server.
  *
  *  @param event The unknown event name.
@@ -208,4 +257,60 @@
 					  params:(NSArray <NSData *> *)params
 					 session:(IRCClientSession *)session;
 
+/** A batch of messages was received from the IRC server. This is only sent if
+ *	the session’s batchesEvents property is YES; it is then sent instead of
+ *	the per-event methods above (except -[connectionSucceeded:],
+ *	-[disconnected:], and -[joinedNewChannel:session:], which are still sent
+ *	as they happen). Channel delegates are not affected.
+ *
+ *	The session has already acted on the messages (kept track of channels,
+ *	answered PINGs and CTCP requests, and so on) by the time they arrive here.
+ *	If the session has an inbound budget (see -[IRCClientSession
+ *	inboundEventLimit]), pass the batch to -[IRCClientSession
+ *	eventBatchConsumed:] once you are done with it.
+ *
+ *  @param batch The messages, in the order received.
+ */
+@optional
+-(void) eventsReceived:(IRCClientEventBatch *)batch
+			   session:(IRCClientSession *)session;
+
+/** An IRCv3 batch (e.g. a netsplit) has ended. The messages in it have
+ *	already been handled (and sent to the delegate) as they came in, except
+ *	for those in a “chathistory” batch, which are only sent here (unless
+ *	they were asked for with -[IRCClientSession
+ *	chatHistory:limit:completion:]).
+ *
+ *  @param batch The messages in the batch, in the order received.
+ */
+@optional
+-(void) batchReceived:(IRCClientEventBatch *)batch
+			  session:(IRCClientSession *)session;
+
+/** Someone has offered to send us a file (with a DCC SEND request). To take
+ *	it, pass the transfer to -[IRCClientSession acceptTransfer:path:resume:];
+ *	offers that aren’t accepted within the transfer’s offerTimeout are
+ *	dropped. (If the delegate doesn’t implement this method, offers are
+ *	ignored; so are offers past 4 waiting from one user, or 32 in all.)
+ *
+ *  @param transfer The offered transfer.
+ */
+@optional
+-(void) fileTransferOffered:(IRCClientDCCTransfer *)transfer
+					session:(IRCClientSession *)session;
+
+/** Someone has offered to chat with us directly (with a DCC CHAT request).
+ *	DCC CHAT is lines of text over TCP; to take the offer, connect to the
+ *	given address and port (e.g. with an IRCClientSocketTransport).
+ *
+ *  @param address The address (numeric, IPv4 or IPv6) to connect to.
+ *  @param port The port to connect to.
+ *  @param nick The person who offered to chat.
+ */
+@optional
+-(void) DCCChatOffered:(NSData *)address
+				  port:(NSUInteger)port
+			  fromUser:(NSData *)nick
+			   session:(IRCClientSession *)session;
+
 @end
@@ -0,0 +1,81 @@
+//
+//  IRCClientSession_Private.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientSession.h"
+#import "IRCClientServerSupport.h"
+#import "IRCClientIdentifier.h"
+
+/*	NOTE: This header is for the framework’s internal use only. Do not import
+ *	it in files that make use of the IRCClientSession class.
+ */
+
+/*****************************/
+#pragma mark IRCClientLinePart
+/*****************************/
+
+/**	The maximum length of an IRC message, including the terminating CRLF.
+ */
+#define IRCClientMaxLineLength 512
+
+/**	The maximum length of an IRC message’s tags (IRCv3), including the leading
+	@ and the trailing space, which doesn’t count toward the line length.
+ */
+#define IRCClientMaxTagsLength 8191
+
+/** @struct IRCClientLinePart
+ *	@brief A run of bytes that makes up part of an outbound IRC message.
+ */
+typedef struct {
+	const void *bytes;
+	NSUInteger length;
+} IRCClientLinePart;
+
+static inline IRCClientLinePart IRCClientLinePartCString(const char *string) {
+	return (IRCClientLinePart) { string, strlen(string) };
+}
+
+static inline IRCClientLinePart IRCClientLinePartData(NSData *data) {
+	return (IRCClientLinePart) { data.bytes, data.length };
+}
+
+/**********************************************/
+#pragma mark - IRCClientSession class extension
+/**********************************************/
+
+@interface IRCClientSession ()
+
+/**	What the server supports (as advertised in RPL_ISUPPORT). Must only be
+	used on the session’s queue.
+ */
+@property (nonatomic, readonly) const IRCClientServerSupport *serverSupport;
+
+/**	The session’s interned nicknames and channel names. Must only be used on
+	the session’s queue. (The pool is replaced if the server’s case mapping
+	changes.)
+ */
+@property (nonatomic, readonly) IRCClientIdentifierPool *identifiers;
+
+/**	Writes the given parts (followed by a CRLF) directly into a new outbound
+	message, and queues the message to be sent.
+
+	Returns 0 on success, or 1 (and sends nothing) if the message would be
+	longer than the server’s maximum line length (IRCClientMaxLineLength,
+	unless the server advertises a LINELEN), or if there’s no memory for it.
+ */
+-(int) sendLineParts:(const IRCClientLinePart *)parts
+			   count:(NSUInteger)count;
+
+/**	Runs the given block on the session’s queue, and waits for it to finish.
+	The block is run at once if the caller is already on the session’s queue,
+	or on the event loop that the session runs on (where nothing else of the
+	session’s can be running, and where waiting would deadlock).
+ */
+-(void) performOnSessionQueueAndWait:(void (^)(void))block;
+
+@end
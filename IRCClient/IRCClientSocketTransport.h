@@ -0,0 +1,73 @@
+//
+//	IRCClientSocketTransport.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+#import "IRCClientTransport.h"
+
+/**************************************/
+#pragma mark IRCClientResolver typedefs
+/**************************************/
+
+/**	Called (on any thread) with the addresses that a host name resolved to,
+	each a struct sockaddr (with the port filled in), in order of
+	preference; or with an error.
+ */
+typedef void (^IRCClientResolverCompletion)(NSArray <NSData *> *addresses, NSError *error);
+
+/**	Looks up the addresses of the given host (without blocking the calling
+	thread), and calls the completion block with them.
+ */
+typedef void (^IRCClientResolver)(NSString *host, NSUInteger port, IRCClientResolverCompletion completion);
+
+/** @class IRCClientSocketTransport
+ *	@brief A transport over a non-blocking TCP socket.
+ *
+ *	Readability and writability of the socket are watched with dispatch
+ *	sources that target the session’s queue directly, so no run loop is
+ *	needed, and events are handled without any further thread hops. (This is
+ *	IRCClientSession’s default transport.)
+ *
+ *	The host name is looked up off the session’s queue. If it has several
+ *	addresses, they are raced (“Happy Eyeballs”, RFC 8305): alternating
+ *	between IPv6 and IPv4, a connection attempt is started every
+ *	connectionAttemptDelay (or as soon as the last one fails) until one of
+ *	them connects; the rest are then abandoned.
+ */
+
+/********************************************************/
+#pragma mark - IRCClientSocketTransport class declaration
+/********************************************************/
+
+@interface IRCClientSocketTransport : NSObject <IRCClientTransport>
+
+@property (weak) id <IRCClientTransportDelegate> delegate;
+
+@property (readonly) NSError *error;
+
+/**	Looks up the host’s addresses. The default is nil, meaning the
+	systemResolver; set this (before opening) to resolve some other way (e.g.
+	to a fixed set of loopback addresses, for testing).
+ */
+@property (copy) IRCClientResolver resolver;
+
+/**	How long to wait for a connection attempt before starting the next one.
+	The default is 0.25 seconds.
+ */
+@property (assign) NSTimeInterval connectionAttemptDelay;
+
+@property (readonly) NSTimeInterval resolveDuration;
+
+@property (readonly) NSTimeInterval connectDuration;
+
+/**	Resolves with getaddrinfo(), on one of a few queues shared by all
+	transports.
+ */
++(IRCClientResolver) systemResolver;
+
+@end
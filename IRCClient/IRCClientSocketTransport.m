@@ -0,0 +1,519 @@
+//
+//	IRCClientSocketTransport.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientSocketTransport.h"
+
+#import <sys/socket.h>
+#import <netdb.h>
+#import <fcntl.h>
+#import <unistd.h>
+#import <stdatomic.h>
+
+/******************************/
+#pragma mark - Static variables
+/******************************/
+
+// How long to wait for one address before also trying the next (RFC 8305,
+// section 5, recommends 250 ms).
+static const NSTimeInterval IRCClientConnectionAttemptDefaultDelay = 0.25;
+
+/******************************/
+#pragma mark - Helper functions
+/******************************/
+
+static uint64_t IRCClientSocketCurrentTime(void) {
+	return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+static NSTimeInterval IRCClientSocketElapsedTime(uint64_t since) {
+	return (IRCClientSocketCurrentTime() - since) / (NSTimeInterval) NSEC_PER_SEC;
+}
+
+// Name lookups block, so they’re done on a few serial queues shared by all
+// transports (rather than on a thread apiece, when many sessions connect at
+// once).
+static dispatch_queue_t IRCClientResolverQueue(void) {
+	enum { QueueCount = 4 };
+	static dispatch_queue_t queues[QueueCount];
+	static _Atomic(NSUInteger) next;
+	static dispatch_once_t once;
+	dispatch_once(&once, ^{
+		for (NSUInteger i = 0; i < QueueCount; i++)
+			queues[i] = dispatch_queue_create_with_target("IRCClientResolver",
+														  DISPATCH_QUEUE_SERIAL,
+														  dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0));
+	});
+
+	return queues[atomic_fetch_add_explicit(&next, 1, memory_order_relaxed) % QueueCount];
+}
+
+static NSError *IRCClientAddressInfoError(int status) {
+	return [NSError errorWithDomain:(NSString *) kCFErrorDomainCFNetwork
+							   code:kCFHostErrorUnknown
+						   userInfo:@{ (NSString *) kCFGetAddrInfoFailureKey : @(status),
+									   NSLocalizedDescriptionKey : @(gai_strerror(status)) }];
+}
+
+// Orders addresses so that the families alternate, starting with the
+// resolver’s first choice (RFC 8305, section 4).
+static NSArray <NSData *> *IRCClientInterleavedAddresses(NSArray <NSData *> *addresses) {
+	sa_family_t firstFamily = ((const struct sockaddr *) addresses.firstObject.bytes)->sa_family;
+
+	NSMutableArray <NSData *> *preferred = [NSMutableArray arrayWithCapacity:addresses.count];
+	NSMutableArray <NSData *> *others = [NSMutableArray arrayWithCapacity:addresses.count];
+	for (NSData *address in addresses) {
+		if (((const struct sockaddr *) address.bytes)->sa_family == firstFamily)
+			[preferred addObject:address];
+		else
+			[others addObject:address];
+	}
+
+	NSMutableArray <NSData *> *interleaved = [NSMutableArray arrayWithCapacity:addresses.count];
+	for (NSUInteger i = 0; i < MAX(preferred.count, others.count); i++) {
+		if (i < preferred.count)
+			[interleaved addObject:preferred[i]];
+		if (i < others.count)
+			[interleaved addObject:others[i]];
+	}
+
+	return interleaved;
+}
+
+/***********************************************************/
+#pragma mark - IRCClientSocketTransport class implementation
+/***********************************************************/
+
+@implementation IRCClientSocketTransport {
+	dispatch_queue_t _queue;
+
+	int _socket;
+	BOOL _connected;
+
+	// Dispatch sources must be resumed before they’re cancelled (and released),
+	// so we keep track of which ones are suspended.
+	dispatch_source_t _readSource;
+	BOOL _readSourceSuspended;
+	dispatch_source_t _writeSource;
+	BOOL _writeSourceSuspended;
+
+	// Reading has been suspended by the delegate (see -[suspendReading]).
+	BOOL _readingSuspended;
+
+	// Incremented on every open and close, so that a name lookup (or a
+	// connection attempt timer) that finishes after the transport has been
+	// closed (or reopened) is ignored.
+	NSUInteger _generation;
+
+	// While connecting: the addresses to try, in order, and the next one to
+	// try; the attempts under way (a write source apiece, which closes its
+	// socket when cancelled); and the errno of the last attempt that failed.
+	NSArray <NSData *> *_addresses;
+	NSUInteger _nextAddress;
+	NSMutableArray <dispatch_source_t> *_attempts;
+	int _lastAttemptErrno;
+
+	// When the open, and connecting (after the lookup), began.
+	uint64_t _openTime;
+	uint64_t _connectTime;
+}
+
+/********************************************/
+#pragma mark - Initializers & factory methods
+/********************************************/
+
+-(instancetype) init {
+	if (!(self = [super init]))
+		return nil;
+
+	_socket = -1;
+	_attempts = [NSMutableArray array];
+	_connectionAttemptDelay = IRCClientConnectionAttemptDefaultDelay;
+
+	return self;
+}
+
+-(void) dealloc {
+	[self close];
+}
+
+/****************************/
+#pragma mark - Helper methods
+/****************************/
+
+-(void) failWithErrno:(int)errorNumber {
+	[self failWithError:[NSError errorWithDomain:NSPOSIXErrorDomain
+											code:errorNumber
+										userInfo:nil]];
+}
+
+-(void) failWithError:(NSError *)error {
+	_error = error;
+	[self close];
+	[_delegate transport:self
+		didFailWithError:_error];
+}
+
+-(void) addressesResolved:(NSArray <NSData *> *)addresses
+					error:(NSError *)error {
+	_resolveDuration = IRCClientSocketElapsedTime(_openTime);
+
+	if (error != nil) {
+		[self failWithError:error];
+		return;
+	}
+	if (addresses.count == 0) {
+		[self failWithErrno:EHOSTUNREACH];
+		return;
+	}
+
+	_connectTime = IRCClientSocketCurrentTime();
+	_addresses = IRCClientInterleavedAddresses(addresses);
+	_nextAddress = 0;
+	_lastAttemptErrno = EHOSTUNREACH;
+	[self startNextAttempt];
+}
+
+// Starts connecting to the next address (skipping any that fail right away).
+// If it hasn’t connected by the time the attempt delay is up, the one after
+// it is tried too, without giving up on it; the first to connect wins.
+-(void) startNextAttempt {
+	while (_nextAddress < _addresses.count) {
+		NSData *address = _addresses[_nextAddress++];
+		const struct sockaddr *socketAddress = address.bytes;
+
+		int fd = socket(socketAddress->sa_family, SOCK_STREAM, IPPROTO_TCP);
+		if (fd < 0) {
+			_lastAttemptErrno = errno;
+			continue;
+		}
+
+		int on = 1;
+		setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+		if (   connect(fd, socketAddress, (socklen_t) address.length) == 0
+			|| errno == EINPROGRESS) {
+			[self watchAttempt:fd];
+
+			if (_nextAddress < _addresses.count) {
+				NSUInteger generation = _generation;
+				NSUInteger started = _nextAddress;
+				__weak typeof(self) weakSelf = self;
+				dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t) (_connectionAttemptDelay * NSEC_PER_SEC)), _queue, ^{
+					typeof(self) strongSelf = weakSelf;
+					// (Unless we’ve connected, or moved on already.)
+					if (   strongSelf != nil
+						&& strongSelf->_generation == generation
+						&& strongSelf->_addresses != nil
+						&& strongSelf->_nextAddress == started)
+						[strongSelf startNextAttempt];
+				});
+			}
+			return;
+		}
+
+		_lastAttemptErrno = errno;
+		close(fd);
+	}
+
+	// Out of addresses; if no attempts are still under way, we’ve failed.
+	if (_attempts.count == 0)
+		[self failWithErrno:_lastAttemptErrno];
+}
+
+-(void) watchAttempt:(int)fd {
+	// The socket becomes writable when the connection is established (or has
+	// failed).
+	dispatch_source_t attempt = dispatch_source_create(DISPATCH_SOURCE_TYPE_WRITE, (uintptr_t) fd, 0, _queue);
+	// (The handler holds on to the source until it’s cancelled, or taken
+	// over by -[watchSocket:writeSource:].)
+	__weak typeof(self) weakSelf = self;
+	dispatch_source_set_event_handler(attempt, ^{
+		[weakSelf attemptIsWritable:attempt];
+	});
+	dispatch_source_set_cancel_handler(attempt, ^{
+		close(fd);
+	});
+	dispatch_resume(attempt);
+
+	[_attempts addObject:attempt];
+}
+
+-(void) attemptIsWritable:(dispatch_source_t)attempt {
+	if ([_attempts containsObject:attempt] == NO)
+		return;
+	[_attempts removeObject:attempt];
+
+	int fd = (int) dispatch_source_get_handle(attempt);
+	int socketError = 0;
+	socklen_t length = sizeof(socketError);
+	getsockopt(fd, SOL_SOCKET, SO_ERROR, &socketError, &length);
+	if (socketError != 0) {
+		dispatch_source_cancel(attempt);
+		_lastAttemptErrno = socketError;
+
+		// No sense waiting out the attempt delay now.
+		[self startNextAttempt];
+		return;
+	}
+
+	// This one won; call off the rest.
+	[self cancelAttempts];
+	_addresses = nil;
+	_connectDuration = IRCClientSocketElapsedTime(_connectTime);
+
+	[self watchSocket:fd
+		  writeSource:attempt];
+	[self socketIsWritable];
+}
+
+-(void) cancelAttempts {
+	for (dispatch_source_t attempt in _attempts)
+		dispatch_source_cancel(attempt);
+	[_attempts removeAllObjects];
+}
+
+// Takes over a connected socket (and the write source that was watching it
+// connect).
+-(void) watchSocket:(int)fd
+		writeSource:(dispatch_source_t)writeSource {
+	_socket = fd;
+
+	// Close the socket once both sources have been cancelled.
+	__block NSUInteger sourcesRemaining = 2;
+	dispatch_block_t cancelHandler = ^{
+		if (--sourcesRemaining == 0)
+			close(fd);
+	};
+
+	__weak typeof(self) weakSelf = self;
+
+	_readSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t) fd, 0, _queue);
+	dispatch_source_set_event_handler(_readSource, ^{
+		typeof(self) strongSelf = weakSelf;
+		[strongSelf.delegate transportHasBytesAvailable:strongSelf];
+	});
+	dispatch_source_set_cancel_handler(_readSource, cancelHandler);
+	_readSourceSuspended = YES;
+
+	_writeSource = writeSource;
+	dispatch_source_set_event_handler(_writeSource, ^{
+		[weakSelf socketIsWritable];
+	});
+	dispatch_source_set_cancel_handler(_writeSource, cancelHandler);
+	_writeSourceSuspended = NO;
+}
+
+-(void) socketIsWritable {
+	// The write source is level-triggered, so we only leave it running while
+	// we’re waiting for space.
+	dispatch_suspend(_writeSource);
+	_writeSourceSuspended = YES;
+
+	if (_connected == NO) {
+		int socketError = 0;
+		socklen_t length = sizeof(socketError);
+		getsockopt(_socket, SOL_SOCKET, SO_ERROR, &socketError, &length);
+		if (socketError != 0) {
+			[self failWithErrno:socketError];
+			return;
+		}
+
+		_connected = YES;
+		if (_readingSuspended == NO) {
+			dispatch_resume(_readSource);
+			_readSourceSuspended = NO;
+		}
+
+		[_delegate transportDidOpen:self];
+
+		// The delegate may have closed us.
+		if (_connected == NO)
+			return;
+	}
+
+	[_delegate transportHasSpaceAvailable:self];
+}
+
+-(void) waitForSpace {
+	if (_writeSourceSuspended) {
+		dispatch_resume(_writeSource);
+		_writeSourceSuspended = NO;
+	}
+}
+
+/***************************/
+#pragma mark - Class methods
+/***************************/
+
++(IRCClientResolver) systemResolver {
+	return ^(NSString *host,
+			 NSUInteger port,
+			 IRCClientResolverCompletion completion) {
+		NSData *hostName = [host dataUsingEncoding:NSUTF8StringEncoding];
+		dispatch_async(IRCClientResolverQueue(), ^{
+			char hostNameString[NI_MAXHOST];
+			snprintf(hostNameString, sizeof(hostNameString), "%.*s", (int) hostName.length, hostName.bytes);
+			char service[8];
+			snprintf(service, sizeof(service), "%lu", (unsigned long) port);
+
+			struct addrinfo hints = { 0 };
+			hints.ai_family = AF_UNSPEC;
+			hints.ai_socktype = SOCK_STREAM;
+			hints.ai_protocol = IPPROTO_TCP;
+
+			struct addrinfo *addressInfo = NULL;
+			int status = getaddrinfo(hostNameString, service, &hints, &addressInfo);
+			if (status != 0) {
+				completion(nil, IRCClientAddressInfoError(status));
+				return;
+			}
+
+			NSMutableArray <NSData *> *addresses = [NSMutableArray array];
+			for (struct addrinfo *address = addressInfo; address != NULL; address = address->ai_next)
+				[addresses addObject:[NSData dataWithBytes:address->ai_addr
+													length:address->ai_addrlen]];
+			freeaddrinfo(addressInfo);
+
+			completion(addresses, nil);
+		});
+	};
+}
+
+/********************************/
+#pragma mark - IRCClientTransport
+/********************************/
+
+-(void) openToHost:(NSString *)host
+			  port:(NSUInteger)port
+			 queue:(dispatch_queue_t)queue {
+	[self close];
+
+	_queue = queue;
+	_error = nil;
+	NSUInteger generation = ++_generation;
+
+	_openTime = IRCClientSocketCurrentTime();
+	_resolveDuration = 0;
+	_connectDuration = 0;
+
+	IRCClientResolver resolver = _resolver ?: [IRCClientSocketTransport systemResolver];
+	__weak typeof(self) weakSelf = self;
+	resolver(host, port, ^(NSArray <NSData *> *addresses, NSError *error) {
+		dispatch_async(queue, ^{
+			typeof(self) strongSelf = weakSelf;
+			// (Unless we were closed, or reopened, in the meantime.)
+			if (   strongSelf != nil
+				&& strongSelf->_generation == generation)
+				[strongSelf addressesResolved:addresses
+										error:error];
+		});
+	});
+}
+
+-(void) close {
+	_generation++;
+	_connected = NO;
+	_readingSuspended = NO;
+
+	[self cancelAttempts];
+	_addresses = nil;
+
+	if (_readSource != nil) {
+		if (_readSourceSuspended)
+			dispatch_resume(_readSource);
+		dispatch_source_cancel(_readSource);
+		_readSource = nil;
+	}
+	if (_writeSource != nil) {
+		if (_writeSourceSuspended)
+			dispatch_resume(_writeSource);
+		dispatch_source_cancel(_writeSource);
+		_writeSource = nil;
+	}
+
+	// (The sources’ cancel handlers close the socket.)
+	_socket = -1;
+}
+
+-(void) suspendReading {
+	_readingSuspended = YES;
+
+	if (   _connected
+		&& _readSourceSuspended == NO) {
+		dispatch_suspend(_readSource);
+		_readSourceSuspended = YES;
+	}
+}
+
+-(void) resumeReading {
+	_readingSuspended = NO;
+
+	if (   _connected
+		&& _readSourceSuspended) {
+		dispatch_resume(_readSource);
+		_readSourceSuspended = NO;
+	}
+}
+
+-(NSInteger) read:(uint8_t *)buffer
+		maxLength:(NSUInteger)length {
+	if (_connected == NO)
+		return IRCClientTransportWouldBlock;
+
+	ssize_t bytesRead = read(_socket, buffer, length);
+	if (bytesRead < 0) {
+		if (errno == EAGAIN || errno == EINTR)
+			return IRCClientTransportWouldBlock;
+
+		_error = [NSError errorWithDomain:NSPOSIXErrorDomain
+									 code:errno
+								 userInfo:nil];
+		return -1;
+	}
+
+	return bytesRead;
+}
+
+-(NSInteger) write:(const uint8_t *)buffer
+		 maxLength:(NSUInteger)length {
+	struct iovec vector = { (void *) buffer, length };
+
+	return [self writeVectors:&vector
+						count:1];
+}
+
+-(NSInteger) writeVectors:(const struct iovec *)vectors
+					count:(int)count {
+	if (_connected == NO)
+		return 0;
+
+	size_t bytesOffered = 0;
+	for (int i = 0; i < count; i++)
+		bytesOffered += vectors[i].iov_len;
+
+	ssize_t bytesWritten = writev(_socket, vectors, count);
+	if (bytesWritten < 0) {
+		if (errno == EAGAIN || errno == EINTR) {
+			bytesWritten = 0;
+		} else {
+			_error = [NSError errorWithDomain:NSPOSIXErrorDomain
+										 code:errno
+									 userInfo:nil];
+			return -1;
+		}
+	}
+
+	if ((size_t) bytesWritten < bytesOffered)
+		[self waitForSpace];
+
+	return bytesWritten;
+}
+
+@end
@@ -0,0 +1,36 @@
+//
+//	IRCClientStreamTransport.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+#import "IRCClientTransport.h"
+
+/** @class IRCClientStreamTransport
+ *	@brief A transport over a pair of NSStreams.
+ *
+ *	IRCClientSession uses this transport (instead of IRCClientSocketTransport)
+ *	when a SOCKS proxy is configured in the system settings, as NSStream
+ *	supports connecting through the proxy.
+ */
+
+/******************************************************/
+#pragma mark IRCClientStreamTransport class declaration
+/******************************************************/
+
+@interface IRCClientStreamTransport : NSObject <IRCClientTransport, NSStreamDelegate>
+
+@property (weak) id <IRCClientTransportDelegate> delegate;
+
+@property (readonly) NSError *error;
+
+/** SOCKS proxy settings (in the format returned by
+	CFNetworkCopySystemProxySettings()) to connect through; nil for none.
+ */
+@property (copy) NSDictionary *proxySettings;
+
+@end
@@ -0,0 +1,168 @@
+//
+//	IRCClientStreamTransport.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientStreamTransport.h"
+
+#import "NSArray+SA_NSArrayExtensions.h"
+#import "NSStream+QNetworkAdditions.h"
+
+/***********************************************************/
+#pragma mark - IRCClientStreamTransport class implementation
+/***********************************************************/
+
+@implementation IRCClientStreamTransport {
+	NSInputStream *_iStream;
+	NSOutputStream *_oStream;
+
+	BOOL _opened;
+}
+
+/****************************/
+#pragma mark - Helper methods
+/****************************/
+
+-(void) openStream:(NSStream *)stream
+			 queue:(dispatch_queue_t)queue {
+	// Have the stream deliver its events directly on the given queue (rather
+	// than on the run loop of whatever thread opened the transport).
+	if ([stream isKindOfClass:[NSInputStream class]])
+		CFReadStreamSetDispatchQueue((__bridge CFReadStreamRef) stream, queue);
+	else
+		CFWriteStreamSetDispatchQueue((__bridge CFWriteStreamRef) stream, queue);
+
+	[stream open];
+}
+
+-(void) closeStream:(NSStream *)stream {
+	stream.delegate = nil;
+	[stream close];
+
+	if ([stream isKindOfClass:[NSInputStream class]])
+		CFReadStreamSetDispatchQueue((__bridge CFReadStreamRef) stream, NULL);
+	else
+		CFWriteStreamSetDispatchQueue((__bridge CFWriteStreamRef) stream, NULL);
+}
+
+/********************************/
+#pragma mark - IRCClientTransport
+/********************************/
+
+-(void) openToHost:(NSString *)host
+			  port:(NSUInteger)port
+			 queue:(dispatch_queue_t)queue {
+	[self close];
+
+	_error = nil;
+
+	NSInputStream *iStream;
+	NSOutputStream *oStream;
+	[NSStream getStreamsToHostNamed:host
+							   port:port
+						inputStream:&iStream
+					   outputStream:&oStream];
+	_iStream = iStream;
+	_oStream = oStream;
+
+	// Configure and open streams. (For TLS, see IRCClientTLSTransport.)
+	[@[ iStream, oStream ] forEach:^(NSStream *stream) {
+		[stream setDelegate:self];
+		if (_proxySettings)
+			[stream setProperty:_proxySettings
+						 forKey:NSStreamSOCKSProxyConfigurationKey];
+		[self openStream:stream
+				   queue:queue];
+	}];
+}
+
+-(void) close {
+	if (_iStream != nil)
+		[self closeStream:_iStream];
+	if (_oStream != nil)
+		[self closeStream:_oStream];
+
+	_iStream = nil;
+	_oStream = nil;
+	_opened = NO;
+}
+
+-(NSInteger) read:(uint8_t *)buffer
+		maxLength:(NSUInteger)length {
+	if ([_iStream hasBytesAvailable] == NO)
+		return IRCClientTransportWouldBlock;
+
+	NSInteger bytesRead = [_iStream read:buffer
+							   maxLength:length];
+	if (bytesRead < 0)
+		_error = _iStream.streamError;
+
+	return bytesRead;
+}
+
+-(NSInteger) write:(const uint8_t *)buffer
+		 maxLength:(NSUInteger)length {
+	// (If there’s no space, the stream will send NSStreamEventHasSpaceAvailable
+	// when there is.)
+	if ([_oStream hasSpaceAvailable] == NO)
+		return 0;
+
+	NSInteger bytesWritten = [_oStream write:buffer
+								   maxLength:length];
+	if (bytesWritten < 0)
+		_error = _oStream.streamError;
+
+	return bytesWritten;
+}
+
+/******************************/
+#pragma mark - NSStreamDelegate
+/******************************/
+
+-(void) stream:(NSStream *)stream
+   handleEvent:(NSStreamEvent)eventCode {
+	switch (eventCode) {
+		case NSStreamEventNone: {
+			break;
+		}
+		case NSStreamEventOpenCompleted: {
+			if (_opened == NO) {
+				_opened = YES;
+				[_delegate transportDidOpen:self];
+			}
+
+			break;
+		}
+		case NSStreamEventHasBytesAvailable: {
+			[_delegate transportHasBytesAvailable:self];
+
+			break;
+		}
+		case NSStreamEventHasSpaceAvailable: {
+			[_delegate transportHasSpaceAvailable:self];
+
+			break;
+		}
+		case NSStreamEventErrorOccurred: {
+			_error = stream.streamError;
+			[self close];
+			[_delegate transport:self
+				didFailWithError:_error];
+
+			break;
+		}
+		case NSStreamEventEndEncountered: {
+			[self close];
+			[_delegate transport:self
+				didFailWithError:nil];
+
+			break;
+		}
+	}
+}
+
+@end
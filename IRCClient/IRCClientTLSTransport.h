@@ -0,0 +1,86 @@
+//
+//	IRCClientTLSTransport.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+#import <Security/Security.h>
+#import "IRCClientTransport.h"
+
+/** @class IRCClientTLSTransport
+ *	@brief A transport that speaks TLS over another transport.
+ *
+ *	Records are decrypted straight into the buffer passed to
+ *	-[read:maxLength:] (i.e., the session’s receive buffer), and encrypted
+ *	straight from the buffers passed to -[write:maxLength:] (the session’s
+ *	output queue); the underlying transport carries only ciphertext.
+ *
+ *	The TLS session is cached under the host name and port, so reconnecting
+ *	to the same server resumes it (with a session ticket, if the server
+ *	supports them) instead of doing a full handshake.
+ *
+ *	IRCClientSession uses this transport (over its default one) if its
+ *	usesTLS property is set; to configure it (certificates, pinning), create
+ *	one and set it as the session’s transport instead.
+ */
+
+/***************************************************/
+#pragma mark IRCClientTLSTransport class declaration
+/***************************************************/
+
+@interface IRCClientTLSTransport : NSObject <IRCClientTransport, IRCClientTransportDelegate>
+
+@property (weak) id <IRCClientTransportDelegate> delegate;
+
+@property (readonly) NSError *error;
+
+/**	The transport that the ciphertext goes over.
+ */
+@property (readonly) id <IRCClientTransport> transport;
+
+/**	Certificates (SecCertificateRef) to trust as certificate authorities
+	instead of the system’s; nil (the default) to trust the system’s.
+ */
+@property (copy) NSArray *anchorCertificates;
+
+/**	The client certificate to present (e.g. for CertFP, or SASL EXTERNAL): an
+	array whose first element is a SecIdentityRef, followed by any
+	intermediate certificates (SecCertificateRef), as for SSLSetCertificate().
+	The default is nil (none).
+ */
+@property (copy) NSArray *clientCertificates;
+
+/**	If not empty, the server’s certificate is only accepted if its public key
+	is one of these (see +[publicKeyDigestForCertificate:]), in addition to
+	being trusted. The default is nil.
+ */
+@property (copy) NSSet <NSData *> *pinnedPublicKeys;
+
+/**	The name that the server’s certificate must be for; nil (the default)
+	for the host name that the transport is opened to.
+ */
+@property (copy) NSString *peerName;
+
+/**	How long the TLS handshake took, for the most recent open (0 until it’s
+	done).
+ */
+@property (readonly) NSTimeInterval handshakeDuration;
+
+@property (readonly) NSTimeInterval resolveDuration;
+
+@property (readonly) NSTimeInterval connectDuration;
+
+/**	Returns a TLS transport over the given transport.
+ */
+-(instancetype) initWithTransport:(id <IRCClientTransport>)transport;
+
+/**	Returns the SHA-256 digest of the certificate’s public key (in the form
+	returned by SecKeyCopyExternalRepresentation()), for pinnedPublicKeys.
+ */
++(NSData *) publicKeyDigestForCertificate:(SecCertificateRef)certificate;
+
+@end
@@ -0,0 +1,445 @@
+//
+//	IRCClientTLSTransport.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientTLSTransport.h"
+
+#import "IRCClientSocketTransport.h"
+
+#import <CommonCrypto/CommonDigest.h>
+
+// Secure Transport is deprecated in favor of Network.framework; but that owns
+// the socket, and the buffers, whereas Secure Transport can run over our own
+// transport, reading and writing through the session’s buffers.
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+
+/******************************/
+#pragma mark - Helper functions
+/******************************/
+
+static uint64_t IRCClientTLSCurrentTime(void) {
+	return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+// Secure Transport’s I/O callbacks (see below).
+static OSStatus IRCClientTLSRead(SSLConnectionRef connection,
+								 void *data,
+								 size_t *length);
+static OSStatus IRCClientTLSWrite(SSLConnectionRef connection,
+								  const void *data,
+								  size_t *length);
+
+/********************************************************/
+#pragma mark - IRCClientTLSTransport class implementation
+/********************************************************/
+
+@implementation IRCClientTLSTransport {
+	SSLContextRef _context;
+
+	NSString *_host;
+	NSUInteger _port;
+
+	// The handshake is under way; or done (and the connection usable).
+	BOOL _handshaking;
+	BOOL _opened;
+
+	uint64_t _handshakeTime;
+}
+
+/********************************************/
+#pragma mark - Initializers & factory methods
+/********************************************/
+
+-(instancetype) init {
+	return [self initWithTransport:[IRCClientSocketTransport new]];
+}
+
+-(instancetype) initWithTransport:(id <IRCClientTransport>)transport {
+	if (!(self = [super init]))
+		return nil;
+
+	_transport = transport;
+	_transport.delegate = self;
+
+	return self;
+}
+
+-(void) dealloc {
+	[self closeContext:NO];
+}
+
+/***************************/
+#pragma mark - Class methods
+/***************************/
+
++(NSData *) publicKeyDigestForCertificate:(SecCertificateRef)certificate {
+	SecKeyRef key = SecCertificateCopyKey(certificate);
+	if (key == NULL)
+		return nil;
+
+	NSData *representation = CFBridgingRelease(SecKeyCopyExternalRepresentation(key, NULL));
+	CFRelease(key);
+	if (representation == nil)
+		return nil;
+
+	uint8_t digest[CC_SHA256_DIGEST_LENGTH];
+	CC_SHA256(representation.bytes, (CC_LONG) representation.length, digest);
+
+	return [NSData dataWithBytes:digest
+						  length:sizeof(digest)];
+}
+
+/****************************/
+#pragma mark - Helper methods
+/****************************/
+
+-(void) failWithStatus:(OSStatus)status {
+	[self failWithError:[NSError errorWithDomain:NSOSStatusErrorDomain
+											code:status
+										userInfo:nil]];
+}
+
+-(void) failWithError:(NSError *)error {
+	_error = error;
+	[self closeContext:NO];
+	[_transport close];
+	[_delegate transport:self
+		didFailWithError:_error];
+}
+
+-(void) closeContext:(BOOL)notifyPeer {
+	if (_context != NULL) {
+		// (Sends close_notify, if it can; we don’t wait for the reply.)
+		if (notifyPeer)
+			SSLClose(_context);
+		CFRelease(_context);
+		_context = NULL;
+	}
+
+	_handshaking = NO;
+	_opened = NO;
+}
+
+-(void) startHandshake {
+	_context = SSLCreateContext(kCFAllocatorDefault, kSSLClientSide, kSSLStreamType);
+	if (_context == NULL) {
+		[self failWithStatus:errSecAllocate];
+		return;
+	}
+
+	SSLSetIOFuncs(_context, IRCClientTLSRead, IRCClientTLSWrite);
+	SSLSetConnection(_context, (__bridge SSLConnectionRef) self);
+	SSLSetProtocolVersionMin(_context, kTLSProtocol12);
+
+	NSData *peerName = [(_peerName ?: _host) dataUsingEncoding:NSUTF8StringEncoding];
+	SSLSetPeerDomainName(_context, peerName.bytes, peerName.length);
+
+	// Sessions are cached by peer ID, so this resumes the last session with
+	// the same server (if it’s still cached), skipping the full handshake.
+	NSData *peerID = [[NSString stringWithFormat:@"%@:%lu", _host, (unsigned long) _port] dataUsingEncoding:NSUTF8StringEncoding];
+	SSLSetPeerID(_context, peerID.bytes, peerID.length);
+	SSLSetSessionOption(_context, kSSLSessionOptionEnableSessionTickets, true);
+
+	// We evaluate the server’s certificate ourselves (see -[peerTrustError]).
+	SSLSetSessionOption(_context, kSSLSessionOptionBreakOnServerAuth, true);
+
+	if (_clientCertificates.count > 0) {
+		OSStatus status = SSLSetCertificate(_context, (__bridge CFArrayRef) _clientCertificates);
+		if (status != noErr) {
+			[self failWithStatus:status];
+			return;
+		}
+	}
+
+	_handshaking = YES;
+	_handshakeTime = IRCClientTLSCurrentTime();
+	[self continueHandshake];
+}
+
+// Called whenever the underlying transport can be read or written during
+// the handshake; picks up where it left off.
+-(void) continueHandshake {
+	OSStatus status;
+	for (;;) {
+		status = SSLHandshake(_context);
+		if (status != errSSLPeerAuthCompleted)
+			break;
+
+		NSError *trustError = [self peerTrustError];
+		if (trustError != nil) {
+			[self failWithError:trustError];
+			return;
+		}
+	}
+
+	if (status == errSSLWouldBlock)
+		return;
+	if (status != noErr) {
+		[self failWithStatus:status];
+		return;
+	}
+
+	_handshaking = NO;
+	_opened = YES;
+	_handshakeDuration = (IRCClientTLSCurrentTime() - _handshakeTime) / (NSTimeInterval) NSEC_PER_SEC;
+
+	[_delegate transportDidOpen:self];
+
+	// The delegate may have closed us.
+	if (_opened == NO)
+		return;
+
+	[_delegate transportHasSpaceAvailable:self];
+}
+
+// Returns nil if the server’s certificate is trusted (and, if there are any
+// pins, has a pinned key).
+-(NSError *) peerTrustError {
+	SecTrustRef trust = NULL;
+	OSStatus status = SSLCopyPeerTrust(_context, &trust);
+	if (   status != noErr
+		|| trust == NULL)
+		return [NSError errorWithDomain:NSOSStatusErrorDomain
+								   code:(status != noErr ? status : errSSLBadCert)
+							   userInfo:nil];
+
+	SecPolicyRef policy = SecPolicyCreateSSL(true, (__bridge CFStringRef) (_peerName ?: _host));
+	SecTrustSetPolicies(trust, policy);
+	CFRelease(policy);
+
+	if (_anchorCertificates != nil) {
+		SecTrustSetAnchorCertificates(trust, (__bridge CFArrayRef) _anchorCertificates);
+		SecTrustSetAnchorCertificatesOnly(trust, true);
+	}
+
+	NSError *error = nil;
+	CFErrorRef trustError = NULL;
+	if (SecTrustEvaluateWithError(trust, &trustError) == NO) {
+		error = CFBridgingRelease(trustError);
+	} else if (_pinnedPublicKeys.count > 0) {
+		SecCertificateRef leaf = SecTrustGetCertificateAtIndex(trust, 0);
+		NSData *digest = (leaf != NULL) ? [IRCClientTLSTransport publicKeyDigestForCertificate:leaf] : nil;
+		if (   digest == nil
+			|| [_pinnedPublicKeys containsObject:digest] == NO)
+			error = [NSError errorWithDomain:NSOSStatusErrorDomain
+										code:errSSLBadCert
+									userInfo:@{ NSLocalizedDescriptionKey : @"The server’s public key is not one of the pinned keys." }];
+	}
+
+	CFRelease(trust);
+
+	return error;
+}
+
+/********************************/
+#pragma mark - IRCClientTransport
+/********************************/
+
+-(void) openToHost:(NSString *)host
+			  port:(NSUInteger)port
+			 queue:(dispatch_queue_t)queue {
+	[self close];
+
+	_error = nil;
+	_host = [host copy];
+	_port = port;
+	_handshakeDuration = 0;
+
+	[_transport openToHost:host
+					  port:port
+					 queue:queue];
+}
+
+-(void) close {
+	[self closeContext:_opened];
+	[_transport close];
+}
+
+-(void) suspendReading {
+	if ([_transport respondsToSelector:@selector(suspendReading)])
+		[_transport suspendReading];
+}
+
+-(void) resumeReading {
+	if ([_transport respondsToSelector:@selector(resumeReading)])
+		[_transport resumeReading];
+}
+
+-(NSTimeInterval) resolveDuration {
+	return ([_transport respondsToSelector:@selector(resolveDuration)]
+			? _transport.resolveDuration
+			: 0);
+}
+
+-(NSTimeInterval) connectDuration {
+	return ([_transport respondsToSelector:@selector(connectDuration)]
+			? _transport.connectDuration
+			: 0);
+}
+
+-(NSInteger) read:(uint8_t *)buffer
+		maxLength:(NSUInteger)length {
+	if (_opened == NO)
+		return IRCClientTransportWouldBlock;
+
+	// Decrypts straight into the caller’s buffer.
+	size_t processed = 0;
+	OSStatus status = SSLRead(_context, buffer, length, &processed);
+	if (processed > 0)
+		return (NSInteger) processed;
+
+	switch (status) {
+		case errSSLWouldBlock:
+			return IRCClientTransportWouldBlock;
+		case errSSLClosedGraceful:
+		case errSSLClosedNoNotify:
+			return 0;
+		default:
+			// (The read callback may have recorded the underlying error.)
+			if (   _error == nil
+				|| status != errSSLClosedAbort)
+				_error = [NSError errorWithDomain:NSOSStatusErrorDomain
+											 code:status
+										 userInfo:nil];
+			return -1;
+	}
+}
+
+/*	NOTE: There’s deliberately no -[writeVectors:count:]; each SSLWrite() is
+	at least one record, so letting the session gather a burst of lines into
+	one chunk gets them sent as a few full records, rather than a record (with
+	its header and MAC) per line.
+ */
+-(NSInteger) write:(const uint8_t *)buffer
+		 maxLength:(NSUInteger)length {
+	if (_opened == NO)
+		return 0;
+
+	// Encrypts straight from the caller’s buffer. (If the underlying
+	// transport takes only some of the ciphertext, it tells us when it can
+	// take more; see -[transportHasSpaceAvailable:].)
+	size_t processed = 0;
+	OSStatus status = SSLWrite(_context, buffer, length, &processed);
+	if (   status != noErr
+		&& status != errSSLWouldBlock) {
+		if (   _error == nil
+			|| status != errSSLClosedAbort)
+			_error = [NSError errorWithDomain:NSOSStatusErrorDomain
+										 code:status
+									 userInfo:nil];
+		return -1;
+	}
+
+	return (NSInteger) processed;
+}
+
+/****************************************/
+#pragma mark - IRCClientTransportDelegate
+/****************************************/
+
+-(void) transportDidOpen:(id <IRCClientTransport>)transport {
+	[self startHandshake];
+}
+
+-(void) transportHasBytesAvailable:(id <IRCClientTransport>)transport {
+	if (_handshaking)
+		[self continueHandshake];
+	else if (_opened)
+		[_delegate transportHasBytesAvailable:self];
+}
+
+-(void) transportHasSpaceAvailable:(id <IRCClientTransport>)transport {
+	if (_handshaking) {
+		[self continueHandshake];
+	} else if (_opened) {
+		// First flush any ciphertext that Secure Transport is holding on to
+		// (a zero-length write does just that).
+		size_t processed = 0;
+		OSStatus status = SSLWrite(_context, NULL, 0, &processed);
+		if (status == errSSLWouldBlock)
+			return;
+		if (status != noErr) {
+			[self failWithStatus:status];
+			return;
+		}
+
+		[_delegate transportHasSpaceAvailable:self];
+	}
+}
+
+-(void) transport:(id <IRCClientTransport>)transport
+ didFailWithError:(NSError *)error {
+	_error = error;
+	[self closeContext:NO];
+	[_delegate transport:self
+		didFailWithError:error];
+}
+
+/**********************************/
+#pragma mark - Secure Transport I/O
+/**********************************/
+
+// Secure Transport wants the whole of what it asks for (or all of what it
+// gives us taken), or errSSLWouldBlock with however much there was.
+
+static OSStatus IRCClientTLSRead(SSLConnectionRef connection,
+								 void *data,
+								 size_t *length) {
+	IRCClientTLSTransport *transport = (__bridge IRCClientTLSTransport *) connection;
+
+	size_t requested = *length;
+	size_t total = 0;
+	while (total < requested) {
+		NSInteger bytesRead = [transport->_transport read:((uint8_t *) data + total)
+										   maxLength:(requested - total)];
+		if (bytesRead == IRCClientTransportWouldBlock) {
+			*length = total;
+			return errSSLWouldBlock;
+		} else if (bytesRead == 0) {
+			*length = total;
+			return errSSLClosedNoNotify;
+		} else if (bytesRead < 0) {
+			transport->_error = transport->_transport.error;
+			*length = total;
+			return errSSLClosedAbort;
+		}
+
+		total += (size_t) bytesRead;
+	}
+
+	*length = total;
+	return noErr;
+}
+
+static OSStatus IRCClientTLSWrite(SSLConnectionRef connection,
+								  const void *data,
+								  size_t *length) {
+	IRCClientTLSTransport *transport = (__bridge IRCClientTLSTransport *) connection;
+
+	size_t offered = *length;
+	size_t total = 0;
+	while (total < offered) {
+		NSInteger bytesWritten = [transport->_transport write:((const uint8_t *) data + total)
+											   maxLength:(offered - total)];
+		if (bytesWritten == 0) {
+			*length = total;
+			return errSSLWouldBlock;
+		} else if (bytesWritten < 0) {
+			transport->_error = transport->_transport.error;
+			*length = total;
+			return errSSLClosedAbort;
+		}
+
+		total += (size_t) bytesWritten;
+	}
+
+	*length = total;
+	return noErr;
+}
+
+@end
@@ -0,0 +1,133 @@
+//
+//	IRCClientTransport.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+#import <sys/uio.h>
+
+@protocol IRCClientTransport;
+
+/**	Returned by -[IRCClientTransport read:maxLength:] when no bytes can be read
+	without blocking.
+ */
+#define IRCClientTransportWouldBlock (-2)
+
+/***********************************************/
+#pragma mark IRCClientTransportDelegate protocol
+/***********************************************/
+
+/** @protocol IRCClientTransportDelegate
+ *	@brief Receives a transport’s events (on the queue given to the transport).
+ */
+@protocol IRCClientTransportDelegate <NSObject>
+
+/**	The connection has been established. (The transport then also sends
+	-[transportHasSpaceAvailable:].)
+ */
+-(void) transportDidOpen:(id <IRCClientTransport>)transport;
+
+/**	There are bytes to read; the delegate should call -[read:maxLength:] until
+	it returns IRCClientTransportWouldBlock (or an error, or end of stream).
+ */
+-(void) transportHasBytesAvailable:(id <IRCClientTransport>)transport;
+
+/**	A write that didn’t (entirely) go through can now be retried.
+ */
+-(void) transportHasSpaceAvailable:(id <IRCClientTransport>)transport;
+
+/**	The connection could not be established, or has failed, or has been
+	closed by the other end (in which case the error is nil). (The transport
+	has closed itself.)
+ */
+-(void) transport:(id <IRCClientTransport>)transport
+ didFailWithError:(NSError *)error;
+
+@end
+
+/*****************************************/
+#pragma mark - IRCClientTransport protocol
+/*****************************************/
+
+/** @protocol IRCClientTransport
+ *	@brief A bidirectional byte stream to an IRC server.
+ *
+ *	IRCClientSession does its I/O through a transport, which lets other kinds
+ *	of connection (TLS, an in-process loopback for testing, etc.) be plugged
+ *	in; see -[IRCClientSession transport].
+ *
+ *	All methods are called on, and all delegate methods must be sent on, the
+ *	queue passed to -[openToHost:port:queue:]. A transport may be opened again
+ *	after it has been closed.
+ */
+@protocol IRCClientTransport <NSObject>
+
+@property (weak) id <IRCClientTransportDelegate> delegate;
+
+/**	The error that caused the most recent failed read or write (if any).
+ */
+@property (readonly) NSError *error;
+
+/**	Starts connecting to the given host and port. The result is reported to
+	the delegate.
+ */
+-(void) openToHost:(NSString *)host
+			  port:(NSUInteger)port
+			 queue:(dispatch_queue_t)queue;
+
+/**	Closes the connection (if any); no further delegate methods are sent.
+ */
+-(void) close;
+
+/**	Reads up to length bytes. Returns the number of bytes read, 0 at end of
+	stream, -1 on error, or IRCClientTransportWouldBlock if no bytes can be
+	read right now.
+ */
+-(NSInteger) read:(uint8_t *)buffer
+		maxLength:(NSUInteger)length;
+
+/**	Writes up to length bytes. Returns the number of bytes written (which may
+	be 0), or -1 on error. If not all of the bytes were written, the delegate
+	will be sent -[transportHasSpaceAvailable:] once more can be.
+ */
+-(NSInteger) write:(const uint8_t *)buffer
+		 maxLength:(NSUInteger)length;
+
+@optional
+
+/**	Like -[write:maxLength:], but writes the bytes described by the given
+	iovecs, in order (without requiring them to be copied into one buffer).
+ */
+-(NSInteger) writeVectors:(const struct iovec *)vectors
+					count:(int)count;
+
+/**	Stops sending -[transportHasBytesAvailable:] until -[resumeReading] is
+	called (so that a transport whose readability is level-triggered doesn’t
+	keep waking the delegate while it isn’t reading).
+ */
+-(void) suspendReading;
+
+/**	Resumes sending -[transportHasBytesAvailable:].
+ */
+-(void) resumeReading;
+
+/**	How long it took to look up the host’s addresses, for the most recent
+	open (0 until it’s done).
+ */
+@property (readonly) NSTimeInterval resolveDuration;
+
+/**	How long it took to establish the connection, once the addresses had
+	been looked up, for the most recent open (0 until it’s done).
+ */
+@property (readonly) NSTimeInterval connectDuration;
+
+/**	How long the TLS handshake took, once connected, for the most recent open
+	(0 until it’s done).
+ */
+@property (readonly) NSTimeInterval handshakeDuration;
+
+@end
@@ -0,0 +1,87 @@
+//
+//	IRCClientBenchmark.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+
+/*	NOTE: Each benchmark is a function that prints its results (as a table,
+ *	on stdout), and returns 0, or 1 if it couldn’t be run. Benchmarks are
+ *	listed in main.m.
+ */
+
+/******************************/
+#pragma mark IRCClientBenchmark
+/******************************/
+
+typedef struct {
+	const char *name;
+	const char *description;
+	int (*run)(void);
+} IRCClientBenchmark;
+
+/************************/
+#pragma mark - Benchmarks
+/************************/
+
+/**	Connects 1,000, 5,000, and 10,000 sessions (sharing an event loop) to a
+	test server in another process, and reports the memory and CPU time
+	that each session takes.
+ */
+int IRCClientSessionBenchmark(void);
+
+/**	Fills channels of 1,000, 10,000, and 50,000 members from RPL_NAMREPLY,
+	then puts each through a churn of joins, parts, kicks, quits, and nick
+	changes; reports the time per member and per event.
+ */
+int IRCClientChannelBenchmark(void);
+
+/**	Fills one channel of 50,000 members, 200 channels with the same 5,000
+	members, and 200 channels with 5,000 members each of their own; reports
+	the memory per member, and the time to look up a nick.
+ */
+int IRCClientIdentifierBenchmark(void);
+
+/**	Connects sessions over TLS to a test server (in this process), 100 times
+	with a full handshake, and 100 times resuming a cached session; reports
+	the handshake latency of each.
+ */
+int IRCClientTLSBenchmark(void);
+
+/*********************************/
+#pragma mark - Measuring functions
+/*********************************/
+
+/**	Returns the current time, in nanoseconds (from an arbitrary point).
+ */
+uint64_t IRCClientBenchmarkTime(void);
+
+/**	Returns the seconds elapsed since the given time (see
+	IRCClientBenchmarkTime()).
+ */
+NSTimeInterval IRCClientBenchmarkElapsedTime(uint64_t since);
+
+/**	Returns the process’s memory footprint (as shown by Activity Monitor),
+	in bytes.
+ */
+uint64_t IRCClientBenchmarkMemoryFootprint(void);
+
+/**	Returns the CPU time (user and system) that the process has used, in
+	seconds.
+ */
+NSTimeInterval IRCClientBenchmarkCPUTime(void);
+
+/*************************/
+#pragma mark - Test server
+/*************************/
+
+/**	Runs an IRCClientTestServer in a child process (so that its memory and
+	CPU time aren’t counted as the benchmark’s), and puts its port in *port.
+	The server goes away when the task is terminated, or when this process
+	exits. Returns nil if the server couldn’t be started.
+ */
+NSTask *IRCClientBenchmarkLaunchServer(NSUInteger *port);
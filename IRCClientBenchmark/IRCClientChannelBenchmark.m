@@ -0,0 +1,198 @@
+//
+//	IRCClientChannelBenchmark.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientBenchmark.h"
+#import "IRCClientSession.h"
+#import "IRCClientSession_Private.h"
+#import "IRCClientChannel.h"
+#import "IRCClientChannel_Private.h"
+
+/******************************/
+#pragma mark - Static variables
+/******************************/
+
+static const NSUInteger IRCClientChannelBenchmarkMemberCounts[] = { 1000, 10000, 50000 };
+
+static const NSUInteger IRCClientChannelBenchmarkChurnEvents = 200000;
+
+// RPL_NAMREPLY lines are about this long (as servers send them).
+static const NSUInteger IRCClientChannelBenchmarkNamesLength = 400;
+
+/******************************/
+#pragma mark - Helper functions
+/******************************/
+
+typedef NS_ENUM(NSUInteger, IRCClientChannelBenchmarkEvent) {
+	IRCClientChannelBenchmarkJoin,
+	IRCClientChannelBenchmarkPart,
+	IRCClientChannelBenchmarkKick,
+	IRCClientChannelBenchmarkQuit,
+	IRCClientChannelBenchmarkNick,
+	IRCClientChannelBenchmarkEventCount
+};
+
+static NSData *IRCClientChannelBenchmarkMakeNick(const char *format,
+												 NSUInteger i) {
+	char nick[32];
+	int length = snprintf(nick, sizeof(nick), format, (unsigned long) i);
+
+	return [NSData dataWithBytes:nick
+						  length:(NSUInteger) length];
+}
+
+static int IRCClientChannelBenchmarkRun(NSUInteger memberCount) {
+	IRCClientSession *session = [IRCClientSession session];
+	IRCClientChannel *channel = [[IRCClientChannel alloc] initWithName:[@"#bench" dataUsingEncoding:NSUTF8StringEncoding]
+														 andIRCSession:session];
+
+	// The RPL_NAMREPLY parameters, with a sprinkling of ops and voices.
+	NSMutableArray <NSData *> *names = [NSMutableArray array];
+	NSMutableArray <NSData *> *members = [NSMutableArray arrayWithCapacity:memberCount];
+	NSMutableData *line = [NSMutableData data];
+	for (NSUInteger i = 0; i < memberCount; i++) {
+		NSData *nick = IRCClientChannelBenchmarkMakeNick("user%lu", i);
+		[members addObject:nick];
+
+		if (i % 20 == 0)
+			[line appendBytes:"@"
+						length:1];
+		else if (i % 5 == 0)
+			[line appendBytes:"+"
+						length:1];
+		[line appendData:nick];
+		if (line.length >= IRCClientChannelBenchmarkNamesLength || i == memberCount - 1) {
+			[names addObject:line];
+			line = [NSMutableData data];
+		} else {
+			[line appendBytes:" "
+						length:1];
+		}
+	}
+
+	// The churn: members leaving (in every way there is), each followed by a
+	// newcomer joining, so that the channel stays the same size. Members are
+	// picked at random, and everything is made in advance, so that only the
+	// channel’s work is timed. (The events’ nicks are kept alive by nicks.)
+	typedef struct {
+		IRCClientChannelBenchmarkEvent event;
+		__unsafe_unretained NSData *nick;
+		__unsafe_unretained NSData *otherNick;
+	} Event;
+	Event *events = calloc(IRCClientChannelBenchmarkChurnEvents, sizeof(Event));
+	NSMutableArray <NSData *> *nicks = [NSMutableArray arrayWithCapacity:IRCClientChannelBenchmarkChurnEvents];
+	NSData *reason = [@"Benchmarking" dataUsingEncoding:NSUTF8StringEncoding];
+	NSData *op = [@"op" dataUsingEncoding:NSUTF8StringEncoding];
+	NSUInteger newcomers = 0;
+	for (NSUInteger i = 0; i < IRCClientChannelBenchmarkChurnEvents; i++) {
+		Event *event = &events[i];
+		if (i % 2 == 1) {
+			NSData *nick = IRCClientChannelBenchmarkMakeNick("new%lu", newcomers++);
+			[nicks addObject:nick];
+			[members addObject:nick];
+			*event = (Event) { IRCClientChannelBenchmarkJoin, nick, nil };
+			continue;
+		}
+
+		NSUInteger index = arc4random_uniform((uint32_t) members.count);
+		NSData *nick = members[index];
+		[nicks addObject:nick];
+		[members replaceObjectAtIndex:index
+						   withObject:members.lastObject];
+		[members removeLastObject];
+
+		IRCClientChannelBenchmarkEvent kind = 1 + (i / 2) % (IRCClientChannelBenchmarkEventCount - 1);
+		NSData *otherNick = nil;
+		if (kind == IRCClientChannelBenchmarkNick) {
+			otherNick = IRCClientChannelBenchmarkMakeNick("renamed%lu", i);
+			[nicks addObject:otherNick];
+			[members addObject:otherNick];
+		}
+		*event = (Event) { kind, nick, otherNick };
+	}
+
+	__block NSTimeInterval namesTime;
+	__block NSTimeInterval churnTime;
+	__block NSUInteger finalCount;
+	[session performOnSessionQueueAndWait:^{
+		uint64_t start = IRCClientBenchmarkTime();
+		for (NSData *namesLine in names)
+			[channel namesReceived:namesLine];
+		[channel namesEnded];
+		namesTime = IRCClientBenchmarkElapsedTime(start);
+
+		start = IRCClientBenchmarkTime();
+		for (NSUInteger i = 0; i < IRCClientChannelBenchmarkChurnEvents; i++) {
+			const Event *event = &events[i];
+			switch (event->event) {
+				case IRCClientChannelBenchmarkJoin:
+					[channel userJoined:event->nick];
+					break;
+				case IRCClientChannelBenchmarkPart:
+					[channel userParted:event->nick
+							 withReason:reason
+									 us:NO];
+					break;
+				case IRCClientChannelBenchmarkKick:
+					[channel userKicked:event->nick
+							 withReason:reason
+									 by:op
+									 us:NO];
+					break;
+				case IRCClientChannelBenchmarkQuit:
+					[channel userQuit:event->nick];
+					break;
+				case IRCClientChannelBenchmarkNick:
+					[channel nickChangedFrom:event->nick
+										  to:event->otherNick];
+					break;
+				default:
+					break;
+			}
+		}
+		churnTime = IRCClientBenchmarkElapsedTime(start);
+
+		finalCount = channel.memberCount;
+	}];
+
+	free(events);
+
+	// (A channel that got its members wrong would be fast for nothing.)
+	if (finalCount != members.count) {
+		fprintf(stderr, "The channel has %lu members, not %lu.\n",
+				(unsigned long) finalCount,
+				(unsigned long) members.count);
+		return 1;
+	}
+
+	printf("%8lu %10.2f %12.1f %14.1f\n",
+		   (unsigned long) memberCount,
+		   namesTime * 1e3,
+		   namesTime / memberCount * 1e9,
+		   churnTime / IRCClientChannelBenchmarkChurnEvents * 1e9);
+
+	return 0;
+}
+
+/************************/
+#pragma mark - Benchmarks
+/************************/
+
+int IRCClientChannelBenchmark(void) {
+	printf("(%lu churn events: joins, parts, kicks, quits, and nick changes)\n", (unsigned long) IRCClientChannelBenchmarkChurnEvents);
+	printf("%8s %10s %12s %14s\n", "members", "NAMES ms", "ns/member", "churn ns/evt");
+
+	int status = 0;
+	for (size_t i = 0; i < sizeof(IRCClientChannelBenchmarkMemberCounts) / sizeof(NSUInteger); i++) {
+		@autoreleasepool {
+			status |= IRCClientChannelBenchmarkRun(IRCClientChannelBenchmarkMemberCounts[i]);
+		}
+	}
+
+	return status;
+}
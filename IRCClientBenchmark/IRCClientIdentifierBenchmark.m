@@ -0,0 +1,147 @@
+//
+//	IRCClientIdentifierBenchmark.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientBenchmark.h"
+#import "IRCClientSession.h"
+#import "IRCClientSession_Private.h"
+#import "IRCClientChannel.h"
+#import "IRCClientChannel_Private.h"
+#import "IRCClientIdentifier.h"
+
+/******************************/
+#pragma mark - Static variables
+/******************************/
+
+typedef struct {
+	NSUInteger channelCount;
+	NSUInteger membersPerChannel;
+
+	// Whether every channel has the same members (or each has its own).
+	BOOL shared;
+} IRCClientIdentifierBenchmarkCase;
+
+static const IRCClientIdentifierBenchmarkCase IRCClientIdentifierBenchmarkCases[] = {
+	{ 1, 50000, YES },
+	{ 200, 5000, YES },
+	{ 200, 5000, NO },
+};
+
+static const NSUInteger IRCClientIdentifierBenchmarkLookups = 1000000;
+
+/******************************/
+#pragma mark - Helper functions
+/******************************/
+
+// Returns RPL_NAMREPLY parameters that list the given number of members
+// (each line about as long as servers send them), with nicks like real ones
+// (mixed case, some with a user@host).
+static NSArray <NSData *> *IRCClientIdentifierBenchmarkNames(NSUInteger channel,
+															  NSUInteger memberCount) {
+	NSMutableArray <NSData *> *names = [NSMutableArray array];
+	NSMutableString *line = [NSMutableString string];
+	for (NSUInteger i = 0; i < memberCount; i++) {
+		[line appendFormat:@"Member%lu_%lu", (unsigned long) channel, (unsigned long) i];
+		if (i % 4 == 0)
+			[line appendString:@"!user@host.example.com"];
+		if (line.length >= 400 || i == memberCount - 1) {
+			[names addObject:[line dataUsingEncoding:NSUTF8StringEncoding]];
+			[line setString:@""];
+		} else {
+			[line appendString:@" "];
+		}
+	}
+
+	return names;
+}
+
+static int IRCClientIdentifierBenchmarkRun(IRCClientIdentifierBenchmarkCase benchmarkCase) {
+	IRCClientSession *session = [IRCClientSession session];
+	NSUInteger memberships = benchmarkCase.channelCount * benchmarkCase.membersPerChannel;
+
+	// Everything that the channels are made from is made first, so that only
+	// the channels’ own memory is counted.
+	NSMutableArray <NSArray <NSData *> *> *channelNames = [NSMutableArray arrayWithCapacity:benchmarkCase.channelCount];
+	NSMutableArray <IRCClientChannel *> *channels = [NSMutableArray arrayWithCapacity:benchmarkCase.channelCount];
+	for (NSUInteger i = 0; i < benchmarkCase.channelCount; i++) {
+		[channelNames addObject:((benchmarkCase.shared && i > 0)
+								 ? channelNames.firstObject
+								 : IRCClientIdentifierBenchmarkNames(i, benchmarkCase.membersPerChannel))];
+		[channels addObject:[[IRCClientChannel alloc] initWithName:[[NSString stringWithFormat:@"#channel%lu", (unsigned long) i] dataUsingEncoding:NSUTF8StringEncoding]
+													 andIRCSession:session]];
+	}
+	NSMutableArray <NSData *> *lookups = [NSMutableArray arrayWithCapacity:benchmarkCase.membersPerChannel];
+	for (NSUInteger i = 0; i < benchmarkCase.membersPerChannel; i++)
+		[lookups addObject:[[NSString stringWithFormat:@"MEMBER0_%lu", (unsigned long) i] dataUsingEncoding:NSUTF8StringEncoding]];
+
+	__block uint64_t memoryBefore;
+	__block uint64_t memoryAfter;
+	__block NSTimeInterval lookupTime;
+	__block NSUInteger found = 0;
+	[session performOnSessionQueueAndWait:^{
+		memoryBefore = IRCClientBenchmarkMemoryFootprint();
+		@autoreleasepool {
+			for (NSUInteger i = 0; i < benchmarkCase.channelCount; i++) {
+				IRCClientChannel *channel = channels[i];
+				for (NSData *names in channelNames[i])
+					[channel namesReceived:names];
+				[channel namesEnded];
+			}
+		}
+		memoryAfter = IRCClientBenchmarkMemoryFootprint();
+
+		// Looking a nick up (as for every message from a user) folds its case
+		// and finds its identifier, without allocating.
+		IRCClientIdentifierPool *identifiers = session.identifiers;
+		uint64_t start = IRCClientBenchmarkTime();
+		for (NSUInteger i = 0; i < IRCClientIdentifierBenchmarkLookups; i++) {
+			NSData *nick = lookups[i % lookups.count];
+			if ([identifiers existingIdentifierForBytes:nick.bytes
+												 length:nick.length] != nil)
+				found++;
+		}
+		lookupTime = IRCClientBenchmarkElapsedTime(start);
+	}];
+
+	if (found != IRCClientIdentifierBenchmarkLookups) {
+		fprintf(stderr, "Only %lu of %lu lookups found their nick.\n",
+				(unsigned long) found,
+				(unsigned long) IRCClientIdentifierBenchmarkLookups);
+		return 1;
+	}
+
+	printf("%8lu %8lu %8s %12.1f %12.1f %10.1f\n",
+		   (unsigned long) benchmarkCase.channelCount,
+		   (unsigned long) benchmarkCase.membersPerChannel,
+		   benchmarkCase.shared ? "yes" : "no",
+		   ((double) memoryAfter - (double) memoryBefore) / 1024.0 / 1024.0,
+		   ((double) memoryAfter - (double) memoryBefore) / memberships,
+		   lookupTime / IRCClientIdentifierBenchmarkLookups * 1e9);
+
+	// (The channels go now, before the next case is measured.)
+	[channels removeAllObjects];
+
+	return 0;
+}
+
+/************************/
+#pragma mark - Benchmarks
+/************************/
+
+int IRCClientIdentifierBenchmark(void) {
+	printf("%8s %8s %8s %12s %12s %10s\n", "channels", "members", "shared", "MB", "bytes/member", "lookup ns");
+
+	int status = 0;
+	for (size_t i = 0; i < sizeof(IRCClientIdentifierBenchmarkCases) / sizeof(IRCClientIdentifierBenchmarkCase); i++) {
+		@autoreleasepool {
+			status |= IRCClientIdentifierBenchmarkRun(IRCClientIdentifierBenchmarkCases[i]);
+		}
+	}
+
+	return status;
+}
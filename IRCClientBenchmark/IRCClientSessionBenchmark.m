@@ -0,0 +1,125 @@
+//
+//	IRCClientSessionBenchmark.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientBenchmark.h"
+#import "IRCClientSession.h"
+#import "IRCClientEventLoop.h"
+#import "IRCClientTestServer.h"
+#import "IRCClientTestDelegate.h"
+
+/******************************/
+#pragma mark - Static variables
+/******************************/
+
+static const NSUInteger IRCClientSessionBenchmarkCounts[] = { 1000, 5000, 10000 };
+
+// How many messages each session sends itself (through the server), to
+// measure the CPU time that handling a message takes.
+static const NSUInteger IRCClientSessionBenchmarkMessagesPerSession = 10;
+
+static const NSTimeInterval IRCClientSessionBenchmarkTimeout = 300.0;
+
+/******************************/
+#pragma mark - Helper functions
+/******************************/
+
+static int IRCClientSessionBenchmarkRun(IRCClientEventLoop *eventLoop,
+										NSUInteger port,
+										NSUInteger sessionCount) {
+	IRCClientTestDelegate *delegate = [IRCClientTestDelegate new];
+	NSMutableArray <IRCClientSession *> *sessions = [NSMutableArray arrayWithCapacity:sessionCount];
+
+	// Connecting (and registering).
+	uint64_t memoryBefore = IRCClientBenchmarkMemoryFootprint();
+	NSTimeInterval CPUTimeBefore = IRCClientBenchmarkCPUTime();
+	uint64_t start = IRCClientBenchmarkTime();
+	for (NSUInteger i = 0; i < sessionCount; i++) {
+		IRCClientSession *session = [IRCClientTestServer sessionWithNickname:[NSString stringWithFormat:@"bench%lu", (unsigned long) i]
+																		host:@"127.0.0.1"
+																		port:port
+																   eventLoop:eventLoop];
+		session.delegate = delegate;
+		[sessions addObject:session];
+		[session connect];
+	}
+	BOOL connected = IRCClientTestWaitUntil(IRCClientSessionBenchmarkTimeout, ^BOOL {
+		return (delegate.connectionCount == sessionCount);
+	});
+	NSTimeInterval connectTime = IRCClientBenchmarkElapsedTime(start);
+	NSTimeInterval connectCPUTime = IRCClientBenchmarkCPUTime() - CPUTimeBefore;
+	uint64_t memoryAfter = IRCClientBenchmarkMemoryFootprint();
+
+	// Sending and receiving messages.
+	NSTimeInterval messageCPUTime = 0;
+	NSUInteger messageCount = sessionCount * IRCClientSessionBenchmarkMessagesPerSession;
+	if (connected) {
+		NSData *message = [@"The quick brown fox jumps over the lazy dog." dataUsingEncoding:NSUTF8StringEncoding];
+		CPUTimeBefore = IRCClientBenchmarkCPUTime();
+		for (NSUInteger i = 0; i < IRCClientSessionBenchmarkMessagesPerSession; i++)
+			for (IRCClientSession *session in sessions)
+				[session message:message
+							  to:session.nickname];
+		connected = IRCClientTestWaitUntil(IRCClientSessionBenchmarkTimeout, ^BOOL {
+			return (delegate.privateMessageCount == messageCount);
+		});
+		messageCPUTime = IRCClientBenchmarkCPUTime() - CPUTimeBefore;
+	}
+
+	for (IRCClientSession *session in sessions)
+		[session disconnect];
+	IRCClientTestWaitUntil(IRCClientSessionBenchmarkTimeout, ^BOOL {
+		return (delegate.disconnectionCount == delegate.connectionCount);
+	});
+
+	if (connected == NO) {
+		fprintf(stderr, "Only %lu of %lu sessions connected, and %lu of %lu messages arrived (is the open file limit too low?).\n",
+				(unsigned long) delegate.connectionCount,
+				(unsigned long) sessionCount,
+				(unsigned long) delegate.privateMessageCount,
+				(unsigned long) messageCount);
+		return 1;
+	}
+
+	printf("%8lu %10.2f %12.1f %12.3f %12.1f\n",
+		   (unsigned long) sessionCount,
+		   connectTime,
+		   ((double) memoryAfter - (double) memoryBefore) / sessionCount / 1024.0,
+		   connectCPUTime / sessionCount * 1e3,
+		   messageCPUTime / messageCount * 1e6);
+
+	return 0;
+}
+
+/************************/
+#pragma mark - Benchmarks
+/************************/
+
+int IRCClientSessionBenchmark(void) {
+	NSUInteger port = 0;
+	NSTask *server = IRCClientBenchmarkLaunchServer(&port);
+	if (server == nil) {
+		fprintf(stderr, "Couldn’t start the test server.\n");
+		return 1;
+	}
+
+	IRCClientEventLoop *eventLoop = [IRCClientEventLoop sharedEventLoop];
+	printf("(%lu event loops)\n", (unsigned long) eventLoop.threadCount);
+	printf("%8s %10s %12s %12s %12s\n", "sessions", "connect s", "KB/session", "CPU ms/conn", "CPU µs/msg");
+
+	int status = 0;
+	for (size_t i = 0; i < sizeof(IRCClientSessionBenchmarkCounts) / sizeof(NSUInteger); i++) {
+		@autoreleasepool {
+			status |= IRCClientSessionBenchmarkRun(eventLoop, port, IRCClientSessionBenchmarkCounts[i]);
+		}
+	}
+
+	[server terminate];
+
+	return status;
+}
@@ -0,0 +1,186 @@
+//
+//	IRCClientTLSBenchmark.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientBenchmark.h"
+#import "IRCClientSession.h"
+#import "IRCClientSocketTransport.h"
+#import "IRCClientTLSTransport.h"
+#import "IRCClientTestServer.h"
+#import "IRCClientTestDelegate.h"
+
+/******************************/
+#pragma mark - Static variables
+/******************************/
+
+static const NSUInteger IRCClientTLSBenchmarkHandshakes = 100;
+
+static const NSTimeInterval IRCClientTLSBenchmarkTimeout = 10.0;
+
+/******************************/
+#pragma mark - Helper functions
+/******************************/
+
+// Returns a session that connects to the server over TLS (trusting the test
+// certificate authority).
+static IRCClientSession *IRCClientTLSBenchmarkSession(IRCClientTestServer *server,
+													  IRCClientTestDelegate *delegate) {
+	IRCClientSession *session = [server sessionWithNickname:@"bench"
+												  eventLoop:nil];
+	session.delegate = delegate;
+
+	IRCClientTLSTransport *transport = [[IRCClientTLSTransport alloc] initWithTransport:[IRCClientSocketTransport new]];
+	transport.anchorCertificates = @[ (__bridge id) [IRCClientTestServer testCertificateAuthority] ];
+	session.transport = transport;
+
+	return session;
+}
+
+// Connects the session, waits for it to register, and disconnects it;
+// returns how long the TLS handshake took (or -1, if it didn’t connect).
+static NSTimeInterval IRCClientTLSBenchmarkConnect(IRCClientSession *session,
+												   IRCClientTestDelegate *delegate) {
+	NSUInteger connectionCount = delegate.connectionCount;
+	[session connect];
+	BOOL connected = IRCClientTestWaitUntil(IRCClientTLSBenchmarkTimeout, ^BOOL {
+		return (delegate.connectionCount > connectionCount);
+	});
+	NSTimeInterval handshake = delegate.connectionTimings.handshake;
+
+	[session disconnect];
+	IRCClientTestWaitUntil(IRCClientTLSBenchmarkTimeout, ^BOOL {
+		return (delegate.disconnectionCount == delegate.connectionCount);
+	});
+
+	return connected ? handshake : -1;
+}
+
+static int IRCClientTLSBenchmarkCompareDurations(const void *a,
+												 const void *b) {
+	NSTimeInterval x = *(const NSTimeInterval *) a;
+	NSTimeInterval y = *(const NSTimeInterval *) b;
+
+	return (x > y) - (x < y);
+}
+
+static void IRCClientTLSBenchmarkPrint(const char *kind,
+									   NSTimeInterval *durations,
+									   NSUInteger count) {
+	qsort(durations, count, sizeof(NSTimeInterval), IRCClientTLSBenchmarkCompareDurations);
+	NSTimeInterval total = 0;
+	for (NSUInteger i = 0; i < count; i++)
+		total += durations[i];
+
+	printf("%10s %8lu %10.3f %10.3f %10.3f\n",
+		   kind,
+		   (unsigned long) count,
+		   total / count * 1e3,
+		   durations[count / 2] * 1e3,
+		   durations[count * 9 / 10] * 1e3);
+}
+
+// Full handshakes: each with a server (and so a port) of its own, so that
+// there’s no cached session to resume.
+static int IRCClientTLSBenchmarkRunFull(NSTimeInterval *durations) {
+	IRCClientTestDelegate *delegate = [IRCClientTestDelegate new];
+	for (NSUInteger i = 0; i < IRCClientTLSBenchmarkHandshakes; i++) {
+		@autoreleasepool {
+			IRCClientTestServer *server = [IRCClientTestServer new];
+			server.identity = [IRCClientTestServer testIdentity];
+			if ([server start] == NO) {
+				fprintf(stderr, "Couldn’t start the test server.\n");
+				return 1;
+			}
+
+			durations[i] = IRCClientTLSBenchmarkConnect(IRCClientTLSBenchmarkSession(server, delegate), delegate);
+			NSUInteger resumedHandshakeCount = server.resumedHandshakeCount;
+			[server stop];
+
+			if (durations[i] < 0) {
+				fprintf(stderr, "A session couldn’t connect.\n");
+				return 1;
+			}
+			if (resumedHandshakeCount != 0) {
+				fprintf(stderr, "A session with a new server was resumed.\n");
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+// Resumed handshakes: one session, reconnecting to one server (after a
+// first, full, handshake, which isn’t counted).
+static int IRCClientTLSBenchmarkRunResumed(NSTimeInterval *durations) {
+	IRCClientTestServer *server = [IRCClientTestServer new];
+	server.identity = [IRCClientTestServer testIdentity];
+	if ([server start] == NO) {
+		fprintf(stderr, "Couldn’t start the test server.\n");
+		return 1;
+	}
+
+	IRCClientTestDelegate *delegate = [IRCClientTestDelegate new];
+	IRCClientSession *session = IRCClientTLSBenchmarkSession(server, delegate);
+	int status = 0;
+	if (IRCClientTLSBenchmarkConnect(session, delegate) < 0)
+		status = 1;
+	for (NSUInteger i = 0; i < IRCClientTLSBenchmarkHandshakes && status == 0; i++) {
+		@autoreleasepool {
+			durations[i] = IRCClientTLSBenchmarkConnect(session, delegate);
+			if (durations[i] < 0)
+				status = 1;
+		}
+	}
+	NSUInteger resumedHandshakeCount = server.resumedHandshakeCount;
+	[server stop];
+
+	if (status != 0) {
+		fprintf(stderr, "A session couldn’t connect.\n");
+		return 1;
+	}
+	// (Resumption that silently stopped working would look like a slow
+	// resumed handshake.)
+	if (resumedHandshakeCount != IRCClientTLSBenchmarkHandshakes) {
+		fprintf(stderr, "Only %lu of %lu reconnections resumed the session.\n",
+				(unsigned long) resumedHandshakeCount,
+				(unsigned long) IRCClientTLSBenchmarkHandshakes);
+		return 1;
+	}
+
+	return 0;
+}
+
+/************************/
+#pragma mark - Benchmarks
+/************************/
+
+int IRCClientTLSBenchmark(void) {
+	if (   [IRCClientTestServer testIdentity] == nil
+		|| [IRCClientTestServer testCertificateAuthority] == NULL) {
+		fprintf(stderr, "Couldn’t load the test certificates (see Scripts/generate_test_certificates.sh).\n");
+		return 1;
+	}
+
+	printf("(%lu handshakes each, over loopback)\n", (unsigned long) IRCClientTLSBenchmarkHandshakes);
+	printf("%10s %8s %10s %10s %10s\n", "handshake", "count", "mean ms", "median ms", "p90 ms");
+
+	NSTimeInterval *durations = calloc(IRCClientTLSBenchmarkHandshakes, sizeof(NSTimeInterval));
+	int status = IRCClientTLSBenchmarkRunFull(durations);
+	if (status == 0)
+		IRCClientTLSBenchmarkPrint("full", durations, IRCClientTLSBenchmarkHandshakes);
+
+	if (IRCClientTLSBenchmarkRunResumed(durations) == 0)
+		IRCClientTLSBenchmarkPrint("resumed", durations, IRCClientTLSBenchmarkHandshakes);
+	else
+		status = 1;
+
+	free(durations);
+
+	return status;
+}
@@ -0,0 +1,175 @@
+//
+//	main.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+/*	Usage: IRCClientBenchmark [<benchmark> ...]
+ *
+ *	Runs the named benchmarks (or all of them), and prints their results.
+ *	Build the Release configuration to get meaningful numbers.
+ */
+
+#import <Foundation/Foundation.h>
+#import "IRCClientBenchmark.h"
+#import "IRCClientTestServer.h"
+
+#import <mach/mach.h>
+#import <sys/resource.h>
+#import <limits.h>
+#import <unistd.h>
+
+/******************************/
+#pragma mark - Static variables
+/******************************/
+
+static const IRCClientBenchmark IRCClientBenchmarks[] = {
+	{ "sessions", "Memory and CPU time per session, at 1k/5k/10k sessions", IRCClientSessionBenchmark },
+	{ "channels", "NAMES ingest and membership churn, at 1k/10k/50k members", IRCClientChannelBenchmark },
+	{ "members", "Memory per channel member, with nicks shared across 200 channels", IRCClientIdentifierBenchmark },
+	{ "tls", "TLS handshake latency, full and resumed, over loopback", IRCClientTLSBenchmark },
+};
+
+// Passed to the benchmark itself, to run a test server instead.
+static const char *IRCClientBenchmarkServeArgument = "--serve";
+
+/******************************/
+#pragma mark - Helper functions
+/******************************/
+
+// Thousands of sessions need thousands of sockets.
+static void IRCClientBenchmarkRaiseFileLimit(void) {
+	struct rlimit limit;
+	if (getrlimit(RLIMIT_NOFILE, &limit) == -1)
+		return;
+
+	// (The kernel refuses more than kern.maxfilesperproc, whatever the hard
+	// limit says.)
+	const rlim_t wanted[] = { 65536, 32768, 24576, OPEN_MAX };
+	for (size_t i = 0; i < sizeof(wanted) / sizeof(wanted[0]); i++) {
+		struct rlimit raised = { MIN(wanted[i], limit.rlim_max), limit.rlim_max };
+		if (   raised.rlim_cur <= limit.rlim_cur
+			|| setrlimit(RLIMIT_NOFILE, &raised) == 0)
+			return;
+	}
+}
+
+// Runs a test server until stdin is closed (i.e., until the benchmark that
+// launched us exits); its port is printed (on a line of its own) once it’s
+// listening.
+static int IRCClientBenchmarkServe(void) {
+	// (Static, so that it outlives the call to dispatch_main().)
+	static IRCClientTestServer *server;
+	server = [IRCClientTestServer new];
+	if ([server start] == NO)
+		return 1;
+	printf("%lu\n", (unsigned long) server.port);
+	fflush(stdout);
+
+	dispatch_source_t stdinSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, STDIN_FILENO, 0, dispatch_get_main_queue());
+	dispatch_source_set_event_handler(stdinSource, ^{
+		char buffer[256];
+		if (read(STDIN_FILENO, buffer, sizeof(buffer)) <= 0)
+			exit(0);
+	});
+	dispatch_resume(stdinSource);
+
+	dispatch_main();
+}
+
+/*********************************/
+#pragma mark - Measuring functions
+/*********************************/
+
+uint64_t IRCClientBenchmarkTime(void) {
+	return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+NSTimeInterval IRCClientBenchmarkElapsedTime(uint64_t since) {
+	return (IRCClientBenchmarkTime() - since) / (NSTimeInterval) NSEC_PER_SEC;
+}
+
+uint64_t IRCClientBenchmarkMemoryFootprint(void) {
+	task_vm_info_data_t info;
+	mach_msg_type_number_t count = TASK_VM_INFO_COUNT;
+	if (task_info(mach_task_self(), TASK_VM_INFO, (task_info_t) &info, &count) != KERN_SUCCESS)
+		return 0;
+
+	return info.phys_footprint;
+}
+
+NSTimeInterval IRCClientBenchmarkCPUTime(void) {
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	return (  usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6
+			+ usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6);
+}
+
+/*************************/
+#pragma mark - Test server
+/*************************/
+
+NSTask *IRCClientBenchmarkLaunchServer(NSUInteger *port) {
+	NSTask *task = [NSTask new];
+	task.executableURL = [NSURL fileURLWithPath:[NSProcessInfo processInfo].arguments.firstObject];
+	task.arguments = @[ @(IRCClientBenchmarkServeArgument) ];
+	NSPipe *input = [NSPipe pipe];
+	NSPipe *output = [NSPipe pipe];
+	task.standardInput = input;
+	task.standardOutput = output;
+	if ([task launchAndReturnError:NULL] == NO)
+		return nil;
+
+	// The first line that the server prints is its port.
+	NSMutableData *line = [NSMutableData data];
+	for (;;) {
+		NSData *data = [output.fileHandleForReading readDataOfLength:1];
+		if (data.length == 0)
+			return nil;
+		if (*(const char *) data.bytes == '\n')
+			break;
+		[line appendData:data];
+	}
+	*port = (NSUInteger) [[NSString alloc] initWithData:line
+											   encoding:NSUTF8StringEncoding].integerValue;
+
+	return (*port != 0) ? task : nil;
+}
+
+/******************/
+#pragma mark - main
+/******************/
+
+int main(int argc, const char *argv[]) {
+	@autoreleasepool {
+		IRCClientBenchmarkRaiseFileLimit();
+
+		if (   argc > 1
+			&& strcmp(argv[1], IRCClientBenchmarkServeArgument) == 0)
+			return IRCClientBenchmarkServe();
+
+		int status = 0;
+		for (size_t i = 0; i < sizeof(IRCClientBenchmarks) / sizeof(IRCClientBenchmark); i++) {
+			const IRCClientBenchmark *benchmark = &IRCClientBenchmarks[i];
+
+			BOOL selected = (argc == 1);
+			for (int j = 1; j < argc; j++)
+				if (strcmp(argv[j], benchmark->name) == 0)
+					selected = YES;
+			if (selected == NO)
+				continue;
+
+			printf("== %s: %s\n", benchmark->name, benchmark->description);
+			@autoreleasepool {
+				status |= benchmark->run();
+			}
+			printf("\n");
+		}
+
+		return status;
+	}
+}
@@ -0,0 +1,348 @@
+//
+//	IRCClientCapabilityTests.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <XCTest/XCTest.h>
+
+#import "IRCClientSession.h"
+#import "IRCClientTestServer.h"
+#import "IRCClientTestDelegate.h"
+
+/****************************/
+#pragma mark Helper functions
+/****************************/
+
+static NSData *IRCClientCapabilityTestsData(NSString *string) {
+	return [string dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+static NSString *IRCClientCapabilityTestsString(NSData *data) {
+	return [[NSString alloc] initWithData:data
+								 encoding:NSUTF8StringEncoding];
+}
+
+/***********************************************************/
+#pragma mark - IRCClientCapabilityTests class implementation
+/***********************************************************/
+
+@interface IRCClientCapabilityTests : XCTestCase
+
+@end
+
+@implementation IRCClientCapabilityTests {
+	IRCClientTestServer *_server;
+	IRCClientTestDelegate *_delegate;
+	IRCClientSession *_session;
+
+	// Guarded by @synchronized (self).
+	// Every line that the server has received, in order.
+	NSMutableArray <NSString *> *_lines;
+	// The subcommand of every CAP message that the session’s handler has
+	// seen, and the capabilities enabled as of the last of them.
+	NSMutableArray <NSString *> *_capabilitySubcommands;
+	NSSet <NSString *> *_enabledCapabilities;
+	// What the server answers the SASL credentials with (e.g. "903 ..."),
+	// or nil for nothing.
+	NSString *_authenticationReply;
+	// If YES, the server ignores CAP altogether.
+	BOOL _ignoresCapabilities;
+	// If YES, the server refuses every CAP REQ.
+	BOOL _refusesRequests;
+}
+
+-(void) setUp {
+	_lines = [NSMutableArray array];
+	_capabilitySubcommands = [NSMutableArray array];
+
+	_server = [IRCClientTestServer new];
+	_server.offeredCapabilities = @"server-time batch account-tag sasl=PLAIN";
+	_server.lineHandler = ^BOOL (IRCClientTestConnection *connection,
+								 NSString *line) {
+		return [self serverConnection:connection
+						 receivedLine:line];
+	};
+	XCTAssertTrue([_server start]);
+
+	_delegate = [IRCClientTestDelegate new];
+	_session = [_server sessionWithNickname:@"reader"
+								  eventLoop:nil];
+	_session.delegate = _delegate;
+	_session.requestedCapabilities = @[ IRCClientCapabilityTestsData(@"server-time"),
+										IRCClientCapabilityTestsData(@"batch"),
+										IRCClientCapabilityTestsData(@"echo-message") ];
+	[_session setHandler:^(NSData *origin,
+						   NSArray <NSData *> *params,
+						   IRCClientSession *session) {
+		// (On the session’s queue, where enabledCapabilities may be used.)
+		NSMutableSet <NSString *> *enabled = [NSMutableSet set];
+		for (NSData *capability in session.enabledCapabilities)
+			[enabled addObject:IRCClientCapabilityTestsString(capability)];
+
+		@synchronized (self) {
+			[_capabilitySubcommands addObject:(params.count > 1 ? IRCClientCapabilityTestsString(params[1]) : @"")];
+			_enabledCapabilities = enabled;
+		}
+	}
+			  forCommand:IRCClientCapabilityTestsData(@"CAP")];
+}
+
+-(void) tearDown {
+	[_session disconnect];
+	[_server stop];
+	_session = nil;
+	_server = nil;
+}
+
+/****************************/
+#pragma mark - Helper methods
+/****************************/
+
+// (On the server’s queue.)
+-(BOOL) serverConnection:(IRCClientTestConnection *)connection
+			receivedLine:(NSString *)line {
+	NSString *authenticationReply;
+	BOOL ignoresCapabilities, refusesRequests;
+	@synchronized (self) {
+		[_lines addObject:line];
+		authenticationReply = _authenticationReply;
+		ignoresCapabilities = _ignoresCapabilities;
+		refusesRequests = _refusesRequests;
+	}
+
+	if ([line hasPrefix:@"CAP "]) {
+		if (ignoresCapabilities)
+			return YES;
+
+		if (   refusesRequests
+			&& [line hasPrefix:@"CAP REQ :"]) {
+			[connection sendLine:[NSString stringWithFormat:@":irc.test CAP * NAK :%@", [line substringFromIndex:9]]];
+			return YES;
+		}
+
+		return NO;
+	}
+
+	if ([line hasPrefix:@"AUTHENTICATE "]) {
+		// (Without the sasl capability, there’s nothing to authenticate.)
+		if (refusesRequests)
+			return YES;
+
+		NSString *argument = [line substringFromIndex:13];
+		if (   [argument isEqualToString:@"PLAIN"]
+			|| [argument isEqualToString:@"EXTERNAL"]) {
+			[connection sendLine:@"AUTHENTICATE +"];
+		} else if (   argument.length < 400
+				   && authenticationReply != nil) {
+			// (The last chunk of the credentials.)
+			[connection sendLine:[NSString stringWithFormat:@":irc.test %@", authenticationReply]];
+		}
+
+		return YES;
+	}
+
+	return NO;
+}
+
+-(void) connect {
+	[_session connect];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (_delegate.connectionCount == 1);
+	}));
+}
+
+-(NSArray <NSString *> *) receivedLinesWithPrefix:(NSString *)prefix {
+	NSMutableArray <NSString *> *lines = [NSMutableArray array];
+	@synchronized (self) {
+		for (NSString *line in _lines)
+			if ([line hasPrefix:prefix])
+				[lines addObject:line];
+	}
+
+	return lines;
+}
+
+-(NSUInteger) indexOfReceivedLine:(NSString *)line {
+	@synchronized (self) {
+		return [_lines indexOfObject:line];
+	}
+}
+
+-(NSArray <NSString *> *) capabilitySubcommands {
+	@synchronized (self) {
+		return [_capabilitySubcommands copy];
+	}
+}
+
+-(NSSet <NSString *> *) enabledCapabilities {
+	@synchronized (self) {
+		return _enabledCapabilities;
+	}
+}
+
+/******************************************/
+#pragma mark - Capability negotiation tests
+/******************************************/
+
+-(void) testNegotiationIsPipelinedWithRegistration {
+	[self connect];
+
+	// (CAP LS goes out in the same flight as NICK and USER; the server holds
+	// off registering until CAP END.)
+	XCTAssertEqualObjects([self receivedLinesWithPrefix:@""].firstObject, @"CAP LS 302");
+	XCTAssertLessThan([self indexOfReceivedLine:@"NICK reader"], [self indexOfReceivedLine:@"CAP REQ :server-time batch"]);
+	XCTAssertLessThan([self indexOfReceivedLine:@"USER test unknown unknown :IRCClient test"], [self indexOfReceivedLine:@"CAP REQ :server-time batch"]);
+
+	// Only what was both wanted and offered is requested.
+	XCTAssertEqualObjects([self receivedLinesWithPrefix:@"CAP "],
+						  (@[ @"CAP LS 302", @"CAP REQ :server-time batch", @"CAP END" ]));
+	XCTAssertEqualObjects(self.capabilitySubcommands, (@[ @"LS", @"ACK" ]));
+	XCTAssertEqualObjects(self.enabledCapabilities, ([NSSet setWithObjects:@"server-time", @"batch", nil]));
+}
+
+-(void) testNegotiationIsSkippedIfNothingIsWanted {
+	_session.requestedCapabilities = @[];
+
+	[self connect];
+
+	XCTAssertEqualObjects([self receivedLinesWithPrefix:@"CAP "], @[]);
+	XCTAssertEqualObjects(self.capabilitySubcommands, @[]);
+}
+
+-(void) testServerWithoutCapabilityNegotiation {
+	// (The server registers us without ever answering CAP LS.)
+	_ignoresCapabilities = YES;
+
+	[self connect];
+
+	XCTAssertEqualObjects([self receivedLinesWithPrefix:@"CAP "], @[ @"CAP LS 302" ]);
+	XCTAssertEqualObjects(self.capabilitySubcommands, @[]);
+	XCTAssertTrue(_session.isConnected);
+}
+
+-(void) testRefusedRequestStillRegisters {
+	_refusesRequests = YES;
+	_session.SASLMechanism = IRCClientSASLMechanismPlain;
+	_session.SASLPassword = IRCClientCapabilityTestsData(@"secret");
+
+	[self connect];
+
+	// (The AUTHENTICATE that went along with the request fails with it, so
+	// negotiation ends as soon as the request is refused.)
+	XCTAssertEqualObjects([self receivedLinesWithPrefix:@"AUTHENTICATE "], @[ @"AUTHENTICATE PLAIN" ]);
+	XCTAssertEqualObjects([self receivedLinesWithPrefix:@"CAP "],
+						  (@[ @"CAP LS 302", @"CAP REQ :server-time batch sasl", @"CAP END" ]));
+	XCTAssertEqualObjects(self.capabilitySubcommands, (@[ @"LS", @"NAK" ]));
+	XCTAssertEqualObjects(self.enabledCapabilities, [NSSet set]);
+}
+
+-(void) testCapabilitiesOfferedLaterAreRequested {
+	_session.requestedCapabilities = @[ IRCClientCapabilityTestsData(@"server-time"),
+										IRCClientCapabilityTestsData(@"away-notify") ];
+	[self connect];
+	XCTAssertEqualObjects(self.enabledCapabilities, [NSSet setWithObject:@"server-time"]);
+
+	IRCClientTestConnection *connection = [_server connectionForNick:@"reader"];
+	_server.offeredCapabilities = @"server-time away-notify";
+	[connection sendLine:@":irc.test CAP reader NEW :away-notify account-notify"];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return [self.enabledCapabilities containsObject:@"away-notify"];
+	}));
+	XCTAssertEqualObjects([self receivedLinesWithPrefix:@"CAP REQ "],
+						  (@[ @"CAP REQ :server-time", @"CAP REQ :away-notify" ]));
+
+	[connection sendLine:@":irc.test CAP reader DEL :away-notify"];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return [self.capabilitySubcommands.lastObject isEqualToString:@"DEL"];
+	}));
+	XCTAssertEqualObjects(self.enabledCapabilities, [NSSet setWithObject:@"server-time"]);
+}
+
+/************************/
+#pragma mark - SASL tests
+/************************/
+
+-(void) testSASLPlainCredentialsAreSent {
+	_authenticationReply = @"903 reader :SASL authentication successful";
+	_session.SASLMechanism = IRCClientSASLMechanismPlain;
+	_session.SASLUsername = IRCClientCapabilityTestsData(@"account");
+	_session.SASLPassword = IRCClientCapabilityTestsData(@"secret");
+
+	[self connect];
+
+	// (authzid NUL authcid NUL password, with an empty authzid.)
+	NSString *credentials = [[NSData dataWithBytes:"\0account\0secret"
+											length:15] base64EncodedStringWithOptions:0];
+	XCTAssertEqualObjects([self receivedLinesWithPrefix:@"AUTHENTICATE "],
+						  (@[ @"AUTHENTICATE PLAIN", [@"AUTHENTICATE " stringByAppendingString:credentials] ]));
+	XCTAssertEqualObjects([self receivedLinesWithPrefix:@"CAP "],
+						  (@[ @"CAP LS 302", @"CAP REQ :server-time batch sasl", @"CAP END" ]));
+
+	// Registration waits until authentication is done.
+	XCTAssertGreaterThan([self indexOfReceivedLine:@"CAP END"],
+						 [self indexOfReceivedLine:[@"AUTHENTICATE " stringByAppendingString:credentials]]);
+}
+
+-(void) testLongCredentialsAreSentInChunks {
+	_authenticationReply = @"903 reader :SASL authentication successful";
+	_session.SASLMechanism = IRCClientSASLMechanismPlain;
+	// (With the nickname as the account: 300 bytes, i.e. exactly 400 bytes
+	// of base64, which must be followed by a “+”.)
+	NSString *password = [@"" stringByPaddingToLength:292
+										   withString:@"x"
+									  startingAtIndex:0];
+	_session.SASLPassword = IRCClientCapabilityTestsData(password);
+
+	[self connect];
+
+	NSMutableData *credentials = [NSMutableData dataWithBytes:"\0reader\0"
+													   length:8];
+	[credentials appendData:IRCClientCapabilityTestsData(password)];
+	NSString *payload = [credentials base64EncodedStringWithOptions:0];
+	XCTAssertEqual(payload.length, (NSUInteger) 400);
+	XCTAssertEqualObjects([self receivedLinesWithPrefix:@"AUTHENTICATE "],
+						  (@[ @"AUTHENTICATE PLAIN", [@"AUTHENTICATE " stringByAppendingString:payload], @"AUTHENTICATE +" ]));
+}
+
+-(void) testSASLFailureStillRegisters {
+	_authenticationReply = @"904 reader :SASL authentication failed";
+	_session.SASLMechanism = IRCClientSASLMechanismPlain;
+	_session.SASLPassword = IRCClientCapabilityTestsData(@"wrong");
+
+	[self connect];
+
+	// (Authentication isn’t tried again.)
+	XCTAssertEqual([self receivedLinesWithPrefix:@"AUTHENTICATE "].count, (NSUInteger) 2);
+	XCTAssertEqualObjects([self receivedLinesWithPrefix:@"CAP END"], @[ @"CAP END" ]);
+	XCTAssertTrue(_session.isConnected);
+}
+
+-(void) testUnsupportedMechanismIsNotAttempted {
+	_server.offeredCapabilities = @"server-time sasl=EXTERNAL";
+	_session.SASLMechanism = IRCClientSASLMechanismPlain;
+	_session.SASLPassword = IRCClientCapabilityTestsData(@"secret");
+
+	[self connect];
+
+	XCTAssertEqualObjects([self receivedLinesWithPrefix:@"AUTHENTICATE "], @[]);
+	XCTAssertEqualObjects([self receivedLinesWithPrefix:@"CAP "],
+						  (@[ @"CAP LS 302", @"CAP REQ :server-time", @"CAP END" ]));
+}
+
+-(void) testSASLIsNotAttemptedWithoutServerSupport {
+	_server.offeredCapabilities = @"server-time";
+	_session.SASLMechanism = IRCClientSASLMechanismPlain;
+	_session.SASLPassword = IRCClientCapabilityTestsData(@"secret");
+
+	[self connect];
+
+	XCTAssertEqualObjects([self receivedLinesWithPrefix:@"AUTHENTICATE "], @[]);
+	XCTAssertEqualObjects([self receivedLinesWithPrefix:@"CAP "],
+						  (@[ @"CAP LS 302", @"CAP REQ :server-time", @"CAP END" ]));
+}
+
+@end
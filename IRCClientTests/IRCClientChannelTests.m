@@ -0,0 +1,221 @@
+//
+//	IRCClientChannelTests.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <XCTest/XCTest.h>
+
+#import "IRCClientSession.h"
+#import "IRCClientSession_Private.h"
+#import "IRCClientChannel.h"
+#import "IRCClientTestServer.h"
+#import "IRCClientTestDelegate.h"
+
+/******************************************************/
+#pragma mark IRCClientChannelTests class implementation
+/******************************************************/
+
+@interface IRCClientChannelTests : XCTestCase
+
+@end
+
+@implementation IRCClientChannelTests {
+	IRCClientTestServer *_server;
+	IRCClientTestDelegate *_delegate;
+	IRCClientSession *_session;
+
+	// The session’s connection, as seen by the server; lines sent on it
+	// are what the session receives.
+	IRCClientTestConnection *_connection;
+}
+
+-(void) setUp {
+	_server = [IRCClientTestServer new];
+	_server.supportTokens = @[ @"PREFIX=(qaohv)~&@%+" ];
+	XCTAssertTrue([_server start]);
+
+	_delegate = [IRCClientTestDelegate new];
+	_session = [_server sessionWithNickname:@"watcher"
+								  eventLoop:nil];
+	_session.delegate = _delegate;
+	[_session connect];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (_delegate.connectionCount == 1);
+	}));
+
+	_connection = [_server connectionForNick:@"watcher"];
+	XCTAssertNotNil(_connection);
+}
+
+-(void) tearDown {
+	[_session disconnect];
+	[_server stop];
+	_session = nil;
+	_server = nil;
+}
+
+/****************************/
+#pragma mark - Helper methods
+/****************************/
+
+// Joins the channels, and returns them (in the same order).
+-(NSArray <IRCClientChannel *> *) join:(NSArray <NSString *> *)channelNames {
+	for (NSString *channelName in channelNames)
+		[_session join:[channelName dataUsingEncoding:NSUTF8StringEncoding]
+				   key:nil];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (_delegate.joinedChannels.count == channelNames.count);
+	}));
+
+	return _delegate.joinedChannels;
+}
+
+-(void) send:(NSArray <NSString *> *)lines {
+	XCTAssertTrue([_delegate sendLines:lines
+						  toConnection:_connection]);
+}
+
+// The channel’s members, as strings (read on the session’s queue, where the
+// members are kept).
+-(NSSet <NSString *> *) membersOf:(IRCClientChannel *)channel {
+	NSMutableSet <NSString *> *members = [NSMutableSet set];
+	[_session performOnSessionQueueAndWait:^{
+		for (NSData *nick in channel.nicks)
+			[members addObject:[[NSString alloc] initWithData:nick
+													 encoding:NSUTF8StringEncoding]];
+	}];
+
+	return members;
+}
+
+-(NSString *) prefixesOf:(NSString *)nick
+			   inChannel:(IRCClientChannel *)channel {
+	NSData *prefixes = [channel prefixesForMember:[nick dataUsingEncoding:NSUTF8StringEncoding]];
+
+	return (prefixes != nil) ? [[NSString alloc] initWithData:prefixes
+													 encoding:NSUTF8StringEncoding] : nil;
+}
+
+/*******************/
+#pragma mark - Tests
+/*******************/
+
+-(void) testJoiningListsTheMembers {
+	IRCClientChannel *channel = [self join:@[ @"#test" ]].firstObject;
+
+	// (The channel is joined when the JOIN comes back; the test server’s
+	// RPL_NAMREPLY and RPL_ENDOFNAMES follow it.)
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return [channel hasMember:[@"watcher" dataUsingEncoding:NSUTF8StringEncoding]];
+	}));
+	XCTAssertEqualObjects([self membersOf:channel], [NSSet setWithObject:@"watcher"]);
+	XCTAssertEqualObjects([self prefixesOf:@"watcher" inChannel:channel], @"@");
+}
+
+-(void) testNamesReplyIsIngested {
+	IRCClientChannel *channel = [self join:@[ @"#test" ]].firstObject;
+
+	// With multi-prefix, every prefix; and with userhost-in-names, the
+	// user@host (which isn’t part of the nick).
+	[self send:@[ @":irc.test 353 watcher = #test :@watcher ~&alice +bob carol!c@example.com",
+				  @":irc.test 353 watcher = #test :@+dave %erin",
+				  @":irc.test 366 watcher #test :End of /NAMES list." ]];
+
+	NSSet *members = [NSSet setWithObjects:@"watcher", @"alice", @"bob", @"carol", @"dave", @"erin", nil];
+	XCTAssertEqualObjects([self membersOf:channel], members);
+
+	XCTAssertEqualObjects([self prefixesOf:@"alice" inChannel:channel], @"~&");
+	XCTAssertEqualObjects([self prefixesOf:@"bob" inChannel:channel], @"+");
+	XCTAssertEqualObjects([self prefixesOf:@"carol" inChannel:channel], @"");
+	XCTAssertEqualObjects([self prefixesOf:@"dave" inChannel:channel], @"@+");
+	XCTAssertEqualObjects([self prefixesOf:@"erin" inChannel:channel], @"%");
+	XCTAssertNil([self prefixesOf:@"frank" inChannel:channel]);
+}
+
+-(void) testNamesReplyReplacesTheMembersOnceComplete {
+	IRCClientChannel *channel = [self join:@[ @"#test" ]].firstObject;
+	[self send:@[ @":irc.test 353 watcher = #test :watcher alice bob",
+				  @":irc.test 366 watcher #test :End of /NAMES list." ]];
+
+	// Until RPL_ENDOFNAMES, the old list stands (though joins and parts
+	// apply to both).
+	[self send:@[ @":irc.test 353 watcher = #test :watcher alice carol",
+				  @":dave!d@example.com JOIN #test",
+				  @":alice!a@example.com PART #test" ]];
+	NSSet *members = [NSSet setWithObjects:@"watcher", @"bob", @"dave", nil];
+	XCTAssertEqualObjects([self membersOf:channel], members);
+
+	[self send:@[ @":irc.test 366 watcher #test :End of /NAMES list." ]];
+	members = [NSSet setWithObjects:@"watcher", @"carol", @"dave", nil];
+	XCTAssertEqualObjects([self membersOf:channel], members);
+}
+
+-(void) testMembershipFollowsJoinPartKickQuitAndNick {
+	IRCClientChannel *channel = [self join:@[ @"#test" ]].firstObject;
+	[self send:@[ @":irc.test 353 watcher = #test :@watcher alice bob carol",
+				  @":irc.test 366 watcher #test :End of /NAMES list." ]];
+
+	[self send:@[ @":dave!d@example.com JOIN #test",
+				  @":bob!b@example.com PART #test :Bye",
+				  @":watcher!test@localhost KICK #test carol :Out",
+				  @":watcher!test@localhost MODE #test +v alice",
+				  @":alice!a@example.com NICK :alicia" ]];
+	NSSet *members = [NSSet setWithObjects:@"watcher", @"alicia", @"dave", nil];
+	XCTAssertEqualObjects([self membersOf:channel], members);
+
+	// The prefixes follow the nick.
+	XCTAssertEqualObjects([self prefixesOf:@"alicia" inChannel:channel], @"+");
+	XCTAssertFalse([channel hasMember:[@"alice" dataUsingEncoding:NSUTF8StringEncoding]]);
+
+	[self send:@[ @":dave!d@example.com QUIT :Gone" ]];
+	members = [NSSet setWithObjects:@"watcher", @"alicia", nil];
+	XCTAssertEqualObjects([self membersOf:channel], members);
+}
+
+-(void) testQuitAndNickApplyToEveryChannel {
+	NSArray <IRCClientChannel *> *channels = [self join:@[ @"#one", @"#two", @"#three" ]];
+	for (NSString *channelName in @[ @"#one", @"#two" ])
+		[self send:@[ [NSString stringWithFormat:@":alice!a@example.com JOIN %@", channelName],
+					  [NSString stringWithFormat:@":bob!b@example.com JOIN %@", channelName] ]];
+
+	[self send:@[ @":alice!a@example.com NICK :alicia",
+				  @":bob!b@example.com QUIT :Gone" ]];
+	for (IRCClientChannel *channel in channels) {
+		BOOL wasJoined = (channel != channels.lastObject);
+		XCTAssertEqual([channel hasMember:[@"alicia" dataUsingEncoding:NSUTF8StringEncoding]], wasJoined);
+		XCTAssertFalse([channel hasMember:[@"alice" dataUsingEncoding:NSUTF8StringEncoding]]);
+		XCTAssertFalse([channel hasMember:[@"bob" dataUsingEncoding:NSUTF8StringEncoding]]);
+	}
+}
+
+-(void) testLargeNamesReply {
+	static const NSUInteger MemberCount = 20000;
+
+	IRCClientChannel *channel = [self join:@[ @"#big" ]].firstObject;
+
+	NSMutableArray <NSString *> *lines = [NSMutableArray array];
+	NSMutableString *names = [NSMutableString string];
+	for (NSUInteger i = 0; i < MemberCount; i++) {
+		[names appendFormat:@"%@user%lu ", (i % 10 == 0 ? @"@" : @""), (unsigned long) i];
+		if (names.length > 400 || i == MemberCount - 1) {
+			[lines addObject:[@":irc.test 353 watcher = #big :" stringByAppendingString:names]];
+			[names setString:@""];
+		}
+	}
+	[lines addObject:@":irc.test 366 watcher #big :End of /NAMES list."];
+	[self send:lines];
+
+	__block NSUInteger memberCount;
+	[_session performOnSessionQueueAndWait:^{
+		memberCount = channel.memberCount;
+	}];
+	XCTAssertEqual(memberCount, MemberCount);
+	XCTAssertEqualObjects([self prefixesOf:@"user12340" inChannel:channel], @"@");
+	XCTAssertEqualObjects([self prefixesOf:@"user12345" inChannel:channel], @"");
+}
+
+@end
@@ -0,0 +1,107 @@
+//
+//	IRCClientCommandTableTests.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <XCTest/XCTest.h>
+
+#import "IRCClientCommandTable.h"
+#import "IRCClientNumericsTable.h"
+
+/****************************/
+#pragma mark Helper functions
+/****************************/
+
+static IRCClientCommand IRCClientCommandTableTestsLookUp(const char *command) {
+	return IRCClientCommandLookup((const uint8_t *) command, strlen(command));
+}
+
+/*************************************************************/
+#pragma mark - IRCClientCommandTableTests class implementation
+/*************************************************************/
+
+@interface IRCClientCommandTableTests : XCTestCase
+
+@end
+
+@implementation IRCClientCommandTableTests
+
+/********************************/
+#pragma mark - Command hash tests
+/********************************/
+
+-(void) testEveryCommandIsFound {
+	NSUInteger found = 0;
+	for (NSUInteger slot = 0; slot < (1 << IRCClientCommandHashBits); slot++) {
+		const char *name = IRCClientCommandHashTable[slot].name;
+		if (name == NULL)
+			continue;
+
+		XCTAssertEqual(strlen(name), IRCClientCommandHashTable[slot].length, @"%s", name);
+		XCTAssertEqual(IRCClientCommandTableTestsLookUp(name), IRCClientCommandHashTable[slot].command, @"%s", name);
+		found++;
+	}
+
+	// (Every command but IRCClientCommandUnknown has a slot.)
+	XCTAssertEqual(found, (NSUInteger) IRCClientCommandFAIL);
+}
+
+-(void) testCommandsAreFoundByName {
+	XCTAssertEqual(IRCClientCommandTableTestsLookUp("PRIVMSG"), IRCClientCommandPRIVMSG);
+	XCTAssertEqual(IRCClientCommandTableTestsLookUp("PING"), IRCClientCommandPING);
+	XCTAssertEqual(IRCClientCommandTableTestsLookUp("CAP"), IRCClientCommandCAP);
+	XCTAssertEqual(IRCClientCommandTableTestsLookUp("AUTHENTICATE"), IRCClientCommandAUTHENTICATE);
+}
+
+-(void) testOtherCommandsAreUnknown {
+	// (Including ones that share a slot’s first four bytes and length.)
+	for (NSString *command in @[ @"CHGHOST", @"ACCOUNT", @"AWAY", @"PONG", @"PRIVMSH", @"AUTHENTICATED", @"PIN", @"NOTICE2" ])
+		XCTAssertEqual(IRCClientCommandTableTestsLookUp(command.UTF8String), IRCClientCommandUnknown, @"%@", command);
+}
+
+-(void) testCommandsAreCaseSensitive {
+	XCTAssertEqual(IRCClientCommandTableTestsLookUp("privmsg"), IRCClientCommandUnknown);
+	XCTAssertEqual(IRCClientCommandTableTestsLookUp("Ping"), IRCClientCommandUnknown);
+}
+
+-(void) testEmptyCommandIsUnknown {
+	XCTAssertEqual(IRCClientCommandLookup((const uint8_t *) "", 0), IRCClientCommandUnknown);
+}
+
+-(void) testOnlyTheGivenBytesAreLookedAt {
+	// (A command is a range of a longer line.)
+	const char *line = "JOINED";
+	XCTAssertEqual(IRCClientCommandLookup((const uint8_t *) line, 4), IRCClientCommandJOIN);
+	XCTAssertEqual(IRCClientCommandLookup((const uint8_t *) line, 6), IRCClientCommandUnknown);
+}
+
+/***************************/
+#pragma mark - Numeric tests
+/***************************/
+
+-(void) testNumericsHaveNames {
+	XCTAssertEqual(strcmp(IRCClientNumericName(1), "RPL_WELCOME"), 0);
+	XCTAssertEqual(strcmp(IRCClientNumericName(5), "RPL_ISUPPORT"), 0);
+	XCTAssertEqual(strcmp(IRCClientNumericName(433), "ERR_NICKNAMEINUSE"), 0);
+}
+
+-(void) testNumericNamesAreCountedAndBounded {
+	NSUInteger count = IRCClientNumericNameCount(5);
+	XCTAssertGreaterThan(count, (NSUInteger) 1);
+	for (NSUInteger i = 0; i < count; i++)
+		XCTAssertNotEqual(IRCClientNumericNameAtIndex(5, i), NULL);
+	XCTAssertEqual(IRCClientNumericNameAtIndex(5, count), NULL);
+}
+
+-(void) testUnknownNumericsHaveNoName {
+	XCTAssertEqual(IRCClientNumericName(0), NULL);
+	XCTAssertEqual(IRCClientNumericName(IRCClientNumericCodeCount), NULL);
+	XCTAssertEqual(IRCClientNumericName(NSUIntegerMax), NULL);
+	XCTAssertEqual(IRCClientNumericNameCount(NSUIntegerMax), (NSUInteger) 0);
+}
+
+@end
@@ -0,0 +1,257 @@
+//
+//	IRCClientCommandTests.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <XCTest/XCTest.h>
+
+#import "IRCClientSession.h"
+#import "IRCClientSession_Private.h"
+#import "IRCClientTestServer.h"
+#import "IRCClientTestDelegate.h"
+
+/****************************/
+#pragma mark Helper functions
+/****************************/
+
+static NSData *IRCClientCommandTestsData(NSString *string) {
+	return [string dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+// Returns a string of the given length.
+static NSString *IRCClientCommandTestsText(NSUInteger length) {
+	return [@"" stringByPaddingToLength:length
+							 withString:@"x"
+						startingAtIndex:0];
+}
+
+/********************************************************/
+#pragma mark - IRCClientCommandTests class implementation
+/********************************************************/
+
+@interface IRCClientCommandTests : XCTestCase
+
+@end
+
+@implementation IRCClientCommandTests {
+	IRCClientTestServer *_server;
+	IRCClientTestDelegate *_delegate;
+	IRCClientSession *_session;
+
+	// Distinguishes the markers sent by -[sentLinesWithCommand:].
+	NSUInteger _markerCount;
+}
+
+-(void) tearDown {
+	[_session disconnect];
+	[_server stop];
+	_session = nil;
+	_server = nil;
+}
+
+/****************************/
+#pragma mark - Helper methods
+/****************************/
+
+-(void) connectWithSupportTokens:(NSArray <NSString *> *)supportTokens {
+	_server = [IRCClientTestServer new];
+	_server.supportTokens = supportTokens;
+	XCTAssertTrue([_server start]);
+
+	_delegate = [IRCClientTestDelegate new];
+	_session = [_server sessionWithNickname:@"sender"
+								  eventLoop:nil];
+	_session.delegate = _delegate;
+	[_session connect];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (_delegate.connectionCount == 1);
+	}));
+}
+
+// Returns the lines with the given command that the server has received,
+// once it has received everything sent before (which is known by sending a
+// marker after it, and waiting for that).
+-(NSArray <NSString *> *) sentLinesWithCommand:(NSString *)command {
+	NSString *marker = [NSString stringWithFormat:@"MARKER %lu", (unsigned long) ++_markerCount];
+	XCTAssertEqual([_session sendRaw:IRCClientCommandTestsData(marker)], 0);
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return [[_server receivedLinesWithCommand:@"MARKER"] containsObject:marker];
+	}));
+
+	return [_server receivedLinesWithCommand:command];
+}
+
+/**************************/
+#pragma mark - Format tests
+/**************************/
+
+-(void) testCommandsAreFormatted {
+	[self connectWithSupportTokens:nil];
+
+	XCTAssertEqual([_session message:IRCClientCommandTestsData(@"Hello, world")
+								  to:IRCClientCommandTestsData(@"friend")], 0);
+	XCTAssertEqual([_session notice:IRCClientCommandTestsData(@"Heads up")
+								 to:IRCClientCommandTestsData(@"#channel")], 0);
+	XCTAssertEqual([_session action:IRCClientCommandTestsData(@"waves")
+								 to:IRCClientCommandTestsData(@"#channel")], 0);
+	XCTAssertEqual([_session ctcpRequest:IRCClientCommandTestsData(@"VERSION")
+								  target:IRCClientCommandTestsData(@"friend")], 0);
+	XCTAssertEqual([_session ctcpReply:IRCClientCommandTestsData(@"VERSION IRCClient")
+								target:IRCClientCommandTestsData(@"friend")], 0);
+	XCTAssertEqual([_session whois:IRCClientCommandTestsData(@"friend")], 0);
+	XCTAssertEqual([_session userMode:IRCClientCommandTestsData(@"+i")], 0);
+
+	XCTAssertEqualObjects([self sentLinesWithCommand:@"PRIVMSG"],
+						  (@[ @"PRIVMSG friend :Hello, world",
+							  @"PRIVMSG #channel :\001ACTION waves\001",
+							  @"PRIVMSG friend :\001VERSION\001" ]));
+	XCTAssertEqualObjects([self sentLinesWithCommand:@"NOTICE"],
+						  (@[ @"NOTICE #channel :Heads up",
+							  @"NOTICE friend :\001VERSION IRCClient\001" ]));
+	XCTAssertEqualObjects([self sentLinesWithCommand:@"WHOIS"], @[ @"WHOIS friend" ]);
+	XCTAssertEqualObjects([self sentLinesWithCommand:@"MODE"], @[ @"MODE sender +i" ]);
+}
+
+-(void) testNamesAndListWithoutAnArgumentHaveNoParameter {
+	[self connectWithSupportTokens:nil];
+
+	XCTAssertEqual([_session names:nil], 0);
+	XCTAssertEqual([_session names:[NSData data]], 0);
+	XCTAssertEqual([_session names:IRCClientCommandTestsData(@"#channel")], 0);
+	XCTAssertEqual([_session list:nil], 0);
+	XCTAssertEqual([_session list:[NSData data]], 0);
+
+	XCTAssertEqualObjects([self sentLinesWithCommand:@"NAMES"],
+						  (@[ @"NAMES", @"NAMES", @"NAMES #channel" ]));
+	XCTAssertEqualObjects([self sentLinesWithCommand:@"LIST"],
+						  (@[ @"LIST", @"LIST" ]));
+}
+
+-(void) testEmptyArgumentsAreRefused {
+	[self connectWithSupportTokens:nil];
+
+	XCTAssertEqual([_session message:nil
+								  to:IRCClientCommandTestsData(@"friend")], 1);
+	XCTAssertEqual([_session message:IRCClientCommandTestsData(@"text")
+								  to:[NSData data]], 1);
+	XCTAssertEqual([_session action:[NSData data]
+								 to:IRCClientCommandTestsData(@"friend")], 1);
+
+	XCTAssertEqualObjects([self sentLinesWithCommand:@"PRIVMSG"], @[]);
+}
+
+/*******************************/
+#pragma mark - Line length tests
+/*******************************/
+
+-(void) testLineOfTheMaximumLengthIsSent {
+	[self connectWithSupportTokens:nil];
+
+	// “PRIVMSG friend :” + text + CRLF is exactly 512 bytes.
+	NSString *text = IRCClientCommandTestsText(IRCClientMaxLineLength - strlen("PRIVMSG friend :") - 2);
+	XCTAssertEqual([_session message:IRCClientCommandTestsData(text)
+								  to:IRCClientCommandTestsData(@"friend")], 0);
+
+	XCTAssertEqualObjects([self sentLinesWithCommand:@"PRIVMSG"],
+						  @[ [@"PRIVMSG friend :" stringByAppendingString:text] ]);
+}
+
+-(void) testLongerLineIsNotSent {
+	[self connectWithSupportTokens:nil];
+
+	NSString *text = IRCClientCommandTestsText(IRCClientMaxLineLength - strlen("PRIVMSG friend :") - 1);
+	XCTAssertEqual([_session message:IRCClientCommandTestsData(text)
+								  to:IRCClientCommandTestsData(@"friend")], 1);
+
+	// (If one of several messages doesn’t fit, none are sent.)
+	XCTAssertEqual([_session messages:@[ IRCClientCommandTestsData(@"short"), IRCClientCommandTestsData(text) ]
+							toTargets:@[ IRCClientCommandTestsData(@"friend") ]], 1);
+
+	XCTAssertEqualObjects([self sentLinesWithCommand:@"PRIVMSG"], @[]);
+}
+
+-(void) testServerCanAllowLongerLines {
+	[self connectWithSupportTokens:@[ @"LINELEN=1024" ]];
+
+	NSString *text = IRCClientCommandTestsText(1024 - strlen("PRIVMSG friend :") - 2);
+	XCTAssertEqual([_session message:IRCClientCommandTestsData(text)
+								  to:IRCClientCommandTestsData(@"friend")], 0);
+	XCTAssertEqual([_session message:IRCClientCommandTestsData([text stringByAppendingString:@"x"])
+								  to:IRCClientCommandTestsData(@"friend")], 1);
+
+	XCTAssertEqualObjects([self sentLinesWithCommand:@"PRIVMSG"],
+						  @[ [@"PRIVMSG friend :" stringByAppendingString:text] ]);
+}
+
+-(void) testServerCannotAllowShorterLines {
+	// (We never send less than the RFC allows.)
+	[self connectWithSupportTokens:@[ @"LINELEN=100" ]];
+
+	NSString *text = IRCClientCommandTestsText(200);
+	XCTAssertEqual([_session message:IRCClientCommandTestsData(text)
+								  to:IRCClientCommandTestsData(@"friend")], 0);
+
+	XCTAssertEqual([self sentLinesWithCommand:@"PRIVMSG"].count, (NSUInteger) 1);
+}
+
+/*******************************/
+#pragma mark - Target list tests
+/*******************************/
+
+-(void) testMessagesGoToAsManyTargetsAsAllowed {
+	[self connectWithSupportTokens:@[ @"TARGMAX=PRIVMSG:2" ]];
+
+	NSArray <NSData *> *targets = @[ IRCClientCommandTestsData(@"a"),
+									 IRCClientCommandTestsData(@"b"),
+									 IRCClientCommandTestsData(@"c") ];
+	XCTAssertEqual([_session messages:@[ IRCClientCommandTestsData(@"one"), IRCClientCommandTestsData(@"two") ]
+							toTargets:targets], 0);
+
+	XCTAssertEqualObjects([self sentLinesWithCommand:@"PRIVMSG"],
+						  (@[ @"PRIVMSG a,b :one",
+							  @"PRIVMSG c :one",
+							  @"PRIVMSG a,b :two",
+							  @"PRIVMSG c :two" ]));
+}
+
+-(void) testChannelsAreJoinedInAsFewMessagesAsFit {
+	[self connectWithSupportTokens:@[ @"TARGMAX=JOIN:3" ]];
+
+	NSMutableArray <NSData *> *channels = [NSMutableArray array];
+	for (NSUInteger i = 0; i < 5; i++)
+		[channels addObject:IRCClientCommandTestsData([NSString stringWithFormat:@"#c%lu", (unsigned long) i])];
+	NSArray <NSData *> *keys = @[ IRCClientCommandTestsData(@"k0"),
+								  [NSData data],
+								  IRCClientCommandTestsData(@"k2"),
+								  [NSData data],
+								  [NSData data] ];
+	XCTAssertEqual([_session joinChannels:channels
+									 keys:keys], 0);
+
+	// (Keyed channels go first, so that the keys line up.)
+	XCTAssertEqualObjects([self sentLinesWithCommand:@"JOIN"],
+						  (@[ @"JOIN #c0,#c2,#c1 k0,k2",
+							  @"JOIN #c3,#c4" ]));
+}
+
+-(void) testChannelsAreSplitByLength {
+	[self connectWithSupportTokens:nil];
+
+	// Each name is 200 bytes, so only two fit in a line.
+	NSMutableArray <NSData *> *channels = [NSMutableArray array];
+	for (NSUInteger i = 0; i < 3; i++)
+		[channels addObject:IRCClientCommandTestsData([NSString stringWithFormat:@"#%lu%@", (unsigned long) i, IRCClientCommandTestsText(198)])];
+	XCTAssertEqual([_session joinChannels:channels
+									 keys:nil], 0);
+
+	NSArray <NSString *> *joins = [self sentLinesWithCommand:@"JOIN"];
+	XCTAssertEqual(joins.count, (NSUInteger) 2);
+	for (NSString *join in joins)
+		XCTAssertLessThanOrEqual([join lengthOfBytesUsingEncoding:NSUTF8StringEncoding] + 2, (NSUInteger) IRCClientMaxLineLength);
+}
+
+@end
@@ -0,0 +1,339 @@
+//
+//	IRCClientDCCTransferTests.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <XCTest/XCTest.h>
+
+#import "IRCClientSession.h"
+#import "IRCClientDCCTransfer.h"
+#import "IRCClientTestServer.h"
+#import "IRCClientTestDelegate.h"
+
+/****************************/
+#pragma mark Helper functions
+/****************************/
+
+// Returns the given number of random bytes.
+static NSData *IRCClientDCCTransferTestsRandomData(NSUInteger length) {
+	NSMutableData *data = [NSMutableData dataWithLength:length];
+	arc4random_buf(data.mutableBytes, length);
+
+	return data;
+}
+
+/************************************************************/
+#pragma mark - IRCClientDCCTransferTests class implementation
+/************************************************************/
+
+@interface IRCClientDCCTransferTests : XCTestCase <IRCClientDCCTransferDelegate>
+
+@end
+
+@implementation IRCClientDCCTransferTests {
+	IRCClientTestServer *_server;
+
+	IRCClientTestDelegate *_senderDelegate;
+	IRCClientSession *_sender;
+	IRCClientTestDelegate *_receiverDelegate;
+	IRCClientSession *_receiver;
+
+	NSString *_directory;
+	NSString *_sourcePath;
+	NSString *_destinationPath;
+	NSData *_contents;
+
+	// What the transfers have told us (guarded by @synchronized (self)).
+	IRCClientDCCTransfer *_offeredTransfer;
+	NSUInteger _offerCount;
+	NSMutableArray <IRCClientDCCTransfer *> *_finishedTransfers;
+	NSMutableArray <IRCClientDCCTransfer *> *_failedTransfers;
+}
+
+-(void) setUp {
+	_server = [IRCClientTestServer new];
+	XCTAssertTrue([_server start]);
+
+	// Both sessions are on this machine, so they can reach each other at the
+	// loopback address.
+	_senderDelegate = [IRCClientTestDelegate new];
+	_sender = [_server sessionWithNickname:@"sender"
+								 eventLoop:nil];
+	_sender.delegate = _senderDelegate;
+	_sender.DCCAddress = @"127.0.0.1";
+	_receiverDelegate = [IRCClientTestDelegate new];
+	_receiver = [_server sessionWithNickname:@"receiver"
+								   eventLoop:nil];
+	_receiver.delegate = _receiverDelegate;
+	_receiver.DCCAddress = @"127.0.0.1";
+	[_sender connect];
+	[_receiver connect];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (   _senderDelegate.connectionCount == 1
+				&& _receiverDelegate.connectionCount == 1);
+	}));
+
+	// A file of a few megabytes (and an odd length), with a space in its
+	// name (which is quoted in DCC requests).
+	_directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+	XCTAssertTrue([[NSFileManager defaultManager] createDirectoryAtPath:_directory
+											withIntermediateDirectories:YES
+															 attributes:nil
+																  error:NULL]);
+	_sourcePath = [_directory stringByAppendingPathComponent:@"logs 2021.tar"];
+	_destinationPath = [_directory stringByAppendingPathComponent:@"received.tar"];
+	_contents = IRCClientDCCTransferTestsRandomData(4 * 1024 * 1024 + 123);
+	XCTAssertTrue([_contents writeToFile:_sourcePath
+							  atomically:NO]);
+
+	_finishedTransfers = [NSMutableArray array];
+	_failedTransfers = [NSMutableArray array];
+}
+
+-(void) tearDown {
+	[_sender disconnect];
+	[_receiver disconnect];
+	[_server stop];
+	_sender = nil;
+	_receiver = nil;
+	_server = nil;
+
+	[[NSFileManager defaultManager] removeItemAtPath:_directory
+											   error:NULL];
+}
+
+/****************************/
+#pragma mark - Helper methods
+/****************************/
+
+// Has the receiver accept whatever it’s offered, into the destination file.
+-(void) acceptOffersResuming:(BOOL)resume {
+	__weak typeof(self) weakSelf = self;
+	NSString *destinationPath = _destinationPath;
+	_receiverDelegate.fileTransferOfferHandler = ^(IRCClientDCCTransfer *transfer,
+												   IRCClientSession *session) {
+		typeof(self) strongSelf = weakSelf;
+		@synchronized (strongSelf) {
+			strongSelf->_offeredTransfer = transfer;
+		}
+		transfer.delegate = strongSelf;
+		[session acceptTransfer:transfer
+						   path:destinationPath
+						 resume:resume];
+	};
+}
+
+-(IRCClientDCCTransfer *) offeredTransfer {
+	@synchronized (self) {
+		return _offeredTransfer;
+	}
+}
+
+-(NSUInteger) offerCount {
+	@synchronized (self) {
+		return _offerCount;
+	}
+}
+
+-(BOOL) hasFinished:(IRCClientDCCTransfer *)transfer {
+	@synchronized (self) {
+		return [_finishedTransfers containsObject:transfer];
+	}
+}
+
+-(BOOL) hasFailed:(IRCClientDCCTransfer *)transfer {
+	@synchronized (self) {
+		return [_failedTransfers containsObject:transfer];
+	}
+}
+
+// Waits for both ends of the transfer to finish; then checks that the whole
+// file arrived, starting from the given position.
+-(void) checkTransfer:(IRCClientDCCTransfer *)sending
+		 fromPosition:(uint64_t)startPosition {
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (   self.offeredTransfer != nil
+				&& [self hasFinished:sending]
+				&& [self hasFinished:self.offeredTransfer]);
+	}));
+	IRCClientDCCTransfer *receiving = self.offeredTransfer;
+
+	XCTAssertEqualObjects([NSData dataWithContentsOfFile:_destinationPath], _contents);
+
+	XCTAssertEqualObjects(receiving.filename, [@"logs 2021.tar" dataUsingEncoding:NSUTF8StringEncoding]);
+	XCTAssertEqualObjects(receiving.nick, [@"sender" dataUsingEncoding:NSUTF8StringEncoding]);
+	XCTAssertEqual(receiving.size, (uint64_t) _contents.length);
+	for (IRCClientDCCTransfer *transfer in @[ sending, receiving ]) {
+		XCTAssertEqual(transfer.state, IRCClientDCCTransferFinished);
+		XCTAssertEqual(transfer.startPosition, startPosition);
+		XCTAssertEqual(transfer.position, (uint64_t) _contents.length);
+		XCTAssertGreaterThan(transfer.throughput, 0.0);
+		XCTAssertGreaterThan(transfer.duration, 0.0);
+		XCTAssertNil(transfer.error);
+	}
+}
+
+/******************************************/
+#pragma mark - IRCClientDCCTransferDelegate
+/******************************************/
+
+-(void) transferFinished:(IRCClientDCCTransfer *)transfer {
+	@synchronized (self) {
+		[_finishedTransfers addObject:transfer];
+	}
+}
+
+-(void) transfer:(IRCClientDCCTransfer *)transfer
+didFailWithError:(NSError *)error {
+	@synchronized (self) {
+		[_failedTransfers addObject:transfer];
+	}
+}
+
+/*******************/
+#pragma mark - Tests
+/*******************/
+
+-(void) testFileIsSent {
+	[self acceptOffersResuming:NO];
+
+	IRCClientDCCTransfer *sending = [_sender sendFile:_sourcePath
+												   to:[@"receiver" dataUsingEncoding:NSUTF8StringEncoding]
+											  passive:NO];
+	XCTAssertNotNil(sending);
+	sending.delegate = self;
+
+	[self checkTransfer:sending
+		   fromPosition:0];
+	XCTAssertFalse(self.offeredTransfer.passive);
+	XCTAssertGreaterThan(self.offeredTransfer.remotePort, (NSUInteger) 0);
+	XCTAssertEqualObjects(self.offeredTransfer.remoteAddress, [@"127.0.0.1" dataUsingEncoding:NSUTF8StringEncoding]);
+}
+
+-(void) testFileIsSentPassively {
+	[self acceptOffersResuming:NO];
+
+	// The receiver listens, and the sender connects to it.
+	IRCClientDCCTransfer *sending = [_sender sendFile:_sourcePath
+												   to:[@"receiver" dataUsingEncoding:NSUTF8StringEncoding]
+											  passive:YES];
+	XCTAssertNotNil(sending);
+	sending.delegate = self;
+
+	[self checkTransfer:sending
+		   fromPosition:0];
+	XCTAssertTrue(sending.passive);
+	XCTAssertTrue(self.offeredTransfer.passive);
+}
+
+-(void) testInterruptedTransferIsResumed {
+	// Half of the file arrived before.
+	NSUInteger half = _contents.length / 2;
+	XCTAssertTrue([[_contents subdataWithRange:NSMakeRange(0, half)] writeToFile:_destinationPath
+																	 atomically:NO]);
+	[self acceptOffersResuming:YES];
+
+	IRCClientDCCTransfer *sending = [_sender sendFile:_sourcePath
+												   to:[@"receiver" dataUsingEncoding:NSUTF8StringEncoding]
+											  passive:NO];
+	XCTAssertNotNil(sending);
+	sending.delegate = self;
+
+	// Only the rest was sent (after a DCC RESUME, and a DCC ACCEPT).
+	[self checkTransfer:sending
+		   fromPosition:half];
+}
+
+-(void) testPassiveTransferIsResumed {
+	NSUInteger half = _contents.length / 2;
+	XCTAssertTrue([[_contents subdataWithRange:NSMakeRange(0, half)] writeToFile:_destinationPath
+																	 atomically:NO]);
+	[self acceptOffersResuming:YES];
+
+	IRCClientDCCTransfer *sending = [_sender sendFile:_sourcePath
+												   to:[@"receiver" dataUsingEncoding:NSUTF8StringEncoding]
+											  passive:YES];
+	XCTAssertNotNil(sending);
+	sending.delegate = self;
+
+	[self checkTransfer:sending
+		   fromPosition:half];
+}
+
+-(void) testCancelledOfferFails {
+	// The receiver is offered the file, but doesn’t take it.
+	__weak typeof(self) weakSelf = self;
+	_receiverDelegate.fileTransferOfferHandler = ^(IRCClientDCCTransfer *transfer,
+												   IRCClientSession *session) {
+		typeof(self) strongSelf = weakSelf;
+		@synchronized (strongSelf) {
+			strongSelf->_offeredTransfer = transfer;
+		}
+	};
+
+	IRCClientDCCTransfer *sending = [_sender sendFile:_sourcePath
+												   to:[@"receiver" dataUsingEncoding:NSUTF8StringEncoding]
+											  passive:NO];
+	XCTAssertNotNil(sending);
+	sending.delegate = self;
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (self.offeredTransfer != nil);
+	}));
+
+	[sending cancel];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return [self hasFailed:sending];
+	}));
+	XCTAssertEqual(sending.state, IRCClientDCCTransferFailed);
+	XCTAssertEqualObjects(sending.error.domain, NSPOSIXErrorDomain);
+	XCTAssertEqual(sending.error.code, ECANCELED);
+	XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:_destinationPath]);
+}
+
+-(void) testOffersPastTheLimitAreIgnored {
+	// The receiver is offered the file, over and over, and doesn’t take it.
+	__weak typeof(self) weakSelf = self;
+	_receiverDelegate.fileTransferOfferHandler = ^(IRCClientDCCTransfer *transfer,
+												   IRCClientSession *session) {
+		typeof(self) strongSelf = weakSelf;
+		@synchronized (strongSelf) {
+			strongSelf->_offerCount++;
+		}
+	};
+
+	// (Faster than flood control would let the offers go otherwise.)
+	_sender.floodControlBurst = 10;
+	for (NSUInteger i = 0; i < 6; i++)
+		XCTAssertNotNil([_sender sendFile:_sourcePath
+									   to:[@"receiver" dataUsingEncoding:NSUTF8StringEncoding]
+								  passive:YES]);
+
+	// Only 4 offers from one user may wait at once.
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (self.offerCount == 4);
+	}));
+	[NSThread sleepForTimeInterval:0.5];
+	XCTAssertEqual(self.offerCount, (NSUInteger) 4);
+}
+
+-(void) testFileThatCannotBeOpenedIsNotOffered {
+	XCTAssertNil([_sender sendFile:[_directory stringByAppendingPathComponent:@"missing"]
+								to:[@"receiver" dataUsingEncoding:NSUTF8StringEncoding]
+						   passive:NO]);
+}
+
+-(void) testActiveOfferNeedsADCCAddress {
+	_sender.DCCAddress = nil;
+	XCTAssertNil([_sender sendFile:_sourcePath
+								to:[@"receiver" dataUsingEncoding:NSUTF8StringEncoding]
+						   passive:NO]);
+	XCTAssertNotNil([_sender sendFile:_sourcePath
+								   to:[@"receiver" dataUsingEncoding:NSUTF8StringEncoding]
+							  passive:YES]);
+}
+
+@end
@@ -0,0 +1,353 @@
+//
+//	IRCClientEventBatchTests.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <XCTest/XCTest.h>
+
+#import "IRCClientSession.h"
+#import "IRCClientEventBatch.h"
+#import "IRCClientEventBatch_Private.h"
+#import "IRCClientTestServer.h"
+#import "IRCClientTestDelegate.h"
+
+/****************************/
+#pragma mark Helper functions
+/****************************/
+
+static NSData *IRCClientEventBatchTestsData(NSString *string) {
+	return [string dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+static NSString *IRCClientEventBatchTestsString(NSData *data) {
+	return (data != nil
+			? [[NSString alloc] initWithData:data
+									encoding:NSUTF8StringEncoding]
+			: nil);
+}
+
+/****************************************************************/
+#pragma mark - IRCClientEventBatchTestsDelegate class declaration
+/****************************************************************/
+
+// A test delegate that takes batches (and keeps them).
+@interface IRCClientEventBatchTestsDelegate : IRCClientTestDelegate
+
+/**	The batches received with -[eventsReceived:session:]. */
+@property (readonly) NSArray <IRCClientEventBatch *> *eventBatches;
+
+/**	The batches received with -[batchReceived:session:]. */
+@property (readonly) NSArray <IRCClientEventBatch *> *batches;
+
+@end
+
+/*******************************************************************/
+#pragma mark - IRCClientEventBatchTestsDelegate class implementation
+/*******************************************************************/
+
+@implementation IRCClientEventBatchTestsDelegate {
+	// These are guarded by @synchronized (self).
+	NSMutableArray <IRCClientEventBatch *> *_eventBatches;
+	NSMutableArray <IRCClientEventBatch *> *_batches;
+}
+
+-(instancetype) init {
+	if (!(self = [super init]))
+		return nil;
+
+	_eventBatches = [NSMutableArray array];
+	_batches = [NSMutableArray array];
+
+	return self;
+}
+
+-(NSArray <IRCClientEventBatch *> *) eventBatches {
+	@synchronized (self) {
+		return [_eventBatches copy];
+	}
+}
+
+-(NSArray <IRCClientEventBatch *> *) batches {
+	@synchronized (self) {
+		return [_batches copy];
+	}
+}
+
+-(void) eventsReceived:(IRCClientEventBatch *)batch
+			   session:(IRCClientSession *)session {
+	@synchronized (self) {
+		[_eventBatches addObject:batch];
+	}
+}
+
+-(void) batchReceived:(IRCClientEventBatch *)batch
+			  session:(IRCClientSession *)session {
+	@synchronized (self) {
+		[_batches addObject:batch];
+	}
+}
+
+@end
+
+/***********************************************************/
+#pragma mark - IRCClientEventBatchTests class implementation
+/***********************************************************/
+
+@interface IRCClientEventBatchTests : XCTestCase
+
+@end
+
+@implementation IRCClientEventBatchTests {
+	IRCClientTestServer *_server;
+	IRCClientEventBatchTestsDelegate *_delegate;
+	IRCClientSession *_session;
+	IRCClientTestConnection *_connection;
+}
+
+-(void) tearDown {
+	[_session disconnect];
+	[_server stop];
+	_session = nil;
+	_server = nil;
+}
+
+/****************************/
+#pragma mark - Helper methods
+/****************************/
+
+-(void) connectBatchingEvents:(BOOL)batchesEvents {
+	_server = [IRCClientTestServer new];
+	XCTAssertTrue([_server start]);
+
+	_delegate = [IRCClientEventBatchTestsDelegate new];
+	_session = [_server sessionWithNickname:@"batcher"
+								  eventLoop:nil];
+	_session.delegate = _delegate;
+	_session.batchesEvents = batchesEvents;
+	[_session connect];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (_delegate.connectionCount == 1);
+	}));
+
+	_connection = [_server connectionForNick:@"batcher"];
+	XCTAssertNotNil(_connection);
+}
+
+// Sends the lines to the session all at once.
+-(void) sendLines:(NSArray <NSString *> *)lines {
+	NSMutableData *data = [NSMutableData data];
+	for (NSString *line in lines)
+		[data appendData:IRCClientEventBatchTestsData([line stringByAppendingString:@"\r\n"])];
+	[_connection sendData:data];
+}
+
+// Returns the given number of private messages to the session.
+-(NSArray <NSString *> *) privateMessages:(NSUInteger)count {
+	NSMutableArray <NSString *> *lines = [NSMutableArray array];
+	for (NSUInteger i = 0; i < count; i++)
+		[lines addObject:[NSString stringWithFormat:@":friend!user@host PRIVMSG batcher :Message %lu", (unsigned long) i]];
+
+	return lines;
+}
+
+// Returns the messages (in all of the delegate’s event batches) with the
+// given command.
+-(NSArray <NSString *> *) batchedMessagesWithCommand:(NSString *)command {
+	NSMutableArray <NSString *> *messages = [NSMutableArray array];
+	for (IRCClientEventBatch *batch in _delegate.eventBatches)
+		for (NSUInteger i = 0; i < batch.count; i++)
+			if ([IRCClientEventBatchTestsString([batch commandOfMessageAtIndex:i]) isEqualToString:command])
+				[messages addObject:IRCClientEventBatchTestsString([batch messageAtIndex:i])];
+
+	return messages;
+}
+
+/*************************/
+#pragma mark - Batch tests
+/*************************/
+
+-(void) testMessagesAreKeptWithTheirParts {
+	IRCClientEventBatch *batch = [[IRCClientEventBatch alloc] initWithCapacity:2];
+	for (NSString *line in @[ @"@time=2021-01-01T00:00:00.000Z;msgid=a\\:b :nick!user@host PRIVMSG #channel :Hello",
+							  @"PING :irc.test" ]) {
+		NSData *data = IRCClientEventBatchTestsData(line);
+		IRCClientMessage message;
+		XCTAssertTrue(IRCClientMessageParse(data.bytes, data.length, &message));
+		[batch addMessage:&message];
+	}
+
+	XCTAssertEqual(batch.count, (NSUInteger) 2);
+	XCTAssertNil(batch.batchType);
+
+	XCTAssertEqualObjects(IRCClientEventBatchTestsString([batch prefixOfMessageAtIndex:0]), @"nick!user@host");
+	XCTAssertEqualObjects(IRCClientEventBatchTestsString([batch commandOfMessageAtIndex:0]), @"PRIVMSG");
+	XCTAssertEqualObjects([batch paramsOfMessageAtIndex:0],
+						  (@[ IRCClientEventBatchTestsData(@"#channel"), IRCClientEventBatchTestsData(@"Hello") ]));
+	XCTAssertEqualObjects(IRCClientEventBatchTestsString([batch valueOfTag:IRCClientEventBatchTestsData(@"msgid")
+														  ofMessageAtIndex:0]), @"a;b");
+	XCTAssertNil([batch valueOfTag:IRCClientEventBatchTestsData(@"account")
+				  ofMessageAtIndex:0]);
+
+	XCTAssertNil([batch prefixOfMessageAtIndex:1]);
+	XCTAssertEqualObjects(IRCClientEventBatchTestsString([batch messageAtIndex:1]), @"PING :irc.test");
+	XCTAssertNil([batch valueOfTag:IRCClientEventBatchTestsData(@"time")
+				  ofMessageAtIndex:1]);
+
+	// (The messages are one after another.)
+	NSRange second = [batch rangeOfMessageAtIndex:1];
+	XCTAssertEqual(NSMaxRange(second), batch.bytes.length);
+	XCTAssertEqual(second.location, NSMaxRange([batch rangeOfMessageAtIndex:0]));
+}
+
+-(void) testMessagesSurviveTheBatchGrowing {
+	// (The bytes are reallocated many times over.)
+	IRCClientEventBatch *batch = [IRCClientEventBatch new];
+	for (NSUInteger i = 0; i < 1000; i++) {
+		NSData *data = IRCClientEventBatchTestsData([NSString stringWithFormat:@":nick%lu!user@host PRIVMSG #channel :Message %lu", (unsigned long) i, (unsigned long) i]);
+		IRCClientMessage message;
+		XCTAssertTrue(IRCClientMessageParse(data.bytes, data.length, &message));
+		[batch addMessage:&message];
+	}
+
+	XCTAssertEqual(batch.count, (NSUInteger) 1000);
+	for (NSUInteger i = 0; i < 1000; i += 111) {
+		XCTAssertEqualObjects(IRCClientEventBatchTestsString([batch prefixOfMessageAtIndex:i]),
+							  ([NSString stringWithFormat:@"nick%lu!user@host", (unsigned long) i]));
+		XCTAssertEqualObjects([batch paramsOfMessageAtIndex:i].lastObject,
+							  IRCClientEventBatchTestsData([NSString stringWithFormat:@"Message %lu", (unsigned long) i]));
+	}
+}
+
+-(void) testIndexPastTheEndIsAnError {
+	IRCClientEventBatch *batch = [IRCClientEventBatch new];
+
+	XCTAssertEqual(batch.count, (NSUInteger) 0);
+	XCTAssertThrowsSpecificNamed([batch messageAtIndex:0], NSException, NSRangeException);
+	XCTAssertThrowsSpecificNamed([batch commandOfMessageAtIndex:NSUIntegerMax], NSException, NSRangeException);
+}
+
+/****************************/
+#pragma mark - Delivery tests
+/****************************/
+
+-(void) testEventsAreDeliveredInBatches {
+	[self connectBatchingEvents:YES];
+	NSUInteger eventBatchCount = _delegate.eventBatches.count;
+
+	[self sendLines:[self privateMessages:20]];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return ([self batchedMessagesWithCommand:@"PRIVMSG"].count == 20);
+	}));
+
+	// (Fewer calls than messages, in order, and none of them one by one.)
+	XCTAssertLessThan(_delegate.eventBatches.count - eventBatchCount, (NSUInteger) 20);
+	XCTAssertEqualObjects([self batchedMessagesWithCommand:@"PRIVMSG"], [self privateMessages:20]);
+	XCTAssertEqual(_delegate.privateMessageCount, (NSUInteger) 0);
+}
+
+-(void) testBatchesAreNoLargerThanTheLimit {
+	[self connectBatchingEvents:YES];
+	_session.eventBatchLimit = 4;
+
+	[self sendLines:[self privateMessages:30]];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return ([self batchedMessagesWithCommand:@"PRIVMSG"].count == 30);
+	}));
+
+	for (IRCClientEventBatch *batch in _delegate.eventBatches)
+		XCTAssertLessThanOrEqual(batch.count, (NSUInteger) 4);
+}
+
+-(void) testSessionStillActsOnBatchedMessages {
+	[self connectBatchingEvents:YES];
+
+	[self sendLines:@[ @"PING :token" ]];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return ([_server receivedLinesWithCommand:@"PONG"].count == 1);
+	}));
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return ([self batchedMessagesWithCommand:@"PING"].count == 1);
+	}));
+}
+
+-(void) testDelegateThatDoesNotTakeBatchesGetsEvents {
+	_server = [IRCClientTestServer new];
+	XCTAssertTrue([_server start]);
+	IRCClientTestDelegate *delegate = [IRCClientTestDelegate new];
+	_session = [_server sessionWithNickname:@"batcher"
+								  eventLoop:nil];
+	_session.batchesEvents = YES;
+	_session.delegate = delegate;
+	[_session connect];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (delegate.connectionCount == 1);
+	}));
+
+	XCTAssertTrue([delegate sendLines:[self privateMessages:3]
+						 toConnection:[_server connectionForNick:@"batcher"]]);
+	XCTAssertEqual(delegate.privateMessageCount, (NSUInteger) 4);
+}
+
+-(void) testTurningBatchingOffDeliversEventsAgain {
+	[self connectBatchingEvents:YES];
+	_session.batchesEvents = NO;
+
+	XCTAssertTrue([_delegate sendLines:[self privateMessages:3]
+						  toConnection:_connection]);
+	XCTAssertEqual(_delegate.privateMessageCount, (NSUInteger) 4);
+	XCTAssertEqual([self batchedMessagesWithCommand:@"PRIVMSG"].count, (NSUInteger) 0);
+}
+
+/*******************************/
+#pragma mark - IRCv3 batch tests
+/*******************************/
+
+-(void) testIRCv3BatchIsGatheredUp {
+	[self connectBatchingEvents:NO];
+
+	XCTAssertTrue([_delegate sendLines:@[ @":irc.test BATCH +split netsplit irc1.test irc2.test",
+										  @"@batch=split :a!user@host QUIT :irc1.test irc2.test",
+										  @"@batch=split :b!user@host QUIT :irc1.test irc2.test",
+										  @":irc.test BATCH -split" ]
+						  toConnection:_connection]);
+
+	XCTAssertEqual(_delegate.batches.count, (NSUInteger) 1);
+	IRCClientEventBatch *batch = _delegate.batches.firstObject;
+	XCTAssertEqualObjects(IRCClientEventBatchTestsString(batch.batchType), @"netsplit");
+	XCTAssertEqualObjects(batch.batchParams,
+						  (@[ IRCClientEventBatchTestsData(@"irc1.test"), IRCClientEventBatchTestsData(@"irc2.test") ]));
+	XCTAssertEqual(batch.count, (NSUInteger) 2);
+	XCTAssertEqualObjects(IRCClientEventBatchTestsString([batch prefixOfMessageAtIndex:1]), @"b!user@host");
+}
+
+-(void) testBatchesMayBeNested {
+	[self connectBatchingEvents:NO];
+
+	XCTAssertTrue([_delegate sendLines:@[ @":irc.test BATCH +outer netsplit irc1.test irc2.test",
+										  @"@batch=outer :irc.test BATCH +inner netjoin irc1.test irc2.test",
+										  @"@batch=inner :a!user@host JOIN #channel",
+										  @":irc.test BATCH -inner",
+										  @":irc.test BATCH -outer" ]
+						  toConnection:_connection]);
+
+	NSArray <IRCClientEventBatch *> *batches = _delegate.batches;
+	XCTAssertEqual(batches.count, (NSUInteger) 2);
+	XCTAssertEqualObjects(IRCClientEventBatchTestsString(batches[0].batchType), @"netjoin");
+	XCTAssertEqual(batches[0].count, (NSUInteger) 1);
+	XCTAssertEqualObjects(IRCClientEventBatchTestsString(batches[1].batchType), @"netsplit");
+}
+
+-(void) testUnmatchedBatchEndIsIgnored {
+	[self connectBatchingEvents:NO];
+
+	XCTAssertTrue([_delegate sendLines:@[ @":irc.test BATCH -nothing", @":irc.test BATCH", @":irc.test BATCH +" ]
+						  toConnection:_connection]);
+
+	XCTAssertEqual(_delegate.batches.count, (NSUInteger) 0);
+}
+
+@end
@@ -0,0 +1,306 @@
+//
+//	IRCClientEventFilterTests.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <XCTest/XCTest.h>
+
+#import "IRCClientSession.h"
+#import "IRCClientEventFilter.h"
+#import "IRCClientEventMatcher.h"
+#import "IRCClientCaseMapping.h"
+#import "IRCClientTestServer.h"
+#import "IRCClientTestDelegate.h"
+
+/****************************/
+#pragma mark Helper functions
+/****************************/
+
+static NSData *IRCClientEventFilterTestsData(NSString *string) {
+	return [string dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+static NSSet <NSData *> *IRCClientEventFilterTestsSet(NSArray <NSString *> *strings) {
+	NSMutableSet <NSData *> *set = [NSMutableSet set];
+	for (NSString *string in strings)
+		[set addObject:IRCClientEventFilterTestsData(string)];
+
+	return set;
+}
+
+static NSArray <NSData *> *IRCClientEventFilterTestsArray(NSArray <NSString *> *strings) {
+	NSMutableArray <NSData *> *array = [NSMutableArray array];
+	for (NSString *string in strings)
+		[array addObject:IRCClientEventFilterTestsData(string)];
+
+	return array;
+}
+
+/************************************************************/
+#pragma mark - IRCClientEventFilterTests class implementation
+/************************************************************/
+
+@interface IRCClientEventFilterTests : XCTestCase
+
+@end
+
+@implementation IRCClientEventFilterTests {
+	IRCClientEventMatcher *_matcher;
+
+	IRCClientTestServer *_server;
+	IRCClientTestDelegate *_delegate;
+	IRCClientSession *_session;
+	IRCClientTestConnection *_connection;
+}
+
+-(void) tearDown {
+	[_session disconnect];
+	[_server stop];
+	_session = nil;
+	_server = nil;
+}
+
+/****************************/
+#pragma mark - Helper methods
+/****************************/
+
+-(void) compileFilters:(NSArray <IRCClientEventFilter *> *)filters {
+	uint8_t caseFold[256];
+	IRCClientCaseFoldTableInit(caseFold, IRCClientCaseMappingRFC1459);
+
+	_matcher = [[IRCClientEventMatcher alloc] initWithFilters:filters
+													 caseFold:caseFold];
+}
+
+-(BOOL) matches:(NSString *)line {
+	NSData *data = IRCClientEventFilterTestsData(line);
+	IRCClientMessage message;
+	XCTAssertTrue(IRCClientMessageParse(data.bytes, data.length, &message), @"%@", line);
+
+	return [_matcher matchesMessage:&message];
+}
+
+-(void) connectWithFilters:(NSArray <IRCClientEventFilter *> *)filters {
+	_server = [IRCClientTestServer new];
+	XCTAssertTrue([_server start]);
+
+	_delegate = [IRCClientTestDelegate new];
+	_session = [_server sessionWithNickname:@"filtered"
+								  eventLoop:nil];
+	_session.delegate = _delegate;
+	_session.eventFilters = filters;
+	[_session connect];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (_delegate.connectionCount == 1);
+	}));
+
+	_connection = [_server connectionForNick:@"filtered"];
+	XCTAssertNotNil(_connection);
+
+	// (So that the rest of registration has been handled, and counted.)
+	XCTAssertTrue([_delegate sendLines:@[]
+						  toConnection:_connection]);
+}
+
+// A filter that passes the test server’s own messages (so that
+// -[IRCClientTestDelegate sendLines:toConnection:] works).
+-(IRCClientEventFilter *) serverFilter {
+	IRCClientEventFilter *filter = [IRCClientEventFilter filter];
+	filter.origins = IRCClientEventFilterTestsArray(@[ @"irc.test" ]);
+
+	return filter;
+}
+
+/*****************************/
+#pragma mark - Criterion tests
+/*****************************/
+
+-(void) testFilterWithNoCriteriaPassesEverything {
+	[self compileFilters:@[ [IRCClientEventFilter filter] ]];
+
+	XCTAssertTrue([self matches:@":nick!user@host PRIVMSG #channel :Hello"]);
+	XCTAssertTrue([self matches:@"PING :irc.test"]);
+	XCTAssertTrue([self matches:@":irc.test 001 nick :Welcome"]);
+}
+
+-(void) testNoFiltersPassNothing {
+	[self compileFilters:@[]];
+
+	XCTAssertFalse([self matches:@":nick!user@host PRIVMSG #channel :Hello"]);
+}
+
+-(void) testCommandsAreMatchedCaseInsensitively {
+	IRCClientEventFilter *filter = [IRCClientEventFilter filter];
+	filter.commands = IRCClientEventFilterTestsSet(@[ @"privmsg", @"332", @"WALLOPS" ]);
+	[self compileFilters:@[ filter ]];
+
+	XCTAssertTrue([self matches:@":nick!user@host PRIVMSG #channel :Hello"]);
+	XCTAssertTrue([self matches:@":irc.test 332 nick #channel :Topic"]);
+	XCTAssertTrue([self matches:@":nick!user@host WALLOPS :Hello"]);
+	XCTAssertTrue([self matches:@":nick!user@host wallops :Hello"]);
+
+	XCTAssertFalse([self matches:@":nick!user@host NOTICE #channel :Hello"]);
+	XCTAssertFalse([self matches:@":irc.test 333 nick #channel someone 0"]);
+	XCTAssertFalse([self matches:@":nick!user@host GLOBOPS :Hello"]);
+}
+
+-(void) testTargetsAreMatchedAsTheServerComparesThem {
+	IRCClientEventFilter *filter = [IRCClientEventFilter filter];
+	filter.targets = IRCClientEventFilterTestsSet(@[ @"#Channel[1]", @"me" ]);
+	[self compileFilters:@[ filter ]];
+
+	XCTAssertTrue([self matches:@":nick!user@host PRIVMSG #channel{1} :Hello"]);
+	XCTAssertTrue([self matches:@":nick!user@host PRIVMSG ME :Hello"]);
+
+	// (Any of a list of targets will do.)
+	XCTAssertTrue([self matches:@":nick!user@host PRIVMSG #other,#CHANNEL[1] :Hello"]);
+
+	XCTAssertFalse([self matches:@":nick!user@host PRIVMSG #channel[1]2 :Hello"]);
+	XCTAssertFalse([self matches:@":nick!user@host PRIVMSG #other,#another :Hello"]);
+	XCTAssertFalse([self matches:@":nick!user@host QUIT"]);
+}
+
+-(void) testOriginsAreMatchedByMask {
+	IRCClientEventFilter *filter = [IRCClientEventFilter filter];
+	filter.origins = IRCClientEventFilterTestsArray(@[ @"*!*@*.Example.com", @"?ick!*@*" ]);
+	[self compileFilters:@[ filter ]];
+
+	XCTAssertTrue([self matches:@":someone!user@host.EXAMPLE.com PRIVMSG me :Hello"]);
+	XCTAssertTrue([self matches:@":nick!user@host.example.org PRIVMSG me :Hello"]);
+	XCTAssertTrue([self matches:@":Rick!user@host.example.org PRIVMSG me :Hello"]);
+
+	XCTAssertFalse([self matches:@":someone!user@example.com PRIVMSG me :Hello"]);
+	XCTAssertFalse([self matches:@":snick!user@host.example.org PRIVMSG me :Hello"]);
+
+	// (A message without a prefix has no sender to match.)
+	XCTAssertFalse([self matches:@"PRIVMSG me :Hello"]);
+}
+
+-(void) testMaskBacktracks {
+	IRCClientEventFilter *filter = [IRCClientEventFilter filter];
+	filter.origins = IRCClientEventFilterTestsArray(@[ @"*a*b" ]);
+	[self compileFilters:@[ filter ]];
+
+	XCTAssertTrue([self matches:@":xaxxabxb PING"]);
+	XCTAssertTrue([self matches:@":ab PING"]);
+	XCTAssertFalse([self matches:@":xaxxbx PING"]);
+	XCTAssertFalse([self matches:@":bbb PING"]);
+}
+
+-(void) testTextIsMatchedExactly {
+	IRCClientEventFilter *filter = [IRCClientEventFilter filter];
+	filter.text = IRCClientEventFilterTestsData(@"urgent");
+	[self compileFilters:@[ filter ]];
+
+	XCTAssertTrue([self matches:@":nick!user@host PRIVMSG #channel :this is urgent!"]);
+	XCTAssertTrue([self matches:@":nick!user@host PRIVMSG #channel urgently"]);
+
+	XCTAssertFalse([self matches:@":nick!user@host PRIVMSG #channel :URGENT"]);
+	XCTAssertFalse([self matches:@":nick!user@host PRIVMSG urgent :not here"]);
+	XCTAssertFalse([self matches:@":nick!user@host QUIT"]);
+}
+
+/*******************************/
+#pragma mark - Combination tests
+/*******************************/
+
+-(void) testFilterNeedsEveryCriterion {
+	IRCClientEventFilter *filter = [IRCClientEventFilter filter];
+	filter.commands = IRCClientEventFilterTestsSet(@[ @"PRIVMSG" ]);
+	filter.targets = IRCClientEventFilterTestsSet(@[ @"#channel" ]);
+	filter.origins = IRCClientEventFilterTestsArray(@[ @"friend!*@*" ]);
+	filter.text = IRCClientEventFilterTestsData(@"!");
+	[self compileFilters:@[ filter ]];
+
+	XCTAssertTrue([self matches:@":friend!user@host PRIVMSG #channel :Hello!"]);
+
+	XCTAssertFalse([self matches:@":friend!user@host NOTICE #channel :Hello!"]);
+	XCTAssertFalse([self matches:@":friend!user@host PRIVMSG #other :Hello!"]);
+	XCTAssertFalse([self matches:@":stranger!user@host PRIVMSG #channel :Hello!"]);
+	XCTAssertFalse([self matches:@":friend!user@host PRIVMSG #channel :Hello"]);
+}
+
+-(void) testAnyFilterWillDo {
+	IRCClientEventFilter *commandFilter = [IRCClientEventFilter filter];
+	commandFilter.commands = IRCClientEventFilterTestsSet(@[ @"NOTICE" ]);
+	IRCClientEventFilter *targetFilter = [IRCClientEventFilter filter];
+	targetFilter.targets = IRCClientEventFilterTestsSet(@[ @"#channel" ]);
+	[self compileFilters:@[ commandFilter, targetFilter ]];
+
+	XCTAssertTrue([self matches:@":nick!user@host NOTICE #other :Hello"]);
+	XCTAssertTrue([self matches:@":nick!user@host PRIVMSG #channel :Hello"]);
+	XCTAssertFalse([self matches:@":nick!user@host PRIVMSG #other :Hello"]);
+}
+
+-(void) testFiltersAreCopied {
+	IRCClientEventFilter *filter = [IRCClientEventFilter filter];
+	filter.commands = IRCClientEventFilterTestsSet(@[ @"PRIVMSG" ]);
+	[self compileFilters:@[ filter ]];
+
+	filter.commands = IRCClientEventFilterTestsSet(@[ @"NOTICE" ]);
+
+	XCTAssertTrue([self matches:@":nick!user@host PRIVMSG #channel :Hello"]);
+	XCTAssertFalse([self matches:@":nick!user@host NOTICE #channel :Hello"]);
+	XCTAssertEqualObjects(_matcher.filters.firstObject.commands, IRCClientEventFilterTestsSet(@[ @"PRIVMSG" ]));
+}
+
+/***************************/
+#pragma mark - Session tests
+/***************************/
+
+-(void) testFilteredMessagesAreDroppedAndCounted {
+	IRCClientEventFilter *filter = [IRCClientEventFilter filter];
+	filter.origins = IRCClientEventFilterTestsArray(@[ @"friend!*@*" ]);
+	[self connectWithFilters:@[ filter, self.serverFilter ]];
+	NSUInteger privateMessageCount = _delegate.privateMessageCount;
+	NSUInteger matchedCount = _session.eventFilterMatchedCount;
+
+	XCTAssertTrue([_delegate sendLines:@[ @":friend!user@host PRIVMSG filtered :one",
+										  @":stranger!user@host PRIVMSG filtered :two",
+										  @":friend!user@host PRIVMSG filtered :three",
+										  @":stranger!user@host NOTICE filtered :four" ]
+						  toConnection:_connection]);
+
+	// (Two from friend, and the sync message from the server.)
+	XCTAssertEqual(_delegate.privateMessageCount - privateMessageCount, (NSUInteger) 3);
+	XCTAssertEqual(_session.eventFilterMatchedCount - matchedCount, (NSUInteger) 3);
+	XCTAssertEqual(_session.eventFilterDroppedCount, (NSUInteger) 2);
+}
+
+-(void) testSessionStillHandlesWhatItKeepsTrackOf {
+	[self connectWithFilters:@[ self.serverFilter ]];
+
+	// (PING isn’t subject to filtering.)
+	XCTAssertTrue([_delegate sendLines:@[ @":stranger!user@host PING :token" ]
+						  toConnection:_connection]);
+	XCTAssertEqual([_server receivedLinesWithCommand:@"PONG"].count, (NSUInteger) 1);
+	XCTAssertEqual(_session.eventFilterDroppedCount, (NSUInteger) 0);
+}
+
+-(void) testFilteredCTCPRequestIsNotAnswered {
+	[self connectWithFilters:@[ self.serverFilter ]];
+
+	XCTAssertTrue([_delegate sendLines:@[ @":stranger!user@host PRIVMSG filtered :\001VERSION\001" ]
+						  toConnection:_connection]);
+
+	XCTAssertEqual(_session.eventFilterDroppedCount, (NSUInteger) 1);
+	XCTAssertEqual([_server receivedLinesWithCommand:@"NOTICE"].count, (NSUInteger) 0);
+}
+
+-(void) testRemovingTheFiltersPassesEverything {
+	[self connectWithFilters:@[ self.serverFilter ]];
+	_session.eventFilters = nil;
+	NSUInteger privateMessageCount = _delegate.privateMessageCount;
+
+	XCTAssertTrue([_delegate sendLines:@[ @":stranger!user@host PRIVMSG filtered :Hello" ]
+						  toConnection:_connection]);
+
+	XCTAssertEqual(_delegate.privateMessageCount - privateMessageCount, (NSUInteger) 2);
+	XCTAssertEqual(_session.eventFilterDroppedCount, (NSUInteger) 0);
+}
+
+@end
@@ -0,0 +1,150 @@
+//
+//	IRCClientEventLoopTests.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <XCTest/XCTest.h>
+
+#import "IRCClientSession.h"
+#import "IRCClientEventLoop.h"
+#import "IRCClientEventLoop_Private.h"
+#import "IRCClientTestServer.h"
+#import "IRCClientTestDelegate.h"
+
+/********************************************************/
+#pragma mark IRCClientEventLoopTests class implementation
+/********************************************************/
+
+@interface IRCClientEventLoopTests : XCTestCase
+
+@end
+
+@implementation IRCClientEventLoopTests {
+	IRCClientTestServer *_server;
+}
+
+-(void) setUp {
+	_server = [IRCClientTestServer new];
+	XCTAssertTrue([_server start]);
+}
+
+-(void) tearDown {
+	[_server stop];
+	_server = nil;
+}
+
+-(void) testSessionsWithoutAnEventLoopHaveNone {
+	XCTAssertNil([IRCClientSession session].eventLoop);
+}
+
+-(void) testSessionsArePinnedToTheLoops {
+	static const NSUInteger SessionCount = 16;
+
+	IRCClientEventLoop *eventLoop = [[IRCClientEventLoop alloc] initWithThreadCount:2];
+	IRCClientTestDelegate *delegate = [IRCClientTestDelegate new];
+
+	// The loop that each session’s delegate is called on.
+	NSMapTable <IRCClientSession *, dispatch_queue_t> *loops = [NSMapTable strongToStrongObjectsMapTable];
+	delegate.connectionHandler = ^(IRCClientSession *session) {
+		dispatch_queue_t loop = IRCClientEventLoopCurrentQueue();
+		@synchronized (loops) {
+			if (loop != nil)
+				[loops setObject:loop
+						  forKey:session];
+		}
+	};
+
+	NSMutableArray <IRCClientSession *> *sessions = [NSMutableArray array];
+	for (NSUInteger i = 0; i < SessionCount; i++) {
+		IRCClientSession *session = [_server sessionWithNickname:[NSString stringWithFormat:@"pinned%lu", (unsigned long) i]
+													   eventLoop:eventLoop];
+		session.delegate = delegate;
+		XCTAssertEqual(session.eventLoop, eventLoop);
+		[sessions addObject:session];
+		[session connect];
+	}
+
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (delegate.connectionCount == SessionCount);
+	}));
+
+	// Every session was called on one of the pool’s two loops, and the
+	// sessions were spread over both of them.
+	NSMutableSet *distinctLoops = [NSMutableSet set];
+	@synchronized (loops) {
+		XCTAssertEqual(loops.count, SessionCount);
+		for (IRCClientSession *session in sessions)
+			[distinctLoops addObject:[loops objectForKey:session]];
+	}
+	XCTAssertEqual(distinctLoops.count, (NSUInteger) 2);
+
+	for (IRCClientSession *session in sessions)
+		[session disconnect];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (delegate.disconnectionCount == SessionCount);
+	}));
+}
+
+-(void) testEventsAreHandledInOrder {
+	static const NSUInteger SessionCount = 8;
+	static const NSUInteger MessageCount = 500;
+
+	// Fewer loops than sessions, so that the sessions have to share them.
+	IRCClientEventLoop *eventLoop = [[IRCClientEventLoop alloc] initWithThreadCount:2];
+	IRCClientTestDelegate *delegate = [IRCClientTestDelegate new];
+
+	NSMutableDictionary <NSData *, NSMutableArray <NSNumber *> *> *received = [NSMutableDictionary dictionary];
+	delegate.privateMessageHandler = ^(NSData *message, NSData *nick, IRCClientSession *session) {
+		NSString *text = [[NSString alloc] initWithData:message
+											   encoding:NSUTF8StringEncoding];
+		@synchronized (received) {
+			NSMutableArray <NSNumber *> *numbers = received[session.nickname];
+			if (numbers == nil)
+				numbers = received[session.nickname] = [NSMutableArray array];
+			[numbers addObject:@(text.integerValue)];
+		}
+	};
+
+	NSMutableArray <IRCClientSession *> *sessions = [NSMutableArray array];
+	for (NSUInteger i = 0; i < SessionCount; i++) {
+		IRCClientSession *session = [_server sessionWithNickname:[NSString stringWithFormat:@"ordered%lu", (unsigned long) i]
+													   eventLoop:eventLoop];
+		session.delegate = delegate;
+		[sessions addObject:session];
+		[session connect];
+	}
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (delegate.connectionCount == SessionCount);
+	}));
+
+	// Each session is sent its numbers in one go, interleaved with the others’.
+	for (NSUInteger i = 0; i < SessionCount; i++) {
+		NSString *nick = [NSString stringWithFormat:@"ordered%lu", (unsigned long) i];
+		NSMutableData *lines = [NSMutableData data];
+		for (NSUInteger n = 0; n < MessageCount; n++)
+			[lines appendData:[[NSString stringWithFormat:@":sender!sender@localhost PRIVMSG %@ :%lu\r\n", nick, (unsigned long) n] dataUsingEncoding:NSUTF8StringEncoding]];
+		[[_server connectionForNick:nick] sendData:lines];
+	}
+
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (delegate.privateMessageCount == SessionCount * MessageCount);
+	}));
+
+	NSMutableArray <NSNumber *> *expected = [NSMutableArray arrayWithCapacity:MessageCount];
+	for (NSUInteger n = 0; n < MessageCount; n++)
+		[expected addObject:@(n)];
+	@synchronized (received) {
+		XCTAssertEqual(received.count, SessionCount);
+		for (NSData *nick in received)
+			XCTAssertEqualObjects(received[nick], expected);
+	}
+
+	for (IRCClientSession *session in sessions)
+		[session disconnect];
+}
+
+@end
@@ -0,0 +1,259 @@
+//
+//	IRCClientIdentifierTests.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <XCTest/XCTest.h>
+
+#import "IRCClientSession.h"
+#import "IRCClientSession_Private.h"
+#import "IRCClientChannel.h"
+#import "IRCClientIdentifier.h"
+#import "IRCClientCaseMapping.h"
+#import "IRCClientTestServer.h"
+#import "IRCClientTestDelegate.h"
+
+/****************************/
+#pragma mark Helper functions
+/****************************/
+
+static IRCClientIdentifierPool *IRCClientIdentifierTestsPool(IRCClientCaseMapping mapping) {
+	uint8_t caseFold[256];
+	IRCClientCaseFoldTableInit(caseFold, mapping);
+
+	return [[IRCClientIdentifierPool alloc] initWithCaseFold:caseFold];
+}
+
+static IRCClientIdentifier *IRCClientIdentifierTestsIntern(IRCClientIdentifierPool *pool,
+														   NSString *name) {
+	return [pool identifierForBytes:(const uint8_t *) name.UTF8String
+							 length:strlen(name.UTF8String)];
+}
+
+static IRCClientIdentifier *IRCClientIdentifierTestsLookUp(IRCClientIdentifierPool *pool,
+														   NSString *name) {
+	return [pool existingIdentifierForBytes:(const uint8_t *) name.UTF8String
+									 length:strlen(name.UTF8String)];
+}
+
+/***********************************************************/
+#pragma mark - IRCClientIdentifierTests class implementation
+/***********************************************************/
+
+@interface IRCClientIdentifierTests : XCTestCase
+
+@end
+
+@implementation IRCClientIdentifierTests {
+	IRCClientTestServer *_server;
+	IRCClientTestDelegate *_delegate;
+	IRCClientSession *_session;
+	IRCClientTestConnection *_connection;
+}
+
+-(void) tearDown {
+	[_session disconnect];
+	[_server stop];
+	_session = nil;
+	_server = nil;
+}
+
+/****************************/
+#pragma mark - Helper methods
+/****************************/
+
+// Connects a session (as “watcher”) to a new test server, which sends the
+// given RPL_ISUPPORT tokens, and joins the channels; returns the channels.
+-(NSArray <IRCClientChannel *> *) connectWithSupportTokens:(NSArray <NSString *> *)supportTokens
+											  joinChannels:(NSArray <NSString *> *)channelNames {
+	_server = [IRCClientTestServer new];
+	_server.supportTokens = supportTokens;
+	XCTAssertTrue([_server start]);
+
+	_delegate = [IRCClientTestDelegate new];
+	_session = [_server sessionWithNickname:@"watcher"
+								  eventLoop:nil];
+	_session.delegate = _delegate;
+	[_session connect];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (_delegate.connectionCount == 1);
+	}));
+	_connection = [_server connectionForNick:@"watcher"];
+
+	for (NSString *channelName in channelNames)
+		[_session join:[channelName dataUsingEncoding:NSUTF8StringEncoding]
+				   key:nil];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (_delegate.joinedChannels.count == channelNames.count);
+	}));
+
+	return _delegate.joinedChannels;
+}
+
+-(void) send:(NSArray <NSString *> *)lines {
+	XCTAssertTrue([_delegate sendLines:lines
+						  toConnection:_connection]);
+}
+
+-(NSUInteger) memberCountOf:(IRCClientChannel *)channel {
+	__block NSUInteger memberCount;
+	[_session performOnSessionQueueAndWait:^{
+		memberCount = channel.memberCount;
+	}];
+
+	return memberCount;
+}
+
+/************************/
+#pragma mark - Pool tests
+/************************/
+
+-(void) testNamesAreInternedOnce {
+	IRCClientIdentifierPool *pool = IRCClientIdentifierTestsPool(IRCClientCaseMappingRFC1459);
+
+	IRCClientIdentifier *identifier = IRCClientIdentifierTestsIntern(pool, @"Nick[away]");
+	XCTAssertEqual(IRCClientIdentifierTestsIntern(pool, @"Nick[away]"), identifier);
+	XCTAssertEqual(IRCClientIdentifierTestsIntern(pool, @"nick{AWAY}"), identifier);
+	XCTAssertEqual(IRCClientIdentifierTestsLookUp(pool, @"NICK[away]"), identifier);
+	XCTAssertNotEqual(IRCClientIdentifierTestsIntern(pool, @"Nick"), identifier);
+
+	// The name is kept as first seen; the key is folded.
+	XCTAssertEqualObjects(identifier.name, [@"Nick[away]" dataUsingEncoding:NSUTF8StringEncoding]);
+	XCTAssertEqualObjects(identifier.key, [@"nick{away}" dataUsingEncoding:NSUTF8StringEncoding]);
+}
+
+-(void) testIdentifiersAreEqualOnlyToThemselves {
+	IRCClientIdentifierPool *pool = IRCClientIdentifierTestsPool(IRCClientCaseMappingRFC1459);
+	IRCClientIdentifier *identifier = IRCClientIdentifierTestsIntern(pool, @"alice");
+	IRCClientIdentifier *other = IRCClientIdentifierTestsIntern(IRCClientIdentifierTestsPool(IRCClientCaseMappingRFC1459), @"alice");
+
+	XCTAssertEqualObjects(identifier, IRCClientIdentifierTestsIntern(pool, @"ALICE"));
+	XCTAssertEqual(identifier.hash, other.hash);
+	XCTAssertNotEqualObjects(identifier, other);
+	XCTAssertEqual([identifier copy], identifier);
+}
+
+-(void) testFoldingFollowsTheCaseMapping {
+	IRCClientIdentifierPool *rfc1459 = IRCClientIdentifierTestsPool(IRCClientCaseMappingRFC1459);
+	XCTAssertEqual(IRCClientIdentifierTestsIntern(rfc1459, @"a[b]\\^"),
+				   IRCClientIdentifierTestsIntern(rfc1459, @"A{B}|~"));
+
+	IRCClientIdentifierPool *strict = IRCClientIdentifierTestsPool(IRCClientCaseMappingStrictRFC1459);
+	XCTAssertEqual(IRCClientIdentifierTestsIntern(strict, @"a[b]\\"),
+				   IRCClientIdentifierTestsIntern(strict, @"A{B}|"));
+	XCTAssertNotEqual(IRCClientIdentifierTestsIntern(strict, @"a^"),
+					  IRCClientIdentifierTestsIntern(strict, @"a~"));
+
+	IRCClientIdentifierPool *ascii = IRCClientIdentifierTestsPool(IRCClientCaseMappingASCII);
+	XCTAssertEqual(IRCClientIdentifierTestsIntern(ascii, @"Alice"),
+				   IRCClientIdentifierTestsIntern(ascii, @"aLICE"));
+	XCTAssertNotEqual(IRCClientIdentifierTestsIntern(ascii, @"a[b]"),
+					  IRCClientIdentifierTestsIntern(ascii, @"a{b}"));
+}
+
+-(void) testLookingUpDoesNotIntern {
+	IRCClientIdentifierPool *pool = IRCClientIdentifierTestsPool(IRCClientCaseMappingRFC1459);
+
+	XCTAssertNil(IRCClientIdentifierTestsLookUp(pool, @"alice"));
+	XCTAssertNil(IRCClientIdentifierTestsLookUp(pool, @"Alice"));
+
+	IRCClientIdentifier *identifier = IRCClientIdentifierTestsIntern(pool, @"alice");
+	XCTAssertEqual(IRCClientIdentifierTestsLookUp(pool, @"Alice"), identifier);
+}
+
+-(void) testUnusedIdentifiersAreReleased {
+	IRCClientIdentifierPool *pool = IRCClientIdentifierTestsPool(IRCClientCaseMappingRFC1459);
+
+	__weak IRCClientIdentifier *weakIdentifier;
+	@autoreleasepool {
+		IRCClientIdentifier *identifier = IRCClientIdentifierTestsIntern(pool, @"alice");
+		weakIdentifier = identifier;
+		XCTAssertNotNil(weakIdentifier);
+	}
+	XCTAssertNil(weakIdentifier);
+	XCTAssertNil(IRCClientIdentifierTestsLookUp(pool, @"alice"));
+}
+
+/***************************/
+#pragma mark - Session tests
+/***************************/
+
+-(void) testNickIsSharedAcrossChannels {
+	NSArray <IRCClientChannel *> *channels = [self connectWithSupportTokens:nil
+															   joinChannels:@[ @"#one", @"#two", @"#three" ]];
+
+	// The same user, spelled differently in each channel.
+	[self send:@[ @":Alice!a@example.com JOIN #one",
+				  @":ALICE!a@example.com JOIN #TWO",
+				  @":alice!a@example.com JOIN #Three" ]];
+
+	// Every channel’s member is the one identifier (so its name is the one
+	// object, as first seen).
+	NSMutableSet *names = [NSMutableSet set];
+	[_session performOnSessionQueueAndWait:^{
+		for (IRCClientChannel *channel in channels)
+			for (NSData *nick in channel.nicks)
+				if (nick.length == 5)
+					[names addObject:[NSValue valueWithNonretainedObject:nick]];
+	}];
+	XCTAssertEqual(names.count, (NSUInteger) 1);
+	XCTAssertEqualObjects([[names anyObject] nonretainedObjectValue], [@"Alice" dataUsingEncoding:NSUTF8StringEncoding]);
+
+	for (IRCClientChannel *channel in channels)
+		XCTAssertTrue([channel hasMember:[@"aLiCe" dataUsingEncoding:NSUTF8StringEncoding]]);
+}
+
+-(void) testOwnNickIsRecognizedInAnyCase {
+	[self connectWithSupportTokens:nil
+					  joinChannels:@[]];
+
+	// A JOIN from us (in whatever case) is a channel joined.
+	[self send:@[ @":WATCHER!test@localhost JOIN #elsewhere" ]];
+	XCTAssertEqual(_delegate.joinedChannels.count, (NSUInteger) 1);
+}
+
+-(void) testCaseMappingComesFromTheServer {
+	IRCClientChannel *channel = [self connectWithSupportTokens:@[ @"CASEMAPPING=ascii" ]
+												  joinChannels:@[ @"#test" ]].firstObject;
+
+	[self send:@[ @":nick[1]!n@example.com JOIN #test",
+				  @":nick{1}!n@example.com JOIN #test",
+				  @":NICK[1]!n@example.com JOIN #test" ]];
+	XCTAssertEqual([self memberCountOf:channel], (NSUInteger) 3);
+}
+
+-(void) testDefaultCaseMappingIsRFC1459 {
+	IRCClientChannel *channel = [self connectWithSupportTokens:nil
+												  joinChannels:@[ @"#test" ]].firstObject;
+
+	[self send:@[ @":nick[1]!n@example.com JOIN #test",
+				  @":nick{1}!n@example.com JOIN #test",
+				  @":NICK[1]!n@example.com JOIN #test" ]];
+	XCTAssertEqual([self memberCountOf:channel], (NSUInteger) 2);
+}
+
+-(void) testIdentifiersAreReleasedAfterLeaving {
+	IRCClientChannel *channel = [self connectWithSupportTokens:nil
+												  joinChannels:@[ @"#test" ]].firstObject;
+
+	[self send:@[ @":alice!a@example.com JOIN #test" ]];
+	XCTAssertTrue([channel hasMember:[@"alice" dataUsingEncoding:NSUTF8StringEncoding]]);
+
+	[self send:@[ @":alice!a@example.com PART #test" ]];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		__block BOOL interned;
+		[_session performOnSessionQueueAndWait:^{
+			@autoreleasepool {
+				interned = (IRCClientIdentifierTestsLookUp(_session.identifiers, @"alice") != nil);
+			}
+		}];
+
+		return !interned;
+	}));
+}
+
+@end
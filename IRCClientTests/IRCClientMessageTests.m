@@ -0,0 +1,353 @@
+//
+//	IRCClientMessageTests.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <XCTest/XCTest.h>
+
+#import "IRCClientMessage.h"
+
+/****************************/
+#pragma mark Helper functions
+/****************************/
+
+// Returns the given range of the message’s bytes as a string (or nil, if the
+// range is absent).
+static NSString *IRCClientMessageTestsString(const IRCClientMessage *message,
+											 NSRange range) {
+	NSData *data = IRCClientMessageDataForRange(message, range);
+
+	return (data != nil
+			? [[NSString alloc] initWithData:data
+									encoding:NSUTF8StringEncoding]
+			: nil);
+}
+
+/********************************************************/
+#pragma mark - IRCClientMessageTests class implementation
+/********************************************************/
+
+@interface IRCClientMessageTests : XCTestCase
+
+@end
+
+@implementation IRCClientMessageTests {
+	// The line that the message was parsed from (which it points into).
+	NSData *_line;
+	IRCClientMessage _message;
+}
+
+/****************************/
+#pragma mark - Helper methods
+/****************************/
+
+-(BOOL) parse:(NSString *)line {
+	_line = [line dataUsingEncoding:NSUTF8StringEncoding];
+
+	return IRCClientMessageParse(_line.bytes, _line.length, &_message);
+}
+
+-(NSString *) command {
+	return IRCClientMessageTestsString(&_message, _message.command);
+}
+
+-(NSString *) prefix {
+	return IRCClientMessageTestsString(&_message, _message.prefix);
+}
+
+-(NSArray <NSString *> *) params {
+	NSMutableArray <NSString *> *params = [NSMutableArray array];
+	for (NSUInteger i = 0; i < _message.paramCount; i++)
+		[params addObject:IRCClientMessageTestsString(&_message, _message.params[i])];
+
+	return params;
+}
+
+// Returns the (unescaped) value of the tag with the given key, or nil if the
+// message has no such tag.
+-(NSString *) tag:(NSString *)key {
+	IRCClientMessageTags tags;
+	IRCClientMessageTagsParse(&_message, &tags);
+
+	NSData *keyData = [key dataUsingEncoding:NSUTF8StringEncoding];
+	NSData *value = IRCClientMessageTagValueData(&_message,
+												 IRCClientMessageTagValueRange(&_message, &tags, keyData.bytes, keyData.length));
+
+	return (value != nil
+			? [[NSString alloc] initWithData:value
+									encoding:NSUTF8StringEncoding]
+			: nil);
+}
+
+-(NSUInteger) tagCount {
+	IRCClientMessageTags tags;
+	IRCClientMessageTagsParse(&_message, &tags);
+
+	return tags.count;
+}
+
+/**************************/
+#pragma mark - Parser tests
+/**************************/
+
+-(void) testMessageIsSplitIntoParts {
+	XCTAssertTrue([self parse:@":nick!user@host PRIVMSG #channel :Hello, world\r\n"]);
+
+	XCTAssertEqual(_message.tags.location, (NSUInteger) NSNotFound);
+	XCTAssertEqualObjects(self.prefix, @"nick!user@host");
+	XCTAssertEqualObjects(self.command, @"PRIVMSG");
+	XCTAssertEqualObjects(self.params, (@[ @"#channel", @"Hello, world" ]));
+	XCTAssertEqualObjects(IRCClientMessageTestsString(&_message, IRCClientMessagePrefixNickRange(&_message)), @"nick");
+
+	// (The CRLF isn’t part of the message.)
+	XCTAssertEqual(_message.length, _line.length - 2);
+}
+
+-(void) testMessageWithoutAPrefix {
+	XCTAssertTrue([self parse:@"PING :irc.test"]);
+
+	XCTAssertEqual(_message.prefix.location, (NSUInteger) NSNotFound);
+	XCTAssertEqual(IRCClientMessagePrefixNickRange(&_message).location, (NSUInteger) NSNotFound);
+	XCTAssertEqualObjects(self.command, @"PING");
+	XCTAssertEqualObjects(self.params, @[ @"irc.test" ]);
+}
+
+-(void) testServerPrefixHasNoNick {
+	XCTAssertTrue([self parse:@":irc.test NOTICE * :Looking up your hostname"]);
+
+	XCTAssertEqualObjects(self.prefix, @"irc.test");
+	XCTAssertEqual(IRCClientMessagePrefixNickRange(&_message).location, (NSUInteger) NSNotFound);
+}
+
+-(void) testMessageWithoutParams {
+	XCTAssertTrue([self parse:@":nick!user@host QUIT"]);
+
+	XCTAssertEqualObjects(self.command, @"QUIT");
+	XCTAssertEqual(_message.paramCount, (NSUInteger) 0);
+	XCTAssertEqual(IRCClientMessageParamRange(&_message, 0).location, (NSUInteger) NSNotFound);
+	XCTAssertNil(IRCClientMessageParamData(&_message, 0));
+	XCTAssertEqualObjects(IRCClientMessageParamsArray(&_message, 0), @[]);
+}
+
+-(void) testTrailingParamKeepsItsSpacesAndColons {
+	XCTAssertTrue([self parse:@"PRIVMSG #channel :  two  spaces :and a colon "]);
+
+	XCTAssertEqualObjects(self.params, (@[ @"#channel", @"  two  spaces :and a colon " ]));
+}
+
+-(void) testEmptyTrailingParam {
+	XCTAssertTrue([self parse:@"TOPIC #channel :"]);
+
+	XCTAssertEqualObjects(self.params, (@[ @"#channel", @"" ]));
+	XCTAssertEqual(IRCClientMessageRangeFirstByte(&_message, _message.params[1]), (uint8_t) 0);
+}
+
+-(void) testExtraSpacesAreSkipped {
+	XCTAssertTrue([self parse:@":nick!user@host   MODE   #channel   +o   other  "]);
+
+	XCTAssertEqualObjects(self.command, @"MODE");
+	XCTAssertEqualObjects(self.params, (@[ @"#channel", @"+o", @"other" ]));
+}
+
+-(void) testLastParamThereIsRoomForRunsToTheEnd {
+	// 14 middle params, and then the rest of the line as the 15th.
+	XCTAssertTrue([self parse:@"CMD 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17"]);
+
+	XCTAssertEqual(_message.paramCount, (NSUInteger) IRCClientMessageMaxParams);
+	XCTAssertEqualObjects(self.params.lastObject, @"15 16 17");
+}
+
+-(void) testParamsCanBeTakenFromAnIndex {
+	XCTAssertTrue([self parse:@"005 nick CHANTYPES=# PREFIX=(ov)@+ :are supported"]);
+
+	XCTAssertEqualObjects(IRCClientMessageParamsArray(&_message, 1),
+						  (@[ [@"CHANTYPES=#" dataUsingEncoding:NSUTF8StringEncoding],
+							  [@"PREFIX=(ov)@+" dataUsingEncoding:NSUTF8StringEncoding],
+							  [@"are supported" dataUsingEncoding:NSUTF8StringEncoding] ]));
+	XCTAssertEqualObjects(IRCClientMessageParamsArray(&_message, 10), @[]);
+}
+
+/**********************************/
+#pragma mark - Malformed line tests
+/**********************************/
+
+-(void) testEmptyLineHasNoCommand {
+	XCTAssertFalse([self parse:@""]);
+	XCTAssertFalse([self parse:@"\r\n"]);
+	XCTAssertFalse([self parse:@"    "]);
+}
+
+-(void) testPrefixAloneHasNoCommand {
+	XCTAssertFalse([self parse:@":nick!user@host"]);
+	XCTAssertFalse([self parse:@":nick!user@host   "]);
+}
+
+-(void) testTagsAloneHaveNoCommand {
+	XCTAssertFalse([self parse:@"@time=2021-01-01T00:00:00.000Z"]);
+	XCTAssertFalse([self parse:@"@time=2021-01-01T00:00:00.000Z :irc.test "]);
+}
+
+-(void) testBareLineFeedIsKept {
+	// (Only a CRLF is a line terminator; the receive buffer splits lines.)
+	XCTAssertTrue([self parse:@"PING :token\n"]);
+
+	XCTAssertEqualObjects(self.params, @[ @"token\n" ]);
+}
+
+-(void) testLongLineIsParsed {
+	// (Longer than the 512 bytes that RFC 1459 allows; the length limit is
+	// the receive buffer’s to enforce.)
+	NSString *text = [@"" stringByPaddingToLength:8192
+									   withString:@"x"
+								  startingAtIndex:0];
+	XCTAssertTrue([self parse:[NSString stringWithFormat:@"PRIVMSG #channel :%@\r\n", text]]);
+
+	XCTAssertEqualObjects(self.params, (@[ @"#channel", text ]));
+}
+
+/***********************/
+#pragma mark - Tag tests
+/***********************/
+
+-(void) testTagsAreSkippedByTheParser {
+	XCTAssertTrue([self parse:@"@time=2021-01-01T00:00:00.000Z;msgid=abc :nick!user@host PRIVMSG #channel :Hello\r\n"]);
+
+	// (Only their extent is found, until some tag is looked up.)
+	XCTAssertEqualObjects(IRCClientMessageTestsString(&_message, _message.tags), @"time=2021-01-01T00:00:00.000Z;msgid=abc");
+	XCTAssertEqualObjects(self.prefix, @"nick!user@host");
+	XCTAssertEqualObjects(self.command, @"PRIVMSG");
+	XCTAssertEqualObjects(self.params, (@[ @"#channel", @"Hello" ]));
+
+	XCTAssertEqual(self.tagCount, (NSUInteger) 2);
+	XCTAssertEqualObjects([self tag:@"time"], @"2021-01-01T00:00:00.000Z");
+	XCTAssertEqualObjects([self tag:@"msgid"], @"abc");
+	XCTAssertNil([self tag:@"account"]);
+	XCTAssertNil([self tag:@"msg"]);
+}
+
+-(void) testMessageWithoutTagsHasNone {
+	XCTAssertTrue([self parse:@":nick!user@host PRIVMSG #channel :time=now"]);
+
+	XCTAssertEqual(self.tagCount, (NSUInteger) 0);
+	XCTAssertNil([self tag:@"time"]);
+}
+
+-(void) testTagWithoutAValueIsEmpty {
+	XCTAssertTrue([self parse:@"@draft/bot;+typing=;account=nick PRIVMSG #channel :text"]);
+
+	XCTAssertEqual(self.tagCount, (NSUInteger) 3);
+	XCTAssertEqualObjects([self tag:@"draft/bot"], @"");
+	XCTAssertEqualObjects([self tag:@"+typing"], @"");
+	XCTAssertEqualObjects([self tag:@"account"], @"nick");
+
+	// (An empty range, but not an absent one.)
+	IRCClientMessageTags tags;
+	IRCClientMessageTagsParse(&_message, &tags);
+	XCTAssertEqual(tags.values[0].location, (NSUInteger) NSNotFound);
+	NSRange value = IRCClientMessageTagValueRange(&_message, &tags, (const uint8_t *) "draft/bot", 9);
+	XCTAssertNotEqual(value.location, (NSUInteger) NSNotFound);
+	XCTAssertEqual(value.length, (NSUInteger) 0);
+}
+
+-(void) testValuesAreUnescaped {
+	XCTAssertTrue([self parse:@"@a=semi\\:colon;b=two\\swords;c=back\\\\slash;d=line\\r\\nbreak;e=\\x\\y;f=plain PRIVMSG #channel :text"]);
+
+	XCTAssertEqualObjects([self tag:@"a"], @"semi;colon");
+	XCTAssertEqualObjects([self tag:@"b"], @"two words");
+	XCTAssertEqualObjects([self tag:@"c"], @"back\\slash");
+	XCTAssertEqualObjects([self tag:@"d"], @"line\r\nbreak");
+	// (An unknown escape is just the character.)
+	XCTAssertEqualObjects([self tag:@"e"], @"xy");
+	XCTAssertEqualObjects([self tag:@"f"], @"plain");
+}
+
+-(void) testTrailingBackslashIsDropped {
+	XCTAssertTrue([self parse:@"@a=value\\;b=\\ PRIVMSG #channel :text"]);
+
+	XCTAssertEqualObjects([self tag:@"a"], @"value");
+	XCTAssertEqualObjects([self tag:@"b"], @"");
+}
+
+-(void) testMalformedTagsAreSkipped {
+	// (Empty tags, and values without keys.)
+	XCTAssertTrue([self parse:@"@;;=orphan;key=value; PRIVMSG #channel :text"]);
+
+	XCTAssertEqual(self.tagCount, (NSUInteger) 1);
+	XCTAssertEqualObjects([self tag:@"key"], @"value");
+	XCTAssertNil([self tag:@""]);
+	XCTAssertEqualObjects(self.command, @"PRIVMSG");
+
+	// (A lone ‘@’ is an empty set of tags.)
+	XCTAssertTrue([self parse:@"@ PRIVMSG #channel :text"]);
+
+	XCTAssertEqual(_message.tags.length, (NSUInteger) 0);
+	XCTAssertEqual(self.tagCount, (NSUInteger) 0);
+	XCTAssertEqualObjects(self.command, @"PRIVMSG");
+}
+
+-(void) testOnlySoManyTagsAreRecorded {
+	NSMutableArray <NSString *> *tags = [NSMutableArray array];
+	for (NSUInteger i = 0; i < IRCClientMessageMaxTags + 8; i++)
+		[tags addObject:[NSString stringWithFormat:@"key%lu=%lu", (unsigned long) i, (unsigned long) i]];
+	XCTAssertTrue([self parse:[NSString stringWithFormat:@"@%@ PRIVMSG #channel :text", [tags componentsJoinedByString:@";"]]]);
+
+	XCTAssertEqual(self.tagCount, (NSUInteger) IRCClientMessageMaxTags);
+	XCTAssertEqualObjects([self tag:@"key0"], @"0");
+	XCTAssertEqualObjects([self tag:([NSString stringWithFormat:@"key%lu", (unsigned long) IRCClientMessageMaxTags - 1])],
+						  ([NSString stringWithFormat:@"%lu", (unsigned long) IRCClientMessageMaxTags - 1]));
+	XCTAssertNil([self tag:([NSString stringWithFormat:@"key%lu", (unsigned long) IRCClientMessageMaxTags])]);
+
+	// (The rest of the message is unaffected.)
+	XCTAssertEqualObjects(self.params, (@[ @"#channel", @"text" ]));
+}
+
+/***************************/
+#pragma mark - Numeric tests
+/***************************/
+
+-(void) testNumericCodeIsRead {
+	NSUInteger code = 0;
+
+	XCTAssertTrue([self parse:@":irc.test 001 nick :Welcome"]);
+	XCTAssertTrue(IRCClientMessageNumericCode(&_message, &code));
+	XCTAssertEqual(code, (NSUInteger) 1);
+
+	XCTAssertTrue([self parse:@":irc.test 433 * nick :Nickname is already in use"]);
+	XCTAssertTrue(IRCClientMessageNumericCode(&_message, &code));
+	XCTAssertEqual(code, (NSUInteger) 433);
+}
+
+-(void) testOnlyThreeDigitsAreANumeric {
+	NSUInteger code = 0;
+
+	for (NSString *line in @[ @"PING :x", @"1234 x", @"12 x", @"4a3 x", @"ABC x" ]) {
+		XCTAssertTrue([self parse:line]);
+		XCTAssertFalse(IRCClientMessageNumericCode(&_message, &code), @"%@", line);
+	}
+}
+
+/******************************/
+#pragma mark - Comparison tests
+/******************************/
+
+-(void) testRangesAreComparedExactly {
+	XCTAssertTrue([self parse:@"PRIVMSG #Channel :text"]);
+
+	XCTAssertTrue(IRCClientMessageRangeIsEqualToCString(&_message, _message.command, "PRIVMSG"));
+	XCTAssertFalse(IRCClientMessageRangeIsEqualToCString(&_message, _message.command, "privmsg"));
+	XCTAssertFalse(IRCClientMessageRangeIsEqualToCString(&_message, _message.command, "PRIVMSGS"));
+	XCTAssertTrue(IRCClientMessageRangeHasCStringPrefix(&_message, _message.params[0], "#"));
+	XCTAssertFalse(IRCClientMessageRangeHasCStringPrefix(&_message, _message.params[0], "#Channel!"));
+	XCTAssertTrue(IRCClientMessageRangeIsEqualToData(&_message, _message.params[0], [@"#Channel" dataUsingEncoding:NSUTF8StringEncoding]));
+	XCTAssertFalse(IRCClientMessageRangeIsEqualToData(&_message, _message.params[0], nil));
+
+	// (An absent range is equal to nothing.)
+	XCTAssertFalse(IRCClientMessageRangeIsEqualToCString(&_message, _message.prefix, ""));
+	XCTAssertFalse(IRCClientMessageRangeHasCStringPrefix(&_message, _message.prefix, ""));
+}
+
+@end
@@ -0,0 +1,382 @@
+//
+//	IRCClientOutputSchedulerTests.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <XCTest/XCTest.h>
+
+#import "IRCClientSession.h"
+#import "IRCClientOutputScheduler.h"
+#import "IRCClientTestServer.h"
+#import "IRCClientTestDelegate.h"
+
+/****************************/
+#pragma mark Helper functions
+/****************************/
+
+// Returns a segment holding the line (and a CRLF).
+static IRCClientOutputSegment *IRCClientOutputSchedulerTestsSegment(NSString *line) {
+	NSData *data = [[line stringByAppendingString:@"\r\n"] dataUsingEncoding:NSUTF8StringEncoding];
+	IRCClientOutputSegment *segment = IRCClientOutputQueueCreateSegment(NULL, data.length);
+	memcpy(segment->bytes, data.bytes, data.length);
+	segment->length = data.length;
+
+	return segment;
+}
+
+static uint64_t IRCClientOutputSchedulerTestsTarget(NSString *line) {
+	IRCClientOutputSegment *segment = IRCClientOutputSchedulerTestsSegment(line);
+	uint64_t target = 0;
+	IRCClientOutputSchedulerClassify(segment, NO, &target);
+	IRCClientOutputQueueFreeSegments(segment);
+
+	return target;
+}
+
+/****************************************************************/
+#pragma mark - IRCClientOutputSchedulerTests class implementation
+/****************************************************************/
+
+@interface IRCClientOutputSchedulerTests : XCTestCase
+
+@end
+
+@implementation IRCClientOutputSchedulerTests {
+	IRCClientOutputScheduler _scheduler;
+}
+
+-(void) setUp {
+	memset(&_scheduler, 0, sizeof(_scheduler));
+}
+
+-(void) tearDown {
+	IRCClientOutputSchedulerFree(&_scheduler);
+}
+
+/****************************/
+#pragma mark - Helper methods
+/****************************/
+
+-(void) enqueue:(NSArray <NSString *> *)lines
+			 at:(uint64_t)now {
+	for (NSString *line in lines)
+		IRCClientOutputSchedulerEnqueue(&_scheduler, IRCClientOutputSchedulerTestsSegment(line), now);
+}
+
+// Returns the next line that may be sent at the given time (without its
+// CRLF), or nil (in which case *wait is set as by
+// IRCClientOutputSchedulerDequeue()).
+-(NSString *) dequeueAt:(uint64_t)now
+				   wait:(uint64_t *)wait {
+	uint64_t ignoredWait = 0;
+	IRCClientOutputSegment *segment = IRCClientOutputSchedulerDequeue(&_scheduler, now, (wait ?: &ignoredWait));
+	if (segment == NULL)
+		return nil;
+
+	NSString *line = [[NSString alloc] initWithBytes:segment->bytes
+											  length:segment->length - 2
+											encoding:NSUTF8StringEncoding];
+	IRCClientOutputQueueFreeSegments(segment);
+
+	return line;
+}
+
+// Returns every line that may be sent at the given time, in order.
+-(NSArray <NSString *> *) dequeueAllAt:(uint64_t)now {
+	NSMutableArray <NSString *> *lines = [NSMutableArray array];
+	NSString *line;
+	while ((line = [self dequeueAt:now
+							  wait:NULL]) != nil)
+		[lines addObject:line];
+
+	return lines;
+}
+
+/**********************************/
+#pragma mark - Classification tests
+/**********************************/
+
+-(void) testCommandsAreClassified {
+	uint64_t target = 0;
+	NSDictionary <NSString *, NSNumber *> *expected = @{
+		@"PONG :irc.test": @(IRCClientOutputPriorityUrgent),
+		@"pong :irc.test": @(IRCClientOutputPriorityUrgent),
+		@"QUIT :Bye": @(IRCClientOutputPriorityUrgent),
+		@"NICK other": @(IRCClientOutputPriorityControl),
+		@"JOIN #channel": @(IRCClientOutputPriorityControl),
+		@"PONGS": @(IRCClientOutputPriorityControl),
+		@"PRIVMSG #channel :Hello": @(IRCClientOutputPriorityUser),
+		@"NOTICE friend :Hello": @(IRCClientOutputPriorityUser),
+		@":me PRIVMSG #channel :Hello": @(IRCClientOutputPriorityUser),
+		@":me PONG :irc.test": @(IRCClientOutputPriorityUrgent)
+	};
+	for (NSString *line in expected) {
+		IRCClientOutputSegment *segment = IRCClientOutputSchedulerTestsSegment(line);
+		XCTAssertEqual(IRCClientOutputSchedulerClassify(segment, NO, &target), expected[line].unsignedCharValue, @"%@", line);
+		IRCClientOutputQueueFreeSegments(segment);
+	}
+}
+
+-(void) testRegistrationIsUrgentOnlyWhileRegistering {
+	uint64_t target = 0;
+	for (NSString *line in @[ @"PASS secret", @"CAP LS 302", @"AUTHENTICATE PLAIN", @"NICK me", @"USER me 0 * :Me" ]) {
+		IRCClientOutputSegment *segment = IRCClientOutputSchedulerTestsSegment(line);
+		XCTAssertEqual(IRCClientOutputSchedulerClassify(segment, YES, &target), IRCClientOutputPriorityUrgent, @"%@", line);
+		XCTAssertEqual(IRCClientOutputSchedulerClassify(segment, NO, &target), IRCClientOutputPriorityControl, @"%@", line);
+		IRCClientOutputQueueFreeSegments(segment);
+	}
+}
+
+-(void) testTargetsAreCaseFolded {
+	XCTAssertEqual(IRCClientOutputSchedulerTestsTarget(@"PRIVMSG #Channel :a"),
+				   IRCClientOutputSchedulerTestsTarget(@"NOTICE #channel :b"));
+	XCTAssertNotEqual(IRCClientOutputSchedulerTestsTarget(@"PRIVMSG #channel :a"),
+					  IRCClientOutputSchedulerTestsTarget(@"PRIVMSG #channel2 :a"));
+}
+
+/****************************/
+#pragma mark - Priority tests
+/****************************/
+
+-(void) testMessagesAreReleasedInPriorityOrder {
+	[self enqueue:@[ @"PRIVMSG #a :1", @"JOIN #b", @"PRIVMSG #a :2", @"PONG :irc.test", @"MODE #b", @"QUIT :Bye" ]
+			   at:0];
+
+	XCTAssertEqualObjects([self dequeueAllAt:0],
+						  (@[ @"PONG :irc.test", @"QUIT :Bye", @"JOIN #b", @"MODE #b", @"PRIVMSG #a :1", @"PRIVMSG #a :2" ]));
+}
+
+-(void) testEmptySchedulerHasNothingToWaitFor {
+	uint64_t wait = 0;
+	XCTAssertNil([self dequeueAt:0
+							wait:&wait]);
+	XCTAssertEqual(wait, UINT64_MAX);
+}
+
+/****************************/
+#pragma mark - Fairness tests
+/****************************/
+
+-(void) testTargetsAreServedRoundRobin {
+	[self enqueue:@[ @"PRIVMSG #a :1", @"PRIVMSG #a :2", @"PRIVMSG #a :3", @"PRIVMSG #b :1", @"PRIVMSG #c :1" ]
+			   at:0];
+
+	XCTAssertEqualObjects([self dequeueAllAt:0],
+						  (@[ @"PRIVMSG #a :1", @"PRIVMSG #b :1", @"PRIVMSG #c :1", @"PRIVMSG #a :2", @"PRIVMSG #a :3" ]));
+	XCTAssertEqual(_scheduler.laneCount, (NSUInteger) 0);
+}
+
+-(void) testNewTargetJoinsAtTheEndOfTheRound {
+	[self enqueue:@[ @"PRIVMSG #a :1", @"PRIVMSG #a :2", @"PRIVMSG #b :1", @"PRIVMSG #c :1" ]
+			   at:0];
+	XCTAssertEqualObjects([self dequeueAt:0
+									 wait:NULL], @"PRIVMSG #a :1");
+
+	[self enqueue:@[ @"PRIVMSG #d :1" ]
+			   at:0];
+
+	XCTAssertEqualObjects([self dequeueAllAt:0],
+						  (@[ @"PRIVMSG #b :1", @"PRIVMSG #c :1", @"PRIVMSG #a :2", @"PRIVMSG #d :1" ]));
+}
+
+-(void) testManyTargetsAreEachServed {
+	// (Enough lanes that the table grows, and that removals shift entries.)
+	NSMutableSet <NSString *> *lines = [NSMutableSet set];
+	for (NSUInteger i = 0; i < 200; i++)
+		[lines addObject:[NSString stringWithFormat:@"PRIVMSG #%lu :x", (unsigned long) i]];
+	[self enqueue:lines.allObjects
+			   at:0];
+	XCTAssertEqual(_scheduler.laneCount, (NSUInteger) 200);
+
+	NSArray <NSString *> *released = [self dequeueAllAt:0];
+	XCTAssertEqual(released.count, (NSUInteger) 200);
+	XCTAssertEqualObjects([NSSet setWithArray:released], lines);
+	XCTAssertEqual(_scheduler.laneCount, (NSUInteger) 0);
+}
+
+/********************************/
+#pragma mark - Token bucket tests
+/********************************/
+
+-(void) testBurstIsSentAtOnceAndTheRestAtTheInterval {
+	IRCClientOutputSchedulerConfigure(&_scheduler, 3, 1000, 0);
+	[self enqueue:@[ @"JOIN #1", @"JOIN #2", @"JOIN #3", @"JOIN #4", @"JOIN #5" ]
+			   at:0];
+
+	XCTAssertEqual([self dequeueAllAt:0].count, (NSUInteger) 3);
+
+	uint64_t wait = 0;
+	XCTAssertNil([self dequeueAt:400
+							wait:&wait]);
+	XCTAssertEqual(wait, (uint64_t) 600);
+
+	XCTAssertEqualObjects([self dequeueAllAt:1000], @[ @"JOIN #4" ]);
+	XCTAssertEqualObjects([self dequeueAllAt:2000], @[ @"JOIN #5" ]);
+}
+
+-(void) testBucketDoesNotFillPastTheBurst {
+	IRCClientOutputSchedulerConfigure(&_scheduler, 2, 1000, 0);
+	[self enqueue:@[ @"JOIN #1", @"JOIN #2", @"JOIN #3", @"JOIN #4" ]
+			   at:0];
+
+	// (A long time idle still only earns the burst.)
+	XCTAssertEqual([self dequeueAllAt:1000000].count, (NSUInteger) 2);
+}
+
+-(void) testUrgentMessagesAreNotHeldBack {
+	IRCClientOutputSchedulerConfigure(&_scheduler, 1, 1000, 0);
+	[self enqueue:@[ @"PRIVMSG #a :1", @"PRIVMSG #a :2" ]
+			   at:0];
+	XCTAssertEqual([self dequeueAllAt:0].count, (NSUInteger) 1);
+
+	[self enqueue:@[ @"PONG :irc.test" ]
+			   at:0];
+	XCTAssertEqualObjects([self dequeueAllAt:0], @[ @"PONG :irc.test" ]);
+
+	// (But it was paid for.)
+	uint64_t wait = 0;
+	XCTAssertNil([self dequeueAt:0
+							wait:&wait]);
+	XCTAssertEqual(wait, (uint64_t) 2000);
+}
+
+-(void) testRegistrationCostsNothing {
+	IRCClientOutputSchedulerConfigure(&_scheduler, 2, 1000, 0);
+	_scheduler.registering = YES;
+	[self enqueue:@[ @"CAP LS 302", @"NICK me", @"USER me 0 * :Me", @"CAP REQ :sasl", @"AUTHENTICATE PLAIN", @"CAP END" ]
+			   at:0];
+	XCTAssertEqual([self dequeueAllAt:0].count, (NSUInteger) 6);
+	_scheduler.registering = NO;
+
+	[self enqueue:@[ @"JOIN #1", @"JOIN #2", @"JOIN #3" ]
+			   at:0];
+	XCTAssertEqual([self dequeueAllAt:0].count, (NSUInteger) 2);
+}
+
+-(void) testConfiguringKeepsTheCredit {
+	// (Turning flood control on starts with a full bucket.)
+	IRCClientOutputSchedulerConfigure(&_scheduler, 4, 1000, 0);
+	XCTAssertEqual(_scheduler.credit, (int64_t) 4000);
+
+	// (A smaller burst clamps it.)
+	IRCClientOutputSchedulerConfigure(&_scheduler, 2, 1000, 0);
+	XCTAssertEqual(_scheduler.credit, (int64_t) 2000);
+
+	[self enqueue:@[ @"JOIN #1", @"JOIN #2" ]
+			   at:0];
+	XCTAssertEqual([self dequeueAllAt:0].count, (NSUInteger) 2);
+
+	// (A larger one doesn’t fill it.)
+	IRCClientOutputSchedulerConfigure(&_scheduler, 8, 1000, 0);
+	XCTAssertEqual(_scheduler.credit, (int64_t) 0);
+
+	IRCClientOutputSchedulerRefill(&_scheduler, 0);
+	XCTAssertEqual(_scheduler.credit, (int64_t) 8000);
+}
+
+-(void) testZeroDisablesFloodControl {
+	IRCClientOutputSchedulerConfigure(&_scheduler, 0, 1000, 0);
+	NSMutableArray <NSString *> *lines = [NSMutableArray array];
+	for (NSUInteger i = 0; i < 100; i++)
+		[lines addObject:[NSString stringWithFormat:@"JOIN #%lu", (unsigned long) i]];
+	[self enqueue:lines
+			   at:0];
+
+	XCTAssertEqual([self dequeueAllAt:0].count, (NSUInteger) 100);
+}
+
+/**************************/
+#pragma mark - Metric tests
+/**************************/
+
+-(void) testQueueDepthIsCounted {
+	[self enqueue:@[ @"JOIN #a", @"PRIVMSG #a :1" ]
+			   at:0];
+	XCTAssertEqual(_scheduler.messagesQueued, (NSUInteger) 2);
+	XCTAssertEqual(_scheduler.bytesQueued, strlen("JOIN #a\r\n") + strlen("PRIVMSG #a :1\r\n"));
+
+	[self dequeueAt:0
+			   wait:NULL];
+	XCTAssertEqual(_scheduler.messagesQueued, (NSUInteger) 1);
+	XCTAssertEqual(_scheduler.bytesQueued, strlen("PRIVMSG #a :1\r\n"));
+}
+
+-(void) testDelayIsMeasured {
+	IRCClientOutputSchedulerConfigure(&_scheduler, 1, 1000, 0);
+	[self enqueue:@[ @"JOIN #1", @"JOIN #2", @"JOIN #3" ]
+			   at:0];
+
+	[self dequeueAllAt:0];
+	XCTAssertEqual(_scheduler.lastDelay, (uint64_t) 0);
+
+	[self dequeueAllAt:2500];
+	XCTAssertEqual(_scheduler.lastDelay, (uint64_t) 2500);
+	XCTAssertEqual(_scheduler.maxDelay, (uint64_t) 2500);
+
+	[self enqueue:@[ @"JOIN #4" ]
+			   at:3000];
+	[self dequeueAllAt:3500];
+	XCTAssertEqual(_scheduler.lastDelay, (uint64_t) 500);
+	XCTAssertEqual(_scheduler.maxDelay, (uint64_t) 2500);
+}
+
+-(void) testFreeingKeepsTheParameters {
+	IRCClientOutputSchedulerConfigure(&_scheduler, 3, 1000, 0);
+	[self enqueue:@[ @"JOIN #a", @"PONG :irc.test", @"PRIVMSG #a :1", @"PRIVMSG #b :1" ]
+			   at:0];
+
+	IRCClientOutputSchedulerFree(&_scheduler);
+
+	XCTAssertEqual(_scheduler.messagesQueued, (NSUInteger) 0);
+	XCTAssertEqual(_scheduler.bytesQueued, (NSUInteger) 0);
+	XCTAssertEqual(_scheduler.laneCount, (NSUInteger) 0);
+	XCTAssertEqual(_scheduler.burst, (NSUInteger) 3);
+	XCTAssertNil([self dequeueAt:0
+							wait:NULL]);
+}
+
+/***************************/
+#pragma mark - Session tests
+/***************************/
+
+-(void) testPongIsNotHeldBehindMessages {
+	IRCClientTestServer *server = [IRCClientTestServer new];
+	XCTAssertTrue([server start]);
+	IRCClientTestDelegate *delegate = [IRCClientTestDelegate new];
+	IRCClientSession *session = [server sessionWithNickname:@"busy"
+												  eventLoop:nil];
+	session.delegate = delegate;
+	session.floodControlBurst = 1;
+	session.floodControlInterval = 0.5;
+	[session connect];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (delegate.connectionCount == 1);
+	}));
+
+	for (NSUInteger i = 0; i < 4; i++)
+		XCTAssertEqual([session message:[@"text" dataUsingEncoding:NSUTF8StringEncoding]
+									 to:[@"friend" dataUsingEncoding:NSUTF8StringEncoding]], 0);
+	XCTAssertGreaterThan(session.outputMessagesQueued, (NSUInteger) 0);
+
+	[[server connectionForNick:@"busy"] sendLine:@"PING :token"];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return ([server receivedLinesWithCommand:@"PONG"].count == 1);
+	}));
+	XCTAssertLessThan([server receivedLinesWithCommand:@"PRIVMSG"].count, (NSUInteger) 4);
+
+	// The rest follow, at the interval.
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return ([server receivedLinesWithCommand:@"PRIVMSG"].count == 4);
+	}));
+	XCTAssertEqual(session.outputMessagesQueued, (NSUInteger) 0);
+	XCTAssertGreaterThan(session.outputMaxQueueDelay, 0.0);
+
+	[session disconnect];
+	[server stop];
+}
+
+@end
@@ -0,0 +1,396 @@
+//
+//	IRCClientReceiveBufferTests.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <XCTest/XCTest.h>
+
+#import "IRCClientSession.h"
+#import "IRCClientReceiveBuffer.h"
+#import "IRCClientTestServer.h"
+#import "IRCClientTestDelegate.h"
+
+#import <stdatomic.h>
+
+/****************************/
+#pragma mark Helper functions
+/****************************/
+
+static NSData *IRCClientReceiveBufferTestsData(NSString *string) {
+	return [string dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+// Returns a line of the given length (including the CRLF).
+static NSString *IRCClientReceiveBufferTestsLine(NSUInteger length) {
+	return [[@"PRIVMSG #channel :" stringByPaddingToLength:(length - 2)
+											   withString:@"x"
+										  startingAtIndex:0] stringByAppendingString:@"\r\n"];
+}
+
+/*******************************************************************/
+#pragma mark - IRCClientReceiveBufferTestsDelegate class declaration
+/*******************************************************************/
+
+// A test delegate that takes batches, and holds on to them (keeping them
+// pending against the session’s inbound budget) until told to consume them.
+@interface IRCClientReceiveBufferTestsDelegate : IRCClientTestDelegate
+
+/**	The number of private messages received in batches. */
+@property (readonly) NSUInteger batchedMessageCount;
+
+/**	If YES, batches are consumed as soon as they’re received. */
+@property (atomic) BOOL consumesBatches;
+
+/**	Consumes the batches that have been held on to.
+ */
+-(void) consumeHeldBatchesOfSession:(IRCClientSession *)session;
+
+@end
+
+/**********************************************************************/
+#pragma mark - IRCClientReceiveBufferTestsDelegate class implementation
+/**********************************************************************/
+
+@implementation IRCClientReceiveBufferTestsDelegate {
+	_Atomic(NSUInteger) _batchedMessageCount;
+
+	// Guarded by @synchronized (self).
+	NSMutableArray <IRCClientEventBatch *> *_heldBatches;
+}
+
+-(instancetype) init {
+	if (!(self = [super init]))
+		return nil;
+
+	_heldBatches = [NSMutableArray array];
+
+	return self;
+}
+
+-(NSUInteger) batchedMessageCount {
+	return atomic_load(&_batchedMessageCount);
+}
+
+-(void) consumeHeldBatchesOfSession:(IRCClientSession *)session {
+	NSArray <IRCClientEventBatch *> *batches;
+	@synchronized (self) {
+		batches = [_heldBatches copy];
+		[_heldBatches removeAllObjects];
+	}
+
+	for (IRCClientEventBatch *batch in batches)
+		[session eventBatchConsumed:batch];
+}
+
+-(void) eventsReceived:(IRCClientEventBatch *)batch
+			   session:(IRCClientSession *)session {
+	NSUInteger privateMessageCount = 0;
+	for (NSUInteger i = 0; i < batch.count; i++)
+		if ([[batch commandOfMessageAtIndex:i] isEqualToData:IRCClientReceiveBufferTestsData(@"PRIVMSG")])
+			privateMessageCount++;
+	atomic_fetch_add(&_batchedMessageCount, privateMessageCount);
+
+	if (self.consumesBatches) {
+		[session eventBatchConsumed:batch];
+	} else {
+		@synchronized (self) {
+			[_heldBatches addObject:batch];
+		}
+	}
+}
+
+@end
+
+/**************************************************************/
+#pragma mark - IRCClientReceiveBufferTests class implementation
+/**************************************************************/
+
+@interface IRCClientReceiveBufferTests : XCTestCase
+
+@end
+
+@implementation IRCClientReceiveBufferTests {
+	IRCClientReceiveBuffer _buffer;
+
+	IRCClientTestServer *_server;
+	IRCClientReceiveBufferTestsDelegate *_delegate;
+	IRCClientSession *_session;
+	IRCClientTestConnection *_connection;
+}
+
+-(void) setUp {
+	IRCClientReceiveBufferInit(&_buffer, 4096);
+}
+
+-(void) tearDown {
+	IRCClientReceiveBufferFree(&_buffer);
+
+	[_session disconnect];
+	[_server stop];
+	_session = nil;
+	_server = nil;
+}
+
+/****************************/
+#pragma mark - Helper methods
+/****************************/
+
+// Writes the string into the buffer, in reads of at most the given size;
+// returns the lines taken out of the buffer after each read.
+-(NSArray <NSString *> *) receive:(NSString *)string
+					  inReadsOfSize:(NSUInteger)readSize {
+	NSData *data = IRCClientReceiveBufferTestsData(string);
+	NSMutableArray <NSString *> *lines = [NSMutableArray array];
+
+	NSUInteger offset = 0;
+	while (offset < data.length) {
+		NSUInteger available;
+		uint8_t *space = IRCClientReceiveBufferPrepareWrite(&_buffer, &available);
+		XCTAssertTrue(space != NULL);
+		NSUInteger count = MIN(MIN(available, readSize), data.length - offset);
+		memcpy(space, ((const uint8_t *) data.bytes) + offset, count);
+		IRCClientReceiveBufferCommitWrite(&_buffer, count);
+		offset += count;
+
+		const uint8_t *line;
+		NSUInteger length;
+		while (IRCClientReceiveBufferNextLine(&_buffer, &line, &length))
+			[lines addObject:[[NSString alloc] initWithBytes:line
+													  length:length
+													encoding:NSUTF8StringEncoding]];
+	}
+
+	return lines;
+}
+
+-(void) connect {
+	_server = [IRCClientTestServer new];
+	XCTAssertTrue([_server start]);
+
+	_delegate = [IRCClientReceiveBufferTestsDelegate new];
+	_session = [_server sessionWithNickname:@"reader"
+								  eventLoop:nil];
+	_session.delegate = _delegate;
+	_session.batchesEvents = YES;
+	[_session connect];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (_delegate.connectionCount == 1);
+	}));
+
+	_connection = [_server connectionForNick:@"reader"];
+	XCTAssertNotNil(_connection);
+
+	_session.eventBatchLimit = 10;
+}
+
+// Sends the given number of private messages (and then the given lines) to
+// the session, all at once.
+-(void) sendPrivateMessages:(NSUInteger)count
+				  thenLines:(NSArray <NSString *> *)lines {
+	NSMutableData *data = [NSMutableData data];
+	for (NSUInteger i = 0; i < count; i++)
+		[data appendData:IRCClientReceiveBufferTestsData([NSString stringWithFormat:@":friend!user@host PRIVMSG reader :Message %lu\r\n", (unsigned long) i])];
+	for (NSString *line in lines)
+		[data appendData:IRCClientReceiveBufferTestsData([line stringByAppendingString:@"\r\n"])];
+	[_connection sendData:data];
+}
+
+/***************************/
+#pragma mark - Framing tests
+/***************************/
+
+-(void) testLinesAreFramedByCRLF {
+	XCTAssertEqualObjects([self receive:@"PING :a\r\n\r\nPING :b\r\nPING :c"
+						  inReadsOfSize:4096],
+						  (@[ @"PING :a\r\n", @"\r\n", @"PING :b\r\n" ]));
+
+	// (The partial line is kept until the rest of it comes in.)
+	XCTAssertEqualObjects([self receive:@"d\r\n"
+						  inReadsOfSize:4096],
+						  @[ @"PING :cd\r\n" ]);
+}
+
+-(void) testLinesAreFramedWhateverTheReadSize {
+	NSString *lines = @"PING :one\r\nPRIVMSG #channel :two\r\n\r\nPONG :three\r\n";
+	NSArray <NSString *> *expected = @[ @"PING :one\r\n", @"PRIVMSG #channel :two\r\n", @"\r\n", @"PONG :three\r\n" ];
+
+	for (NSUInteger readSize = 1; readSize < 16; readSize++)
+		XCTAssertEqualObjects([self receive:lines
+							  inReadsOfSize:readSize], expected, @"%lu", (unsigned long) readSize);
+}
+
+-(void) testBareLineFeedIsPartOfTheLine {
+	XCTAssertEqualObjects([self receive:@"PING :a\nb\r\n\nPING :c\r\n"
+						  inReadsOfSize:4096],
+						  (@[ @"PING :a\nb\r\n", @"\nPING :c\r\n" ]));
+}
+
+-(void) testBufferIsCompactedAndGrown {
+	// (Many times the buffer’s capacity, in lines that straddle reads.)
+	NSMutableString *lines = [NSMutableString string];
+	for (NSUInteger i = 0; i < 2000; i++)
+		[lines appendFormat:@"PRIVMSG #channel :Message %lu\r\n", (unsigned long) i];
+
+	NSArray <NSString *> *received = [self receive:lines
+									 inReadsOfSize:1000];
+	XCTAssertEqual(received.count, (NSUInteger) 2000);
+	XCTAssertEqualObjects(received.lastObject, @"PRIVMSG #channel :Message 1999\r\n");
+
+	// (Without a line limit, a long line is kept whole.)
+	NSString *longLine = IRCClientReceiveBufferTestsLine(100000);
+	XCTAssertEqualObjects([self receive:longLine
+						  inReadsOfSize:4096], @[ longLine ]);
+}
+
+/****************************/
+#pragma mark - Overflow tests
+/****************************/
+
+-(void) testLineOfTheLimitIsKept {
+	_buffer.lineLimit = 512;
+
+	XCTAssertEqualObjects([self receive:IRCClientReceiveBufferTestsLine(512)
+						  inReadsOfSize:4096],
+						  @[ IRCClientReceiveBufferTestsLine(512) ]);
+	XCTAssertEqual(_buffer.linesDropped, (NSUInteger) 0);
+}
+
+-(void) testLongerLineIsDropped {
+	_buffer.lineLimit = 512;
+
+	XCTAssertEqualObjects([self receive:[NSString stringWithFormat:@"%@PING :after\r\n", IRCClientReceiveBufferTestsLine(513)]
+						  inReadsOfSize:4096],
+						  @[ @"PING :after\r\n" ]);
+	XCTAssertEqual(_buffer.linesDropped, (NSUInteger) 1);
+}
+
+-(void) testLongLineIsDroppedAsItComesIn {
+	_buffer.lineLimit = 512;
+
+	NSString *lines = [NSString stringWithFormat:@"PING :before\r\n%@%@PING :after\r\n",
+					   IRCClientReceiveBufferTestsLine(1000000),
+					   IRCClientReceiveBufferTestsLine(600)];
+	XCTAssertEqualObjects([self receive:lines
+						  inReadsOfSize:1000],
+						  (@[ @"PING :before\r\n", @"PING :after\r\n" ]));
+	XCTAssertEqual(_buffer.linesDropped, (NSUInteger) 2);
+
+	// (The buffer never held more than a read’s worth of it.)
+	XCTAssertLessThanOrEqual(_buffer.capacity, (NSUInteger) 8192);
+}
+
+-(void) testDroppedLineMayEndWithABareLineFeed {
+	// (Its CR may have been dropped along with the rest of it.)
+	_buffer.lineLimit = 512;
+
+	XCTAssertEqualObjects([self receive:[IRCClientReceiveBufferTestsLine(2000) stringByReplacingOccurrencesOfString:@"\r\n"
+																										withString:@"\n"]
+						  inReadsOfSize:1000], @[]);
+	XCTAssertEqualObjects([self receive:@"PING :after\r\n"
+						  inReadsOfSize:1000],
+						  @[ @"PING :after\r\n" ]);
+	XCTAssertEqual(_buffer.linesDropped, (NSUInteger) 1);
+}
+
+-(void) testInitializingResetsTheBuffer {
+	IRCClientReceiveBuffer buffer;
+	memset(&buffer, 0xff, sizeof(buffer));
+
+	IRCClientReceiveBufferInit(&buffer, 16);
+
+	XCTAssertEqual(buffer.capacity, (NSUInteger) 16);
+	XCTAssertEqual(buffer.start, (NSUInteger) 0);
+	XCTAssertEqual(buffer.end, (NSUInteger) 0);
+	XCTAssertEqual(buffer.lineLimit, (NSUInteger) 0);
+	XCTAssertFalse(buffer.discarding);
+	XCTAssertEqual(buffer.linesDropped, (NSUInteger) 0);
+
+	IRCClientReceiveBufferFree(&buffer);
+	XCTAssertEqual(buffer.capacity, (NSUInteger) 0);
+	XCTAssertTrue(buffer.bytes == NULL);
+}
+
+/********************************/
+#pragma mark - Backpressure tests
+/********************************/
+
+-(void) testReadingPausesUntilTheDelegateCatchesUp {
+	[self connect];
+	_session.inboundEventLimit = 20;
+
+	[self sendPrivateMessages:100
+					thenLines:@[]];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return _session.isReadingPaused;
+	}));
+
+	// (Long enough for anything more to have been delivered, if it were.)
+	[NSThread sleepForTimeInterval:0.2];
+	XCTAssertGreaterThanOrEqual(_delegate.batchedMessageCount, (NSUInteger) 20);
+	XCTAssertLessThan(_delegate.batchedMessageCount, (NSUInteger) 100);
+	XCTAssertGreaterThanOrEqual(_session.inboundEventsPending, (NSUInteger) 20);
+	XCTAssertGreaterThan(_session.inboundBytesPending, (NSUInteger) 0);
+
+	// Once the delegate is done with what it has, the rest comes in.
+	_delegate.consumesBatches = YES;
+	[_delegate consumeHeldBatchesOfSession:_session];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (_delegate.batchedMessageCount == 100);
+	}));
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (_session.inboundEventsPending == 0);
+	}));
+	XCTAssertFalse(_session.isReadingPaused);
+	XCTAssertTrue(_session.isConnected);
+}
+
+-(void) testOverflowMayDisconnect {
+	[self connect];
+	_session.inboundEventLimit = 20;
+	_session.inboundOverflowPolicy = IRCClientInboundOverflowDisconnect;
+
+	[self sendPrivateMessages:100
+					thenLines:@[]];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (_delegate.disconnectionCount == 1);
+	}));
+	XCTAssertLessThan(_delegate.batchedMessageCount, (NSUInteger) 100);
+}
+
+-(void) testOverflowMayDropMessages {
+	[self connect];
+	_session.inboundEventLimit = 20;
+	_session.inboundOverflowPolicy = IRCClientInboundOverflowDropMessages;
+
+	[self sendPrivateMessages:100
+					thenLines:@[ @"PING :flood" ]];
+
+	// (What the session keeps track of the connection with isn’t dropped.)
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return ([_server receivedLinesWithCommand:@"PONG"].count == 1);
+	}));
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (_delegate.batchedMessageCount + _session.inboundEventsDropped == 100);
+	}));
+	XCTAssertGreaterThan(_session.inboundEventsDropped, (NSUInteger) 0);
+	XCTAssertFalse(_session.isReadingPaused);
+	XCTAssertTrue(_session.isConnected);
+}
+
+-(void) testNothingIsPendingWithoutABudget {
+	[self connect];
+
+	[self sendPrivateMessages:100
+					thenLines:@[]];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (_delegate.batchedMessageCount == 100);
+	}));
+	XCTAssertEqual(_session.inboundEventsPending, (NSUInteger) 0);
+	XCTAssertFalse(_session.isReadingPaused);
+}
+
+@end
@@ -0,0 +1,189 @@
+//
+//	IRCClientReconnectTests.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <XCTest/XCTest.h>
+
+#import "IRCClientSession.h"
+#import "IRCClientSession_Private.h"
+#import "IRCClientTestServer.h"
+#import "IRCClientTestDelegate.h"
+
+/********************************************************/
+#pragma mark IRCClientReconnectTests class implementation
+/********************************************************/
+
+@interface IRCClientReconnectTests : XCTestCase
+
+@end
+
+@implementation IRCClientReconnectTests {
+	IRCClientTestServer *_server;
+	IRCClientTestDelegate *_delegate;
+	IRCClientSession *_session;
+}
+
+-(void) setUp {
+	_server = [IRCClientTestServer new];
+	_server.supportTokens = @[ @"TARGMAX=JOIN:4" ];
+	XCTAssertTrue([_server start]);
+
+	// Short delays, so that the tests don’t take long.
+	_delegate = [IRCClientTestDelegate new];
+	_session = [_server sessionWithNickname:@"bot"
+								  eventLoop:nil];
+	_session.delegate = _delegate;
+	_session.reconnects = YES;
+	_session.reconnectInitialDelay = 0.05;
+	_session.reconnectMaxDelay = 0.2;
+	[_session connect];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (_delegate.connectionCount == 1);
+	}));
+}
+
+-(void) tearDown {
+	[_session disconnect];
+	[_server stop];
+	_session = nil;
+	_server = nil;
+}
+
+/****************************/
+#pragma mark - Helper methods
+/****************************/
+
+-(NSUInteger) reconnectAttempts {
+	__block NSUInteger reconnectAttempts;
+	[_session performOnSessionQueueAndWait:^{
+		reconnectAttempts = _session.reconnectAttempts;
+	}];
+
+	return reconnectAttempts;
+}
+
+-(NSTimeInterval) lastRecoveryDuration {
+	__block NSTimeInterval lastRecoveryDuration;
+	[_session performOnSessionQueueAndWait:^{
+		lastRecoveryDuration = _session.lastRecoveryDuration;
+	}];
+
+	return lastRecoveryDuration;
+}
+
+/*******************/
+#pragma mark - Tests
+/*******************/
+
+-(void) testRejoinsEveryChannelAfterTheConnectionDrops {
+	static const NSUInteger ChannelCount = 10;
+
+	// One channel has a key (given when it was joined).
+	[_server setKey:@"secret"
+		 forChannel:@"#chan3"];
+	NSMutableSet <NSString *> *channelNames = [NSMutableSet set];
+	for (NSUInteger i = 0; i < ChannelCount; i++) {
+		NSString *channelName = [NSString stringWithFormat:@"#chan%lu", (unsigned long) i];
+		[channelNames addObject:channelName];
+		[_session join:[channelName dataUsingEncoding:NSUTF8StringEncoding]
+				   key:(i == 3 ? [@"secret" dataUsingEncoding:NSUTF8StringEncoding] : nil)];
+	}
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (_delegate.joinedChannels.count == ChannelCount);
+	}));
+	NSUInteger joinsBefore = [_server receivedLinesWithCommand:@"JOIN"].count;
+	XCTAssertEqual([self lastRecoveryDuration], 0.0);
+
+	[_server dropConnections];
+
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (   _delegate.connectionCount == 2
+				&& _delegate.joinedChannels.count == 2 * ChannelCount);
+	}));
+	XCTAssertEqual(_delegate.disconnectionCount, (NSUInteger) 1);
+	XCTAssertEqual(_server.registrationCount, (NSUInteger) 2);
+
+	// The channels were rejoined in as few JOINs as TARGMAX allows, with the
+	// keyed channel first (so that its key lines up with it).
+	NSArray <NSString *> *joins = [_server receivedLinesWithCommand:@"JOIN"];
+	joins = [joins subarrayWithRange:NSMakeRange(joinsBefore, joins.count - joinsBefore)];
+	XCTAssertEqual(joins.count, (NSUInteger) 3);
+	XCTAssertTrue([joins.firstObject hasPrefix:@"JOIN #chan3,"]);
+	XCTAssertTrue([joins.firstObject hasSuffix:@" secret"]);
+
+	NSMutableSet <NSString *> *rejoined = [NSMutableSet set];
+	for (NSString *join in joins)
+		[rejoined addObjectsFromArray:[[join componentsSeparatedByString:@" "][1] componentsSeparatedByString:@","]];
+	XCTAssertEqualObjects(rejoined, channelNames);
+
+	// Recovery is complete once the last JOIN comes back.
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return ([self lastRecoveryDuration] > 0);
+	}));
+	XCTAssertEqual([self reconnectAttempts], (NSUInteger) 0);
+}
+
+-(void) testReconnectsWhenTheServerComesBack {
+	[_server stop];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (_delegate.disconnectionCount == 1);
+	}));
+
+	// While the server is down, attempts fail (and are counted).
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return ([self reconnectAttempts] >= 2);
+	}));
+
+	XCTAssertTrue([_server start]);
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (_delegate.connectionCount == 2);
+	}));
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return ([self lastRecoveryDuration] > 0);
+	}));
+	XCTAssertEqual([self reconnectAttempts], (NSUInteger) 0);
+}
+
+-(void) testGivesUpAfterTheMaximumAttempts {
+	_session.reconnectInitialDelay = 0.01;
+	_session.reconnectMaxDelay = 0.02;
+	_session.reconnectMaxAttempts = 3;
+
+	// From now on, the server accepts connections, but hangs up on them
+	// before they can register.
+	_server.lineHandler = ^BOOL (IRCClientTestConnection *connection,
+								 NSString *line) {
+		[connection close];
+		return YES;
+	};
+	[_server dropConnections];
+
+	// The connection that was dropped, and three attempts after it.
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (_server.acceptedConnectionCount == 4);
+	}));
+
+	// (Long enough for a fourth attempt, if there were going to be one.)
+	[NSThread sleepForTimeInterval:0.5];
+	XCTAssertEqual(_server.acceptedConnectionCount, (NSUInteger) 4);
+	XCTAssertEqual(_delegate.connectionCount, (NSUInteger) 1);
+	XCTAssertFalse(_session.isConnected);
+}
+
+-(void) testDoesNotReconnectAfterDisconnecting {
+	[_session disconnect];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (_delegate.disconnectionCount == 1);
+	}));
+
+	[NSThread sleepForTimeInterval:0.5];
+	XCTAssertEqual(_server.acceptedConnectionCount, (NSUInteger) 1);
+	XCTAssertEqual([self reconnectAttempts], (NSUInteger) 0);
+}
+
+@end
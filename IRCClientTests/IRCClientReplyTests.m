@@ -0,0 +1,530 @@
+//
+//	IRCClientReplyTests.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <XCTest/XCTest.h>
+
+#import "IRCClientSession.h"
+#import "IRCClientReply.h"
+#import "IRCClientReply_Private.h"
+#import "IRCClientEventBatch.h"
+#import "IRCClientMessage.h"
+#import "IRCClientTestServer.h"
+#import "IRCClientTestDelegate.h"
+
+/****************************/
+#pragma mark Helper functions
+/****************************/
+
+static NSData *IRCClientReplyTestsData(NSString *string) {
+	return [string dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+// Returns the given column of every row of the reply, as strings.
+static NSArray <NSString *> *IRCClientReplyTestsColumn(IRCClientReply *reply,
+													   NSUInteger column) {
+	NSMutableArray <NSString *> *values = [NSMutableArray arrayWithCapacity:reply.count];
+	for (NSUInteger i = 0; i < reply.count; i++)
+		[values addObject:[[NSString alloc] initWithData:[reply valueOfColumn:column
+																	  atIndex:i]
+												encoding:NSUTF8StringEncoding]];
+
+	return values;
+}
+
+/***********************************************************/
+#pragma mark - IRCClientReplyTestsDelegate class declaration
+/***********************************************************/
+
+// A test delegate that keeps track of the numeric replies it’s sent.
+@interface IRCClientReplyTestsDelegate : IRCClientTestDelegate
+
+/**	The codes of the numeric replies received (in the order received). */
+@property (readonly) NSArray <NSNumber *> *numericCodes;
+
+@end
+
+/**************************************************************/
+#pragma mark - IRCClientReplyTestsDelegate class implementation
+/**************************************************************/
+
+@implementation IRCClientReplyTestsDelegate {
+	// Guarded by @synchronized (self).
+	NSMutableArray <NSNumber *> *_numericCodes;
+}
+
+-(instancetype) init {
+	if (!(self = [super init]))
+		return nil;
+
+	_numericCodes = [NSMutableArray array];
+
+	return self;
+}
+
+-(NSArray <NSNumber *> *) numericCodes {
+	@synchronized (self) {
+		return [_numericCodes copy];
+	}
+}
+
+-(void) numericEventReceived:(NSUInteger)event
+						from:(NSData *)origin
+					  params:(NSArray <NSData *> *)params
+					 session:(IRCClientSession *)session {
+	@synchronized (self) {
+		[_numericCodes addObject:@(event)];
+	}
+}
+
+@end
+
+/******************************************************/
+#pragma mark - IRCClientReplyTests class implementation
+/******************************************************/
+
+@interface IRCClientReplyTests : XCTestCase
+
+@end
+
+@implementation IRCClientReplyTests {
+	IRCClientTestServer *_server;
+	IRCClientReplyTestsDelegate *_delegate;
+	IRCClientSession *_session;
+	IRCClientTestConnection *_connection;
+
+	// Guarded by @synchronized (self).
+	// The lines that the server answers each request line with.
+	NSMutableDictionary <NSString *, NSArray <NSString *> *> *_answers;
+	// The replies that requests have been completed with (NSNull for nil).
+	NSMutableArray *_replies;
+}
+
+-(void) setUp {
+	_answers = [NSMutableDictionary dictionary];
+	_replies = [NSMutableArray array];
+
+	_server = [IRCClientTestServer new];
+	_server.lineHandler = ^BOOL (IRCClientTestConnection *connection,
+								 NSString *line) {
+		return [self serverConnection:connection
+						 receivedLine:line];
+	};
+	XCTAssertTrue([_server start]);
+
+	_delegate = [IRCClientReplyTestsDelegate new];
+	_session = [_server sessionWithNickname:@"reader"
+								  eventLoop:nil];
+	_session.delegate = _delegate;
+}
+
+-(void) tearDown {
+	[_session disconnect];
+	[_server stop];
+	_session = nil;
+	_server = nil;
+}
+
+/****************************/
+#pragma mark - Helper methods
+/****************************/
+
+// (On the server’s queue.)
+-(BOOL) serverConnection:(IRCClientTestConnection *)connection
+			receivedLine:(NSString *)line {
+	BOOL request = NO;
+	for (NSString *command in @[ @"NAMES ", @"WHO ", @"LIST", @"CHATHISTORY " ])
+		if ([line hasPrefix:command])
+			request = YES;
+	if (request == NO)
+		return NO;
+
+	NSArray <NSString *> *answer;
+	@synchronized (self) {
+		answer = _answers[line];
+	}
+
+	// (A request with no answer goes unanswered.)
+	if (answer.count > 0) {
+		NSMutableData *data = [NSMutableData data];
+		for (NSString *answerLine in answer)
+			[data appendData:IRCClientReplyTestsData([answerLine stringByAppendingString:@"\r\n"])];
+		[connection sendData:data];
+	}
+
+	return YES;
+}
+
+-(void) answer:(NSString *)requestLine
+		  with:(NSArray <NSString *> *)lines {
+	@synchronized (self) {
+		_answers[requestLine] = lines;
+	}
+}
+
+-(void) connect {
+	[_session connect];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (_delegate.connectionCount == 1);
+	}));
+
+	_connection = [_server connectionForNick:@"reader"];
+	XCTAssertNotNil(_connection);
+}
+
+-(IRCClientReplyHandler) replyRecorder {
+	return ^(IRCClientReply *reply,
+			 IRCClientSession *session) {
+		@synchronized (self) {
+			[_replies addObject:(reply ?: [NSNull null])];
+		}
+	};
+}
+
+// Waits until the given number of replies are in, and returns them.
+-(NSArray *) waitForReplies:(NSUInteger)count {
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		@synchronized (self) {
+			return (_replies.count >= count);
+		}
+	}));
+
+	@synchronized (self) {
+		return [_replies copy];
+	}
+}
+
+/*************************/
+#pragma mark - Table tests
+/*************************/
+
+-(void) testRowsAreStoredByColumn {
+	IRCClientReply *reply = [[IRCClientReply alloc] initWithType:IRCClientReplyList
+														  target:nil
+													  completion:nil];
+	XCTAssertEqual(reply.count, (NSUInteger) 0);
+	XCTAssertEqual(reply.columnCount, (NSUInteger) 3);
+
+	for (NSString *line in @[ @":irc.test 322 reader #one 5 :First topic", @":irc.test 322 reader #two 7" ]) {
+		NSData *data = IRCClientReplyTestsData(line);
+		IRCClientMessage message;
+		XCTAssertTrue(IRCClientMessageParse(data.bytes, data.length, &message));
+
+		NSRange fields[] = {
+			[IRCClientListColumnChannel]	= IRCClientMessageParamRange(&message, 1),
+			[IRCClientListColumnUsers]		= IRCClientMessageParamRange(&message, 2),
+			[IRCClientListColumnTopic]		= IRCClientMessageParamRange(&message, 3)
+		};
+		[reply addRowWithRanges:fields
+					  ofMessage:&message];
+	}
+
+	XCTAssertEqual(reply.count, (NSUInteger) 2);
+	XCTAssertEqualObjects(IRCClientReplyTestsColumn(reply, IRCClientListColumnChannel), (@[ @"#one", @"#two" ]));
+	XCTAssertEqualObjects(IRCClientReplyTestsColumn(reply, IRCClientListColumnUsers), (@[ @"5", @"7" ]));
+	// (A missing field is empty.)
+	XCTAssertEqualObjects(IRCClientReplyTestsColumn(reply, IRCClientListColumnTopic), (@[ @"First topic", @"" ]));
+
+	// The fields are held one after another.
+	XCTAssertEqualObjects(reply.bytes, IRCClientReplyTestsData(@"#one5First topic#two7"));
+	const NSRange *channels = [reply rangesOfColumn:IRCClientListColumnChannel];
+	XCTAssertEqual(channels[1].location, (NSUInteger) 16);
+	XCTAssertEqual(channels[1].length, (NSUInteger) 4);
+}
+
+-(void) testOutOfBoundsAccessThrows {
+	IRCClientReply *reply = [[IRCClientReply alloc] initWithType:IRCClientReplyNames
+														  target:IRCClientReplyTestsData(@"#channel")
+													  completion:nil];
+
+	XCTAssertThrowsSpecificNamed([reply rangesOfColumn:2], NSException, NSRangeException);
+	XCTAssertThrowsSpecificNamed([reply valueOfColumn:IRCClientNamesColumnNick
+											  atIndex:0], NSException, NSRangeException);
+}
+
+-(void) testColumnCountDependsOnTheType {
+	NSUInteger columnCounts[] = {
+		[IRCClientReplyNames]	= 2,
+		[IRCClientReplyWho]		= 8,
+		[IRCClientReplyList]	= 3,
+		[IRCClientReplyHistory]	= 0
+	};
+	for (IRCClientReplyType type = IRCClientReplyNames; type <= IRCClientReplyHistory; type++) {
+		IRCClientReply *reply = [[IRCClientReply alloc] initWithType:type
+															  target:nil
+														  completion:nil];
+		XCTAssertEqual(reply.columnCount, columnCounts[type], @"%lu", (unsigned long) type);
+	}
+}
+
+/*****************************/
+#pragma mark - Gathering tests
+/*****************************/
+
+-(void) testNamesReplyIsGathered {
+	[self connect];
+	[self answer:@"NAMES #channel"
+			with:@[ @":irc.test 353 reader = #channel :@op +voiced",
+					@":irc.test 353 reader = #channel :plain reader",
+					@":irc.test 366 reader #channel :End of /NAMES list" ]];
+
+	[_session names:IRCClientReplyTestsData(@"#channel")
+		 completion:[self replyRecorder]];
+
+	IRCClientReply *reply = [self waitForReplies:1].firstObject;
+	XCTAssertEqual(reply.type, IRCClientReplyNames);
+	XCTAssertEqualObjects(reply.target, IRCClientReplyTestsData(@"#channel"));
+	XCTAssertNil(reply.failure);
+	XCTAssertEqualObjects(IRCClientReplyTestsColumn(reply, IRCClientNamesColumnNick), (@[ @"op", @"voiced", @"plain", @"reader" ]));
+	XCTAssertEqualObjects(IRCClientReplyTestsColumn(reply, IRCClientNamesColumnPrefixes), (@[ @"@", @"+", @"", @"" ]));
+
+	// (The lines of the reply aren’t also sent to the delegate.)
+	XCTAssertFalse([_delegate.numericCodes containsObject:@353]);
+	XCTAssertFalse([_delegate.numericCodes containsObject:@366]);
+}
+
+-(void) testWhoReplyIsGathered {
+	[self connect];
+	[self answer:@"WHO #channel"
+			with:@[ @":irc.test 352 reader #channel one host.one irc.test first H@ :0 First User",
+					@":irc.test 352 reader #channel two host.two irc.test second G :3",
+					@":irc.test 315 reader #channel :End of WHO list" ]];
+
+	[_session who:IRCClientReplyTestsData(@"#channel")
+	   completion:[self replyRecorder]];
+
+	IRCClientReply *reply = [self waitForReplies:1].firstObject;
+	XCTAssertEqual(reply.type, IRCClientReplyWho);
+	XCTAssertNil(reply.failure);
+	XCTAssertEqual(reply.count, (NSUInteger) 2);
+	XCTAssertEqualObjects(IRCClientReplyTestsColumn(reply, IRCClientWhoColumnNick), (@[ @"first", @"second" ]));
+	XCTAssertEqualObjects(IRCClientReplyTestsColumn(reply, IRCClientWhoColumnUsername), (@[ @"one", @"two" ]));
+	XCTAssertEqualObjects(IRCClientReplyTestsColumn(reply, IRCClientWhoColumnHost), (@[ @"host.one", @"host.two" ]));
+	XCTAssertEqualObjects(IRCClientReplyTestsColumn(reply, IRCClientWhoColumnFlags), (@[ @"H@", @"G" ]));
+	// (The hop count and the realname share the trailing param; a reply
+	// without a realname has an empty one.)
+	XCTAssertEqualObjects(IRCClientReplyTestsColumn(reply, IRCClientWhoColumnHopCount), (@[ @"0", @"3" ]));
+	XCTAssertEqualObjects(IRCClientReplyTestsColumn(reply, IRCClientWhoColumnRealname), (@[ @"First User", @"" ]));
+
+	XCTAssertFalse([_delegate.numericCodes containsObject:@352]);
+	XCTAssertFalse([_delegate.numericCodes containsObject:@315]);
+}
+
+-(void) testLargeListIsOneReply {
+	[self connect];
+	NSMutableArray <NSString *> *lines = [NSMutableArray arrayWithObject:@":irc.test 321 reader Channel :Users  Name"];
+	for (NSUInteger i = 0; i < 5000; i++)
+		[lines addObject:[NSString stringWithFormat:@":irc.test 322 reader #channel%lu %lu :Topic %lu", (unsigned long) i, (unsigned long) i, (unsigned long) i]];
+	[lines addObject:@":irc.test 323 reader :End of /LIST"];
+	[self answer:@"LIST"
+			with:lines];
+
+	[_session list:nil
+		completion:[self replyRecorder]];
+
+	IRCClientReply *reply = [self waitForReplies:1].firstObject;
+	XCTAssertEqual(reply.type, IRCClientReplyList);
+	XCTAssertNil(reply.failure);
+	XCTAssertEqual(reply.count, (NSUInteger) 5000);
+	XCTAssertEqualObjects([reply valueOfColumn:IRCClientListColumnChannel
+									   atIndex:4999], IRCClientReplyTestsData(@"#channel4999"));
+	XCTAssertEqualObjects([reply valueOfColumn:IRCClientListColumnTopic
+									   atIndex:0], IRCClientReplyTestsData(@"Topic 0"));
+
+	for (NSNumber *code in @[ @321, @322, @323 ])
+		XCTAssertFalse([_delegate.numericCodes containsObject:code], @"%@", code);
+}
+
+-(void) testRepliesAreMatchedToRequestsInOrder {
+	[self connect];
+	[self answer:@"WHO alpha"
+			with:@[ @":irc.test 352 reader * a host irc.test alpha H :0 Alpha",
+					@":irc.test 315 reader alpha :End of WHO list" ]];
+	[self answer:@"WHO beta"
+			with:@[ @":irc.test 315 reader beta :End of WHO list" ]];
+
+	[_session who:IRCClientReplyTestsData(@"alpha")
+	   completion:[self replyRecorder]];
+	[_session who:IRCClientReplyTestsData(@"beta")
+	   completion:[self replyRecorder]];
+
+	NSArray <IRCClientReply *> *replies = [self waitForReplies:2];
+	XCTAssertEqualObjects(replies[0].target, IRCClientReplyTestsData(@"alpha"));
+	XCTAssertEqual(replies[0].count, (NSUInteger) 1);
+	XCTAssertEqualObjects(replies[1].target, IRCClientReplyTestsData(@"beta"));
+	XCTAssertEqual(replies[1].count, (NSUInteger) 0);
+}
+
+-(void) testChatHistoryIsGathered {
+	[self connect];
+	[self answer:@"CHATHISTORY LATEST #channel * 10"
+			with:@[ @":irc.test BATCH +history chathistory #channel",
+					@"@batch=history;time=2021-01-01T00:00:00.000Z :friend!user@host PRIVMSG #channel :one",
+					@"@batch=history;time=2021-01-01T00:00:01.000Z :friend!user@host PRIVMSG #channel :two",
+					@":irc.test BATCH -history" ]];
+
+	[_session chatHistory:IRCClientReplyTestsData(@"#channel")
+					limit:10
+			   completion:[self replyRecorder]];
+
+	IRCClientReply *reply = [self waitForReplies:1].firstObject;
+	XCTAssertEqual(reply.type, IRCClientReplyHistory);
+	XCTAssertNil(reply.failure);
+	XCTAssertEqual(reply.count, (NSUInteger) 2);
+	XCTAssertEqualObjects(reply.messages.batchType, IRCClientReplyTestsData(@"chathistory"));
+	XCTAssertEqualObjects([reply.messages commandOfMessageAtIndex:1], IRCClientReplyTestsData(@"PRIVMSG"));
+}
+
+/***********************************/
+#pragma mark - Refused request tests
+/***********************************/
+
+-(void) testNoSuchChannelEndsTheReply {
+	[self connect];
+	[self answer:@"NAMES #nowhere"
+			with:@[ @":irc.test 403 reader #nowhere :No such channel" ]];
+
+	[_session names:IRCClientReplyTestsData(@"#nowhere")
+		 completion:[self replyRecorder]];
+
+	IRCClientReply *reply = [self waitForReplies:1].firstObject;
+	XCTAssertEqualObjects(reply.failure, IRCClientReplyTestsData(@"403"));
+	XCTAssertEqual(reply.count, (NSUInteger) 0);
+	XCTAssertFalse([_delegate.numericCodes containsObject:@403]);
+}
+
+-(void) testTryAgainEndsTheReply {
+	[self connect];
+	[self answer:@"LIST"
+			with:@[ @":irc.test 263 reader LIST :Please wait a while and try again." ]];
+
+	[_session list:nil
+		completion:[self replyRecorder]];
+
+	IRCClientReply *reply = [self waitForReplies:1].firstObject;
+	XCTAssertEqualObjects(reply.failure, IRCClientReplyTestsData(@"263"));
+	XCTAssertEqual(reply.count, (NSUInteger) 0);
+}
+
+-(void) testReplyCutShortKeepsItsRows {
+	[self connect];
+	[self answer:@"WHO *"
+			with:@[ @":irc.test 352 reader * one host irc.test first H :0 First",
+					@":irc.test 352 reader * two host irc.test second H :0 Second",
+					@":irc.test 416 reader WHO * :Output too long" ]];
+
+	[_session who:IRCClientReplyTestsData(@"*")
+	   completion:[self replyRecorder]];
+
+	IRCClientReply *reply = [self waitForReplies:1].firstObject;
+	XCTAssertEqualObjects(reply.failure, IRCClientReplyTestsData(@"416"));
+	XCTAssertEqual(reply.count, (NSUInteger) 2);
+}
+
+-(void) testNoPrivilegesEndsTheOldestReply {
+	[self connect];
+	[self answer:@"WHO alpha"
+			with:@[ @":irc.test 481 reader :Permission Denied- You're not an IRC operator" ]];
+	[self answer:@"LIST"
+			with:@[ @":irc.test 321 reader Channel :Users  Name",
+					@":irc.test 323 reader :End of /LIST" ]];
+
+	[_session who:IRCClientReplyTestsData(@"alpha")
+	   completion:[self replyRecorder]];
+	[_session list:nil
+		completion:[self replyRecorder]];
+
+	NSArray <IRCClientReply *> *replies = [self waitForReplies:2];
+	XCTAssertEqual(replies[0].type, IRCClientReplyWho);
+	XCTAssertEqualObjects(replies[0].failure, IRCClientReplyTestsData(@"481"));
+	XCTAssertEqual(replies[1].type, IRCClientReplyList);
+	XCTAssertNil(replies[1].failure);
+}
+
+-(void) testUnrelatedErrorIsPassedOn {
+	[self connect];
+
+	[_session names:IRCClientReplyTestsData(@"#channel")
+		 completion:[self replyRecorder]];
+
+	// (An error about some other target isn’t the reply to this request.)
+	XCTAssertTrue([_delegate sendLines:@[ @":irc.test 403 reader #other :No such channel" ]
+						  toConnection:_connection]);
+	XCTAssertTrue([_delegate.numericCodes containsObject:@403]);
+	@synchronized (self) {
+		XCTAssertEqual(_replies.count, (NSUInteger) 0);
+	}
+
+	XCTAssertTrue([_delegate sendLines:@[ @":irc.test 366 reader #channel :End of /NAMES list" ]
+						  toConnection:_connection]);
+	IRCClientReply *reply = [self waitForReplies:1].firstObject;
+	XCTAssertNil(reply.failure);
+	XCTAssertEqual(reply.count, (NSUInteger) 0);
+}
+
+-(void) testFailedChatHistoryEndsTheReply {
+	[self connect];
+	[self answer:@"CHATHISTORY LATEST #channel * 10"
+			with:@[ @":irc.test FAIL CHATHISTORY INVALID_TARGET LATEST #channel :Messages could not be retrieved" ]];
+
+	[_session chatHistory:IRCClientReplyTestsData(@"#channel")
+					limit:10
+			   completion:[self replyRecorder]];
+
+	IRCClientReply *reply = [self waitForReplies:1].firstObject;
+	XCTAssertEqualObjects(reply.failure, IRCClientReplyTestsData(@"INVALID_TARGET"));
+	XCTAssertNil(reply.messages);
+}
+
+/******************************/
+#pragma mark - Connection tests
+/******************************/
+
+-(void) testLostConnectionEndsPendingReplies {
+	[self connect];
+
+	// (No answer comes.)
+	[_session who:IRCClientReplyTestsData(@"alpha")
+	   completion:[self replyRecorder]];
+	[_session names:IRCClientReplyTestsData(@"#channel")
+		 completion:[self replyRecorder]];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return ([_server receivedLinesWithCommand:@"NAMES"].count == 1);
+	}));
+
+	[_connection close];
+
+	XCTAssertEqualObjects([self waitForReplies:2], (@[ [NSNull null], [NSNull null] ]));
+}
+
+-(void) testRequestWhileDisconnectedEndsAtOnce {
+	[_session who:IRCClientReplyTestsData(@"alpha")
+	   completion:[self replyRecorder]];
+
+	XCTAssertEqualObjects([self waitForReplies:1], @[ [NSNull null] ]);
+}
+
+-(void) testRequestsWithoutATargetAreRefused {
+	[self connect];
+
+	XCTAssertNotEqual([_session names:nil
+						   completion:[self replyRecorder]], 0);
+	XCTAssertNotEqual([_session who:IRCClientReplyTestsData(@"")
+						 completion:[self replyRecorder]], 0);
+	XCTAssertNotEqual([_session chatHistory:IRCClientReplyTestsData(@"#channel")
+									  limit:0
+								 completion:[self replyRecorder]], 0);
+
+	// (Nothing was asked, so nothing is answered.)
+	[NSThread sleepForTimeInterval:0.2];
+	@synchronized (self) {
+		XCTAssertEqual(_replies.count, (NSUInteger) 0);
+	}
+}
+
+@end
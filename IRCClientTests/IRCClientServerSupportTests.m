@@ -0,0 +1,305 @@
+//
+//	IRCClientServerSupportTests.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <XCTest/XCTest.h>
+
+#import "IRCClientServerSupport.h"
+#import "IRCClientSession_Private.h"
+
+/****************************/
+#pragma mark Helper functions
+/****************************/
+
+// Compares field by field (the structs’ padding isn’t initialized).
+static BOOL IRCClientServerSupportTestsIsEqual(const IRCClientServerSupport *support,
+											   const IRCClientServerSupport *otherSupport) {
+	return (   memcmp(support->channelTypes, otherSupport->channelTypes, sizeof(support->channelTypes)) == 0
+			&& support->prefixes.count == otherSupport->prefixes.count
+			&& memcmp(support->prefixes.modes, otherSupport->prefixes.modes, support->prefixes.count) == 0
+			&& memcmp(support->prefixes.symbols, otherSupport->prefixes.symbols, support->prefixes.count) == 0
+			&& memcmp(support->channelModeTypes, otherSupport->channelModeTypes, sizeof(support->channelModeTypes)) == 0
+			&& support->caseMapping == otherSupport->caseMapping
+			&& memcmp(support->caseFold, otherSupport->caseFold, sizeof(support->caseFold)) == 0
+			&& memcmp(support->targetLimits, otherSupport->targetLimits, sizeof(support->targetLimits)) == 0
+			&& support->lineLength == otherSupport->lineLength
+			&& support->modesPerCommand == otherSupport->modesPerCommand);
+}
+
+/**************************************************************/
+#pragma mark - IRCClientServerSupportTests class implementation
+/**************************************************************/
+
+@interface IRCClientServerSupportTests : XCTestCase
+
+@end
+
+@implementation IRCClientServerSupportTests {
+	IRCClientServerSupport _support;
+}
+
+-(void) setUp {
+	IRCClientServerSupportInit(&_support);
+}
+
+/****************************/
+#pragma mark - Helper methods
+/****************************/
+
+-(void) apply:(NSString *)token {
+	IRCClientServerSupportApplyToken(&_support, (const uint8_t *) token.UTF8String, strlen(token.UTF8String));
+}
+
+-(BOOL) isChannelType:(char)byte {
+	return IRCClientServerSupportIsChannelType(&_support, (uint8_t) byte);
+}
+
+-(IRCClientChannelModeType) typeOfMode:(char)mode {
+	return IRCClientServerSupportChannelModeType(&_support, (uint8_t) mode);
+}
+
+/***************************/
+#pragma mark - Default tests
+/***************************/
+
+-(void) testDefaultsAreTheRFCs {
+	for (char byte = 0; byte < 127; byte++)
+		XCTAssertEqual([self isChannelType:byte], (BOOL) (byte != 0 && strchr("#&!+", byte) != NULL), @"%d", byte);
+
+	XCTAssertEqual(_support.prefixes.count, (NSUInteger) 2);
+	XCTAssertEqual(IRCClientChannelPrefixIndex(&_support.prefixes, '@'), (NSUInteger) 0);
+	XCTAssertEqual(IRCClientChannelPrefixIndex(&_support.prefixes, '+'), (NSUInteger) 1);
+
+	XCTAssertEqual([self typeOfMode:'b'], IRCClientChannelModeTypeList);
+	XCTAssertEqual([self typeOfMode:'k'], IRCClientChannelModeTypeParameter);
+	XCTAssertEqual([self typeOfMode:'l'], IRCClientChannelModeTypeParameterWhenSet);
+	XCTAssertEqual([self typeOfMode:'n'], IRCClientChannelModeTypeFlag);
+	XCTAssertEqual([self typeOfMode:'o'], IRCClientChannelModeTypeMembership);
+	XCTAssertEqual([self typeOfMode:'Z'], IRCClientChannelModeTypeUnknown);
+
+	XCTAssertEqual(_support.caseMapping, IRCClientCaseMappingRFC1459);
+	XCTAssertEqual(_support.targetLimits[IRCClientTargetCommandPRIVMSG], (NSUInteger) 1);
+	XCTAssertEqual(_support.targetLimits[IRCClientTargetCommandJOIN], NSUIntegerMax);
+	XCTAssertEqual(_support.lineLength, (NSUInteger) IRCClientMaxLineLength);
+	XCTAssertEqual(_support.modesPerCommand, (NSUInteger) 3);
+}
+
+/***************************/
+#pragma mark - Channel tests
+/***************************/
+
+-(void) testChannelTypesAreReplaced {
+	[self apply:@"CHANTYPES=#$"];
+
+	XCTAssertTrue([self isChannelType:'#']);
+	XCTAssertTrue([self isChannelType:'$']);
+	XCTAssertFalse([self isChannelType:'&']);
+	XCTAssertFalse([self isChannelType:'+']);
+}
+
+-(void) testEmptyChannelTypesMeansNoChannels {
+	[self apply:@"CHANTYPES="];
+
+	XCTAssertFalse([self isChannelType:'#']);
+}
+
+-(void) testHighBytesCanBeChannelTypes {
+	const uint8_t token[] = { 'C', 'H', 'A', 'N', 'T', 'Y', 'P', 'E', 'S', '=', 0xff };
+	IRCClientServerSupportApplyToken(&_support, token, sizeof(token));
+
+	XCTAssertTrue(IRCClientServerSupportIsChannelType(&_support, 0xff));
+	XCTAssertFalse(IRCClientServerSupportIsChannelType(&_support, 0xfe));
+}
+
+-(void) testPrefixesAreReplaced {
+	[self apply:@"PREFIX=(qaohv)~&@%+"];
+
+	XCTAssertEqual(_support.prefixes.count, (NSUInteger) 5);
+	XCTAssertEqual(IRCClientChannelPrefixIndex(&_support.prefixes, '~'), (NSUInteger) 0);
+	XCTAssertEqual(IRCClientChannelPrefixIndex(&_support.prefixes, '%'), (NSUInteger) 3);
+	XCTAssertEqual(IRCClientChannelPrefixModeIndex(&_support.prefixes, 'h'), (NSUInteger) 3);
+	XCTAssertEqual(IRCClientChannelPrefixIndex(&_support.prefixes, '!'), (NSUInteger) NSNotFound);
+	XCTAssertEqual([self typeOfMode:'q'], IRCClientChannelModeTypeMembership);
+}
+
+-(void) testEmptyPrefixMeansNoPrefixes {
+	[self apply:@"PREFIX="];
+
+	XCTAssertEqual(_support.prefixes.count, (NSUInteger) 0);
+	XCTAssertEqual(IRCClientChannelPrefixIndex(&_support.prefixes, '@'), (NSUInteger) NSNotFound);
+}
+
+-(void) testMalformedPrefixIsIgnored {
+	for (NSString *token in @[ @"PREFIX=ov@+", @"PREFIX=(ov@+", @"PREFIX=(ov)@", @"PREFIX=(o)@+", @"PREFIX=(abcdefghijklmnopq)~!@#$%^&*()_+=-{}" ]) {
+		[self apply:token];
+
+		XCTAssertEqual(_support.prefixes.count, (NSUInteger) 2, @"%@", token);
+		XCTAssertEqual(IRCClientChannelPrefixIndex(&_support.prefixes, '@'), (NSUInteger) 0, @"%@", token);
+	}
+}
+
+-(void) testChannelModesAreTyped {
+	[self apply:@"CHANMODES=beI,kf,lj,CimnpstZ"];
+
+	XCTAssertEqual([self typeOfMode:'I'], IRCClientChannelModeTypeList);
+	XCTAssertEqual([self typeOfMode:'f'], IRCClientChannelModeTypeParameter);
+	XCTAssertEqual([self typeOfMode:'j'], IRCClientChannelModeTypeParameterWhenSet);
+	XCTAssertEqual([self typeOfMode:'Z'], IRCClientChannelModeTypeFlag);
+
+	// (Prefix modes are typed by the prefixes.)
+	XCTAssertEqual([self typeOfMode:'v'], IRCClientChannelModeTypeMembership);
+}
+
+-(void) testFurtherModeGroupsAreIgnored {
+	[self apply:@"CHANMODES=b,k,l,n,XY"];
+
+	XCTAssertEqual([self typeOfMode:'n'], IRCClientChannelModeTypeFlag);
+	XCTAssertEqual([self typeOfMode:'X'], IRCClientChannelModeTypeUnknown);
+}
+
+-(void) testHighModesAreUnknown {
+	const uint8_t token[] = { 'C', 'H', 'A', 'N', 'M', 'O', 'D', 'E', 'S', '=', ',', ',', ',', 0xe9 };
+	IRCClientServerSupportApplyToken(&_support, token, sizeof(token));
+
+	XCTAssertEqual(IRCClientServerSupportChannelModeType(&_support, 0xe9), IRCClientChannelModeTypeUnknown);
+}
+
+/********************************/
+#pragma mark - Case mapping tests
+/********************************/
+
+-(void) testCaseMappingIsApplied {
+	XCTAssertEqual(_support.caseFold['['], (uint8_t) '{');
+	XCTAssertEqual(_support.caseFold['^'], (uint8_t) '~');
+
+	[self apply:@"CASEMAPPING=strict-rfc1459"];
+	XCTAssertEqual(_support.caseMapping, IRCClientCaseMappingStrictRFC1459);
+	XCTAssertEqual(_support.caseFold['['], (uint8_t) '{');
+	XCTAssertEqual(_support.caseFold['^'], (uint8_t) '^');
+
+	[self apply:@"CASEMAPPING=ascii"];
+	XCTAssertEqual(_support.caseMapping, IRCClientCaseMappingASCII);
+	XCTAssertEqual(_support.caseFold['A'], (uint8_t) 'a');
+	XCTAssertEqual(_support.caseFold['['], (uint8_t) '[');
+
+	[self apply:@"CASEMAPPING=rfc7613"];
+	XCTAssertEqual(_support.caseMapping, IRCClientCaseMappingASCII);
+}
+
+-(void) testUnknownCaseMappingIsRFC1459 {
+	[self apply:@"CASEMAPPING=ascii"];
+	[self apply:@"CASEMAPPING=klingon"];
+
+	XCTAssertEqual(_support.caseMapping, IRCClientCaseMappingRFC1459);
+	XCTAssertEqual(_support.caseFold['['], (uint8_t) '{');
+}
+
+/*************************/
+#pragma mark - Limit tests
+/*************************/
+
+-(void) testTargetLimitsAreSet {
+	[self apply:@"TARGMAX=PRIVMSG:4,NOTICE:3,JOIN:2,WHOIS:,KICK:1,PONG:9,NAMES"];
+
+	XCTAssertEqual(_support.targetLimits[IRCClientTargetCommandPRIVMSG], (NSUInteger) 4);
+	XCTAssertEqual(_support.targetLimits[IRCClientTargetCommandNOTICE], (NSUInteger) 3);
+	XCTAssertEqual(_support.targetLimits[IRCClientTargetCommandJOIN], (NSUInteger) 2);
+	XCTAssertEqual(_support.targetLimits[IRCClientTargetCommandKICK], (NSUInteger) 1);
+
+	// (An empty limit means no limit; a missing one changes nothing.)
+	XCTAssertEqual(_support.targetLimits[IRCClientTargetCommandWHOIS], NSUIntegerMax);
+	XCTAssertEqual(_support.targetLimits[IRCClientTargetCommandNAMES], (NSUInteger) 1);
+	XCTAssertEqual(_support.targetLimits[IRCClientTargetCommandPART], NSUIntegerMax);
+}
+
+-(void) testMaxTargetsIsForMessages {
+	[self apply:@"MAXTARGETS=5"];
+
+	XCTAssertEqual(_support.targetLimits[IRCClientTargetCommandPRIVMSG], (NSUInteger) 5);
+	XCTAssertEqual(_support.targetLimits[IRCClientTargetCommandNOTICE], (NSUInteger) 5);
+	XCTAssertEqual(_support.targetLimits[IRCClientTargetCommandKICK], (NSUInteger) 1);
+}
+
+-(void) testUnparseableLimitMeansNoLimit {
+	[self apply:@"MODES=lots"];
+	XCTAssertEqual(_support.modesPerCommand, NSUIntegerMax);
+
+	[self apply:@"MODES=99999999999999999999999"];
+	XCTAssertEqual(_support.modesPerCommand, NSUIntegerMax);
+
+	[self apply:@"MODES=6"];
+	XCTAssertEqual(_support.modesPerCommand, (NSUInteger) 6);
+
+	[self apply:@"MODES"];
+	XCTAssertEqual(_support.modesPerCommand, NSUIntegerMax);
+}
+
+-(void) testLineLengthIsNeverLessThanTheRFCs {
+	[self apply:@"LINELEN=2048"];
+	XCTAssertEqual(_support.lineLength, (NSUInteger) 2048);
+
+	[self apply:@"LINELEN=100"];
+	XCTAssertEqual(_support.lineLength, (NSUInteger) 2048);
+
+	[self apply:@"LINELEN="];
+	XCTAssertEqual(_support.lineLength, (NSUInteger) 2048);
+
+	[self apply:@"-LINELEN"];
+	XCTAssertEqual(_support.lineLength, (NSUInteger) IRCClientMaxLineLength);
+}
+
+/****************************/
+#pragma mark - Negation tests
+/****************************/
+
+-(void) testNegatedTokensRestoreTheDefaults {
+	[self apply:@"CHANTYPES=$"];
+	[self apply:@"PREFIX=(qo)~@"];
+	[self apply:@"CHANMODES=,,,Z"];
+	[self apply:@"CASEMAPPING=ascii"];
+	[self apply:@"TARGMAX=PRIVMSG:4,KICK:4"];
+	[self apply:@"MODES=8"];
+
+	for (NSString *token in @[ @"-CHANTYPES", @"-PREFIX", @"-CHANMODES", @"-CASEMAPPING", @"-TARGMAX", @"-MODES" ])
+		[self apply:token];
+
+	IRCClientServerSupport defaults;
+	IRCClientServerSupportInit(&defaults);
+	XCTAssertTrue(IRCClientServerSupportTestsIsEqual(&_support, &defaults));
+}
+
+-(void) testNegatedMaxTargetsIsOneTarget {
+	[self apply:@"MAXTARGETS=5"];
+	[self apply:@"-MAXTARGETS"];
+
+	XCTAssertEqual(_support.targetLimits[IRCClientTargetCommandPRIVMSG], (NSUInteger) 1);
+	XCTAssertEqual(_support.targetLimits[IRCClientTargetCommandNOTICE], (NSUInteger) 1);
+}
+
+/*********************************/
+#pragma mark - Unknown token tests
+/*********************************/
+
+-(void) testUnknownTokensAreIgnored {
+	IRCClientServerSupport before = _support;
+
+	for (NSString *token in @[ @"NETWORK=Test", @"EXCEPTS", @"-WHOX", @"CHANTYPESX=$", @"chantypes=$", @"=#", @"-", @"PREFIX(ov)@+" ])
+		[self apply:token];
+
+	XCTAssertTrue(IRCClientServerSupportTestsIsEqual(&_support, &before));
+}
+
+-(void) testEmptyTokenIsIgnored {
+	IRCClientServerSupport before = _support;
+
+	IRCClientServerSupportApplyToken(&_support, (const uint8_t *) "", 0);
+
+	XCTAssertTrue(IRCClientServerSupportTestsIsEqual(&_support, &before));
+}
+
+@end
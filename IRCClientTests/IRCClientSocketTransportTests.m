@@ -0,0 +1,273 @@
+//
+//	IRCClientSocketTransportTests.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <XCTest/XCTest.h>
+
+#import "IRCClientSession.h"
+#import "IRCClientSocketTransport.h"
+#import "IRCClientTestServer.h"
+#import "IRCClientTestDelegate.h"
+
+#import <sys/socket.h>
+#import <netinet/in.h>
+#import <arpa/inet.h>
+
+/****************************/
+#pragma mark Helper functions
+/****************************/
+
+// Returns the struct sockaddr for the given (numeric) IPv4 or IPv6 address
+// and port.
+static NSData *IRCClientSocketTransportTestsAddress(NSString *host,
+													NSUInteger port) {
+	struct sockaddr_in address4 = { .sin_len = sizeof(address4), .sin_family = AF_INET, .sin_port = htons((uint16_t) port) };
+	if (inet_pton(AF_INET, host.UTF8String, &address4.sin_addr) == 1)
+		return [NSData dataWithBytes:&address4
+							  length:sizeof(address4)];
+
+	struct sockaddr_in6 address6 = { .sin6_len = sizeof(address6), .sin6_family = AF_INET6, .sin6_port = htons((uint16_t) port) };
+	if (inet_pton(AF_INET6, host.UTF8String, &address6.sin6_addr) == 1)
+		return [NSData dataWithBytes:&address6
+							  length:sizeof(address6)];
+
+	return nil;
+}
+
+// Returns a resolver that, after the given delay, comes up with the given
+// addresses (or error).
+static IRCClientResolver IRCClientSocketTransportTestsResolver(NSTimeInterval delay,
+															   NSArray <NSData *> *addresses,
+															   NSError *error) {
+	return ^(NSString *host, NSUInteger port, IRCClientResolverCompletion completion) {
+		dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t) (delay * NSEC_PER_SEC)),
+					   dispatch_get_global_queue(QOS_CLASS_DEFAULT, 0), ^{
+			completion(addresses, error);
+		});
+	};
+}
+
+/****************************************************************/
+#pragma mark - IRCClientSocketTransportTests class implementation
+/****************************************************************/
+
+@interface IRCClientSocketTransportTests : XCTestCase <IRCClientTransportDelegate>
+
+@end
+
+@implementation IRCClientSocketTransportTests {
+	IRCClientTestServer *_server;
+
+	IRCClientSocketTransport *_transport;
+	dispatch_queue_t _queue;
+
+	// What the transport has told us (guarded by @synchronized (self)).
+	BOOL _opened;
+	NSError *_failure;
+}
+
+-(void) setUp {
+	_server = [IRCClientTestServer new];
+	XCTAssertTrue([_server start]);
+
+	_transport = [IRCClientSocketTransport new];
+	_transport.delegate = self;
+	_queue = dispatch_queue_create("IRCClientSocketTransportTests", DISPATCH_QUEUE_SERIAL);
+}
+
+-(void) tearDown {
+	dispatch_sync(_queue, ^{
+		[_transport close];
+	});
+	_transport = nil;
+
+	[_server stop];
+	_server = nil;
+}
+
+/****************************/
+#pragma mark - Helper methods
+/****************************/
+
+-(void) open {
+	dispatch_async(_queue, ^{
+		[_transport openToHost:@"irc.test"
+						  port:_server.port
+						 queue:_queue];
+	});
+}
+
+-(BOOL) opened {
+	@synchronized (self) {
+		return _opened;
+	}
+}
+
+-(NSError *) failure {
+	@synchronized (self) {
+		return _failure;
+	}
+}
+
+// Returns a port on the given loopback address that refuses connections.
+-(NSUInteger) refusingPortForFamily:(int)family {
+	IRCClientTestServer *server = [[IRCClientTestServer alloc] initWithFamily:family];
+	XCTAssertTrue([server start]);
+	NSUInteger port = server.port;
+	[server stop];
+
+	return port;
+}
+
+/****************************************/
+#pragma mark - IRCClientTransportDelegate
+/****************************************/
+
+-(void) transportDidOpen:(id <IRCClientTransport>)transport {
+	@synchronized (self) {
+		_opened = YES;
+	}
+}
+
+-(void) transportHasBytesAvailable:(id <IRCClientTransport>)transport {
+}
+
+-(void) transportHasSpaceAvailable:(id <IRCClientTransport>)transport {
+}
+
+-(void) transport:(id <IRCClientTransport>)transport
+ didFailWithError:(NSError *)error {
+	@synchronized (self) {
+		_failure = error ?: [NSError errorWithDomain:NSPOSIXErrorDomain
+												code:ECONNRESET
+											userInfo:nil];
+	}
+}
+
+/*******************/
+#pragma mark - Tests
+/*******************/
+
+-(void) testSystemResolverFillsInThePort {
+	XCTestExpectation *resolved = [self expectationWithDescription:@"resolved"];
+	[IRCClientSocketTransport systemResolver](@"localhost", 6697, ^(NSArray <NSData *> *addresses, NSError *error) {
+		XCTAssertNil(error);
+		XCTAssertGreaterThan(addresses.count, (NSUInteger) 0);
+		for (NSData *address in addresses) {
+			const struct sockaddr *socketAddress = address.bytes;
+			in_port_t port = (socketAddress->sa_family == AF_INET6
+							  ? ((const struct sockaddr_in6 *) socketAddress)->sin6_port
+							  : ((const struct sockaddr_in *) socketAddress)->sin_port);
+			XCTAssertEqual(ntohs(port), 6697);
+		}
+		[resolved fulfill];
+	});
+	[self waitForExpectationsWithTimeout:10
+								 handler:nil];
+}
+
+-(void) testSlowResolverIsTimed {
+	_transport.resolver = IRCClientSocketTransportTestsResolver(0.2, @[ IRCClientSocketTransportTestsAddress(_server.host, _server.port) ], nil);
+	[self open];
+
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return self.opened;
+	}));
+	XCTAssertGreaterThanOrEqual(_transport.resolveDuration, 0.2);
+	XCTAssertLessThan(_transport.connectDuration, 0.2);
+}
+
+-(void) testResolverErrorIsReported {
+	NSError *error = [NSError errorWithDomain:NSPOSIXErrorDomain
+										 code:EHOSTUNREACH
+									 userInfo:nil];
+	_transport.resolver = IRCClientSocketTransportTestsResolver(0, nil, error);
+	[self open];
+
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (self.failure != nil);
+	}));
+	XCTAssertEqualObjects(self.failure, error);
+	XCTAssertFalse(self.opened);
+}
+
+-(void) testRefusedAddressIsSkippedAtOnce {
+	// The IPv6 address refuses; the IPv4 one is tried next, without waiting
+	// out the (long) attempt delay.
+	_transport.connectionAttemptDelay = 10;
+	_transport.resolver = IRCClientSocketTransportTestsResolver(0, @[ IRCClientSocketTransportTestsAddress(@"::1", [self refusingPortForFamily:AF_INET6]),
+																	  IRCClientSocketTransportTestsAddress(_server.host, _server.port) ], nil);
+	[self open];
+
+	XCTAssertTrue(IRCClientTestWaitUntil(5, ^BOOL {
+		return self.opened;
+	}));
+	XCTAssertLessThan(_transport.connectDuration, 1.0);
+	XCTAssertTrue(IRCClientTestWaitUntil(5, ^BOOL {
+		return (_server.connectionCount == 1);
+	}));
+}
+
+-(void) testUnresponsiveAddressIsRacedPast {
+	// Nothing answers at 192.0.2.1 (TEST-NET-1), so the attempt there either
+	// hangs or fails; either way, the next address is tried within the
+	// attempt delay, and wins.
+	_transport.connectionAttemptDelay = 0.1;
+	_transport.resolver = IRCClientSocketTransportTestsResolver(0, @[ IRCClientSocketTransportTestsAddress(@"192.0.2.1", _server.port),
+																	  IRCClientSocketTransportTestsAddress(_server.host, _server.port) ], nil);
+	[self open];
+
+	XCTAssertTrue(IRCClientTestWaitUntil(5, ^BOOL {
+		return self.opened;
+	}));
+	XCTAssertLessThan(_transport.connectDuration, 1.0);
+	XCTAssertNil(self.failure);
+}
+
+-(void) testEveryAddressRefusingFails {
+	_transport.connectionAttemptDelay = 10;
+	_transport.resolver = IRCClientSocketTransportTestsResolver(0, @[ IRCClientSocketTransportTestsAddress(@"::1", [self refusingPortForFamily:AF_INET6]),
+																	  IRCClientSocketTransportTestsAddress(@"127.0.0.1", [self refusingPortForFamily:AF_INET]) ], nil);
+	[self open];
+
+	XCTAssertTrue(IRCClientTestWaitUntil(5, ^BOOL {
+		return (self.failure != nil);
+	}));
+	XCTAssertEqualObjects(self.failure.domain, NSPOSIXErrorDomain);
+	XCTAssertEqual(self.failure.code, ECONNREFUSED);
+	XCTAssertFalse(self.opened);
+}
+
+-(void) testSessionReportsPhaseTimings {
+	IRCClientTestDelegate *delegate = [IRCClientTestDelegate new];
+	IRCClientSession *session = [_server sessionWithNickname:@"timed"
+												   eventLoop:nil];
+	session.delegate = delegate;
+
+	IRCClientSocketTransport *transport = [IRCClientSocketTransport new];
+	transport.resolver = IRCClientSocketTransportTestsResolver(0.2, @[ IRCClientSocketTransportTestsAddress(_server.host, _server.port) ], nil);
+	session.transport = transport;
+
+	// Connecting doesn’t wait for the lookup.
+	NSDate *start = [NSDate date];
+	[session connect];
+	XCTAssertLessThan(-start.timeIntervalSinceNow, 0.1);
+
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (delegate.connectionCount == 1);
+	}));
+	IRCClientConnectionTimings timings = delegate.connectionTimings;
+	XCTAssertGreaterThanOrEqual(timings.resolve, 0.2);
+	XCTAssertGreaterThanOrEqual(timings.connect, 0.0);
+	XCTAssertEqual(timings.handshake, 0.0);
+	XCTAssertGreaterThan(timings.registration, 0.0);
+
+	[session disconnect];
+}
+
+@end
@@ -0,0 +1,303 @@
+//
+//	IRCClientTLSTransportTests.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <XCTest/XCTest.h>
+
+#import "IRCClientSession.h"
+#import "IRCClientSocketTransport.h"
+#import "IRCClientTLSTransport.h"
+#import "IRCClientTestServer.h"
+#import "IRCClientTestDelegate.h"
+
+/****************************/
+#pragma mark Helper functions
+/****************************/
+
+// Returns the public key digest (for pinnedPublicKeys) of the test server’s
+// own certificate.
+static NSData *IRCClientTLSTransportTestsServerKeyDigest(void) {
+	SecCertificateRef certificate = NULL;
+	SecIdentityCopyCertificate((__bridge SecIdentityRef) [IRCClientTestServer testIdentity].firstObject, &certificate);
+	NSData *digest = [IRCClientTLSTransport publicKeyDigestForCertificate:certificate];
+	CFRelease(certificate);
+
+	return digest;
+}
+
+/*************************************************************/
+#pragma mark - IRCClientTLSTransportTests class implementation
+/*************************************************************/
+
+@interface IRCClientTLSTransportTests : XCTestCase <IRCClientTransportDelegate>
+
+@end
+
+@implementation IRCClientTLSTransportTests {
+	IRCClientTestServer *_server;
+
+	IRCClientTLSTransport *_transport;
+	dispatch_queue_t _queue;
+
+	// What the transport has told us (guarded by @synchronized (self)).
+	BOOL _opened;
+	NSError *_failure;
+}
+
+-(void) setUp {
+	_server = [IRCClientTestServer new];
+	_server.identity = [IRCClientTestServer testIdentity];
+	XCTAssertNotNil(_server.identity);
+	XCTAssertTrue([_server start]);
+
+	_transport = [[IRCClientTLSTransport alloc] initWithTransport:[IRCClientSocketTransport new]];
+	_transport.anchorCertificates = @[ (__bridge id) [IRCClientTestServer testCertificateAuthority] ];
+	_transport.delegate = self;
+	_queue = dispatch_queue_create("IRCClientTLSTransportTests", DISPATCH_QUEUE_SERIAL);
+}
+
+-(void) tearDown {
+	dispatch_sync(_queue, ^{
+		[_transport close];
+	});
+	_transport = nil;
+
+	[_server stop];
+	_server = nil;
+}
+
+/****************************/
+#pragma mark - Helper methods
+/****************************/
+
+-(void) openToServer:(IRCClientTestServer *)server {
+	@synchronized (self) {
+		_opened = NO;
+		_failure = nil;
+	}
+
+	dispatch_async(_queue, ^{
+		[_transport openToHost:server.host
+						  port:server.port
+						 queue:_queue];
+	});
+}
+
+-(void) close {
+	dispatch_sync(_queue, ^{
+		[_transport close];
+	});
+}
+
+-(BOOL) opened {
+	@synchronized (self) {
+		return _opened;
+	}
+}
+
+-(NSError *) failure {
+	@synchronized (self) {
+		return _failure;
+	}
+}
+
+// Waits for the transport to open (or fail); returns whether it opened.
+-(BOOL) waitForOpen {
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (self.opened || self.failure != nil);
+	}));
+
+	return self.opened;
+}
+
+/****************************************/
+#pragma mark - IRCClientTransportDelegate
+/****************************************/
+
+-(void) transportDidOpen:(id <IRCClientTransport>)transport {
+	@synchronized (self) {
+		_opened = YES;
+	}
+}
+
+-(void) transportHasBytesAvailable:(id <IRCClientTransport>)transport {
+}
+
+-(void) transportHasSpaceAvailable:(id <IRCClientTransport>)transport {
+}
+
+-(void) transport:(id <IRCClientTransport>)transport
+ didFailWithError:(NSError *)error {
+	@synchronized (self) {
+		_failure = error ?: [NSError errorWithDomain:NSPOSIXErrorDomain
+												code:ECONNRESET
+											userInfo:nil];
+	}
+}
+
+/*************************/
+#pragma mark - Trust tests
+/*************************/
+
+-(void) testServerIssuedByAnAnchorIsTrusted {
+	[self openToServer:_server];
+
+	XCTAssertTrue([self waitForOpen]);
+	XCTAssertNil(self.failure);
+	XCTAssertGreaterThan(_transport.handshakeDuration, 0.0);
+}
+
+-(void) testServerIsCheckedAgainstTheSystemsAnchorsByDefault {
+	// (The test certificate authority isn’t one of the system’s.)
+	_transport.anchorCertificates = nil;
+	[self openToServer:_server];
+
+	XCTAssertFalse([self waitForOpen]);
+	XCTAssertNotNil(self.failure);
+}
+
+-(void) testCertificateMustBeForThePeerName {
+	_transport.peerName = @"irc.example.com";
+	[self openToServer:_server];
+
+	XCTAssertFalse([self waitForOpen]);
+	XCTAssertNotNil(self.failure);
+}
+
+-(void) testPeerNameIsCheckedInsteadOfTheHost {
+	// The certificate is for localhost as well as for 127.0.0.1.
+	_transport.peerName = @"localhost";
+	[self openToServer:_server];
+
+	XCTAssertTrue([self waitForOpen]);
+}
+
+/***********************/
+#pragma mark - Pin tests
+/***********************/
+
+-(void) testPinnedKeyIsAccepted {
+	_transport.pinnedPublicKeys = [NSSet setWithObject:IRCClientTLSTransportTestsServerKeyDigest()];
+	[self openToServer:_server];
+
+	XCTAssertTrue([self waitForOpen]);
+}
+
+-(void) testKeyThatIsNotPinnedIsRejected {
+	// The server’s certificate is trusted, but its key isn’t the pinned one
+	// (which is the certificate authority’s).
+	NSData *otherDigest = [IRCClientTLSTransport publicKeyDigestForCertificate:[IRCClientTestServer testCertificateAuthority]];
+	XCTAssertNotEqualObjects(otherDigest, IRCClientTLSTransportTestsServerKeyDigest());
+	_transport.pinnedPublicKeys = [NSSet setWithObject:otherDigest];
+	[self openToServer:_server];
+
+	XCTAssertFalse([self waitForOpen]);
+	XCTAssertEqualObjects(self.failure.domain, NSOSStatusErrorDomain);
+	XCTAssertEqual(self.failure.code, errSSLBadCert);
+}
+
+/******************************/
+#pragma mark - Resumption tests
+/******************************/
+
+-(void) testReconnectingResumesTheSession {
+	[self openToServer:_server];
+	XCTAssertTrue([self waitForOpen]);
+	XCTAssertEqual(_server.resumedHandshakeCount, (NSUInteger) 0);
+	[self close];
+
+	[self openToServer:_server];
+	XCTAssertTrue([self waitForOpen]);
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (_server.resumedHandshakeCount == 1);
+	}));
+	XCTAssertGreaterThan(_transport.handshakeDuration, 0.0);
+}
+
+-(void) testOtherServerIsNotResumed {
+	[self openToServer:_server];
+	XCTAssertTrue([self waitForOpen]);
+	[self close];
+
+	// (Sessions are cached by host and port.)
+	IRCClientTestServer *otherServer = [IRCClientTestServer new];
+	otherServer.identity = [IRCClientTestServer testIdentity];
+	XCTAssertTrue([otherServer start]);
+
+	[self openToServer:otherServer];
+	XCTAssertTrue([self waitForOpen]);
+
+	// (Long enough for the server to have finished its side of the
+	// handshake.)
+	[NSThread sleepForTimeInterval:0.2];
+	XCTAssertEqual(otherServer.resumedHandshakeCount, (NSUInteger) 0);
+
+	[self close];
+	[otherServer stop];
+}
+
+/***************************/
+#pragma mark - Session tests
+/***************************/
+
+-(void) testSessionRegistersOverTLS {
+	IRCClientTestDelegate *delegate = [IRCClientTestDelegate new];
+	IRCClientSession *session = [_server sessionWithNickname:@"secure"
+												   eventLoop:nil];
+	session.delegate = delegate;
+	IRCClientTLSTransport *transport = [[IRCClientTLSTransport alloc] initWithTransport:[IRCClientSocketTransport new]];
+	transport.anchorCertificates = _transport.anchorCertificates;
+	session.transport = transport;
+
+	[session connect];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (delegate.connectionCount == 1);
+	}));
+	XCTAssertEqual(_server.registrationCount, (NSUInteger) 1);
+	XCTAssertGreaterThan(delegate.connectionTimings.handshake, 0.0);
+
+	// Lines go both ways (and many at once), encrypted.
+	NSMutableArray <NSString *> *lines = [NSMutableArray array];
+	for (NSUInteger i = 0; i < 1000; i++)
+		[lines addObject:[NSString stringWithFormat:@":irc.test NOTICE secure :Line %lu", (unsigned long) i]];
+	XCTAssertTrue([delegate sendLines:lines
+						 toConnection:[_server connectionForNick:@"secure"]]);
+
+	[session disconnect];
+}
+
+-(void) testChangingUsesTLSTakesEffectOnTheNextConnect {
+	// (A server that doesn’t speak TLS, since the system doesn’t trust the
+	// test certificate authority.)
+	IRCClientTestServer *plainServer = [IRCClientTestServer new];
+	XCTAssertTrue([plainServer start]);
+	IRCClientTestDelegate *delegate = [IRCClientTestDelegate new];
+	IRCClientSession *session = [plainServer sessionWithNickname:@"plain"
+													   eventLoop:nil];
+	session.delegate = delegate;
+
+	[session connect];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (delegate.connectionCount == 1);
+	}));
+	XCTAssertFalse([session.transport isKindOfClass:[IRCClientTLSTransport class]]);
+	[session disconnect];
+	XCTAssertTrue(IRCClientTestWaitUntil(10, ^BOOL {
+		return (delegate.disconnectionCount == 1);
+	}));
+
+	// The transport that the session made is made again, with TLS.
+	session.usesTLS = YES;
+	[session connect];
+	XCTAssertTrue([session.transport isKindOfClass:[IRCClientTLSTransport class]]);
+
+	[session disconnect];
+	[plainServer stop];
+}
+
+@end
@@ -0,0 +1,69 @@
+//
+//	IRCClientTestDelegate.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+#import "IRCClientSessionDelegate.h"
+
+@class IRCClientTestConnection;
+
+/** @class IRCClientTestDelegate
+ *	@brief A session delegate that counts (and keeps) what it’s sent, for
+ *	tests and benchmarks.
+ *
+ *	One delegate may serve many sessions. The counts may be read on any
+ *	thread; the handlers are called on the session’s queue.
+ */
+
+/***************************************************/
+#pragma mark IRCClientTestDelegate class declaration
+/***************************************************/
+
+@interface IRCClientTestDelegate : NSObject <IRCClientSessionDelegate>
+
+/************************/
+#pragma mark - Properties
+/************************/
+
+/**	The number of -[connectionSucceeded:] messages received. */
+@property (readonly) NSUInteger connectionCount;
+
+/**	The number of -[disconnected:] messages received. */
+@property (readonly) NSUInteger disconnectionCount;
+
+/**	The number of private messages received. */
+@property (readonly) NSUInteger privateMessageCount;
+
+/**	The channels joined (in the order joined). */
+@property (readonly) NSArray <IRCClientChannel *> *joinedChannels;
+
+/**	The timings of the most recent connection. */
+@property (readonly) IRCClientConnectionTimings connectionTimings;
+
+@property (copy) void (^connectionHandler)(IRCClientSession *session);
+
+@property (copy) void (^privateMessageHandler)(NSData *message,
+											   NSData *nick,
+											   IRCClientSession *session);
+
+@property (copy) void (^fileTransferOfferHandler)(IRCClientDCCTransfer *transfer,
+												  IRCClientSession *session);
+
+/******************************/
+#pragma mark - Instance methods
+/******************************/
+
+/**	Sends the lines to a session of this delegate’s (over the session’s
+	connection to the test server), followed by a private message; then
+	waits until the message has been received, by which time the session has
+	handled the lines. Returns NO if the message didn’t arrive in time.
+ */
+-(BOOL) sendLines:(NSArray <NSString *> *)lines
+	 toConnection:(IRCClientTestConnection *)connection;
+
+@end
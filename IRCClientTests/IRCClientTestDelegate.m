@@ -0,0 +1,181 @@
+//
+//	IRCClientTestDelegate.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientTestDelegate.h"
+#import "IRCClientTestServer.h"
+
+#import <stdatomic.h>
+
+/********************************************************/
+#pragma mark - IRCClientTestDelegate class implementation
+/********************************************************/
+
+@implementation IRCClientTestDelegate {
+	_Atomic(NSUInteger) _connectionCount;
+	_Atomic(NSUInteger) _disconnectionCount;
+	_Atomic(NSUInteger) _privateMessageCount;
+
+	// These are guarded by @synchronized (self).
+	NSMutableArray <IRCClientChannel *> *_joinedChannels;
+	IRCClientConnectionTimings _connectionTimings;
+}
+
+/******************************/
+#pragma mark - Custom accessors
+/******************************/
+
+-(NSUInteger) connectionCount {
+	return atomic_load(&_connectionCount);
+}
+
+-(NSUInteger) disconnectionCount {
+	return atomic_load(&_disconnectionCount);
+}
+
+-(NSUInteger) privateMessageCount {
+	return atomic_load(&_privateMessageCount);
+}
+
+-(NSArray <IRCClientChannel *> *) joinedChannels {
+	@synchronized (self) {
+		return [_joinedChannels copy];
+	}
+}
+
+-(IRCClientConnectionTimings) connectionTimings {
+	@synchronized (self) {
+		return _connectionTimings;
+	}
+}
+
+/********************************************/
+#pragma mark - Initializers & factory methods
+/********************************************/
+
+-(instancetype) init {
+	if (!(self = [super init]))
+		return nil;
+
+	_joinedChannels = [NSMutableArray array];
+
+	return self;
+}
+
+/******************************/
+#pragma mark - Instance methods
+/******************************/
+
+-(BOOL) sendLines:(NSArray <NSString *> *)lines
+	 toConnection:(IRCClientTestConnection *)connection {
+	NSUInteger privateMessageCount = self.privateMessageCount;
+
+	NSMutableData *data = [NSMutableData data];
+	for (NSString *line in lines)
+		[data appendData:[[line stringByAppendingString:@"\r\n"] dataUsingEncoding:NSUTF8StringEncoding]];
+	[data appendData:[[NSString stringWithFormat:@":irc.test PRIVMSG %@ :sync\r\n", connection.nick] dataUsingEncoding:NSUTF8StringEncoding]];
+	[connection sendData:data];
+
+	return IRCClientTestWaitUntil(10, ^BOOL {
+		return (self.privateMessageCount > privateMessageCount);
+	});
+}
+
+/**************************************/
+#pragma mark - IRCClientSessionDelegate
+/**************************************/
+
+-(void) connectionSucceeded:(IRCClientSession *)session {
+	atomic_fetch_add(&_connectionCount, 1);
+
+	void (^connectionHandler)(IRCClientSession *) = self.connectionHandler;
+	if (connectionHandler != nil)
+		connectionHandler(session);
+}
+
+-(void) connectionTimed:(IRCClientConnectionTimings)timings
+				session:(IRCClientSession *)session {
+	@synchronized (self) {
+		_connectionTimings = timings;
+	}
+}
+
+-(void) disconnected:(IRCClientSession *)session {
+	atomic_fetch_add(&_disconnectionCount, 1);
+}
+
+-(void) nickChangedFrom:(NSData *)oldNick
+					 to:(NSData *)newNick
+					own:(BOOL)wasItUs
+				session:(IRCClientSession *)session {
+}
+
+-(void) userQuit:(NSData *)nick
+	  withReason:(NSData *)reason
+		 session:(IRCClientSession *)session {
+}
+
+-(void) joinedNewChannel:(IRCClientChannel *)channel
+				 session:(IRCClientSession *)session {
+	@synchronized (self) {
+		[_joinedChannels addObject:channel];
+	}
+}
+
+-(void) modeSet:(NSData *)mode
+			 by:(NSData *)nick
+		session:(IRCClientSession *)session {
+}
+
+-(void) errorReceived:(NSArray <NSData *> *)params
+			  session:(IRCClientSession *)session {
+}
+
+-(void) privateMessageReceived:(NSData *)message
+					  fromUser:(NSData *)nick
+					   session:(IRCClientSession *)session {
+	atomic_fetch_add(&_privateMessageCount, 1);
+
+	void (^privateMessageHandler)(NSData *, NSData *, IRCClientSession *) = self.privateMessageHandler;
+	if (privateMessageHandler != nil)
+		privateMessageHandler(message, nick, session);
+}
+
+-(void) privateNoticeReceived:(NSData *)notice
+					 fromUser:(NSData *)nick
+					  session:(IRCClientSession *)session {
+}
+
+-(void) serverMessageReceivedFrom:(NSData *)origin
+						   params:(NSArray <NSData *> *)params
+						  session:(IRCClientSession *)session {
+}
+
+-(void) serverNoticeReceivedFrom:(NSData *)origin
+						  params:(NSArray <NSData *> *)params
+						 session:(IRCClientSession *)session {
+}
+
+-(void) invitedToChannel:(NSData *)channelName
+					  by:(NSData *)nick
+				 session:(IRCClientSession *)session {
+}
+
+-(void) privateCTCPActionReceived:(NSData *)action
+						 fromUser:(NSData *)nick
+						  session:(IRCClientSession *)session {
+}
+
+-(void) fileTransferOffered:(IRCClientDCCTransfer *)transfer
+					session:(IRCClientSession *)session {
+	void (^fileTransferOfferHandler)(IRCClientDCCTransfer *, IRCClientSession *) = self.fileTransferOfferHandler;
+	if (fileTransferOfferHandler != nil)
+		fileTransferOfferHandler(transfer, session);
+}
+
+@end
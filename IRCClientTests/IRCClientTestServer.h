@@ -0,0 +1,211 @@
+//
+//	IRCClientTestServer.h
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import <Foundation/Foundation.h>
+#import <Security/Security.h>
+
+@class IRCClientSession;
+@class IRCClientEventLoop;
+@class IRCClientTestConnection;
+
+/**	Sees each line that an IRCClientTestServer receives (on the server’s
+	queue) before the server does; returns YES if it has dealt with the line
+	(in which case the server does nothing more with it).
+ */
+typedef BOOL (^IRCClientTestServerLineHandler)(IRCClientTestConnection *connection,
+											   NSString *line);
+
+/** @class IRCClientTestServer
+ *	@brief A minimal IRC server on a loopback address, for tests and
+ *	benchmarks.
+ *
+ *	The server registers clients (answering CAP LS with the
+ *	offeredCapabilities, and sending RPL_WELCOME, RPL_ISUPPORT, and
+ *	ERR_NOMOTD), answers PINGs, and
+ *	keeps channels: JOINs (checked against the channel’s key, if it has one),
+ *	PARTs, NICKs, and QUITs are relayed to the members, with RPL_NAMREPLY
+ *	for whoever joins; PRIVMSGs and NOTICEs are relayed to a channel’s
+ *	members, or to a nick. Everything else is ignored (unless a lineHandler
+ *	deals with it).
+ *
+ *	If it has an identity, the server speaks TLS.
+ *
+ *	Everything happens on the server’s own serial queue; the methods below
+ *	may be called on any thread.
+ */
+
+/*************************************************/
+#pragma mark IRCClientTestServer class declaration
+/*************************************************/
+
+@interface IRCClientTestServer : NSObject
+
+/************************/
+#pragma mark - Properties
+/************************/
+
+/**	The loopback address that the server listens on ("127.0.0.1" or "::1").
+ */
+@property (readonly) NSString *host;
+
+/**	The port that the server listens on (0 until it has been started).
+ */
+@property (readonly) NSUInteger port;
+
+/**	The server’s name, as it appears in the prefix of its own messages. The
+	default is "irc.test".
+ */
+@property (copy) NSString *name;
+
+/**	The RPL_ISUPPORT tokens (e.g. "TARGMAX=JOIN:4") to send on registration.
+	The default is nil (none).
+ */
+@property (copy) NSArray <NSString *> *supportTokens;
+
+/**	The IRCv3 capabilities (e.g. "sasl=PLAIN server-time") to list in reply
+	to CAP LS; a CAP REQ is acknowledged if it asks only for these, and
+	refused otherwise. The default is nil (none).
+ */
+@property (copy) NSString *offeredCapabilities;
+
+/**	The server’s certificate, as for SSLSetCertificate() (a SecIdentityRef,
+	followed by any intermediate certificates); if set, connections accepted
+	from then on speak TLS. The default is nil.
+ */
+@property (copy) NSArray *identity;
+
+@property (copy) IRCClientTestServerLineHandler lineHandler;
+
+/**	The number of clients connected right now. */
+@property (readonly) NSUInteger connectionCount;
+
+/**	The number of clients that have connected (since the server was created).
+ */
+@property (readonly) NSUInteger acceptedConnectionCount;
+
+/**	The number of clients that have registered (since the server was
+	created). */
+@property (readonly) NSUInteger registrationCount;
+
+/**	The number of TLS handshakes that resumed a cached session, instead of
+	doing a full handshake (since the server was created).
+ */
+@property (readonly) NSUInteger resumedHandshakeCount;
+
+/********************************************/
+#pragma mark - Initializers & factory methods
+/********************************************/
+
+/**	Returns a server that listens on the loopback address of the given
+	family (AF_INET or AF_INET6).
+ */
+-(instancetype) initWithFamily:(int)family;
+
+/**	Returns an identity (for the identity property) whose certificate is for
+	localhost, 127.0.0.1, and ::1, and is issued by
+	+[testCertificateAuthority]; nil if it can’t be loaded. (See
+	Scripts/generate_test_certificates.sh.)
+ */
++(NSArray *) testIdentity;
+
+/**	Returns the certificate authority that issued the +[testIdentity]
+	certificate (for a TLS transport’s anchorCertificates).
+ */
++(SecCertificateRef) testCertificateAuthority;
+
+/**	Returns a session that will connect to the given server (with no
+	capability negotiation, no flood control, and no logging).
+ */
++(IRCClientSession *) sessionWithNickname:(NSString *)nickname
+									 host:(NSString *)host
+									 port:(NSUInteger)port
+								eventLoop:(IRCClientEventLoop *)eventLoop;
+
+/******************************/
+#pragma mark - Instance methods
+/******************************/
+
+/**	Returns a session that will connect to this server (as for
+	+[sessionWithNickname:host:port:eventLoop:]).
+ */
+-(IRCClientSession *) sessionWithNickname:(NSString *)nickname
+								eventLoop:(IRCClientEventLoop *)eventLoop;
+
+/**	Starts listening: on an unused port the first time, and on the same port
+	as before after -[stop]. Returns NO if the port can’t be had.
+ */
+-(BOOL) start;
+
+/**	Stops listening (so that connection attempts are refused), and closes
+	every connection.
+ */
+-(void) stop;
+
+/**	Closes every connection, abruptly (as when a server goes down); the
+	server goes on listening.
+ */
+-(void) dropConnections;
+
+/**	Sets the key that must be given to join the channel (nil for none).
+ */
+-(void) setKey:(NSString *)key
+	forChannel:(NSString *)channel;
+
+/**	Returns the registered connection with the given nick (or nil).
+ */
+-(IRCClientTestConnection *) connectionForNick:(NSString *)nick;
+
+/**	Returns every line received with the given command (e.g. "JOIN"), on any
+	connection, in the order received.
+ */
+-(NSArray <NSString *> *) receivedLinesWithCommand:(NSString *)command;
+
+@end
+
+/*******************************************************/
+#pragma mark - IRCClientTestConnection class declaration
+/*******************************************************/
+
+/** @class IRCClientTestConnection
+ *	@brief A client’s connection to an IRCClientTestServer.
+ */
+@interface IRCClientTestConnection : NSObject
+
+/**	The client’s nick (nil until it has sent one). */
+@property (readonly) NSString *nick;
+
+/**	The client’s nick!user@host. */
+@property (readonly) NSString *prefix;
+
+@property (readonly, getter=isRegistered) BOOL registered;
+
+/**	Sends the line (to which a CRLF is added) to the client.
+ */
+-(void) sendLine:(NSString *)line;
+
+/**	Sends the bytes (which should be whole lines, with their CRLFs) to the
+	client, all at once.
+ */
+-(void) sendData:(NSData *)data;
+
+/**	Closes the connection, abruptly.
+ */
+-(void) close;
+
+@end
+
+/******************************/
+#pragma mark - Helper functions
+/******************************/
+
+/**	Waits (polling every few milliseconds) until the condition holds, or the
+	timeout runs out; returns whether the condition held.
+ */
+BOOL IRCClientTestWaitUntil(NSTimeInterval timeout,
+							BOOL (^condition)(void));
@@ -0,0 +1,972 @@
+//
+//	IRCClientTestServer.m
+//
+//  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+//  libircclient Copyright 2004-2009 Georgy Yunaev.
+//
+//  See LICENSE and README.md for more info.
+
+#import "IRCClientTestServer.h"
+#import "IRCClientSession.h"
+
+#import <Security/Security.h>
+#import <sys/socket.h>
+#import <netinet/in.h>
+#import <netinet/tcp.h>
+#import <fcntl.h>
+#import <unistd.h>
+
+/******************************/
+#pragma mark - Static variables
+/******************************/
+
+static const NSUInteger IRCClientTestServerReadChunkSize = 16384;
+
+// How many names go in one RPL_NAMREPLY.
+static const NSUInteger IRCClientTestServerNamesPerReply = 40;
+
+// How many tokens go in one RPL_ISUPPORT.
+static const NSUInteger IRCClientTestServerTokensPerReply = 12;
+
+// Identifies a server’s queue (the value is the server).
+static char IRCClientTestServerQueueKey;
+
+/******************************/
+#pragma mark - Helper functions
+/******************************/
+
+// Returns the command of the line, followed by its params (leaving out any
+// tags and prefix).
+static NSArray <NSString *> *IRCClientTestServerLineWords(NSString *line) {
+	NSString *rest = line;
+	for (NSString *leader in @[ @"@", @":" ]) {
+		if ([rest hasPrefix:leader] == NO)
+			continue;
+		NSRange space = [rest rangeOfString:@" "];
+		rest = (space.location == NSNotFound) ? @"" : [rest substringFromIndex:NSMaxRange(space)];
+	}
+
+	NSRange trailing = [rest rangeOfString:@" :"];
+	NSString *middle = (trailing.location == NSNotFound) ? rest : [rest substringToIndex:trailing.location];
+
+	NSMutableArray <NSString *> *words = [NSMutableArray array];
+	for (NSString *word in [middle componentsSeparatedByString:@" "])
+		if (word.length > 0)
+			[words addObject:word];
+	if (trailing.location != NSNotFound)
+		[words addObject:[rest substringFromIndex:NSMaxRange(trailing)]];
+
+	return words;
+}
+
+// TLS I/O: reads don’t block (so that the connection can wait for more
+// bytes on its read source), but writes do.
+// Returns the contents of the named resource: from the test bundle, or (for
+// the benchmark tool, which has no resources of its own) from the source
+// tree, next to this file.
+static NSData *IRCClientTestServerResource(NSString *name,
+										   NSString *extension) {
+	NSURL *url = [[NSBundle bundleForClass:[IRCClientTestServer class]] URLForResource:name
+																	  withExtension:extension];
+	if (url == nil)
+		url = [[NSURL fileURLWithPath:@(__FILE__)].URLByDeletingLastPathComponent URLByAppendingPathComponent:[name stringByAppendingPathExtension:extension]];
+
+	return [NSData dataWithContentsOfURL:url];
+}
+
+static OSStatus IRCClientTestServerTLSRead(SSLConnectionRef connection,
+										   void *data,
+										   size_t *length) {
+	int fd = (int) (intptr_t) connection;
+	size_t requested = *length;
+	size_t processed = 0;
+	while (processed < requested) {
+		ssize_t count = recv(fd, (uint8_t *) data + processed, requested - processed, MSG_DONTWAIT);
+		if (count > 0) {
+			processed += (size_t) count;
+		} else if (count == 0) {
+			*length = processed;
+			return errSSLClosedGraceful;
+		} else if (errno != EINTR) {
+			*length = processed;
+			return (errno == EAGAIN) ? errSSLWouldBlock : errSSLClosedAbort;
+		}
+	}
+
+	*length = processed;
+	return noErr;
+}
+
+static OSStatus IRCClientTestServerTLSWrite(SSLConnectionRef connection,
+											const void *data,
+											size_t *length) {
+	int fd = (int) (intptr_t) connection;
+	size_t requested = *length;
+	size_t processed = 0;
+	while (processed < requested) {
+		ssize_t count = send(fd, (const uint8_t *) data + processed, requested - processed, 0);
+		if (count >= 0) {
+			processed += (size_t) count;
+		} else if (errno != EINTR) {
+			*length = processed;
+			return errSSLClosedAbort;
+		}
+	}
+
+	*length = processed;
+	return noErr;
+}
+
+/*****************************************************/
+#pragma mark - IRCClientTestConnection class extension
+/*****************************************************/
+
+@interface IRCClientTestConnection ()
+
+@property (readwrite) NSString *nick;
+
+@property (copy) NSString *user;
+
+@property (readwrite, getter=isRegistered) BOOL registered;
+
+// The client has sent CAP LS, and not yet CAP END.
+@property (assign) BOOL negotiatingCapabilities;
+
+// The client has sent QUIT (so it’s been seen off already).
+@property (assign) BOOL quit;
+
+// The channels (case-folded names) that the client is on.
+@property (readonly) NSMutableSet <NSString *> *channels;
+
+-(instancetype) initWithSocket:(int)connectionSocket
+						server:(IRCClientTestServer *)server
+						 queue:(dispatch_queue_t)queue;
+
+-(void) startWithIdentity:(NSArray *)identity;
+
+-(void) writeLine:(NSString *)line;
+
+-(void) shutDown;
+
+@end
+
+/*************************************************/
+#pragma mark - IRCClientTestServer class extension
+/*************************************************/
+
+@interface IRCClientTestServer ()
+
+-(void) performOnQueue:(void (^)(void))block;
+
+-(void) connection:(IRCClientTestConnection *)connection
+	  receivedLine:(NSString *)line;
+
+-(void) connectionClosed:(IRCClientTestConnection *)connection;
+
+-(void) connectionResumedSession:(IRCClientTestConnection *)connection;
+
+@end
+
+/******************************************************/
+#pragma mark - IRCClientTestServer class implementation
+/******************************************************/
+
+@implementation IRCClientTestServer {
+	dispatch_queue_t _queue;
+
+	int _family;
+	int _listeningSocket;
+	dispatch_source_t _acceptSource;
+
+	NSMutableArray <IRCClientTestConnection *> *_connections;
+	NSMutableDictionary <NSString *, IRCClientTestConnection *> *_connectionsByNick;
+
+	// Keyed by case-folded channel name; the members are in the order they
+	// joined.
+	NSMutableDictionary <NSString *, NSMutableArray <IRCClientTestConnection *> *> *_channels;
+	NSMutableDictionary <NSString *, NSString *> *_channelKeys;
+
+	NSMutableArray <NSString *> *_receivedLines;
+}
+
+/******************************/
+#pragma mark - Custom accessors
+/******************************/
+
+-(NSString *) host {
+	return (_family == AF_INET6) ? @"::1" : @"127.0.0.1";
+}
+
+-(NSUInteger) connectionCount {
+	__block NSUInteger connectionCount;
+	[self performOnQueueAndWait:^{
+		connectionCount = _connections.count;
+	}];
+
+	return connectionCount;
+}
+
+/********************************************/
+#pragma mark - Initializers & factory methods
+/********************************************/
+
+-(instancetype) init {
+	return [self initWithFamily:AF_INET];
+}
+
+-(instancetype) initWithFamily:(int)family {
+	if (!(self = [super init]))
+		return nil;
+
+	_queue = dispatch_queue_create("IRCClientTestServer", DISPATCH_QUEUE_SERIAL);
+	dispatch_queue_set_specific(_queue, &IRCClientTestServerQueueKey, (__bridge void *) self, NULL);
+
+	_family = family;
+	_listeningSocket = -1;
+	_name = @"irc.test";
+
+	_connections = [NSMutableArray array];
+	_connectionsByNick = [NSMutableDictionary dictionary];
+	_channels = [NSMutableDictionary dictionary];
+	_channelKeys = [NSMutableDictionary dictionary];
+	_receivedLines = [NSMutableArray array];
+
+	return self;
+}
+
+-(void) dealloc {
+	if (_acceptSource != nil)
+		dispatch_source_cancel(_acceptSource);
+}
+
++(NSArray *) testIdentity {
+	static NSArray *testIdentity;
+	static dispatch_once_t once;
+	dispatch_once(&once, ^{
+		NSData *data = IRCClientTestServerResource(@"IRCClientTestServer", @"p12");
+		if (data == nil)
+			return;
+
+		CFArrayRef items = NULL;
+		NSDictionary *options = @{ (__bridge id) kSecImportExportPassphrase: @"test" };
+		if (SecPKCS12Import((__bridge CFDataRef) data, (__bridge CFDictionaryRef) options, &items) != errSecSuccess)
+			return;
+		id identity = ((__bridge_transfer NSArray *) items).firstObject[(__bridge id) kSecImportItemIdentity];
+		if (identity != nil)
+			testIdentity = @[ identity ];
+	});
+
+	return testIdentity;
+}
+
++(SecCertificateRef) testCertificateAuthority {
+	static SecCertificateRef testCertificateAuthority;
+	static dispatch_once_t once;
+	dispatch_once(&once, ^{
+		NSData *data = IRCClientTestServerResource(@"IRCClientTestCA", @"der");
+		if (data != nil)
+			testCertificateAuthority = SecCertificateCreateWithData(kCFAllocatorDefault, (__bridge CFDataRef) data);
+	});
+
+	return testCertificateAuthority;
+}
+
++(IRCClientSession *) sessionWithNickname:(NSString *)nickname
+									 host:(NSString *)host
+									 port:(NSUInteger)port
+								eventLoop:(IRCClientEventLoop *)eventLoop {
+	IRCClientSession *session = [[IRCClientSession alloc] initWithEventLoop:eventLoop];
+	session.server = [host dataUsingEncoding:NSUTF8StringEncoding];
+	session.port = port;
+	session.requestedCapabilities = @[];
+	session.floodControlBurst = 0;
+	session.logSink = nil;
+	[session setNickname:[nickname dataUsingEncoding:NSUTF8StringEncoding]
+				username:[@"test" dataUsingEncoding:NSUTF8StringEncoding]
+				realname:[@"IRCClient test" dataUsingEncoding:NSUTF8StringEncoding]];
+
+	return session;
+}
+
+/******************************/
+#pragma mark - Instance methods
+/******************************/
+
+-(IRCClientSession *) sessionWithNickname:(NSString *)nickname
+								eventLoop:(IRCClientEventLoop *)eventLoop {
+	return [IRCClientTestServer sessionWithNickname:nickname
+											   host:self.host
+											   port:self.port
+										  eventLoop:eventLoop];
+}
+
+-(BOOL) start {
+	__block BOOL started;
+	[self performOnQueueAndWait:^{
+		started = [self listen];
+	}];
+
+	return started;
+}
+
+-(void) stop {
+	[self performOnQueueAndWait:^{
+		if (_acceptSource != nil) {
+			dispatch_source_cancel(_acceptSource);
+			_acceptSource = nil;
+			_listeningSocket = -1;
+		}
+		[self closeConnections];
+	}];
+}
+
+-(void) dropConnections {
+	[self performOnQueueAndWait:^{
+		[self closeConnections];
+	}];
+}
+
+-(void) setKey:(NSString *)key
+	forChannel:(NSString *)channel {
+	[self performOnQueueAndWait:^{
+		_channelKeys[channel.lowercaseString] = key;
+	}];
+}
+
+-(IRCClientTestConnection *) connectionForNick:(NSString *)nick {
+	__block IRCClientTestConnection *connection;
+	[self performOnQueueAndWait:^{
+		connection = _connectionsByNick[nick.lowercaseString];
+	}];
+
+	return connection;
+}
+
+-(NSArray <NSString *> *) receivedLinesWithCommand:(NSString *)command {
+	NSMutableArray <NSString *> *lines = [NSMutableArray array];
+	[self performOnQueueAndWait:^{
+		for (NSString *line in _receivedLines)
+			if ([IRCClientTestServerLineWords(line).firstObject.uppercaseString isEqualToString:command.uppercaseString])
+				[lines addObject:line];
+	}];
+
+	return lines;
+}
+
+/****************************/
+#pragma mark - Helper methods
+/****************************/
+
+-(BOOL) isOnQueue {
+	return (dispatch_get_specific(&IRCClientTestServerQueueKey) == (__bridge void *) self);
+}
+
+-(void) performOnQueue:(void (^)(void))block {
+	if ([self isOnQueue])
+		block();
+	else
+		dispatch_async(_queue, block);
+}
+
+-(void) performOnQueueAndWait:(void (^)(void))block {
+	if ([self isOnQueue])
+		block();
+	else
+		dispatch_sync(_queue, block);
+}
+
+-(BOOL) listen {
+	if (_listeningSocket != -1)
+		return YES;
+
+	int listeningSocket = socket(_family, SOCK_STREAM, 0);
+	if (listeningSocket == -1)
+		return NO;
+
+	int on = 1;
+	setsockopt(listeningSocket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+	struct sockaddr_storage address = { 0 };
+	socklen_t addressLength;
+	if (_family == AF_INET6) {
+		struct sockaddr_in6 *address6 = (struct sockaddr_in6 *) &address;
+		address6->sin6_len = sizeof(struct sockaddr_in6);
+		address6->sin6_family = AF_INET6;
+		address6->sin6_port = htons((uint16_t) _port);
+		address6->sin6_addr = in6addr_loopback;
+		addressLength = sizeof(struct sockaddr_in6);
+	} else {
+		struct sockaddr_in *address4 = (struct sockaddr_in *) &address;
+		address4->sin_len = sizeof(struct sockaddr_in);
+		address4->sin_family = AF_INET;
+		address4->sin_port = htons((uint16_t) _port);
+		address4->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addressLength = sizeof(struct sockaddr_in);
+	}
+
+	if (   bind(listeningSocket, (const struct sockaddr *) &address, addressLength) == -1
+		|| listen(listeningSocket, 4096) == -1
+		|| getsockname(listeningSocket, (struct sockaddr *) &address, &addressLength) == -1) {
+		close(listeningSocket);
+		return NO;
+	}
+	_port = ntohs((_family == AF_INET6)
+				  ? ((const struct sockaddr_in6 *) &address)->sin6_port
+				  : ((const struct sockaddr_in *) &address)->sin_port);
+
+	fcntl(listeningSocket, F_SETFL, fcntl(listeningSocket, F_GETFL) | O_NONBLOCK);
+	_listeningSocket = listeningSocket;
+
+	_acceptSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t) listeningSocket, 0, _queue);
+	__weak typeof(self) weakSelf = self;
+	dispatch_source_set_event_handler(_acceptSource, ^{
+		[weakSelf acceptConnections];
+	});
+	dispatch_source_set_cancel_handler(_acceptSource, ^{
+		close(listeningSocket);
+	});
+	dispatch_resume(_acceptSource);
+
+	return YES;
+}
+
+-(void) acceptConnections {
+	for (;;) {
+		int connectionSocket = accept(_listeningSocket, NULL, NULL);
+		if (connectionSocket == -1) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		// (Accepted sockets inherit the listening socket’s O_NONBLOCK.)
+		fcntl(connectionSocket, F_SETFL, fcntl(connectionSocket, F_GETFL) & ~O_NONBLOCK);
+		int on = 1;
+		setsockopt(connectionSocket, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+		setsockopt(connectionSocket, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+		IRCClientTestConnection *connection = [[IRCClientTestConnection alloc] initWithSocket:connectionSocket
+																					   server:self
+																						queue:_queue];
+		[_connections addObject:connection];
+		_acceptedConnectionCount++;
+		[connection startWithIdentity:self.identity];
+	}
+}
+
+-(void) closeConnections {
+	for (IRCClientTestConnection *connection in [_connections copy])
+		[connection shutDown];
+}
+
+-(void) sendNumeric:(NSString *)numeric
+		 parameters:(NSString *)parameters
+	   toConnection:(IRCClientTestConnection *)connection {
+	[connection writeLine:[NSString stringWithFormat:@":%@ %@ %@ %@",
+						   self.name,
+						   numeric,
+						   (connection.nick ?: @"*"),
+						   parameters]];
+}
+
+// Sends the line to every member of the channels that the connection is on
+// (and, if includingConnection is YES, to it), once each.
+-(void) sendLine:(NSString *)line
+  toPeersOfConnection:(IRCClientTestConnection *)connection
+  includingConnection:(BOOL)includingConnection {
+	NSMutableSet <IRCClientTestConnection *> *peers = [NSMutableSet set];
+	for (NSString *channel in connection.channels)
+		[peers addObjectsFromArray:_channels[channel]];
+	if (includingConnection)
+		[peers addObject:connection];
+	else
+		[peers removeObject:connection];
+
+	for (IRCClientTestConnection *peer in peers)
+		[peer writeLine:line];
+}
+
+-(void) registerConnectionIfReady:(IRCClientTestConnection *)connection {
+	if (   connection.registered
+		|| connection.nick == nil
+		|| connection.user == nil
+		|| connection.negotiatingCapabilities)
+		return;
+
+	connection.registered = YES;
+	_connectionsByNick[connection.nick.lowercaseString] = connection;
+	_registrationCount++;
+
+	[self sendNumeric:@"001"
+		   parameters:[NSString stringWithFormat:@":Welcome to the test network, %@", connection.prefix]
+		 toConnection:connection];
+	NSArray <NSString *> *supportTokens = self.supportTokens;
+	for (NSUInteger i = 0; i < supportTokens.count; i += IRCClientTestServerTokensPerReply) {
+		NSArray <NSString *> *tokens = [supportTokens subarrayWithRange:NSMakeRange(i, MIN(IRCClientTestServerTokensPerReply, supportTokens.count - i))];
+		[self sendNumeric:@"005"
+			   parameters:[NSString stringWithFormat:@"%@ :are supported by this server", [tokens componentsJoinedByString:@" "]]
+			 toConnection:connection];
+	}
+	[self sendNumeric:@"422"
+		   parameters:@":MOTD File is missing"
+		 toConnection:connection];
+}
+
+-(void) connection:(IRCClientTestConnection *)connection
+		joinChannel:(NSString *)channel
+				key:(NSString *)key {
+	NSString *folded = channel.lowercaseString;
+	if ([connection.channels containsObject:folded])
+		return;
+
+	NSString *channelKey = _channelKeys[folded];
+	if (   channelKey != nil
+		&& [channelKey isEqualToString:key] == NO) {
+		[self sendNumeric:@"475"
+			   parameters:[NSString stringWithFormat:@"%@ :Cannot join channel (+k)", channel]
+			 toConnection:connection];
+		return;
+	}
+
+	NSMutableArray <IRCClientTestConnection *> *members = _channels[folded];
+	if (members == nil)
+		members = _channels[folded] = [NSMutableArray array];
+	[members addObject:connection];
+	[connection.channels addObject:folded];
+
+	NSString *join = [NSString stringWithFormat:@":%@ JOIN %@", connection.prefix, channel];
+	for (IRCClientTestConnection *member in members)
+		[member writeLine:join];
+
+	// (Whoever is first on the channel is its operator.)
+	NSMutableArray <NSString *> *names = [NSMutableArray arrayWithCapacity:members.count];
+	for (IRCClientTestConnection *member in members)
+		[names addObject:(member == members.firstObject
+						  ? [@"@" stringByAppendingString:member.nick]
+						  : member.nick)];
+	for (NSUInteger i = 0; i < names.count; i += IRCClientTestServerNamesPerReply) {
+		NSArray <NSString *> *someNames = [names subarrayWithRange:NSMakeRange(i, MIN(IRCClientTestServerNamesPerReply, names.count - i))];
+		[self sendNumeric:@"353"
+			   parameters:[NSString stringWithFormat:@"= %@ :%@", channel, [someNames componentsJoinedByString:@" "]]
+			 toConnection:connection];
+	}
+	[self sendNumeric:@"366"
+		   parameters:[NSString stringWithFormat:@"%@ :End of /NAMES list", channel]
+		 toConnection:connection];
+}
+
+-(void) connection:(IRCClientTestConnection *)connection
+	   leaveChannel:(NSString *)folded {
+	NSMutableArray <IRCClientTestConnection *> *members = _channels[folded];
+	[members removeObjectIdenticalTo:connection];
+	if (members.count == 0)
+		[_channels removeObjectForKey:folded];
+	[connection.channels removeObject:folded];
+}
+
+-(void) connection:(IRCClientTestConnection *)connection
+	  receivedLine:(NSString *)line {
+	[_receivedLines addObject:line];
+
+	IRCClientTestServerLineHandler lineHandler = self.lineHandler;
+	if (   lineHandler != nil
+		&& lineHandler(connection, line))
+		return;
+
+	NSArray <NSString *> *words = IRCClientTestServerLineWords(line);
+	NSString *command = words.firstObject.uppercaseString;
+	NSArray <NSString *> *params = (words.count > 0) ? [words subarrayWithRange:NSMakeRange(1, words.count - 1)] : @[];
+
+	if ([command isEqualToString:@"CAP"]) {
+		NSString *subcommand = params.firstObject.uppercaseString;
+		if ([subcommand isEqualToString:@"LS"]) {
+			connection.negotiatingCapabilities = YES;
+			[connection writeLine:[NSString stringWithFormat:@":%@ CAP * LS :%@", self.name, (self.offeredCapabilities ?: @"")]];
+		} else if ([subcommand isEqualToString:@"REQ"]) {
+			NSMutableSet <NSString *> *offered = [NSMutableSet set];
+			for (NSString *capability in [self.offeredCapabilities componentsSeparatedByString:@" "])
+				[offered addObject:[capability componentsSeparatedByString:@"="].firstObject];
+			NSArray <NSString *> *requested = [params.lastObject componentsSeparatedByString:@" "];
+			BOOL acknowledged = [[NSSet setWithArray:requested] isSubsetOfSet:offered];
+			[connection writeLine:[NSString stringWithFormat:@":%@ CAP * %@ :%@", self.name, (acknowledged ? @"ACK" : @"NAK"), params.lastObject]];
+		} else if ([subcommand isEqualToString:@"END"]) {
+			connection.negotiatingCapabilities = NO;
+			[self registerConnectionIfReady:connection];
+		}
+	} else if ([command isEqualToString:@"NICK"]) {
+		NSString *nick = params.firstObject;
+		if (nick.length == 0)
+			return;
+
+		IRCClientTestConnection *holder = _connectionsByNick[nick.lowercaseString];
+		if (   holder != nil
+			&& holder != connection) {
+			[self sendNumeric:@"433"
+				   parameters:[NSString stringWithFormat:@"%@ :Nickname is already in use", nick]
+				 toConnection:connection];
+			return;
+		}
+
+		if (connection.registered) {
+			[self sendLine:[NSString stringWithFormat:@":%@ NICK :%@", connection.prefix, nick]
+				toPeersOfConnection:connection
+				includingConnection:YES];
+			[_connectionsByNick removeObjectForKey:connection.nick.lowercaseString];
+			_connectionsByNick[nick.lowercaseString] = connection;
+			connection.nick = nick;
+		} else {
+			connection.nick = nick;
+			[self registerConnectionIfReady:connection];
+		}
+	} else if ([command isEqualToString:@"USER"]) {
+		if (params.count == 0)
+			return;
+
+		connection.user = params.firstObject;
+		[self registerConnectionIfReady:connection];
+	} else if ([command isEqualToString:@"PING"]) {
+		[connection writeLine:[NSString stringWithFormat:@":%@ PONG %@ :%@", self.name, self.name, (params.firstObject ?: @"")]];
+	} else if (connection.registered == NO) {
+		[self sendNumeric:@"451"
+			   parameters:@":You have not registered"
+			 toConnection:connection];
+	} else if ([command isEqualToString:@"JOIN"]) {
+		NSArray <NSString *> *channels = [params.firstObject componentsSeparatedByString:@","];
+		NSArray <NSString *> *keys = (params.count > 1) ? [params[1] componentsSeparatedByString:@","] : @[];
+		[channels enumerateObjectsUsingBlock:^(NSString *channel, NSUInteger i, BOOL *stop) {
+			if (channel.length == 0)
+				return;
+			[self connection:connection
+				 joinChannel:channel
+						 key:(i < keys.count ? keys[i] : nil)];
+		}];
+	} else if ([command isEqualToString:@"PART"]) {
+		for (NSString *channel in [params.firstObject componentsSeparatedByString:@","]) {
+			NSString *folded = channel.lowercaseString;
+			if ([connection.channels containsObject:folded] == NO)
+				continue;
+
+			NSString *part = (params.count > 1
+							  ? [NSString stringWithFormat:@":%@ PART %@ :%@", connection.prefix, channel, params[1]]
+							  : [NSString stringWithFormat:@":%@ PART %@", connection.prefix, channel]);
+			for (IRCClientTestConnection *member in _channels[folded])
+				[member writeLine:part];
+			[self connection:connection
+				leaveChannel:folded];
+		}
+	} else if (   [command isEqualToString:@"PRIVMSG"]
+			   || [command isEqualToString:@"NOTICE"]) {
+		if (params.count < 2)
+			return;
+
+		NSString *target = params[0];
+		NSString *message = [NSString stringWithFormat:@":%@ %@ %@ :%@", connection.prefix, command, target, params[1]];
+		if ([target hasPrefix:@"#"]) {
+			for (IRCClientTestConnection *member in _channels[target.lowercaseString])
+				if (member != connection)
+					[member writeLine:message];
+		} else {
+			[_connectionsByNick[target.lowercaseString] writeLine:message];
+		}
+	} else if ([command isEqualToString:@"QUIT"]) {
+		connection.quit = YES;
+		[self sendLine:[NSString stringWithFormat:@":%@ QUIT :Quit: %@", connection.prefix, (params.firstObject ?: @"")]
+			toPeersOfConnection:connection
+			includingConnection:NO];
+		[connection writeLine:@"ERROR :Closing link"];
+		[connection shutDown];
+	}
+}
+
+-(void) connectionClosed:(IRCClientTestConnection *)connection {
+	if (connection.quit == NO)
+		[self sendLine:[NSString stringWithFormat:@":%@ QUIT :Connection closed", connection.prefix]
+			toPeersOfConnection:connection
+			includingConnection:NO];
+
+	for (NSString *channel in [connection.channels copy])
+		[self connection:connection
+			leaveChannel:channel];
+	if (   connection.nick != nil
+		&& _connectionsByNick[connection.nick.lowercaseString] == connection)
+		[_connectionsByNick removeObjectForKey:connection.nick.lowercaseString];
+	[_connections removeObjectIdenticalTo:connection];
+}
+
+-(void) connectionResumedSession:(IRCClientTestConnection *)connection {
+	_resumedHandshakeCount++;
+}
+
+@end
+
+/**********************************************************/
+#pragma mark - IRCClientTestConnection class implementation
+/**********************************************************/
+
+@implementation IRCClientTestConnection {
+	__weak IRCClientTestServer *_server;
+	dispatch_queue_t _queue;
+
+	int _socket;
+	dispatch_source_t _readSource;
+
+	// With TLS: the context, whether the handshake is still going on, and
+	// what’s to be sent once it’s done.
+	SSLContextRef _context;
+	BOOL _handshaking;
+	NSMutableArray <NSData *> *_pendingOutput;
+
+	NSMutableData *_input;
+}
+
+/******************************/
+#pragma mark - Custom accessors
+/******************************/
+
+-(NSString *) prefix {
+	return [NSString stringWithFormat:@"%@!%@@localhost", (self.nick ?: @"*"), (self.user ?: @"*")];
+}
+
+/********************************************/
+#pragma mark - Initializers & factory methods
+/********************************************/
+
+-(instancetype) initWithSocket:(int)connectionSocket
+						server:(IRCClientTestServer *)server
+						 queue:(dispatch_queue_t)queue {
+	if (!(self = [super init]))
+		return nil;
+
+	_socket = connectionSocket;
+	_server = server;
+	_queue = queue;
+
+	_channels = [NSMutableSet set];
+	_pendingOutput = [NSMutableArray array];
+	_input = [NSMutableData data];
+
+	return self;
+}
+
+-(void) dealloc {
+	if (_readSource != nil)
+		dispatch_source_cancel(_readSource);
+	if (_context != NULL)
+		CFRelease(_context);
+}
+
+/******************************/
+#pragma mark - Instance methods
+/******************************/
+
+-(void) sendLine:(NSString *)line {
+	[_server performOnQueue:^{
+		[self writeLine:line];
+	}];
+}
+
+-(void) sendData:(NSData *)data {
+	[_server performOnQueue:^{
+		[self writeData:data];
+	}];
+}
+
+-(void) close {
+	[_server performOnQueue:^{
+		[self shutDown];
+	}];
+}
+
+/****************************************/
+#pragma mark - Instance methods (private)
+/****************************************/
+
+-(void) startWithIdentity:(NSArray *)identity {
+	if (identity != nil) {
+		_context = SSLCreateContext(kCFAllocatorDefault, kSSLServerSide, kSSLStreamType);
+		SSLSetIOFuncs(_context, IRCClientTestServerTLSRead, IRCClientTestServerTLSWrite);
+		SSLSetConnection(_context, (SSLConnectionRef) (intptr_t) _socket);
+		SSLSetCertificate(_context, (__bridge CFArrayRef) identity);
+		// (So that sessions are cached, and a client that comes back can
+		// resume its session.)
+		SSLSetPeerID(_context, "IRCClientTestServer", strlen("IRCClientTestServer"));
+		_handshaking = YES;
+	}
+
+	_readSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t) _socket, 0, _queue);
+	__weak typeof(self) weakSelf = self;
+	dispatch_source_set_event_handler(_readSource, ^{
+		[weakSelf readAvailableBytes];
+	});
+	int fd = _socket;
+	dispatch_source_set_cancel_handler(_readSource, ^{
+		close(fd);
+	});
+	dispatch_resume(_readSource);
+}
+
+-(void) writeLine:(NSString *)line {
+	NSMutableData *data = [[line dataUsingEncoding:NSUTF8StringEncoding] mutableCopy];
+	[data appendBytes:"\r\n"
+			   length:2];
+	[self writeData:data];
+}
+
+-(void) writeData:(NSData *)data {
+	if (_socket == -1)
+		return;
+
+	if (_handshaking) {
+		[_pendingOutput addObject:data];
+		return;
+	}
+
+	const uint8_t *bytes = data.bytes;
+	NSUInteger length = data.length;
+	NSUInteger written = 0;
+	while (written < length) {
+		if (_context != NULL) {
+			size_t processed = 0;
+			OSStatus status = SSLWrite(_context, bytes + written, length - written, &processed);
+			written += processed;
+			if (status != noErr) {
+				[self shutDown];
+				return;
+			}
+		} else {
+			ssize_t count = send(_socket, bytes + written, length - written, 0);
+			if (count >= 0) {
+				written += (NSUInteger) count;
+			} else if (errno != EINTR) {
+				[self shutDown];
+				return;
+			}
+		}
+	}
+}
+
+-(void) readAvailableBytes {
+	if (_socket == -1)
+		return;
+
+	if (_handshaking) {
+		OSStatus status = SSLHandshake(_context);
+		if (status == errSSLWouldBlock)
+			return;
+		if (status != noErr) {
+			[self shutDown];
+			return;
+		}
+
+		_handshaking = NO;
+		Boolean resumed = false;
+		uint8_t sessionID[32];
+		size_t sessionIDLength = sizeof(sessionID);
+		if (   SSLGetResumableSessionInfo(_context, &resumed, sessionID, &sessionIDLength) == noErr
+			&& resumed)
+			[_server connectionResumedSession:self];
+
+		NSArray <NSData *> *pendingOutput = [_pendingOutput copy];
+		[_pendingOutput removeAllObjects];
+		for (NSData *data in pendingOutput)
+			[self writeData:data];
+	}
+
+	uint8_t buffer[IRCClientTestServerReadChunkSize];
+	BOOL closed = NO;
+	for (;;) {
+		if (_context != NULL) {
+			size_t processed = 0;
+			OSStatus status = SSLRead(_context, buffer, sizeof(buffer), &processed);
+			[_input appendBytes:buffer
+						 length:processed];
+			if (status == errSSLWouldBlock)
+				break;
+			if (status != noErr) {
+				closed = YES;
+				break;
+			}
+			if (processed == 0)
+				break;
+		} else {
+			ssize_t count = recv(_socket, buffer, sizeof(buffer), MSG_DONTWAIT);
+			if (count > 0) {
+				[_input appendBytes:buffer
+							 length:(NSUInteger) count];
+			} else if (count == 0) {
+				closed = YES;
+				break;
+			} else if (errno != EINTR) {
+				closed = (errno != EAGAIN);
+				break;
+			}
+		}
+	}
+
+	[self processInput];
+	if (closed)
+		[self shutDown];
+}
+
+-(void) processInput {
+	const uint8_t *bytes = _input.bytes;
+	NSUInteger length = _input.length;
+	NSUInteger lineStart = 0;
+	for (NSUInteger i = 0; i < length; i++) {
+		if (bytes[i] != '\n')
+			continue;
+
+		NSUInteger lineEnd = (i > lineStart && bytes[i - 1] == '\r') ? i - 1 : i;
+		NSString *line = ([[NSString alloc] initWithBytes:(bytes + lineStart)
+												   length:(lineEnd - lineStart)
+												 encoding:NSUTF8StringEncoding]
+						  ?: [[NSString alloc] initWithBytes:(bytes + lineStart)
+													  length:(lineEnd - lineStart)
+													encoding:NSISOLatin1StringEncoding]);
+		lineStart = i + 1;
+
+		[_server connection:self
+			   receivedLine:line];
+		if (_socket == -1)
+			return;
+	}
+
+	[_input replaceBytesInRange:NSMakeRange(0, lineStart)
+					  withBytes:NULL
+						 length:0];
+}
+
+-(void) shutDown {
+	if (_socket == -1)
+		return;
+
+	dispatch_source_cancel(_readSource);
+	_readSource = nil;
+	_socket = -1;
+	if (_context != NULL) {
+		CFRelease(_context);
+		_context = NULL;
+	}
+	_handshaking = NO;
+
+	[_server connectionClosed:self];
+}
+
+@end
+
+/******************************/
+#pragma mark - Helper functions
+/******************************/
+
+BOOL IRCClientTestWaitUntil(NSTimeInterval timeout,
+							BOOL (^condition)(void)) {
+	NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:timeout];
+	while (condition() == NO) {
+		if (deadline.timeIntervalSinceNow <= 0)
+			return NO;
+		usleep(5000);
+	}
+
+	return YES;
+}
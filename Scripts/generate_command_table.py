@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+#
+#	generate_command_table.py
+#
+#  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+#  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+#  libircclient Copyright 2004-2009 Georgy Yunaev.
+#
+#  See LICENSE and README.md for more info.
+
+"""Generates IRCClient/IRCClientCommandTable.h, the perfect hash table that
+maps the IRC commands IRCClient handles to IRCClientCommand values.
+
+The hash of a command is its first four bytes (zero-padded) and its length,
+multiplied by a constant and shifted down to the table size. This script
+searches for a multiplier that maps every command to its own slot. To add a
+command, add it to COMMANDS, re-run this script, and handle the new
+IRCClientCommand value in -[IRCClientSession handleIRCEvent:].
+
+Usage: Scripts/generate_command_table.py
+"""
+
+import os
+
+COMMANDS = [
+	"PING",
+	"NICK",
+	"QUIT",
+	"JOIN",
+	"PART",
+	"MODE",
+	"TOPIC",
+	"KICK",
+	"ERROR",
+	"INVITE",
+	"PRIVMSG",
+	"NOTICE",
+	"CAP",
+	"AUTHENTICATE",
+	"BATCH",
+	"FAIL",
+]
+
+OUTPUT_PATH = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+						   "..", "IRCClient", "IRCClientCommandTable.h")
+
+def key(command):
+	padded = (command.encode("ascii") + b"\0\0\0\0")[:4]
+	return (int.from_bytes(padded, "little") ^ len(command)) & 0xFFFFFFFF
+
+def slot(command, multiplier, bits):
+	return ((key(command) * multiplier) & 0xFFFFFFFF) >> (32 - bits)
+
+def find_hash():
+	bits = max(len(COMMANDS) - 1, 1).bit_length() + 1
+	while True:
+		for multiplier in range(0x9E3779B1, 0x9E3779B1 + 2000000, 2):
+			slots = { slot(command, multiplier, bits) for command in COMMANDS }
+			if len(slots) == len(COMMANDS):
+				return multiplier, bits
+		bits += 1
+
+def banner(emit, title, first=False):
+	mark = "#pragma mark " + ("" if first else "- ") + title
+	emit("/" + "*" * (len(mark) - 1) + "/")
+	emit(mark)
+	emit("/" + "*" * (len(mark) - 1) + "/")
+
+def main():
+	multiplier, bits = find_hash()
+	table = [ None ] * (1 << bits)
+	for command in COMMANDS:
+		table[slot(command, multiplier, bits)] = command
+
+	lines = []
+	emit = lines.append
+	emit("//")
+	emit("//\tIRCClientCommandTable.h")
+	emit("//")
+	emit("//  Modified IRCClient Copyright 2015-2021 Said Achmiz.")
+	emit("//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.")
+	emit("//  libircclient Copyright 2004-2009 Georgy Yunaev.")
+	emit("//")
+	emit("//  See LICENSE and README.md for more info.")
+	emit("")
+	emit("/*\tNOTE: This file is generated by Scripts/generate_command_table.py.")
+	emit("\tDo not edit it by hand; edit the script and re-run it instead.")
+	emit(" */")
+	emit("")
+	emit("#import <Foundation/Foundation.h>")
+	emit("")
+	banner(emit, "IRCClientCommand", first=True)
+	emit("")
+	emit("typedef NS_ENUM(NSUInteger, IRCClientCommand) {")
+	emit("\tIRCClientCommandUnknown = 0,")
+	for command in COMMANDS:
+		emit("\tIRCClientCommand%s," % command)
+	emit("};")
+	emit("")
+	banner(emit, "Perfect hash table")
+	emit("")
+	emit("#define IRCClientCommandHashMultiplier 0x%08XU" % multiplier)
+	emit("#define IRCClientCommandHashBits %d" % bits)
+	emit("")
+	emit("static const struct {")
+	emit("\tconst char *name;")
+	emit("\tNSUInteger length;")
+	emit("\tIRCClientCommand command;")
+	emit("} IRCClientCommandHashTable[1 << IRCClientCommandHashBits] = {")
+	for index, command in enumerate(table):
+		if command is None:
+			emit("\t/* %2d */ { NULL, 0, IRCClientCommandUnknown }," % index)
+		else:
+			emit("\t/* %2d */ { \"%s\", %d, IRCClientCommand%s }," % (index, command, len(command), command))
+	emit("};")
+	emit("")
+	banner(emit, "Lookup function")
+	emit("")
+	emit("/**\tReturns the IRCClientCommand for the given command bytes (or")
+	emit("\tIRCClientCommandUnknown if the command is not one that IRCClient handles).")
+	emit(" */")
+	emit("static inline IRCClientCommand IRCClientCommandLookup(const uint8_t *bytes,")
+	emit("\t\t\t\t\t\t\t\t\t\t\t\t\t   NSUInteger length) {")
+	emit("\tuint32_t key = 0;")
+	emit("\tfor (NSUInteger i = 0; i < length && i < 4; i++)")
+	emit("\t\tkey |= ((uint32_t) bytes[i]) << (8 * i);")
+	emit("\tkey ^= (uint32_t) length;")
+	emit("")
+	emit("\tuint32_t slot = (key * IRCClientCommandHashMultiplier) >> (32 - IRCClientCommandHashBits);")
+	emit("\tif (   IRCClientCommandHashTable[slot].length == length")
+	emit("\t\t&& memcmp(IRCClientCommandHashTable[slot].name, bytes, length) == 0)")
+	emit("\t\treturn IRCClientCommandHashTable[slot].command;")
+	emit("")
+	emit("\treturn IRCClientCommandUnknown;")
+	emit("}")
+
+	with open(OUTPUT_PATH, "w") as output:
+		output.write("\n".join(lines) + "\n")
+
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+#
+#	generate_numerics_table.py
+#
+#  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+#  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+#  libircclient Copyright 2004-2009 Georgy Yunaev.
+#
+#  See LICENSE and README.md for more info.
+
+"""Generates IRCClient/IRCClientNumericsTable.h, the static table of known IRC
+numeric reply names, from IRCClient/IRC_Numerics.plist.
+
+All the names are stored in one string pool (each name NUL-terminated). The
+table has an entry for every numeric code from 0 to 999, giving the index of
+the code's first name (in the list of name offsets) and the number of names,
+so looking up the names for a code takes no searching and no allocation. To
+update the list of numerics, edit IRC_Numerics.plist and re-run this script.
+
+Usage: Scripts/generate_numerics_table.py
+"""
+
+import os
+import plistlib
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+
+INPUT_PATH = os.path.join(SCRIPT_DIR, "..", "IRCClient", "IRC_Numerics.plist")
+OUTPUT_PATH = os.path.join(SCRIPT_DIR, "..", "IRCClient", "IRCClientNumericsTable.h")
+
+CODE_COUNT = 1000
+
+def load_numerics():
+	with open(INPUT_PATH, "rb") as input:
+		plist = plistlib.load(input)
+
+	source = plist.pop("source", None)
+	numerics = { }
+	for code, entry in plist.items():
+		code = int(code)
+		if code < 0 or code >= CODE_COUNT:
+			raise ValueError("numeric code out of range: %d" % code)
+		numerics[code] = entry["names"]
+
+	return source, numerics
+
+def banner(emit, title, first=False):
+	mark = "#pragma mark " + ("" if first else "- ") + title
+	emit("/" + "*" * (len(mark) - 1) + "/")
+	emit(mark)
+	emit("/" + "*" * (len(mark) - 1) + "/")
+
+def main():
+	source, numerics = load_numerics()
+
+	# Lay out the string pool and the name offsets, in order of numeric code.
+	pool = []
+	pool_length = 0
+	offsets = []
+	entries = [ (0, 0) ] * CODE_COUNT
+	for code in sorted(numerics):
+		names = numerics[code]
+		entries[code] = (len(offsets), len(names))
+		for name in names:
+			offsets.append(pool_length)
+			pool.append(name)
+			pool_length += len(name.encode("ascii")) + 1
+
+	if pool_length > 0xFFFF or len(offsets) > 0xFFFF:
+		raise ValueError("too many numeric names for 16-bit offsets")
+
+	lines = []
+	emit = lines.append
+	emit("//")
+	emit("//\tIRCClientNumericsTable.h")
+	emit("//")
+	emit("//  Modified IRCClient Copyright 2015-2021 Said Achmiz.")
+	emit("//  Original IRCClient Copyright 2009 Nathan Ollerenshaw.")
+	emit("//  libircclient Copyright 2004-2009 Georgy Yunaev.")
+	emit("//")
+	emit("//  See LICENSE and README.md for more info.")
+	emit("")
+	emit("/*\tNOTE: This file is generated by Scripts/generate_numerics_table.py")
+	emit("\tfrom IRC_Numerics.plist. Do not edit it by hand; edit the plist and")
+	emit("\tre-run the script instead.")
+	emit(" */")
+	emit("")
+	emit("#import <Foundation/Foundation.h>")
+	emit("")
+	banner(emit, "Constants", first=True)
+	emit("")
+	emit("#define IRCClientNumericCodeCount %d" % CODE_COUNT)
+	emit("")
+	if source is not None:
+		emit("#define IRCClientNumericsSource \"%s\"" % source)
+		emit("")
+	banner(emit, "Name pool")
+	emit("")
+	emit("static const char IRCClientNumericNamePool[] =")
+	for name in pool:
+		emit("\t\"%s\\0\"" % name)
+	emit("\t;")
+	emit("")
+	emit("static const uint16_t IRCClientNumericNameOffsets[%d] = {" % len(offsets))
+	for index in range(0, len(offsets), 8):
+		emit("\t" + " ".join("%d," % offset for offset in offsets[index:index + 8]))
+	emit("};")
+	emit("")
+	banner(emit, "Numerics table")
+	emit("")
+	emit("/*\tIndexed by numeric code; codes with no known names have a count of 0.")
+	emit(" */")
+	emit("static const struct {")
+	emit("\tuint16_t firstName;")
+	emit("\tuint16_t nameCount;")
+	emit("} IRCClientNumericsTable[IRCClientNumericCodeCount] = {")
+	for code in sorted(numerics):
+		first, count = entries[code]
+		emit("\t[%d] = { %d, %d }," % (code, first, count))
+	emit("};")
+	emit("")
+	banner(emit, "Lookup functions")
+	emit("")
+	emit("/**\tReturns the number of known names for the given numeric code.")
+	emit(" */")
+	emit("static inline NSUInteger IRCClientNumericNameCount(NSUInteger code) {")
+	emit("\tif (code >= IRCClientNumericCodeCount)")
+	emit("\t\treturn 0;")
+	emit("")
+	emit("\treturn IRCClientNumericsTable[code].nameCount;")
+	emit("}")
+	emit("")
+	emit("/**\tReturns the index’th known name for the given numeric code (as a")
+	emit("\tstatically allocated C string), or NULL if there is no such name.")
+	emit(" */")
+	emit("static inline const char *IRCClientNumericNameAtIndex(NSUInteger code,")
+	emit("\t\t\t\t\t\t\t\t\t\t\t\t\t   NSUInteger index) {")
+	emit("\tif (index >= IRCClientNumericNameCount(code))")
+	emit("\t\treturn NULL;")
+	emit("")
+	emit("\treturn IRCClientNumericNamePool + IRCClientNumericNameOffsets[IRCClientNumericsTable[code].firstName + index];")
+	emit("}")
+	emit("")
+	emit("/**\tReturns the first (usually the standard) known name for the given")
+	emit("\tnumeric code, or NULL if the code is not a known one.")
+	emit(" */")
+	emit("static inline const char *IRCClientNumericName(NSUInteger code) {")
+	emit("\treturn IRCClientNumericNameAtIndex(code, 0);")
+	emit("}")
+
+	with open(OUTPUT_PATH, "w") as output:
+		output.write("\n".join(lines) + "\n")
+
+if __name__ == "__main__":
+	main()
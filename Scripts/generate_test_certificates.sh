@@ -0,0 +1,76 @@
+#!/bin/sh
+#
+#	generate_test_certificates.sh
+#
+#  Modified IRCClient Copyright 2015-2021 Said Achmiz.
+#  Original IRCClient Copyright 2009 Nathan Ollerenshaw.
+#  libircclient Copyright 2004-2009 Georgy Yunaev.
+#
+#  See LICENSE and README.md for more info.
+
+# Generates the certificates that IRCClientTestServer speaks TLS with:
+#
+#	IRCClientTests/IRCClientTestCA.der		a certificate authority (DER)
+#	IRCClientTests/IRCClientTestServer.p12	a certificate for localhost,
+#											127.0.0.1, and ::1, issued by
+#											that authority, with its key
+#											(password: "test")
+#
+# The server certificate is valid for 825 days (the most that macOS trusts a
+# TLS server certificate for); when it runs out, the TLS tests fail, and this
+# script should be re-run (and its output committed).
+#
+# Usage: Scripts/generate_test_certificates.sh
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+OUTPUT_DIR="$SCRIPT_DIR/../IRCClientTests"
+
+WORK_DIR="$(mktemp -d)"
+trap 'rm -rf "$WORK_DIR"' EXIT
+cd "$WORK_DIR"
+
+cat > ca.cnf <<EOF
+[req]
+distinguished_name = dn
+prompt = no
+x509_extensions = ca
+[dn]
+CN = IRCClient Test CA
+[ca]
+basicConstraints = critical, CA:TRUE
+keyUsage = critical, keyCertSign, cRLSign
+subjectKeyIdentifier = hash
+EOF
+
+cat > server.cnf <<EOF
+[req]
+distinguished_name = dn
+prompt = no
+[dn]
+CN = localhost
+[server]
+basicConstraints = critical, CA:FALSE
+keyUsage = critical, digitalSignature, keyEncipherment
+extendedKeyUsage = serverAuth
+subjectAltName = DNS:localhost, IP:127.0.0.1, IP:::1
+subjectKeyIdentifier = hash
+authorityKeyIdentifier = keyid
+EOF
+
+openssl req -x509 -new -newkey rsa:2048 -nodes -sha256 -days 36500 \
+	-config ca.cnf -keyout ca.key -out ca.pem
+openssl req -new -newkey rsa:2048 -nodes -sha256 \
+	-config server.cnf -keyout server.key -out server.csr
+openssl x509 -req -in server.csr -sha256 -days 825 \
+	-CA ca.pem -CAkey ca.key -CAcreateserial \
+	-extfile server.cnf -extensions server -out server.pem
+
+# (The Security framework can’t read PKCS #12 files made with OpenSSL 3’s
+# default algorithms, so the old ones are asked for.)
+openssl pkcs12 -export -name "IRCClient Test Server" \
+	-inkey server.key -in server.pem -certfile ca.pem \
+	-certpbe PBE-SHA1-3DES -keypbe PBE-SHA1-3DES -macalg sha1 \
+	-passout pass:test -out "$OUTPUT_DIR/IRCClientTestServer.p12"
+openssl x509 -in ca.pem -outform der -out "$OUTPUT_DIR/IRCClientTestCA.der"